@@ -0,0 +1,195 @@
+#! /usr/bin/env python3
+
+"""
+Replays a log through EKF2 with and without warm start (EKF2_WS_EN) and compares how fast the
+IMU bias estimates converge.
+
+The warm start snapshot is taken from the end of the cold start replay of --snapshot-log (a
+previous flight of the same vehicle), or of the replayed log itself if not given. Build the
+replay target first, e.g. 'make px4_sitl_default replay=<log.ulg>', then:
+
+    Tools/ecl_ekf/compare_warm_start.py <log.ulg> --snapshot-log <previous_log.ulg>
+
+Exits with 1 if the warm start does not converge at least as fast as the cold start.
+The same comparison on a synthetic IMU sequence runs as unit test (make tests TESTFILTER=WarmStartReplay).
+"""
+
+import argparse
+import glob
+import os
+import subprocess
+import sys
+from typing import Dict, List, Optional, Tuple
+
+import numpy as np
+from pyulog import ULog
+
+SRC_DIR = os.path.realpath(os.path.join(os.path.dirname(__file__), '..', '..'))
+
+
+def get_arguments():
+    parser = argparse.ArgumentParser(description='Compare the EKF2 bias convergence with and without warm start')
+    parser.add_argument('filename', metavar='file.ulg', help='ULog file to replay')
+    parser.add_argument('--snapshot-log', default=None,
+                        help='ULog of a previous flight to take the warm start snapshot from (default: file.ulg)')
+    parser.add_argument('--build-dir', default=os.path.join(SRC_DIR, 'build', 'px4_sitl_default_replay'),
+                        help='replay build directory')
+    parser.add_argument('--gyro-tol', type=float, default=0.002,
+                        help='gyro bias convergence tolerance [rad/s] (default: 0.002)')
+    parser.add_argument('--accel-tol', type=float, default=0.05,
+                        help='accel bias convergence tolerance [m/s^2] (default: 0.05)')
+    parser.add_argument('--timeout', type=float, default=600, help='replay timeout [s]')
+    return parser.parse_args()
+
+
+def replay(filename: str, build_dir: str, params: Dict[str, float], timeout: float) -> str:
+    """
+    runs an EKF2 replay of a log with overridden parameters
+    :param filename: the log to replay
+    :param build_dir: the replay build directory
+    :param params: parameter overrides
+    :param timeout: replay timeout in seconds
+    :return: the replayed log
+    """
+    rootfs = os.path.join(build_dir, 'tmp', 'rootfs')
+    os.makedirs(rootfs, exist_ok=True)
+    params_file = os.path.join(rootfs, 'replay_params.txt')
+
+    with open(params_file, 'w') as file:
+        for name, value in params.items():
+            file.write('{:s} {:}\n'.format(name, value))
+
+    existing = set(glob.glob(os.path.join(rootfs, 'log', '**', '*_replayed.ulg'), recursive=True))
+
+    env = dict(os.environ, replay=os.path.realpath(filename), replay_mode='ekf2')
+    command = [os.path.join(build_dir, 'bin', 'px4'), '-d', os.path.join(SRC_DIR, 'ROMFS', 'px4fmu_common'),
+               '-s', 'etc/init.d-posix/rcS', '-t', os.path.join(SRC_DIR, 'test_data')]
+
+    try:
+        with open(os.devnull, 'w') as devnull:
+            subprocess.run(command, cwd=rootfs, env=env, stdout=devnull, stderr=devnull, timeout=timeout, check=False)
+    finally:
+        # do not affect later replays
+        os.remove(params_file)
+
+    replayed = set(glob.glob(os.path.join(rootfs, 'log', '**', '*_replayed.ulg'), recursive=True)) - existing
+
+    if not replayed:
+        raise RuntimeError('replay of {:s} did not produce a log'.format(filename))
+
+    return max(replayed, key=os.path.getmtime)
+
+
+def bias_data(ulog: ULog) -> Tuple[np.ndarray, np.ndarray, np.ndarray]:
+    """
+    :param ulog: a replayed log
+    :return: time since EKF start [s], total gyro bias [rad/s] and accel bias [m/s^2] (N x 3)
+    """
+    bias = ulog.get_dataset('sensor_bias').data
+    time_s = (bias['timestamp'] - bias['timestamp'][0]) * 1e-6
+    gyro = np.column_stack([bias['gyro_bias[{:d}]'.format(i)] for i in range(3)])
+    accel = np.column_stack([bias['accel_bias[{:d}]'.format(i)] for i in range(3)])
+    return time_s, gyro, accel
+
+
+def bias_std(ulog: ULog, first: int, switch_on_std: float) -> float:
+    """
+    bias uncertainty at the end of the log, from the ratio of the bias state variances to their
+    initial value (the variances are in delta angle/velocity units)
+    :param first: index of the first bias state (10: gyro, 13: accel)
+    :param switch_on_std: the uncertainty the filter was initialised with
+    """
+    status = ulog.get_dataset('estimator_status').data
+    ratio = max(status['covariances[{:d}]'.format(i)][-1] / status['covariances[{:d}]'.format(i)][0]
+                for i in range(first, first + 3))
+    return float(switch_on_std * np.sqrt(ratio))
+
+
+def snapshot_params(cold: ULog, original: ULog) -> Dict[str, float]:
+    """
+    warm start parameters from the end of a cold start replay
+    """
+    _, gyro, accel = bias_data(cold)
+    selection = original.get_dataset('sensor_selection').data
+
+    params = {'EKF2_WS_EN': 1, 'EKF2_WS_TDIFF': 0}
+
+    for i, axis in enumerate('XYZ'):
+        params['EKF2_WS_GB_' + axis] = float(np.mean(gyro[-50:, i]))
+        params['EKF2_WS_AB_' + axis] = float(np.mean(accel[-50:, i]))
+
+    params['EKF2_WS_GB_STD'] = bias_std(cold, 10, cold.initial_parameters['EKF2_GBIAS_INIT'])
+    params['EKF2_WS_AB_STD'] = bias_std(cold, 13, cold.initial_parameters['EKF2_ABIAS_INIT'])
+    params['EKF2_WS_GB_ID'] = int(selection['gyro_device_id'][0])
+    params['EKF2_WS_AB_ID'] = int(selection['accel_device_id'][0])
+    return params
+
+
+def convergence_time(time_s: np.ndarray, bias: np.ndarray, reference: np.ndarray, tol: float) -> Optional[float]:
+    """
+    :return: time after which the bias stays within tol of the reference on all axes, None if never
+    """
+    error = np.max(np.abs(bias - reference), axis=1)
+    outside = np.nonzero(error > tol)[0]
+
+    if len(outside) == 0:
+        return float(time_s[0])
+
+    if outside[-1] + 1 >= len(time_s):
+        return None
+
+    return float(time_s[outside[-1] + 1])
+
+
+def format_time(value: Optional[float]) -> str:
+    return '{:8.1f} s'.format(value) if value is not None else '     n/a'
+
+
+def main() -> int:
+    args = get_arguments()
+    snapshot_log = args.snapshot_log or args.filename
+    messages = ['sensor_bias', 'estimator_status', 'sensor_selection']
+
+    cold_params = {'EKF2_WS_EN': 0}
+
+    if snapshot_log != args.filename:
+        snapshot_replayed = replay(snapshot_log, args.build_dir, cold_params, args.timeout)
+    else:
+        snapshot_replayed = None
+
+    cold_replayed = replay(args.filename, args.build_dir, cold_params, args.timeout)
+    cold = ULog(cold_replayed, messages)
+
+    warm_params = snapshot_params(ULog(snapshot_replayed or cold_replayed, messages),
+                                  ULog(snapshot_log, ['sensor_selection']))
+    warm = ULog(replay(args.filename, args.build_dir, warm_params, args.timeout), messages)
+
+    # the end of the cold start replay is the reference for both
+    _, cold_gyro, cold_accel = bias_data(cold)
+    gyro_reference = np.mean(cold_gyro[-50:], axis=0)
+    accel_reference = np.mean(cold_accel[-50:], axis=0)
+
+    results: List[Tuple[str, Optional[float], Optional[float]]] = []
+
+    for name, ulog in (('cold', cold), ('warm', warm)):
+        time_s, gyro, accel = bias_data(ulog)
+        results.append((name, convergence_time(time_s, gyro, gyro_reference, args.gyro_tol),
+                        convergence_time(time_s, accel, accel_reference, args.accel_tol)))
+
+    print('warm start snapshot from {:s}:'.format(snapshot_log))
+    for name in sorted(warm_params):
+        print('  {:16s} {:}'.format(name, warm_params[name]))
+
+    print('{:6s} {:>12s} {:>12s}'.format('', 'gyro bias', 'accel bias'))
+    for name, gyro_time, accel_time in results:
+        print('{:6s} {:>12s} {:>12s}'.format(name, format_time(gyro_time), format_time(accel_time)))
+
+    def not_slower(warm_time, cold_time):
+        return warm_time is not None and (cold_time is None or warm_time <= cold_time)
+
+    ok = not_slower(results[1][1], results[0][1]) and not_slower(results[1][2], results[0][2])
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
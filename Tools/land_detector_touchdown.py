@@ -0,0 +1,112 @@
+#! /usr/bin/env python3
+
+"""
+Evaluates the multicopter touchdown detection (LNDMC_TD_EN) on logged landings.
+
+For every landing in the logs the time from the first ground contact and from the touchdown
+confidence reaching the contact and the landed thresholds of the land detector to the landed
+state is reported. Confidence episodes above the contact threshold that are not followed by
+a landing are counted as false positives:
+
+    Tools/land_detector_touchdown.py log1.ulg [log2.ulg ...]
+
+Exits with 1 if a false positive was found.
+"""
+
+import argparse
+import sys
+from typing import List, Optional, Tuple
+
+from pyulog import ULog
+
+# MulticopterLandDetector TOUCHDOWN_CONTACT_CONFIDENCE and TOUCHDOWN_LANDED_CONFIDENCE
+CONTACT_CONFIDENCE = 0.5
+LANDED_CONFIDENCE = 0.9
+
+
+def get_arguments():
+    parser = argparse.ArgumentParser(description='Evaluate the touchdown detection on logged landings')
+    parser.add_argument('filenames', metavar='file.ulg', nargs='+', help='ULog files')
+    parser.add_argument('--window', type=float, default=3.0,
+                        help='time in which a confidence episode has to be followed by landed [s] (default: 3)')
+    return parser.parse_args()
+
+
+def first_time(times: List[float], values: List[bool], start: float, end: float) -> Optional[float]:
+    """
+    :return: first time in [start, end] at which the value is set, None if never
+    """
+    for time_s, value in zip(times, values):
+        if start <= time_s <= end and value:
+            return time_s
+    return None
+
+
+def evaluate(filename: str, window: float) -> Tuple[List[Tuple[float, Optional[float], Optional[float],
+                                                                 Optional[float]]], int]:
+    """
+    :return: per landing (time, latency from ground contact, from contact confidence, from landed confidence)
+             and the number of false positive confidence episodes
+    """
+    data = ULog(filename, ['vehicle_land_detected']).get_dataset('vehicle_land_detected').data
+
+    if 'touchdown_confidence' not in data:
+        raise RuntimeError('{:s} has no touchdown confidence'.format(filename))
+
+    times = [t * 1e-6 for t in data['timestamp']]
+    landed = [bool(v) for v in data['landed']]
+    contact = [bool(v) for v in data['ground_contact']]
+    confidence = list(data['touchdown_confidence'])
+
+    landings = [times[i] for i in range(1, len(times)) if landed[i] and not landed[i - 1]]
+    results = []
+    previous_landing = times[0]
+
+    for landing in landings:
+        def latency(values):
+            start = first_time(times, values, max(previous_landing, landing - window), landing)
+            return landing - start if start is not None else None
+
+        results.append((landing, latency(contact),
+                        latency([c >= CONTACT_CONFIDENCE for c in confidence]),
+                        latency([c >= LANDED_CONFIDENCE for c in confidence])))
+        previous_landing = landing
+
+    # rising edges above the contact confidence in the air without landing within the window
+    false_positives = 0
+
+    for i in range(1, len(times)):
+        if confidence[i] >= CONTACT_CONFIDENCE > confidence[i - 1] and not landed[i]:
+            if not any(times[i] <= landing <= times[i] + window for landing in landings):
+                false_positives += 1
+
+    return results, false_positives
+
+
+def format_time(value: Optional[float]) -> str:
+    return '{:8.3f} s'.format(value) if value is not None else '     n/a'
+
+
+def main() -> int:
+    args = get_arguments()
+    total_false_positives = 0
+
+    print('{:40s} {:>10s} {:>10s} {:>10s} {:>10s}'.format('', 'landed', 'contact', 'TD contact', 'TD landed'))
+
+    for filename in args.filenames:
+        results, false_positives = evaluate(filename, args.window)
+        total_false_positives += false_positives
+
+        for landing, contact, td_contact, td_landed in results:
+            print('{:40s} {:8.1f} s {:>10s} {:>10s} {:>10s}'.format(
+                filename[-40:], landing, format_time(contact), format_time(td_contact), format_time(td_landed)))
+
+        if false_positives:
+            print('{:40s} {:d} false positives'.format(filename[-40:], false_positives))
+
+    print('false positives: {:d}'.format(total_false_positives))
+    return 0 if total_false_positives == 0 else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,191 @@
+#!/usr/bin/env python
+
+"""
+Measure the round-trip latency and the CPU usage of a micrortps_agent over UDP.
+
+The script takes the role of the client: it sends framed messages of a topic the
+agent publishes into DDS (send scope in uorb_rtps_message_ids.yaml) to the agent
+receive port and waits for the agent, started in echo mode (-e), to return them.
+The CPU usage of the agent is sampled from /proc while idle and under load.
+
+Build the agent first (e.g. 'make px4_sitl_rtps' with GENERATE_RTPS_BRIDGE), then:
+
+    Tools/micrortps_agent_bench.py -a build/px4_sitl_rtps/src/modules/micrortps_bridge/micrortps_agent/build/micrortps_agent
+
+Pass a second agent with -b to compare against a baseline build. Agents without
+echo mode (-e) are measured without latencies.
+"""
+
+from __future__ import print_function
+import os
+import socket
+import struct
+import subprocess
+import sys
+import time
+from argparse import ArgumentParser
+
+
+def crc16_table():
+    """ CRC-16 (polynomial 0x8005, reflected) as used by microRTPS_transport """
+    table = []
+    for i in range(256):
+        crc = i
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+        table.append(crc)
+    return table
+
+
+CRC16_TABLE = crc16_table()
+
+
+def crc16(data):
+    crc = 0
+    for byte in bytearray(data):
+        crc = (crc >> 8) ^ CRC16_TABLE[(crc ^ byte) & 0xff]
+    return crc
+
+
+def frame(topic_id, seq, payload):
+    """ [>,>,>,topic_ID,seq,payload_length_H,payload_length_L,CRCHigh,CRCLow,payload] """
+    crc = crc16(payload)
+    return b'>>>' + struct.pack('>BBHH', topic_id, seq & 0xff, len(payload), crc) + payload
+
+
+def parse_frame(data):
+    """ @return (topic_id, payload) or None """
+    if len(data) < 9 or data[:3] != b'>>>':
+        return None
+    topic_id, _, length, crc = struct.unpack('>BBHH', data[3:9])
+    payload = data[9:9 + length]
+    if len(payload) != length or crc16(payload) != crc:
+        return None
+    return topic_id, payload
+
+
+def cpu_seconds(pid):
+    """ utime + stime of a process """
+    with open('/proc/{:}/stat'.format(pid)) as stat:
+        fields = stat.read().rsplit(')', 1)[1].split()
+    return (int(fields[11]) + int(fields[12])) / float(os.sysconf('SC_CLK_TCK'))
+
+
+def cpu_usage(pid, duration):
+    start = cpu_seconds(pid)
+    time.sleep(duration)
+    return 100. * (cpu_seconds(pid) - start) / duration
+
+
+def percentile(values, p):
+    if not values:
+        return float('nan')
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p / 100. * len(values)))]
+
+
+def start_agent(agent, args, echo):
+    command = [agent, '-t', 'UDP', '-r', str(args.recv_port), '-s', str(args.send_port)]
+    if echo:
+        command.append('-e')
+    with open(os.devnull, 'w') as devnull:
+        process = subprocess.Popen(command, stdout=devnull, stderr=devnull)
+    time.sleep(args.startup)
+    return process
+
+
+def run(agent, args):
+    recv = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    recv.bind(('127.0.0.1', args.send_port))
+    recv.settimeout(args.timeout)
+    send = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+
+    echo = True
+    process = start_agent(agent, args, echo)
+
+    if process.poll() is not None:
+        # older agent without echo mode
+        echo = False
+        process = start_agent(agent, args, echo)
+
+    try:
+        if process.poll() is not None:
+            print('{:} exited with {:}'.format(agent, process.returncode))
+            sys.exit(1)
+
+        idle_cpu = cpu_usage(process.pid, args.idle)
+
+        latencies = []
+        lost = 0
+        padding = b'\0' * max(0, args.size - 8)
+        start = time.time()
+        load_cpu_start = cpu_seconds(process.pid)
+
+        for seq in range(args.count):
+            # sequence and timestamp in the first bytes, the agent does not interpret them in echo mode
+            payload = struct.pack('<II', seq, int(time.time() * 1e6) & 0xffffffff) + padding
+            sent = time.time()
+            send.sendto(frame(args.topic_id, seq, payload), ('127.0.0.1', args.recv_port))
+
+            while echo:
+                try:
+                    data = recv.recv(4096)
+                except socket.timeout:
+                    lost += 1
+                    break
+                parsed = parse_frame(data)
+                if parsed and parsed[0] == args.topic_id and struct.unpack('<I', parsed[1][:4])[0] == seq:
+                    latencies.append((time.time() - sent) * 1e6)
+                    break
+
+            if args.rate > 0:
+                time.sleep(max(0., start + (seq + 1) / args.rate - time.time()))
+
+        duration = time.time() - start
+        load_cpu = 100. * (cpu_seconds(process.pid) - load_cpu_start) / duration
+
+    finally:
+        process.send_signal(2)
+        try:
+            process.wait()
+        except KeyboardInterrupt:
+            process.kill()
+        recv.close()
+        send.close()
+
+    return idle_cpu, load_cpu, latencies, lost, duration
+
+
+def main():
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument('-a', '--agent', required=True, help='micrortps_agent binary')
+    parser.add_argument('-b', '--baseline', help='baseline micrortps_agent binary to compare against')
+    parser.add_argument('-t', '--topic-id', type=int, default=1,
+                        help='id of a topic received by the agent (default: 1, sensor_combined)')
+    parser.add_argument('-n', '--count', type=int, default=2000, help='number of messages')
+    parser.add_argument('-s', '--size', type=int, default=48, help='payload size [bytes]')
+    parser.add_argument('-r', '--rate', type=float, default=500, help='send rate [Hz], 0 for back to back')
+    parser.add_argument('--recv-port', type=int, default=2020, help='agent UDP receive port')
+    parser.add_argument('--send-port', type=int, default=2019, help='agent UDP send port')
+    parser.add_argument('--timeout', type=float, default=0.5, help='echo timeout [s]')
+    parser.add_argument('--startup', type=float, default=2., help='time for the agent to start [s]')
+    parser.add_argument('--idle', type=float, default=3., help='idle CPU measurement duration [s]')
+    args = parser.parse_args()
+
+    agents = [('agent', args.agent)]
+    if args.baseline:
+        agents.insert(0, ('baseline', args.baseline))
+
+    print('{:} messages of {:} bytes at {:} Hz, topic id {:}'.format(args.count, args.size, args.rate, args.topic_id))
+    print('{:10s} {:>9s} {:>9s} {:>9s} {:>9s} {:>9s} {:>6s} {:>9s}'.format(
+        '', 'idle CPU', 'load CPU', 'msg/s', 'p50 [us]', 'p99 [us]', 'lost', 'max [us]'))
+
+    for name, agent in agents:
+        idle_cpu, load_cpu, latencies, lost, duration = run(agent, args)
+        print('{:10s} {:8.2f}% {:8.2f}% {:9.1f} {:9.0f} {:9.0f} {:6d} {:9.0f}'.format(
+            name, idle_cpu, load_cpu, len(latencies) / duration, percentile(latencies, 50),
+            percentile(latencies, 99), lost, max(latencies) if latencies else float('nan')))
+
+
+if __name__ == '__main__':
+    main()
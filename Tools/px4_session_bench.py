@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+
+"""
+Measure the command throughput of a running PX4 POSIX daemon, comparing one
+client process per command (px4-<command>) with a persistent session
+(px4-session) carrying the same commands over one connection.
+
+Start SITL first, e.g. 'make px4_sitl none', then run from the build directory:
+
+    Tools/px4_session_bench.py -d build/px4_sitl_default/bin -n 500
+"""
+
+from __future__ import print_function
+import os
+import subprocess
+import sys
+from argparse import ArgumentParser
+from timeit import default_timer as timer
+
+
+def run_per_process(bin_dir, instance, commands):
+    """ one client process (and connection) per command """
+    failed = 0
+    with open(os.devnull, 'w') as devnull:
+        for command in commands:
+            args = command.split()
+            client = os.path.join(bin_dir, 'px4-' + args[0])
+            ret = subprocess.call([client, '--instance', str(instance)] + args[1:],
+                                  stdout=devnull, stderr=devnull)
+            if ret != 0:
+                failed += 1
+    return failed
+
+
+def run_session(bin_dir, instance, commands, concurrent):
+    """ all commands in one session """
+    client = os.path.join(bin_dir, 'px4-session')
+    args = [client, '--instance', str(instance)]
+    if concurrent:
+        args.append('-c')
+    with open(os.devnull, 'w') as devnull:
+        process = subprocess.Popen(args, stdin=subprocess.PIPE, stdout=devnull, stderr=devnull)
+        process.communicate(('\n'.join(commands) + '\n').encode())
+    return process.returncode
+
+
+def main():
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument('-d', '--bin-dir', default='build/px4_sitl_default/bin',
+                        help='directory containing the px4 binary and the px4-* symlinks')
+    parser.add_argument('-i', '--instance', type=int, default=0, help='px4 instance id')
+    parser.add_argument('-n', '--count', type=int, default=200, help='number of commands')
+    parser.add_argument('-c', '--command', action='append',
+                        help='command to run, can be repeated (default: a bring-up like mix)')
+    args = parser.parse_args()
+
+    if not os.path.exists(os.path.join(args.bin_dir, 'px4-session')):
+        print('px4-session not found in {:}'.format(args.bin_dir))
+        sys.exit(1)
+
+    mix = args.command or ['param set SYS_AUTOSTART 10016', 'param show SYS_AUTOSTART', 'uorb status',
+                           'listener vehicle_status 1']
+    commands = [mix[i % len(mix)] for i in range(args.count)]
+
+    print('{:} commands: {:}'.format(args.count, ', '.join(mix)))
+
+    results = []
+
+    start = timer()
+    failed = run_per_process(args.bin_dir, args.instance, commands)
+    results.append(('per process', timer() - start, failed))
+
+    start = timer()
+    ret = run_session(args.bin_dir, args.instance, commands, False)
+    results.append(('session', timer() - start, ret))
+
+    start = timer()
+    ret = run_session(args.bin_dir, args.instance, commands, True)
+    results.append(('session -c', timer() - start, ret))
+
+    baseline = results[0][1]
+
+    for name, duration, status in results:
+        print('{:12s} {:8.1f} cmd/s  {:6.2f}x  (status {:})'.format(
+            name, args.count / duration, baseline / duration, status))
+
+
+if __name__ == '__main__':
+    main()
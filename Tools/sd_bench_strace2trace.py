@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+
+"""
+Convert an strace log of a running PX4 instance on Linux into a write trace for 'sd_bench -t'.
+
+Record the writes of the logger and dataman, e.g. during a flight or SITL run:
+
+    strace -f -ttt -yy -e trace=write,fsync -o px4.strace -p $(pidof px4)
+
+Then convert and replay on the storage to qualify:
+
+    Tools/sd_bench_strace2trace.py px4.strace -o logger.trace
+    sd_bench -t logger.trace -p /fs/microsd/benchmark.tmp
+
+Writes to .ulg files become log writes, writes to the dataman file become dataman writes
+(which include their fsync), and fsyncs of .ulg files become log fsyncs.
+"""
+
+from __future__ import print_function
+import re
+import sys
+from argparse import ArgumentParser
+
+# [pid] time syscall(fd<path>, ...
+LINE = re.compile(r'^(?:\d+\s+)?(\d+\.\d+)\s+(write|fsync)\((\d+)<([^>]*)>(.*)$')
+SIZE = re.compile(r',\s*(\d+)\)\s*=\s*(-?\d+)')
+
+
+def convert(lines, log_pattern, dataman_pattern):
+    ops = []
+    start = None
+
+    for line in lines:
+        match = LINE.match(line)
+        if not match:
+            continue
+        time, syscall, _, path, rest = match.groups()
+
+        if re.search(log_pattern, path):
+            kind = 'log'
+        elif re.search(dataman_pattern, path):
+            kind = 'dataman'
+        else:
+            continue
+
+        if syscall == 'write':
+            size = SIZE.search(rest)
+            # unfinished (resumed) calls are skipped, the result is the number of bytes written
+            if not size or int(size.group(2)) <= 0:
+                continue
+            op = ('w' if kind == 'log' else 'd', int(size.group(2)))
+        elif kind == 'log':
+            op = ('f', 0)
+        else:
+            continue
+
+        time_us = int(round(float(time) * 1e6))
+        if start is None:
+            start = time_us
+        ops.append((time_us - start, op[0], op[1]))
+
+    return ops
+
+
+def main():
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument('strace', help='output of strace -ttt -yy')
+    parser.add_argument('-o', '--output', help='trace file (default: stdout)')
+    parser.add_argument('--log', default=r'\.ulg$', help='regex of the log file paths')
+    parser.add_argument('--dataman', default=r'dataman$', help='regex of the dataman file path')
+    args = parser.parse_args()
+
+    with open(args.strace) as f:
+        ops = convert(f, args.log, args.dataman)
+
+    if not ops:
+        print('no log or dataman writes found', file=sys.stderr)
+        sys.exit(1)
+
+    output = open(args.output, 'w') if args.output else sys.stdout
+    output.write('# time [us], op (w: log write, f: log fsync, d: dataman write), size [bytes]\n')
+    for time_us, op, size in ops:
+        output.write('{:} {:} {:}\n'.format(time_us, op, size))
+
+    if args.output:
+        output.close()
+
+    counts = {op: sum(1 for o in ops if o[1] == op) for op in 'wfd'}
+    print('{:} log writes, {:} log fsyncs, {:} dataman writes over {:.1f} s'.format(
+        counts['w'], counts['f'], counts['d'], ops[-1][0] * 1e-6), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
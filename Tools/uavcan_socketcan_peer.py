@@ -0,0 +1,211 @@
+#! /usr/bin/env python3
+
+"""
+Scripted UAVCAN peer node to test the uavcan module on SocketCAN (Linux, e.g. SITL).
+
+The peer publishes its NodeStatus, listens to the NodeStatus and the ESC commands of PX4 and
+measures the round-trip time of GetNodeInfo requests to PX4, i.e. the receive and transmit path
+of the driver including the batching and the wakeup of the uavcan task.
+
+Set up a virtual CAN interface and start PX4 on it:
+
+    sudo modprobe vcan
+    sudo ip link add dev vcan0 type vcan
+    sudo ip link set up vcan0
+    PX4_UAVCAN_INTERFACES=vcan0 make px4_sitl_default   # with UAVCAN_ENABLE set to 1
+
+or run 'uavcan start -i vcan0' in the PX4 shell, then:
+
+    Tools/uavcan_socketcan_peer.py -i vcan0
+
+Exits with 1 if PX4 was not seen on the bus or did not answer the requests.
+"""
+
+import argparse
+import select
+import socket
+import struct
+import sys
+import time
+from typing import List, Optional
+
+CAN_EFF_FLAG = 0x80000000
+CAN_EFF_MASK = 0x1FFFFFFF
+CAN_FRAME = struct.Struct('=IB3x8s')
+
+NODE_STATUS_ID = 341
+ESC_RAW_COMMAND_ID = 1030
+GET_NODE_INFO_ID = 1
+
+PRIORITY_LOW = 24
+
+
+def message_can_id(priority: int, type_id: int, source: int) -> int:
+    return (priority << 24) | (type_id << 8) | source
+
+
+def request_can_id(priority: int, type_id: int, destination: int, source: int) -> int:
+    return (priority << 24) | (type_id << 16) | (1 << 15) | (destination << 8) | (1 << 7) | source
+
+
+def tail_byte(transfer_id: int) -> int:
+    """ single frame transfer: start and end of transfer, toggle 0 """
+    return 0xC0 | (transfer_id & 0x1F)
+
+
+def node_status_payload(uptime_s: int) -> bytes:
+    """ uptime_sec, health OK, mode OPERATIONAL, sub mode 0, vendor specific status 0 """
+    return struct.pack('<IBH', uptime_s, 0, 0)
+
+
+def percentile(values: List[float], p: float) -> float:
+    if not values:
+        return float('nan')
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p / 100. * len(values)))]
+
+
+def get_arguments():
+    parser = argparse.ArgumentParser(description='Scripted UAVCAN peer node for the uavcan module on SocketCAN')
+    parser.add_argument('-i', '--interface', default='vcan0', help='CAN network interface (default: vcan0)')
+    parser.add_argument('-n', '--node-id', type=int, default=100, help='node ID of the peer (default: 100)')
+    parser.add_argument('-p', '--px4-node-id', type=int, default=1, help='node ID of PX4 (UAVCAN_NODE_ID, default: 1)')
+    parser.add_argument('-d', '--duration', type=float, default=10., help='test duration [s] (default: 10)')
+    parser.add_argument('-r', '--request-rate', type=float, default=50., help='GetNodeInfo request rate [Hz]')
+    parser.add_argument('--timeout', type=float, default=0.1, help='GetNodeInfo response timeout [s]')
+    return parser.parse_args()
+
+
+class Peer:
+    def __init__(self, args):
+        self.args = args
+        self.sock = socket.socket(socket.AF_CAN, socket.SOCK_RAW, socket.CAN_RAW)
+        self.sock.bind((args.interface,))
+        self.sock.setblocking(False)
+        self.start = time.monotonic()
+
+        self.node_status_transfer_id = 0
+        self.request_transfer_id = 0
+
+        self.px4_node_status: List[float] = []
+        self.px4_mode: Optional[int] = None
+        self.esc_commands = 0
+
+        self.pending_request: Optional[int] = None
+        self.request_sent = 0.
+        self.requests = 0
+        self.timeouts = 0
+        self.round_trips: List[float] = []
+
+    def send(self, can_id: int, payload: bytes):
+        self.sock.send(CAN_FRAME.pack(can_id | CAN_EFF_FLAG, len(payload), payload.ljust(8, b'\0')))
+
+    def send_node_status(self):
+        payload = node_status_payload(int(time.monotonic() - self.start))
+        payload += bytes([tail_byte(self.node_status_transfer_id)])
+        self.send(message_can_id(PRIORITY_LOW, NODE_STATUS_ID, self.args.node_id), payload)
+        self.node_status_transfer_id += 1
+
+    def send_request(self, now: float):
+        transfer_id = self.request_transfer_id & 0x1F
+        self.send(request_can_id(PRIORITY_LOW, GET_NODE_INFO_ID, self.args.px4_node_id, self.args.node_id),
+                  bytes([tail_byte(transfer_id)]))
+        self.request_transfer_id += 1
+        self.pending_request = transfer_id
+        self.request_sent = now
+        self.requests += 1
+
+    def handle_frame(self, frame: bytes, now: float):
+        can_id, dlc, data = CAN_FRAME.unpack(frame)
+
+        if not can_id & CAN_EFF_FLAG or dlc == 0:
+            return
+
+        can_id &= CAN_EFF_MASK
+        source = can_id & 0x7F
+        tail = data[dlc - 1]
+        end_of_transfer = bool(tail & 0x40)
+
+        if source != self.args.px4_node_id or not end_of_transfer:
+            return
+
+        if can_id & (1 << 7):
+            # service frame: response to us from PX4
+            type_id = (can_id >> 16) & 0xFF
+            destination = (can_id >> 8) & 0x7F
+            request = bool(can_id & (1 << 15))
+
+            if (type_id == GET_NODE_INFO_ID and destination == self.args.node_id and not request
+                    and self.pending_request == tail & 0x1F):
+                self.round_trips.append((now - self.request_sent) * 1e6)
+                self.pending_request = None
+
+        else:
+            type_id = (can_id >> 8) & 0xFFFF
+
+            if type_id == NODE_STATUS_ID:
+                self.px4_node_status.append(now)
+                self.px4_mode = (data[4] >> 3) & 0x07
+
+            elif type_id == ESC_RAW_COMMAND_ID:
+                self.esc_commands += 1
+
+    def run(self):
+        end = self.start + self.args.duration
+        next_node_status = self.start
+        next_request = self.start
+
+        while True:
+            now = time.monotonic()
+
+            if now >= end:
+                break
+
+            if now >= next_node_status:
+                self.send_node_status()
+                next_node_status += 1.
+
+            if self.pending_request is not None and now - self.request_sent > self.args.timeout:
+                self.timeouts += 1
+                self.pending_request = None
+
+            if self.pending_request is None and now >= next_request and self.args.request_rate > 0:
+                self.send_request(now)
+                next_request = now + 1. / self.args.request_rate
+
+            timeout = max(0., min(next_node_status, next_request, end) - now)
+            readable, _, _ = select.select([self.sock], [], [], timeout)
+
+            if readable:
+                while True:
+                    try:
+                        frame = self.sock.recv(CAN_FRAME.size)
+                    except BlockingIOError:
+                        break
+                    self.handle_frame(frame, time.monotonic())
+
+        self.sock.close()
+
+
+def main() -> int:
+    args = get_arguments()
+    peer = Peer(args)
+    peer.run()
+
+    print('PX4 node status:  {:d} messages ({:.1f} Hz), mode {:}'.format(
+        len(peer.px4_node_status), len(peer.px4_node_status) / args.duration,
+        peer.px4_mode if peer.px4_mode is not None else 'n/a'))
+    print('ESC commands:     {:d} ({:.1f} Hz)'.format(peer.esc_commands, peer.esc_commands / args.duration))
+    print('GetNodeInfo:      {:d} requests, {:d} timeouts'.format(peer.requests, peer.timeouts))
+    print('round trip [us]:  p50 {:.0f}, p99 {:.0f}, max {:.0f}'.format(
+        percentile(peer.round_trips, 50), percentile(peer.round_trips, 99),
+        max(peer.round_trips) if peer.round_trips else float('nan')))
+
+    # NodeStatus is published at least every second
+    ok = (len(peer.px4_node_status) >= args.duration / 2 and len(peer.round_trips) > 0
+          and peer.timeouts <= 0.01 * peer.requests)
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -5,6 +5,7 @@ px4_add_board(
 	MODEL sitl
 	LABEL default
 	TESTING
+	UAVCAN_INTERFACES 2
 
 	DRIVERS
 		#barometer # all available barometer drivers
@@ -18,7 +19,7 @@ px4_add_board(
 		pwm_out_sim
 		#telemetry # all available telemetry drivers
 		tone_alarm
-		#uavcan
+		uavcan
 
 	MODULES
 		attitude_estimator_q
@@ -61,12 +61,18 @@ except AttributeError:
 
 #include "RtpsTopics.h"
 
+#include <cinttypes>
+
+#include <fastcdr/exceptions/Exception.h>
+
 bool RtpsTopics::init()
 {
 @[if recv_topics]@
     // Initialise subscribers
 @[for topic in recv_topics]@
-    if (_@(topic)_sub.init()) {
+    _stats[@(rtps_message_id(ids, topic))].name = "@(topic)";
+    _stats[@(rtps_message_id(ids, topic))].outbound = true;
+    if (_@(topic)_sub.init([this]() { queueMsg(@(rtps_message_id(ids, topic))); })) {
         std::cout << "@(topic) subscriber started" << std::endl;
     } else {
         std::cout << "ERROR starting @(topic) subscriber" << std::endl;
@@ -78,6 +84,7 @@ bool RtpsTopics::init()
 @[if send_topics]@
     // Initialise publishers
 @[for topic in send_topics]@
+    _stats[@(rtps_message_id(ids, topic))].name = "@(topic)";
     if (_@(topic)_pub.init()) {
         std::cout << "@(topic) publisher started" << std::endl;
     } else {
@@ -90,9 +97,52 @@ bool RtpsTopics::init()
     return true;
 }
 
+void RtpsTopics::addLatency(TopicStats &stats, std::chrono::steady_clock::time_point start)
+{
+    const uint64_t latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now() - start).count();
+
+    ++stats.count;
+    stats.latency_sum_us += latency_us;
+
+    if (latency_us > stats.latency_max_us) {
+        stats.latency_max_us = latency_us;
+    }
+}
+
+void RtpsTopics::printStats()
+{
+    printf("\n%-32s %3s %10s %8s %10s %10s\n", "topic", "dir", "count", "dropped", "avg [us]", "max [us]");
+
+    for (TopicStats &stats : _stats)
+    {
+        if (stats.name == nullptr) continue;
+
+        uint32_t dropped = stats.dropped;
+        const uint32_t count = stats.count;
+
+@[if recv_topics]@
+        // messages replaced by a newer one before they could be sent
+        switch (&stats - _stats)
+        {
+@[for topic in recv_topics]@
+            case @(rtps_message_id(ids, topic)): dropped += _@(topic)_sub.getOverwritten(); break;
+@[end for]@
+            default: break;
+        }
+
+@[end if]@
+        printf("%-32s %3s %10" PRIu32 " %8" PRIu32 " %10" PRIu64 " %10" PRIu32 "\n", stats.name,
+               stats.outbound ? "out" : "in", count, dropped, count > 0 ? stats.latency_sum_us / count : 0,
+               stats.latency_max_us.load());
+    }
+}
+
 @[if send_topics]@
 void RtpsTopics::publish(uint8_t topic_ID, char data_buffer[], size_t len)
 {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
     switch (topic_ID)
     {
 @[for topic in send_topics]@
@@ -113,8 +163,15 @@ void RtpsTopics::publish(uint8_t topic_ID, char data_buffer[], size_t len)
 @[    end if]@
             eprosima::fastcdr::FastBuffer cdrbuffer(data_buffer, len);
             eprosima::fastcdr::Cdr cdr_des(cdrbuffer);
-            st.deserialize(cdr_des);
+            try {
+                st.deserialize(cdr_des);
+            } catch (const eprosima::fastcdr::exception::Exception &) {
+                // truncated or corrupted message
+                ++_stats[topic_ID].dropped;
+                break;
+            }
             _@(topic)_pub.publish(&st);
+            addLatency(_stats[topic_ID], start);
         }
         break;
 @[end for]@
@@ -126,31 +183,29 @@ void RtpsTopics::publish(uint8_t topic_ID, char data_buffer[], size_t len)
 @[end if]@
 @[if recv_topics]@
 
-bool RtpsTopics::hasMsg(uint8_t *topic_ID)
+void RtpsTopics::queueMsg(uint8_t topic_ID)
 {
-    if (nullptr == topic_ID) return false;
-
-    *topic_ID = 0;
-    while (_next_sub_idx < @(len(recv_topics)) && 0 == *topic_ID)
     {
-        switch (_sub_topics[_next_sub_idx])
-        {
-@[for topic in recv_topics]@
-            case @(rtps_message_id(ids, topic)): if (_@(topic)_sub.hasMsg()) *topic_ID = @(rtps_message_id(ids, topic)); break;
-@[end for]@
-            default:
-                printf("Unexpected topic ID to check hasMsg\n");
-            break;
-        }
-        _next_sub_idx++;
+        std::lock_guard<std::mutex> lock(_send_queue_mutex);
+        _send_queue.push_back(topic_ID);
     }
 
-    if (0 == *topic_ID)
+    _send_queue_cv.notify_one();
+}
+
+bool RtpsTopics::waitMsg(uint8_t *topic_ID, std::chrono::milliseconds timeout)
+{
+    if (nullptr == topic_ID) return false;
+
+    std::unique_lock<std::mutex> lock(_send_queue_mutex);
+
+    if (!_send_queue_cv.wait_for(lock, timeout, [this] { return !_send_queue.empty(); }))
     {
-        _next_sub_idx = 0;
         return false;
     }
 
+    *topic_ID = _send_queue.front();
+    _send_queue.pop_front();
     return true;
 }
 
@@ -165,15 +220,15 @@ bool RtpsTopics::getMsg(const uint8_t topic_ID, eprosima::fastcdr::Cdr &scdr)
             {
 @[    if 1.5 <= fastrtpsgen_version <= 1.7]@
 @[        if ros2_distro]@
-                @(package)::msg::dds_::@(topic)_ msg = _@(topic)_sub.getMsg();
+                @(package)::msg::dds_::@(topic)_ msg = _@(topic)_sub.getMsg(&_stats[topic_ID].start);
 @[        else]@
-                @(topic)_ msg = _@(topic)_sub.getMsg();
+                @(topic)_ msg = _@(topic)_sub.getMsg(&_stats[topic_ID].start);
 @[        end if]@
 @[    else]@
 @[        if ros2_distro]@
-                @(package)::msg::@(topic) msg = _@(topic)_sub.getMsg();
+                @(package)::msg::@(topic) msg = _@(topic)_sub.getMsg(&_stats[topic_ID].start);
 @[        else]@
-                @(topic) msg = _@(topic)_sub.getMsg();
+                @(topic) msg = _@(topic)_sub.getMsg(&_stats[topic_ID].start);
 @[        end if]@
 @[    end if]@
                 msg.serialize(scdr);
@@ -188,4 +243,13 @@ bool RtpsTopics::getMsg(const uint8_t topic_ID, eprosima::fastcdr::Cdr &scdr)
 
     return ret;
 }
+
+void RtpsTopics::sent(const uint8_t topic_ID, bool success)
+{
+    if (success) {
+        addLatency(_stats[topic_ID], _stats[topic_ID].start);
+    } else {
+        ++_stats[topic_ID].dropped;
+    }
+}
 @[end if]@
@@ -53,6 +53,12 @@ recv_topics = [(alias[idx] if alias[idx] else s.short_name) for idx, s in enumer
  *
  ****************************************************************************/
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
 #include <fastcdr/Cdr.h>
 
 @[for topic in send_topics]@
@@ -69,11 +75,41 @@ public:
     void publish(uint8_t topic_ID, char data_buffer[], size_t len);
 @[end if]@
 @[if recv_topics]@
-    bool hasMsg(uint8_t *topic_ID);
+    /**
+     * Wait until a subscribed topic has a new message. Topics are returned in the order
+     * in which their messages arrived, each topic is queued at most once.
+     * @@param topic_ID set to the topic with the oldest pending message
+     * @@return false on timeout
+     */
+    bool waitMsg(uint8_t *topic_ID, std::chrono::milliseconds timeout);
     bool getMsg(const uint8_t topic_ID, eprosima::fastcdr::Cdr &scdr);
+
+    /**
+     * Account the transport write of a message obtained with getMsg()
+     */
+    void sent(const uint8_t topic_ID, bool success);
 @[end if]@
 
+    /**
+     * Print the per-topic message counts, drops and latencies
+     */
+    void printStats();
+
 private:
+    struct TopicStats {
+        const char *name{nullptr};
+        bool outbound{false};
+        std::atomic<uint32_t> count{0};
+        std::atomic<uint32_t> dropped{0}; ///< inbound: deserialization failed, outbound: write failed
+        std::atomic<uint64_t> latency_sum_us{0}; ///< inbound: frame to DDS publish, outbound: DDS sample to transport write
+        std::atomic<uint32_t> latency_max_us{0};
+        std::chrono::steady_clock::time_point start; ///< receive time of the message being sent
+    };
+
+    void addLatency(TopicStats &stats, std::chrono::steady_clock::time_point start);
+
+    TopicStats _stats[256];
+
 @[if send_topics]@
     // Publishers
 @[for topic in send_topics]@
@@ -87,11 +123,11 @@ private:
     @(topic)_Subscriber _@(topic)_sub;
 @[end for]@
 
-    unsigned _next_sub_idx = 0;
-    unsigned char _sub_topics[@(len(recv_topics))] = {
-@[for topic in recv_topics]@
-        @(rtps_message_id(ids, topic)), // @(topic)
-@[end for]@
-    };
+    void queueMsg(uint8_t topic_ID);
+
+    // Outbound queue of topics with a pending message, filled by the DDS listeners
+    std::mutex _send_queue_mutex;
+    std::condition_variable _send_queue_cv;
+    std::deque<uint8_t> _send_queue;
 @[end if]@
 };
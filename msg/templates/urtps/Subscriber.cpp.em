@@ -74,8 +74,10 @@ except AttributeError:
 
 @(topic)_Subscriber::~@(topic)_Subscriber() {   Domain::removeParticipant(mp_participant);}
 
-bool @(topic)_Subscriber::init()
+bool @(topic)_Subscriber::init(std::function<void()> on_new_msg)
 {
+    m_listener.on_new_msg = on_new_msg;
+
     // Create RTPSParticipant
     ParticipantAttributes PParam;
     PParam.rtps.builtin.domainId = 0; // MUST BE THE SAME AS IN THE PUBLISHER
@@ -130,7 +132,7 @@ void @(topic)_Subscriber::SubListener::onSubscriptionMatched(Subscriber* sub, Ma
 
 void @(topic)_Subscriber::SubListener::onNewDataMessage(Subscriber* sub)
 {
-        // Take data
+        // Take all available data, only the latest sample is kept until it is sent
 @[if 1.5 <= fastrtpsgen_version <= 1.7]@
 @[    if ros2_distro]@
         @(package)::msg::dds_::@(topic)_ st;
@@ -145,17 +147,34 @@ void @(topic)_Subscriber::SubListener::onNewDataMessage(Subscriber* sub)
 @[    end if]@
 @[end if]@
 
-        if(sub->takeNextData(&st, &m_info))
+        bool notify = false;
+
         {
-            if(m_info.sampleKind == ALIVE)
-            {
-                // Print your structure data here.
-                ++n_msg;
-                //std::cout << "Sample received, count=" << n_msg << std::endl;
-                has_msg = true;
+            std::lock_guard<std::mutex> lock(msg_mutex);
 
+            while (sub->takeNextData(&st, &m_info))
+            {
+                if (m_info.sampleKind == ALIVE)
+                {
+                    ++n_msg;
+
+                    if (has_msg) {
+                        ++n_overwritten;
+                    } else {
+                        notify = true;
+                    }
+
+                    msg = st;
+                    has_msg = true;
+                    receive_time = std::chrono::steady_clock::now();
+                }
             }
         }
+
+        // a message that is already pending is queued for sending already
+        if (notify && on_new_msg) {
+            on_new_msg();
+        }
 }
 
 void @(topic)_Subscriber::run()
@@ -167,23 +186,30 @@ void @(topic)_Subscriber::run()
 
 bool @(topic)_Subscriber::hasMsg()
 {
+    std::lock_guard<std::mutex> lock(m_listener.msg_mutex);
     return m_listener.has_msg;
 }
 
 @[if 1.5 <= fastrtpsgen_version <= 1.7]@
 @[    if ros2_distro]@
-@(package)::msg::dds_::@(topic)_ @(topic)_Subscriber::getMsg()
+@(package)::msg::dds_::@(topic)_ @(topic)_Subscriber::getMsg(std::chrono::steady_clock::time_point *receive_time)
 @[    else]@
-@(topic)_ @(topic)_Subscriber::getMsg()
+@(topic)_ @(topic)_Subscriber::getMsg(std::chrono::steady_clock::time_point *receive_time)
 @[    end if]@
 @[else]@
 @[    if ros2_distro]@
-@(package)::msg::@(topic) @(topic)_Subscriber::getMsg()
+@(package)::msg::@(topic) @(topic)_Subscriber::getMsg(std::chrono::steady_clock::time_point *receive_time)
 @[    else]@
-@(topic) @(topic)_Subscriber::getMsg()
+@(topic) @(topic)_Subscriber::getMsg(std::chrono::steady_clock::time_point *receive_time)
 @[    end if]@
 @[end if]@
 {
+    std::lock_guard<std::mutex> lock(m_listener.msg_mutex);
     m_listener.has_msg = false;
+
+    if (receive_time) {
+        *receive_time = m_listener.receive_time;
+    }
+
     return m_listener.msg;
 }
@@ -65,6 +65,11 @@ except AttributeError:
 #ifndef _@(topic)__SUBSCRIBER_H_
 #define _@(topic)__SUBSCRIBER_H_
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
 #include <fastrtps/fastrtps_fwd.h>
 #include <fastrtps/subscriber/SubscriberListener.h>
 #include <fastrtps/subscriber/SampleInfo.h>
@@ -82,22 +87,27 @@ class @(topic)_Subscriber
 public:
     @(topic)_Subscriber();
     virtual ~@(topic)_Subscriber();
-    bool init();
+    /**
+     * @@param on_new_msg called from the DDS listener thread when a message becomes available
+     */
+    bool init(std::function<void()> on_new_msg = nullptr);
     void run();
     bool hasMsg();
 @[if 1.5 <= fastrtpsgen_version <= 1.7]@
 @[    if ros2_distro]@
-    @(package)::msg::dds_::@(topic)_ getMsg();
+    @(package)::msg::dds_::@(topic)_ getMsg(std::chrono::steady_clock::time_point *receive_time = nullptr);
 @[    else]@
-    @(topic)_ getMsg();
+    @(topic)_ getMsg(std::chrono::steady_clock::time_point *receive_time = nullptr);
 @[    end if]@
 @[else]@
 @[    if ros2_distro]@
-    @(package)::msg::@(topic) getMsg();
+    @(package)::msg::@(topic) getMsg(std::chrono::steady_clock::time_point *receive_time = nullptr);
 @[    else]@
-    @(topic) getMsg();
+    @(topic) getMsg(std::chrono::steady_clock::time_point *receive_time = nullptr);
 @[    end if]@
 @[end if]@
+    /** Number of messages replaced by a newer one before they were taken */
+    uint32_t getOverwritten() const { return m_listener.n_overwritten.load(); }
 private:
     Participant *mp_participant;
     Subscriber *mp_subscriber;
@@ -112,6 +122,10 @@ private:
         SampleInfo_t m_info;
         int n_matched;
         int n_msg;
+        std::atomic<uint32_t> n_overwritten{0};
+        std::function<void()> on_new_msg;
+        std::mutex msg_mutex; ///< protects msg, has_msg and receive_time
+        std::chrono::steady_clock::time_point receive_time;
 @[if 1.5 <= fastrtpsgen_version <= 1.7]@
 @[    if ros2_distro]@
         @(package)::msg::dds_::@(topic)_ msg;
@@ -53,11 +53,14 @@ recv_topics = [(alias[idx] if alias[idx] else s.short_name) for idx, s in enumer
 
 #include <thread>
 #include <atomic>
+#include <mutex>
 #include <unistd.h>
 #include <poll.h>
+#include <pthread.h>
 #include <chrono>
 #include <ctime>
 #include <csignal>
+#include <cstring>
 #include <termios.h>
 
 #include <fastcdr/Cdr.h>
@@ -76,7 +79,7 @@ recv_topics = [(alias[idx] if alias[idx] else s.short_name) for idx, s in enumer
 #define SLEEP_US 1
 #define BAUDRATE B460800
 #define BAUDRATE_VAL 460800
-#define POLL_MS 0
+#define POLL_MS 100
 #define WAIT_CNST 2
 #define DEFAULT_RECV_PORT 2020
 #define DEFAULT_SEND_PORT 2019
@@ -85,9 +88,11 @@ using namespace eprosima;
 using namespace eprosima::fastrtps;
 
 volatile sig_atomic_t running = 1;
+volatile sig_atomic_t print_stats = 0;
 Transport_node *transport_node = nullptr;
+std::mutex transport_write_mutex; // Transport_node::write() is not reentrant
 RtpsTopics topics;
-uint32_t total_sent = 0, sent = 0;
+std::atomic<uint32_t> total_sent{0}, sent{0};
 
 struct baudtype {
     speed_t code;
@@ -119,6 +124,7 @@ struct options {
     int poll_ms = POLL_MS;
     uint16_t recv_port = DEFAULT_RECV_PORT;
     uint16_t send_port = DEFAULT_SEND_PORT;
+    bool echo = false;
 } _options;
 
 static void usage(const char *name)
@@ -126,11 +132,13 @@ static void usage(const char *name)
     printf("usage: %s [options]\n\n"
              "  -t <transport>          [UART|UDP] Default UART\n"
              "  -d <device>             UART device. Default /dev/ttyACM0\n"
-             "  -w <sleep_time_us>      Time in us for which each iteration sleep. Default 1ms\n"
+             "  -w <sleep_time_us>      Unused, the agent blocks on the transport and the DDS listeners\n"
              "  -b <baudrate>           UART device baudrate. Default 460800\n"
-             "  -p <poll_ms>            Time in ms to poll over UART. Default 1ms\n"
-             "  -r <reception port>     UDP port for receiving. Default 2019\n"
-             "  -s <sending port>       UDP port for sending. Default 2020\n",
+             "  -p <poll_ms>            Time in ms to poll over UART/UDP. Default 100ms\n"
+             "  -r <reception port>     UDP port for receiving. Default 2020\n"
+             "  -s <sending port>       UDP port for sending. Default 2019\n"
+             "  -e                      Echo every received frame back over the transport (for benchmarking)\n\n"
+             "Send SIGUSR1 to print the per-topic statistics.\n",
              name);
 }
 
@@ -147,7 +155,7 @@ static int parse_options(int argc, char **argv)
 {
     int ch;
 
-    while ((ch = getopt(argc, argv, "t:d:w:b:p:r:s:")) != EOF)
+    while ((ch = getopt(argc, argv, "t:d:w:b:p:r:s:e")) != EOF)
     {
         switch (ch)
         {
@@ -160,6 +168,7 @@ static int parse_options(int argc, char **argv)
             case 'p': _options.poll_ms        = strtol(optarg, nullptr, 10);  break;
             case 'r': _options.recv_port      = strtoul(optarg, nullptr, 10); break;
             case 's': _options.send_port      = strtoul(optarg, nullptr, 10); break;
+            case 'e': _options.echo           = true;                         break;
             default:
                 usage(argv[0]);
             return -1;
@@ -177,9 +186,21 @@ static int parse_options(int argc, char **argv)
 
 void signal_handler(int signum)
 {
-   printf("Interrupt signal (%d) received.\n", signum);
-   running = 0;
-   transport_node->close();
+    if (signum == SIGUSR1) {
+        print_stats = 1;
+        return;
+    }
+
+    running = 0;
+}
+
+/**
+ * Write a buffer, which must leave get_header_length() bytes free at the beginning
+ */
+static ssize_t transport_write(const uint8_t topic_ID, char buffer[], size_t length)
+{
+    std::lock_guard<std::mutex> lock(transport_write_mutex);
+    return transport_node->write(topic_ID, buffer, length);
 }
 
 @[if recv_topics]@
@@ -190,27 +211,30 @@ void t_send(void *data)
     int length = 0;
     uint8_t topic_ID = 255;
 
-    while (running)
+    // Woken up by the DDS listeners, the timeout only bounds the reaction to exit requests
+    while (running && !exit_sender_thread.load())
     {
-        // Send subscribed topics over UART
-        while (topics.hasMsg(&topic_ID) && !exit_sender_thread.load())
+        if (!topics.waitMsg(&topic_ID, std::chrono::milliseconds(100)))
         {
-            uint16_t header_length = transport_node->get_header_length();
-            /* make room for the header to fill in later */
-            eprosima::fastcdr::FastBuffer cdrbuffer(&data_buffer[header_length], sizeof(data_buffer)-header_length);
-            eprosima::fastcdr::Cdr scdr(cdrbuffer);
-            if (topics.getMsg(topic_ID, scdr))
+            continue;
+        }
+
+        uint16_t header_length = transport_node->get_header_length();
+        /* make room for the header to fill in later */
+        eprosima::fastcdr::FastBuffer cdrbuffer(&data_buffer[header_length], sizeof(data_buffer)-header_length);
+        eprosima::fastcdr::Cdr scdr(cdrbuffer);
+        if (topics.getMsg(topic_ID, scdr))
+        {
+            length = scdr.getSerializedDataLength();
+            length = transport_write(topic_ID, data_buffer, length);
+            topics.sent(topic_ID, length > 0);
+
+            if (0 < length)
             {
-                length = scdr.getSerializedDataLength();
-                if (0 < (length = transport_node->write(topic_ID, data_buffer, length)))
-                {
-                    total_sent += length;
-                    ++sent;
-                }
+                total_sent += length;
+                ++sent;
             }
         }
-
-        usleep(_options.sleep_us);
     }
 }
 @[end if]@
@@ -223,23 +247,27 @@ int main(int argc, char** argv)
         return -1;
     }
 
-    // register signal SIGINT and signal handler
-    signal(SIGINT, signal_handler);
+    // register signal SIGINT and signal handler. No SA_RESTART, such that a blocking read returns
+    struct sigaction sig_action = {};
+    sig_action.sa_handler = signal_handler;
+    sigemptyset(&sig_action.sa_mask);
+    sigaction(SIGINT, &sig_action, nullptr);
+    sigaction(SIGUSR1, &sig_action, nullptr);
 
     switch (_options.transport)
     {
         case options::eTransports::UART:
         {
             transport_node = new UART_node(_options.device, _options.baudrate.code, _options.poll_ms);
-            printf("\nUART transport: device: %s; baudrate: %d; sleep: %dus; poll: %dms\n\n",
-                   _options.device, _options.baudrate.val, _options.sleep_us, _options.poll_ms);
+            printf("\nUART transport: device: %s; baudrate: %d; poll: %dms\n\n",
+                   _options.device, _options.baudrate.val, _options.poll_ms);
         }
         break;
         case options::eTransports::UDP:
         {
-            transport_node = new UDP_node(_options.recv_port, _options.send_port);
-            printf("\nUDP transport: recv port: %u; send port: %u; sleep: %dus\n\n",
-                    _options.recv_port, _options.send_port, _options.sleep_us);
+            transport_node = new UDP_node(_options.recv_port, _options.send_port, _options.poll_ms);
+            printf("\nUDP transport: recv port: %u; send port: %u; poll: %dms\n\n",
+                    _options.recv_port, _options.send_port, _options.poll_ms);
         }
         break;
         default:
@@ -257,13 +285,22 @@ int main(int argc, char** argv)
 
 @[if send_topics]@
     char data_buffer[BUFFER_SIZE] = {};
+    char echo_buffer[BUFFER_SIZE] = {};
     int received = 0, loop = 0;
     int length = 0, total_read = 0;
     bool receiving = false;
     uint8_t topic_ID = 255;
+    const uint16_t header_length = transport_node->get_header_length();
     std::chrono::time_point<std::chrono::steady_clock> start, end;
 @[end if]@
 
+    // The signals are only handled by the main thread, the DDS and sender threads inherit this mask
+    sigset_t signal_set;
+    sigemptyset(&signal_set);
+    sigaddset(&signal_set, SIGINT);
+    sigaddset(&signal_set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signal_set, nullptr);
+
     topics.init();
 
     running = true;
@@ -271,19 +308,38 @@ int main(int argc, char** argv)
     std::thread sender_thread(t_send, nullptr);
 @[end if]@
 
+    pthread_sigmask(SIG_UNBLOCK, &signal_set, nullptr);
+
     while (running)
     {
+        if (print_stats)
+        {
+            print_stats = 0;
+            topics.printStats();
+        }
+
 @[if send_topics]@
         ++loop;
         if (!receiving) start = std::chrono::steady_clock::now();
-        // Publish messages received from UART
+        // Publish messages received from UART/UDP, read() blocks until data arrives, the poll
+        // timeout expires or a signal is received
         while (0 < (length = transport_node->read(&topic_ID, data_buffer, BUFFER_SIZE)))
         {
-            topics.publish(topic_ID, data_buffer, sizeof(data_buffer));
+            const size_t payload_length = length - header_length;
+            topics.publish(topic_ID, data_buffer, payload_length);
+
+            if (_options.echo && payload_length + header_length <= sizeof(echo_buffer))
+            {
+                memcpy(&echo_buffer[header_length], data_buffer, payload_length);
+                transport_write(topic_ID, echo_buffer, payload_length);
+            }
+
             ++received;
             total_read += length;
             receiving = true;
             end = std::chrono::steady_clock::now();
+
+            if (!running || print_stats) break;
         }
 
         if ((receiving && std::chrono::duration<double>(std::chrono::steady_clock::now() - end).count() > WAIT_CNST) ||
@@ -291,20 +347,25 @@ int main(int argc, char** argv)
         {
             std::chrono::duration<double>  elapsed_secs = end - start;
             printf("\nSENT:     %lu messages - %lu bytes\n",
-                    (unsigned long)sent, (unsigned long)total_sent);
+                    (unsigned long)sent.load(), (unsigned long)total_sent.load());
             printf("RECEIVED: %d messages - %d bytes; %d LOOPS - %.03f seconds - %.02fKB/s\n\n",
                     received, total_read, loop, elapsed_secs.count(), (double)total_read/(1000*elapsed_secs.count()));
             received = sent = total_read = total_sent = 0;
             receiving = false;
         }
 
+@[else]@
+        // Nothing to receive, wait for a signal
+        pause();
 @[end if]@
-        usleep(_options.sleep_us);
     }
 @[if recv_topics]@
     exit_sender_thread = true;
     sender_thread.join();
 @[end if]@
+    topics.printStats();
+
+    transport_node->close();
     delete transport_node;
     transport_node = nullptr;
 
@@ -113,27 +113,31 @@ ssize_t Transport_node::read(uint8_t *topic_ID, char out_buffer[], size_t buffer
 
 	*topic_ID = 255;
 
-	ssize_t len = node_read((void *)(rx_buffer + rx_buff_pos), sizeof(rx_buffer) - rx_buff_pos);
+	// We read some
+	size_t header_size = sizeof(struct Header);
+	ssize_t len = 0;
+
+	// Only wait for new data if there is no complete message buffered already, node_read() might block
+	if (!msg_buffered()) {
+		len = node_read((void *)(rx_buffer + rx_buff_pos), sizeof(rx_buffer) - rx_buff_pos);
 
-	if (len <= 0) {
-		int errsv = errno;
+		if (len <= 0) {
+			int errsv = errno;
 
-		if (errsv && EAGAIN != errsv && ETIMEDOUT != errsv) {
+			if (errsv && EAGAIN != errsv && ETIMEDOUT != errsv && EINTR != errsv) {
 #ifndef PX4_ERR
-			printf("Read fail %d\n", errsv);
+				printf("Read fail %d\n", errsv);
 #else
-			PX4_ERR("Read fail %d", errsv);
+				PX4_ERR("Read fail %d", errsv);
 #endif /* PX4_ERR */
+			}
+
+			return len;
 		}
 
-		return len;
+		rx_buff_pos += len;
 	}
 
-	rx_buff_pos += len;
-
-	// We read some
-	size_t header_size = sizeof(struct Header);
-
 	// but not enough
 	if (rx_buff_pos < header_size) {
 		return 0;
@@ -216,6 +220,21 @@ ssize_t Transport_node::read(uint8_t *topic_ID, char out_buffer[], size_t buffer
 	return len;
 }
 
+bool Transport_node::msg_buffered()
+{
+	const size_t header_size = sizeof(struct Header);
+
+	for (uint32_t pos = 0; pos + header_size <= rx_buff_pos; ++pos) {
+		if (memcmp(rx_buffer + pos, ">>>", 3) == 0) {
+			const struct Header *header = (const struct Header *)&rx_buffer[pos];
+			const uint32_t payload_len = ((uint32_t)header->payload_len_h << 8) | header->payload_len_l;
+			return pos + header_size + payload_len <= rx_buff_pos;
+		}
+	}
+
+	return false;
+}
+
 ssize_t Transport_node::get_header_length()
 {
     return sizeof(struct Header);
@@ -535,11 +554,12 @@ bool UART_node::baudrate_to_speed(uint32_t bauds, speed_t *speed)
 	return true;
 }
 
-UDP_node::UDP_node(uint16_t _udp_port_recv, uint16_t _udp_port_send):
+UDP_node::UDP_node(uint16_t _udp_port_recv, uint16_t _udp_port_send, int _poll_ms):
 	sender_fd(-1),
 	receiver_fd(-1),
 	udp_port_recv(_udp_port_recv),
-	udp_port_send(_udp_port_send)
+	udp_port_send(_udp_port_send),
+	poll_ms(_poll_ms)
 {
 }
 
@@ -671,6 +691,24 @@ ssize_t UDP_node::node_read(void *buffer, size_t len)
 
 	int ret = 0;
 #ifndef __PX4_NUTTX
+
+	// Wait for a datagram with a timeout, if requested
+	if (poll_ms >= 0) {
+		struct pollfd poll_fd = {};
+		poll_fd.fd = receiver_fd;
+		poll_fd.events = POLLIN;
+
+		int r = poll(&poll_fd, 1, poll_ms);
+
+		if (r <= 0) {
+			if (r == 0) {
+				errno = EAGAIN;
+			}
+
+			return -1;
+		}
+	}
+
 	// Blocking call
 	static socklen_t addrlen = sizeof(receiver_outaddr);
 	ret = recvfrom(receiver_fd, buffer, len, 0, (struct sockaddr *) &receiver_outaddr, &addrlen);
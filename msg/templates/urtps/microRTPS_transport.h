@@ -72,6 +72,9 @@ protected:
 	uint16_t crc16_byte(uint16_t crc, const uint8_t data);
 	uint16_t crc16(uint8_t const *buffer, size_t len);
 
+	/** @return true if rx_buffer contains a complete message (which might still fail the CRC check) */
+	bool msg_buffered();
+
 protected:
 	uint32_t rx_buff_pos;
 	char rx_buffer[1024] = {};
@@ -113,7 +116,10 @@ protected:
 class UDP_node: public Transport_node
 {
 public:
-	UDP_node(uint16_t udp_port_recv, uint16_t udp_port_send);
+	/**
+	 * @param poll_ms timeout for waiting for a datagram in read(), -1 to block
+	 */
+	UDP_node(uint16_t udp_port_recv, uint16_t udp_port_send, int poll_ms = -1);
 	virtual ~UDP_node();
 
 	int init();
@@ -130,6 +136,7 @@ protected:
 	int receiver_fd;
 	uint16_t udp_port_recv;
 	uint16_t udp_port_send;
+	int poll_ms;
 	struct sockaddr_in sender_outaddr;
 	struct sockaddr_in receiver_inaddr;
 	struct sockaddr_in receiver_outaddr;
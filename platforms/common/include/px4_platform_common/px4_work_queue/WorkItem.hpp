@@ -35,6 +35,7 @@
 
 #include "WorkQueueManager.hpp"
 #include "WorkQueue.hpp"
+#include "WorkItemBudget.hpp"
 
 #include <containers/IntrusiveQueue.hpp>
 #include <px4_defines.h>
@@ -62,6 +63,24 @@ public:
 	 */
 	bool ChangeWorkQeue(const wq_config_t &config) { return Init(config); }
 
+	/**
+	 * Declare the execution budget of each run. The WorkQueue measures the runtime and start
+	 * lateness of every run and applies the policy once the budget is exceeded on several
+	 * consecutive runs (see WorkItemBudget).
+	 *
+	 * @param budget_us Execution budget per run in microseconds, 0 to disable.
+	 * @param period_us Expected period in microseconds, 0 to keep the current one (e.g. from ScheduleOnInterval).
+	 * @param policy Action on chronic overruns.
+	 */
+	void SetExecutionBudget(uint32_t budget_us, uint32_t period_us = 0,
+				WorkItemBudget::Policy policy = WorkItemBudget::Policy::Report)
+	{
+		_budget.configure(budget_us, (period_us > 0) ? period_us : _budget.period(), policy);
+	}
+
+	const char *ItemName() const { return _item_name; }
+	const WorkItemBudget &budget() const { return _budget; }
+
 protected:
 
 	explicit WorkItem(const char *name, const wq_config_t &config);
@@ -73,7 +92,7 @@ protected:
 
 	void RunPreamble() { _run_count++; }
 
-	friend void WorkQueue::Run();
+	friend class WorkQueue;
 	virtual void Run() = 0;
 
 	/**
@@ -91,15 +110,21 @@ protected:
 	float average_rate() const;
 	float average_interval() const;
 
+	void print_budget_status() const;
 
 	hrt_abstime	_start_time{0};
 	unsigned	_run_count{0};
 	const char 	*_item_name;
 
+	WorkItemBudget	_budget{};
+
 private:
 
 	WorkQueue	*_wq{nullptr};
 
+	// accessed by the WorkQueue
+	hrt_abstime		_queued_time{0};
+
 };
 
 } // namespace px4
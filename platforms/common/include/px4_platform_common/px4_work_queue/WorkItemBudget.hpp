@@ -0,0 +1,199 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file WorkItemBudget.hpp
+ *
+ * Execution budget accounting of a WorkItem: runtime and start lateness
+ * statistics, overrun detection and the policy for chronic overruns.
+ * Timestamps are passed in by the WorkQueue, so this has no platform dependencies.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace px4
+{
+
+class WorkItemBudget
+{
+public:
+
+	enum class Policy : uint8_t {
+		Report = 0,	///< count and report overruns only
+		Skip = 1,	///< skip every other run while chronically overrunning
+	};
+
+	enum class Event : uint8_t {
+		None = 0,
+		Chronic,	///< overran the budget on overrun_limit consecutive runs
+		Recovered,	///< back within budget for overrun_limit consecutive runs
+	};
+
+	/**
+	 * @param budget_us execution budget per run in microseconds, 0 to disable overrun detection
+	 * @param period_us expected period in microseconds, 0 if not periodic
+	 * @param policy action when the item overruns chronically
+	 * @param overrun_limit consecutive overruns (and runs within budget) to enter (and leave) the chronic state
+	 */
+	void configure(uint32_t budget_us, uint32_t period_us, Policy policy, uint16_t overrun_limit = 5)
+	{
+		_budget_us = budget_us;
+		_period_us = period_us;
+		_policy = policy;
+		_overrun_limit = (overrun_limit > 0) ? overrun_limit : 1;
+		_consecutive = 0;
+		_chronic = false;
+	}
+
+	void set_period(uint32_t period_us) { _period_us = period_us; }
+
+	/**
+	 * Called before the item runs.
+	 * @param now current time
+	 * @param queued time the item was scheduled, 0 if unknown
+	 * @return false if the run is to be skipped
+	 */
+	bool begin(uint64_t now, uint64_t queued)
+	{
+		if (_chronic && (_policy == Policy::Skip) && ((++_skip_toggle & 1) != 0)) {
+			_skip_count++;
+			return false;
+		}
+
+		const uint32_t lateness = ((queued > 0) && (now > queued)) ? (uint32_t)(now - queued) : 0;
+		_lateness_sum += lateness;
+
+		if (lateness > _lateness_max) {
+			_lateness_max = lateness;
+		}
+
+		// started more than a full period after it was scheduled, at least one cycle was lost
+		if ((_period_us > 0) && (lateness > _period_us)) {
+			_late_count++;
+		}
+
+		_start = now;
+		return true;
+	}
+
+	/**
+	 * Called after the item ran.
+	 * @param now current time
+	 * @return a change of the chronic overrun state
+	 */
+	Event end(uint64_t now)
+	{
+		const uint32_t runtime = (now > _start) ? (uint32_t)(now - _start) : 0;
+		_runtime_last = runtime;
+		_runtime_sum += runtime;
+		_run_count++;
+
+		if (runtime > _runtime_max) {
+			_runtime_max = runtime;
+		}
+
+		if (_budget_us == 0) {
+			return Event::None;
+		}
+
+		if (runtime > _budget_us) {
+			_overrun_count++;
+			_consecutive = _chronic ? 0 : _consecutive + 1;
+
+			if (!_chronic && (_consecutive >= _overrun_limit)) {
+				_chronic = true;
+				_consecutive = 0;
+				return Event::Chronic;
+			}
+
+		} else {
+			_consecutive = _chronic ? _consecutive + 1 : 0;
+
+			if (_chronic && (_consecutive >= _overrun_limit)) {
+				_chronic = false;
+				_consecutive = 0;
+				return Event::Recovered;
+			}
+		}
+
+		return Event::None;
+	}
+
+	bool enabled() const { return _budget_us > 0; }
+	bool chronic() const { return _chronic; }
+
+	Policy policy() const { return _policy; }
+	uint32_t budget() const { return _budget_us; }
+	uint32_t period() const { return _period_us; }
+
+	uint32_t run_count() const { return _run_count; }
+	uint32_t overrun_count() const { return _overrun_count; }
+	uint32_t late_count() const { return _late_count; }
+	uint32_t skip_count() const { return _skip_count; }
+
+	uint32_t runtime_last() const { return _runtime_last; }
+	uint32_t runtime_max() const { return _runtime_max; }
+	uint32_t runtime_avg() const { return (_run_count > 0) ? (uint32_t)(_runtime_sum / _run_count) : 0; }
+
+	uint32_t lateness_max() const { return _lateness_max; }
+	uint32_t lateness_avg() const { return (_run_count > 0) ? (uint32_t)(_lateness_sum / _run_count) : 0; }
+
+private:
+
+	uint64_t	_start{0};
+	uint64_t	_runtime_sum{0};
+	uint64_t	_lateness_sum{0};
+
+	uint32_t	_budget_us{0};
+	uint32_t	_period_us{0};
+
+	uint32_t	_run_count{0};
+	uint32_t	_overrun_count{0};
+	uint32_t	_late_count{0};
+	uint32_t	_skip_count{0};
+
+	uint32_t	_runtime_last{0};
+	uint32_t	_runtime_max{0};
+	uint32_t	_lateness_max{0};
+
+	uint16_t	_overrun_limit{5};
+	uint16_t	_consecutive{0};	///< consecutive overruns, or runs within budget while chronic
+	uint8_t		_skip_toggle{0};
+
+	Policy		_policy{Policy::Report};
+	bool		_chronic{false};
+};
+
+} // namespace px4
@@ -34,6 +34,7 @@
 #pragma once
 
 #include "WorkQueueManager.hpp"
+#include "WorkItemBudget.hpp"
 
 #include <containers/BlockingList.hpp>
 #include <containers/List.hpp>
@@ -58,6 +59,8 @@ public:
 
 	const char *get_name() { return _config.name; }
 
+	pthread_t get_thread() const { return _thread; }
+
 	bool Attach(WorkItem *item);
 	void Detach(WorkItem *item);
 
@@ -72,12 +75,27 @@ public:
 
 	void print_status(bool last = false);
 
+	/**
+	 * Call func for each attached WorkItem.
+	 */
+	template<typename F>
+	void for_each_item(F func)
+	{
+		LockGuard lg{_work_items.mutex()};
+
+		for (WorkItem *item : _work_items) {
+			func(*item);
+		}
+	}
+
 private:
 
 	bool should_exit() const { return _should_exit.load(); }
 
 	inline void signal_worker_thread();
 
+	void budget_event(WorkItem *item, WorkItemBudget::Event event);
+
 #ifdef __PX4_NUTTX
 	// In NuttX work can be enqueued from an ISR
 	void work_lock() { _flags = enter_critical_section(); }
@@ -92,9 +110,12 @@ private:
 	IntrusiveQueue<WorkItem *>	_q;
 	px4_sem_t			_process_lock;
 	const wq_config_t		&_config;
+	const pthread_t			_thread{pthread_self()}; ///< constructed on the work queue thread
 	BlockingList<WorkItem *>	_work_items;
 	px4::atomic_bool		_should_exit{false};
 
+	WorkItem			*_current_item{nullptr}; ///< item currently running, cleared if it detaches while running
+
 };
 
 } // namespace px4
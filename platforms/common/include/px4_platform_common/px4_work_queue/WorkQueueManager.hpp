@@ -33,12 +33,14 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace px4
 {
 
 class WorkQueue; // forward declaration
+class WorkItem;
 
 struct wq_config_t {
 	const char *name;
@@ -87,6 +89,33 @@ int WorkQueueManagerStop();
  */
 int WorkQueueManagerStatus();
 
+/**
+ * Call a function for every WorkItem of every running work queue (e.g. to publish budget status).
+ *
+ * @param func		Called with the work queue name, the item and arg.
+ * @param arg		Passed through to func.
+ */
+void WorkQueueManagerForEachItem(void (*func)(const char *wq_name, const WorkItem &item, void *arg), void *arg);
+
+/**
+ * Pin a work queue thread to a set of CPUs (Linux). Takes effect immediately if the
+ * work queue is running, otherwise when it is created.
+ *
+ * @param name		The work queue name, with or without "wq:" prefix (e.g. "wq:rate_ctrl").
+ * @param cpus		CPU bit mask (bit i: CPU i), 0 for all CPUs.
+ * @return		PX4_OK, or PX4_ERROR if not supported.
+ */
+int WorkQueueManagerSetAffinity(const char *name, uint32_t cpus);
+
+/**
+ * Lock all current and future memory and pre-fault a heap reserve (POSIX). Work queue
+ * threads created afterwards pre-fault their stacks.
+ *
+ * @param heap_reserve	Bytes of heap to pre-fault.
+ * @return		PX4_OK or PX4_ERROR.
+ */
+int WorkQueueManagerLockMemory(size_t heap_reserve);
+
 /**
  * Create (or find) a work queue with a particular configuration.
  *
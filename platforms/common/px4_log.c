@@ -43,18 +43,176 @@
 #include <px4_log.h>
 #if defined(__PX4_POSIX)
 #include <px4_daemon/server_io.h>
+#include <px4_log_deferred.h>
+#include <px4_tasks.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 #endif
 
 #include <uORB/uORB.h>
 #include <uORB/topics/log_message.h>
 #include <drivers/drv_hrt.h>
 
+#define LOG_MESSAGE_QUEUE_LENGTH 8
+
 static orb_advert_t orb_log_message_pub = NULL;
 
 __EXPORT const char *__px4_log_level_str[_PX4_LOG_LEVEL_PANIC + 1] = { "DEBUG", "INFO", "WARN", "ERROR", "PANIC" };
 __EXPORT const char *__px4_log_level_color[_PX4_LOG_LEVEL_PANIC + 1] =
 { PX4_ANSI_COLOR_GREEN, PX4_ANSI_COLOR_RESET, PX4_ANSI_COLOR_YELLOW, PX4_ANSI_COLOR_RED, PX4_ANSI_COLOR_RED };
 
+static const uint8_t log_level_table[_PX4_LOG_LEVEL_PANIC + 1] = {
+	7, /* _PX4_LOG_LEVEL_DEBUG */
+	6, /* _PX4_LOG_LEVEL_INFO */
+	4, /* _PX4_LOG_LEVEL_WARN */
+	3, /* _PX4_LOG_LEVEL_ERROR */
+	0  /* _PX4_LOG_LEVEL_PANIC */
+};
+
+#if defined(__PX4_POSIX)
+/*
+ * Messages of threads without a client stdout are not formatted on the calling thread,
+ * but stored into a per-thread ring and printed and published by the formatter task.
+ * Raw output of these threads goes through the same ring (without module name) to keep
+ * the order. PANIC messages and threads with a client stdout (commands) are always
+ * logged immediately.
+ */
+static bool log_deferred_running = false;
+static bool log_deferred_publish = true;
+
+// Only the formatter drains and publishes while running, such that the log_message queue
+// is never filled faster than the logger reads it. Other threads wake it up to flush.
+static pthread_mutex_t log_formatter_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_formatter_cond = PTHREAD_COND_INITIALIZER;
+static bool log_formatter_wakeup = false;
+
+static void log_deferred_output(void *context, uint64_t timestamp, int level, const char *moduleName,
+				const char *text)
+{
+	bool use_color = true;
+	FILE *out = get_stdout(&use_color);
+
+#ifndef PX4_LOG_COLORIZED_OUTPUT
+	use_color = false;
+#endif
+
+	// raw output (PX4_INFO_RAW) is printed as is and not published
+	if (!moduleName) {
+		if (use_color) { fputs(__px4_log_level_color[level], out); }
+
+		fputs(text, out);
+
+		if (use_color) { fputs(PX4_ANSI_COLOR_RESET, out); }
+
+		return;
+	}
+
+	if (use_color) { fputs(__px4_log_level_color[level], out); }
+
+	fprintf(out, __px4__log_level_fmt __px4__log_level_arg(level));
+
+	if (use_color) { fputs(PX4_ANSI_COLOR_GRAY, out); }
+
+	fprintf(out, __px4__log_modulename_pfmt, moduleName);
+
+	if (use_color) { fputs(__px4_log_level_color[level], out); }
+
+	fputs(text, out);
+
+	if (use_color) { fputs(PX4_ANSI_COLOR_RESET, out); }
+
+	fputc('\n', out);
+
+#if !defined(PARAM_NO_ORB)
+
+	if (orb_log_message_pub && __atomic_load_n(&log_deferred_publish, __ATOMIC_RELAXED)) {
+		struct log_message_s log_message;
+		log_message.timestamp = timestamp;
+		log_message.severity = log_level_table[level];
+		snprintf((char *)log_message.text, sizeof(log_message.text), __px4__log_modulename_pfmt "%s", moduleName, text);
+		orb_publish(ORB_ID(log_message), orb_log_message_pub, &log_message);
+	}
+
+#endif /* !PARAM_NO_ORB */
+}
+
+static int log_formatter_main(int argc, char *argv[])
+{
+	px4_log_deferred_set_thread_enabled(false);
+
+	uint32_t dropped_reported = 0;
+
+	while (true) {
+		// the logger reads up to the queue length per iteration, publishing more at once would drop messages
+		const int processed = px4_log_deferred_drain(log_deferred_output, NULL, LOG_MESSAGE_QUEUE_LENGTH);
+
+		struct px4_log_deferred_stats_s stats;
+		px4_log_deferred_get_stats(&stats);
+
+		if (stats.dropped != dropped_reported) {
+			char text[64];
+			snprintf(text, sizeof(text), "%u log messages dropped", (unsigned)(stats.dropped - dropped_reported));
+			log_deferred_output(NULL, hrt_absolute_time(), _PX4_LOG_LEVEL_WARN, MODULE_NAME, text);
+			dropped_reported = stats.dropped;
+		}
+
+		// real time instead of px4_usleep: the output must not depend on the lockstep simulation
+		if (processed == LOG_MESSAGE_QUEUE_LENGTH) {
+			// give the logger time to read the queue
+			usleep(4000);
+
+		} else {
+			struct timespec timeout;
+			clock_gettime(CLOCK_REALTIME, &timeout);
+			timeout.tv_nsec += 20 * 1000 * 1000;
+
+			if (timeout.tv_nsec >= 1000 * 1000 * 1000) {
+				timeout.tv_sec++;
+				timeout.tv_nsec -= 1000 * 1000 * 1000;
+			}
+
+			pthread_mutex_lock(&log_formatter_mutex);
+
+			while (!log_formatter_wakeup
+			       && pthread_cond_timedwait(&log_formatter_cond, &log_formatter_mutex, &timeout) == 0) {}
+
+			log_formatter_wakeup = false;
+			pthread_mutex_unlock(&log_formatter_mutex);
+		}
+	}
+
+	return 0;
+}
+
+static void log_flush_at_exit(void)
+{
+	// uORB might already be gone, the remaining messages are only printed
+	__atomic_store_n(&log_deferred_publish, false, __ATOMIC_RELAXED);
+
+	if (__atomic_load_n(&log_deferred_running, __ATOMIC_ACQUIRE)) {
+		px4_log_deferred_drain(log_deferred_output, NULL, 1 << 30);
+	}
+}
+
+void px4_log_set_deferred(bool deferred)
+{
+	px4_log_deferred_set_thread_enabled(deferred);
+}
+
+void px4_log_flush(void)
+{
+	if (!__atomic_load_n(&log_deferred_running, __ATOMIC_ACQUIRE) || !px4_log_deferred_thread_pending()) {
+		return;
+	}
+
+	pthread_mutex_lock(&log_formatter_mutex);
+	log_formatter_wakeup = true;
+	pthread_cond_signal(&log_formatter_cond);
+	pthread_mutex_unlock(&log_formatter_mutex);
+}
+#endif /* __PX4_POSIX */
+
 
 void px4_log_initialize(void)
 {
@@ -67,12 +225,24 @@ void px4_log_initialize(void)
 	strcpy((char *)log_message.text, "initialized uORB logging");
 
 #if !defined(PARAM_NO_ORB)
-	orb_log_message_pub = orb_advertise_queue(ORB_ID(log_message), &log_message, 2);
+	orb_log_message_pub = orb_advertise_queue(ORB_ID(log_message), &log_message, LOG_MESSAGE_QUEUE_LENGTH);
 #endif /* !PARAM_NO_ORB */
 
 	if (!orb_log_message_pub) {
 		PX4_ERR("failed to advertise log_message");
 	}
+
+#if defined(__PX4_POSIX)
+
+	if (px4_task_spawn_cmd("log_formatter", SCHED_DEFAULT, SCHED_PRIORITY_LOG_FORMATTER, 2500, log_formatter_main,
+			       NULL) < 0) {
+		PX4_ERR("log formatter task start failed");
+		return;
+	}
+
+	atexit(log_flush_at_exit);
+	__atomic_store_n(&log_deferred_running, true, __ATOMIC_RELEASE);
+#endif /* __PX4_POSIX */
 }
 
 
@@ -83,6 +253,20 @@ __EXPORT void px4_log_modulename(int level, const char *moduleName, const char *
 
 #ifdef __PX4_POSIX
 	out = get_stdout(&use_color);
+
+	if (level >= _PX4_LOG_LEVEL_INFO && level < _PX4_LOG_LEVEL_PANIC && out == stdout
+	    && __atomic_load_n(&log_deferred_running, __ATOMIC_RELAXED)) {
+
+		va_list argptr;
+		va_start(argptr, fmt);
+		const int ret = px4_log_deferred_write(hrt_absolute_time(), level, moduleName, fmt, argptr);
+		va_end(argptr);
+
+		if (ret != PX4_LOG_DEFERRED_SYNC) {
+			return;
+		}
+	}
+
 #endif
 
 #ifndef PX4_LOG_COLORIZED_OUTPUT
@@ -116,14 +300,6 @@ __EXPORT void px4_log_modulename(int level, const char *moduleName, const char *
 		struct log_message_s log_message;
 		const unsigned max_length_pub = sizeof(log_message.text);
 		log_message.timestamp = hrt_absolute_time();
-
-		const uint8_t log_level_table[] = {
-			7, /* _PX4_LOG_LEVEL_DEBUG */
-			6, /* _PX4_LOG_LEVEL_INFO */
-			4, /* _PX4_LOG_LEVEL_WARN */
-			3, /* _PX4_LOG_LEVEL_ERROR */
-			0  /* _PX4_LOG_LEVEL_PANIC */
-		};
 		log_message.severity = log_level_table[level];
 
 		unsigned pos = 0;
@@ -149,6 +325,22 @@ __EXPORT void px4_log_raw(int level, const char *fmt, ...)
 
 #ifdef __PX4_POSIX
 	out = get_stdout(&use_color);
+
+	// defer as well to keep the order with the deferred messages of this thread
+	if (level >= _PX4_LOG_LEVEL_INFO && out == stdout && __atomic_load_n(&log_deferred_running, __ATOMIC_RELAXED)) {
+		va_list argptr;
+		va_start(argptr, fmt);
+		const int ret = px4_log_deferred_write(hrt_absolute_time(), level, NULL, fmt, argptr);
+		va_end(argptr);
+
+		if (ret != PX4_LOG_DEFERRED_SYNC) {
+			return;
+		}
+
+		// unsupported format: printed immediately, possibly ahead of pending messages of this thread
+		px4_log_flush();
+	}
+
 #endif
 
 #ifndef PX4_LOG_COLORIZED_OUTPUT
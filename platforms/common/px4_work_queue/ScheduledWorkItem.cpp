@@ -60,6 +60,8 @@ ScheduledWorkItem::ScheduleOnInterval(uint32_t interval_us, uint32_t delay_us)
 	// reset start time to first deadline (approximately)
 	_start_time = hrt_absolute_time() + interval_us + delay_us;
 
+	_budget.set_period(interval_us);
+
 	hrt_call_every(&_call, delay_us, interval_us, (hrt_callout)&ScheduledWorkItem::schedule_trampoline, this);
 }
 
@@ -73,8 +75,9 @@ void
 ScheduledWorkItem::print_run_status() const
 {
 	if (_call.period > 0) {
-		PX4_INFO_RAW("%-24s %8.1f Hz %12.1f us (%" PRId64 " us)\n", _item_name, (double)average_rate(),
+		PX4_INFO_RAW("%-24s %8.1f Hz %12.1f us (%" PRId64 " us)", _item_name, (double)average_rate(),
 			     (double)average_interval(), _call.period);
+		print_budget_status();
 
 	} else {
 		WorkItem::print_run_status();
@@ -39,6 +39,8 @@
 #include <px4_log.h>
 #include <drivers/drv_hrt.h>
 
+#include <inttypes.h>
+
 namespace px4
 {
 
@@ -122,7 +124,22 @@ WorkItem::average_interval() const
 void
 WorkItem::print_run_status() const
 {
-	PX4_INFO_RAW("%-24s %8.1f Hz %12.1f us\n", _item_name, (double)average_rate(), (double)average_interval());
+	PX4_INFO_RAW("%-24s %8.1f Hz %12.1f us", _item_name, (double)average_rate(), (double)average_interval());
+	print_budget_status();
+}
+
+void
+WorkItem::print_budget_status() const
+{
+	PX4_INFO_RAW("  runtime avg %" PRIu32 " max %" PRIu32 " us, lateness avg %" PRIu32 " max %" PRIu32 " us",
+		     _budget.runtime_avg(), _budget.runtime_max(), _budget.lateness_avg(), _budget.lateness_max());
+
+	if (_budget.enabled()) {
+		PX4_INFO_RAW(", budget %" PRIu32 " us, %" PRIu32 " overruns, %" PRIu32 " late%s", _budget.budget(),
+			     _budget.overrun_count(), _budget.late_count(), _budget.chronic() ? " (chronic)" : "");
+	}
+
+	PX4_INFO_RAW("\n");
 }
 
 } // namespace px4
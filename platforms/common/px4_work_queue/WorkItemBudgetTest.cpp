@@ -0,0 +1,255 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the WorkItem execution budget accounting
+ * Run this test only using make tests TESTFILTER=WorkItemBudget
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include <px4_platform_common/px4_work_queue/WorkItemBudget.hpp>
+
+using px4::WorkItemBudget;
+
+/**
+ * Synthetic work items on a simulated single threaded work queue: all items are
+ * scheduled at the start of each period and run back to back in order, taking
+ * the injected runtime, as WorkQueue::Run() would.
+ */
+class WorkItemBudgetTest : public ::testing::Test
+{
+public:
+	static constexpr uint32_t PERIOD = 1000; // [us]
+
+	struct SyntheticItem {
+		WorkItemBudget budget;
+		uint32_t runtime{100}; ///< runtime of the next runs [us]
+		std::vector<WorkItemBudget::Event> events;
+		unsigned runs{0};
+	};
+
+	/** run one period of the queue with the items in order */
+	void runPeriod(std::vector<SyntheticItem *> items)
+	{
+		const uint64_t queued = _now;
+
+		for (SyntheticItem *item : items) {
+			if (item->budget.begin(_now, queued)) {
+				_now += item->runtime;
+				item->runs++;
+
+				const WorkItemBudget::Event event = item->budget.end(_now);
+
+				if (event != WorkItemBudget::Event::None) {
+					item->events.push_back(event);
+				}
+			}
+		}
+
+		_now = queued + PERIOD;
+	}
+
+	void runPeriods(std::vector<SyntheticItem *> items, unsigned count)
+	{
+		for (unsigned i = 0; i < count; i++) {
+			runPeriod(items);
+		}
+	}
+
+private:
+	uint64_t _now{1000000};
+};
+
+TEST_F(WorkItemBudgetTest, withinBudget)
+{
+	SyntheticItem item;
+	item.budget.configure(200, PERIOD, WorkItemBudget::Policy::Report);
+	item.runtime = 150;
+
+	runPeriods({&item}, 100);
+
+	EXPECT_EQ(item.budget.run_count(), 100u);
+	EXPECT_EQ(item.budget.overrun_count(), 0u);
+	EXPECT_EQ(item.budget.late_count(), 0u);
+	EXPECT_EQ(item.budget.runtime_avg(), 150u);
+	EXPECT_EQ(item.budget.runtime_max(), 150u);
+	EXPECT_FALSE(item.budget.chronic());
+	EXPECT_TRUE(item.events.empty());
+}
+
+TEST_F(WorkItemBudgetTest, noBudgetOnlyMeasures)
+{
+	SyntheticItem item;
+	item.runtime = 5000;
+
+	runPeriods({&item}, 20);
+
+	EXPECT_FALSE(item.budget.enabled());
+	EXPECT_EQ(item.budget.run_count(), 20u);
+	EXPECT_EQ(item.budget.runtime_max(), 5000u);
+	EXPECT_EQ(item.budget.overrun_count(), 0u);
+	EXPECT_TRUE(item.events.empty());
+}
+
+TEST_F(WorkItemBudgetTest, sporadicOverrunsAreNotChronic)
+{
+	SyntheticItem item;
+	item.budget.configure(200, PERIOD, WorkItemBudget::Policy::Report, 5);
+
+	for (int i = 0; i < 10; i++) {
+		// 4 consecutive overruns, one below the limit, then back within budget
+		item.runtime = 300;
+		runPeriods({&item}, 4);
+		item.runtime = 100;
+		runPeriods({&item}, 1);
+	}
+
+	EXPECT_EQ(item.budget.overrun_count(), 40u);
+	EXPECT_EQ(item.budget.runtime_last(), 100u);
+	EXPECT_EQ(item.budget.runtime_max(), 300u);
+	EXPECT_FALSE(item.budget.chronic());
+	EXPECT_TRUE(item.events.empty());
+}
+
+TEST_F(WorkItemBudgetTest, chronicOverrunAndRecovery)
+{
+	SyntheticItem item;
+	item.budget.configure(200, PERIOD, WorkItemBudget::Policy::Report, 5);
+
+	item.runtime = 100;
+	runPeriods({&item}, 10);
+
+	// injected overruns: reported once when becoming chronic
+	item.runtime = 400;
+	runPeriods({&item}, 4);
+	EXPECT_TRUE(item.events.empty());
+	runPeriods({&item}, 1);
+	ASSERT_EQ(item.events.size(), 1u);
+	EXPECT_EQ(item.events[0], WorkItemBudget::Event::Chronic);
+	EXPECT_TRUE(item.budget.chronic());
+
+	runPeriods({&item}, 50);
+	EXPECT_EQ(item.events.size(), 1u);
+	EXPECT_EQ(item.budget.overrun_count(), 55u);
+
+	// an overrun in between restarts the recovery
+	item.runtime = 100;
+	runPeriods({&item}, 4);
+	item.runtime = 400;
+	runPeriods({&item}, 1);
+	item.runtime = 100;
+	runPeriods({&item}, 4);
+	EXPECT_TRUE(item.budget.chronic());
+	runPeriods({&item}, 1);
+
+	ASSERT_EQ(item.events.size(), 2u);
+	EXPECT_EQ(item.events[1], WorkItemBudget::Event::Recovered);
+	EXPECT_FALSE(item.budget.chronic());
+
+	// Report policy never skips
+	EXPECT_EQ(item.budget.skip_count(), 0u);
+	EXPECT_EQ(item.runs, 75u);
+}
+
+TEST_F(WorkItemBudgetTest, skipPolicyHalvesChronicRuns)
+{
+	SyntheticItem item;
+	item.budget.configure(200, PERIOD, WorkItemBudget::Policy::Skip, 5);
+
+	item.runtime = 400;
+	runPeriods({&item}, 5);
+	EXPECT_TRUE(item.budget.chronic());
+	EXPECT_EQ(item.runs, 5u);
+
+	runPeriods({&item}, 100);
+	EXPECT_EQ(item.runs, 55u);
+	EXPECT_EQ(item.budget.skip_count(), 50u);
+	EXPECT_EQ(item.budget.run_count(), 55u);
+
+	// runs within budget recover, skipped runs do not count
+	item.runtime = 100;
+	runPeriods({&item}, 9);
+	EXPECT_TRUE(item.budget.chronic());
+	runPeriods({&item}, 1);
+	EXPECT_FALSE(item.budget.chronic());
+
+	const unsigned runs = item.runs;
+	runPeriods({&item}, 10);
+	EXPECT_EQ(item.runs, runs + 10);
+}
+
+TEST_F(WorkItemBudgetTest, overrunIsAttributedNotTheLateItem)
+{
+	// a driver overrunning on the same queue delays the controller behind it
+	SyntheticItem driver;
+	driver.budget.configure(300, PERIOD, WorkItemBudget::Policy::Report, 5);
+	driver.runtime = 200;
+
+	SyntheticItem controller;
+	controller.budget.configure(300, PERIOD, WorkItemBudget::Policy::Report, 5);
+	controller.runtime = 200;
+
+	runPeriods({&driver, &controller}, 10);
+	EXPECT_EQ(controller.budget.lateness_max(), 200u);
+	EXPECT_EQ(controller.budget.late_count(), 0u);
+
+	// injected overrun of more than a period
+	driver.runtime = 1500;
+	runPeriods({&driver, &controller}, 1);
+
+	EXPECT_EQ(driver.budget.overrun_count(), 1u);
+	EXPECT_EQ(driver.budget.runtime_max(), 1500u);
+	EXPECT_EQ(driver.budget.lateness_max(), 0u);
+
+	EXPECT_EQ(controller.budget.overrun_count(), 0u);
+	EXPECT_EQ(controller.budget.late_count(), 1u);
+	EXPECT_EQ(controller.budget.lateness_max(), 1500u);
+	EXPECT_EQ(controller.budget.runtime_max(), 200u);
+}
+
+TEST_F(WorkItemBudgetTest, unknownQueueTime)
+{
+	WorkItemBudget budget;
+	budget.configure(100, PERIOD, WorkItemBudget::Policy::Report);
+
+	// items run without being queued through WorkQueue::Add() have no lateness
+	EXPECT_TRUE(budget.begin(5000, 0));
+	budget.end(5050);
+
+	EXPECT_EQ(budget.lateness_max(), 0u);
+	EXPECT_EQ(budget.late_count(), 0u);
+	EXPECT_EQ(budget.runtime_max(), 50u);
+}
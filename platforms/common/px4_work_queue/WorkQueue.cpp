@@ -36,10 +36,17 @@
 
 #include <string.h>
 
+#include <px4_log.h>
 #include <px4_tasks.h>
 #include <px4_time.h>
 #include <drivers/drv_hrt.h>
 
+#include <inttypes.h>
+
+#if defined(__PX4_POSIX) && !defined(__PX4_QURT)
+#include <px4_rt_profile.h>
+#endif
+
 namespace px4
 {
 
@@ -94,6 +101,11 @@ WorkQueue::Detach(WorkItem *item)
 
 	_work_items.remove(item);
 
+	if (_current_item == item) {
+		// detached (deleted or moved to another queue) while running
+		_current_item = nullptr;
+	}
+
 	if (_work_items.size() == 0) {
 		// shutdown, no active WorkItems
 		PX4_DEBUG("stopping: %s, last active WorkItem closing", _config.name);
@@ -108,7 +120,15 @@ WorkQueue::Detach(WorkItem *item)
 void
 WorkQueue::Add(WorkItem *item)
 {
+	const hrt_abstime now = hrt_absolute_time();
+
 	work_lock();
+
+	// keep the time of the first activation if already queued
+	if (item->_queued_time == 0) {
+		item->_queued_time = now;
+	}
+
 	_q.push(item);
 	work_unlock();
 
@@ -130,6 +150,7 @@ WorkQueue::Remove(WorkItem *item)
 {
 	work_lock();
 	_q.remove(item);
+	item->_queued_time = 0;
 	work_unlock();
 }
 
@@ -139,7 +160,7 @@ WorkQueue::Clear()
 	work_lock();
 
 	while (!_q.empty()) {
-		_q.pop();
+		_q.pop()->_queued_time = 0;
 	}
 
 	work_unlock();
@@ -156,11 +177,34 @@ WorkQueue::Run()
 		// process queued work
 		while (!_q.empty()) {
 			WorkItem *work = _q.pop();
+			const hrt_abstime queued = work->_queued_time;
+			work->_queued_time = 0;
+
+			if (!work->_budget.begin(hrt_absolute_time(), queued)) {
+				// skipped by the budget policy
+				continue;
+			}
+
+			_current_item = work;
 
 			work_unlock(); // unlock work queue to run (item may requeue itself)
 			work->RunPreamble();
 			work->Run();
+			const hrt_abstime end = hrt_absolute_time();
 			work_lock(); // re-lock
+
+			// skip the accounting if the item detached (e.g. deleted itself) while running
+			if (_current_item == work) {
+				_current_item = nullptr;
+
+				const WorkItemBudget::Event event = work->_budget.end(end);
+
+				if (event != WorkItemBudget::Event::None) {
+					work_unlock();
+					budget_event(work, event);
+					work_lock();
+				}
+			}
 		}
 
 		work_unlock();
@@ -169,11 +213,54 @@ WorkQueue::Run()
 	PX4_DEBUG("%s: exiting", _config.name);
 }
 
+void
+WorkQueue::budget_event(WorkItem *item, WorkItemBudget::Event event)
+{
+	const WorkItemBudget &budget = item->_budget;
+
+	if (event == WorkItemBudget::Event::Recovered) {
+		PX4_INFO("%s: %s back within its %" PRIu32 " us budget", _config.name, item->_item_name, budget.budget());
+		return;
+	}
+
+	PX4_WARN("%s: %s overran its %" PRIu32 " us budget (last %" PRIu32 " us, %" PRIu32 " overruns)",
+		 _config.name, item->_item_name, budget.budget(), budget.runtime_last(), budget.overrun_count());
+
+	switch (budget.policy()) {
+	case WorkItemBudget::Policy::Report:
+		break;
+
+	case WorkItemBudget::Policy::Skip:
+		PX4_WARN("%s: skipping every other run of %s", _config.name, item->_item_name);
+		break;
+	}
+}
+
 void
 WorkQueue::print_status(bool last)
 {
 	const size_t num_items = _work_items.size();
+#if defined(__PX4_POSIX) && !defined(__PX4_QURT)
+	// effective scheduling and CPU affinity of the thread
+	int policy = 0;
+	int priority = 0;
+	uint32_t cpus = 0;
+	char cpu_list[PX4_RT_CPU_LIST_LEN] {"?"};
+
+	if (px4_rt_get_affinity(_thread, &cpus) == 0) {
+		px4_rt_format_cpu_list(cpus, cpu_list, sizeof(cpu_list));
+	}
+
+	if (px4_rt_get_sched(_thread, &policy, &priority) == 0) {
+		PX4_INFO_RAW("%-16s %s %i, CPU %s\n", get_name(), px4_rt_policy_name(policy), priority, cpu_list);
+
+	} else {
+		PX4_INFO_RAW("%-16s\n", get_name());
+	}
+
+#else
 	PX4_INFO_RAW("%-16s\n", get_name());
+#endif
 	size_t i = 0;
 
 	for (WorkItem *item : _work_items) {
@@ -34,6 +34,7 @@
 #include <px4_platform_common/px4_work_queue/WorkQueueManager.hpp>
 
 #include <px4_platform_common/px4_work_queue/WorkQueue.hpp>
+#include <px4_platform_common/px4_work_queue/WorkItem.hpp>
 
 #include <drivers/drv_hrt.h>
 #include <px4_posix.h>
@@ -48,6 +49,11 @@
 #include <limits.h>
 #include <string.h>
 
+#if defined(__PX4_POSIX) && !defined(__PX4_QURT)
+#include <px4_rt_profile.h>
+#define WQ_RT_PROFILE
+#endif
+
 using namespace time_literals;
 
 namespace px4
@@ -61,6 +67,34 @@ static BlockingQueue<const wq_config_t *, 1> *_wq_manager_create_queue{nullptr};
 
 static px4::atomic_bool _wq_manager_should_exit{true};
 
+#if defined(WQ_RT_PROFILE)
+// CPU affinity by work queue name, applied by each work queue thread before it runs any work
+struct wq_affinity_t {
+	char name[24];
+	uint32_t cpus;
+};
+
+static wq_affinity_t _wq_affinity[16] {};
+static pthread_mutex_t _wq_affinity_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// with _wq_affinity_mutex held
+static void
+WorkQueueApplyAffinity(const char *name, pthread_t thread)
+{
+	for (const wq_affinity_t &affinity : _wq_affinity) {
+		if (strcmp(affinity.name, name) == 0) {
+			const int ret = px4_rt_set_affinity(thread, affinity.cpus);
+
+			if (ret != 0) {
+				PX4_ERR("setting CPU affinity of %s failed (%i)", name, ret);
+			}
+
+			return;
+		}
+	}
+}
+#endif // WQ_RT_PROFILE
+
 
 static WorkQueue *
 FindWorkQueueByName(const char *name)
@@ -164,8 +198,22 @@ WorkQueueRunner(void *context)
 	wq_config_t *config = static_cast<wq_config_t *>(context);
 	WorkQueue wq(*config);
 
+#if defined(WQ_RT_PROFILE)
+
+	if (px4_rt_memory_locked()) {
+		// fault in the stack now, not during the first runs of the work items
+		px4_rt_prefault_stack(PX4_STACK_ADJUSTED(config->stacksize) / 2);
+	}
+
+	pthread_mutex_lock(&_wq_affinity_mutex);
+	// add to work queue list
+	_wq_manager_wqs_list->add(&wq);
+	WorkQueueApplyAffinity(config->name, pthread_self());
+	pthread_mutex_unlock(&_wq_affinity_mutex);
+#else
 	// add to work queue list
 	_wq_manager_wqs_list->add(&wq);
+#endif // WQ_RT_PROFILE
 
 	wq.Run();
 
@@ -224,6 +272,16 @@ WorkQueueManagerRun(int, char **)
 
 #endif // ! QuRT
 
+#if defined(WQ_RT_PROFILE)
+			// otherwise the thread inherits the policy and priority of the manager task
+			int ret_setinheritsched = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+
+			if (ret_setinheritsched != 0) {
+				PX4_ERR("setting explicit scheduling for %s failed (%i)", wq->name, ret_setinheritsched);
+			}
+
+#endif // WQ_RT_PROFILE
+
 			// priority
 			param.sched_priority = sched_get_priority_max(SCHED_FIFO) + wq->relative_priority;
 			int ret_setschedparam = pthread_attr_setschedparam(&attr, &param);
@@ -236,6 +294,23 @@ WorkQueueManagerRun(int, char **)
 			pthread_t thread;
 			int ret_create = pthread_create(&thread, &attr, WorkQueueRunner, (void *)wq);
 
+#if defined(WQ_RT_PROFILE)
+
+			if (ret_create == EPERM) {
+				// real-time scheduling not permitted (e.g. not running as root)
+				static bool warned = false;
+
+				if (!warned) {
+					PX4_WARN("SCHED_FIFO not permitted, work queues inherit the scheduling policy");
+					warned = true;
+				}
+
+				pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+				ret_create = pthread_create(&thread, &attr, WorkQueueRunner, (void *)wq);
+			}
+
+#endif // WQ_RT_PROFILE
+
 			if (ret_create == 0) {
 				PX4_DEBUG("starting: %s, priority: %d, stack: %zu bytes", wq->name, param.sched_priority, stacksize);
 
@@ -340,6 +415,9 @@ WorkQueueManagerStatus()
 	if (!_wq_manager_should_exit.load() && (_wq_manager_wqs_list != nullptr)) {
 
 		const size_t num_wqs = _wq_manager_wqs_list->size();
+#if defined(WQ_RT_PROFILE)
+		PX4_INFO_RAW("\nMemory locked: %s\n", px4_rt_memory_locked() ? "yes" : "no");
+#endif // WQ_RT_PROFILE
 		PX4_INFO_RAW("\nWork Queue: %-1zu threads                      RATE        INTERVAL\n", num_wqs);
 
 		LockGuard lg{_wq_manager_wqs_list->mutex()};
@@ -367,4 +445,85 @@ WorkQueueManagerStatus()
 	return PX4_OK;
 }
 
+void
+WorkQueueManagerForEachItem(void (*func)(const char *wq_name, const WorkItem &item, void *arg), void *arg)
+{
+	if (!_wq_manager_should_exit.load() && (_wq_manager_wqs_list != nullptr)) {
+		LockGuard lg{_wq_manager_wqs_list->mutex()};
+
+		for (WorkQueue *wq : *_wq_manager_wqs_list) {
+			const char *wq_name = wq->get_name();
+			wq->for_each_item([&](const WorkItem & item) { func(wq_name, item, arg); });
+		}
+	}
+}
+
+int
+WorkQueueManagerSetAffinity(const char *name, uint32_t cpus)
+{
+#if defined(WQ_RT_PROFILE)
+	char wq_name[sizeof(wq_affinity_t::name)];
+	snprintf(wq_name, sizeof(wq_name), "%s%s", (strncmp(name, "wq:", 3) == 0) ? "" : "wq:", name);
+
+	pthread_mutex_lock(&_wq_affinity_mutex);
+
+	wq_affinity_t *entry = nullptr;
+
+	for (wq_affinity_t &affinity : _wq_affinity) {
+		if (strcmp(affinity.name, wq_name) == 0) {
+			entry = &affinity;
+			break;
+
+		} else if ((entry == nullptr) && (affinity.name[0] == '\0')) {
+			entry = &affinity;
+		}
+	}
+
+	if (entry == nullptr) {
+		pthread_mutex_unlock(&_wq_affinity_mutex);
+		PX4_ERR("too many work queues with CPU affinity");
+		return PX4_ERROR;
+	}
+
+	strncpy(entry->name, wq_name, sizeof(entry->name) - 1);
+	entry->cpus = cpus;
+
+	// apply to the running work queue thread, if any
+	if (_wq_manager_wqs_list != nullptr) {
+		LockGuard lg{_wq_manager_wqs_list->mutex()};
+
+		for (WorkQueue *wq : *_wq_manager_wqs_list) {
+			if (strcmp(wq->get_name(), wq_name) == 0) {
+				WorkQueueApplyAffinity(wq_name, wq->get_thread());
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&_wq_affinity_mutex);
+
+	return PX4_OK;
+#else
+	PX4_ERR("CPU affinity not supported");
+	return PX4_ERROR;
+#endif // WQ_RT_PROFILE
+}
+
+int
+WorkQueueManagerLockMemory(size_t heap_reserve)
+{
+#if defined(WQ_RT_PROFILE)
+	const int ret = px4_rt_lock_memory(heap_reserve);
+
+	if (ret != 0) {
+		PX4_ERR("locking memory failed (%i)", ret);
+		return PX4_ERROR;
+	}
+
+	return PX4_OK;
+#else
+	PX4_ERR("memory locking not supported");
+	return PX4_ERROR;
+#endif // WQ_RT_PROFILE
+}
+
 } // namespace px4
@@ -0,0 +1,98 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "wqueue_budget_test.h"
+
+#include <drivers/drv_hrt.h>
+#include <px4_log.h>
+#include <px4_time.h>
+
+#include <unistd.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+using namespace px4;
+
+AppState WQueueBudgetTest::appState;
+
+static constexpr uint32_t INTERVAL_US = 4000;
+static constexpr uint32_t BUDGET_US = 1000;
+
+void WQueueBudgetTest::Run()
+{
+	if (_iter > 500) {
+		appState.requestExit();
+	}
+
+	// injected overruns after the first 100 runs
+	if (_iter > 100) {
+		px4_usleep(2 * BUDGET_US);
+	}
+
+	_iter++;
+}
+
+int WQueueBudgetTest::main()
+{
+	appState.setRunning(true);
+
+	_iter = 0;
+
+	SetExecutionBudget(BUDGET_US, 0, WorkItemBudget::Policy::Report);
+
+	// Put work in the work queue
+	ScheduleOnInterval(INTERVAL_US);
+
+	// Wait for work to finsh
+	while (!appState.exitRequested()) {
+		px4_usleep(10000);
+	}
+
+	ScheduleClear();
+
+	print_run_status();
+
+	const WorkItemBudget &status = budget();
+
+	if (status.period() != INTERVAL_US || !status.chronic() || status.overrun_count() < 300) {
+		PX4_ERR("WQueueBudgetTest failed: %" PRIu32 " overruns, chronic: %d", status.overrun_count(), status.chronic());
+		return 1;
+	}
+
+	PX4_INFO("WQueueBudgetTest finished");
+
+	px4_sleep(2);
+
+	return 0;
+}
@@ -173,6 +173,13 @@ int main(int argc, char **argv)
 		argv[0] += path_length + strlen(prefix);
 
 		px4_daemon::Client client(instance);
+
+		if (strcmp(argv[0], "session") == 0) {
+			/* Run all commands from stdin over one connection. */
+			const bool concurrent = argc >= 2 && strcmp(argv[1], "-c") == 0;
+			return client.run_session(stdin, concurrent);
+		}
+
 		return client.process_args(argc, (const char **)argv);
 
 	} else {
@@ -293,6 +300,8 @@ int main(int argc, char **argv)
 			wait_to_exit();
 
 		} else {
+			// the shell mixes log messages with direct stdout output
+			px4_log_set_deferred(false);
 			px4_daemon::Pxh pxh;
 			pxh.run_pxh();
 		}
@@ -570,6 +579,11 @@ void print_usage()
 	printf("\n");
 	printf("    px4-MODULE [--instance <instance>] command using symlink.\n");
 	printf("        e.g.: px4-commander status\n");
+	printf("\n");
+	printf("    px4-session [--instance <instance>] [-c]\n");
+	printf("        run the commands from stdin (one per line) over one connection,\n");
+	printf("        -c allows the commands to run concurrently\n");
+	printf("        e.g.: px4-session < commands.txt\n");
 }
 
 bool is_already_running(int instance)
@@ -48,6 +48,7 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <map>
 #include <string>
 
 #include <px4_log.h>
@@ -62,7 +63,7 @@ Client::Client(int instance_id) :
 {}
 
 int
-Client::process_args(const int argc, const char **argv)
+Client::_connect()
 {
 	std::string sock_path = get_socket_path(_instance_id);
 
@@ -82,6 +83,16 @@ Client::process_args(const int argc, const char **argv)
 		return -1;
 	}
 
+	return 0;
+}
+
+int
+Client::process_args(const int argc, const char **argv)
+{
+	if (_connect() != 0) {
+		return -1;
+	}
+
 	int ret = _send_cmds(argc, argv);
 
 	if (ret != 0) {
@@ -93,41 +104,175 @@ Client::process_args(const int argc, const char **argv)
 }
 
 int
-Client::_send_cmds(const int argc, const char **argv)
+Client::run_session(FILE *commands, bool concurrent)
 {
-	std::string cmd_buf;
+	if (_connect() != 0) {
+		return -1;
+	}
 
-	for (int i = 0; i < argc; ++i) {
-		cmd_buf += argv[i];
+	if (_write(SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0) {
+		return -3;
+	}
 
-		if (i + 1 != argc) {
-			// TODO: Use '\0' as argument separator (and parse this server-side as well),
-			// so (quoted) whitespace within arguments doesn't get lost.
-			cmd_buf += " ";
+	const uint32_t flags = (isatty(STDOUT_FILENO) ? SESSION_FLAG_ISATTY : 0) | (concurrent ? SESSION_FLAG_CONCURRENT : 0);
+
+	struct Result {
+		int retval;
+		std::string output;
+	};
+
+	// Results that arrived before the ones of earlier commands.
+	std::map<uint32_t, Result> results;
+
+	uint32_t next_id = 0;
+	uint32_t next_output = 0;
+	int in_flight = 0;
+	bool end_of_commands = false;
+	int ret = 0;
+
+	while (true) {
+		// Keep the server busy with up to SESSION_WINDOW commands.
+		while (!end_of_commands && in_flight < SESSION_WINDOW) {
+			std::string command;
+
+			if (!_read_command(commands, command)) {
+				end_of_commands = true;
+				break;
+			}
+
+			session_request_s request{next_id++, flags, (uint32_t)command.size()};
+
+			if (_write(&request, sizeof(request)) != 0 || _write(command.data(), command.size()) != 0) {
+				return -3;
+			}
+
+			++in_flight;
+		}
+
+		if (in_flight == 0) {
+			break;
+		}
+
+		session_response_s response;
+		Result result;
+
+		if (_read(&response, sizeof(response)) != 0) {
+			return -1;
+		}
+
+		result.retval = response.retval;
+		result.output.resize(response.length);
+
+		if (response.length > 0 && _read(&result.output[0], response.length) != 0) {
+			return -1;
+		}
+
+		--in_flight;
+		results[response.id] = std::move(result);
+
+		// Output in the order of the commands.
+		for (auto it = results.find(next_output); it != results.end(); it = results.find(++next_output)) {
+			fwrite(it->second.output.data(), it->second.output.size(), 1, stdout);
+
+			if (ret == 0) {
+				ret = it->second.retval;
+			}
+
+			results.erase(it);
 		}
 	}
 
-	// Last byte is 'isatty'.
-	cmd_buf.push_back(isatty(STDOUT_FILENO));
+	fflush(stdout);
+	return ret;
+}
 
-	size_t n = cmd_buf.size();
-	const char *buf = cmd_buf.data();
+bool
+Client::_read_command(FILE *commands, std::string &command)
+{
+	char line[SESSION_MAX_COMMAND_LENGTH];
 
-	while (n > 0) {
-		int n_sent = write(_fd, buf, n);
+	while (fgets(line, sizeof(line), commands) != nullptr) {
+		command = line;
+
+		// Strip the line ending and leading whitespace, skip empty lines and comments.
+		while (!command.empty() && (command.back() == '\n' || command.back() == '\r')) {
+			command.pop_back();
+		}
+
+		size_t start = command.find_first_not_of(" \t");
+
+		if (start == std::string::npos || command[start] == '#') {
+			continue;
+		}
+
+		command.erase(0, start);
+		return true;
+	}
+
+	return false;
+}
+
+int
+Client::_write(const void *data, size_t length)
+{
+	const char *buf = (const char *)data;
+
+	while (length > 0) {
+		int n_sent = write(_fd, buf, length);
 
 		if (n_sent < 0) {
 			PX4_ERR("write() failed: %s", strerror(errno));
 			return -1;
 		}
 
-		n -= n_sent;
+		length -= n_sent;
 		buf += n_sent;
 	}
 
 	return 0;
 }
 
+int
+Client::_read(void *data, size_t length)
+{
+	char *buf = (char *)data;
+
+	while (length > 0) {
+		int n_read = read(_fd, buf, length);
+
+		if (n_read <= 0) {
+			PX4_ERR("unable to read from socket");
+			return -1;
+		}
+
+		length -= n_read;
+		buf += n_read;
+	}
+
+	return 0;
+}
+
+int
+Client::_send_cmds(const int argc, const char **argv)
+{
+	std::string cmd_buf;
+
+	for (int i = 0; i < argc; ++i) {
+		cmd_buf += argv[i];
+
+		if (i + 1 != argc) {
+			// TODO: Use '\0' as argument separator (and parse this server-side as well),
+			// so (quoted) whitespace within arguments doesn't get lost.
+			cmd_buf += " ";
+		}
+	}
+
+	// Last byte is 'isatty'.
+	cmd_buf.push_back(isatty(STDOUT_FILENO));
+
+	return _write(cmd_buf.data(), cmd_buf.size());
+}
+
 int
 Client::_listen()
 {
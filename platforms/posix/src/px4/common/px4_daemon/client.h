@@ -40,6 +40,9 @@
  * It the client dies, the connection gets closed automatically and the corresponding
  * thread in the server gets cancelled.
  *
+ * In session mode, the client sends all commands read from a stream over one connection
+ * and outputs the results in the order of the commands.
+ *
  * @author Julian Oes <julian@oes.ch>
  * @author Beat Küng <beat-kueng@gmx.net>
  * @author Mara Bos <m-ou.se@m-ou.se>
@@ -47,6 +50,8 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
+#include <string>
 
 #include "sock_protocol.h"
 
@@ -76,10 +81,26 @@ public:
 	 */
 	int process_args(const int argc, const char **argv);
 
+	/**
+	 * Run all commands of a stream (one per line) in a single session.
+	 *
+	 * @param commands: stream to read the commands from
+	 * @param concurrent: allow the server to run the commands concurrently
+	 * @return 0 if all commands succeeded, otherwise the return value of the first failing command
+	 */
+	int run_session(FILE *commands, bool concurrent);
+
 private:
+	static constexpr int SESSION_WINDOW = 16; ///< maximum number of commands in flight in a session
+
+	int _connect();
 	int _send_cmds(const int argc, const char **argv);
 	int _listen();
 
+	int _write(const void *data, size_t length);
+	int _read(void *data, size_t length);
+	static bool _read_command(FILE *commands, std::string &command);
+
 	int _fd;
 	int _instance_id; ///< instance ID for running multiple instances of the px4 server
 };
@@ -136,6 +136,10 @@ Server::_server_main()
 		return;
 	}
 
+	if (_session_pool.start(_key) != 0) {
+		PX4_ERR("failed to start session workers");
+	}
+
 	// The list of file descriptors to watch.
 	std::vector<pollfd> poll_fds;
 
@@ -248,6 +252,21 @@ void
 
 		cmd.resize(n + n_read);
 
+		// A session starts with the magic instead of a command.
+		if (cmd[0] == SESSION_MAGIC[0]) {
+			if (cmd.size() < sizeof(SESSION_MAGIC)) {
+				continue;
+			}
+
+			if (memcmp(cmd.data(), SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0) {
+				_cleanup(fd);
+				return nullptr;
+			}
+
+			_handle_session(fd, cmd.substr(sizeof(SESSION_MAGIC)));
+			return nullptr;
+		}
+
 		// Command ends in 0x00 (no tty) or 0x01 (tty).
 		if (!cmd.empty() && cmd.back() < 2) {
 			break;
@@ -291,6 +310,37 @@ void
 	return nullptr;
 }
 
+void
+Server::_handle_session(int fd, const std::string &buffered)
+{
+	// The session runs on its own descriptor of the socket, and is no longer cancelled by the main
+	// thread when the client hangs up: it has to wait for the commands it dispatched to the workers.
+	// The main thread still closes the original descriptor once it sees the hang up.
+	int session_fd = dup(fd);
+
+	_instance->_lock();
+	_instance->_fd_to_thread.erase(fd);
+	_instance->_unlock();
+
+	if (session_fd < 0) {
+		PX4_ERR("could not duplicate session socket");
+		shutdown(fd, SHUT_RDWR);
+		return;
+	}
+
+	{
+		Session session(session_fd, buffered);
+		session.run(_instance->_session_pool);
+
+		PX4_DEBUG("session closed after %u commands", (unsigned)session.commands());
+	}
+
+	// The session may also end on our side (read error, malformed request) while the client
+	// keeps the connection open: shut the socket down such that the main thread gets a
+	// 'POLLHUP' and closes the original descriptor, as in _cleanup().
+	shutdown(fd, SHUT_RDWR);
+}
+
 void
 Server::_cleanup(int fd)
 {
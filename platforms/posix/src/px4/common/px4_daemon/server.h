@@ -39,6 +39,9 @@
  * The server will return the stdout of the executing command, as well as the return
  * value to the client.
  *
+ * Alternatively, a client can open a session to send a stream of commands over the same
+ * connection, which are run by a pool of worker threads (see session.h).
+ *
  * There should only every be one server running, therefore the static instance.
  * The Singleton implementation is not complete, but it should be obvious not
  * to instantiate multiple servers.
@@ -55,6 +58,7 @@
 #include <pthread.h>
 #include <map>
 
+#include "session.h"
 #include "sock_protocol.h"
 
 
@@ -104,6 +108,7 @@ private:
 	}
 
 	static void *_handle_client(void *arg);
+	static void _handle_session(int fd, const std::string &buffered);
 	static void _cleanup(int fd);
 
 	pthread_t _server_main_pthread;
@@ -117,6 +122,8 @@ private:
 
 	int _fd;
 
+	SessionWorkerPool _session_pool;
+
 	static void _pthread_key_destructor(void *arg);
 
 	static Server *_instance;
@@ -0,0 +1,290 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file session.cpp
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include <px4_log.h>
+
+#include "pxh.h"
+#include "server.h"
+#include "session.h"
+
+namespace px4_daemon
+{
+
+SessionWorkerPool::SessionWorkerPool()
+	: _mutex(PTHREAD_MUTEX_INITIALIZER),
+	  _not_empty(PTHREAD_COND_INITIALIZER),
+	  _not_full(PTHREAD_COND_INITIALIZER)
+{
+}
+
+int
+SessionWorkerPool::start(pthread_key_t key)
+{
+	_key = key;
+
+	int started = 0;
+
+	for (int i = 0; i < NUM_WORKERS; ++i) {
+		pthread_t thread;
+
+		if (pthread_create(&thread, nullptr, _worker_trampoline, this) != 0) {
+			PX4_ERR("could not start session worker %i", i);
+			continue;
+		}
+
+		pthread_detach(thread);
+		++started;
+	}
+
+	return started > 0 ? 0 : -1;
+}
+
+void
+SessionWorkerPool::push(Job &&job)
+{
+	pthread_mutex_lock(&_mutex);
+
+	while (_queue.size() >= QUEUE_SIZE) {
+		pthread_cond_wait(&_not_full, &_mutex);
+	}
+
+	_queue.push_back(std::move(job));
+	pthread_cond_signal(&_not_empty);
+	pthread_mutex_unlock(&_mutex);
+}
+
+void *
+SessionWorkerPool::_worker_trampoline(void *arg)
+{
+	((SessionWorkerPool *)arg)->_worker();
+	return nullptr;
+}
+
+void
+SessionWorkerPool::_worker()
+{
+	// The thread specific data makes PX4_INFO (etc.) and printf of the commands go to the session.
+	Server::CmdThreadSpecificData *thread_data = new Server::CmdThreadSpecificData;
+	thread_data->thread_stdout = nullptr;
+	thread_data->is_atty = false;
+	(void)pthread_setspecific(_key, (void *)thread_data);
+
+	while (true) {
+		pthread_mutex_lock(&_mutex);
+
+		while (_queue.empty()) {
+			pthread_cond_wait(&_not_empty, &_mutex);
+		}
+
+		Job job = std::move(_queue.front());
+		_queue.pop_front();
+		pthread_cond_signal(&_not_full);
+		pthread_mutex_unlock(&_mutex);
+
+		// Collect the output in memory and send it together with the return value.
+		char *output = nullptr;
+		size_t output_length = 0;
+		FILE *out = open_memstream(&output, &output_length);
+
+		thread_data->thread_stdout = out;
+		thread_data->is_atty = job.flags & SESSION_FLAG_ISATTY;
+
+		int retval = Pxh::process_line(job.command, true);
+
+		thread_data->thread_stdout = nullptr;
+
+		if (out != nullptr) {
+			fclose(out);
+		}
+
+		job.session->complete(job.id, job.flags, retval, output, output_length);
+		free(output);
+	}
+}
+
+Session::Session(int fd, const std::string &buffered)
+	: _fd(fd),
+	  _buffered(buffered),
+	  _mutex(PTHREAD_MUTEX_INITIALIZER),
+	  _completed(PTHREAD_COND_INITIALIZER)
+{
+}
+
+Session::~Session()
+{
+	close(_fd);
+}
+
+void
+Session::run(SessionWorkerPool &pool)
+{
+	while (true) {
+		session_request_s request;
+
+		if (!_read(&request, sizeof(request))) {
+			break;
+		}
+
+		if (request.length > SESSION_MAX_COMMAND_LENGTH) {
+			PX4_ERR("session command too long (%u)", (unsigned)request.length);
+			break;
+		}
+
+		SessionWorkerPool::Job job{this, request.id, request.flags, std::string(request.length, '\0')};
+
+		if (request.length > 0 && !_read(&job.command[0], request.length)) {
+			break;
+		}
+
+		_wait_dispatch(request.flags);
+		pool.push(std::move(job));
+		++_commands;
+	}
+
+	// The jobs refer to this session, wait for them before it goes away.
+	pthread_mutex_lock(&_mutex);
+
+	while (_in_flight > 0) {
+		pthread_cond_wait(&_completed, &_mutex);
+	}
+
+	pthread_mutex_unlock(&_mutex);
+}
+
+void
+Session::complete(uint32_t id, uint32_t flags, int retval, const char *output, size_t length)
+{
+	session_response_s response{id, retval, (uint32_t)length};
+
+	pthread_mutex_lock(&_mutex);
+
+	// A client that went away does not stop the session, the remaining commands still have to complete.
+	if (!_write_failed) {
+		_write_failed = !_write(&response, sizeof(response)) || (length > 0 && !_write(output, length));
+	}
+
+	--_in_flight;
+
+	if (!(flags & SESSION_FLAG_CONCURRENT)) {
+		_sequential_in_flight = false;
+	}
+
+	pthread_cond_broadcast(&_completed);
+	pthread_mutex_unlock(&_mutex);
+}
+
+void
+Session::_wait_dispatch(uint32_t flags)
+{
+	const bool concurrent = flags & SESSION_FLAG_CONCURRENT;
+
+	pthread_mutex_lock(&_mutex);
+
+	// A sequential command waits for all commands before it, and all commands wait for a
+	// sequential one before them.
+	while (_sequential_in_flight || (!concurrent && _in_flight > 0)) {
+		pthread_cond_wait(&_completed, &_mutex);
+	}
+
+	++_in_flight;
+	_sequential_in_flight = !concurrent;
+
+	pthread_mutex_unlock(&_mutex);
+}
+
+bool
+Session::_read(void *data, size_t length)
+{
+	uint8_t *buf = (uint8_t *)data;
+
+	// Data that was received together with the magic comes first.
+	if (_buffered_pos < _buffered.size()) {
+		size_t n = std::min(length, _buffered.size() - _buffered_pos);
+		memcpy(buf, &_buffered[_buffered_pos], n);
+		_buffered_pos += n;
+		buf += n;
+		length -= n;
+	}
+
+	while (length > 0) {
+		ssize_t n_read = read(_fd, buf, length);
+
+		if (n_read < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (n_read <= 0) {
+			return false;
+		}
+
+		buf += n_read;
+		length -= n_read;
+	}
+
+	return true;
+}
+
+bool
+Session::_write(const void *data, size_t length)
+{
+	const uint8_t *buf = (const uint8_t *)data;
+
+	while (length > 0) {
+		ssize_t n_sent = write(_fd, buf, length);
+
+		if (n_sent < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (n_sent <= 0) {
+			return false;
+		}
+
+		buf += n_sent;
+		length -= n_sent;
+	}
+
+	return true;
+}
+
+} // namespace px4_daemon
@@ -0,0 +1,145 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file session.h
+ *
+ * Persistent command sessions of the server.
+ *
+ * A session is a single client connection carrying a stream of framed commands and results
+ * (see sock_protocol.h). The commands of all sessions are executed by a bounded pool of worker
+ * threads, which avoids a process, a connection and a thread per command.
+ *
+ * Within a session, commands run in order, unless they are flagged as concurrent, in which case
+ * they may run in parallel with other concurrent commands of the session.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <pthread.h>
+#include <deque>
+#include <string>
+
+#include "sock_protocol.h"
+
+namespace px4_daemon
+{
+
+class Session;
+
+class SessionWorkerPool
+{
+public:
+	static constexpr int NUM_WORKERS = 4;
+	static constexpr size_t QUEUE_SIZE = 32;
+
+	SessionWorkerPool();
+	~SessionWorkerPool() = default;
+
+	/**
+	 * Start the worker threads.
+	 *
+	 * @param key: pthread key of the thread specific data used for the stdout of commands
+	 * @return 0 if at least one worker was started
+	 */
+	int start(pthread_key_t key);
+
+	struct Job {
+		Session *session;
+		uint32_t id;
+		uint32_t flags;
+		std::string command;
+	};
+
+	/**
+	 * Queue a command, blocking while the queue is full.
+	 */
+	void push(Job &&job);
+
+private:
+	static void *_worker_trampoline(void *arg);
+	void _worker();
+
+	pthread_mutex_t _mutex;
+	pthread_cond_t _not_empty;
+	pthread_cond_t _not_full;
+	std::deque<Job> _queue;
+
+	pthread_key_t _key;
+};
+
+class Session
+{
+public:
+	/**
+	 * @param fd: socket of the session, owned (and closed) by the session
+	 * @param buffered: data already read from the socket after the magic
+	 */
+	Session(int fd, const std::string &buffered);
+	~Session();
+
+	/**
+	 * Read and dispatch commands until the client closes the connection or sends an invalid
+	 * request, then wait until all dispatched commands completed.
+	 */
+	void run(SessionWorkerPool &pool);
+
+	/**
+	 * Send the result of a command and mark it as completed. Called by the workers.
+	 */
+	void complete(uint32_t id, uint32_t flags, int retval, const char *output, size_t length);
+
+	uint32_t commands() const { return _commands; }
+
+private:
+	bool _read(void *data, size_t length);
+	bool _write(const void *data, size_t length);
+
+	/**
+	 * Wait until a command with the given flags can be dispatched and account for it.
+	 */
+	void _wait_dispatch(uint32_t flags);
+
+	int _fd;
+	std::string _buffered;
+	size_t _buffered_pos{0};
+
+	pthread_mutex_t _mutex; ///< Protects the dispatch state and serializes the responses.
+	pthread_cond_t _completed;
+	int _in_flight{0};
+	bool _sequential_in_flight{false};
+	bool _write_failed{false};
+
+	uint32_t _commands{0};
+};
+
+} // namespace px4_daemon
@@ -37,6 +37,7 @@
  */
 #pragma once
 
+#include <stdint.h>
 #include <string>
 
 namespace px4_daemon
@@ -44,5 +45,32 @@ namespace px4_daemon
 
 std::string get_socket_path(int instance_id);
 
+/*
+ * Session mode: instead of a single command, a client sends SESSION_MAGIC once after connecting,
+ * followed by any number of requests, each a session_request_s header and the command line.
+ * The server answers every request with a session_response_s header and the output of the command.
+ * Responses carry the id of the request, as concurrent commands can complete out of order.
+ *
+ * The first byte of the magic can never start a command line.
+ */
+static const char SESSION_MAGIC[4] = {0x02, 'P', 'X', 'S'};
+
+static constexpr uint32_t SESSION_FLAG_ISATTY = 1 << 0; ///< the client outputs to a terminal
+static constexpr uint32_t SESSION_FLAG_CONCURRENT = 1 << 1; ///< may run concurrently with other concurrent commands
+
+static constexpr uint32_t SESSION_MAX_COMMAND_LENGTH = 4096;
+
+struct session_request_s {
+	uint32_t id;
+	uint32_t flags;
+	uint32_t length; ///< length of the command line following the header
+};
+
+struct session_response_s {
+	uint32_t id;
+	int32_t retval;
+	uint32_t length; ///< length of the output following the header
+};
+
 } // namespace px4_daemon
 
@@ -0,0 +1,419 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the deferred logging
+ * Run this test only using make tests TESTFILTER=LogDeferred
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "px4_log_deferred.h"
+
+namespace
+{
+
+struct Message {
+	uint64_t timestamp;
+	int level;
+	std::string module;
+	std::string text;
+};
+
+std::mutex messages_mutex;
+std::vector<Message> messages;
+
+void collect(void *context, uint64_t timestamp, int level, const char *module, const char *text)
+{
+	std::lock_guard<std::mutex> lock(messages_mutex);
+	messages.push_back(Message{timestamp, level, module ? module : "(raw)", text});
+}
+
+void discard(void *context, uint64_t timestamp, int level, const char *module, const char *text)
+{
+}
+
+__attribute__((format(printf, 2, 3)))
+int logDeferred(uint64_t timestamp, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int ret = px4_log_deferred_write(timestamp, 2, "test", fmt, args);
+	va_end(args);
+	return ret;
+}
+
+__attribute__((format(printf, 2, 3)))
+int logRaw(uint64_t timestamp, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int ret = px4_log_deferred_write(timestamp, 1, nullptr, fmt, args);
+	va_end(args);
+	return ret;
+}
+
+__attribute__((format(printf, 1, 2)))
+std::string format(const char *fmt, ...)
+{
+	char text[PX4_LOG_DEFERRED_MAX_TEXT];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(text, sizeof(text), fmt, args);
+	va_end(args);
+	return text;
+}
+
+px4_log_deferred_stats_s stats()
+{
+	px4_log_deferred_stats_s stats;
+	px4_log_deferred_get_stats(&stats);
+	return stats;
+}
+
+} // namespace
+
+class LogDeferredTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		px4_log_deferred_drain(discard, nullptr, 1 << 30);
+		messages.clear();
+	}
+};
+
+TEST_F(LogDeferredTest, formatMatchesPrintf)
+{
+	const char *string = "abc";
+	const long long big = -1234567890123LL;
+	const size_t size = 4096;
+	void *pointer = &messages;
+
+	EXPECT_EQ(logDeferred(1, "plain"), PX4_LOG_DEFERRED_QUEUED);
+	EXPECT_EQ(logDeferred(2, "%d %i %u %x %X %o %c %%", -42, 17, 42u, 0xbeefu, 0xbeefu, 8u, 'z'),
+		  PX4_LOG_DEFERRED_QUEUED);
+	EXPECT_EQ(logDeferred(3, "%hhd %hd %ld %lu %lld %llx %zu %td", (signed char) - 3, (short)300, -70000L, 70000UL, big,
+			      0xdeadbeefcafeULL, size, (ptrdiff_t) - 5), PX4_LOG_DEFERRED_QUEUED);
+	EXPECT_EQ(logDeferred(4, "%.3f %8.2f %-8.1e| %g %lf %+.0f", 3.14159, -2.5, 12345.678, 1e-7, 0.5, 9.9),
+		  PX4_LOG_DEFERRED_QUEUED);
+	EXPECT_EQ(logDeferred(5, "[%s] [%10s] [%-5s|] [%.2s]", string, string, string, string), PX4_LOG_DEFERRED_QUEUED);
+	EXPECT_EQ(logDeferred(6, "%*d|%-*d|%.*f|%*.*s|%p", 6, 42, 4, 7, 2, 1.2345, 5, 2, "xyz", pointer),
+		  PX4_LOG_DEFERRED_QUEUED);
+
+	EXPECT_EQ(px4_log_deferred_drain(collect, nullptr, 100), 6);
+	ASSERT_EQ(messages.size(), 6u);
+
+	EXPECT_EQ(messages[0].text, "plain");
+	EXPECT_EQ(messages[1].text, format("%d %i %u %x %X %o %c %%", -42, 17, 42u, 0xbeefu, 0xbeefu, 8u, 'z'));
+	EXPECT_EQ(messages[2].text, format("%hhd %hd %ld %lu %lld %llx %zu %td", (signed char) - 3, (short)300, -70000L,
+					   70000UL, big, 0xdeadbeefcafeULL, size, (ptrdiff_t) - 5));
+	EXPECT_EQ(messages[3].text, format("%.3f %8.2f %-8.1e| %g %lf %+.0f", 3.14159, -2.5, 12345.678, 1e-7, 0.5, 9.9));
+	EXPECT_EQ(messages[4].text, "[abc] [       abc] [abc  |] [ab]");
+	EXPECT_EQ(messages[5].text, format("%*d|%-*d|%.*f|%*.*s|%p", 6, 42, 4, 7, 2, 1.2345, 5, 2, "xyz", pointer));
+
+	for (size_t i = 0; i < messages.size(); ++i) {
+		EXPECT_EQ(messages[i].timestamp, i + 1);
+		EXPECT_EQ(messages[i].level, 2);
+		EXPECT_EQ(messages[i].module, "test");
+	}
+}
+
+TEST_F(LogDeferredTest, stringArgumentsAreCopied)
+{
+	char buffer[32];
+	strcpy(buffer, "before");
+	EXPECT_EQ(logDeferred(1, "%s", buffer), PX4_LOG_DEFERRED_QUEUED);
+	strcpy(buffer, "after");
+
+	// strings longer than a record are truncated
+	std::string long_string(2 * PX4_LOG_DEFERRED_MAX_RECORD, 'x');
+	EXPECT_EQ(logDeferred(2, "%s", long_string.c_str()), PX4_LOG_DEFERRED_QUEUED);
+
+	EXPECT_EQ(px4_log_deferred_drain(collect, nullptr, 100), 2);
+	ASSERT_EQ(messages.size(), 2u);
+	EXPECT_EQ(messages[0].text, "before");
+	EXPECT_EQ(messages[1].text, std::string(PX4_LOG_DEFERRED_MAX_TEXT - 1, 'x'));
+}
+
+TEST_F(LogDeferredTest, unsupportedIsLoggedImmediately)
+{
+	const uint32_t sync = stats().sync;
+
+	EXPECT_EQ(logDeferred(1, "%Lf", 1.0L), PX4_LOG_DEFERRED_SYNC);
+	EXPECT_EQ(logDeferred(2, "%ls", L"wide"), PX4_LOG_DEFERRED_SYNC);
+	EXPECT_EQ(stats().sync, sync + 2);
+
+	px4_log_deferred_set_thread_enabled(false);
+	EXPECT_FALSE(px4_log_deferred_thread_enabled());
+	EXPECT_EQ(logDeferred(3, "disabled"), PX4_LOG_DEFERRED_SYNC);
+	px4_log_deferred_set_thread_enabled(true);
+	EXPECT_EQ(logDeferred(4, "enabled"), PX4_LOG_DEFERRED_QUEUED);
+
+	EXPECT_EQ(px4_log_deferred_drain(collect, nullptr, 100), 1);
+	ASSERT_EQ(messages.size(), 1u);
+	EXPECT_EQ(messages[0].text, "enabled");
+}
+
+TEST_F(LogDeferredTest, rawOutputKeepsTheOrder)
+{
+	// GIVEN: a message followed by raw output without module name
+	EXPECT_EQ(logDeferred(1, "message"), PX4_LOG_DEFERRED_QUEUED);
+	EXPECT_EQ(logRaw(2, "%-6s %4.1f\n", "raw", 1.5), PX4_LOG_DEFERRED_QUEUED);
+
+	// THEN: both reach the sink in order, the raw output as formatted and without module
+	EXPECT_EQ(px4_log_deferred_drain(collect, nullptr, 100), 2);
+	ASSERT_EQ(messages.size(), 2u);
+	EXPECT_EQ(messages[0].module, "test");
+	EXPECT_EQ(messages[1].module, "(raw)");
+	EXPECT_EQ(messages[1].text, "raw     1.5\n");
+}
+
+TEST_F(LogDeferredTest, pendingMessagesOfTheThread)
+{
+	// GIVEN: a message queued by another thread
+	std::thread other([] { logDeferred(1, "other"); });
+	other.join();
+
+	// THEN: this thread has nothing pending
+	EXPECT_FALSE(px4_log_deferred_thread_pending());
+
+	// WHEN: this thread queues a message
+	EXPECT_EQ(logDeferred(2, "own"), PX4_LOG_DEFERRED_QUEUED);
+
+	// THEN: it is pending until drained
+	EXPECT_TRUE(px4_log_deferred_thread_pending());
+	EXPECT_EQ(px4_log_deferred_drain(collect, nullptr, 100), 2);
+	EXPECT_FALSE(px4_log_deferred_thread_pending());
+}
+
+TEST_F(LogDeferredTest, fullRingDropsAndCounts)
+{
+	const px4_log_deferred_stats_s before = stats();
+
+	// each record is a header plus one argument, the ring is not drained while writing
+	int queued = 0;
+	int dropped = 0;
+
+	for (int i = 0; i < PX4_LOG_DEFERRED_RING_SIZE; ++i) {
+		const int ret = logDeferred(i, "message %d", i);
+
+		if (ret == PX4_LOG_DEFERRED_QUEUED) {
+			EXPECT_EQ(dropped, 0) << "messages must not be queued after the first drop";
+			++queued;
+
+		} else {
+			EXPECT_EQ(ret, PX4_LOG_DEFERRED_DROPPED);
+			++dropped;
+		}
+	}
+
+	EXPECT_GT(queued, 100);
+	EXPECT_GT(dropped, 0);
+
+	const px4_log_deferred_stats_s after = stats();
+	EXPECT_EQ(after.queued - before.queued, (uint32_t)queued);
+	EXPECT_EQ(after.dropped - before.dropped, (uint32_t)dropped);
+	EXPECT_LE(after.max_fill, (uint32_t)PX4_LOG_DEFERRED_RING_SIZE);
+	EXPECT_GT(after.max_fill, (uint32_t)PX4_LOG_DEFERRED_RING_SIZE - PX4_LOG_DEFERRED_MAX_RECORD);
+
+	// the queued ones are delivered in order, in chunks
+	EXPECT_EQ(px4_log_deferred_drain(collect, nullptr, 10), 10);
+	EXPECT_EQ(px4_log_deferred_drain(collect, nullptr, 1 << 30), queued - 10);
+	ASSERT_EQ(messages.size(), (size_t)queued);
+
+	for (int i = 0; i < queued; ++i) {
+		EXPECT_EQ(messages[i].text, "message " + std::to_string(i));
+	}
+
+	// and the ring accepts messages again
+	EXPECT_EQ(logDeferred(0, "again"), PX4_LOG_DEFERRED_QUEUED);
+	EXPECT_EQ(stats().processed - before.processed, (uint32_t)queued);
+}
+
+TEST_F(LogDeferredTest, burstMultiThread)
+{
+	// bursts of messages from several threads, drained concurrently
+	static constexpr int NUM_THREADS = 8;
+	static constexpr int NUM_BURSTS = 20;
+	static constexpr int BURST_SIZE = 100;
+
+	const px4_log_deferred_stats_s before = stats();
+	std::atomic<uint64_t> time{1};
+	std::atomic<bool> done{false};
+	int dropped[NUM_THREADS] {};
+
+	std::thread consumer([&done]() {
+		while (!done) {
+			px4_log_deferred_drain(collect, nullptr, 1 << 30);
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	});
+
+	std::vector<std::thread> producers;
+
+	for (int t = 0; t < NUM_THREADS; ++t) {
+		producers.emplace_back([t, &time, &dropped]() {
+			for (int burst = 0; burst < NUM_BURSTS; ++burst) {
+				for (int i = 0; i < BURST_SIZE; ++i) {
+					const int seq = burst * BURST_SIZE + i;
+
+					if (logDeferred(time++, "thread %d seq %d value %.2f name %s", t, seq, seq * 0.5,
+							"burst") != PX4_LOG_DEFERRED_QUEUED) {
+						++dropped[t];
+					}
+				}
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			}
+		});
+	}
+
+	for (std::thread &producer : producers) {
+		producer.join();
+	}
+
+	done = true;
+	consumer.join();
+	px4_log_deferred_drain(collect, nullptr, 1 << 30);
+
+	// every message is either delivered intact and in order per thread, or counted as dropped
+	int last_seq[NUM_THREADS];
+	int received[NUM_THREADS] {};
+
+	for (int t = 0; t < NUM_THREADS; ++t) {
+		last_seq[t] = -1;
+	}
+
+	for (const Message &message : messages) {
+		int t = -1;
+		int seq = -1;
+		ASSERT_EQ(sscanf(message.text.c_str(), "thread %d seq %d", &t, &seq), 2) << message.text;
+		ASSERT_GE(t, 0);
+		ASSERT_LT(t, NUM_THREADS);
+		EXPECT_GT(seq, last_seq[t]);
+		EXPECT_EQ(message.text, format("thread %d seq %d value %.2f name %s", t, seq, seq * 0.5, "burst"));
+		last_seq[t] = seq;
+		++received[t];
+	}
+
+	int total_dropped = 0;
+
+	for (int t = 0; t < NUM_THREADS; ++t) {
+		EXPECT_EQ(received[t] + dropped[t], NUM_BURSTS * BURST_SIZE);
+		total_dropped += dropped[t];
+	}
+
+	const px4_log_deferred_stats_s after = stats();
+	EXPECT_EQ(after.queued - before.queued, messages.size());
+	EXPECT_EQ(after.dropped - before.dropped, (uint32_t)total_dropped);
+	EXPECT_EQ(after.processed - before.processed, messages.size());
+
+	// a burst fits into a ring, so drops only happen if the consumer is stalled (e.g. on a loaded host)
+	printf("%zu messages delivered, %i dropped\n", messages.size(), total_dropped);
+}
+
+TEST_F(LogDeferredTest, ringsAreReusedAfterThreadExit)
+{
+	const uint16_t rings = stats().rings;
+
+	// many more short-lived threads than rings
+	for (int i = 0; i < 4 * PX4_LOG_DEFERRED_MAX_RINGS; ++i) {
+		std::thread thread([i]() {
+			EXPECT_EQ(logDeferred(i, "short-lived %d", i), PX4_LOG_DEFERRED_QUEUED);
+		});
+		thread.join();
+		px4_log_deferred_drain(collect, nullptr, 1 << 30);
+	}
+
+	ASSERT_EQ(messages.size(), 4u * PX4_LOG_DEFERRED_MAX_RINGS);
+	EXPECT_EQ(messages.back().text, "short-lived " + std::to_string(4 * PX4_LOG_DEFERRED_MAX_RINGS - 1));
+	EXPECT_LE(stats().rings, rings + 1);
+}
+
+TEST_F(LogDeferredTest, callSiteCost)
+{
+	// compare the cost for the calling thread with formatting and writing the message
+	static constexpr int NUM_MESSAGES = 100;
+	static constexpr int NUM_ROUNDS = 200;
+
+	FILE *null_file = fopen("/dev/null", "w");
+	ASSERT_NE(null_file, nullptr);
+
+	using clock = std::chrono::steady_clock;
+	clock::duration deferred_min = clock::duration::max();
+	clock::duration immediate_min = clock::duration::max();
+
+	for (int round = 0; round < NUM_ROUNDS; ++round) {
+		clock::time_point start = clock::now();
+
+		for (int i = 0; i < NUM_MESSAGES; ++i) {
+			logDeferred(i, "Attitude error %.3f %.3f %.3f rad, mode %s (%d)", i * 0.1, -0.25, 1.5, "manual", i);
+		}
+
+		deferred_min = std::min(deferred_min, clock::now() - start);
+
+		px4_log_deferred_drain(discard, nullptr, 1 << 30);
+
+		start = clock::now();
+
+		for (int i = 0; i < NUM_MESSAGES; ++i) {
+			char text[PX4_LOG_DEFERRED_MAX_TEXT];
+			snprintf(text, sizeof(text), "Attitude error %.3f %.3f %.3f rad, mode %s (%d)", i * 0.1, -0.25, 1.5, "manual",
+				 i);
+			fprintf(null_file, "%-5s [%s] %s\n", "WARN", "test", text);
+		}
+
+		fflush(null_file);
+		immediate_min = std::min(immediate_min, clock::now() - start);
+	}
+
+	fclose(null_file);
+
+	const double deferred_ns = std::chrono::duration<double, std::nano>(deferred_min).count() / NUM_MESSAGES;
+	const double immediate_ns = std::chrono::duration<double, std::nano>(immediate_min).count() / NUM_MESSAGES;
+	printf("call site cost: deferred %.0f ns, immediate %.0f ns (%.1fx)\n", deferred_ns, immediate_ns,
+	       immediate_ns / deferred_ns);
+
+	EXPECT_LT(deferred_ns, immediate_ns);
+}
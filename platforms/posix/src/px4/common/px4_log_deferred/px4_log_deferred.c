@@ -0,0 +1,652 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file px4_log_deferred.c
+ *
+ * Per-thread message rings and the deferred formatter.
+ *
+ * A record in the ring consists of a record_header followed by the arguments in the
+ * order of the format string: '*' width/precision arguments as int32_t, numbers and
+ * pointers as 8 byte arg_value and strings as uint16_t length followed by the characters.
+ */
+
+#include "px4_log_deferred.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONVERSION_MAX_LENGTH 24
+
+enum arg_kind {
+	ARG_NONE, ///< '%%'
+	ARG_INT,
+	ARG_LONG,
+	ARG_LLONG,
+	ARG_INTMAX,
+	ARG_SIZE,
+	ARG_PTRDIFF,
+	ARG_DOUBLE,
+	ARG_POINTER,
+	ARG_STRING
+};
+
+struct conversion {
+	enum arg_kind kind;
+	int num_stars; ///< number of '*' arguments preceding the value
+	int length; ///< length of the specification, including '%'
+};
+
+union arg_value {
+	int64_t i;
+	uint64_t u;
+	double d;
+	const void *p;
+};
+
+struct record_header {
+	uint64_t timestamp;
+	const char *module;
+	const char *fmt;
+	uint16_t size; ///< total size of the record, including the header [bytes]
+	uint8_t level;
+};
+
+struct log_ring {
+	uint32_t head; ///< write position, only written by the owning thread
+	uint32_t queued;
+	uint32_t dropped;
+	uint32_t max_fill;
+
+	uint32_t tail __attribute__((aligned(64))); ///< read position, only written by the formatter
+
+	bool in_use; ///< owned by a thread (protected by _rings_mutex)
+	bool released; ///< the owning thread exited, the ring can be reused once it is empty
+
+	uint8_t buffer[PX4_LOG_DEFERRED_RING_SIZE];
+};
+
+static struct log_ring *_rings[PX4_LOG_DEFERRED_MAX_RINGS];
+static uint32_t _num_rings = 0;
+static pthread_mutex_t _rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t _drain_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t _key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t _key;
+
+static uint32_t _sync = 0;
+static uint32_t _processed = 0;
+
+static __thread struct log_ring *_thread_ring = NULL;
+static __thread bool _thread_disabled = false;
+
+/**
+ * Parse a conversion specification
+ * @param p points to the '%'
+ * @return pointer past the specification, NULL if it is not supported
+ */
+static const char *parse_conversion(const char *p, struct conversion *conv)
+{
+	const char *start = p++;
+	enum arg_kind integer = ARG_INT;
+
+	conv->num_stars = 0;
+
+	if (*p == '%') {
+		conv->kind = ARG_NONE;
+		conv->length = 2;
+		return p + 1;
+	}
+
+	while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') { ++p; }
+
+	if (*p == '*') {
+		++conv->num_stars;
+		++p;
+
+	} else {
+		while (*p >= '0' && *p <= '9') { ++p; }
+	}
+
+	if (*p == '.') {
+		++p;
+
+		if (*p == '*') {
+			++conv->num_stars;
+			++p;
+
+		} else {
+			while (*p >= '0' && *p <= '9') { ++p; }
+		}
+	}
+
+	// length modifier
+	const char modifier = *p;
+
+	switch (modifier) {
+	case 'h':
+		++p;
+
+		if (*p == 'h') { ++p; }
+
+		break;
+
+	case 'l':
+		++p;
+		integer = ARG_LONG;
+
+		if (*p == 'l') {
+			++p;
+			integer = ARG_LLONG;
+		}
+
+		break;
+
+	case 'j':
+		++p;
+		integer = ARG_INTMAX;
+		break;
+
+	case 'z':
+		++p;
+		integer = ARG_SIZE;
+		break;
+
+	case 't':
+		++p;
+		integer = ARG_PTRDIFF;
+		break;
+
+	default:
+		break;
+	}
+
+	switch (*p) {
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		conv->kind = integer;
+		break;
+
+	case 'f':
+	case 'F':
+	case 'e':
+	case 'E':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		conv->kind = ARG_DOUBLE;
+
+		if (integer != ARG_INT && integer != ARG_LONG) {
+			return NULL;
+		}
+
+		break;
+
+	case 'c':
+		conv->kind = ARG_INT;
+
+		if (integer != ARG_INT) { // wint_t
+			return NULL;
+		}
+
+		break;
+
+	case 's':
+		conv->kind = ARG_STRING;
+
+		if (integer != ARG_INT || modifier == 'h') { // wide strings
+			return NULL;
+		}
+
+		break;
+
+	case 'p':
+		conv->kind = ARG_POINTER;
+
+		if (integer != ARG_INT || modifier == 'h') {
+			return NULL;
+		}
+
+		break;
+
+	default:
+		// long double, %n and invalid specifications
+		return NULL;
+	}
+
+	++p;
+	conv->length = p - start;
+
+	if (conv->length >= CONVERSION_MAX_LENGTH) {
+		return NULL;
+	}
+
+	return p;
+}
+
+static void release_ring(void *ring)
+{
+	// log immediately from the remaining thread exit code, the ring might get reused
+	_thread_ring = NULL;
+	_thread_disabled = true;
+	__atomic_store_n(&((struct log_ring *)ring)->released, true, __ATOMIC_RELEASE);
+}
+
+static void create_key(void)
+{
+	pthread_key_create(&_key, release_ring);
+}
+
+static struct log_ring *acquire_ring(void)
+{
+	pthread_once(&_key_once, create_key);
+	pthread_mutex_lock(&_rings_mutex);
+
+	struct log_ring *ring = NULL;
+
+	for (uint32_t i = 0; i < _num_rings; ++i) {
+		if (!_rings[i]->in_use) {
+			ring = _rings[i];
+			break;
+		}
+	}
+
+	if (!ring && _num_rings < PX4_LOG_DEFERRED_MAX_RINGS) {
+		ring = (struct log_ring *)calloc(1, sizeof(struct log_ring));
+
+		if (ring) {
+			_rings[_num_rings] = ring;
+			__atomic_store_n(&_num_rings, _num_rings + 1, __ATOMIC_RELEASE);
+		}
+	}
+
+	if (ring) {
+		ring->in_use = true;
+		_thread_ring = ring;
+		pthread_setspecific(_key, ring);
+	}
+
+	pthread_mutex_unlock(&_rings_mutex);
+	return ring;
+}
+
+static void ring_write(struct log_ring *ring, uint32_t pos, const void *data, uint32_t size)
+{
+	const uint32_t offset = pos & (PX4_LOG_DEFERRED_RING_SIZE - 1);
+	const uint32_t first = PX4_LOG_DEFERRED_RING_SIZE - offset;
+
+	if (size <= first) {
+		memcpy(ring->buffer + offset, data, size);
+
+	} else {
+		memcpy(ring->buffer + offset, data, first);
+		memcpy(ring->buffer, (const uint8_t *)data + first, size - first);
+	}
+}
+
+static void ring_read(const struct log_ring *ring, uint32_t pos, void *data, uint32_t size)
+{
+	const uint32_t offset = pos & (PX4_LOG_DEFERRED_RING_SIZE - 1);
+	const uint32_t first = PX4_LOG_DEFERRED_RING_SIZE - offset;
+
+	if (size <= first) {
+		memcpy(data, ring->buffer + offset, size);
+
+	} else {
+		memcpy(data, ring->buffer + offset, first);
+		memcpy((uint8_t *)data + first, ring->buffer, size - first);
+	}
+}
+
+int px4_log_deferred_write(uint64_t timestamp, int level, const char *module, const char *fmt, va_list args)
+{
+	if (_thread_disabled) {
+		return PX4_LOG_DEFERRED_SYNC;
+	}
+
+	struct log_ring *ring = _thread_ring;
+
+	if (!ring) {
+		ring = acquire_ring();
+
+		if (!ring) {
+			__atomic_fetch_add(&_sync, 1, __ATOMIC_RELAXED);
+			return PX4_LOG_DEFERRED_SYNC;
+		}
+	}
+
+	// serialize the arguments
+	uint8_t record[PX4_LOG_DEFERRED_MAX_RECORD];
+	uint32_t size = sizeof(struct record_header);
+	bool supported = true;
+
+	va_list ap;
+	va_copy(ap, args);
+
+	for (const char *p = strchr(fmt, '%'); p && supported; p = strchr(p, '%')) {
+		struct conversion conv;
+		p = parse_conversion(p, &conv);
+
+		if (!p || size + conv.num_stars * sizeof(int32_t) + sizeof(union arg_value) > sizeof(record)) {
+			supported = false;
+			break;
+		}
+
+		for (int i = 0; i < conv.num_stars; ++i) {
+			const int32_t star = va_arg(ap, int);
+			memcpy(record + size, &star, sizeof(star));
+			size += sizeof(star);
+		}
+
+		union arg_value value;
+		value.u = 0;
+
+		switch (conv.kind) {
+		case ARG_NONE:
+			continue;
+
+		case ARG_INT: value.i = va_arg(ap, int); break;
+
+		case ARG_LONG: value.i = va_arg(ap, long); break;
+
+		case ARG_LLONG: value.i = va_arg(ap, long long); break;
+
+		case ARG_INTMAX: value.i = va_arg(ap, intmax_t); break;
+
+		case ARG_SIZE: value.u = va_arg(ap, size_t); break;
+
+		case ARG_PTRDIFF: value.i = va_arg(ap, ptrdiff_t); break;
+
+		case ARG_DOUBLE: value.d = va_arg(ap, double); break;
+
+		case ARG_POINTER: value.p = va_arg(ap, void *); break;
+
+		case ARG_STRING: {
+				const char *string = va_arg(ap, const char *);
+
+				if (!string) {
+					string = "(null)";
+				}
+
+				// truncate long strings to the space left in the record
+				const size_t max_length = sizeof(record) - size - sizeof(uint16_t);
+				const uint16_t length = strnlen(string, max_length);
+				memcpy(record + size, &length, sizeof(length));
+				memcpy(record + size + sizeof(length), string, length);
+				size += sizeof(length) + length;
+				continue;
+			}
+		}
+
+		memcpy(record + size, &value, sizeof(value));
+		size += sizeof(value);
+	}
+
+	va_end(ap);
+
+	if (!supported) {
+		__atomic_fetch_add(&_sync, 1, __ATOMIC_RELAXED);
+		return PX4_LOG_DEFERRED_SYNC;
+	}
+
+	struct record_header header;
+	memset(&header, 0, sizeof(header));
+	header.timestamp = timestamp;
+	header.module = module;
+	header.fmt = fmt;
+	header.size = size;
+	header.level = level;
+	memcpy(record, &header, sizeof(header));
+
+	const uint32_t head = ring->head;
+	const uint32_t fill = head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+	if (PX4_LOG_DEFERRED_RING_SIZE - fill < size) {
+		__atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+		return PX4_LOG_DEFERRED_DROPPED;
+	}
+
+	ring_write(ring, head, record, size);
+	__atomic_store_n(&ring->head, head + size, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&ring->queued, ring->queued + 1, __ATOMIC_RELAXED);
+
+	if (fill + size > ring->max_fill) {
+		__atomic_store_n(&ring->max_fill, fill + size, __ATOMIC_RELAXED);
+	}
+
+	return PX4_LOG_DEFERRED_QUEUED;
+}
+
+#define FORMAT_VALUE(value) \
+	(conv->num_stars == 0 ? snprintf(buf, size, spec, value) : \
+	 conv->num_stars == 1 ? snprintf(buf, size, spec, stars[0], value) : \
+	 snprintf(buf, size, spec, stars[0], stars[1], value))
+
+static int format_conversion(char *buf, size_t size, const char *spec, const struct conversion *conv,
+			     const int32_t *stars, union arg_value value, const char *string)
+{
+	switch (conv->kind) {
+	case ARG_NONE: return snprintf(buf, size, "%%");
+
+	case ARG_INT: return FORMAT_VALUE((int)value.i);
+
+	case ARG_LONG: return FORMAT_VALUE((long)value.i);
+
+	case ARG_LLONG: return FORMAT_VALUE((long long)value.i);
+
+	case ARG_INTMAX: return FORMAT_VALUE((intmax_t)value.i);
+
+	case ARG_SIZE: return FORMAT_VALUE((size_t)value.u);
+
+	case ARG_PTRDIFF: return FORMAT_VALUE((ptrdiff_t)value.i);
+
+	case ARG_DOUBLE: return FORMAT_VALUE(value.d);
+
+	case ARG_POINTER: return FORMAT_VALUE(value.p);
+
+	case ARG_STRING: return FORMAT_VALUE(string);
+	}
+
+	return 0;
+}
+
+/**
+ * Format a record from the ring into text
+ */
+static void format_record(const uint8_t *record, char *text)
+{
+	struct record_header header;
+	memcpy(&header, record, sizeof(header));
+
+	const size_t text_size = PX4_LOG_DEFERRED_MAX_TEXT;
+	uint32_t pos = sizeof(struct record_header);
+	size_t length = 0;
+	const char *p = header.fmt;
+
+	text[0] = '\0';
+
+	while (*p && length < text_size - 1) {
+		const char *next = strchr(p, '%');
+		const size_t literal = next ? (size_t)(next - p) : strlen(p);
+		const size_t copy = literal < text_size - 1 - length ? literal : text_size - 1 - length;
+		memcpy(text + length, p, copy);
+		length += copy;
+		text[length] = '\0';
+
+		if (!next) {
+			break;
+		}
+
+		struct conversion conv;
+		p = parse_conversion(next, &conv);
+
+		char spec[CONVERSION_MAX_LENGTH];
+		memcpy(spec, next, conv.length);
+		spec[conv.length] = '\0';
+
+		int32_t stars[2] = {0, 0};
+
+		for (int i = 0; i < conv.num_stars; ++i) {
+			memcpy(&stars[i], record + pos, sizeof(int32_t));
+			pos += sizeof(int32_t);
+		}
+
+		union arg_value value;
+		value.u = 0;
+		char string[PX4_LOG_DEFERRED_MAX_RECORD];
+		string[0] = '\0';
+
+		if (conv.kind == ARG_STRING) {
+			uint16_t string_length;
+			memcpy(&string_length, record + pos, sizeof(string_length));
+			memcpy(string, record + pos + sizeof(string_length), string_length);
+			string[string_length] = '\0';
+			pos += sizeof(string_length) + string_length;
+
+		} else if (conv.kind != ARG_NONE) {
+			memcpy(&value, record + pos, sizeof(value));
+			pos += sizeof(value);
+		}
+
+		const int ret = format_conversion(text + length, text_size - length, spec, &conv, stars, value, string);
+
+		if (ret > 0) {
+			length += (size_t)ret < text_size - length ? (size_t)ret : text_size - 1 - length;
+		}
+	}
+}
+
+int px4_log_deferred_drain(px4_log_deferred_sink_t sink, void *context, int max_messages)
+{
+	pthread_mutex_lock(&_drain_mutex);
+
+	int processed = 0;
+
+	while (processed < max_messages) {
+		// find the ring with the oldest pending message
+		struct log_ring *oldest = NULL;
+		struct record_header oldest_header;
+		const uint32_t num_rings = __atomic_load_n(&_num_rings, __ATOMIC_ACQUIRE);
+
+		for (uint32_t i = 0; i < num_rings; ++i) {
+			struct log_ring *ring = _rings[i];
+			const bool released = __atomic_load_n(&ring->released, __ATOMIC_ACQUIRE);
+			const uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+			if (head == ring->tail) {
+				if (released) {
+					pthread_mutex_lock(&_rings_mutex);
+					ring->released = false;
+					ring->in_use = false;
+					pthread_mutex_unlock(&_rings_mutex);
+				}
+
+				continue;
+			}
+
+			struct record_header header;
+			ring_read(ring, ring->tail, &header, sizeof(header));
+
+			if (!oldest || header.timestamp < oldest_header.timestamp) {
+				oldest = ring;
+				oldest_header = header;
+			}
+		}
+
+		if (!oldest) {
+			break;
+		}
+
+		uint8_t record[PX4_LOG_DEFERRED_MAX_RECORD];
+		ring_read(oldest, oldest->tail, record, oldest_header.size);
+		__atomic_store_n(&oldest->tail, oldest->tail + oldest_header.size, __ATOMIC_RELEASE);
+
+		char text[PX4_LOG_DEFERRED_MAX_TEXT];
+		format_record(record, text);
+		sink(context, oldest_header.timestamp, oldest_header.level, oldest_header.module, text);
+		++processed;
+	}
+
+	__atomic_store_n(&_processed, _processed + processed, __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock(&_drain_mutex);
+
+	return processed;
+}
+
+void px4_log_deferred_set_thread_enabled(bool enabled)
+{
+	_thread_disabled = !enabled;
+}
+
+bool px4_log_deferred_thread_enabled(void)
+{
+	return !_thread_disabled;
+}
+
+bool px4_log_deferred_thread_pending(void)
+{
+	const struct log_ring *ring = _thread_ring;
+
+	return ring && __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) != ring->head;
+}
+
+void px4_log_deferred_get_stats(struct px4_log_deferred_stats_s *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	const uint32_t num_rings = __atomic_load_n(&_num_rings, __ATOMIC_ACQUIRE);
+
+	for (uint32_t i = 0; i < num_rings; ++i) {
+		const struct log_ring *ring = _rings[i];
+		stats->queued += __atomic_load_n(&ring->queued, __ATOMIC_RELAXED);
+		stats->dropped += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+		const uint32_t max_fill = __atomic_load_n(&ring->max_fill, __ATOMIC_RELAXED);
+
+		if (max_fill > stats->max_fill) {
+			stats->max_fill = max_fill;
+		}
+	}
+
+	stats->sync = __atomic_load_n(&_sync, __ATOMIC_RELAXED);
+	stats->processed = __atomic_load_n(&_processed, __ATOMIC_RELAXED);
+	stats->rings = num_rings;
+}
@@ -0,0 +1,114 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file px4_log_deferred.h
+ *
+ * Deferred formatting of log messages.
+ *
+ * Instead of formatting a message on the calling thread, the caller stores the pointer
+ * to the format string (which serves as format id), the module name and the raw
+ * arguments into a lock-free single-producer single-consumer ring owned by the thread.
+ * A low-priority thread later drains all rings in timestamp order, formats the messages
+ * and passes them to a sink (console output and uORB publication).
+ *
+ * Format strings and module names must be string literals (or otherwise outlive the
+ * message), which is the case for all PX4_INFO/PX4_WARN/PX4_ERR call sites.
+ * String arguments are copied into the ring.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+#define PX4_LOG_DEFERRED_RING_SIZE 8192 ///< per-thread ring size [bytes], must be a power of 2
+#define PX4_LOG_DEFERRED_MAX_RINGS 64 ///< maximum number of threads with a ring at the same time
+#define PX4_LOG_DEFERRED_MAX_RECORD 512 ///< maximum size of a single message in the ring [bytes]
+#define PX4_LOG_DEFERRED_MAX_TEXT 256 ///< maximum length of a formatted message, including 0-termination
+
+#define PX4_LOG_DEFERRED_QUEUED 0 ///< the message was stored and will be passed to the sink
+#define PX4_LOG_DEFERRED_DROPPED 1 ///< the ring of the thread was full and the message was dropped
+#define PX4_LOG_DEFERRED_SYNC -1 ///< the message cannot be deferred and must be logged immediately
+
+__BEGIN_DECLS
+
+/**
+ * Called from the draining thread for each message, in timestamp order per thread
+ * @param text formatted message, without module name and newline
+ */
+typedef void (*px4_log_deferred_sink_t)(void *context, uint64_t timestamp, int level, const char *module,
+					const char *text);
+
+struct px4_log_deferred_stats_s {
+	uint32_t queued; ///< messages stored into a ring
+	uint32_t dropped; ///< messages dropped because the ring of the thread was full
+	uint32_t sync; ///< messages that had to be logged immediately (unsupported format, no ring left)
+	uint32_t processed; ///< messages passed to the sink
+	uint32_t max_fill; ///< highest fill level of any ring [bytes]
+	uint16_t rings; ///< number of allocated rings
+};
+
+/**
+ * Store a message into the ring of the calling thread. Lock-free except for the first
+ * call of a thread, which allocates the ring.
+ * module may be NULL (e.g. for raw output), it is passed to the sink as is.
+ * @return PX4_LOG_DEFERRED_QUEUED, PX4_LOG_DEFERRED_DROPPED or PX4_LOG_DEFERRED_SYNC
+ */
+__EXPORT int px4_log_deferred_write(uint64_t timestamp, int level, const char *module, const char *fmt,
+				    va_list args);
+
+/**
+ * Format and pass up to max_messages pending messages to the sink, oldest first.
+ * Can be called from any thread, calls are serialized.
+ * @return number of processed messages
+ */
+__EXPORT int px4_log_deferred_drain(px4_log_deferred_sink_t sink, void *context, int max_messages);
+
+/**
+ * Select whether messages of the calling thread may be deferred (enabled by default).
+ * If disabled, px4_log_deferred_write() returns PX4_LOG_DEFERRED_SYNC.
+ */
+__EXPORT void px4_log_deferred_set_thread_enabled(bool enabled);
+__EXPORT bool px4_log_deferred_thread_enabled(void);
+
+/**
+ * @return true if messages of the calling thread have not been passed to the sink yet
+ */
+__EXPORT bool px4_log_deferred_thread_pending(void);
+
+__EXPORT void px4_log_deferred_get_stats(struct px4_log_deferred_stats_s *stats);
+
+__END_DECLS
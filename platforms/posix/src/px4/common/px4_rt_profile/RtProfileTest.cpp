@@ -0,0 +1,426 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the POSIX real-time profile helpers
+ * Run this test only using make tests TESTFILTER=RtProfile
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "px4_rt_profile.h"
+
+namespace
+{
+
+uint32_t processCpus()
+{
+	uint32_t mask = 0;
+
+	if (px4_rt_get_affinity(pthread_self(), &mask) != 0 || mask == 0) {
+		mask = px4_rt_online_cpus();
+	}
+
+	return mask;
+}
+
+uint64_t nowUs()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+struct JitterResult {
+	bool realtime{false};
+	uint64_t p50{0};
+	uint64_t p99{0};
+	uint64_t max{0};
+};
+
+struct JitterConfig {
+	bool realtime{false}; ///< SCHED_FIFO, pinned, stack pre-faulted
+	uint32_t cpus{0};
+	int cycles{1000};
+	uint64_t period_us{1000};
+	JitterResult result;
+};
+
+/** periodic absolute wake-ups, lateness of each wake-up */
+void *jitterThread(void *arg)
+{
+	JitterConfig &config = *static_cast<JitterConfig *>(arg);
+
+	if (config.realtime) {
+		px4_rt_prefault_stack(64 * 1024);
+	}
+
+	std::vector<uint64_t> lateness;
+	lateness.reserve(config.cycles);
+
+	timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	for (int i = 0; i < config.cycles; i++) {
+		next.tv_nsec += config.period_us * 1000;
+
+		if (next.tv_nsec >= 1000000000) {
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) == EINTR) {}
+
+		const uint64_t deadline = (uint64_t)next.tv_sec * 1000000 + next.tv_nsec / 1000;
+		const uint64_t now = nowUs();
+		lateness.push_back(now > deadline ? now - deadline : 0);
+	}
+
+	std::sort(lateness.begin(), lateness.end());
+	config.result.p50 = lateness[lateness.size() / 2];
+	config.result.p99 = lateness[lateness.size() * 99 / 100];
+	config.result.max = lateness.back();
+	return nullptr;
+}
+
+/** run the jitter thread, @return false if it could not be started with the requested profile */
+bool measureJitter(JitterConfig &config)
+{
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, 256 * 1024);
+
+	if (config.realtime) {
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		sched_param param{};
+		param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+		pthread_attr_setschedparam(&attr, &param);
+		px4_rt_attr_set_affinity(&attr, config.cpus);
+	}
+
+	pthread_t thread;
+	const int ret = pthread_create(&thread, &attr, jitterThread, &config);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		return false;
+	}
+
+	pthread_join(thread, nullptr);
+	config.result.realtime = config.realtime;
+	return true;
+}
+
+} // namespace
+
+TEST(RtProfileTest, parseCpuList)
+{
+	uint32_t mask = 0;
+	EXPECT_EQ(px4_rt_parse_cpu_list("3", &mask), 0);
+	EXPECT_EQ(mask, 0x8u);
+	EXPECT_EQ(px4_rt_parse_cpu_list("0,2", &mask), 0);
+	EXPECT_EQ(mask, 0x5u);
+	EXPECT_EQ(px4_rt_parse_cpu_list("1-3", &mask), 0);
+	EXPECT_EQ(mask, 0xeu);
+	EXPECT_EQ(px4_rt_parse_cpu_list("0,2-3,5", &mask), 0);
+	EXPECT_EQ(mask, 0x2du);
+	EXPECT_EQ(px4_rt_parse_cpu_list("31", &mask), 0);
+	EXPECT_EQ(mask, 0x80000000u);
+
+	mask = 0x1234;
+	const char *invalid[] = {"", "a", "3-1", "1,", "32", "-1", "1-", "1 2", "0-32", ",1"};
+
+	for (const char *list : invalid) {
+		EXPECT_EQ(px4_rt_parse_cpu_list(list, &mask), -EINVAL) << list;
+	}
+
+	// unchanged on error
+	EXPECT_EQ(mask, 0x1234u);
+}
+
+TEST(RtProfileTest, formatCpuList)
+{
+	char buf[PX4_RT_CPU_LIST_LEN];
+
+	px4_rt_format_cpu_list(0x2d, buf, sizeof(buf));
+	EXPECT_STREQ(buf, "0,2-3,5");
+	px4_rt_format_cpu_list(0, buf, sizeof(buf));
+	EXPECT_STREQ(buf, "none");
+	px4_rt_format_cpu_list(0xffffffff, buf, sizeof(buf));
+	EXPECT_STREQ(buf, "0-31");
+	px4_rt_format_cpu_list(0x55555555, buf, sizeof(buf));
+	EXPECT_STREQ(buf, "0,2,4,6,8,10,12,14,16,18,20,22,24,26,28,30");
+
+	// round trip
+	uint32_t mask = 0;
+	px4_rt_format_cpu_list(0x8000f0f1, buf, sizeof(buf));
+	EXPECT_EQ(px4_rt_parse_cpu_list(buf, &mask), 0);
+	EXPECT_EQ(mask, 0x8000f0f1u);
+}
+
+TEST(RtProfileTest, appliedAffinity)
+{
+	const uint32_t cpus = processCpus();
+
+	for (int cpu = 0; cpu < PX4_RT_MAX_CPUS; cpu++) {
+		if ((cpus & (1u << cpu)) == 0) {
+			continue;
+		}
+
+		// pinned at creation, the thread never runs on another CPU
+		struct Pinned {
+			std::atomic<uint32_t> seen{0};
+			static void *run(void *arg)
+			{
+				Pinned *self = static_cast<Pinned *>(arg);
+
+				for (int i = 0; i < 1000; i++) {
+					self->seen |= 1u << sched_getcpu();
+
+					if (i % 100 == 0) {
+						sched_yield();
+					}
+				}
+
+				return nullptr;
+			}
+		} pinned;
+
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		ASSERT_EQ(px4_rt_attr_set_affinity(&attr, 1u << cpu), 0);
+
+		pthread_t thread;
+		ASSERT_EQ(pthread_create(&thread, &attr, Pinned::run, &pinned), 0);
+		pthread_attr_destroy(&attr);
+
+		uint32_t applied = 0;
+		EXPECT_EQ(px4_rt_get_affinity(thread, &applied), 0);
+		EXPECT_EQ(applied, 1u << cpu);
+
+		pthread_join(thread, nullptr);
+		EXPECT_EQ(pinned.seen.load(), 1u << cpu);
+	}
+
+	// re-pinning a running thread, 0 resets to all online CPUs
+	std::atomic<bool> stop{false};
+	std::thread worker([&stop]() { while (!stop) { std::this_thread::yield(); } });
+
+	const uint32_t first = cpus & (~cpus + 1);
+	EXPECT_EQ(px4_rt_set_affinity(worker.native_handle(), first), 0);
+	uint32_t applied = 0;
+	EXPECT_EQ(px4_rt_get_affinity(worker.native_handle(), &applied), 0);
+	EXPECT_EQ(applied, first);
+
+	EXPECT_EQ(px4_rt_set_affinity(worker.native_handle(), 0), 0);
+	EXPECT_EQ(px4_rt_get_affinity(worker.native_handle(), &applied), 0);
+	EXPECT_EQ(applied, px4_rt_online_cpus() & applied);
+	EXPECT_NE(applied, 0u);
+
+	stop = true;
+	worker.join();
+}
+
+TEST(RtProfileTest, effectiveSchedulingPolicy)
+{
+	int policy = -1;
+	int priority = -1;
+	ASSERT_EQ(px4_rt_get_sched(pthread_self(), &policy, &priority), 0);
+	EXPECT_STRNE(px4_rt_policy_name(policy), "?");
+
+	// threads inherit the scheduling of the creator unless it is explicit
+	struct Sched {
+		int policy{-1};
+		static void *run(void *arg)
+		{
+			int priority;
+			px4_rt_get_sched(pthread_self(), &static_cast<Sched *>(arg)->policy, &priority);
+			return nullptr;
+		}
+	} sched;
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setschedpolicy(&attr, policy == SCHED_FIFO ? SCHED_RR : SCHED_FIFO);
+
+	pthread_t thread;
+
+	if (pthread_create(&thread, &attr, Sched::run, &sched) == 0) {
+		pthread_join(thread, nullptr);
+		EXPECT_EQ(sched.policy, policy);
+	}
+
+	pthread_attr_destroy(&attr);
+}
+
+TEST(RtProfileTest, prefaultedStackDoesNotFault)
+{
+	struct Faults {
+		bool prefault{false};
+		uint64_t minor{0};
+
+		static __attribute__((noinline)) void useStack(size_t size)
+		{
+			volatile char *stack = (volatile char *)alloca(size);
+
+			for (size_t i = 0; i < size; i += 1024) {
+				stack[i] = 1;
+			}
+		}
+
+		static void *run(void *arg)
+		{
+			Faults *self = static_cast<Faults *>(arg);
+
+			if (self->prefault) {
+				px4_rt_prefault_stack(192 * 1024);
+			}
+
+			uint64_t minor_before, major_before, minor_after, major_after;
+			px4_rt_thread_page_faults(&minor_before, &major_before);
+			useStack(160 * 1024);
+			px4_rt_thread_page_faults(&minor_after, &major_after);
+			self->minor = minor_after - minor_before;
+			return nullptr;
+		}
+	};
+
+	Faults cold;
+	Faults prefaulted;
+	prefaulted.prefault = true;
+
+	for (Faults *faults : {&cold, &prefaulted}) {
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		pthread_attr_setstacksize(&attr, 512 * 1024);
+		pthread_t thread;
+		ASSERT_EQ(pthread_create(&thread, &attr, Faults::run, faults), 0);
+		pthread_attr_destroy(&attr);
+		pthread_join(thread, nullptr);
+	}
+
+	printf("stack page faults: cold %llu, pre-faulted %llu\n", (unsigned long long)cold.minor,
+	       (unsigned long long)prefaulted.minor);
+
+	EXPECT_GT(cold.minor, 10u);
+	EXPECT_LE(prefaulted.minor, 2u);
+}
+
+TEST(RtProfileTest, lockMemory)
+{
+	const int ret = px4_rt_lock_memory(1024 * 1024);
+
+	if (ret != 0) {
+		// no CAP_IPC_LOCK or RLIMIT_MEMLOCK too small
+		EXPECT_TRUE(ret == -EPERM || ret == -ENOMEM) << ret;
+		EXPECT_FALSE(px4_rt_memory_locked());
+		return;
+	}
+
+	EXPECT_TRUE(px4_rt_memory_locked());
+
+	// with locked memory and no heap trimming, allocations within the reserve do not fault
+	uint64_t minor_before, major_before, minor_after, major_after;
+	px4_rt_thread_page_faults(&minor_before, &major_before);
+	std::vector<char> buffer(512 * 1024, 1);
+	px4_rt_thread_page_faults(&minor_after, &major_after);
+	EXPECT_LE(minor_after - minor_before, 2u);
+	EXPECT_EQ(major_after - major_before, 0u);
+
+	munlockall();
+}
+
+TEST(RtProfileTest, wakeupJitterUnderLoad)
+{
+	const uint32_t cpus = processCpus();
+	const int num_cpus = __builtin_popcount(cpus);
+
+	// synthetic background load: two busy threads per CPU
+	std::atomic<bool> stop{false};
+	std::vector<std::thread> load;
+
+	for (int i = 0; i < 2 * num_cpus; i++) {
+		load.emplace_back([&stop]() {
+			volatile uint64_t x = 0;
+
+			while (!stop) {
+				x = x + 1;
+			}
+		});
+	}
+
+	JitterConfig normal;
+	ASSERT_TRUE(measureJitter(normal));
+
+	// real-time profile: SCHED_FIFO at max priority, pinned to the highest CPU, stack pre-faulted
+	JitterConfig realtime;
+	realtime.realtime = true;
+	realtime.cpus = 1u << (31 - __builtin_clz(cpus));
+	const bool realtime_available = measureJitter(realtime);
+
+	stop = true;
+
+	for (std::thread &t : load) {
+		t.join();
+	}
+
+	printf("wake-up lateness with %i busy threads on %i CPUs [us]\n", 2 * num_cpus, num_cpus);
+	printf("  SCHED_OTHER         p50 %6llu  p99 %6llu  max %6llu\n", (unsigned long long)normal.result.p50,
+	       (unsigned long long)normal.result.p99, (unsigned long long)normal.result.max);
+
+	if (!realtime_available) {
+		printf("  SCHED_FIFO not permitted, skipped\n");
+		return;
+	}
+
+	printf("  FIFO, pinned        p50 %6llu  p99 %6llu  max %6llu\n", (unsigned long long)realtime.result.p50,
+	       (unsigned long long)realtime.result.p99, (unsigned long long)realtime.result.max);
+
+	// the real-time thread preempts the load, a normal thread competes with it
+	EXPECT_LT(realtime.result.p99, 2000u);
+	EXPECT_LE(realtime.result.p99, normal.result.p99 + 100);
+}
@@ -0,0 +1,334 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file px4_rt_profile.c
+ *
+ * Real-time profile helpers for POSIX.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // CPU affinity, RUSAGE_THREAD
+#endif
+
+#include "px4_rt_profile.h"
+
+#include <alloca.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+static volatile bool memory_locked = false;
+
+int px4_rt_parse_cpu_list(const char *list, uint32_t *mask)
+{
+	uint32_t result = 0;
+	const char *p = list;
+
+	if (list == NULL || *list == '\0') {
+		return -EINVAL;
+	}
+
+	while (*p != '\0') {
+		char *end;
+		const long first = strtol(p, &end, 10);
+		long last = first;
+
+		if (end == p || first < 0 || first >= PX4_RT_MAX_CPUS) {
+			return -EINVAL;
+		}
+
+		p = end;
+
+		if (*p == '-') {
+			++p;
+			last = strtol(p, &end, 10);
+
+			if (end == p || last < first || last >= PX4_RT_MAX_CPUS) {
+				return -EINVAL;
+			}
+
+			p = end;
+		}
+
+		for (long cpu = first; cpu <= last; ++cpu) {
+			result |= 1u << cpu;
+		}
+
+		if (*p == ',') {
+			++p;
+
+			if (*p == '\0') {
+				return -EINVAL;
+			}
+
+		} else if (*p != '\0') {
+			return -EINVAL;
+		}
+	}
+
+	*mask = result;
+	return 0;
+}
+
+void px4_rt_format_cpu_list(uint32_t mask, char *buf, size_t len)
+{
+	size_t pos = 0;
+	buf[0] = '\0';
+
+	if (mask == 0) {
+		snprintf(buf, len, "none");
+		return;
+	}
+
+	for (int cpu = 0; cpu < PX4_RT_MAX_CPUS && pos < len; ++cpu) {
+		if ((mask & (1u << cpu)) == 0) {
+			continue;
+		}
+
+		int last = cpu;
+
+		while (last + 1 < PX4_RT_MAX_CPUS && (mask & (1u << (last + 1))) != 0) {
+			++last;
+		}
+
+		int ret;
+
+		if (last > cpu) {
+			ret = snprintf(buf + pos, len - pos, "%s%i-%i", pos > 0 ? "," : "", cpu, last);
+
+		} else {
+			ret = snprintf(buf + pos, len - pos, "%s%i", pos > 0 ? "," : "", cpu);
+		}
+
+		if (ret < 0) {
+			break;
+		}
+
+		pos += (size_t)ret;
+		cpu = last;
+	}
+}
+
+uint32_t px4_rt_online_cpus(void)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (cpus <= 0) {
+		cpus = 1;
+
+	} else if (cpus > PX4_RT_MAX_CPUS) {
+		cpus = PX4_RT_MAX_CPUS;
+	}
+
+	return (cpus == PX4_RT_MAX_CPUS) ? 0xffffffffu : ((1u << cpus) - 1);
+}
+
+#if defined(__PX4_LINUX)
+
+static void mask_to_cpu_set(uint32_t mask, cpu_set_t *set)
+{
+	if (mask == 0) {
+		mask = px4_rt_online_cpus();
+	}
+
+	CPU_ZERO(set);
+
+	for (int cpu = 0; cpu < PX4_RT_MAX_CPUS; ++cpu) {
+		if (mask & (1u << cpu)) {
+			CPU_SET(cpu, set);
+		}
+	}
+}
+
+int px4_rt_attr_set_affinity(pthread_attr_t *attr, uint32_t mask)
+{
+	cpu_set_t set;
+	mask_to_cpu_set(mask, &set);
+	return -pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+}
+
+int px4_rt_set_affinity(pthread_t thread, uint32_t mask)
+{
+	cpu_set_t set;
+	mask_to_cpu_set(mask, &set);
+	return -pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+
+int px4_rt_get_affinity(pthread_t thread, uint32_t *mask)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	const int ret = pthread_getaffinity_np(thread, sizeof(set), &set);
+
+	if (ret != 0) {
+		return -ret;
+	}
+
+	*mask = 0;
+
+	for (int cpu = 0; cpu < PX4_RT_MAX_CPUS; ++cpu) {
+		if (CPU_ISSET(cpu, &set)) {
+			*mask |= 1u << cpu;
+		}
+	}
+
+	return 0;
+}
+
+int px4_rt_thread_page_faults(uint64_t *minor, uint64_t *major)
+{
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+		return -errno;
+	}
+
+	*minor = (uint64_t)usage.ru_minflt;
+	*major = (uint64_t)usage.ru_majflt;
+	return 0;
+}
+
+#else
+
+int px4_rt_attr_set_affinity(pthread_attr_t *attr, uint32_t mask)
+{
+	return -ENOTSUP;
+}
+
+int px4_rt_set_affinity(pthread_t thread, uint32_t mask)
+{
+	return -ENOTSUP;
+}
+
+int px4_rt_get_affinity(pthread_t thread, uint32_t *mask)
+{
+	return -ENOTSUP;
+}
+
+int px4_rt_thread_page_faults(uint64_t *minor, uint64_t *major)
+{
+	return -ENOTSUP;
+}
+
+#endif /* __PX4_LINUX */
+
+int px4_rt_get_sched(pthread_t thread, int *policy, int *priority)
+{
+	struct sched_param param;
+	const int ret = pthread_getschedparam(thread, policy, &param);
+
+	if (ret != 0) {
+		return -ret;
+	}
+
+	*priority = param.sched_priority;
+	return 0;
+}
+
+const char *px4_rt_policy_name(int policy)
+{
+	switch (policy) {
+	case SCHED_FIFO: return "FIFO";
+
+	case SCHED_RR: return "RR";
+
+	case SCHED_OTHER: return "OTHER";
+#if defined(SCHED_BATCH)
+
+	case SCHED_BATCH: return "BATCH";
+#endif
+#if defined(SCHED_IDLE)
+
+	case SCHED_IDLE: return "IDLE";
+#endif
+	}
+
+	return "?";
+}
+
+int px4_rt_lock_memory(size_t heap_reserve)
+{
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+		return -errno;
+	}
+
+#if defined(__GLIBC__)
+	// keep freed memory in the heap instead of returning it to the system (and faulting it in again),
+	// and serve large allocations from the (locked) heap instead of separate mappings
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+#endif
+
+	if (heap_reserve > 0) {
+		// grow the heap once and touch every page, it stays mapped after the free
+		volatile char *reserve = (volatile char *)malloc(heap_reserve);
+
+		if (reserve != NULL) {
+			const long page_size = sysconf(_SC_PAGESIZE);
+
+			for (size_t i = 0; i < heap_reserve; i += (size_t)page_size) {
+				reserve[i] = 0;
+			}
+
+			free((void *)reserve);
+		}
+	}
+
+	memory_locked = true;
+	return 0;
+}
+
+bool px4_rt_memory_locked(void)
+{
+	return memory_locked;
+}
+
+__attribute__((noinline)) void px4_rt_prefault_stack(size_t size)
+{
+	volatile char *stack = (volatile char *)alloca(size);
+	const long page_size = sysconf(_SC_PAGESIZE);
+
+	for (size_t i = 0; i < size; i += (size_t)page_size) {
+		stack[i] = 0;
+	}
+}
@@ -0,0 +1,130 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file px4_rt_profile.h
+ *
+ * Real-time profile helpers for POSIX: CPU affinity of threads, the effective
+ * scheduling policy, and locking and pre-faulting of memory so that the
+ * real-time threads do not page fault.
+ *
+ * CPU sets are bit masks (bit i: CPU i). Affinity is only supported on Linux,
+ * the functions return -ENOTSUP elsewhere.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+#define PX4_RT_MAX_CPUS 32 ///< number of CPUs that can be addressed by a mask
+#define PX4_RT_CPU_LIST_LEN 64 ///< buffer length for a formatted CPU list
+
+__BEGIN_DECLS
+
+/**
+ * Parse a CPU list such as "3", "0,2" or "1-3".
+ * @return 0 on success, -EINVAL on a malformed list or CPU index out of range
+ */
+int px4_rt_parse_cpu_list(const char *list, uint32_t *mask);
+
+/**
+ * Format a mask as CPU list ("0,2-3"), "none" for an empty mask.
+ */
+void px4_rt_format_cpu_list(uint32_t mask, char *buf, size_t len);
+
+/**
+ * Mask of the CPUs that are online.
+ */
+uint32_t px4_rt_online_cpus(void);
+
+/**
+ * Set the CPU affinity of thread creation attributes.
+ * @param mask CPU set, 0 for all online CPUs
+ * @return 0 or -errno
+ */
+int px4_rt_attr_set_affinity(pthread_attr_t *attr, uint32_t mask);
+
+/**
+ * Set the CPU affinity of a running thread.
+ * @param mask CPU set, 0 for all online CPUs
+ * @return 0 or -errno
+ */
+int px4_rt_set_affinity(pthread_t thread, uint32_t mask);
+
+/**
+ * Get the effective CPU affinity of a thread.
+ * @return 0 or -errno
+ */
+int px4_rt_get_affinity(pthread_t thread, uint32_t *mask);
+
+/**
+ * Get the effective scheduling policy and priority of a thread.
+ * @return 0 or -errno
+ */
+int px4_rt_get_sched(pthread_t thread, int *policy, int *priority);
+
+/**
+ * Name of a scheduling policy ("FIFO", "RR", "OTHER", ...).
+ */
+const char *px4_rt_policy_name(int policy);
+
+/**
+ * Lock all current and future memory (mlockall), keep freed heap memory in the process
+ * and pre-fault a heap reserve, so that later allocations do not page fault.
+ * @param heap_reserve bytes of heap to pre-fault, 0 for none
+ * @return 0 or -errno (e.g. -EPERM without CAP_IPC_LOCK, -ENOMEM above RLIMIT_MEMLOCK)
+ */
+int px4_rt_lock_memory(size_t heap_reserve);
+
+/**
+ * @return true after a successful px4_rt_lock_memory()
+ */
+bool px4_rt_memory_locked(void);
+
+/**
+ * Touch size bytes of the calling thread's stack below the current frame, so that
+ * they are faulted in before the thread does real-time work.
+ */
+void px4_rt_prefault_stack(size_t size);
+
+/**
+ * Count of page faults of the calling thread (minor and major) since it started.
+ * @return 0 or -errno
+ */
+int px4_rt_thread_page_faults(uint64_t *minor, uint64_t *major);
+
+__END_DECLS
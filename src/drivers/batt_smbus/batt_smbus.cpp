@@ -63,6 +63,11 @@ BATT_SMBUS::BATT_SMBUS(SMBus *interface, const char *path) :
 	_cell_undervoltage_protection_status(1)
 {
 	battery_status_s new_report = {};
+	new_report.remaining_std = NAN;
+	new_report.internal_resistance = NAN;
+	new_report.time_remaining_s = NAN;
+	new_report.time_remaining_std_s = NAN;
+	new_report.energy_remaining_wh = NAN;
 	_batt_topic = orb_advertise(ORB_ID(battery_status), &new_report);
 
 	int battsource = 1;
@@ -171,27 +176,40 @@ void BATT_SMBUS::Run()
 
 	new_report.connected = true;
 
-	// Temporary variable for storing SMBUS reads.
-	uint16_t result;
+	// The smart battery does not provide the model based estimates.
+	new_report.remaining_std = NAN;
+	new_report.internal_resistance = NAN;
+	new_report.time_remaining_s = NAN;
+	new_report.time_remaining_std_s = NAN;
+	new_report.energy_remaining_wh = NAN;
+
+	// Read all periodic values at once, such that they share one bus transaction.
+	static constexpr uint8_t cmd_codes[] = {
+		BATT_SMBUS_VOLTAGE,
+		BATT_SMBUS_CURRENT,
+		BATT_SMBUS_AVERAGE_CURRENT,
+		BATT_SMBUS_RUN_TIME_TO_EMPTY,
+		BATT_SMBUS_AVERAGE_TIME_TO_EMPTY,
+		BATT_SMBUS_REMAINING_CAPACITY,
+		BATT_SMBUS_TEMP
+	};
+
+	uint16_t words[sizeof(cmd_codes)] {};
 
-	int ret = _interface->read_word(BATT_SMBUS_VOLTAGE, result);
+	int ret = _interface->read_words(cmd_codes, words, sizeof(cmd_codes));
 
 	ret |= get_cell_voltages();
 
 	// Convert millivolts to volts.
-	new_report.voltage_v = ((float)result) / 1000.0f;
+	new_report.voltage_v = ((float)words[0]) / 1000.0f;
 	new_report.voltage_filtered_v = new_report.voltage_v;
 
-	// Read current.
-	ret |= _interface->read_word(BATT_SMBUS_CURRENT, result);
-
-	new_report.current_a = (-1.0f * ((float)(*(int16_t *)&result)) / 1000.0f);
+	// Current.
+	new_report.current_a = (-1.0f * ((float)(int16_t)words[1]) / 1000.0f);
 	new_report.current_filtered_a = new_report.current_a;
 
-	// Read average current.
-	ret |= _interface->read_word(BATT_SMBUS_AVERAGE_CURRENT, result);
-
-	float average_current = (-1.0f * ((float)(*(int16_t *)&result)) / 1000.0f);
+	// Average current.
+	float average_current = (-1.0f * ((float)(int16_t)words[2]) / 1000.0f);
 
 	new_report.average_current_a = average_current;
 
@@ -199,23 +217,21 @@ void BATT_SMBUS::Run()
 	// a battery from cutting off while flying with high current near the end of the packs capacity.
 	set_undervoltage_protection(average_current);
 
-	// Read run time to empty.
-	ret |= _interface->read_word(BATT_SMBUS_RUN_TIME_TO_EMPTY, result);
-	new_report.run_time_to_empty = result;
+	// Run time to empty.
+	new_report.run_time_to_empty = words[3];
 
-	// Read average time to empty.
-	ret |= _interface->read_word(BATT_SMBUS_AVERAGE_TIME_TO_EMPTY, result);
-	new_report.average_time_to_empty = result;
+	// Average time to empty.
+	new_report.average_time_to_empty = words[4];
 
-	// Read remaining capacity.
-	ret |= _interface->read_word(BATT_SMBUS_REMAINING_CAPACITY, result);
+	// Remaining capacity.
+	const uint16_t remaining_capacity = words[5];
 
 	// Calculate remaining capacity percent with complementary filter.
-	new_report.remaining = 0.8f * _last_report.remaining + 0.2f * (1.0f - (float)((float)(_batt_capacity - result) /
-			       (float)_batt_capacity));
+	new_report.remaining = 0.8f * _last_report.remaining + 0.2f * (1.0f - (float)((float)(_batt_capacity -
+			       remaining_capacity) / (float)_batt_capacity));
 
 	// Calculate total discharged amount.
-	new_report.discharged_mah = _batt_startup_capacity - result;
+	new_report.discharged_mah = _batt_startup_capacity - remaining_capacity;
 
 	// Check if max lifetime voltage delta is greater than allowed.
 	if (_lifetime_max_delta_cell_voltage > BATT_CELL_VOLTAGE_THRESHOLD_FAILED) {
@@ -238,9 +254,8 @@ void BATT_SMBUS::Run()
 		}
 	}
 
-	// Read battery temperature and covert to Celsius.
-	ret |= _interface->read_word(BATT_SMBUS_TEMP, result);
-	new_report.temperature = ((float)result / 10.0f) + CONSTANTS_ABSOLUTE_NULL_CELSIUS;
+	// Battery temperature, convert to Celsius.
+	new_report.temperature = ((float)words[6] / 10.0f) + CONSTANTS_ABSOLUTE_NULL_CELSIUS;
 
 	new_report.capacity = _batt_capacity;
 	new_report.cycle_count = _cycle_count;
@@ -284,24 +299,22 @@ void BATT_SMBUS::resume()
 
 int BATT_SMBUS::get_cell_voltages()
 {
+	static constexpr uint8_t cmd_codes[] = {
+		BATT_SMBUS_CELL_1_VOLTAGE,
+		BATT_SMBUS_CELL_2_VOLTAGE,
+		BATT_SMBUS_CELL_3_VOLTAGE,
+		BATT_SMBUS_CELL_4_VOLTAGE
+	};
+
 	// Temporary variable for storing SMBUS reads.
-	uint16_t result = 0;
+	uint16_t result[sizeof(cmd_codes)] {};
 
-	int ret = _interface->read_word(BATT_SMBUS_CELL_1_VOLTAGE, result);
-	// Convert millivolts to volts.
-	_cell_voltages[0] = ((float)result) / 1000.0f;
+	int ret = _interface->read_words(cmd_codes, result, sizeof(cmd_codes));
 
-	ret = _interface->read_word(BATT_SMBUS_CELL_2_VOLTAGE, result);
-	// Convert millivolts to volts.
-	_cell_voltages[1] = ((float)result) / 1000.0f;
-
-	ret = _interface->read_word(BATT_SMBUS_CELL_3_VOLTAGE, result);
-	// Convert millivolts to volts.
-	_cell_voltages[2] = ((float)result) / 1000.0f;
-
-	ret = _interface->read_word(BATT_SMBUS_CELL_4_VOLTAGE, result);
-	// Convert millivolts to volts.
-	_cell_voltages[3] = ((float)result) / 1000.0f;
+	for (unsigned i = 0; i < sizeof(cmd_codes); i++) {
+		// Convert millivolts to volts.
+		_cell_voltages[i] = ((float)result[i]) / 1000.0f;
+	}
 
 	//Calculate max cell delta
 	_min_cell_voltage = _cell_voltages[0];
@@ -499,6 +512,18 @@ void BATT_SMBUS::print_report()
 	print_message(_last_report);
 }
 
+int BATT_SMBUS::print_status()
+{
+	PX4_INFO("running");
+
+#if defined(__PX4_LINUX)
+	// the batched reads of the shared bus
+	_interface->print_bus_stats();
+#endif
+
+	return PX4_OK;
+}
+
 int BATT_SMBUS::manufacturer_read(const uint16_t cmd_code, void *data, const unsigned length)
 {
 	uint8_t code = BATT_SMBUS_MANUFACTURER_BLOCK_ACCESS;
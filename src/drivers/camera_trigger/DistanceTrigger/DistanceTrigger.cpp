@@ -0,0 +1,155 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file DistanceTrigger.cpp
+ */
+
+#include "DistanceTrigger.hpp"
+
+#include <float.h>
+#include <mathlib/mathlib.h>
+
+using matrix::Vector2f;
+
+void DistanceTrigger::reset()
+{
+	_valid = false;
+	_armed_time_us = 0;
+	_pending_time_us = 0;
+	_evaluation_available = false;
+}
+
+Vector2f DistanceTrigger::_extrapolate(const Vector2f &position, const Vector2f &velocity, uint64_t from_us,
+				       uint64_t to_us)
+{
+	float dt = (to_us >= from_us) ? (to_us - from_us) * 1e-6f : -((from_us - to_us) * 1e-6f);
+	dt = math::constrain(dt, -MAX_EXTRAPOLATION, MAX_EXTRAPOLATION);
+	return position + velocity * dt;
+}
+
+int64_t DistanceTrigger::update(uint64_t now_us, const Vector2f &position, const Vector2f &velocity,
+				uint64_t position_time_us)
+{
+	// The trigger position is known once there is an estimate after it. Until then the
+	// position predicted for the trigger time is used as reference.
+	if (_pending_time_us != 0 && position_time_us >= _pending_time_us) {
+		const Vector2f trigger_position = _extrapolate(position, velocity, position_time_us, _pending_time_us);
+
+		if (_pending_evaluate) {
+			_evaluation.trigger_time_us = _pending_time_us;
+			_evaluation.distance_predicted = _pending_distance_predicted;
+			_evaluation.distance = (trigger_position - _pending_reference).length();
+			_evaluation.lead_time = _pending_lead_time;
+			_evaluation_available = true;
+		}
+
+		_reference = trigger_position;
+		_pending_time_us = 0;
+	}
+
+	const Vector2f position_now = _extrapolate(position, velocity, position_time_us, now_us);
+
+	_armed_at_us = now_us;
+	_armed_position = position_now;
+	_armed_velocity = velocity;
+
+	if (!_valid) {
+		// first trigger
+		_reference = position_now;
+		_valid = true;
+		_first_trigger = true;
+		_armed_time_us = now_us;
+		return 0;
+	}
+
+	// Solve |r + v * t| = distance for the time t at which the trigger distance is reached
+	const Vector2f r = position_now - _reference;
+	const float a = velocity.norm_squared();
+	const float b = 2.f * (r * velocity);
+	const float c = r.norm_squared() - _distance * _distance;
+
+	if (c >= 0.f) {
+		// already there, e.g. after a position reset
+		_armed_time_us = now_us;
+		return 0;
+	}
+
+	if (a < FLT_EPSILON) {
+		_armed_time_us = 0;
+		return -1;
+	}
+
+	// c < 0, so there is exactly one positive solution
+	const float t = (-b + sqrtf(b * b - 4.f * a * c)) / (2.f * a);
+	const int64_t delay_us = (int64_t)(t * 1e6f);
+
+	if (delay_us > (int64_t)_horizon_us) {
+		_armed_time_us = 0;
+		return -1;
+	}
+
+	_armed_time_us = now_us + delay_us;
+	return delay_us;
+}
+
+void DistanceTrigger::triggered(uint64_t time_us)
+{
+	if (_armed_time_us == 0) {
+		return;
+	}
+
+	const Vector2f predicted_position = _extrapolate(_armed_position, _armed_velocity, _armed_at_us, time_us);
+
+	// the first trigger has no previous one to be evaluated against
+	_pending_evaluate = !_first_trigger;
+	_first_trigger = false;
+	_pending_reference = _reference;
+	_pending_distance_predicted = (predicted_position - _reference).length();
+	_pending_lead_time = (time_us >= _armed_at_us) ? (time_us - _armed_at_us) * 1e-6f : 0.f;
+	_pending_time_us = time_us;
+
+	_reference = predicted_position;
+	_armed_time_us = 0;
+}
+
+bool DistanceTrigger::getEvaluation(Evaluation &evaluation)
+{
+	if (!_evaluation_available) {
+		return false;
+	}
+
+	evaluation = _evaluation;
+	_evaluation_available = false;
+	return true;
+}
@@ -0,0 +1,137 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file DistanceTrigger.hpp
+ *
+ * Prediction of distance based camera triggers.
+ *
+ * Instead of triggering once the distance to the previous trigger position has been exceeded,
+ * the time at which the distance will be reached is predicted from the position and velocity
+ * estimate, such that the trigger can be scheduled with a one-shot timer for that instant.
+ * The prediction is repeated with every update until the trigger fires, and only made within
+ * a short horizon. Once a position estimate after the trigger is available, the trigger position
+ * is evaluated and becomes the reference for the next one. Positions are in a local frame [m].
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+#include <stdint.h>
+
+class DistanceTrigger
+{
+public:
+	struct Evaluation {
+		uint64_t trigger_time_us;
+		float distance_predicted; ///< distance from the previous trigger, predicted with the estimate used to arm [m]
+		float distance; ///< distance from the previous trigger, from the first estimate after the trigger [m]
+		float lead_time; ///< time between the last prediction and the trigger [s]
+	};
+
+	DistanceTrigger() = default;
+	~DistanceTrigger() = default;
+
+	/**
+	 * Forget the previous trigger position, the next update triggers immediately
+	 */
+	void reset();
+
+	/**
+	 * @param distance distance between triggers [m]
+	 */
+	void setDistance(float distance) { _distance = distance; }
+	float getDistance() const { return _distance; }
+
+	/**
+	 * @param horizon_us the trigger is only armed if it is predicted within this time [us]
+	 */
+	void setHorizon(uint64_t horizon_us) { _horizon_us = horizon_us; }
+
+	/**
+	 * Update with the latest position estimate
+	 * @param now_us current time [us]
+	 * @param position estimated position [m]
+	 * @param velocity estimated velocity [m/s]
+	 * @param position_time_us time of the estimate [us]
+	 * @return delay after which to trigger [us], 0 for immediately, or -1 if the trigger is not within the horizon
+	 */
+	int64_t update(uint64_t now_us, const matrix::Vector2f &position, const matrix::Vector2f &velocity,
+		       uint64_t position_time_us);
+
+	/**
+	 * Notify that the trigger armed by the last update() fired
+	 * @param time_us time of the trigger [us]
+	 */
+	void triggered(uint64_t time_us);
+
+	/**
+	 * @return true if the trigger was armed by the last update() and has not fired yet
+	 */
+	bool isArmed() const { return _armed_time_us != 0; }
+
+	/**
+	 * @param evaluation filled with the evaluation of the last trigger
+	 * @return true if a new evaluation is available
+	 */
+	bool getEvaluation(Evaluation &evaluation);
+
+private:
+	static constexpr float MAX_EXTRAPOLATION = 1.f; ///< maximum age of an estimate to extrapolate it [s]
+
+	static matrix::Vector2f _extrapolate(const matrix::Vector2f &position, const matrix::Vector2f &velocity,
+					     uint64_t from_us, uint64_t to_us);
+
+	float _distance{25.f};
+	uint64_t _horizon_us{50000};
+
+	bool _valid{false}; ///< a reference position exists
+	matrix::Vector2f _reference; ///< position of the previous trigger
+	bool _first_trigger{false};
+
+	// state when the trigger was armed
+	uint64_t _armed_time_us{0}; ///< predicted trigger time, 0 if not armed
+	uint64_t _armed_at_us{0};
+	matrix::Vector2f _armed_position;
+	matrix::Vector2f _armed_velocity;
+
+	// trigger waiting for a position estimate after it
+	uint64_t _pending_time_us{0};
+	bool _pending_evaluate{false};
+	matrix::Vector2f _pending_reference;
+	float _pending_distance_predicted{0.f};
+	float _pending_lead_time{0.f};
+
+	Evaluation _evaluation{};
+	bool _evaluation_available{false};
+};
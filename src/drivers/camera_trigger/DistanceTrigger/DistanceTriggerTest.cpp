@@ -0,0 +1,305 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the distance based camera trigger prediction
+ * Run this test only using make tests TESTFILTER=DistanceTrigger
+ */
+
+#include <gtest/gtest.h>
+#include <functional>
+#include <vector>
+#include <matrix/matrix/math.hpp>
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+#include "DistanceTrigger.hpp"
+
+using namespace matrix;
+
+class DistanceTriggerTest : public ::testing::Test
+{
+public:
+	/** true position and velocity at a time [s] */
+	using Trajectory = std::function<void(float t, Vector2f &position, Vector2f &velocity)>;
+
+	static constexpr uint64_t RUN_INTERVAL = 5000; ///< camera_trigger work item [us]
+	static constexpr uint64_t ESTIMATE_INTERVAL = 20000; ///< local position estimate [us]
+	static constexpr uint64_t ESTIMATE_DELAY = 2000; ///< estimate timestamp to availability [us]
+	static constexpr uint64_t TIMER_LATENCY = 20; ///< hrt callout latency [us]
+	static constexpr float DISTANCE = 10.f;
+
+	struct Result {
+		std::vector<Vector2f> positions; ///< true trigger positions
+		std::vector<DistanceTrigger::Evaluation> evaluations;
+		float max_error{0.f}; ///< maximum spacing error [m]
+		float mean_error{0.f}; ///< mean spacing error [m]
+	};
+
+	static void estimate(const Trajectory &trajectory, uint64_t now, Vector2f &position, Vector2f &velocity,
+			     uint64_t &time)
+	{
+		time = ((now - ESTIMATE_DELAY) / ESTIMATE_INTERVAL) * ESTIMATE_INTERVAL;
+		trajectory(time * 1e-6f, position, velocity);
+	}
+
+	static void addTrigger(Result &result, const Trajectory &trajectory, uint64_t time)
+	{
+		Vector2f position, velocity;
+		trajectory(time * 1e-6f, position, velocity);
+
+		if (!result.positions.empty()) {
+			const float error = fabsf((position - result.positions.back()).length() - DISTANCE);
+			result.max_error = math::max(result.max_error, error);
+			result.mean_error += (error - result.mean_error) / result.positions.size();
+		}
+
+		result.positions.push_back(position);
+	}
+
+	/** predicted trigger with a one-shot timer, as in camera_trigger */
+	Result runPredictive(const Trajectory &trajectory, float duration)
+	{
+		Result result;
+		DistanceTrigger trigger;
+		trigger.setDistance(DISTANCE);
+		trigger.setHorizon(50000);
+
+		uint64_t fire_time = 0;
+
+		for (uint64_t now = ESTIMATE_DELAY; now < duration * 1e6f; now += RUN_INTERVAL) {
+			if (fire_time != 0 && fire_time <= now) {
+				addTrigger(result, trajectory, fire_time);
+				trigger.triggered(fire_time);
+				fire_time = 0;
+			}
+
+			Vector2f position, velocity;
+			uint64_t time;
+			estimate(trajectory, now, position, velocity, time);
+
+			const int64_t delay = trigger.update(now, position, velocity, time);
+
+			// re-arming replaces the pending call
+			fire_time = (delay >= 0) ? now + delay + TIMER_LATENCY : 0;
+
+			DistanceTrigger::Evaluation evaluation;
+
+			if (trigger.getEvaluation(evaluation)) {
+				result.evaluations.push_back(evaluation);
+			}
+		}
+
+		return result;
+	}
+
+	/** trigger once the distance is exceeded, as before */
+	Result runPolling(const Trajectory &trajectory, float duration)
+	{
+		Result result;
+		Vector2f last_position;
+		bool valid = false;
+
+		for (uint64_t now = ESTIMATE_DELAY; now < duration * 1e6f; now += RUN_INTERVAL) {
+			Vector2f position, velocity;
+			uint64_t time;
+			estimate(trajectory, now, position, velocity, time);
+
+			if (!valid || (position - last_position).length() >= DISTANCE) {
+				addTrigger(result, trajectory, now + TIMER_LATENCY);
+				last_position = position;
+				valid = true;
+			}
+		}
+
+		return result;
+	}
+
+	static Trajectory straightLine(float speed)
+	{
+		return [speed](float t, Vector2f & position, Vector2f & velocity) {
+			const Vector2f direction = Vector2f(3.f, 4.f) / 5.f;
+			position = direction * speed * t;
+			velocity = direction * speed;
+		};
+	}
+};
+
+TEST_F(DistanceTriggerTest, StraightLineAcrossSpeeds)
+{
+	float predictive_max_error = 0.f;
+	float polling_mean_error = 0.f;
+	int runs = 0;
+
+	// speeds at which the trigger interval is not a multiple of the estimate interval
+	for (float speed : {1.3f, 3.7f, 6.1f, 11.3f, 17.9f, 23.3f}) {
+		const float duration = 20.5f * DISTANCE / speed;
+		const Result predictive = runPredictive(straightLine(speed), duration);
+		const Result polling = runPolling(straightLine(speed), duration);
+
+		// WHEN: flying at a constant velocity
+		// THEN: the triggers are spaced by the distance up to the timer latency, independent of the speed
+		EXPECT_EQ(predictive.positions.size(), 21u) << "speed " << speed;
+		EXPECT_LT(predictive.max_error, 0.01f) << "speed " << speed;
+
+		predictive_max_error = math::max(predictive_max_error, predictive.max_error);
+		polling_mean_error += polling.mean_error;
+		++runs;
+	}
+
+	// while polling overshoots by up to the distance travelled in one estimate interval
+	polling_mean_error /= runs;
+	EXPECT_GT(polling_mean_error, 0.05f);
+	EXPECT_LT(predictive_max_error, 0.02f * polling_mean_error);
+}
+
+TEST_F(DistanceTriggerTest, Accelerating)
+{
+	// GIVEN: a vehicle accelerating from standstill to 20 m/s
+	const Trajectory trajectory = [](float t, Vector2f & position, Vector2f & velocity) {
+		const float acceleration = 2.f;
+		const float t_accel = math::min(t, 10.f);
+		const float speed = acceleration * t_accel;
+		const float distance = 0.5f * acceleration * t_accel * t_accel + speed * (t - t_accel);
+		position = Vector2f(distance, 0.f);
+		velocity = Vector2f(speed, 0.f);
+	};
+
+	const Result result = runPredictive(trajectory, 20.5f);
+
+	// THEN: the constant velocity prediction over a few ms stays accurate
+	EXPECT_EQ(result.positions.size(), 31u);
+	EXPECT_LT(result.max_error, 0.01f);
+}
+
+TEST_F(DistanceTriggerTest, Turn)
+{
+	// GIVEN: a vehicle flying a circle with 30 m radius at 10 m/s
+	const Trajectory trajectory = [](float t, Vector2f & position, Vector2f & velocity) {
+		const float radius = 30.f;
+		const float rate = 10.f / radius;
+		position = Vector2f(radius * cosf(rate * t), radius * sinf(rate * t));
+		velocity = Vector2f(-radius * rate * sinf(rate * t), radius * rate * cosf(rate * t));
+	};
+
+	const Result predictive = runPredictive(trajectory, 18.f);
+	const Result polling = runPolling(trajectory, 18.f);
+
+	// THEN: the straight line prediction is still much better than polling
+	EXPECT_GE(predictive.positions.size(), 17u);
+	EXPECT_LT(predictive.max_error, 0.02f);
+	EXPECT_LT(predictive.max_error, 0.1f * polling.max_error);
+}
+
+TEST_F(DistanceTriggerTest, Evaluation)
+{
+	const float speed = 12.f;
+	const Result result = runPredictive(straightLine(speed), 10.f);
+
+	// THEN: every trigger except the first one is evaluated once a later estimate is available
+	ASSERT_GE(result.positions.size(), 10u);
+	EXPECT_GE(result.evaluations.size(), result.positions.size() - 2);
+
+	for (size_t i = 0; i < result.evaluations.size(); ++i) {
+		const DistanceTrigger::Evaluation &evaluation = result.evaluations[i];
+		const float true_distance = (result.positions[i + 1] - result.positions[i]).length();
+
+		EXPECT_NEAR(evaluation.distance, true_distance, 0.01f);
+		EXPECT_NEAR(evaluation.distance_predicted, DISTANCE, 0.01f);
+		// the trigger is predicted within one work item interval before it fires
+		EXPECT_GE(evaluation.lead_time, 0.f);
+		EXPECT_LE(evaluation.lead_time, RUN_INTERVAL * 1e-6f);
+	}
+}
+
+TEST_F(DistanceTriggerTest, Hover)
+{
+	DistanceTrigger trigger;
+	trigger.setDistance(DISTANCE);
+
+	// WHEN: the first estimate arrives
+	// THEN: the first trigger is immediate
+	EXPECT_EQ(trigger.update(1000, Vector2f(1.f, 2.f), Vector2f(), 1000), 0);
+	trigger.triggered(1100);
+
+	// WHEN: hovering
+	// THEN: the trigger is not armed
+	for (uint64_t now = 6000; now < 1000000; now += 5000) {
+		EXPECT_EQ(trigger.update(now, Vector2f(1.f, 2.f), Vector2f(), now), -1);
+		EXPECT_FALSE(trigger.isArmed());
+	}
+
+	DistanceTrigger::Evaluation evaluation;
+	EXPECT_FALSE(trigger.getEvaluation(evaluation));
+}
+
+TEST_F(DistanceTriggerTest, HorizonAndPositionJump)
+{
+	DistanceTrigger trigger;
+	trigger.setDistance(DISTANCE);
+	trigger.setHorizon(50000);
+
+	EXPECT_EQ(trigger.update(0, Vector2f(), Vector2f(), 0), 0);
+	trigger.triggered(0);
+
+	// WHEN: the distance is reached in 100 ms at 10 m/s
+	// THEN: the trigger is not armed yet
+	EXPECT_EQ(trigger.update(10000, Vector2f(9.f, 0.f), Vector2f(10.f, 0.f), 10000), -1);
+
+	// WHEN: the distance is reached in 30 ms
+	// THEN: the trigger is armed for that time
+	const int64_t delay = trigger.update(20000, Vector2f(9.7f, 0.f), Vector2f(10.f, 0.f), 20000);
+	EXPECT_NEAR(delay, 30000, 10);
+	EXPECT_TRUE(trigger.isArmed());
+
+	// WHEN: the estimate jumps beyond the distance
+	// THEN: the trigger is immediate
+	EXPECT_EQ(trigger.update(25000, Vector2f(15.f, 0.f), Vector2f(10.f, 0.f), 25000), 0);
+}
+
+TEST_F(DistanceTriggerTest, Reset)
+{
+	DistanceTrigger trigger;
+	trigger.setDistance(DISTANCE);
+
+	EXPECT_EQ(trigger.update(0, Vector2f(), Vector2f(5.f, 0.f), 0), 0);
+	trigger.triggered(10);
+	EXPECT_EQ(trigger.update(5000, Vector2f(0.025f, 0.f), Vector2f(5.f, 0.f), 5000), -1);
+
+	// WHEN: the trigger is reset, e.g. after a pause
+	trigger.reset();
+
+	// THEN: the next update triggers immediately
+	EXPECT_EQ(trigger.update(10000, Vector2f(0.05f, 0.f), Vector2f(5.f, 0.f), 10000), 0);
+}
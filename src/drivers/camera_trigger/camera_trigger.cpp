@@ -50,14 +50,17 @@
 #include <poll.h>
 #include <mathlib/mathlib.h>
 #include <matrix/math.hpp>
+#include <px4_atomic.h>
 #include <px4_platform_common/px4_work_queue/ScheduledWorkItem.hpp>
 #include <systemlib/err.h>
 #include <parameters/param.h>
 #include <systemlib/mavlink_log.h>
 
+#include <uORB/Publication.hpp>
 #include <uORB/PublicationQueued.hpp>
 #include <uORB/Subscription.hpp>
 #include <uORB/topics/camera_trigger.h>
+#include <uORB/topics/camera_trigger_distance.h>
 #include <uORB/topics/camera_capture.h>
 #include <uORB/topics/sensor_combined.h>
 #include <uORB/topics/vehicle_command.h>
@@ -72,6 +75,8 @@
 #include "interfaces/src/pwm.h"
 #include "interfaces/src/seagull_map2.h"
 
+#include "DistanceTrigger.hpp"
+
 extern "C" __EXPORT int camera_trigger_main(int argc, char *argv[]);
 
 typedef enum : int32_t {
@@ -117,8 +122,9 @@ public:
 
 	/**
 	 * Trigger the camera just once
+	 * @param delay time until the trigger [us]
 	 */
-	void		shoot_once();
+	void		shoot_once(hrt_abstime delay = 0);
 
 	/**
 	 * Toggle keep camera alive functionality
@@ -168,15 +174,22 @@ private:
 	bool			_one_shot;
 	bool			_test_shot;
 	bool 			_turning_on;
-	matrix::Vector2f	_last_shoot_position;
 	bool			_valid_position;
 
+	DistanceTrigger		_distance_trigger;
+	px4::atomic_bool	_triggered{false};	///< set by engage(), with the time and sequence of the trigger
+	hrt_abstime		_trigger_time{0};
+	uint32_t		_triggered_seq{0};
+	uint32_t		_evaluated_seq{0};
+	float			_last_distance_error{0.f};
+
 	uORB::Subscription	_command_sub{ORB_ID(vehicle_command)};
 	uORB::Subscription	_lpos_sub{ORB_ID(vehicle_local_position)};
 
 	orb_advert_t		_trigger_pub;
 
 	uORB::PublicationQueued<vehicle_command_ack_s>	_cmd_ack_pub{ORB_ID(vehicle_command_ack)};
+	uORB::Publication<camera_trigger_distance_s>	_trigger_distance_pub{ORB_ID(camera_trigger_distance)};
 
 	param_t			_p_mode;
 	param_t			_p_activation_time;
@@ -249,7 +262,6 @@ CameraTrigger::CameraTrigger() :
 	_one_shot(false),
 	_test_shot(false),
 	_turning_on(false),
-	_last_shoot_position(0.0f, 0.0f),
 	_valid_position(false),
 	_trigger_pub(nullptr),
 	_trigger_mode(TRIGGER_MODE_NONE),
@@ -362,26 +374,57 @@ CameraTrigger::update_distance()
 	}
 
 	if (_trigger_enabled) {
+		// Stop an armed trigger before it is re-armed, such that it cannot fire in between
+		if (_distance_trigger.isArmed()) {
+			hrt_cancel(&_engagecall);
+		}
+
+		if (_triggered.load()) {
+			_distance_trigger.triggered(_trigger_time);
+			_evaluated_seq = _triggered_seq;
+			_triggered.store(false);
+		}
+
 		vehicle_local_position_s local{};
 		_lpos_sub.copy(&local);
 
 		if (local.xy_valid) {
 
-			// Initialize position if not done yet
-			matrix::Vector2f current_position(local.x, local.y);
-
 			if (!_valid_position) {
 				// First time valid position, take first shot
-				_last_shoot_position = current_position;
-				_valid_position = local.xy_valid;
-				shoot_once();
+				_distance_trigger.reset();
+				_valid_position = true;
 			}
 
-			// Check that distance threshold is exceeded
-			if (matrix::Vector2f(_last_shoot_position - current_position).length() >= _distance) {
-				shoot_once();
-				_last_shoot_position = current_position;
+			_distance_trigger.setDistance(_distance);
+
+			// Without a velocity estimate the trigger fires once the distance is exceeded
+			const matrix::Vector2f velocity = local.v_xy_valid ? matrix::Vector2f(local.vx, local.vy) : matrix::Vector2f();
+
+			// Predict when the distance is reached and schedule the trigger for that time
+			const int64_t delay = _distance_trigger.update(hrt_absolute_time(), matrix::Vector2f(local.x, local.y),
+					      velocity, local.timestamp);
 
+			if (delay >= 0) {
+				shoot_once(delay);
+			}
+
+			DistanceTrigger::Evaluation evaluation;
+
+			if (_distance_trigger.getEvaluation(evaluation)) {
+				camera_trigger_distance_s trigger_distance{};
+				trigger_distance.timestamp_trigger = evaluation.trigger_time_us;
+				trigger_distance.seq = _evaluated_seq;
+				trigger_distance.trigger_distance = _distance_trigger.getDistance();
+				trigger_distance.distance_predicted = evaluation.distance_predicted;
+				trigger_distance.distance = evaluation.distance;
+				trigger_distance.error_predicted = evaluation.distance_predicted - trigger_distance.trigger_distance;
+				trigger_distance.error = evaluation.distance - trigger_distance.trigger_distance;
+				trigger_distance.lead_time = evaluation.lead_time;
+				trigger_distance.timestamp = hrt_absolute_time();
+				_trigger_distance_pub.publish(trigger_distance);
+
+				_last_distance_error = trigger_distance.error;
 			}
 		}
 	}
@@ -417,14 +460,14 @@ CameraTrigger::toggle_power()
 }
 
 void
-CameraTrigger::shoot_once()
+CameraTrigger::shoot_once(hrt_abstime delay)
 {
 	if (!_trigger_paused) {
 		// schedule trigger on and off calls
-		hrt_call_after(&_engagecall, 0,
+		hrt_call_after(&_engagecall, delay,
 			       (hrt_callout)&CameraTrigger::engage, this);
 
-		hrt_call_after(&_disengagecall, 0 + (_activation_time * 1000),
+		hrt_call_after(&_disengagecall, delay + (_activation_time * 1000),
 			       (hrt_callout)&CameraTrigger::disengage, this);
 	}
 }
@@ -741,6 +784,11 @@ CameraTrigger::engage(void *arg)
 	trigger.seq = trig->_trigger_seq;
 	trigger.feedback = false;
 
+	// for the evaluation of distance based triggers
+	trig->_trigger_time = trigger.timestamp;
+	trig->_triggered_seq = trigger.seq;
+	trig->_triggered.store(true);
+
 	if (!trig->_cam_cap_fback) {
 		orb_publish(ORB_ID(camera_trigger), trig->_trigger_pub, &trigger);
 
@@ -806,6 +854,7 @@ CameraTrigger::status()
 	} else if (_trigger_mode == TRIGGER_MODE_DISTANCE_ALWAYS_ON ||
 		   _trigger_mode == TRIGGER_MODE_DISTANCE_ON_CMD) {
 		PX4_INFO("distance : %.2f [m]", (double)_distance);
+		PX4_INFO("last distance error : %.3f [m]", (double)_last_distance_error);
 	}
 
 	if (_camera_interface->has_power_control())	{
@@ -502,15 +502,51 @@ MPU9250::start()
 	/* make sure we are stopped first */
 	stop();
 
+#if defined(__PX4_LINUX)
+
+	if (_data_ready_line[0] != '\0') {
+		if (_data_ready.start(_data_ready_line, LinuxGPIOLines::Edge::RISING, &MPU9250::data_ready_callback, this,
+				      &MPU9250::data_ready_failure_callback) == 0) {
+			return;
+		}
+
+		PX4_WARN("data ready on %s unavailable, using timer", _data_ready_line);
+	}
+
+#endif
+
 	ScheduleOnInterval(_call_interval - MPU9250_TIMER_REDUCTION, 1000);
 }
 
 void
 MPU9250::stop()
 {
+#if defined(__PX4_LINUX)
+	_data_ready.stop();
+#endif
+
 	ScheduleClear();
 }
 
+#if defined(__PX4_LINUX)
+void
+MPU9250::data_ready_callback(void *arg, hrt_abstime timestamp)
+{
+	MPU9250 *dev = static_cast<MPU9250 *>(arg);
+	dev->_data_ready_timestamp.store(timestamp);
+	dev->ScheduleNow();
+}
+
+void
+MPU9250::data_ready_failure_callback(void *arg)
+{
+	// no more data ready edges, continue with the timer
+	MPU9250 *dev = static_cast<MPU9250 *>(arg);
+	PX4_WARN("data ready on %s lost, using timer", dev->_data_ready_line);
+	dev->ScheduleOnInterval(dev->_call_interval - MPU9250_TIMER_REDUCTION, 1000);
+}
+#endif
+
 void
 MPU9250::Run()
 {
@@ -645,7 +681,20 @@ MPU9250::measure()
 	/* start measuring */
 	perf_begin(_sample_perf);
 
-	const hrt_abstime timestamp_sample = hrt_absolute_time();
+	hrt_abstime timestamp_sample = hrt_absolute_time();
+
+#if defined(__PX4_LINUX)
+
+	if (_data_ready.isRunning()) {
+		// the sample was taken at the data ready edge, not when the work item ran
+		const hrt_abstime data_ready = _data_ready_timestamp.load();
+
+		if (data_ready <= timestamp_sample && timestamp_sample - data_ready < _call_interval) {
+			timestamp_sample = data_ready;
+		}
+	}
+
+#endif
 
 	/*
 	 * Fetch the full set of measurements from the MPU9250 in one pass
@@ -799,4 +848,12 @@ MPU9250::print_info()
 	}
 
 	_mag.print_status();
+
+#if defined(__PX4_LINUX)
+
+	if (_data_ready_line[0] != '\0') {
+		_data_ready.print_status();
+	}
+
+#endif
 }
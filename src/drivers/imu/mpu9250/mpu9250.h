@@ -34,6 +34,7 @@
 #include <lib/drivers/accelerometer/PX4Accelerometer.hpp>
 #include <lib/drivers/gyroscope/PX4Gyroscope.hpp>
 #include <lib/ecl/geo/geo.h>
+#include <px4_atomic.h>
 #include <px4_getopt.h>
 #include <px4_platform_common/px4_work_queue/ScheduledWorkItem.hpp>
 #include <systemlib/conversions.h>
@@ -41,6 +42,10 @@
 
 #include "MPU9250_mag.h"
 
+#if defined(__PX4_LINUX)
+#include <lib/drivers/linux_gpio/linux_gpio_data_ready.h>
+#endif
+
 
 #if defined(PX4_I2C_OBDEV_MPU9250) || defined(PX4_I2C_BUS_EXPANSION)
 #  define USE_I2C
@@ -251,6 +256,16 @@ public:
 	 */
 	void			print_info();
 
+#if defined(__PX4_LINUX)
+	/**
+	 * Trigger the measurements from the INT pin (data ready) instead of a timer.
+	 * Must be called before init().
+	 *
+	 * @param line GPIO line of the INT pin, <chip>:<offset>
+	 */
+	void			set_data_ready_line(const char *line) { strncpy(_data_ready_line, line, sizeof(_data_ready_line) - 1); }
+#endif
+
 protected:
 	device::Device *_interface;
 	uint8_t			_whoami{0};	/** whoami result */
@@ -273,6 +288,15 @@ private:
 
 	unsigned		_call_interval{1000};
 
+#if defined(__PX4_LINUX)
+	char			_data_ready_line[32] {};
+	LinuxGPIODataReady	_data_ready;
+	px4::atomic<hrt_abstime>	_data_ready_timestamp{0};	/* time of the last data ready edge */
+
+	static void		data_ready_callback(void *arg, hrt_abstime timestamp);
+	static void		data_ready_failure_callback(void *arg);
+#endif
+
 	unsigned		_dlpf_freq;
 
 	unsigned		_sample_rate{1000};
@@ -110,9 +110,17 @@ struct mpu9250_bus_option {
 
 #define NUM_BUS_OPTIONS (sizeof(bus_options)/sizeof(bus_options[0]))
 
+#if defined(__PX4_LINUX)
+#define MPU9250_OPTIONS "XISstMR:D:"
+#else
+#define MPU9250_OPTIONS "XISstMR:"
+#endif
+
 
-void	start(enum MPU9250_BUS busid, enum Rotation rotation, bool external_bus, bool magnetometer_only);
-bool	start_bus(struct mpu9250_bus_option &bus, enum Rotation rotation, bool external_bus, bool magnetometer_only);
+void	start(enum MPU9250_BUS busid, enum Rotation rotation, bool external_bus, bool magnetometer_only,
+	      const char *data_ready_line);
+bool	start_bus(struct mpu9250_bus_option &bus, enum Rotation rotation, bool external_bus, bool magnetometer_only,
+		  const char *data_ready_line);
 struct mpu9250_bus_option &find_bus(enum MPU9250_BUS busid);
 void	stop(enum MPU9250_BUS busid);
 void	info(enum MPU9250_BUS busid);
@@ -137,7 +145,8 @@ struct mpu9250_bus_option &find_bus(enum MPU9250_BUS busid)
  * start driver for a specific bus option
  */
 bool
-start_bus(struct mpu9250_bus_option &bus, enum Rotation rotation, bool external, bool magnetometer_only)
+start_bus(struct mpu9250_bus_option &bus, enum Rotation rotation, bool external, bool magnetometer_only,
+	  const char *data_ready_line)
 {
 	PX4_INFO("Bus probed: %d", bus.busid);
 
@@ -183,6 +192,14 @@ start_bus(struct mpu9250_bus_option &bus, enum Rotation rotation, bool external,
 		return false;
 	}
 
+#if defined(__PX4_LINUX)
+
+	if (data_ready_line != nullptr) {
+		bus.dev->set_data_ready_line(data_ready_line);
+	}
+
+#endif
+
 	if (OK != bus.dev->init()) {
 		goto fail;
 	}
@@ -206,7 +223,8 @@ fail:
  * or failed to detect the sensor.
  */
 void
-start(enum MPU9250_BUS busid, enum Rotation rotation, bool external, bool magnetometer_only)
+start(enum MPU9250_BUS busid, enum Rotation rotation, bool external, bool magnetometer_only,
+      const char *data_ready_line)
 {
 
 	bool started = false;
@@ -222,7 +240,7 @@ start(enum MPU9250_BUS busid, enum Rotation rotation, bool external, bool magnet
 			continue;
 		}
 
-		started |= start_bus(bus_options[i], rotation, external, magnetometer_only);
+		started |= start_bus(bus_options[i], rotation, external, magnetometer_only, data_ready_line);
 
 		if (started) { break; }
 	}
@@ -280,6 +298,9 @@ usage()
 	PX4_INFO("    -t    (spi internal bus, 2nd instance)");
 	PX4_INFO("    -R rotation");
 	PX4_INFO("    -M only enable magnetometer, accel/gyro disabled - not av. on MPU6500");
+#if defined(__PX4_LINUX)
+	PX4_INFO("    -D <chip>:<line> data ready GPIO (INT pin), e.g. gpiochip0:23");
+#endif
 }
 
 } // namespace
@@ -294,8 +315,9 @@ mpu9250_main(int argc, char *argv[])
 	enum MPU9250_BUS busid = MPU9250_BUS_ALL;
 	enum Rotation rotation = ROTATION_NONE;
 	bool magnetometer_only = false;
+	const char *data_ready_line = nullptr;
 
-	while ((ch = px4_getopt(argc, argv, "XISstMR:", &myoptind, &myoptarg)) != EOF) {
+	while ((ch = px4_getopt(argc, argv, MPU9250_OPTIONS, &myoptind, &myoptarg)) != EOF) {
 		switch (ch) {
 		case 'X':
 			busid = MPU9250_BUS_I2C_EXTERNAL;
@@ -325,6 +347,13 @@ mpu9250_main(int argc, char *argv[])
 			magnetometer_only = true;
 			break;
 
+#if defined(__PX4_LINUX)
+
+		case 'D':
+			data_ready_line = myoptarg;
+			break;
+#endif
+
 		default:
 			mpu9250::usage();
 			return 0;
@@ -343,7 +372,7 @@ mpu9250_main(int argc, char *argv[])
 	 * Start/load the driver.
 	 */
 	if (!strcmp(verb, "start")) {
-		mpu9250::start(busid, rotation, external, magnetometer_only);
+		mpu9250::start(busid, rotation, external, magnetometer_only, data_ready_line);
 	}
 
 	if (!strcmp(verb, "stop")) {
@@ -75,6 +75,11 @@ UavcanBatteryBridge::battery_sub_cb(const uavcan::ReceivedDataStructure<uavcan::
 	// battery.average_current_a = msg.;
 	// battery.discharged_mah = msg.;
 	battery.remaining = msg.remaining_capacity_wh / msg.full_charge_capacity_wh; // between 0 and 1
+	battery.remaining_std = NAN;
+	battery.internal_resistance = NAN;
+	battery.time_remaining_s = NAN;
+	battery.time_remaining_std_s = NAN;
+	battery.energy_remaining_wh = msg.remaining_capacity_wh;
 	// battery.scale = msg.; // Power scaling factor, >= 1, or -1 if unknown
 	battery.temperature = msg.temperature;
 	// battery.cell_count = msg.;
@@ -40,6 +40,8 @@
 #  include <uavcan_kinetis/uavcan_kinetis.hpp>
 #elif defined(UAVCAN_STM32_NUTTX)
 #  include <uavcan_stm32/uavcan_stm32.hpp>
+#elif defined(UAVCAN_SOCKETCAN_POSIX)
+#  include <uavcan_socketcan/uavcan_socketcan.hpp>
 #else
 #  error "Unsupported driver"
 #endif
@@ -0,0 +1,80 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#pragma once
+
+#include <uavcan/driver/system_clock.hpp>
+
+namespace uavcan_socketcan
+{
+
+namespace clock
+{
+
+/**
+ * Monotonic time, the PX4 high resolution timer (which follows the lockstep scheduler in SITL).
+ */
+uavcan::MonotonicTime getMonotonic();
+
+/**
+ * UTC time, zero until the first adjustment.
+ */
+uavcan::UtcTime getUtc();
+
+/**
+ * Converts a monotonic timestamp to UTC, zero until the first adjustment.
+ */
+uavcan::UtcTime monotonicToUtc(uavcan::MonotonicTime timestamp);
+
+/**
+ * Adjusts the UTC time. The first adjustment sets the UTC time, later ones are added to it.
+ */
+void adjustUtc(uavcan::UtcDuration adjustment);
+
+} // namespace clock
+
+class SystemClock : public uavcan::ISystemClock, uavcan::Noncopyable
+{
+	SystemClock() = default;
+
+	virtual void adjustUtc(uavcan::UtcDuration adjustment) { clock::adjustUtc(adjustment); }
+
+public:
+	virtual uavcan::MonotonicTime getMonotonic() const { return clock::getMonotonic(); }
+	virtual uavcan::UtcTime getUtc()             const { return clock::getUtc(); }
+
+	static SystemClock &instance();
+};
+
+} // namespace uavcan_socketcan
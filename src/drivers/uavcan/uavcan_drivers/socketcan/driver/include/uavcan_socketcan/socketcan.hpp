@@ -0,0 +1,218 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#pragma once
+
+#include <stdint.h>
+
+#include <uavcan/driver/can.hpp>
+#include <uavcan_socketcan/thread.hpp>
+
+namespace uavcan_socketcan
+{
+
+static constexpr unsigned NumIfaces = UAVCAN_SOCKETCAN_NUM_IFACES;
+
+struct CanRxItem {
+	uavcan::CanFrame frame;
+	uavcan::MonotonicTime ts_mono;
+	uavcan::UtcTime ts_utc;
+	uavcan::CanIOFlags flags{0};
+};
+
+/**
+ * A SocketCAN raw socket. Frames are sent and received in batches (sendmmsg/recvmmsg): send()
+ * only queues the frame, the queue is sent by flush(). Received frames are read by the receive
+ * thread of the driver into a queue, with the kernel receive timestamp.
+ */
+class CanIface : public uavcan::ICanIface, uavcan::Noncopyable
+{
+public:
+	static constexpr unsigned TxQueueCapacity = 64;
+	static constexpr unsigned BatchSize = 16;
+	static constexpr uint16_t NumFilters = 32;
+
+	CanIface(CanRxItem *rx_buffer, unsigned rx_capacity) : _rx_buffer(rx_buffer), _rx_capacity(rx_capacity) {}
+	virtual ~CanIface() { close(); }
+
+	/**
+	 * Opens and binds the socket of a network interface, e.g. can0 or vcan0.
+	 * @return 0 on success, -errno otherwise
+	 */
+	int open(const char *name);
+	void close();
+
+	bool isOpen() const { return _fd >= 0; }
+	int getFd() const { return _fd; }
+	const char *getName() const { return _name; }
+
+	virtual int16_t send(const uavcan::CanFrame &frame, uavcan::MonotonicTime tx_deadline, uavcan::CanIOFlags flags);
+
+	virtual int16_t receive(uavcan::CanFrame &out_frame, uavcan::MonotonicTime &out_ts_monotonic,
+				uavcan::UtcTime &out_ts_utc, uavcan::CanIOFlags &out_flags);
+
+	virtual int16_t configureFilters(const uavcan::CanFilterConfig *filter_configs, uint16_t num_configs);
+
+	virtual uint16_t getNumFilters() const { return NumFilters; }
+
+	/**
+	 * Error frames, frames dropped by the kernel or for a full receive queue and socket errors.
+	 */
+	virtual uint64_t getErrorCount() const;
+
+	/**
+	 * Sends the queued frames, dropping the ones past their deadline. Frames the socket does not
+	 * accept (full device queue) stay queued for the next flush.
+	 */
+	void flush(uavcan::MonotonicTime now);
+
+	/**
+	 * Reads a batch of frames into the receive queue, called by the receive thread.
+	 * @return number of frames read, -errno on socket errors
+	 */
+	int readBatch();
+
+	bool hasRxPending() const;
+	unsigned getRxQueueSpace() const;
+	bool canAcceptTx() const { return _tx_count < TxQueueCapacity; }
+
+	void printStatus() const;
+
+private:
+	struct TxItem {
+		uavcan::CanFrame frame;
+		uavcan::MonotonicTime deadline;
+		bool loopback{false};
+	};
+
+	void pushRx(const CanRxItem &item);
+
+	int _fd{-1};
+	char _name[16] {};
+
+	TxItem _tx_queue[TxQueueCapacity] {};
+	unsigned _tx_head{0};
+	unsigned _tx_count{0};
+
+	// shared with the receive thread
+	mutable Mutex _mutex;
+	CanRxItem *const _rx_buffer;
+	const unsigned _rx_capacity;
+	unsigned _rx_head{0};
+	unsigned _rx_count{0};
+
+	uint64_t _errors{0};
+	uint32_t _kernel_drops{0};
+
+	uint64_t _tx_frames{0};
+	uint64_t _tx_batches{0};
+	uint64_t _tx_expired{0};
+	uint64_t _rx_frames{0};
+	uint64_t _rx_batches{0};
+	uint64_t _rx_kernel_timestamps{0};
+};
+
+/**
+ * The interfaces and the receive thread, which waits for the sockets to become readable, reads
+ * them in batches and signals the BusEvent.
+ */
+class CanDriver : public uavcan::ICanDriver, uavcan::Noncopyable
+{
+public:
+	CanDriver(CanRxItem *rx_buffers, unsigned rx_capacity_per_iface);
+	virtual ~CanDriver();
+
+	/**
+	 * Sets the network interfaces, comma separated (default: can0,can1,...). Must be called
+	 * before init().
+	 * @return false if the list has too many interfaces
+	 */
+	static bool setInterfaces(const char *interfaces);
+
+	/**
+	 * Opens the interfaces and starts the receive thread. The bitrate is a property of the
+	 * network interface on Linux (ip link set can0 type can bitrate 1000000), it is not applied.
+	 * @return 0 on success, -errno otherwise
+	 */
+	int init(uint32_t bitrate);
+
+	virtual int16_t select(uavcan::CanSelectMasks &inout_masks,
+			       const uavcan::CanFrame *(&pending_tx)[uavcan::MaxCanIfaces],
+			       uavcan::MonotonicTime blocking_deadline);
+
+	virtual CanIface *getIface(uint8_t iface_index);
+
+	virtual uint8_t getNumIfaces() const { return _num_ifaces; }
+
+	/**
+	 * Sends the queued frames of all interfaces.
+	 */
+	void flush();
+
+	BusEvent &getBusEvent() { return _bus_event; }
+
+private:
+	static void *rxThreadTrampoline(void *arg);
+	void rxThread();
+
+	uavcan::CanSelectMasks makeSelectMasks() const;
+
+	static char _interfaces[128];
+
+	BusEvent _bus_event;
+	CanIface *_ifaces[NumIfaces] {};
+	uint8_t _num_ifaces{0};
+
+	pthread_t _rx_thread{};
+	volatile bool _rx_thread_running{false};
+	volatile bool _rx_thread_should_exit{false};
+
+	CanRxItem *const _rx_buffers;
+	const unsigned _rx_capacity;
+};
+
+template <unsigned RxQueueCapacity = 128>
+class CanInitHelper
+{
+	CanRxItem _rx_buffers[NumIfaces * RxQueueCapacity];
+
+public:
+	CanDriver driver;
+
+	CanInitHelper() : driver(_rx_buffers, RxQueueCapacity) {}
+
+	int init(uint32_t bitrate) { return driver.init(bitrate); }
+};
+
+} // namespace uavcan_socketcan
@@ -0,0 +1,97 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#pragma once
+
+#include <pthread.h>
+
+#include <lib/cdev/CDev.hpp>
+#include <px4_sem.h>
+#include <uavcan/driver/system_clock.hpp>
+
+namespace uavcan_socketcan
+{
+
+/**
+ * Signalled by the receive thread when frames were received. The uavcan task waits for it in
+ * CanDriver::select() and polls it together with the uORB topics in its main loop.
+ */
+class BusEvent : public cdev::CDev
+{
+public:
+	static const char DevName[];
+
+	BusEvent();
+	virtual ~BusEvent();
+
+	/**
+	 * Waits for and consumes the event.
+	 * @param duration maximum time to wait, the event is only consumed if not positive
+	 * @return true if the event was signalled
+	 */
+	bool wait(uavcan::MonotonicDuration duration);
+
+	void signal();
+
+protected:
+	virtual pollevent_t poll_state(cdev::file_t *filep);
+
+private:
+	px4_sem_t _sem;
+};
+
+class Mutex
+{
+public:
+	Mutex() { pthread_mutex_init(&_mutex, nullptr); }
+	~Mutex() { pthread_mutex_destroy(&_mutex); }
+
+	void lock() { pthread_mutex_lock(&_mutex); }
+	void unlock() { pthread_mutex_unlock(&_mutex); }
+
+private:
+	pthread_mutex_t _mutex;
+};
+
+class MutexLocker
+{
+public:
+	MutexLocker(Mutex &mutex) : _mutex(mutex) { _mutex.lock(); }
+	~MutexLocker() { _mutex.unlock(); }
+
+private:
+	Mutex &_mutex;
+};
+
+} // namespace uavcan_socketcan
@@ -0,0 +1,696 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include <uavcan_socketcan/socketcan.hpp>
+#include <uavcan_socketcan/clock.hpp>
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+#include <drivers/drv_hrt.h>
+#include <px4_log.h>
+#include <px4_posix.h>
+#include <px4_tasks.h>
+
+#ifndef SO_RXQ_OVFL
+#define SO_RXQ_OVFL 40
+#endif
+
+namespace uavcan_socketcan
+{
+
+static can_frame toSocketCan(const uavcan::CanFrame &frame)
+{
+	can_frame out{};
+	out.can_id = frame.id & uavcan::CanFrame::MaskExtID;
+	out.can_dlc = frame.dlc;
+	memcpy(out.data, frame.data, frame.dlc);
+
+	if (frame.isExtended()) {
+		out.can_id |= CAN_EFF_FLAG;
+	}
+
+	if (frame.isRemoteTransmissionRequest()) {
+		out.can_id |= CAN_RTR_FLAG;
+	}
+
+	return out;
+}
+
+static uavcan::CanFrame fromSocketCan(const can_frame &frame)
+{
+	uavcan::CanFrame out(frame.can_id & CAN_EFF_MASK, frame.data, frame.can_dlc > 8 ? 8 : frame.can_dlc);
+
+	if (frame.can_id & CAN_EFF_FLAG) {
+		out.id |= uavcan::CanFrame::FlagEFF;
+
+	} else {
+		out.id &= uavcan::CanFrame::MaskStdID;
+	}
+
+	if (frame.can_id & CAN_RTR_FLAG) {
+		out.id |= uavcan::CanFrame::FlagRTR;
+	}
+
+	return out;
+}
+
+static uint32_t toSocketCanFlags(uint32_t id)
+{
+	uint32_t out = id & uavcan::CanFrame::MaskExtID;
+
+	if (id & uavcan::CanFrame::FlagEFF) {
+		out |= CAN_EFF_FLAG;
+	}
+
+	if (id & uavcan::CanFrame::FlagRTR) {
+		out |= CAN_RTR_FLAG;
+	}
+
+	return out;
+}
+
+int CanIface::open(const char *name)
+{
+	close();
+	strncpy(_name, name, sizeof(_name) - 1);
+
+	const int fd = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+
+	if (fd < 0) {
+		return -errno;
+	}
+
+	struct ifreq ifr {};
+	strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+
+	const int on = 1;
+	// error frames are counted
+	const can_err_mask_t err_mask = CAN_ERR_MASK;
+
+	struct sockaddr_can addr {};
+	addr.can_family = AF_CAN;
+
+	if (::ioctl(fd, SIOCGIFINDEX, &ifr) < 0
+	    || ::setsockopt(fd, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0
+	    || ::setsockopt(fd, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &err_mask, sizeof(err_mask)) < 0) {
+		const int ret = -errno;
+		::close(fd);
+		return ret;
+	}
+
+	// kernel drop counter, not available on old kernels
+	(void)::setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+
+	addr.can_ifindex = ifr.ifr_ifindex;
+
+	if (::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+		const int ret = -errno;
+		::close(fd);
+		return ret;
+	}
+
+	_fd = fd;
+	return 0;
+}
+
+void CanIface::close()
+{
+	if (_fd >= 0) {
+		::close(_fd);
+		_fd = -1;
+	}
+}
+
+int16_t CanIface::send(const uavcan::CanFrame &frame, uavcan::MonotonicTime tx_deadline, uavcan::CanIOFlags flags)
+{
+	if (_fd < 0 || frame.isErrorFrame() || frame.dlc > 8) {
+		return -1;
+	}
+
+	if (!canAcceptTx()) {
+		return 0;
+	}
+
+	// the queue is ordered by CAN arbitration priority, frames of equal priority stay in order
+	// (e.g. the frames of a multi-frame transfer), so bulk transfers do not delay e.g. ESC commands
+	unsigned index = _tx_count;
+
+	while (index > 0) {
+		const TxItem &prev = _tx_queue[(_tx_head + index - 1) % TxQueueCapacity];
+
+		if (!frame.priorityHigherThan(prev.frame)) {
+			break;
+		}
+
+		_tx_queue[(_tx_head + index) % TxQueueCapacity] = prev;
+		index--;
+	}
+
+	TxItem &item = _tx_queue[(_tx_head + index) % TxQueueCapacity];
+	item.frame = frame;
+	item.deadline = tx_deadline;
+	item.loopback = (flags & uavcan::CanIOFlagLoopback) != 0;
+	_tx_count++;
+
+	return 1;
+}
+
+void CanIface::flush(uavcan::MonotonicTime now)
+{
+	can_frame frames[BatchSize];
+	struct iovec iovs[BatchSize];
+	struct mmsghdr msgs[BatchSize];
+
+	while (_tx_count > 0 && _fd >= 0) {
+
+		if (_tx_queue[_tx_head].deadline < now) {
+			_tx_head = (_tx_head + 1) % TxQueueCapacity;
+			_tx_count--;
+			_tx_expired++;
+			continue;
+		}
+
+		// batch up to the next expired frame, which is dropped in the next round
+		unsigned num = 0;
+
+		while (num < _tx_count && num < BatchSize) {
+			const TxItem &item = _tx_queue[(_tx_head + num) % TxQueueCapacity];
+
+			if (item.deadline < now) {
+				break;
+			}
+
+			frames[num] = toSocketCan(item.frame);
+			iovs[num].iov_base = &frames[num];
+			iovs[num].iov_len = sizeof(can_frame);
+			msgs[num] = {};
+			msgs[num].msg_hdr.msg_iov = &iovs[num];
+			msgs[num].msg_hdr.msg_iovlen = 1;
+			num++;
+		}
+
+		const int sent = ::sendmmsg(_fd, msgs, num, MSG_DONTWAIT);
+
+		if (sent < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+				// device queue full, retry at the next flush
+				break;
+			}
+
+			// e.g. the interface is down: drop the frame
+			MutexLocker locker(_mutex);
+			_errors++;
+			_tx_head = (_tx_head + 1) % TxQueueCapacity;
+			_tx_count--;
+			continue;
+		}
+
+		const uavcan::MonotonicTime sent_time = clock::getMonotonic();
+
+		for (int i = 0; i < sent; i++) {
+			const TxItem &item = _tx_queue[_tx_head];
+
+			// loopback frames (e.g. of the time sync master) are received with the send time
+			if (item.loopback) {
+				CanRxItem rx_item;
+				rx_item.frame = item.frame;
+				rx_item.ts_mono = sent_time;
+				rx_item.ts_utc = clock::monotonicToUtc(sent_time);
+				rx_item.flags = uavcan::CanIOFlagLoopback;
+				pushRx(rx_item);
+			}
+
+			_tx_head = (_tx_head + 1) % TxQueueCapacity;
+			_tx_count--;
+		}
+
+		_tx_frames += sent;
+		_tx_batches++;
+
+		if ((unsigned)sent < num) {
+			break;
+		}
+	}
+}
+
+int16_t CanIface::receive(uavcan::CanFrame &out_frame, uavcan::MonotonicTime &out_ts_monotonic,
+			  uavcan::UtcTime &out_ts_utc, uavcan::CanIOFlags &out_flags)
+{
+	MutexLocker locker(_mutex);
+
+	if (_rx_count == 0) {
+		return 0;
+	}
+
+	const CanRxItem &item = _rx_buffer[_rx_head];
+	out_frame = item.frame;
+	out_ts_monotonic = item.ts_mono;
+	out_ts_utc = item.ts_utc;
+	out_flags = item.flags;
+
+	_rx_head = (_rx_head + 1) % _rx_capacity;
+	_rx_count--;
+
+	return 1;
+}
+
+void CanIface::pushRx(const CanRxItem &item)
+{
+	MutexLocker locker(_mutex);
+
+	if (_rx_count >= _rx_capacity) {
+		_errors++;
+		return;
+	}
+
+	_rx_buffer[(_rx_head + _rx_count) % _rx_capacity] = item;
+	_rx_count++;
+}
+
+int CanIface::readBatch()
+{
+	const unsigned space = getRxQueueSpace();
+	const unsigned num = space < BatchSize ? space : BatchSize;
+
+	if (_fd < 0 || num == 0) {
+		return 0;
+	}
+
+	static constexpr size_t ControlSize = CMSG_SPACE(sizeof(struct timeval)) + CMSG_SPACE(sizeof(uint32_t));
+
+	can_frame frames[BatchSize];
+	struct iovec iovs[BatchSize];
+	struct mmsghdr msgs[BatchSize];
+	alignas(struct cmsghdr) uint8_t control[BatchSize][ControlSize];
+
+	for (unsigned i = 0; i < num; i++) {
+		iovs[i].iov_base = &frames[i];
+		iovs[i].iov_len = sizeof(can_frame);
+		msgs[i] = {};
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_control = control[i];
+		msgs[i].msg_hdr.msg_controllen = ControlSize;
+	}
+
+	const int received = ::recvmmsg(_fd, msgs, num, MSG_DONTWAIT, nullptr);
+
+	if (received < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+			return 0;
+		}
+
+		const int ret = -errno;
+		MutexLocker locker(_mutex);
+		_errors++;
+		return ret;
+	}
+
+	// the kernel timestamps are realtime, the age of a frame is the same on the monotonic clock
+	struct timespec now_realtime {};
+
+	clock_gettime(CLOCK_REALTIME, &now_realtime);
+
+	const uint64_t now = hrt_absolute_time();
+
+	const uint64_t now_realtime_us = (uint64_t)now_realtime.tv_sec * 1000000 + now_realtime.tv_nsec / 1000;
+
+	MutexLocker locker(_mutex);
+
+	for (int i = 0; i < received; i++) {
+		uint64_t timestamp = now;
+		bool kernel_timestamp = false;
+
+		for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != nullptr;
+		     cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+
+			if (cmsg->cmsg_level != SOL_SOCKET) {
+				continue;
+			}
+
+			if (cmsg->cmsg_type == SO_TIMESTAMP) {
+				struct timeval tv;
+				memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+				const uint64_t timestamp_us = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+				const uint64_t age = now_realtime_us > timestamp_us ? now_realtime_us - timestamp_us : 0;
+#if !defined(ENABLE_LOCKSTEP_SCHEDULER)
+				// with lockstep the monotonic clock is the simulation time, use the receive time
+				timestamp = now > age ? now - age : 0;
+				kernel_timestamp = true;
+#else
+				(void)age;
+#endif
+
+			} else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+				uint32_t drops;
+				memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+				_errors += drops - _kernel_drops;
+				_kernel_drops = drops;
+			}
+		}
+
+		if (frames[i].can_id & CAN_ERR_FLAG) {
+			_errors++;
+			continue;
+		}
+
+		if (_rx_count >= _rx_capacity) {
+			_errors++;
+			continue;
+		}
+
+		CanRxItem &item = _rx_buffer[(_rx_head + _rx_count) % _rx_capacity];
+		item.frame = fromSocketCan(frames[i]);
+		item.ts_mono = uavcan::MonotonicTime::fromUSec(timestamp);
+		item.ts_utc = clock::monotonicToUtc(item.ts_mono);
+		item.flags = 0;
+		_rx_count++;
+
+		if (kernel_timestamp) {
+			_rx_kernel_timestamps++;
+		}
+	}
+
+	_rx_frames += received;
+	_rx_batches++;
+
+	return received;
+}
+
+int16_t CanIface::configureFilters(const uavcan::CanFilterConfig *filter_configs, uint16_t num_configs)
+{
+	if (_fd < 0 || num_configs > NumFilters) {
+		return -1;
+	}
+
+	struct can_filter filters[NumFilters] {};
+
+	for (unsigned i = 0; i < num_configs; i++) {
+		filters[i].can_id = toSocketCanFlags(filter_configs[i].id);
+		filters[i].can_mask = toSocketCanFlags(filter_configs[i].mask);
+	}
+
+	// no filters: accept everything
+	const unsigned num = num_configs > 0 ? num_configs : 1;
+
+	if (::setsockopt(_fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters, num * sizeof(can_filter)) < 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+uint64_t CanIface::getErrorCount() const
+{
+	MutexLocker locker(_mutex);
+	return _errors;
+}
+
+bool CanIface::hasRxPending() const
+{
+	MutexLocker locker(_mutex);
+	return _rx_count > 0;
+}
+
+unsigned CanIface::getRxQueueSpace() const
+{
+	MutexLocker locker(_mutex);
+	return _rx_capacity - _rx_count;
+}
+
+void CanIface::printStatus() const
+{
+	MutexLocker locker(_mutex);
+
+	printf("\tinterface: %s%s\n", _name, _fd < 0 ? " (closed)" : "");
+	printf("\tTX: %llu frames in %llu batches, %llu expired, %u queued\n", (unsigned long long)_tx_frames,
+	       (unsigned long long)_tx_batches, (unsigned long long)_tx_expired, _tx_count);
+	printf("\tRX: %llu frames in %llu batches, %llu kernel timestamps, %u queued\n", (unsigned long long)_rx_frames,
+	       (unsigned long long)_rx_batches, (unsigned long long)_rx_kernel_timestamps, _rx_count);
+}
+
+char CanDriver::_interfaces[128] {};
+
+CanDriver::CanDriver(CanRxItem *rx_buffers, unsigned rx_capacity_per_iface) :
+	_rx_buffers(rx_buffers),
+	_rx_capacity(rx_capacity_per_iface)
+{
+}
+
+CanDriver::~CanDriver()
+{
+	if (_rx_thread_running) {
+		_rx_thread_should_exit = true;
+		pthread_join(_rx_thread, nullptr);
+	}
+
+	for (unsigned i = 0; i < _num_ifaces; i++) {
+		delete _ifaces[i];
+	}
+}
+
+bool CanDriver::setInterfaces(const char *interfaces)
+{
+	unsigned num = 1;
+
+	for (const char *c = interfaces; *c != '\0'; c++) {
+		if (*c == ',') {
+			num++;
+		}
+	}
+
+	if (num > NumIfaces || strlen(interfaces) >= sizeof(_interfaces)) {
+		return false;
+	}
+
+	strncpy(_interfaces, interfaces, sizeof(_interfaces) - 1);
+	return true;
+}
+
+int CanDriver::init(uint32_t bitrate)
+{
+	(void)bitrate;
+
+	if (_interfaces[0] == '\0') {
+		for (unsigned i = 0; i < NumIfaces; i++) {
+			const size_t len = strlen(_interfaces);
+			snprintf(_interfaces + len, sizeof(_interfaces) - len, "%scan%u", i > 0 ? "," : "", i);
+		}
+	}
+
+	char interfaces[sizeof(_interfaces)];
+	strncpy(interfaces, _interfaces, sizeof(interfaces));
+
+	char *save_ptr = nullptr;
+
+	for (char *name = strtok_r(interfaces, ",", &save_ptr); name != nullptr && _num_ifaces < NumIfaces;
+	     name = strtok_r(nullptr, ",", &save_ptr)) {
+
+		CanIface *iface = new CanIface(_rx_buffers + _num_ifaces * _rx_capacity, _rx_capacity);
+
+		if (iface == nullptr) {
+			return -ENOMEM;
+		}
+
+		_ifaces[_num_ifaces++] = iface;
+
+		const int ret = iface->open(name);
+
+		if (ret < 0) {
+			PX4_ERR("CAN interface %s: %s", name, strerror(-ret));
+			return ret;
+		}
+	}
+
+	int ret = _bus_event.init();
+
+	if (ret != PX4_OK) {
+		return ret;
+	}
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+
+	// above the uavcan task, which waits for the received frames
+	struct sched_param param {};
+	param.sched_priority = SCHED_PRIORITY_MAX - 5;
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	pthread_attr_setschedparam(&attr, &param);
+	pthread_attr_setstacksize(&attr, PX4_STACK_ADJUSTED(2000));
+
+	ret = pthread_create(&_rx_thread, &attr, &CanDriver::rxThreadTrampoline, this);
+
+	if (ret != 0) {
+		// without the permission for real-time priorities
+		pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+		ret = pthread_create(&_rx_thread, &attr, &CanDriver::rxThreadTrampoline, this);
+	}
+
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		return -ret;
+	}
+
+	_rx_thread_running = true;
+	return 0;
+}
+
+void *CanDriver::rxThreadTrampoline(void *arg)
+{
+	px4_prctl(PR_SET_NAME, "uavcan_rx", px4_getpid());
+	static_cast<CanDriver *>(arg)->rxThread();
+	return nullptr;
+}
+
+void CanDriver::rxThread()
+{
+	struct pollfd fds[NumIfaces] {};
+
+	while (!_rx_thread_should_exit) {
+
+		for (unsigned i = 0; i < _num_ifaces; i++) {
+			fds[i].fd = _ifaces[i]->getFd();
+			// a full receive queue leaves the frames in the socket buffer until it is read
+			fds[i].events = _ifaces[i]->getRxQueueSpace() > 0 ? POLLIN : 0;
+			fds[i].revents = 0;
+		}
+
+		// the timeout is for the exit request and full receive queues
+		const int ret = ::poll(fds, _num_ifaces, 10);
+
+		if (ret <= 0) {
+			continue;
+		}
+
+		bool received = false;
+
+		for (unsigned i = 0; i < _num_ifaces; i++) {
+			if (fds[i].revents & POLLIN) {
+				received |= _ifaces[i]->readBatch() > 0;
+
+			} else if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+				// reads and clears the socket error
+				_ifaces[i]->readBatch();
+				usleep(1000);
+			}
+		}
+
+		if (received) {
+			_bus_event.signal();
+		}
+	}
+}
+
+uavcan::CanSelectMasks CanDriver::makeSelectMasks() const
+{
+	uavcan::CanSelectMasks masks;
+
+	for (unsigned i = 0; i < _num_ifaces; i++) {
+		if (_ifaces[i]->hasRxPending()) {
+			masks.read |= 1 << i;
+		}
+
+		if (_ifaces[i]->canAcceptTx()) {
+			masks.write |= 1 << i;
+		}
+	}
+
+	return masks;
+}
+
+int16_t CanDriver::select(uavcan::CanSelectMasks &inout_masks,
+			  const uavcan::CanFrame *(&pending_tx)[uavcan::MaxCanIfaces],
+			  uavcan::MonotonicTime blocking_deadline)
+{
+	(void)pending_tx;
+
+	const uavcan::MonotonicTime now = clock::getMonotonic();
+
+	for (unsigned i = 0; i < _num_ifaces; i++) {
+		_ifaces[i]->flush(now);
+	}
+
+	// consume the event before checking the receive queues, frames received later signal it again
+	_bus_event.wait(uavcan::MonotonicDuration());
+
+	uavcan::CanSelectMasks masks = makeSelectMasks();
+
+	if ((masks.read & inout_masks.read) == 0 && (masks.write & inout_masks.write) == 0) {
+		uavcan::MonotonicDuration timeout = blocking_deadline - now;
+
+		// a full transmit queue is retried with the next flush
+		if ((inout_masks.write & ~masks.write) != 0 && timeout > uavcan::MonotonicDuration::fromMSec(1)) {
+			timeout = uavcan::MonotonicDuration::fromMSec(1);
+		}
+
+		_bus_event.wait(timeout);
+
+		for (unsigned i = 0; i < _num_ifaces; i++) {
+			_ifaces[i]->flush(clock::getMonotonic());
+		}
+
+		masks = makeSelectMasks();
+	}
+
+	inout_masks = masks;
+	return _num_ifaces;
+}
+
+CanIface *CanDriver::getIface(uint8_t iface_index)
+{
+	return iface_index < _num_ifaces ? _ifaces[iface_index] : nullptr;
+}
+
+void CanDriver::flush()
+{
+	const uavcan::MonotonicTime now = clock::getMonotonic();
+
+	for (unsigned i = 0; i < _num_ifaces; i++) {
+		_ifaces[i]->flush(now);
+	}
+}
+
+} // namespace uavcan_socketcan
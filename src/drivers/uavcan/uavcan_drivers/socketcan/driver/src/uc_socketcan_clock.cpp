@@ -0,0 +1,87 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include <uavcan_socketcan/clock.hpp>
+
+#include <drivers/drv_hrt.h>
+#include <px4_atomic.h>
+
+namespace uavcan_socketcan
+{
+namespace clock
+{
+
+// UTC = monotonic + offset, written by the uavcan task and read by the receive thread
+static px4::atomic<int64_t> utc_offset{0};
+static px4::atomic_bool utc_set{false};
+
+uavcan::MonotonicTime getMonotonic()
+{
+	return uavcan::MonotonicTime::fromUSec(hrt_absolute_time());
+}
+
+uavcan::UtcTime getUtc()
+{
+	return monotonicToUtc(getMonotonic());
+}
+
+uavcan::UtcTime monotonicToUtc(uavcan::MonotonicTime timestamp)
+{
+	if (!utc_set.load()) {
+		return uavcan::UtcTime();
+	}
+
+	return uavcan::UtcTime::fromUSec(timestamp.toUSec() + utc_offset.load());
+}
+
+void adjustUtc(uavcan::UtcDuration adjustment)
+{
+	if (utc_set.load()) {
+		utc_offset.fetch_add(adjustment.toUSec());
+
+	} else {
+		utc_offset.store(adjustment.toUSec() - (int64_t)hrt_absolute_time());
+		utc_set.store(true);
+	}
+}
+
+} // namespace clock
+
+SystemClock &SystemClock::instance()
+{
+	static SystemClock instance;
+	return instance;
+}
+
+} // namespace uavcan_socketcan
@@ -0,0 +1,102 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include <uavcan_socketcan/thread.hpp>
+
+#include <errno.h>
+
+#include <px4_time.h>
+
+namespace uavcan_socketcan
+{
+
+const char BusEvent::DevName[] = "/dev/uavcan/busevent";
+
+BusEvent::BusEvent() :
+	CDev(DevName)
+{
+	px4_sem_init(&_sem, 0, 0);
+	/* _sem use case is a signal */
+	px4_sem_setprotocol(&_sem, SEM_PRIO_NONE);
+}
+
+BusEvent::~BusEvent()
+{
+	px4_sem_destroy(&_sem);
+}
+
+bool BusEvent::wait(uavcan::MonotonicDuration duration)
+{
+	if (!duration.isPositive()) {
+		return px4_sem_trywait(&_sem) == 0;
+	}
+
+	struct timespec abstime {};
+
+	px4_clock_gettime(CLOCK_MONOTONIC, &abstime);
+
+	const uint64_t nsecs = abstime.tv_nsec + duration.toUSec() * 1000;
+
+	abstime.tv_sec += nsecs / 1000000000;
+
+	abstime.tv_nsec = nsecs % 1000000000;
+
+	while (px4_sem_timedwait(&_sem, &abstime) != 0) {
+		if (errno != EINTR) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void BusEvent::signal()
+{
+	int value = 0;
+
+	// the semaphore is used as a flag, only the receive thread posts
+	if (px4_sem_getvalue(&_sem, &value) == 0 && value <= 0) {
+		px4_sem_post(&_sem);
+	}
+
+	poll_notify(POLLIN);
+}
+
+pollevent_t BusEvent::poll_state(cdev::file_t *filep)
+{
+	int value = 0;
+	return (px4_sem_getvalue(&_sem, &value) == 0 && value > 0) ? POLLIN : 0;
+}
+
+} // namespace uavcan_socketcan
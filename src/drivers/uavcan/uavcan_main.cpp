@@ -52,8 +52,11 @@
 #include <parameters/param.h>
 #include <lib/mixer/mixer.h>
 #include <version/version.h>
+
+#if defined(__PX4_NUTTX)
 #include <arch/board/board.h>
 #include <arch/chip/chip.h>
+#endif
 
 #include <uORB/Subscription.hpp>
 #include <uORB/topics/esc_status.h>
@@ -176,9 +179,29 @@ int UavcanNode::getHardwareVersion(uavcan::protocol::HardwareVersion &hwver)
 			; // All other values of px4_board_name() resolve to zero
 		}
 
+#if defined(__PX4_NUTTX)
 		mfguid_t mfgid = {};
 		board_get_mfguid(mfgid);
 		uavcan::copy(mfgid, mfgid + sizeof(mfgid), hwver.unique_id.begin());
+#else
+		// the machine id is a unique 128 bit hex string per Linux installation
+		FILE *machine_id = fopen("/etc/machine-id", "r");
+
+		if (machine_id != nullptr) {
+			for (unsigned i = 0; i < hwver.unique_id.size(); i++) {
+				unsigned byte = 0;
+
+				if (fscanf(machine_id, "%2x", &byte) != 1) {
+					break;
+				}
+
+				hwver.unique_id[i] = byte;
+			}
+
+			fclose(machine_id);
+		}
+
+#endif
 		rv = 0;
 	}
 
@@ -694,7 +717,7 @@ int UavcanNode::add_poll_fd(int fd)
 		errx(1, "uavcan: too many poll fds, exiting");
 	}
 
-	_poll_fds[_poll_fds_num]	= ::pollfd();
+	_poll_fds[_poll_fds_num]	= px4_pollfd_struct_t();
 	_poll_fds[_poll_fds_num].fd	= fd;
 	_poll_fds[_poll_fds_num].events	= POLLIN;
 	_poll_fds_num += 1;
@@ -779,7 +802,7 @@ int UavcanNode::run()
 
 	_node_status_monitor.start();
 
-	const int busevent_fd = ::open(UAVCAN_DRIVER::BusEvent::DevName, 0);
+	const int busevent_fd = px4_open(UAVCAN_DRIVER::BusEvent::DevName, 0);
 
 	if (busevent_fd < 0) {
 		PX4_ERR("Failed to open %s", UAVCAN_DRIVER::BusEvent::DevName);
@@ -849,10 +872,15 @@ int UavcanNode::run()
 			_groups_subscribed = _groups_required;
 		}
 
+#if defined(UAVCAN_SOCKETCAN_POSIX)
+		// send the frames queued in this iteration (e.g. the ESC commands) in one batch now
+		static_cast<UAVCAN_DRIVER::CanDriver &>(_node.getDispatcher().getCanIOManager().getCanDriver()).flush();
+#endif
+
 		// Mutex is unlocked while the thread is blocked on IO multiplexing
 		(void)pthread_mutex_unlock(&_node_mutex);
 
-		const int poll_ret = ::poll(_poll_fds, _poll_fds_num, PollTimeoutMs);
+		const int poll_ret = px4_poll(_poll_fds, _poll_fds_num, PollTimeoutMs);
 
 		(void)pthread_mutex_lock(&_node_mutex);
 
@@ -996,11 +1024,11 @@ int UavcanNode::run()
 		}
 	}
 
-	(void)::close(busevent_fd);
+	(void)px4_close(busevent_fd);
 
 	teardown();
 
-	exit(0);
+	return 0;
 }
 
 int
@@ -1063,7 +1091,7 @@ UavcanNode::subscribe()
 }
 
 int
-UavcanNode::ioctl(file *filp, int cmd, unsigned long arg)
+UavcanNode::ioctl(cdev::file_t *filp, int cmd, unsigned long arg)
 {
 	int ret = OK;
 
@@ -1200,6 +1228,10 @@ UavcanNode::print_info()
 		auto iface = _node.getDispatcher().getCanIOManager().getCanDriver().getIface(i);
 		printf("\tHW errors: %llu\n", iface->getErrorCount());
 
+#if defined(UAVCAN_SOCKETCAN_POSIX)
+		static_cast<UAVCAN_DRIVER::CanIface *>(iface)->printStatus();
+#endif
+
 		auto iface_perf_cnt = _node.getDispatcher().getCanIOManager().getIfacePerfCounters(i);
 		printf("\tIO errors: %llu\n", iface_perf_cnt.errors);
 		printf("\tRX frames: %llu\n", iface_perf_cnt.frames_rx);
@@ -1272,7 +1304,11 @@ static void print_usage()
 	PX4_INFO("usage: \n"
 		 "\tuavcan {start [fw]|status|stop [all|fw]|shrink|arm|disarm|update fw|\n"
 		 "\t        param [set|get|list|save] <node-id> <name> <value>|reset <node-id>|\n"
-		 "\t        hardpoint set <id> <command>}");
+		 "\t        hardpoint set <id> <command>}"
+#if defined(UAVCAN_SOCKETCAN_POSIX)
+		 "\n\tuavcan start [-i <interfaces>]: SocketCAN interfaces, comma separated (default: can0,...)"
+#endif
+		);
 }
 
 extern "C" __EXPORT int uavcan_main(int argc, char *argv[]);
@@ -1281,7 +1317,7 @@ int uavcan_main(int argc, char *argv[])
 {
 	if (argc < 2) {
 		print_usage();
-		::exit(1);
+		return 1;
 	}
 
 	bool fw = argc > 2 && !std::strcmp(argv[2], "fw");
@@ -1293,24 +1329,35 @@ int uavcan_main(int argc, char *argv[])
 
 				if (rv < 0) {
 					PX4_ERR("Firmware Server Failed to Start %d", rv);
-					::exit(rv);
+					return rv;
 				}
 
-				::exit(0);
+				return 0;
 			}
 
 			// Already running, no error
 			PX4_INFO("already started");
-			::exit(0);
+			return 0;
+		}
+
+#if defined(UAVCAN_SOCKETCAN_POSIX)
+
+		for (int i = 2; i < argc - 1; i++) {
+			if (!std::strcmp(argv[i], "-i") && !UAVCAN_DRIVER::CanDriver::setInterfaces(argv[i + 1])) {
+				PX4_ERR("Invalid interfaces %s (at most %u)", argv[i + 1], UAVCAN_DRIVER::NumIfaces);
+				return 1;
+			}
 		}
 
+#endif
+
 		// Node ID
 		int32_t node_id = 1;
 		(void)param_get(param_find("UAVCAN_NODE_ID"), &node_id);
 
 		if (node_id < 0 || node_id > uavcan::NodeID::Max || !uavcan::NodeID(node_id).isUnicast()) {
 			PX4_ERR("Invalid Node ID %i", node_id);
-			::exit(1);
+			return 1;
 		}
 
 		// CAN bitrate
@@ -1326,41 +1373,43 @@ int uavcan_main(int argc, char *argv[])
 	UavcanNode *const inst = UavcanNode::instance();
 
 	if (!inst) {
-		errx(1, "application not running");
+		PX4_ERR("application not running");
+		return 1;
 	}
 
 	if (fw && !std::strcmp(argv[1], "update")) {
 		if (UavcanServers::instance() == nullptr) {
-			errx(1, "firmware server is not running");
+			PX4_ERR("firmware server is not running");
+			return 1;
 		}
 
 		int rv = UavcanNode::instance()->fw_server(UavcanNode::CheckFW);
-		::exit(rv);
+		return rv;
 	}
 
 	if (fw && (!std::strcmp(argv[1], "status") || !std::strcmp(argv[1], "info"))) {
 		printf("Firmware Server is %s\n", UavcanServers::instance() ? "Running" : "Stopped");
-		::exit(0);
+		return 0;
 	}
 
 	if (!std::strcmp(argv[1], "status") || !std::strcmp(argv[1], "info")) {
 		inst->print_info();
-		::exit(0);
+		return 0;
 	}
 
 	if (!std::strcmp(argv[1], "shrink")) {
 		inst->shrink();
-		::exit(0);
+		return 0;
 	}
 
 	if (!std::strcmp(argv[1], "arm")) {
 		inst->arm_actuators(true);
-		::exit(0);
+		return 0;
 	}
 
 	if (!std::strcmp(argv[1], "disarm")) {
 		inst->arm_actuators(false);
-		::exit(0);
+		return 0;
 	}
 
 	/*
@@ -1376,13 +1425,15 @@ int uavcan_main(int argc, char *argv[])
 
 	if (!std::strcmp(argv[1], "param") || node_arg == 2) {
 		if (argc < node_arg + 1) {
-			errx(1, "Node id required");
+			PX4_ERR("Node id required");
+			return 1;
 		}
 
 		int nodeid = atoi(argv[node_arg]);
 
 		if (nodeid  == 0 || nodeid  > 127 || nodeid  == inst->get_node().getNodeID().get()) {
-			errx(1, "Invalid Node id");
+			PX4_ERR("Invalid Node id");
+			return 1;
 		}
 
 		if (node_arg == 2) {
@@ -1399,18 +1450,21 @@ int uavcan_main(int argc, char *argv[])
 
 		} else if (!std::strcmp(argv[2], "get")) {
 			if (argc < 5) {
-				errx(1, "Name required");
+				PX4_ERR("Name required");
+				return 1;
 			}
 
 			return inst->get_param(nodeid, argv[4]);
 
 		} else if (!std::strcmp(argv[2], "set")) {
 			if (argc < 5) {
-				errx(1, "Name required");
+				PX4_ERR("Name required");
+				return 1;
 			}
 
 			if (argc < 6) {
-				errx(1, "Value required");
+				PX4_ERR("Value required");
+				return 1;
 			}
 
 			return inst->set_param(nodeid, argv[4], argv[5]);
@@ -1428,14 +1482,16 @@ int uavcan_main(int argc, char *argv[])
 				inst->hardpoint_controller_set((uint8_t) hardpoint_id, (uint16_t) command);
 
 			} else {
-				errx(1, "Invalid argument");
+				PX4_ERR("Invalid argument");
+				return 1;
 			}
 
 		} else {
-			errx(1, "Invalid hardpoint command");
+			PX4_ERR("Invalid hardpoint command");
+			return 1;
 		}
 
-		::exit(0);
+		return 0;
 	}
 
 	if (!std::strcmp(argv[1], "stop")) {
@@ -1449,17 +1505,17 @@ int uavcan_main(int argc, char *argv[])
 
 			if (rv < 0) {
 				PX4_ERR("Firmware Server Failed to Stop %d", rv);
-				::exit(rv);
+				return rv;
 			}
 
-			::exit(0);
+			return 0;
 
 		} else {
 			delete inst;
-			::exit(0);
+			return 0;
 		}
 	}
 
 	print_usage();
-	::exit(1);
+	return 1;
 }
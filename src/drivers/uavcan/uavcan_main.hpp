@@ -110,7 +110,7 @@ public:
 
 	virtual		~UavcanNode();
 
-	virtual int	ioctl(file *filp, int cmd, unsigned long arg);
+	virtual int	ioctl(cdev::file_t *filp, int cmd, unsigned long arg);
 
 	static int	start(uavcan::NodeID node_id, uint32_t bitrate);
 
@@ -198,7 +198,7 @@ private:
 	int				_control_subs[NUM_ACTUATOR_CONTROL_GROUPS_UAVCAN];
 	actuator_controls_s		_controls[NUM_ACTUATOR_CONTROL_GROUPS_UAVCAN] = {};
 	orb_id_t			_control_topics[NUM_ACTUATOR_CONTROL_GROUPS_UAVCAN] = {};
-	pollfd				_poll_fds[UAVCAN_NUM_POLL_FDS] = {};
+	px4_pollfd_struct_t		_poll_fds[UAVCAN_NUM_POLL_FDS] = {};
 	unsigned			_poll_fds_num = 0;
 	int32_t 			_idle_throttle_when_armed = 0;
 
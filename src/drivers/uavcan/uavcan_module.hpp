@@ -34,6 +34,7 @@
 #pragma once
 
 #include <px4_config.h>
+#include <px4_defines.h>
 
 #include <drivers/device/device.h>
 
@@ -49,12 +50,12 @@
 
 // firmware paths
 #define UAVCAN_MAX_PATH_LENGTH (128 + 40)
-#define UAVCAN_FIRMWARE_PATH   "/fs/microsd/fw"
-#define UAVCAN_ROMFS_FW_PATH   "/etc/uavcan/fw"
+#define UAVCAN_FIRMWARE_PATH   PX4_STORAGEDIR"/fw"
+#define UAVCAN_ROMFS_FW_PATH   PX4_ROOTFSDIR"/etc/uavcan/fw"
 #define UAVCAN_ROMFS_FW_PREFIX "_"
 
 // logging
-#define UAVCAN_NODE_DB_PATH "/fs/microsd/uavcan.db"
+#define UAVCAN_NODE_DB_PATH PX4_STORAGEDIR"/uavcan.db"
 #define UAVCAN_LOG_FILE     UAVCAN_NODE_DB_PATH"/trace.log"
 
 // device files
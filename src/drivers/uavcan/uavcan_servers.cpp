@@ -34,7 +34,7 @@
 #include <px4_tasks.h>
 #include <drivers/drv_hrt.h>
 
-#include <nuttx/config.h>
+#include <px4_config.h>
 
 #include <cstdlib>
 #include <cstring>
@@ -46,8 +46,11 @@
 #include <parameters/param.h>
 #include <lib/mixer/mixer.h>
 #include <version/version.h>
+
+#if defined(__PX4_NUTTX)
 #include <arch/board/board.h>
 #include <arch/chip/chip.h>
+#endif
 
 #include "uavcan_main.hpp"
 #include "uavcan_servers.hpp"
@@ -166,7 +169,7 @@ int UavcanServers::start(uavcan::INode &main_node)
 
 	pthread_attr_init(&tattr);
 	(void)pthread_attr_getschedparam(&tattr, &param);
-	tattr.stacksize = PX4_STACK_ADJUSTED(StackSize);
+	(void)pthread_attr_setstacksize(&tattr, PX4_STACK_ADJUSTED(StackSize));
 	param.sched_priority = Priority;
 
 	if (pthread_attr_setschedparam(&tattr, &param)) {
@@ -175,7 +178,7 @@ int UavcanServers::start(uavcan::INode &main_node)
 
 	static auto run_trampoline = [](void *) {return UavcanServers::_instance->run(_instance);};
 
-	rv = pthread_create(&_instance->_subnode_thread, &tattr, static_cast<pthread_startroutine_t>(run_trampoline), NULL);
+	rv = pthread_create(&_instance->_subnode_thread, &tattr, run_trampoline, NULL);
 
 	if (rv != 0) {
 		rv = -rv;
@@ -282,9 +285,9 @@ int UavcanServers::init()
 	return 0;
 }
 
-pthread_addr_t UavcanServers::run(pthread_addr_t)
+void *UavcanServers::run(void *)
 {
-	prctl(PR_SET_NAME, "uavcan fw srv", 0);
+	px4_prctl(PR_SET_NAME, "uavcan fw srv", px4_getpid());
 
 	Lock lock(_subnode_mutex);
 
@@ -593,7 +596,7 @@ pthread_addr_t UavcanServers::run(pthread_addr_t)
 	_subnode_thread_should_exit = false;
 
 	warnx("exiting");
-	return (pthread_addr_t) 0;
+	return nullptr;
 }
 
 void UavcanServers::cb_getset(const uavcan::ServiceCallResult<uavcan::protocol::param::GetSet> &result)
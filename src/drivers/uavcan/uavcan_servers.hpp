@@ -116,7 +116,7 @@ private:
 
 	int		init();
 
-	pthread_addr_t	run(pthread_addr_t);
+	void		*run(void *);
 
 	static UavcanServers	*_instance;            ///< singleton pointer
 
@@ -35,7 +35,7 @@
 
 #pragma once
 
-#include <nuttx/config.h>
+#include <px4_config.h>
 
 #include <cstdlib>
 #include <cstdint>
@@ -44,7 +44,6 @@
 #include <fcntl.h>
 #include <pthread.h>
 #include <semaphore.h>
-#include <debug.h>
 
 #include <uavcan/node/sub_node.hpp>
 #include <uavcan/protocol/node_status_monitor.hpp>
@@ -343,7 +342,7 @@ class VirtualCanDriver : public uavcan::ICanDriver,
 {
 	class Event
 	{
-		FAR px4_sem_t sem;
+		px4_sem_t sem;
 
 
 	public:
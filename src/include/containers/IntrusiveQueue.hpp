@@ -97,29 +97,38 @@ public:
 
 	bool remove(T removeNode)
 	{
+		if ((removeNode == nullptr) || empty()) {
+			return false;
+		}
+
 		// base case
 		if (removeNode == _head) {
-			if (_head->next_intrusive_queue_node() != nullptr) {
-				_head = _head->next_intrusive_queue_node();
+			if (_head == _tail) {
+				// only one item left
+				_head = nullptr;
+				_tail = nullptr;
 
 			} else {
-				_head = nullptr;
+				_head = _head->next_intrusive_queue_node();
 			}
 
+			// clear next in removed (it might be re-inserted later)
+			removeNode->set_next_intrusive_queue_node(nullptr);
+
 			return true;
 		}
 
 		for (T node = _head; node != nullptr; node = node->next_intrusive_queue_node()) {
 			// is sibling the node to remove?
 			if (node->next_intrusive_queue_node() == removeNode) {
-				// replace sibling
-				if (node->next_intrusive_queue_node() != nullptr) {
-					node->set_next_intrusive_queue_node(node->next_intrusive_queue_node()->next_intrusive_queue_node());
-
-				} else {
-					node->set_next_intrusive_queue_node(nullptr);
+				if (removeNode == _tail) {
+					_tail = node;
 				}
 
+				// replace sibling
+				node->set_next_intrusive_queue_node(removeNode->next_intrusive_queue_node());
+				removeNode->set_next_intrusive_queue_node(nullptr);
+
 				return true;
 			}
 		}
@@ -67,6 +67,7 @@ bool FlightTaskAuto::updateInitialize()
 	_sub_manual_control_setpoint.update();
 	_sub_vehicle_status.update();
 	_sub_triplet_setpoint.update();
+	_sub_mission_lookahead.update();
 
 	// require valid reference and valid target
 	ret = ret && _evaluateGlobalReference() && _evaluateTriplets();
@@ -223,6 +224,8 @@ bool FlightTaskAuto::_evaluateTriplets()
 			_triplet_prev_wp = _position;
 		}
 
+		_next_acceptance_radius = _target_acceptance_radius;
+
 		if (_type == WaypointType::loiter) {
 			_triplet_next_wp = _triplet_target;
 
@@ -231,6 +234,11 @@ bool FlightTaskAuto::_evaluateTriplets()
 					       _sub_triplet_setpoint.get().next.lon, &_triplet_next_wp(0), &_triplet_next_wp(1));
 			_triplet_next_wp(2) = -(_sub_triplet_setpoint.get().next.alt - _reference_altitude);
 
+			if (PX4_ISFINITE(_sub_triplet_setpoint.get().next.acceptance_radius)
+			    && _sub_triplet_setpoint.get().next.acceptance_radius > FLT_EPSILON) {
+				_next_acceptance_radius = _sub_triplet_setpoint.get().next.acceptance_radius;
+			}
+
 		} else {
 			_triplet_next_wp = _triplet_target;
 		}
@@ -271,6 +279,8 @@ bool FlightTaskAuto::_evaluateTriplets()
 		_mission_gear = _sub_triplet_setpoint.get().current.landing_gear;
 	}
 
+	_evaluateLookahead();
+
 	if (_param_com_obs_avoid.get()
 	    && _sub_vehicle_status.get().vehicle_type == vehicle_status_s::VEHICLE_TYPE_ROTARY_WING) {
 		_obstacle_avoidance.updateAvoidanceDesiredWaypoints(_triplet_target, _yaw_setpoint, _yawspeed_setpoint,
@@ -284,6 +294,38 @@ bool FlightTaskAuto::_evaluateTriplets()
 	return true;
 }
 
+void FlightTaskAuto::_evaluateLookahead()
+{
+	_lookahead_count = 0;
+
+	const position_setpoint_s &next = _sub_triplet_setpoint.get().next;
+	const mission_lookahead_s &lookahead = _sub_mission_lookahead.get();
+
+	// The lookahead is only meaningful while tracking the navigator waypoints and if it
+	// continues from the current next waypoint.
+	if (_current_state != State::none || _type == WaypointType::loiter
+	    || !next.valid || !_isFinite(next)
+	    || fabs(lookahead.anchor_lat - next.lat) > 1e-7
+	    || fabs(lookahead.anchor_lon - next.lon) > 1e-7) {
+		return;
+	}
+
+	const int count = math::min((int)lookahead.count, (int)mission_lookahead_s::MAX_ITEMS);
+
+	for (int i = 0; i < count; i++) {
+		if (!PX4_ISFINITE(lookahead.lat[i]) || !PX4_ISFINITE(lookahead.lon[i]) || !PX4_ISFINITE(lookahead.alt[i])) {
+			break;
+		}
+
+		map_projection_project(&_reference_position, lookahead.lat[i], lookahead.lon[i],
+				       &_lookahead_wp[i](0), &_lookahead_wp[i](1));
+		_lookahead_wp[i](2) = -(lookahead.alt[i] - _reference_altitude);
+		_lookahead_acceptance_radius[i] = lookahead.acceptance_radius[i];
+		_lookahead_stop[i] = lookahead.stop[i];
+		_lookahead_count++;
+	}
+}
+
 void FlightTaskAuto::_set_heading_from_mode()
 {
 
@@ -43,6 +43,7 @@
 #include <uORB/topics/position_setpoint_triplet.h>
 #include <uORB/topics/position_setpoint.h>
 #include <uORB/topics/home_position.h>
+#include <uORB/topics/mission_lookahead.h>
 #include <uORB/topics/manual_control_setpoint.h>
 #include <uORB/topics/vehicle_status.h>
 #include <lib/ecl/geo/geo.h>
@@ -96,6 +97,10 @@ protected:
 	matrix::Vector3f _prev_wp{}; /**< Previous waypoint  (local frame). If no previous triplet is available, the prev_wp is set to current position. */
 	matrix::Vector3f _target{}; /**< Target waypoint  (local frame).*/
 	matrix::Vector3f _next_wp{}; /**< The next waypoint after target (local frame). If no next setpoint is available, next is set to target. */
+	matrix::Vector3f _lookahead_wp[mission_lookahead_s::MAX_ITEMS] {}; /**< Waypoints following _next_wp (local frame). */
+	float _lookahead_acceptance_radius[mission_lookahead_s::MAX_ITEMS] {}; /**< Acceptance radii of the lookahead waypoints. */
+	bool _lookahead_stop[mission_lookahead_s::MAX_ITEMS] {}; /**< True if the vehicle has to stop at the lookahead waypoint. */
+	int _lookahead_count{0}; /**< Number of valid lookahead waypoints, only non-zero if _next_wp is the navigator next waypoint. */
 	float _mc_cruise_speed{0.0f}; /**< Requested cruise speed. If not valid, default cruise speed is used. */
 	WaypointType _type{WaypointType::idle}; /**< Type of current target triplet. */
 
@@ -105,6 +110,7 @@ protected:
 
 	State _current_state{State::none};
 	float _target_acceptance_radius{0.0f}; /**< Acceptances radius of the target */
+	float _next_acceptance_radius{0.0f}; /**< Acceptances radius of the next waypoint, the one of the target if not available */
 	int _mission_gear{landing_gear_s::GEAR_KEEP};
 
 	float _yaw_sp_prev{NAN};
@@ -129,6 +135,7 @@ private:
 	bool _yaw_lock{false}; /**< if within acceptance radius, lock yaw to current yaw */
 
 	uORB::SubscriptionData<position_setpoint_triplet_s> _sub_triplet_setpoint{ORB_ID(position_setpoint_triplet)};
+	uORB::SubscriptionData<mission_lookahead_s> _sub_mission_lookahead{ORB_ID(mission_lookahead)};
 
 	matrix::Vector3f
 	_triplet_target; /**< current triplet from navigator which may differ from the intenal one (_target) depending on the vehicle state. */
@@ -147,6 +154,7 @@ private:
 
 	void _limitYawRate(); /**< Limits the rate of change of the yaw setpoint. */
 	bool _evaluateTriplets(); /**< Checks and sets triplets. */
+	void _evaluateLookahead(); /**< Projects the mission waypoints following the triplet into the local frame. */
 	bool _isFinite(const position_setpoint_s &sp); /**< Checks if all waypoint triplets are finite. */
 	bool _evaluateGlobalReference(); /**< Check is global reference is available. */
 	State _getCurrentState(); /**< Computes the current vehicle state based on the vehicle position and navigator triplets. */
@@ -55,6 +55,7 @@ bool FlightTaskAutoLineSmoothVel::activate(vehicle_local_position_setpoint_s las
 	}
 
 	_yaw_sp_prev = last_setpoint.yaw;
+	_corner_blend_valid = false;
 	_updateTrajConstraints();
 
 	return ret;
@@ -181,7 +182,7 @@ float FlightTaskAutoLineSmoothVel::_constrainAbsPrioritizeMin(float val, float m
 	return math::sign(val) * math::max(math::min(fabsf(val), fabsf(max)), fabsf(min));
 }
 
-float FlightTaskAutoLineSmoothVel::_getSpeedAtTarget() const
+float FlightTaskAutoLineSmoothVel::_getSpeedAtTarget()
 {
 	// Compute the maximum allowed speed at the waypoint assuming that we want to
 	// connect the two lines (prev-current and current-next)
@@ -189,32 +190,66 @@ float FlightTaskAutoLineSmoothVel::_getSpeedAtTarget() const
 	// The circle should in theory start and end at the intersection of the lines and the waypoint's acceptance radius.
 	// This is not exactly true in reality since Navigator switches the waypoint so we have to take in account that
 	// the real acceptance radius is smaller.
-	// It can be that the next waypoint is the last one or that the drone will have to stop for some other reason
-	// so we have to make sure that the speed at the current waypoint allows to stop at the next waypoint.
-	float speed_at_target = 0.0f;
-
-	const float distance_current_next = Vector2f(&(_target - _next_wp)(0)).length();
-	const bool waypoint_overlap = Vector2f(&(_target - _prev_wp)(0)).length() < _target_acceptance_radius;
+	// The same constraint is applied to all the known upcoming mission waypoints and the speed at the current
+	// waypoint has to allow braking to the speed of each of them, and to a stop at the last one.
 	const bool yaw_align_check_pass = (_param_mpc_yaw_mode.get() != 4) || _yaw_sp_aligned;
 
-	if (distance_current_next > 0.001f &&
-	    !waypoint_overlap &&
-	    yaw_align_check_pass) {
-		// Max speed between current and next
-		const float max_speed_current_next = _getMaxSpeedFromDistance(distance_current_next);
-		const float alpha = acosf(Vector2f(&(_target - _prev_wp)(0)).unit_or_zero() *
-					  Vector2f(&(_target - _next_wp)(0)).unit_or_zero());
-		// We choose a maximum centripetal acceleration of MPC_ACC_HOR * MPC_XY_TRAJ_P to take in account
-		// that there is a jerk limit (a direct transition from line to circle is not possible)
-		// MPC_XY_TRAJ_P should be between 0 and 1.
-		float accel_tmp = _param_mpc_xy_traj_p.get() * _param_mpc_acc_hor.get();
-		float max_speed_in_turn = math::trajectory::computeMaxSpeedInWaypoint(alpha,
-					  accel_tmp,
-					  _target_acceptance_radius);
-		speed_at_target = math::min(math::min(max_speed_in_turn, max_speed_current_next), _mc_cruise_speed);
+	_lookahead.reset();
+
+	if (!yaw_align_check_pass) {
+		return 0.f;
+	}
+	_lookahead.setMaxJerk(_param_mpc_jerk_auto.get());
+	_lookahead.setMaxAccel(_param_mpc_acc_hor.get());
+	_lookahead.setMaxVel(_mc_cruise_speed);
+	// We choose a maximum centripetal acceleration of MPC_ACC_HOR * MPC_XY_TRAJ_P to take in account
+	// that there is a jerk limit (a direct transition from line to circle is not possible)
+	// MPC_XY_TRAJ_P should be between 0 and 1.
+	_lookahead.setCornerAccelRatio(_param_mpc_xy_traj_p.get());
+	_lookahead.setMaxSpeedDistanceRatio(_param_mpc_xy_traj_p.get());
+	// Altitude changes are flown by stopping at the waypoint before climbing or descending
+	_lookahead.setAltitudeAcceptanceRadius(_param_nav_mc_alt_rad.get());
+
+	_lookahead.addWaypoint(_prev_wp, 0.f);
+	_lookahead.addWaypoint(_target, _target_acceptance_radius);
+
+	if (Vector2f(_target - _next_wp).length() > 0.001f) {
+		_lookahead.addWaypoint(_next_wp, _next_acceptance_radius);
+
+		for (int i = 0; i < _lookahead_count; i++) {
+			if (!_lookahead.addWaypoint(_lookahead_wp[i], _lookahead_acceptance_radius[i], _lookahead_stop[i])) {
+				break;
+			}
+		}
+	}
+
+	_lookahead.plan();
+
+	return _lookahead.getSpeedAtWaypoint(1);
+}
+
+bool FlightTaskAutoLineSmoothVel::_getCornerBlendVelocity(const Vector3f &position, Vector2f &velocity)
+{
+	Vector2f direction;
+
+	// Once Navigator switched to the next waypoint, the blend of the
+	// previous corner is still flown until the vehicle has left it
+	const bool in_previous_blend = _corner_blend_valid
+				       && Vector2f(_corner_blend_wp - _prev_wp).length() < 0.001f
+				       && WaypointLookahead::getBlendDirection(_corner_blend, position, direction);
+
+	if (!in_previous_blend) {
+		_corner_blend_valid = _lookahead.getCornerBlend(1, _corner_blend);
+		_corner_blend_wp = _target;
+		_corner_blend_speed = _lookahead.getSpeedAtWaypoint(1);
+
+		if (!_corner_blend_valid || !WaypointLookahead::getBlendDirection(_corner_blend, position, direction)) {
+			return false;
+		}
 	}
 
-	return speed_at_target;
+	velocity = direction * _corner_blend_speed;
+	return true;
 }
 
 float FlightTaskAutoLineSmoothVel::_getMaxSpeedFromDistance(float braking_distance) const
@@ -273,6 +308,7 @@ void FlightTaskAutoLineSmoothVel::_prepareSetpoints()
 			} else {
 				// The drone has to change altitude, stop at the waypoint
 				vel_min_xy.setAll(0.f);
+				_corner_blend_valid = false;
 			}
 
 			// Constrain the norm of each component using min and max values
@@ -280,6 +316,12 @@ void FlightTaskAutoLineSmoothVel::_prepareSetpoints()
 			vel_sp_constrained_xy(0) = _constrainAbsPrioritizeMin(vel_sp_xy(0), vel_min_xy(0), vel_max_xy(0));
 			vel_sp_constrained_xy(1) = _constrainAbsPrioritizeMin(vel_sp_xy(1), vel_min_xy(1), vel_max_xy(1));
 
+			// Within the corner, follow the blend connecting the two lines at the planned speed,
+			// unless the vehicle has to stop to change altitude
+			if (has_reached_altitude) {
+				_getCornerBlendVelocity(pos_traj, vel_sp_constrained_xy);
+			}
+
 			for (int i = 0; i < 2; i++) {
 				// If available, constrain the velocity using _velocity_setpoint(.)
 				if (PX4_ISFINITE(_velocity_setpoint(i))) {
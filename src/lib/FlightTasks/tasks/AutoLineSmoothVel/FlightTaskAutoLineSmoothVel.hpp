@@ -42,6 +42,7 @@
 
 #include "FlightTaskAutoMapper2.hpp"
 #include "VelocitySmoothing.hpp"
+#include "WaypointLookahead.hpp"
 
 class FlightTaskAutoLineSmoothVel : public FlightTaskAutoMapper2
 {
@@ -90,7 +91,8 @@ protected:
 	 */
 	static float _constrainAbsPrioritizeMin(float val, float min, float max);
 
-	float _getSpeedAtTarget() const;
+	float _getSpeedAtTarget();
+	bool _getCornerBlendVelocity(const matrix::Vector3f &position, matrix::Vector2f &velocity); /**< Velocity along the blend of the corner being flown. */
 	float _getMaxSpeedFromDistance(float braking_distance) const;
 
 	void _prepareSetpoints(); /**< Generate velocity target points for the trajectory generator. */
@@ -102,4 +104,9 @@ protected:
 	bool _want_takeoff{false};
 
 	VelocitySmoothing _trajectory[3]; ///< Trajectories in x, y and z directions
+	WaypointLookahead _lookahead; ///< Speed planner over the upcoming mission waypoints
+	bezier::BezierQuad_f _corner_blend; ///< Blend of the corner at the target, kept until the vehicle has left it
+	matrix::Vector3f _corner_blend_wp{}; ///< Waypoint blended by _corner_blend
+	float _corner_blend_speed{0.f}; ///< Planned speed through _corner_blend
+	bool _corner_blend_valid{false};
 };
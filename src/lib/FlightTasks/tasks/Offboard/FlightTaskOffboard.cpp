@@ -43,7 +43,31 @@ bool FlightTaskOffboard::updateInitialize()
 {
 	bool ret = FlightTask::updateInitialize();
 
-	_sub_triplet_setpoint.update();
+	const bool triplet_updated = _sub_triplet_setpoint.update();
+
+	offboard_trajectory_sample_s sample;
+
+	while (_sub_trajectory_sample.update(&sample)) {
+		_trajectory_buffer.push({sample.sample_time,
+					 Vector3f(sample.position),
+					 Vector3f(sample.velocity),
+					 Vector3f(sample.acceleration),
+					 sample.yaw});
+		_trajectory_sample_timestamp = sample.timestamp;
+	}
+
+	// A setpoint without trajectory sample ends the timestamped trajectory. The sample is
+	// published right after the triplet, so it is only missing if it did not arrive by the next update.
+	if (_triplet_without_sample_timestamp != 0 && _trajectory_sample_timestamp < _triplet_without_sample_timestamp) {
+		_trajectory_buffer.reset(_time_stamp_activate);
+	}
+
+	_triplet_without_sample_timestamp = 0;
+
+	if (triplet_updated && _trajectory_buffer.size() > 0
+	    && _trajectory_sample_timestamp < _sub_triplet_setpoint.get().timestamp) {
+		_triplet_without_sample_timestamp = _sub_triplet_setpoint.get().timestamp;
+	}
 
 	// require a valid triplet
 	ret = ret && _sub_triplet_setpoint.get().current.valid;
@@ -61,6 +85,8 @@ bool FlightTaskOffboard::activate(vehicle_local_position_setpoint_s last_setpoin
 	_position_setpoint = _position;
 	_velocity_setpoint.setZero();
 	_position_lock.setAll(NAN);
+	_trajectory_buffer.reset(_time_stamp_activate);
+	_triplet_without_sample_timestamp = 0;
 	return ret;
 }
 
@@ -93,6 +119,11 @@ bool FlightTaskOffboard::update()
 
 	}
 
+	// The timestamped trajectory only applies to position setpoints
+	if (_sub_triplet_setpoint.get().current.type != position_setpoint_s::SETPOINT_TYPE_POSITION) {
+		_trajectory_buffer.reset(_time_stamp_activate);
+	}
+
 	// Loiter
 	if (_sub_triplet_setpoint.get().current.type == position_setpoint_s::SETPOINT_TYPE_LOITER) {
 		// loiter just means that the vehicle should keep position
@@ -154,6 +185,12 @@ bool FlightTaskOffboard::update()
 		return true;
 	}
 
+	// Timestamped trajectory
+	if (_evaluateTrajectoryBuffer()) {
+		_constraints.want_takeoff = _checkTakeoff();
+		return true;
+	}
+
 	// Possible inputs:
 	// 1. position setpoint
 	// 2. position setpoint + velocity setpoint (velocity used as feedforward)
@@ -238,3 +275,28 @@ bool FlightTaskOffboard::update()
 
 	return true;
 }
+
+bool FlightTaskOffboard::_evaluateTrajectoryBuffer()
+{
+	if (!_sub_vehicle_local_position.get().xy_valid || !_sub_vehicle_local_position.get().z_valid) {
+		return false;
+	}
+
+	TrajectoryBuffer::Sample sample{};
+
+	// When the horizon expired, the buffer holds the position at the end of the extrapolation
+	// until its hold timeout, then it is empty and the triplet is used again
+	if (_trajectory_buffer.evaluate(_time_stamp_current, sample) == TrajectoryBuffer::Status::empty) {
+		return false;
+	}
+
+	_position_setpoint = sample.position;
+	_velocity_setpoint = sample.velocity;
+	_acceleration_setpoint = sample.acceleration;
+
+	if (PX4_ISFINITE(sample.yaw)) {
+		_yaw_setpoint = sample.yaw;
+	}
+
+	return true;
+}
@@ -38,6 +38,8 @@
 #pragma once
 
 #include "FlightTask.hpp"
+#include "TrajectoryBuffer.hpp"
+#include <uORB/topics/offboard_trajectory_sample.h>
 #include <uORB/topics/position_setpoint_triplet.h>
 #include <uORB/topics/position_setpoint.h>
 
@@ -53,9 +55,19 @@ public:
 
 protected:
 	uORB::SubscriptionData<position_setpoint_triplet_s> _sub_triplet_setpoint{ORB_ID(position_setpoint_triplet)};
+	uORB::Subscription _sub_trajectory_sample{ORB_ID(offboard_trajectory_sample)};
 
 private:
+	/**
+	 * Set the setpoints from the buffered timestamped trajectory.
+	 * @return true if the trajectory buffer is used
+	 */
+	bool _evaluateTrajectoryBuffer();
+
 	matrix::Vector3f _position_lock{};
+	TrajectoryBuffer _trajectory_buffer;
+	hrt_abstime _trajectory_sample_timestamp{0}; ///< publication time of the last trajectory sample
+	hrt_abstime _triplet_without_sample_timestamp{0}; ///< triplet not yet followed by a trajectory sample, 0 if none
 
 	DEFINE_PARAMETERS_CUSTOM_PARENT(FlightTask,
 					(ParamFloat<px4::params::MPC_LAND_SPEED>) _param_mpc_land_speed,
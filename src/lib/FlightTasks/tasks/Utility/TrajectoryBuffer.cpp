@@ -0,0 +1,215 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file TrajectoryBuffer.cpp
+ */
+
+#include "TrajectoryBuffer.hpp"
+
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+using namespace matrix;
+
+bool TrajectoryBuffer::push(const Sample &sample)
+{
+	if (sample.time_us == 0 || sample.time_us < _start_us) {
+		return false;
+	}
+
+	// The first sample is the one the vehicle is currently flying from, anything older is useless
+	if (_count > 0 && sample.time_us < _samples[0].time_us && _samples[0].time_us <= _last_evaluation_us) {
+		return false;
+	}
+
+	// Find the insertion index, keeping the samples sorted by time
+	int index = _count;
+
+	while (index > 0 && _samples[index - 1].time_us > sample.time_us) {
+		index--;
+	}
+
+	// A sample for the same time supersedes the buffered one
+	int replace = -1;
+
+	if (index > 0 && sample.time_us - _samples[index - 1].time_us < SAME_TIME_TOLERANCE_US) {
+		replace = index - 1;
+
+	} else if (index < _count && _samples[index].time_us - sample.time_us < SAME_TIME_TOLERANCE_US) {
+		replace = index;
+	}
+
+	if (replace >= 0) {
+		_samples[replace] = sample;
+		_holding = _holding && replace > 0;
+		return true;
+	}
+
+	if (_count == CAPACITY) {
+		if (index == 0) {
+			// older than everything in a full buffer
+			return false;
+		}
+
+		_dropFront(1);
+		index--;
+	}
+
+	for (int i = _count; i > index; i--) {
+		_samples[i] = _samples[i - 1];
+	}
+
+	_samples[index] = sample;
+	_count++;
+
+	return true;
+}
+
+TrajectoryBuffer::Status TrajectoryBuffer::evaluate(uint64_t time_us, Sample &out)
+{
+	_last_evaluation_us = time_us;
+
+	if (_count == 0) {
+		_holding = false;
+		return Status::empty;
+	}
+
+	// Only keep the last sample before the requested time
+	int first_needed = 0;
+
+	while (first_needed < _count - 1 && _samples[first_needed + 1].time_us <= time_us) {
+		first_needed++;
+	}
+
+	_dropFront(first_needed);
+
+	const Sample &first = _samples[0];
+
+	if (time_us <= first.time_us) {
+		// Horizon starts in the future: fly to the first sample
+		out = first;
+		out.time_us = time_us;
+		return Status::interpolating;
+	}
+
+	if (_count > 1) {
+		_holding = false;
+		out = interpolate(_samples[0], _samples[1], time_us);
+		return Status::interpolating;
+	}
+
+	// The horizon ran out
+	const uint64_t time_since_last = time_us - first.time_us;
+
+	if (!_holding && time_since_last <= _extrapolation_timeout_us) {
+		const float dt = time_since_last * 1e-6f;
+		out = first;
+		out.time_us = time_us;
+		out.position = first.position + first.velocity * dt;
+		out.acceleration.setZero();
+		return Status::extrapolating;
+	}
+
+	// Replace the last sample by the hold state such that new samples connect to it
+	Sample &hold = _samples[0];
+
+	if (!_holding) {
+		hold.position = hold.position + hold.velocity * (_extrapolation_timeout_us * 1e-6f);
+		hold.velocity.setZero();
+		hold.acceleration.setZero();
+		_holding = true;
+		_hold_start_us = time_us;
+
+	} else if (time_us - _hold_start_us > _hold_timeout_us) {
+		// the sender stopped streaming, give control back to the other setpoints
+		reset(_start_us);
+		return Status::empty;
+	}
+
+	hold.time_us = time_us;
+	out = hold;
+
+	return Status::expired;
+}
+
+TrajectoryBuffer::Sample TrajectoryBuffer::interpolate(const Sample &a, const Sample &b, uint64_t time_us)
+{
+	Sample out{};
+	out.time_us = time_us;
+
+	const float T = (b.time_us - a.time_us) * 1e-6f;
+	const float s = math::constrain((float)(time_us - a.time_us) * 1e-6f / T, 0.f, 1.f);
+	const float s2 = s * s;
+	const float s3 = s2 * s;
+
+	// Cubic Hermite basis and derivatives
+	const float h00 = 2.f * s3 - 3.f * s2 + 1.f;
+	const float h10 = s3 - 2.f * s2 + s;
+	const float h01 = -2.f * s3 + 3.f * s2;
+	const float h11 = s3 - s2;
+
+	const float dh00 = 6.f * s2 - 6.f * s;
+	const float dh10 = 3.f * s2 - 4.f * s + 1.f;
+	const float dh01 = -6.f * s2 + 6.f * s;
+	const float dh11 = 3.f * s2 - 2.f * s;
+
+	out.position = a.position * h00 + a.velocity * (h10 * T) + b.position * h01 + b.velocity * (h11 * T);
+	out.velocity = (a.position * dh00 + b.position * dh01) / T + a.velocity * dh10 + b.velocity * dh11;
+	out.acceleration = a.acceleration * (1.f - s) + b.acceleration * s;
+
+	if (PX4_ISFINITE(a.yaw) && PX4_ISFINITE(b.yaw)) {
+		out.yaw = wrap_pi(a.yaw + wrap_pi(b.yaw - a.yaw) * s);
+
+	} else {
+		out.yaw = PX4_ISFINITE(b.yaw) ? b.yaw : a.yaw;
+	}
+
+	return out;
+}
+
+void TrajectoryBuffer::_dropFront(int n)
+{
+	if (n <= 0) {
+		return;
+	}
+
+	for (int i = n; i < _count; i++) {
+		_samples[i - n] = _samples[i];
+	}
+
+	_count -= n;
+
+	// the hold state is always the first sample
+	_holding = false;
+}
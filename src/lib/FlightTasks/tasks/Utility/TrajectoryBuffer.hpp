@@ -0,0 +1,124 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file TrajectoryBuffer.hpp
+ *
+ * Buffer of timestamped future trajectory samples (position, velocity, acceleration)
+ * that can be evaluated at any time in between the samples.
+ *
+ * Position and velocity are interpolated with a cubic Hermite spline, acceleration
+ * and yaw linearly. Samples can arrive out of order; a sample with the same time as
+ * an already buffered one replaces it.
+ *
+ * When the horizon runs out, the last sample is extrapolated with constant velocity
+ * during the extrapolation timeout. After that, the position at the end of the
+ * extrapolation is held with zero velocity and acceleration during the hold timeout,
+ * after which the buffer is emptied.
+ */
+
+#pragma once
+
+#include <matrix/math.hpp>
+#include <stdint.h>
+
+class TrajectoryBuffer
+{
+public:
+	static constexpr int CAPACITY = 32;
+
+	struct Sample {
+		uint64_t time_us; ///< time at which the state should be reached [us]
+		matrix::Vector3f position;
+		matrix::Vector3f velocity;
+		matrix::Vector3f acceleration;
+		float yaw;
+	};
+
+	enum class Status {
+		empty, ///< no sample received
+		interpolating, ///< the requested time is covered by the buffered horizon
+		extrapolating, ///< the horizon ran out, extrapolating the last sample
+		expired ///< the horizon ran out longer than the extrapolation timeout ago, holding position
+	};
+
+	TrajectoryBuffer() = default;
+	~TrajectoryBuffer() = default;
+
+	/**
+	 * Empty the buffer
+	 * @param start_us samples for an earlier time are rejected from now on [us]
+	 */
+	void reset(uint64_t start_us = 0) { _count = 0; _holding = false; _start_us = start_us; }
+
+	/**
+	 * Insert a sample. Samples that are already in the past of the buffered horizon
+	 * or before the start time of the last reset are rejected.
+	 * @return true if the sample was inserted
+	 */
+	bool push(const Sample &sample);
+
+	/**
+	 * Evaluate the trajectory at a given time and drop the samples that are not needed anymore.
+	 * @param time_us time at which the trajectory is evaluated [us]
+	 * @param out resulting state, only written if the buffer is not empty
+	 * @return status of the evaluation
+	 */
+	Status evaluate(uint64_t time_us, Sample &out);
+
+	int size() const { return _count; }
+
+	/**
+	 * @return time of the last buffered sample, 0 if empty
+	 */
+	uint64_t getHorizonEnd() const { return _count > 0 ? _samples[_count - 1].time_us : 0; }
+
+	void setExtrapolationTimeout(float timeout_s) { _extrapolation_timeout_us = (uint64_t)(timeout_s * 1e6f); }
+	void setHoldTimeout(float timeout_s) { _hold_timeout_us = (uint64_t)(timeout_s * 1e6f); }
+
+	static Sample interpolate(const Sample &a, const Sample &b, uint64_t time_us);
+
+private:
+	void _dropFront(int n);
+
+	static constexpr uint64_t SAME_TIME_TOLERANCE_US = 1000;
+
+	Sample _samples[CAPACITY] {};
+	int _count{0};
+	uint64_t _last_evaluation_us{0};
+	uint64_t _start_us{0};
+	bool _holding{false}; ///< horizon expired, _samples[0] is the hold state
+	uint64_t _hold_start_us{0};
+	uint64_t _extrapolation_timeout_us{300000};
+	uint64_t _hold_timeout_us{1000000};
+};
@@ -0,0 +1,272 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Test code for the Trajectory Buffer library
+ * Run this test only using make tests TESTFILTER=TrajectoryBuffer
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/matrix/math.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "TrajectoryBuffer.hpp"
+
+using namespace matrix;
+
+class TrajectoryBufferTest : public ::testing::Test
+{
+public:
+	/** Circular reference trajectory sent by the companion computer */
+	static TrajectoryBuffer::Sample reference(uint64_t time_us)
+	{
+		const float radius = 5.f;
+		const float omega = 0.5f;
+		const float t = time_us * 1e-6f;
+
+		TrajectoryBuffer::Sample sample{};
+		sample.time_us = time_us;
+		sample.position = Vector3f(radius * cosf(omega * t), radius * sinf(omega * t), -5.f);
+		sample.velocity = Vector3f(-radius * omega * sinf(omega * t), radius * omega * cosf(omega * t), 0.f);
+		sample.acceleration = Vector3f(-radius * omega * omega * cosf(omega * t), -radius * omega * omega * sinf(omega * t), 0.f);
+		sample.yaw = NAN;
+		return sample;
+	}
+
+	/** Deterministic pseudo random number in [0, 1) */
+	float random()
+	{
+		_seed = 1103515245u * _seed + 12345u;
+		return (float)((_seed >> 8) & 0xFFFF) / 65536.f;
+	}
+
+	struct Message {
+		uint64_t arrival_us;
+		TrajectoryBuffer::Sample sample;
+	};
+
+	TrajectoryBuffer _buffer;
+	uint32_t _seed{12345};
+};
+
+TEST_F(TrajectoryBufferTest, emptyBuffer)
+{
+	TrajectoryBuffer::Sample out{};
+	EXPECT_EQ(_buffer.evaluate(1000000, out), TrajectoryBuffer::Status::empty);
+}
+
+TEST_F(TrajectoryBufferTest, interpolationIsExactOnSamples)
+{
+	// GIVEN: two samples
+	_buffer.push(reference(1000000));
+	_buffer.push(reference(1100000));
+
+	// WHEN: we evaluate the buffer at the sample times
+	TrajectoryBuffer::Sample out{};
+	EXPECT_EQ(_buffer.evaluate(1000000, out), TrajectoryBuffer::Status::interpolating);
+
+	// THEN: we get the samples back
+	EXPECT_LT((out.position - reference(1000000).position).norm(), 1e-4f);
+	EXPECT_LT((out.velocity - reference(1000000).velocity).norm(), 1e-4f);
+
+	EXPECT_EQ(_buffer.evaluate(1050000, out), TrajectoryBuffer::Status::interpolating);
+	EXPECT_LT((out.position - reference(1050000).position).norm(), 1e-3f);
+	EXPECT_LT((out.velocity - reference(1050000).velocity).norm(), 1e-2f);
+}
+
+TEST_F(TrajectoryBufferTest, outOfOrderAndDuplicates)
+{
+	// GIVEN: samples arriving out of order, one of them twice
+	_buffer.push(reference(1300000));
+	_buffer.push(reference(1100000));
+	_buffer.push(reference(1200000));
+	_buffer.push(reference(1100000));
+
+	// THEN: they are sorted and not duplicated
+	EXPECT_EQ(_buffer.size(), 3);
+	EXPECT_EQ(_buffer.getHorizonEnd(), 1300000u);
+
+	// WHEN: we evaluate after the second sample
+	TrajectoryBuffer::Sample out{};
+	_buffer.evaluate(1250000, out);
+
+	// THEN: the first sample is dropped and older samples are rejected
+	EXPECT_EQ(_buffer.size(), 2);
+	EXPECT_FALSE(_buffer.push(reference(1100000)));
+}
+
+TEST_F(TrajectoryBufferTest, horizonRunsOut)
+{
+	// GIVEN: a short horizon of a vehicle moving along the circle
+	_buffer.setExtrapolationTimeout(0.3f);
+	_buffer.setHoldTimeout(2.f);
+	_buffer.push(reference(1000000));
+	_buffer.push(reference(1100000));
+	const TrajectoryBuffer::Sample last = reference(1100000);
+
+	// WHEN: the horizon runs out
+	TrajectoryBuffer::Sample out{};
+	EXPECT_EQ(_buffer.evaluate(1200000, out), TrajectoryBuffer::Status::extrapolating);
+
+	// THEN: the last sample is extrapolated with constant velocity
+	EXPECT_LT((out.position - (last.position + last.velocity * 0.1f)).norm(), 1e-4f);
+	EXPECT_LT((out.velocity - last.velocity).norm(), 1e-4f);
+
+	// AND: after the timeout the position is held
+	EXPECT_EQ(_buffer.evaluate(1500000, out), TrajectoryBuffer::Status::expired);
+	const Vector3f hold = last.position + last.velocity * 0.3f;
+	EXPECT_LT((out.position - hold).norm(), 1e-4f);
+	EXPECT_LT(out.velocity.norm(), 1e-6f);
+
+	EXPECT_EQ(_buffer.evaluate(3000000, out), TrajectoryBuffer::Status::expired);
+	EXPECT_LT((out.position - hold).norm(), 1e-4f);
+
+	// AND: a new horizon connects to the hold position
+	TrajectoryBuffer::Sample resume = reference(3500000);
+	_buffer.push(resume);
+	EXPECT_EQ(_buffer.evaluate(3000000, out), TrajectoryBuffer::Status::interpolating);
+	EXPECT_LT((out.position - hold).norm(), 1e-4f);
+	EXPECT_EQ(_buffer.evaluate(3500000, out), TrajectoryBuffer::Status::interpolating);
+	EXPECT_LT((out.position - resume.position).norm(), 1e-4f);
+	EXPECT_EQ(_buffer.evaluate(3600000, out), TrajectoryBuffer::Status::extrapolating);
+}
+
+TEST_F(TrajectoryBufferTest, holdTimeout)
+{
+	// GIVEN: a horizon that ran out
+	_buffer.setExtrapolationTimeout(0.3f);
+	_buffer.setHoldTimeout(1.f);
+	_buffer.push(reference(1000000));
+	_buffer.push(reference(1100000));
+
+	TrajectoryBuffer::Sample out{};
+	EXPECT_EQ(_buffer.evaluate(1500000, out), TrajectoryBuffer::Status::expired);
+	EXPECT_EQ(_buffer.evaluate(2500000, out), TrajectoryBuffer::Status::expired);
+
+	// WHEN: no new sample arrives during the hold timeout
+	// THEN: the buffer is emptied
+	EXPECT_EQ(_buffer.evaluate(2600000, out), TrajectoryBuffer::Status::empty);
+	EXPECT_EQ(_buffer.size(), 0);
+}
+
+TEST_F(TrajectoryBufferTest, rejectBeforeStart)
+{
+	// GIVEN: a buffer reset on activation
+	_buffer.reset(2000000);
+
+	// WHEN: samples of a horizon sent before the activation arrive
+	// THEN: they are rejected
+	EXPECT_FALSE(_buffer.push(reference(1900000)));
+	EXPECT_EQ(_buffer.size(), 0);
+
+	// AND: samples for later are accepted
+	EXPECT_TRUE(_buffer.push(reference(2100000)));
+	EXPECT_EQ(_buffer.size(), 1);
+}
+
+TEST_F(TrajectoryBufferTest, jitteredLossyStream)
+{
+	// GIVEN: a companion computer sending every 100ms a horizon of 10 samples spaced by 100ms
+	// over a link with 20 to 100ms latency and 20% message loss
+	std::vector<Message> horizon_messages;
+	std::vector<Message> setpoint_messages;
+
+	for (uint64_t send_us = 0; send_us < 20000000; send_us += 100000) {
+		for (int k = 1; k <= 10; k++) {
+			const float delay = 20000.f + 80000.f * random();
+
+			if (random() > 0.2f) {
+				horizon_messages.push_back({send_us + (uint64_t)delay, reference(send_us + k * 100000)});
+			}
+		}
+
+		// AND: for comparison, the current setpoint over the same link (triplet behavior)
+		const float delay = 20000.f + 80000.f * random();
+
+		if (random() > 0.2f) {
+			setpoint_messages.push_back({send_us + (uint64_t)delay, reference(send_us)});
+		}
+	}
+
+	auto by_arrival = [](const Message & a, const Message & b) { return a.arrival_us < b.arrival_us; };
+	std::sort(horizon_messages.begin(), horizon_messages.end(), by_arrival);
+	std::sort(setpoint_messages.begin(), setpoint_messages.end(), by_arrival);
+
+	// WHEN: the controller runs at 250Hz
+	size_t horizon_index = 0;
+	size_t setpoint_index = 0;
+	Vector3f last_setpoint = reference(0).position;
+	float error_buffer_squared = 0.f;
+	float error_setpoint_squared = 0.f;
+	float error_buffer_max = 0.f;
+	int n = 0;
+
+	for (uint64_t now = 0; now < 20000000; now += 4000) {
+		while (horizon_index < horizon_messages.size() && horizon_messages[horizon_index].arrival_us <= now) {
+			_buffer.push(horizon_messages[horizon_index++].sample);
+		}
+
+		while (setpoint_index < setpoint_messages.size() && setpoint_messages[setpoint_index].arrival_us <= now) {
+			last_setpoint = setpoint_messages[setpoint_index++].sample.position;
+		}
+
+		TrajectoryBuffer::Sample out{};
+		const TrajectoryBuffer::Status status = _buffer.evaluate(now, out);
+
+		if (now < 1000000) {
+			// startup
+			continue;
+		}
+
+		EXPECT_EQ(status, TrajectoryBuffer::Status::interpolating);
+
+		const Vector3f truth = reference(now).position;
+		const float error_buffer = (out.position - truth).norm();
+		const float error_setpoint = (last_setpoint - truth).norm();
+		error_buffer_squared += error_buffer * error_buffer;
+		error_setpoint_squared += error_setpoint * error_setpoint;
+		error_buffer_max = fmaxf(error_buffer_max, error_buffer);
+		n++;
+	}
+
+	const float rms_buffer = sqrtf(error_buffer_squared / n);
+	const float rms_setpoint = sqrtf(error_setpoint_squared / n);
+
+	// THEN: the interpolated trajectory is independent of the link latency
+	EXPECT_LT(rms_buffer, 0.01f);
+	EXPECT_LT(error_buffer_max, 0.05f);
+	EXPECT_GT(rms_setpoint, 0.1f);
+	EXPECT_LT(rms_buffer * 10.f, rms_setpoint);
+}
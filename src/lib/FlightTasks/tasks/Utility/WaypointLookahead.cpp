@@ -0,0 +1,260 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file WaypointLookahead.cpp
+ */
+
+#include "WaypointLookahead.hpp"
+
+#include <float.h>
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+using namespace matrix;
+
+bool WaypointLookahead::addWaypoint(const Vector3f &position, float acceptance_radius, bool stop)
+{
+	if (_num_waypoints >= MAX_WAYPOINTS) {
+		return false;
+	}
+
+	Waypoint &wp = _waypoints[_num_waypoints++];
+	wp.position = position;
+	wp.acceptance_radius = PX4_ISFINITE(acceptance_radius) ? math::max(acceptance_radius, 0.f) : 0.f;
+	wp.stop = stop;
+
+	return true;
+}
+
+void WaypointLookahead::plan()
+{
+	// Corner constraints
+	for (int i = 0; i < _num_waypoints; i++) {
+		_corner_speed[i] = 0.f;
+
+		if (i == 0 || i == _num_waypoints - 1 || _waypoints[i].stop) {
+			continue;
+		}
+
+		// The altitude is changed before the vehicle continues to the next waypoint
+		if (fabsf(_waypoints[i + 1].position(2) - _waypoints[i].position(2)) > _altitude_acceptance_radius) {
+			continue;
+		}
+
+		const float acceptance_radius = _waypoints[i].acceptance_radius;
+		const float length_prev = _segmentLengthXY(i - 1);
+		const float length_next = _segmentLengthXY(i);
+
+		// Overlapping waypoints can't be connected with a turn
+		if (length_prev < acceptance_radius || length_next < 0.001f) {
+			continue;
+		}
+
+		const Vector2f u_to_prev = Vector2f(_waypoints[i - 1].position - _waypoints[i].position).unit_or_zero();
+		const Vector2f u_to_next = Vector2f(_waypoints[i + 1].position - _waypoints[i].position).unit_or_zero();
+		const float alpha = acosf(math::constrain(u_to_prev * u_to_next, -1.f, 1.f));
+
+		// The centripetal acceleration is only a fraction of the maximum acceleration
+		// since a direct transition from line to circle is not possible with a jerk limit
+		float speed_in_turn = _max_vel;
+
+		if (alpha < M_PI_F - 0.001f) {
+			speed_in_turn = math::trajectory::computeMaxSpeedInWaypoint(alpha,
+					_corner_accel_ratio * _max_accel,
+					acceptance_radius);
+		}
+
+		_corner_speed[i] = math::min(speed_in_turn, _max_vel);
+	}
+
+	// Backward pass: each waypoint has to allow braking to the speed of all the following ones
+	// in the horizon, the last waypoint of the horizon being treated as a stop.
+	for (int i = 0; i < _num_waypoints; i++) {
+		int last = _num_waypoints - 1;
+
+		if (_horizon > 0) {
+			last = math::min(last, i + _horizon);
+		}
+
+		float speed = 0.f;
+
+		for (int k = last - 1; k >= i; k--) {
+			const float distance = _segmentLengthXY(k) + computeBrakingDistance(speed);
+			speed = math::min(_corner_speed[k], computeMaxSpeedFromDistance(distance));
+		}
+
+		_speed[i] = speed;
+	}
+}
+
+float WaypointLookahead::getSpeedAtWaypoint(int i) const
+{
+	return (i >= 0 && i < _num_waypoints) ? _speed[i] : 0.f;
+}
+
+float WaypointLookahead::getCornerSpeed(int i) const
+{
+	return (i >= 0 && i < _num_waypoints) ? _corner_speed[i] : 0.f;
+}
+
+bool WaypointLookahead::getCornerBlend(int i, bezier::BezierQuad_f &blend) const
+{
+	const float radius = _blendRadius(i);
+
+	if (radius < FLT_EPSILON) {
+		return false;
+	}
+
+	const Vector3f &corner = _waypoints[i].position;
+	const Vector3f u_in = (corner - _waypoints[i - 1].position).unit_or_zero();
+	const Vector3f u_out = (_waypoints[i + 1].position - corner).unit_or_zero();
+
+	blend.setBezier(corner - u_in * radius, corner, corner + u_out * radius);
+
+	if (_speed[i] > FLT_EPSILON) {
+		blend.setDuration(blend.getArcLength(0.05f) / _speed[i]);
+	}
+
+	return true;
+}
+
+bool WaypointLookahead::getBlendDirection(bezier::BezierQuad_f &blend, const Vector3f &position, Vector2f &direction)
+{
+	// The control point of the blend is the corner
+	const Vector3f corner = blend.getCtrl();
+	const float radius = Vector2f(blend.getPt0() - corner).length();
+
+	if (radius < FLT_EPSILON || Vector2f(position - corner).length() > radius) {
+		return false;
+	}
+
+	Vector3f point;
+	Vector3f velocity;
+	Vector3f acceleration;
+	blend.getStatesClosest(point, velocity, acceleration, Vector3f(position(0), position(1), corner(2)));
+	direction = Vector2f(velocity).unit_or_zero();
+
+	return direction.length() > FLT_EPSILON;
+}
+
+float WaypointLookahead::estimateTraversalTime(float initial_speed) const
+{
+	float total_time = 0.f;
+	float speed = math::max(initial_speed, 0.f);
+
+	for (int k = 0; k < _num_waypoints - 1; k++) {
+		// Straight part of the segment in between the corner blends
+		const float blend_start = _blendRadius(k);
+		const float blend_end = _blendRadius(k + 1);
+		const float length = math::max(_segmentLengthXY(k) - blend_start - blend_end, 0.f);
+
+		const float reachable_speed = computeMaxSpeedFromDistance(length + computeBrakingDistance(speed));
+		const float speed_end = math::min(_speed[k + 1], reachable_speed);
+
+		total_time += _segmentTime(length, speed, speed_end);
+
+		// Corner blend flown at constant speed
+		bezier::BezierQuad_f blend;
+
+		if (speed_end > FLT_EPSILON && getCornerBlend(k + 1, blend)) {
+			total_time += blend.getArcLength(0.05f) / speed_end;
+		}
+
+		speed = speed_end;
+	}
+
+	return total_time;
+}
+
+float WaypointLookahead::computeMaxSpeedFromDistance(float braking_distance) const
+{
+	float max_speed = math::trajectory::computeMaxSpeedFromBrakingDistance(_max_jerk, _max_accel,
+			  math::max(braking_distance, 0.f));
+	// To avoid high gain at low distance due to the sqrt, we take the minimum
+	// of this velocity and a slope of "ratio" m/s per meter
+	max_speed = math::min(max_speed, braking_distance * _max_speed_distance_ratio);
+
+	return math::constrain(max_speed, 0.f, _max_vel);
+}
+
+float WaypointLookahead::computeBrakingDistance(float speed) const
+{
+	if (speed < FLT_EPSILON) {
+		return 0.f;
+	}
+
+	// Invert 0 = vel^2 - 2*accel*(x - vel*2*accel/jerk), see computeMaxSpeedFromBrakingDistance
+	const float distance = speed * speed / (2.f * _max_accel) + 2.f * _max_accel * speed / _max_jerk;
+
+	if (_max_speed_distance_ratio > FLT_EPSILON) {
+		return math::max(distance, speed / _max_speed_distance_ratio);
+	}
+
+	return distance;
+}
+
+float WaypointLookahead::_segmentLengthXY(int i) const
+{
+	return Vector2f(_waypoints[i + 1].position - _waypoints[i].position).length();
+}
+
+float WaypointLookahead::_segmentTime(float length, float v_start, float v_end) const
+{
+	// Trapezoidal velocity profile: accelerate, cruise and decelerate
+	const float accel = _max_accel;
+	float v_peak = math::min(_max_vel, sqrtf(accel * length + 0.5f * (v_start * v_start + v_end * v_end)));
+	v_peak = math::max(v_peak, math::max(v_start, v_end));
+
+	if (v_peak < FLT_EPSILON) {
+		return 0.f;
+	}
+
+	const float length_accel = (v_peak * v_peak - v_start * v_start) / (2.f * accel);
+	const float length_decel = (v_peak * v_peak - v_end * v_end) / (2.f * accel);
+	const float length_cruise = math::max(length - length_accel - length_decel, 0.f);
+
+	return (v_peak - v_start) / accel + (v_peak - v_end) / accel + length_cruise / v_peak;
+}
+
+float WaypointLookahead::_blendRadius(int i) const
+{
+	if (i <= 0 || i >= _num_waypoints - 1 || _speed[i] < FLT_EPSILON) {
+		return 0.f;
+	}
+
+	// The blend starts and ends within the acceptance radius and never
+	// uses more than half of the adjacent segments
+	return math::min(_waypoints[i].acceptance_radius,
+			 math::min(0.5f * _segmentLengthXY(i - 1), 0.5f * _segmentLengthXY(i)));
+}
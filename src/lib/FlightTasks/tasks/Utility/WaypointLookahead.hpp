@@ -0,0 +1,173 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file WaypointLookahead.hpp
+ *
+ * Horizontal speed planner over a sequence of upcoming waypoints.
+ *
+ * For every waypoint the planner computes the maximum speed at which it can be
+ * passed such that:
+ * - the corner can be flown on a circle that stays within the acceptance radius
+ *   with the given centripetal acceleration,
+ * - the vehicle stops before an altitude change, which is flown like a stop waypoint,
+ * - the vehicle is still able to slow down to the planned speed of all the
+ *   following waypoints (jerk-limited braking distance), and to stop at the
+ *   last known waypoint of the horizon.
+ *
+ * The corners are blended with a quadratic bezier spline bounded by the
+ * acceptance radius, which is used to time-parameterise the path and gives
+ * the direction of travel while flying through the corner.
+ */
+
+#pragma once
+
+#include <matrix/math.hpp>
+#include <lib/bezier/BezierQuad.hpp>
+
+class WaypointLookahead
+{
+public:
+	static constexpr int MAX_WAYPOINTS = 8;
+
+	WaypointLookahead() = default;
+	~WaypointLookahead() = default;
+
+	/**
+	 * Remove all waypoints. Has to be followed by addWaypoint() and plan().
+	 */
+	void reset() { _num_waypoints = 0; }
+
+	/**
+	 * Append a waypoint to the sequence. The first waypoint is the start of the path
+	 * (usually the previous waypoint or the vehicle position).
+	 * @param position waypoint position in local frame [m]
+	 * @param acceptance_radius horizontal acceptance radius of the waypoint [m]
+	 * @param stop true if the vehicle has to stop at this waypoint
+	 * @return false if the waypoint could not be added (sequence full)
+	 */
+	bool addWaypoint(const matrix::Vector3f &position, float acceptance_radius, bool stop = false);
+
+	int getNumWaypoints() const { return _num_waypoints; }
+
+	/**
+	 * Compute the maximum speed at each waypoint of the sequence
+	 */
+	void plan();
+
+	/**
+	 * @return the maximum horizontal speed at which waypoint i can be passed [m/s]
+	 */
+	float getSpeedAtWaypoint(int i) const;
+
+	/**
+	 * @return the maximum horizontal speed allowed by the corner geometry of waypoint i [m/s]
+	 */
+	float getCornerSpeed(int i) const;
+
+	/**
+	 * Get the bezier spline blending the corner at waypoint i. The spline starts and ends
+	 * on the adjacent segments within the acceptance radius and is time-parameterised with
+	 * the planned speed at the waypoint.
+	 * @return false if waypoint i is not a corner (first, last, stop waypoint or altitude change)
+	 */
+	bool getCornerBlend(int i, bezier::BezierQuad_f &blend) const;
+
+	/**
+	 * Get the horizontal direction of travel along a corner blend at the point closest to a position.
+	 * @param blend corner blend from getCornerBlend()
+	 * @param position current position of the trajectory [m]
+	 * @param direction unit vector tangent to the blend
+	 * @return false if the position is not within the blend radius of the corner
+	 */
+	static bool getBlendDirection(bezier::BezierQuad_f &blend, const matrix::Vector3f &position,
+				      matrix::Vector2f &direction);
+
+	/**
+	 * Estimate the time needed to fly the whole sequence with the planned speeds.
+	 * @param initial_speed horizontal speed at the first waypoint [m/s]
+	 * @return traversal time [s]
+	 */
+	float estimateTraversalTime(float initial_speed = 0.f) const;
+
+	/**
+	 * Limit the number of waypoints taken into account after each waypoint.
+	 * A horizon of 1 only considers the next waypoint and assumes a stop there.
+	 * @param horizon number of waypoints to look ahead, 0 for unlimited
+	 */
+	void setHorizon(int horizon) { _horizon = horizon; }
+
+	void setMaxJerk(float max_jerk) { _max_jerk = max_jerk; }
+	void setMaxAccel(float max_accel) { _max_accel = max_accel; }
+	void setMaxVel(float max_vel) { _max_vel = max_vel; }
+	/** Fraction of the maximum acceleration usable as centripetal acceleration in corners */
+	void setCornerAccelRatio(float ratio) { _corner_accel_ratio = ratio; }
+	/** Maximum ratio between speed and distance to a stop, avoids high gains close to the waypoint [1/s] */
+	void setMaxSpeedDistanceRatio(float ratio) { _max_speed_distance_ratio = ratio; }
+	/** Altitude difference to the next waypoint above which the vehicle stops at a waypoint [m] */
+	void setAltitudeAcceptanceRadius(float radius) { _altitude_acceptance_radius = radius; }
+
+	/**
+	 * @return the maximum speed from which the vehicle can brake to a stop within the given distance
+	 */
+	float computeMaxSpeedFromDistance(float braking_distance) const;
+
+	/**
+	 * @return the distance needed to brake from the given speed to a stop (inverse of computeMaxSpeedFromDistance)
+	 */
+	float computeBrakingDistance(float speed) const;
+
+private:
+	float _segmentLengthXY(int i) const;
+	float _segmentTime(float length, float v_start, float v_end) const;
+	float _blendRadius(int i) const;
+
+	struct Waypoint {
+		matrix::Vector3f position;
+		float acceptance_radius;
+		bool stop;
+	};
+
+	Waypoint _waypoints[MAX_WAYPOINTS] {};
+	float _corner_speed[MAX_WAYPOINTS] {};
+	float _speed[MAX_WAYPOINTS] {};
+	int _num_waypoints{0};
+	int _horizon{0};
+
+	float _max_jerk{8.f};
+	float _max_accel{3.f};
+	float _max_vel{5.f};
+	float _corner_accel_ratio{0.5f};
+	float _max_speed_distance_ratio{1.f};
+	float _altitude_acceptance_radius{INFINITY};
+};
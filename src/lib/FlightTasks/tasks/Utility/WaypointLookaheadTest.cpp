@@ -0,0 +1,433 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Test code for the Waypoint Lookahead library
+ * Run this test only using make tests TESTFILTER=WaypointLookahead
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/matrix/math.hpp>
+#include <mathlib/mathlib.h>
+
+#include "WaypointLookahead.hpp"
+#include "VelocitySmoothing.hpp"
+
+using namespace matrix;
+
+namespace
+{
+static constexpr float MAX_JERK = 8.f;
+static constexpr float MAX_ACCEL = 3.f;
+static constexpr float CRUISE_SPEED = 8.f;
+static constexpr float TRAJ_P = 0.5f; // MPC_XY_TRAJ_P
+static constexpr float ACCEPTANCE_RADIUS = 2.f;
+static constexpr int SURVEY_SIZE = 8;
+
+static const Vector3f SURVEY[SURVEY_SIZE] = {
+	Vector3f(0.f, 0.f, -10.f),
+	Vector3f(10.f, 0.f, -10.f),
+	Vector3f(20.f, 0.f, -10.f),
+	Vector3f(30.f, 0.f, -10.f),
+	Vector3f(40.f, 0.f, -10.f),
+	Vector3f(40.f, 10.f, -10.f),
+	Vector3f(30.f, 10.f, -10.f),
+	Vector3f(20.f, 10.f, -10.f)
+};
+
+float constrainAbsPrioritizeMin(float val, float min, float max)
+{
+	return math::sign(val) * math::max(math::min(fabsf(val), fabsf(max)), fabsf(min));
+}
+
+/**
+ * Speed at the target as computed by FlightTaskAutoLineSmoothVel from the triplet only
+ */
+float tripletSpeedAtTarget(const WaypointLookahead &planner, int target)
+{
+	const Vector3f &prev = SURVEY[target - 1];
+	const Vector3f &current = SURVEY[target];
+	const Vector3f &next = SURVEY[math::min(target + 1, SURVEY_SIZE - 1)];
+
+	const float distance_current_next = Vector2f(current - next).length();
+	const bool waypoint_overlap = Vector2f(current - prev).length() < ACCEPTANCE_RADIUS;
+
+	if (distance_current_next < 0.001f || waypoint_overlap) {
+		return 0.f;
+	}
+
+	const float alpha = acosf(Vector2f(current - prev).unit_or_zero() * Vector2f(current - next).unit_or_zero());
+	const float max_speed_in_turn = math::trajectory::computeMaxSpeedInWaypoint(alpha, TRAJ_P * MAX_ACCEL,
+					ACCEPTANCE_RADIUS);
+
+	return math::min(math::min(max_speed_in_turn, planner.computeMaxSpeedFromDistance(distance_current_next)),
+			 CRUISE_SPEED);
+}
+
+/**
+ * Fly the survey pattern with the trajectory generation of FlightTaskAutoLineSmoothVel,
+ * switching to the next waypoint within the acceptance radius like Navigator does.
+ * @param lookahead plan the speed at the target over the whole pattern instead of the triplet only
+ * @return time needed to reach the last waypoint [s]
+ */
+float flySurvey(bool lookahead)
+{
+	WaypointLookahead planner;
+	planner.setMaxJerk(MAX_JERK);
+	planner.setMaxAccel(MAX_ACCEL);
+	planner.setMaxVel(CRUISE_SPEED);
+	planner.setCornerAccelRatio(TRAJ_P);
+	planner.setMaxSpeedDistanceRatio(TRAJ_P);
+
+	VelocitySmoothing trajectory[2];
+
+	for (int i = 0; i < 2; i++) {
+		trajectory[i].setMaxJerk(MAX_JERK);
+		trajectory[i].setMaxAccel(MAX_ACCEL);
+		trajectory[i].setMaxVel(CRUISE_SPEED);
+		trajectory[i].reset(0.f, 0.f, SURVEY[0](i));
+	}
+
+	bezier::BezierQuad_f corner_blend;
+	Vector3f corner_blend_wp;
+	float corner_blend_speed = 0.f;
+	bool corner_blend_valid = false;
+
+	const float dt = 0.02f;
+	int target = 1;
+
+	for (float time = 0.f; time < 100.f; time += dt) {
+		const Vector3f position(trajectory[0].getCurrentPosition(), trajectory[1].getCurrentPosition(), SURVEY[0](2));
+
+		if (Vector2f(SURVEY[target] - position).length() < ACCEPTANCE_RADIUS) {
+			if (++target == SURVEY_SIZE) {
+				return time;
+			}
+		}
+
+		const Vector3f &prev = SURVEY[target - 1];
+		float speed_at_target = 0.f;
+
+		if (lookahead) {
+			planner.reset();
+
+			for (int i = target - 1; i < SURVEY_SIZE; i++) {
+				planner.addWaypoint(SURVEY[i], ACCEPTANCE_RADIUS);
+			}
+
+			planner.plan();
+			speed_at_target = planner.getSpeedAtWaypoint(1);
+
+		} else {
+			speed_at_target = tripletSpeedAtTarget(planner, target);
+		}
+
+		const Vector2f to_target(SURVEY[target] - position);
+		const Vector2f vel_sp_xy = to_target.unit_or_zero() * CRUISE_SPEED;
+		const Vector2f vel_min_xy = Vector2f(SURVEY[target] - prev).unit_or_zero() * speed_at_target;
+
+		Vector2f vel_sp_constrained_xy;
+		Vector2f blend_direction;
+
+		for (int i = 0; i < 2; i++) {
+			vel_sp_constrained_xy(i) = constrainAbsPrioritizeMin(vel_sp_xy(i), vel_min_xy(i),
+						   planner.computeMaxSpeedFromDistance(fabsf(to_target(i))));
+		}
+
+		if (lookahead) {
+			// The blend of the previous corner is flown until the vehicle has left it
+			const bool in_previous_blend = corner_blend_valid
+						       && Vector2f(corner_blend_wp - prev).length() < 0.001f
+						       && WaypointLookahead::getBlendDirection(corner_blend, position, blend_direction);
+
+			if (!in_previous_blend) {
+				corner_blend_valid = planner.getCornerBlend(1, corner_blend);
+				corner_blend_wp = SURVEY[target];
+				corner_blend_speed = speed_at_target;
+			}
+
+			if (corner_blend_valid && (in_previous_blend
+						   || WaypointLookahead::getBlendDirection(corner_blend, position, blend_direction))) {
+				vel_sp_constrained_xy = blend_direction * corner_blend_speed;
+			}
+		}
+
+		for (int i = 0; i < 2; i++) {
+			trajectory[i].updateTraj(dt);
+		}
+
+		for (int i = 0; i < 2; i++) {
+			trajectory[i].updateDurations(vel_sp_constrained_xy(i));
+		}
+
+		VelocitySmoothing::timeSynchronization(trajectory, 2);
+	}
+
+	return INFINITY;
+}
+} // namespace
+
+class WaypointLookaheadTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		_planner.setMaxJerk(8.f);
+		_planner.setMaxAccel(3.f);
+		_planner.setMaxVel(8.f);
+		_planner.setCornerAccelRatio(0.5f);
+		_planner.setMaxSpeedDistanceRatio(1.f);
+	}
+
+	/** Survey line with intermediate camera waypoints followed by a turn onto the next line */
+	void addSurveyPattern()
+	{
+		const float acceptance_radius = 2.f;
+		_planner.addWaypoint(Vector3f(0.f, 0.f, -10.f), acceptance_radius);
+		_planner.addWaypoint(Vector3f(10.f, 0.f, -10.f), acceptance_radius);
+		_planner.addWaypoint(Vector3f(20.f, 0.f, -10.f), acceptance_radius);
+		_planner.addWaypoint(Vector3f(30.f, 0.f, -10.f), acceptance_radius);
+		_planner.addWaypoint(Vector3f(40.f, 0.f, -10.f), acceptance_radius);
+		_planner.addWaypoint(Vector3f(40.f, 10.f, -10.f), acceptance_radius);
+		_planner.addWaypoint(Vector3f(30.f, 10.f, -10.f), acceptance_radius);
+		_planner.addWaypoint(Vector3f(20.f, 10.f, -10.f), acceptance_radius);
+	}
+
+	WaypointLookahead _planner;
+};
+
+TEST_F(WaypointLookaheadTest, brakingDistanceIsInverse)
+{
+	// WHEN: we compute the braking distance of the speed reachable over a given distance
+	for (float distance = 0.5f; distance < 50.f; distance += 0.5f) {
+		const float speed = _planner.computeMaxSpeedFromDistance(distance);
+
+		// THEN: we get the same distance back, unless the speed is saturated
+		if (speed < 8.f) {
+			EXPECT_NEAR(_planner.computeBrakingDistance(speed), distance, 0.01f);
+		}
+	}
+}
+
+TEST_F(WaypointLookaheadTest, lastWaypointStops)
+{
+	// GIVEN: a straight line
+	_planner.addWaypoint(Vector3f(0.f, 0.f, 0.f), 2.f);
+	_planner.addWaypoint(Vector3f(20.f, 0.f, 0.f), 2.f);
+	_planner.addWaypoint(Vector3f(40.f, 0.f, 0.f), 2.f);
+
+	// WHEN: we plan the speeds
+	_planner.plan();
+
+	// THEN: the straight waypoint is passed at the speed allowing to stop at the end of the line
+	EXPECT_FLOAT_EQ(_planner.getSpeedAtWaypoint(1), _planner.computeMaxSpeedFromDistance(20.f));
+	EXPECT_FLOAT_EQ(_planner.getSpeedAtWaypoint(2), 0.f);
+}
+
+TEST_F(WaypointLookaheadTest, cornerSpeedBoundedByAcceptanceRadius)
+{
+	// GIVEN: a 90 degrees corner
+	const float acceptance_radius = 2.f;
+	_planner.addWaypoint(Vector3f(0.f, 0.f, 0.f), acceptance_radius);
+	_planner.addWaypoint(Vector3f(30.f, 0.f, 0.f), acceptance_radius);
+	_planner.addWaypoint(Vector3f(30.f, 30.f, 0.f), acceptance_radius);
+
+	// WHEN: we plan the speeds
+	_planner.plan();
+
+	// THEN: the speed in the corner is limited by the centripetal acceleration on a circle
+	// tangent to both lines at the acceptance radius
+	const float expected_speed = sqrtf(0.5f * 3.f * acceptance_radius);
+	EXPECT_NEAR(_planner.getCornerSpeed(1), expected_speed, 1e-3f);
+	EXPECT_NEAR(_planner.getSpeedAtWaypoint(1), expected_speed, 1e-3f);
+
+	// AND: the blend stays within the acceptance radius of the corner
+	bezier::BezierQuad_f blend;
+	ASSERT_TRUE(_planner.getCornerBlend(1, blend));
+	const Vector3f corner(30.f, 0.f, 0.f);
+	EXPECT_LE((blend.getPt0() - corner).length(), acceptance_radius + 1e-4f);
+	EXPECT_LE((blend.getPt1() - corner).length(), acceptance_radius + 1e-4f);
+	EXPECT_LE((blend.getPoint(0.5f * (blend.getArcLength(0.05f) / expected_speed)) - corner).length(), acceptance_radius);
+}
+
+TEST_F(WaypointLookaheadTest, stopWaypoint)
+{
+	// GIVEN: a straight line with a waypoint the vehicle has to stop at
+	_planner.addWaypoint(Vector3f(0.f, 0.f, 0.f), 2.f);
+	_planner.addWaypoint(Vector3f(20.f, 0.f, 0.f), 2.f);
+	_planner.addWaypoint(Vector3f(25.f, 0.f, 0.f), 2.f, true);
+	_planner.addWaypoint(Vector3f(45.f, 0.f, 0.f), 2.f);
+
+	// WHEN: we plan the speeds
+	_planner.plan();
+
+	// THEN: the vehicle stops at the stop waypoint and brakes for it before
+	EXPECT_FLOAT_EQ(_planner.getSpeedAtWaypoint(2), 0.f);
+	EXPECT_FLOAT_EQ(_planner.getSpeedAtWaypoint(1), _planner.computeMaxSpeedFromDistance(5.f));
+
+	bezier::BezierQuad_f blend;
+	EXPECT_FALSE(_planner.getCornerBlend(2, blend));
+}
+
+TEST_F(WaypointLookaheadTest, cornerWithAltitudeStep)
+{
+	// GIVEN: a corner after which the vehicle climbs by 5m
+	_planner.setAltitudeAcceptanceRadius(0.8f);
+	_planner.addWaypoint(Vector3f(0.f, 0.f, -10.f), 2.f);
+	_planner.addWaypoint(Vector3f(30.f, 0.f, -10.f), 2.f);
+	_planner.addWaypoint(Vector3f(30.f, 30.f, -15.f), 2.f);
+	_planner.addWaypoint(Vector3f(60.f, 30.f, -15.f), 2.f);
+
+	// WHEN: we plan the speeds
+	_planner.plan();
+
+	// THEN: the vehicle stops at the corner to change altitude, there is no blend to round it
+	EXPECT_FLOAT_EQ(_planner.getSpeedAtWaypoint(1), 0.f);
+
+	bezier::BezierQuad_f blend;
+	EXPECT_FALSE(_planner.getCornerBlend(1, blend));
+
+	// AND: the corner after the altitude change is flown at speed
+	EXPECT_GT(_planner.getSpeedAtWaypoint(2), 0.f);
+	EXPECT_TRUE(_planner.getCornerBlend(2, blend));
+
+	// AND: within the altitude acceptance radius, the corner is blended
+	_planner.reset();
+	_planner.addWaypoint(Vector3f(0.f, 0.f, -10.f), 2.f);
+	_planner.addWaypoint(Vector3f(30.f, 0.f, -10.f), 2.f);
+	_planner.addWaypoint(Vector3f(30.f, 30.f, -10.5f), 2.f);
+	_planner.addWaypoint(Vector3f(60.f, 30.f, -10.5f), 2.f);
+	_planner.plan();
+	EXPECT_GT(_planner.getSpeedAtWaypoint(1), 0.f);
+	EXPECT_TRUE(_planner.getCornerBlend(1, blend));
+}
+
+TEST_F(WaypointLookaheadTest, horizonOneMatchesTriplet)
+{
+	// GIVEN: a survey pattern
+	addSurveyPattern();
+
+	// WHEN: we only look at the next waypoint (triplet behavior)
+	_planner.setHorizon(1);
+	_planner.plan();
+
+	// THEN: the speed at each waypoint only allows braking to a stop at the next one
+	EXPECT_FLOAT_EQ(_planner.getSpeedAtWaypoint(1), _planner.computeMaxSpeedFromDistance(10.f));
+	EXPECT_FLOAT_EQ(_planner.getSpeedAtWaypoint(2), _planner.computeMaxSpeedFromDistance(10.f));
+}
+
+TEST_F(WaypointLookaheadTest, surveyTraversalTime)
+{
+	// GIVEN: a survey pattern
+	addSurveyPattern();
+
+	// WHEN: we plan with the triplet only
+	_planner.setHorizon(1);
+	_planner.plan();
+	const float speed_triplet = _planner.getSpeedAtWaypoint(1);
+	const float time_triplet = _planner.estimateTraversalTime();
+
+	// AND: with the full lookahead
+	_planner.setHorizon(0);
+	_planner.plan();
+	const float speed_lookahead = _planner.getSpeedAtWaypoint(1);
+	const float time_lookahead = _planner.estimateTraversalTime();
+
+	// THEN: the vehicle doesn't need to prepare for a stop at every camera waypoint
+	EXPECT_GT(speed_lookahead, speed_triplet);
+	EXPECT_FLOAT_EQ(speed_lookahead, 8.f);
+
+	// AND: the survey is flown faster
+	EXPECT_GT(time_triplet, 0.f);
+	EXPECT_LT(time_lookahead, time_triplet);
+
+	// AND: the turn is still flown at the corner speed
+	EXPECT_FLOAT_EQ(_planner.getSpeedAtWaypoint(4), _planner.getCornerSpeed(4));
+}
+
+TEST_F(WaypointLookaheadTest, surveyBenchmark)
+{
+	// GIVEN: the survey pattern flown with the trajectory generation of FlightTaskAutoLineSmoothVel
+
+	// WHEN: the speed at each waypoint is planned from the triplet only
+	const float time_triplet = flySurvey(false);
+
+	// AND: from the whole lookahead with the corners blended
+	const float time_lookahead = flySurvey(true);
+
+	// THEN: both reach the end of the survey
+	EXPECT_LT(time_triplet, 100.f);
+
+	// AND: the lookahead is faster since it doesn't prepare for a stop at every camera waypoint
+	EXPECT_LT(time_lookahead, time_triplet);
+}
+
+TEST_F(WaypointLookaheadTest, blendDirection)
+{
+	// GIVEN: a 90 degrees corner
+	_planner.addWaypoint(Vector3f(0.f, 0.f, 0.f), 2.f);
+	_planner.addWaypoint(Vector3f(30.f, 0.f, 0.f), 2.f);
+	_planner.addWaypoint(Vector3f(30.f, 30.f, 0.f), 2.f);
+	_planner.plan();
+
+	bezier::BezierQuad_f blend;
+	ASSERT_TRUE(_planner.getCornerBlend(1, blend));
+	Vector2f direction;
+
+	// THEN: there is no blend direction before the corner
+	EXPECT_FALSE(WaypointLookahead::getBlendDirection(blend, Vector3f(20.f, 0.f, 0.f), direction));
+
+	// AND: the direction follows the incoming line at the start of the blend, the outgoing line at its end
+	// and is diagonal in the middle
+	ASSERT_TRUE(WaypointLookahead::getBlendDirection(blend, Vector3f(28.f, 0.f, 0.f), direction));
+	EXPECT_NEAR(direction(0), 1.f, 1e-2f);
+	ASSERT_TRUE(WaypointLookahead::getBlendDirection(blend, Vector3f(30.f, 2.f, 0.f), direction));
+	EXPECT_NEAR(direction(1), 1.f, 1e-2f);
+	ASSERT_TRUE(WaypointLookahead::getBlendDirection(blend, Vector3f(29.5f, 0.5f, 0.f), direction));
+	EXPECT_NEAR(direction(0), direction(1), 1e-2f);
+}
+
+TEST_F(WaypointLookaheadTest, capacity)
+{
+	// WHEN: we add more waypoints than supported
+	for (int i = 0; i < WaypointLookahead::MAX_WAYPOINTS; i++) {
+		EXPECT_TRUE(_planner.addWaypoint(Vector3f(10.f * i, 0.f, 0.f), 1.f));
+	}
+
+	// THEN: the additional waypoints are rejected
+	EXPECT_FALSE(_planner.addWaypoint(Vector3f(100.f, 0.f, 0.f), 1.f));
+	EXPECT_EQ(_planner.getNumWaypoints(), (int)WaypointLookahead::MAX_WAYPOINTS);
+
+	_planner.reset();
+	EXPECT_EQ(_planner.getNumWaypoints(), 0);
+}
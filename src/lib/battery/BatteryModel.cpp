@@ -0,0 +1,291 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file BatteryModel.cpp
+ */
+
+#include "BatteryModel.hpp"
+
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+using namespace matrix;
+
+// Open circuit voltage of a lithium polymer cell every 10% of charge, normalized between empty and full
+static constexpr float OCV_TABLE[] = {0.f, 0.452f, 0.495f, 0.538f, 0.559f, 0.591f, 0.645f, 0.710f, 0.785f, 0.871f, 1.f};
+
+void BatteryModel::setCellVoltageRange(float v_empty, float v_charged)
+{
+	_v_empty = v_empty;
+	_v_charged = math::max(v_charged, v_empty + 0.01f);
+}
+
+void BatteryModel::reset()
+{
+	_state.zero();
+	_covariance.setZero();
+	_initialized = false;
+	_time_last_us = 0;
+	_time_last_prediction_us = 0;
+	_power_filtered = 0.f;
+	_power_average = 0.f;
+	_power_variance = 0.f;
+	_time_remaining = NAN;
+	_time_remaining_std = NAN;
+}
+
+float BatteryModel::openCircuitVoltage(float soc) const
+{
+	const float index = math::constrain(soc, 0.f, 1.f) * (OCV_TABLE_SIZE - 1);
+	const int i = math::min((int)index, OCV_TABLE_SIZE - 2);
+	const float normalized = OCV_TABLE[i] + (index - i) * (OCV_TABLE[i + 1] - OCV_TABLE[i]);
+
+	return _v_empty + normalized * (_v_charged - _v_empty);
+}
+
+float BatteryModel::_openCircuitVoltageSlope(float soc) const
+{
+	const float index = math::constrain(soc, 0.f, 1.f) * (OCV_TABLE_SIZE - 1);
+	const int i = math::min((int)index, OCV_TABLE_SIZE - 2);
+
+	return (OCV_TABLE[i + 1] - OCV_TABLE[i]) * (OCV_TABLE_SIZE - 1) * (_v_charged - _v_empty);
+}
+
+float BatteryModel::stateOfChargeFromVoltage(float cell_voltage) const
+{
+	const float normalized = (cell_voltage - _v_empty) / (_v_charged - _v_empty);
+
+	if (normalized <= 0.f) {
+		return 0.f;
+	}
+
+	for (int i = 0; i < OCV_TABLE_SIZE - 1; i++) {
+		if (normalized < OCV_TABLE[i + 1]) {
+			return (i + (normalized - OCV_TABLE[i]) / (OCV_TABLE[i + 1] - OCV_TABLE[i])) / (OCV_TABLE_SIZE - 1);
+		}
+	}
+
+	return 1.f;
+}
+
+bool BatteryModel::update(uint64_t time_us, float voltage_v, float current_a)
+{
+	if (_capacity_ah <= 0.f || _cell_count <= 0 || !PX4_ISFINITE(voltage_v) || !PX4_ISFINITE(current_a)
+	    || current_a < 0.f) {
+		return false;
+	}
+
+	const float cell_voltage = voltage_v / _cell_count;
+
+	if (!_initialized || time_us <= _time_last_us) {
+		_initialize(cell_voltage, current_a);
+		_time_last_us = time_us;
+		_time_last_prediction_us = time_us;
+		_power_filtered = voltage_v * current_a;
+		_power_average = _power_filtered;
+		_power_variance = 0.f;
+		return true;
+	}
+
+	const float dt = math::min((time_us - _time_last_us) * 1e-6f, 1.f);
+	_time_last_us = time_us;
+
+	_predict(current_a, dt);
+	_fuseVoltage(cell_voltage, current_a);
+
+	const float alpha = dt / (POWER_TIME_CONSTANT + dt);
+	_power_filtered += alpha * (voltage_v * current_a - _power_filtered);
+
+	// how much the filtered power varies tells how representative it is for the rest of the flight
+	const float alpha_average = dt / (3.f * POWER_TIME_CONSTANT + dt);
+	const float power_deviation = _power_filtered - _power_average;
+	_power_average += alpha_average * power_deviation;
+	_power_variance += alpha_average * (power_deviation * power_deviation - _power_variance);
+
+	// the prediction is expensive compared to the filter, run it once per second
+	if (time_us - _time_last_prediction_us >= 1000000) {
+		_time_last_prediction_us = time_us;
+		_time_remaining = predictTimeRemaining(_power_filtered);
+
+		// linearized around the current state of charge and power
+		const float soc_rel_std = getStateOfChargeStd() / math::max(_state(SOC), 0.01f);
+		const float power_rel_std = sqrtf(_power_variance) / math::max(_power_filtered, 1.f);
+		_time_remaining_std = PX4_ISFINITE(_time_remaining) ?
+				      _time_remaining * sqrtf(soc_rel_std * soc_rel_std + power_rel_std * power_rel_std) : NAN;
+	}
+
+	return true;
+}
+
+void BatteryModel::_initialize(float cell_voltage, float current_a)
+{
+	// assume a relaxed polarization, the uncertainty covers the error if it is not
+	_state(R0) = _resistance_init;
+	_state(R1) = POLARIZATION_RESISTANCE_RATIO * _resistance_init;
+	_state(V1) = 0.f;
+	_state(SOC) = stateOfChargeFromVoltage(cell_voltage + _resistance_init * current_a);
+
+	_covariance.setZero();
+	_covariance(SOC, SOC) = 0.3f * 0.3f;
+	_covariance(V1, V1) = 0.02f * 0.02f;
+	_covariance(R0, R0) = _state(R0) * _state(R0);
+	_covariance(R1, R1) = _state(R1) * _state(R1);
+
+	_time_remaining = NAN;
+	_time_remaining_std = NAN;
+	_initialized = true;
+}
+
+void BatteryModel::_predict(float current_a, float dt)
+{
+	const float decay = expf(-dt / POLARIZATION_TIME_CONSTANT);
+	const float soc_rate = 1.f / (3600.f * _capacity_ah);
+
+	_state(SOC) -= current_a * dt * soc_rate;
+	_state(V1) = decay * _state(V1) + (1.f - decay) * _state(R1) * current_a;
+
+	SquareMatrix<float, STATE_SIZE> F;
+	F.setIdentity();
+	F(V1, V1) = decay;
+	F(V1, R1) = (1.f - decay) * current_a;
+
+	const float current_noise = CURRENT_NOISE_REL * current_a + CURRENT_NOISE_ABS;
+	const float soc_noise = current_noise * dt * soc_rate;
+
+	_covariance = F * _covariance * F.transpose();
+	_covariance(SOC, SOC) += soc_noise * soc_noise;
+	_covariance(V1, V1) += 1e-6f * dt;
+	_covariance(R0, R0) += RESISTANCE_PROCESS_NOISE * RESISTANCE_PROCESS_NOISE * dt;
+	_covariance(R1, R1) += RESISTANCE_PROCESS_NOISE * RESISTANCE_PROCESS_NOISE * dt;
+}
+
+void BatteryModel::_fuseVoltage(float cell_voltage, float current_a)
+{
+	const float soc = _state(SOC);
+	Vector<float, STATE_SIZE> H;
+	H(SOC) = _openCircuitVoltageSlope(soc);
+	H(V1) = -1.f;
+	H(R0) = -current_a;
+
+	const float predicted = openCircuitVoltage(soc) - _state(V1) - _state(R0) * current_a;
+
+	const Vector<float, STATE_SIZE> PHt = _covariance * H;
+	const float innovation_variance = H.dot(PHt) + VOLTAGE_NOISE * VOLTAGE_NOISE;
+	const float innovation = cell_voltage - predicted;
+
+	// reject voltage spikes
+	if (innovation * innovation > 25.f * innovation_variance) {
+		return;
+	}
+
+	const Vector<float, STATE_SIZE> gain = PHt / innovation_variance;
+	_state += gain * innovation;
+
+	for (int i = 0; i < STATE_SIZE; i++) {
+		for (int j = 0; j < STATE_SIZE; j++) {
+			_covariance(i, j) -= gain(i) * PHt(j);
+		}
+	}
+
+	// keep the covariance symmetric
+	_covariance = (_covariance + _covariance.transpose()) * 0.5f;
+
+	_state(SOC) = math::constrain(_state(SOC), 0.f, 1.f);
+	_state(R0) = math::constrain(_state(R0), 0.0005f, 0.2f);
+	_state(R1) = math::constrain(_state(R1), 0.f, 0.2f);
+}
+
+float BatteryModel::getEnergyRemaining() const
+{
+	if (!_initialized) {
+		return NAN;
+	}
+
+	// integral of the piecewise linear open circuit voltage up to the current state of charge
+	const float soc = math::constrain(_state(SOC), 0.f, 1.f);
+	const float step = 1.f / (OCV_TABLE_SIZE - 1);
+	float cell_energy = 0.f; // [V * soc]
+
+	for (int i = 0; i < OCV_TABLE_SIZE - 1 && i * step < soc; i++) {
+		const float upper = math::min((i + 1) * step, soc);
+		cell_energy += 0.5f * (openCircuitVoltage(i * step) + openCircuitVoltage(upper)) * (upper - i * step);
+	}
+
+	return cell_energy * _capacity_ah * _cell_count;
+}
+
+float BatteryModel::predictTimeRemaining(float power_w) const
+{
+	if (!_initialized) {
+		return NAN;
+	}
+
+	const float cell_power = power_w / _cell_count;
+
+	if (cell_power <= 0.f) {
+		return INFINITY;
+	}
+
+	const float decay = expf(-PREDICTION_STEP / POLARIZATION_TIME_CONSTANT);
+	const float resistance = _state(R0);
+	const float polarization_resistance = _state(R1);
+	float soc = _state(SOC);
+	float v1 = _state(V1);
+	float time = 0.f;
+
+	while (time < PREDICTION_HORIZON) {
+		// current drawing the power: R0 * i^2 - (ocv - v1) * i + p = 0
+		const float source_voltage = openCircuitVoltage(soc) - v1;
+		const float discriminant = source_voltage * source_voltage - 4.f * resistance * cell_power;
+
+		if (discriminant < 0.f) {
+			// the battery cannot deliver that power anymore
+			break;
+		}
+
+		const float current = (source_voltage - sqrtf(discriminant)) / (2.f * resistance);
+		const float soc_step = current * PREDICTION_STEP / (3600.f * _capacity_ah);
+
+		if (soc_step >= soc) {
+			time += PREDICTION_STEP * soc / soc_step;
+			break;
+		}
+
+		soc -= soc_step;
+		v1 = decay * v1 + (1.f - decay) * polarization_resistance * current;
+		time += PREDICTION_STEP;
+	}
+
+	return time;
+}
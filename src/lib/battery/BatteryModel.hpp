@@ -0,0 +1,193 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file BatteryModel.hpp
+ *
+ * Battery state estimation based on an equivalent circuit model of a lithium polymer cell:
+ *
+ * v_cell = ocv(soc) - R0 * i - v1
+ * dv1/dt = (R1 * i - v1) / tau
+ * dsoc/dt = -i / capacity
+ *
+ * where ocv is a tabulated open circuit voltage, R0 the internal resistance and v1 the voltage
+ * over the polarization (R1, tau) branch. An extended Kalman filter fuses the coulomb counting
+ * with the cell voltage to estimate the state of charge with its uncertainty, and identifies both
+ * resistances online. The remaining flight time is predicted by discharging the model
+ * at the current power draw, which accounts for the increasing current as the voltage drops.
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+#include <math.h>
+#include <stdint.h>
+
+class BatteryModel
+{
+public:
+	BatteryModel() { reset(); }
+	~BatteryModel() = default;
+
+	/**
+	 * @param capacity_mah capacity of the battery [mAh], the model is disabled if not positive
+	 */
+	void setCapacity(float capacity_mah) { _capacity_ah = capacity_mah * 1e-3f; }
+
+	/**
+	 * @param cell_count number of cells in series
+	 */
+	void setCellCount(int cell_count) { _cell_count = cell_count; }
+
+	/**
+	 * Set the cell voltages corresponding to an empty and a full battery
+	 * The open circuit voltage curve is scaled between these two values.
+	 */
+	void setCellVoltageRange(float v_empty, float v_charged);
+
+	/**
+	 * @param resistance initial internal resistance per cell [Ohm]
+	 */
+	void setInitialResistance(float resistance) { _resistance_init = resistance; }
+
+	/**
+	 * Restart the estimation with the next measurement
+	 */
+	void reset();
+
+	/**
+	 * Run one estimation cycle
+	 * @param time_us timestamp of the measurement [us]
+	 * @param voltage_v battery voltage [V]
+	 * @param current_a battery current [A], positive when discharging
+	 * @return true if the estimate is valid
+	 */
+	bool update(uint64_t time_us, float voltage_v, float current_a);
+
+	bool isValid() const { return _initialized; }
+
+	float getStateOfCharge() const { return _state(SOC); }
+	float getStateOfChargeStd() const { return sqrtf(_covariance(SOC, SOC)); }
+
+	/**
+	 * @return estimated internal resistance per cell [Ohm]
+	 */
+	float getInternalResistance() const { return _state(R0); }
+
+	/**
+	 * @return estimated polarization resistance per cell [Ohm]
+	 */
+	float getPolarizationResistance() const { return _state(R1); }
+
+	/**
+	 * @return low-pass filtered power drawn from the battery [W]
+	 */
+	float getPower() const { return _power_filtered; }
+
+	/**
+	 * @return predicted time until the battery is empty at the current power draw [s], NAN if not available
+	 */
+	float getTimeRemaining() const { return _time_remaining; }
+
+	/**
+	 * @return approximate standard deviation of the remaining time due to the state of charge
+	 * uncertainty and the variation of the power draw [s]
+	 */
+	float getTimeRemainingStd() const { return _time_remaining_std; }
+
+	/**
+	 * @return energy stored in the battery, part of it is lost in the internal resistance [Wh]
+	 */
+	float getEnergyRemaining() const;
+
+	/**
+	 * Predict the time until the battery is empty
+	 * @param power_w constant power drawn from the battery [W]
+	 * @return [s], NAN if the model is not valid
+	 */
+	float predictTimeRemaining(float power_w) const;
+
+	/**
+	 * @return open circuit voltage of a cell at the given state of charge [V]
+	 */
+	float openCircuitVoltage(float soc) const;
+
+	/**
+	 * @return state of charge corresponding to the given open circuit voltage of a cell
+	 */
+	float stateOfChargeFromVoltage(float cell_voltage) const;
+
+private:
+	enum StateIndex {
+		SOC = 0,
+		V1,
+		R0,
+		R1,
+		STATE_SIZE
+	};
+
+	float _openCircuitVoltageSlope(float soc) const;
+	void _initialize(float cell_voltage, float current_a);
+	void _predict(float current_a, float dt);
+	void _fuseVoltage(float cell_voltage, float current_a);
+
+	static constexpr int OCV_TABLE_SIZE = 11; ///< open circuit voltage every 10% of charge
+	static constexpr float POLARIZATION_TIME_CONSTANT = 30.f; ///< [s]
+	static constexpr float POLARIZATION_RESISTANCE_RATIO = 0.5f; ///< initial R1 / R0
+	static constexpr float CURRENT_NOISE_REL = 0.05f; ///< relative current sensor uncertainty
+	static constexpr float CURRENT_NOISE_ABS = 0.2f; ///< [A]
+	static constexpr float VOLTAGE_NOISE = 0.03f; ///< cell voltage measurement noise and model error [V]
+	static constexpr float RESISTANCE_PROCESS_NOISE = 1e-5f; ///< resistance random walk [Ohm/s^0.5]
+	static constexpr float POWER_TIME_CONSTANT = 30.f; ///< [s]
+	static constexpr float PREDICTION_STEP = 5.f; ///< [s]
+	static constexpr float PREDICTION_HORIZON = 3.f * 3600.f; ///< [s]
+
+	// Parameters
+	float _capacity_ah{0.f};
+	int _cell_count{0};
+	float _v_empty{3.5f};
+	float _v_charged{4.05f};
+	float _resistance_init{0.005f};
+
+	// State
+	matrix::Vector<float, STATE_SIZE> _state;
+	matrix::SquareMatrix<float, STATE_SIZE> _covariance;
+	bool _initialized{false};
+	uint64_t _time_last_us{0};
+	uint64_t _time_last_prediction_us{0};
+	float _power_filtered{0.f};
+	float _power_average{0.f}; ///< slower average of the filtered power
+	float _power_variance{0.f}; ///< variance of the filtered power around its average
+	float _time_remaining{NAN};
+	float _time_remaining_std{NAN};
+};
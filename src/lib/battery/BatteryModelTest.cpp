@@ -0,0 +1,247 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the Battery Model
+ * Run this test only using make tests TESTFILTER=BatteryModel
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/matrix/math.hpp>
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+#include "BatteryModel.hpp"
+
+/**
+ * 4S 5000mAh lithium polymer pack with an open circuit voltage curve slightly different from
+ * the one of the model, a higher internal resistance than the initial guess and a slower polarization.
+ */
+class SimulatedBattery
+{
+public:
+	static constexpr int CELLS = 4;
+	static constexpr float CAPACITY_AH = 5.f;
+	static constexpr float R0 = 0.012f; ///< [Ohm]
+	static constexpr float R1 = 0.008f; ///< [Ohm]
+	static constexpr float TAU = 45.f; ///< [s]
+
+	SimulatedBattery(float soc) : _soc(soc)
+	{
+		_reference.setCellVoltageRange(3.5f, 4.05f);
+	}
+
+	float openCircuitVoltage() const
+	{
+		return _reference.openCircuitVoltage(_soc) + 0.01f * sinf(9.f * _soc);
+	}
+
+	/** Draw the given power for dt, return the cell voltage */
+	void step(float power_w, float dt)
+	{
+		const float source_voltage = CELLS * (openCircuitVoltage() - _v1);
+		const float resistance = CELLS * R0;
+		_current = (source_voltage - sqrtf(source_voltage * source_voltage - 4.f * resistance * power_w)) / (2.f * resistance);
+		_soc -= _current * dt / (3600.f * CAPACITY_AH);
+		_v1 += (R1 * _current - _v1) * dt / TAU;
+		_voltage = CELLS * (openCircuitVoltage() - _v1 - R0 * _current);
+	}
+
+	float _soc;
+	float _v1{0.f};
+	float _current{0.f};
+	float _voltage{0.f};
+
+private:
+	BatteryModel _reference; ///< only used for its open circuit voltage curve
+};
+
+class BatteryModelTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		_model.setCapacity(SimulatedBattery::CAPACITY_AH * 1e3f);
+		_model.setCellCount(SimulatedBattery::CELLS);
+		_model.setCellVoltageRange(3.5f, 4.05f);
+		_model.setInitialResistance(0.005f);
+		_model.reset();
+	}
+
+	/** Multicopter power profile, 10s on the ground then hovering with maneuvers [W] */
+	static float power(float t)
+	{
+		if (t < 10.f) {
+			return 10.f;
+		}
+
+		const float maneuver = fmodf(t, 40.f) < 10.f ? 150.f : 0.f;
+		return 300.f + maneuver + 20.f * sinf(0.5f * t);
+	}
+
+	/** Standard normal pseudo random number */
+	float noise()
+	{
+		float sum = 0.f;
+
+		for (int i = 0; i < 12; i++) {
+			_seed = 1103515245u * _seed + 12345u;
+			sum += (float)((_seed >> 8) & 0xFFFF) / 65536.f;
+		}
+
+		return sum - 6.f;
+	}
+
+	/** Run the battery and the model at 20Hz with noisy measurements */
+	void fly(SimulatedBattery &battery, float duration)
+	{
+		for (float t = 0.f; t < duration; t += DT) {
+			battery.step(power(_time), DT);
+			_time += DT;
+			_model.update((uint64_t)(_time * 1e6f), battery._voltage + 0.02f * noise(), battery._current + 0.3f * noise());
+		}
+	}
+
+	/** Time until the battery is empty at the power profile [s] */
+	static float timeToEmpty(SimulatedBattery battery, float time)
+	{
+		const float start = time;
+
+		while (battery._soc > 0.f) {
+			battery.step(power(time), DT);
+			time += DT;
+		}
+
+		return time - start;
+	}
+
+	static constexpr float DT = 0.05f;
+
+	BatteryModel _model;
+	float _time{0.f};
+	uint32_t _seed{1};
+};
+
+TEST_F(BatteryModelTest, openCircuitVoltageRoundTrip)
+{
+	for (float soc = 0.f; soc <= 1.f; soc += 0.05f) {
+		EXPECT_NEAR(_model.stateOfChargeFromVoltage(_model.openCircuitVoltage(soc)), soc, 1e-4f);
+	}
+
+	EXPECT_FLOAT_EQ(_model.openCircuitVoltage(0.f), 3.5f);
+	EXPECT_FLOAT_EQ(_model.openCircuitVoltage(1.f), 4.05f);
+	EXPECT_FLOAT_EQ(_model.stateOfChargeFromVoltage(3.f), 0.f);
+	EXPECT_FLOAT_EQ(_model.stateOfChargeFromVoltage(4.2f), 1.f);
+}
+
+TEST_F(BatteryModelTest, disabledWithoutCapacity)
+{
+	_model.setCapacity(-1.f);
+	EXPECT_FALSE(_model.update(1000, 16.f, 10.f));
+	EXPECT_FALSE(_model.isValid());
+	EXPECT_FALSE(PX4_ISFINITE(_model.getTimeRemaining()));
+}
+
+TEST_F(BatteryModelTest, stateOfChargeConsistent)
+{
+	// GIVEN: a battery that is started under load, with resistances the model does not know
+	SimulatedBattery battery(0.9f);
+	fly(battery, 1.f);
+
+	// WHEN: we fly until the battery is almost empty
+	while (battery._soc > 0.05f) {
+		fly(battery, 10.f);
+
+		// THEN: the state of charge is within its uncertainty
+		const float error = _model.getStateOfCharge() - battery._soc;
+		EXPECT_LT(fabsf(error), 3.f * _model.getStateOfChargeStd() + 0.01f) << "at " << _time << "s";
+
+		if (_time > 60.f) {
+			EXPECT_LT(fabsf(error), 0.05f) << "at " << _time << "s";
+		}
+	}
+
+	EXPECT_LT(_model.getStateOfChargeStd(), 0.05f);
+}
+
+TEST_F(BatteryModelTest, identifiesInternalResistance)
+{
+	// GIVEN: an initial internal resistance less than half the true one
+	SimulatedBattery battery(0.95f);
+
+	// WHEN: we fly with changing loads
+	fly(battery, 300.f);
+
+	// THEN: the resistance is identified
+	EXPECT_NEAR(_model.getInternalResistance(), SimulatedBattery::R0, 0.3f * SimulatedBattery::R0);
+}
+
+TEST_F(BatteryModelTest, flightTimePrediction)
+{
+	// GIVEN: a full battery
+	SimulatedBattery battery(1.f);
+	fly(battery, 120.f);
+
+	float error_model_squared = 0.f;
+	float error_coulomb_squared = 0.f;
+	int n = 0;
+
+	// WHEN: we fly until 10% is left
+	while (battery._soc > 0.1f) {
+		fly(battery, 30.f);
+
+		// THEN: the predicted flight time matches the real one
+		const float truth = timeToEmpty(battery, _time);
+		const float predicted = _model.getTimeRemaining();
+		EXPECT_LT(fabsf(predicted - truth), 0.1f * truth + 30.f) << "at " << _time << "s";
+		EXPECT_LT(fabsf(predicted - truth), 3.f * _model.getTimeRemainingStd() + 30.f) << "at " << _time << "s";
+
+		// AND: it is better than dividing the remaining charge by the current
+		const float coulomb = _model.getStateOfCharge() * SimulatedBattery::CAPACITY_AH * 3600.f
+				      / (_model.getPower() / battery._voltage);
+
+		error_model_squared += (predicted - truth) * (predicted - truth);
+		error_coulomb_squared += (coulomb - truth) * (coulomb - truth);
+		n++;
+	}
+
+	const float rms_model = sqrtf(error_model_squared / n);
+	const float rms_coulomb = sqrtf(error_coulomb_squared / n);
+	EXPECT_LT(rms_model, rms_coulomb);
+
+	// AND: the stored energy covers the prediction at the current power plus the resistive losses
+	const float energy_time = _model.getEnergyRemaining() * 3600.f / _model.getPower();
+	EXPECT_GT(energy_time, _model.getTimeRemaining());
+	EXPECT_LT(energy_time, 1.3f * _model.getTimeRemaining());
+}
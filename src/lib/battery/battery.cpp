@@ -49,6 +49,45 @@ Battery::Battery() :
 	_warning(battery_status_s::BATTERY_WARNING_NONE),
 	_last_timestamp(0)
 {
+	configureModel();
+}
+
+void
+Battery::updateParams()
+{
+	const float capacity = _param_bat_capacity.get();
+	const int n_cells = _param_bat_n_cells.get();
+	const float v_empty = _param_bat_v_empty.get();
+	const float v_charged = _param_bat_v_charged.get();
+	const float r_internal = _param_bat_r_internal.get();
+	const int model_en = _param_bat_model_en.get();
+
+	ModuleParams::updateParams();
+
+	// reconfiguring resets the model estimate, only do it if the battery description changed
+	if (fabsf(capacity - _param_bat_capacity.get()) > FLT_EPSILON
+	    || n_cells != _param_bat_n_cells.get()
+	    || fabsf(v_empty - _param_bat_v_empty.get()) > FLT_EPSILON
+	    || fabsf(v_charged - _param_bat_v_charged.get()) > FLT_EPSILON
+	    || fabsf(r_internal - _param_bat_r_internal.get()) > FLT_EPSILON
+	    || model_en != _param_bat_model_en.get()) {
+		configureModel();
+	}
+}
+
+void
+Battery::configureModel()
+{
+	_model.setCapacity(_param_bat_model_en.get() ? _param_bat_capacity.get() : -1.f);
+	_model.setCellCount(_param_bat_n_cells.get());
+	_model.setCellVoltageRange(_param_bat_v_empty.get(), _param_bat_v_charged.get());
+
+	if (_param_bat_r_internal.get() > 0.f) {
+		_model.setInitialResistance(_param_bat_r_internal.get());
+	}
+
+	_model.reset();
+	_model_valid = false;
 }
 
 void
@@ -57,6 +96,11 @@ Battery::reset(battery_status_s *battery_status)
 	memset(battery_status, 0, sizeof(*battery_status));
 	battery_status->current_a = -1.f;
 	battery_status->remaining = 1.f;
+	battery_status->remaining_std = NAN;
+	battery_status->internal_resistance = NAN;
+	battery_status->time_remaining_s = NAN;
+	battery_status->time_remaining_std_s = NAN;
+	battery_status->energy_remaining_wh = NAN;
 	battery_status->scale = 1.f;
 	battery_status->cell_count = _param_bat_n_cells.get();
 	// TODO: check if it is sane to reset warning to NONE
@@ -76,6 +120,7 @@ Battery::updateBatteryStatus(hrt_abstime timestamp, float voltage_v, float curre
 	filterThrottle(throttle_normalized);
 	filterCurrent(current_a);
 	sumDischarged(timestamp, current_a);
+	updateModel(timestamp, voltage_v, current_a);
 	estimateRemaining(_voltage_filtered_v, _current_filtered_a, _throttle_filtered, armed);
 	computeScale();
 
@@ -96,6 +141,18 @@ Battery::updateBatteryStatus(hrt_abstime timestamp, float voltage_v, float curre
 		battery_status->connected = connected;
 		battery_status->system_source = selected_source;
 		battery_status->priority = priority;
+
+		if (_model_valid) {
+			battery_status->remaining_std = _model.getStateOfChargeStd();
+			battery_status->internal_resistance = _model.getInternalResistance();
+			battery_status->time_remaining_s = _model.getTimeRemaining();
+			battery_status->time_remaining_std_s = _model.getTimeRemainingStd();
+			battery_status->energy_remaining_wh = _model.getEnergyRemaining();
+
+			if (PX4_ISFINITE(_model.getTimeRemaining())) {
+				battery_status->run_time_to_empty = math::min(_model.getTimeRemaining() / 60.f, (float)UINT16_MAX);
+			}
+		}
 	}
 
 	battery_status->temperature = NAN;
@@ -166,6 +223,22 @@ Battery::sumDischarged(hrt_abstime timestamp, float current_a)
 	_last_timestamp = timestamp;
 }
 
+void
+Battery::updateModel(hrt_abstime timestamp, float voltage_v, float current_a)
+{
+	// the model needs both measurements, it restarts when they come back
+	if (current_a < 0.f || !PX4_ISFINITE(voltage_v) || voltage_v < 2.1f) {
+		if (_model_valid) {
+			_model.reset();
+		}
+
+		_model_valid = false;
+		return;
+	}
+
+	_model_valid = _model.update(timestamp, voltage_v, current_a);
+}
+
 void
 Battery::estimateRemaining(float voltage_v, float current_a, float throttle, bool armed)
 {
@@ -184,7 +257,11 @@ Battery::estimateRemaining(float voltage_v, float current_a, float throttle, boo
 	_remaining_voltage = math::gradual(cell_voltage, _param_bat_v_empty.get(), _param_bat_v_charged.get(), 0.f, 1.f);
 
 	// choose which quantity we're using for final reporting
-	if (_param_bat_capacity.get() > 0.f) {
+	if (_model_valid) {
+		// the model fuses the voltage with the used capacity and accounts for the load
+		_remaining = math::constrain(_model.getStateOfCharge(), 0.f, 1.f);
+
+	} else if (_param_bat_capacity.get() > 0.f) {
 		// if battery capacity is known, fuse voltage measurement with used capacity
 		if (!_battery_initialized) {
 			// initialization of the estimation state
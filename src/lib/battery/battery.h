@@ -41,6 +41,8 @@
 
 #pragma once
 
+#include "BatteryModel.hpp"
+
 #include <uORB/topics/battery_status.h>
 #include <drivers/drv_hrt.h>
 #include <px4_module_params.h>
@@ -86,12 +88,16 @@ public:
 				 float throttle_normalized,
 				 bool armed, battery_status_s *status);
 
+	void updateParams() override;
+
 private:
 	void filterVoltage(float voltage_v);
 	void filterThrottle(float throttle);
 	void filterCurrent(float current_a);
 	void sumDischarged(hrt_abstime timestamp, float current_a);
 	void estimateRemaining(float voltage_v, float current_a, float throttle, bool armed);
+	void updateModel(hrt_abstime timestamp, float voltage_v, float current_a);
+	void configureModel();
 	void determineWarning(bool connected);
 	void computeScale();
 
@@ -104,9 +110,13 @@ private:
 		(ParamFloat<px4::params::BAT_R_INTERNAL>) _param_bat_r_internal,
 		(ParamFloat<px4::params::BAT_LOW_THR>) _param_bat_low_thr,
 		(ParamFloat<px4::params::BAT_CRIT_THR>) _param_bat_crit_thr,
-		(ParamFloat<px4::params::BAT_EMERGEN_THR>) _param_bat_emergen_thr
+		(ParamFloat<px4::params::BAT_EMERGEN_THR>) _param_bat_emergen_thr,
+		(ParamInt<px4::params::BAT_MODEL_EN>) _param_bat_model_en
 	)
 
+	BatteryModel _model;
+	bool _model_valid = false;
+
 	bool _battery_initialized = false;
 	float _voltage_filtered_v = -1.f;
 	float _throttle_filtered = -1.f;
@@ -196,3 +196,17 @@ PARAM_DEFINE_INT32(BAT_N_CELLS, 0);
  * @reboot_required true
  */
 PARAM_DEFINE_FLOAT(BAT_CAPACITY, -1.0f);
+
+/**
+ * Battery model based state estimation.
+ *
+ * If enabled and the capacity is configured, the state of charge is estimated with an
+ * equivalent circuit model of the battery which identifies the internal resistance online
+ * and predicts the remaining flight time at the present power draw.
+ * Requires a current measurement.
+ *
+ * @group Battery Calibration
+ * @boolean
+ * @reboot_required true
+ */
+PARAM_DEFINE_INT32(BAT_MODEL_EN, 0);
@@ -42,6 +42,8 @@
 
 #include "I2C.hpp"
 
+#include <drivers/drv_hrt.h>
+
 #ifdef __PX4_LINUX
 #include <linux/i2c.h>
 #include <linux/i2c-dev.h>
@@ -59,6 +61,80 @@ static constexpr const int simulate = PX4_SIMULATE_I2C;
 namespace device
 {
 
+namespace
+{
+
+/**
+ * i2c-dev adapter, executing a combined transaction with a single I2C_RDWR ioctl
+ */
+class I2CDevAdapter : public I2CBusScheduler::Adapter
+{
+public:
+	explicit I2CDevAdapter(int fd) : _fd(fd) {}
+
+	~I2CDevAdapter() override
+	{
+#ifndef __PX4_QURT
+
+		if (!simulate && _fd >= 0) {
+			::close(_fd);
+		}
+
+#endif /* !__PX4_QURT */
+	}
+
+	int transfer(I2CBusScheduler::Message *messages, unsigned count) override
+	{
+#ifndef __PX4_LINUX
+		return PX4_ERROR;
+#else
+		struct i2c_msg msgv[I2CBusScheduler::MAX_MESSAGES];
+
+		for (unsigned i = 0; i < count; i++) {
+			msgv[i].addr = messages[i].address;
+			msgv[i].flags = (messages[i].flags & I2CBusScheduler::Message::FLAG_READ) ? I2C_M_READ : 0;
+			msgv[i].buf = messages[i].buffer;
+			msgv[i].len = messages[i].length;
+		}
+
+		struct i2c_rdwr_ioctl_data packets;
+		packets.msgs = msgv;
+		packets.nmsgs = count;
+
+		if (simulate) {
+			PX4_DEBUG("I2C SIM: transfer of %u messages", count);
+			return PX4_OK;
+		}
+
+		if (::ioctl(_fd, I2C_RDWR, (unsigned long)&packets) == -1) {
+			PX4_DEBUG("I2C transfer failed");
+			return -errno;
+		}
+
+		return PX4_OK;
+#endif
+	}
+
+private:
+	const int _fd;
+};
+
+/**
+ * The adapter and scheduler of a bus, shared by all devices on it
+ */
+struct Bus {
+	int bus;
+	unsigned users;
+	I2CDevAdapter *adapter;
+	I2CBusScheduler *scheduler;
+};
+
+constexpr unsigned MAX_BUSES = 8;
+Bus buses[MAX_BUSES] {};
+pthread_mutex_t buses_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+} // namespace
+
 I2C::I2C(const char *name, const char *devname, const int bus, const uint16_t address, const uint32_t frequency) :
 	CDev(name, devname)
 {
@@ -73,12 +149,7 @@ I2C::I2C(const char *name, const char *devname, const int bus, const uint16_t ad
 
 I2C::~I2C()
 {
-	if (_fd >= 0) {
-#ifndef __PX4_QURT
-		::close(_fd);
-#endif /* !__PX4_QURT */
-		_fd = -1;
-	}
+	release_bus();
 }
 
 int
@@ -95,100 +166,185 @@ I2C::init()
 		return ret;
 	}
 
-	if (simulate) {
-		_fd = 10000;
+	if (_bus_scheduler != nullptr) {
+		return ret;
+	}
 
-	} else {
-#ifndef __PX4_QURT
+	pthread_mutex_lock(&buses_mutex);
 
-		// Open the actual I2C device
-		char dev_path[16];
-		snprintf(dev_path, sizeof(dev_path), "/dev/i2c-%i", get_device_bus());
-		_fd = ::open(dev_path, O_RDWR);
+	Bus *entry = nullptr;
 
-		if (_fd < 0) {
-			PX4_ERR("could not open %s", dev_path);
-			px4_errno = errno;
+	for (Bus &b : buses) {
+		if (b.users > 0 && b.bus == get_device_bus()) {
+			entry = &b;
+			break;
+		}
+	}
+
+	if (entry == nullptr) {
+		for (Bus &b : buses) {
+			if (b.users == 0) {
+				entry = &b;
+				break;
+			}
+		}
+
+		if (entry == nullptr) {
+			pthread_mutex_unlock(&buses_mutex);
+			PX4_ERR("too many I2C buses");
 			return PX4_ERROR;
 		}
 
+		int fd = -1;
+
+		if (simulate) {
+			fd = 10000;
+
+		} else {
+#ifndef __PX4_QURT
+
+			// Open the actual I2C device, shared by all devices on the bus
+			char dev_path[16];
+			snprintf(dev_path, sizeof(dev_path), "/dev/i2c-%i", get_device_bus());
+			fd = ::open(dev_path, O_RDWR);
+
+			if (fd < 0) {
+				pthread_mutex_unlock(&buses_mutex);
+				PX4_ERR("could not open %s", dev_path);
+				px4_errno = errno;
+				return PX4_ERROR;
+			}
+
 #endif /* !__PX4_QURT */
+		}
+
+		entry->bus = get_device_bus();
+		entry->adapter = new I2CDevAdapter(fd);
+		entry->scheduler = new I2CBusScheduler(*entry->adapter);
+	}
+
+	_bus_address = get_device_address();
+	_bus_device = entry->scheduler->registerDevice(_bus_address);
+
+	if (_bus_device < 0) {
+		if (entry->users == 0) {
+			delete entry->scheduler;
+			delete entry->adapter;
+		}
+
+		pthread_mutex_unlock(&buses_mutex);
+		PX4_ERR("too many devices on I2C bus %d", get_device_bus());
+		return PX4_ERROR;
 	}
 
+	entry->users++;
+	_bus_scheduler = entry->scheduler;
+
+	pthread_mutex_unlock(&buses_mutex);
+
 	return ret;
 }
 
+void
+I2C::release_bus()
+{
+	if (_bus_scheduler == nullptr) {
+		return;
+	}
+
+	pthread_mutex_lock(&buses_mutex);
+
+	_bus_scheduler->unregisterDevice(_bus_device);
+
+	for (Bus &b : buses) {
+		if (b.users > 0 && b.scheduler == _bus_scheduler) {
+			if (--b.users == 0) {
+				delete b.scheduler;
+				delete b.adapter;
+				b.scheduler = nullptr;
+				b.adapter = nullptr;
+			}
+
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&buses_mutex);
+
+	_bus_scheduler = nullptr;
+	_bus_device = -1;
+}
+
 int
 I2C::transfer(const uint8_t *send, const unsigned send_len, uint8_t *recv, const unsigned recv_len)
 {
-#ifndef __PX4_LINUX
-	return PX4_ERROR;
-#else
-	struct i2c_msg msgv[2];
-	unsigned msgs;
 	int ret = PX4_ERROR;
 	unsigned retry_count = 0;
 
-	if (_fd < 0) {
+	if (_bus_scheduler == nullptr) {
 		PX4_ERR("I2C device not opened");
 		return 1;
 	}
 
+	if (send_len == 0 && recv_len == 0) {
+		return -EINVAL;
+	}
+
+	if (_bus_address != get_device_address()) {
+		// the driver changed the address, e.g. while probing
+		_bus_address = get_device_address();
+		_bus_scheduler->setDeviceAddress(_bus_device, _bus_address);
+	}
+
 	do {
 		DEVICE_DEBUG("transfer out %p/%u  in %p/%u", send, send_len, recv, recv_len);
-		msgs = 0;
-
-		if (send_len > 0) {
-			msgv[msgs].addr = get_device_address();
-			msgv[msgs].flags = 0;
-			msgv[msgs].buf = const_cast<uint8_t *>(send);
-			msgv[msgs].len = send_len;
-			msgs++;
-		}
 
-		if (recv_len > 0) {
-			msgv[msgs].addr = get_device_address();
-			msgv[msgs].flags = I2C_M_READ;
-			msgv[msgs].buf = recv;
-			msgv[msgs].len = recv_len;
-			msgs++;
-		}
+		ret = _bus_scheduler->transfer(_bus_device, send, send_len, recv, recv_len);
 
-		if (msgs == 0) {
-			return -EINVAL;
+		/* success */
+		if (ret == PX4_OK) {
+			break;
 		}
 
-		struct i2c_rdwr_ioctl_data packets;
-
-		packets.msgs  = msgv;
+		ret = PX4_ERROR;
 
-		packets.nmsgs = msgs;
+	} while (retry_count++ < _retries);
 
-		if (simulate) {
-			DEVICE_DEBUG("I2C SIM: transfer_4 on %s", get_devname());
-			ret = PX4_OK;
+	return ret;
+}
 
-		} else {
-			ret = ::ioctl(_fd, I2C_RDWR, (unsigned long)&packets);
+int
+I2C::submit_transfer(I2CBusScheduler::Transfer &transfer)
+{
+	if (_bus_scheduler == nullptr) {
+		return -ENODEV;
+	}
 
-			if (ret == -1) {
-				DEVICE_DEBUG("I2C transfer failed");
-				ret = PX4_ERROR;
+	transfer.device = _bus_device;
+	return _bus_scheduler->submit(transfer);
+}
 
-			} else {
-				ret = PX4_OK;
-			}
-		}
+void
+I2C::flush_bus()
+{
+	if (_bus_scheduler != nullptr) {
+		_bus_scheduler->flush(hrt_absolute_time(), _bus_device);
+	}
+}
 
-		/* success */
-		if (ret == PX4_OK) {
-			break;
-		}
+void
+I2C::print_bus_stats()
+{
+	if (_bus_scheduler == nullptr) {
+		return;
+	}
 
-	} while (retry_count++ < _retries);
+	const I2CBusScheduler::DeviceStats stats = _bus_scheduler->getDeviceStats(_bus_device);
 
-	return ret;
-#endif
+	PX4_INFO("i2c-%d 0x%02x: %u transfers, %u errors, %u bytes, %.3f s bus time",
+		 get_device_bus(), stats.address, stats.transfers, stats.errors, stats.bytes, (double)(stats.bus_time_us * 1e-6));
+	PX4_INFO("i2c-%d: %u transactions, %u transfers batched",
+		 get_device_bus(), _bus_scheduler->getTransactionCount(), _bus_scheduler->getBatchedTransferCount());
 }
 
 } // namespace device
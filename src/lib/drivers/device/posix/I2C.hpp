@@ -41,6 +41,7 @@
 #define _DEVICE_I2C_H
 
 #include "../CDev.hpp"
+#include "I2CBusScheduler.hpp"
 
 #include <px4_i2c.h>
 
@@ -62,6 +63,11 @@ public:
 
 	virtual int	init();
 
+	/**
+	 * Print the transfer and error counts and the bus time of the device.
+	 */
+	void		print_bus_stats();
+
 protected:
 	/**
 	 * The number of times a read or write operation will be retried on
@@ -100,10 +106,30 @@ protected:
 	 */
 	int		transfer(const uint8_t *send, const unsigned send_len, uint8_t *recv, const unsigned recv_len);
 
+	/**
+	 * Queue a transfer on the bus, to be executed together with the other transfers
+	 * on the bus that are due at the same time. The device field is set by this call.
+	 *
+	 * @param transfer	Transfer descriptor, must stay valid until it is executed.
+	 * @return		OK if queued, -errno otherwise.
+	 */
+	int		submit_transfer(I2CBusScheduler::Transfer &transfer);
+
+	/**
+	 * Execute the queued transfers of this device that are due, in as few transactions as
+	 * possible, and call their callbacks on the calling thread. Transfers of other devices
+	 * on the bus are left to their drivers.
+	 */
+	void		flush_bus();
+
 	bool		external() { return px4_i2c_bus_external(_device_id.devid_s.bus); }
 
 private:
-	int 			_fd{-1};
+	I2CBusScheduler		*_bus_scheduler{nullptr};	///< shared by all devices on the bus
+	int			_bus_device{-1};		///< handle of this device in the bus scheduler
+	uint16_t		_bus_address{0};		///< address registered with the bus scheduler
+
+	void			release_bus();
 
 	I2C(const device::I2C &);
 	I2C operator=(const device::I2C &);
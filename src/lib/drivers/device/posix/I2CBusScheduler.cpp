@@ -0,0 +1,318 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file I2CBusScheduler.cpp
+ */
+
+#include "I2CBusScheduler.hpp"
+
+namespace device
+{
+
+I2CBusScheduler::I2CBusScheduler(Adapter &adapter, uint32_t frequency) :
+	_adapter(adapter),
+	_frequency(frequency)
+{
+	pthread_mutex_init(&_mutex, nullptr);
+}
+
+I2CBusScheduler::~I2CBusScheduler()
+{
+	pthread_mutex_destroy(&_mutex);
+}
+
+int I2CBusScheduler::registerDevice(uint16_t address)
+{
+	int device = -ENOMEM;
+
+	pthread_mutex_lock(&_mutex);
+
+	for (unsigned i = 0; i < MAX_DEVICES; i++) {
+		if (!_devices[i].used) {
+			_devices[i].used = true;
+			_devices[i].stats = DeviceStats{};
+			_devices[i].stats.address = address;
+			device = i;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&_mutex);
+
+	return device;
+}
+
+void I2CBusScheduler::setDeviceAddress(int device, uint16_t address)
+{
+	if (device < 0 || device >= (int)MAX_DEVICES) {
+		return;
+	}
+
+	pthread_mutex_lock(&_mutex);
+	_devices[device].stats.address = address;
+	pthread_mutex_unlock(&_mutex);
+}
+
+void I2CBusScheduler::unregisterDevice(int device)
+{
+	if (device < 0 || device >= (int)MAX_DEVICES) {
+		return;
+	}
+
+	pthread_mutex_lock(&_mutex);
+
+	unsigned kept = 0;
+
+	for (unsigned i = 0; i < _pending_count; i++) {
+		if (_pending[i]->device == device) {
+			_pending[i]->result = -ENODEV;
+
+		} else {
+			_pending[kept++] = _pending[i];
+		}
+	}
+
+	_pending_count = kept;
+	_devices[device].used = false;
+
+	pthread_mutex_unlock(&_mutex);
+}
+
+int I2CBusScheduler::transfer(int device, const uint8_t *send, unsigned send_len, uint8_t *recv, unsigned recv_len)
+{
+	Transfer transfer{};
+	transfer.device = device;
+	transfer.send = send;
+	transfer.send_len = send_len;
+	transfer.recv = recv;
+	transfer.recv_len = recv_len;
+
+	if (!_valid(transfer)) {
+		return -EINVAL;
+	}
+
+	Transfer *transfers[1] {&transfer};
+
+	pthread_mutex_lock(&_mutex);
+	_execute(transfers, 1);
+	pthread_mutex_unlock(&_mutex);
+
+	return transfer.result;
+}
+
+int I2CBusScheduler::submit(Transfer &transfer)
+{
+	if (!_valid(transfer)) {
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&_mutex);
+
+	if (_pending_count >= MAX_PENDING) {
+		pthread_mutex_unlock(&_mutex);
+		return -EBUSY;
+	}
+
+	transfer.result = -EINPROGRESS;
+
+	// keep the queue sorted by due time, in submission order for the same due time
+	unsigned index = _pending_count;
+
+	while (index > 0 && _pending[index - 1]->due_us > transfer.due_us) {
+		_pending[index] = _pending[index - 1];
+		index--;
+	}
+
+	_pending[index] = &transfer;
+	_pending_count++;
+
+	pthread_mutex_unlock(&_mutex);
+
+	return 0;
+}
+
+unsigned I2CBusScheduler::flush(uint64_t now, int device)
+{
+	Transfer *transfers[MAX_PENDING];
+
+	pthread_mutex_lock(&_mutex);
+
+	const unsigned count = _takeDue(now, device, transfers, MAX_PENDING);
+	_execute(transfers, count);
+
+	pthread_mutex_unlock(&_mutex);
+
+	for (unsigned i = 0; i < count; i++) {
+		if (transfers[i]->callback) {
+			transfers[i]->callback(*transfers[i], transfers[i]->context);
+		}
+	}
+
+	return count;
+}
+
+uint64_t I2CBusScheduler::nextDue()
+{
+	pthread_mutex_lock(&_mutex);
+	const uint64_t due = (_pending_count > 0) ? _pending[0]->due_us : UINT64_MAX;
+	pthread_mutex_unlock(&_mutex);
+
+	return due;
+}
+
+I2CBusScheduler::DeviceStats I2CBusScheduler::getDeviceStats(int device)
+{
+	DeviceStats stats{};
+
+	if (device >= 0 && device < (int)MAX_DEVICES) {
+		pthread_mutex_lock(&_mutex);
+		stats = _devices[device].stats;
+		pthread_mutex_unlock(&_mutex);
+	}
+
+	return stats;
+}
+
+void I2CBusScheduler::_execute(Transfer **transfers, unsigned count)
+{
+	Message messages[MAX_MESSAGES];
+	unsigned first = 0;
+
+	while (first < count) {
+		// pack as many transfers as fit into one transaction
+		unsigned message_count = 0;
+		unsigned last = first;
+
+		while (last < count && message_count + 2 <= MAX_MESSAGES) {
+			message_count += _fillMessages(*transfers[last], &messages[message_count]);
+			last++;
+		}
+
+		const int ret = _adapter.transfer(messages, message_count);
+		_transaction_count++;
+
+		// the failing message is unknown, all transfers of the transaction report the error
+		for (unsigned i = first; i < last; i++) {
+			transfers[i]->result = ret;
+			_account(*transfers[i]);
+		}
+
+		if (ret == 0 && last - first > 1) {
+			_batched_transfer_count += last - first;
+		}
+
+		first = last;
+	}
+}
+
+unsigned I2CBusScheduler::_takeDue(uint64_t now, int device, Transfer **out, unsigned max_count)
+{
+	unsigned count = 0;
+	unsigned kept = 0;
+
+	// the queue is sorted by due time, the remaining transfers keep their order
+	for (unsigned i = 0; i < _pending_count; i++) {
+		Transfer *transfer = _pending[i];
+
+		if (count < max_count && transfer->due_us <= now && (device < 0 || transfer->device == device)) {
+			out[count++] = transfer;
+
+		} else {
+			_pending[kept++] = transfer;
+		}
+	}
+
+	_pending_count = kept;
+
+	return count;
+}
+
+unsigned I2CBusScheduler::_fillMessages(const Transfer &transfer, Message *messages) const
+{
+	const uint16_t address = _devices[transfer.device].stats.address;
+	unsigned count = 0;
+
+	if (transfer.send_len > 0) {
+		messages[count].address = address;
+		messages[count].flags = 0;
+		messages[count].length = transfer.send_len;
+		messages[count].buffer = const_cast<uint8_t *>(transfer.send);
+		count++;
+	}
+
+	if (transfer.recv_len > 0) {
+		messages[count].address = address;
+		messages[count].flags = Message::FLAG_READ;
+		messages[count].length = transfer.recv_len;
+		messages[count].buffer = transfer.recv;
+		count++;
+	}
+
+	return count;
+}
+
+void I2CBusScheduler::_account(const Transfer &transfer)
+{
+	DeviceStats &stats = _devices[transfer.device].stats;
+
+	stats.transfers++;
+
+	if (transfer.result != 0) {
+		stats.errors++;
+
+	} else {
+		stats.bytes += transfer.send_len + transfer.recv_len;
+	}
+
+	// start condition, address and data bytes with acknowledge bit per message
+	unsigned bits = 0;
+
+	if (transfer.send_len > 0) {
+		bits += 1 + 9 * (1 + transfer.send_len);
+	}
+
+	if (transfer.recv_len > 0) {
+		bits += 1 + 9 * (1 + transfer.recv_len);
+	}
+
+	stats.bus_time_us += (uint64_t)bits * 1000000 / _frequency;
+}
+
+bool I2CBusScheduler::_valid(const Transfer &transfer) const
+{
+	return transfer.device >= 0 && transfer.device < (int)MAX_DEVICES && _devices[transfer.device].used
+	       && (transfer.send_len > 0 || transfer.recv_len > 0)
+	       && transfer.send_len <= UINT16_MAX && transfer.recv_len <= UINT16_MAX;
+}
+
+} // namespace device
@@ -0,0 +1,207 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file I2CBusScheduler.hpp
+ *
+ * Per-bus I2C transaction scheduler.
+ *
+ * All devices on a bus share one scheduler owning the adapter. Drivers either call
+ * transfer() synchronously, which only executes that transfer, or submit() a transfer
+ * descriptor with a due time. flush() packs all transfers that are due into a single
+ * combined transaction (one I2C_RDWR ioctl on Linux), which saves a syscall per transfer.
+ * flush() executes the transfers and callbacks of all devices on the bus, so it is meant
+ * to be called from the work queue of the bus which runs the drivers of the bus.
+ * flush() of a single device only executes the transfers of that device.
+ *
+ * A failed combined transaction is not repeated: the adapter does not tell which message
+ * failed and reads of FIFOs or writes must not be executed twice. All its transfers report
+ * the error and the drivers decide whether to retry.
+ *
+ * The scheduler keeps per-device statistics of the transfers, errors and bus time.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+
+namespace device
+{
+
+class I2CBusScheduler
+{
+public:
+	static constexpr unsigned MAX_MESSAGES = 42; ///< I2C_RDWR_IOCTL_MAX_MSGS
+	static constexpr unsigned MAX_DEVICES = 16;
+	static constexpr unsigned MAX_PENDING = 32;
+
+	/** One segment of a combined transaction, layout independent of the OS */
+	struct Message {
+		static constexpr uint16_t FLAG_READ = 0x0001;
+
+		uint16_t address;
+		uint16_t flags;
+		uint16_t length;
+		uint8_t *buffer;
+	};
+
+	/** The bus driver, e.g. a Linux i2c-dev file descriptor */
+	class Adapter
+	{
+	public:
+		virtual ~Adapter() = default;
+
+		/**
+		 * Execute the messages as one combined transaction (repeated start in between)
+		 * @return 0 on success, -errno otherwise
+		 */
+		virtual int transfer(Message *messages, unsigned count) = 0;
+	};
+
+	struct Transfer {
+		int device; ///< handle returned by registerDevice()
+		const uint8_t *send;
+		unsigned send_len;
+		uint8_t *recv;
+		unsigned recv_len;
+		uint64_t due_us; ///< time at which the transfer should be executed, 0 for the next bus access
+
+		/** called after the transfer was executed, it may submit() again */
+		void (*callback)(Transfer &transfer, void *context);
+		void *context;
+
+		int result; ///< -EINPROGRESS while pending, 0 or -errno once executed
+	};
+
+	struct DeviceStats {
+		uint16_t address;
+		uint32_t transfers;
+		uint32_t errors;
+		uint32_t bytes;
+		uint64_t bus_time_us; ///< time the bus was occupied by the transfers of the device
+	};
+
+	/**
+	 * @param adapter bus driver, must outlive the scheduler
+	 * @param frequency bus frequency used to compute the bus time [Hz]
+	 */
+	I2CBusScheduler(Adapter &adapter, uint32_t frequency = 400000);
+	~I2CBusScheduler();
+
+	/**
+	 * @return device handle, -ENOMEM if all device slots are used
+	 */
+	int registerDevice(uint16_t address);
+
+	/**
+	 * Change the address of a device, e.g. while probing
+	 */
+	void setDeviceAddress(int device, uint16_t address);
+
+	/**
+	 * Release a device handle, pending transfers of the device are dropped
+	 */
+	void unregisterDevice(int device);
+
+	/**
+	 * Execute a transfer right away, on its own. Pending transfers are left to flush().
+	 * At least one of send_len and recv_len must be non-zero.
+	 * @return 0 on success, -errno otherwise
+	 */
+	int transfer(int device, const uint8_t *send, unsigned send_len, uint8_t *recv, unsigned recv_len);
+
+	/**
+	 * Queue a transfer until it is due. The descriptor and its buffers must stay valid until the callback.
+	 * @return 0 if queued, -EINVAL for an invalid descriptor, -EBUSY if the queue is full
+	 */
+	int submit(Transfer &transfer);
+
+	/**
+	 * Execute all pending transfers that are due and call their callbacks
+	 * @param device only execute the transfers of this device, -1 for all devices
+	 * @return number of executed transfers
+	 */
+	unsigned flush(uint64_t now, int device = -1);
+
+	/**
+	 * @return due time of the earliest pending transfer, UINT64_MAX if there is none
+	 */
+	uint64_t nextDue();
+
+	DeviceStats getDeviceStats(int device);
+
+	/** number of adapter transactions (syscalls) */
+	uint32_t getTransactionCount() const { return _transaction_count; }
+
+	/** number of transfers executed in a combined transaction with other transfers */
+	uint32_t getBatchedTransferCount() const { return _batched_transfer_count; }
+
+private:
+	struct Device {
+		DeviceStats stats;
+		bool used;
+	};
+
+	/**
+	 * Execute the transfers in as few transactions as possible, the lock must be held
+	 */
+	void _execute(Transfer **transfers, unsigned count);
+
+	/**
+	 * Remove the due transfers (of a device, or all if -1) from the pending queue, the lock must be held
+	 * @return number of transfers written to out
+	 */
+	unsigned _takeDue(uint64_t now, int device, Transfer **out, unsigned max_count);
+
+	unsigned _fillMessages(const Transfer &transfer, Message *messages) const;
+
+	void _account(const Transfer &transfer);
+
+	bool _valid(const Transfer &transfer) const;
+
+	Adapter &_adapter;
+	const uint32_t _frequency;
+
+	pthread_mutex_t _mutex;
+
+	Device _devices[MAX_DEVICES] {};
+
+	Transfer *_pending[MAX_PENDING] {};
+	unsigned _pending_count{0};
+
+	uint32_t _transaction_count{0};
+	uint32_t _batched_transfer_count{0};
+};
+
+} // namespace device
@@ -0,0 +1,364 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * Test code for the I2C bus scheduler
+ * Run this test only using make tests TESTFILTER=I2CBusScheduler
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "I2CBusScheduler.hpp"
+
+using namespace device;
+
+static const uint16_t BARO = 0x77;
+static const uint16_t MAG = 0x1e;
+static const uint16_t POWER = 0x40;
+
+/** Adapter that records the transactions and NAKs a configurable address */
+class FakeAdapter : public I2CBusScheduler::Adapter
+{
+public:
+	int transfer(I2CBusScheduler::Message *messages, unsigned count) override
+	{
+		transactions.push_back(std::vector<I2CBusScheduler::Message>(messages, messages + count));
+
+		for (unsigned i = 0; i < count; i++) {
+			if (messages[i].address == nak_address) {
+				// the transaction is aborted
+				return -EIO;
+			}
+
+			if (messages[i].flags & I2CBusScheduler::Message::FLAG_READ) {
+				for (unsigned k = 0; k < messages[i].length; k++) {
+					messages[i].buffer[k] = messages[i].address + k;
+				}
+			}
+		}
+
+		return 0;
+	}
+
+	std::vector<std::vector<I2CBusScheduler::Message>> transactions;
+	uint16_t nak_address{0};
+};
+
+class I2CBusSchedulerTest : public ::testing::Test
+{
+public:
+	/** Register read of a device: write the register address, read the data */
+	struct Read {
+		I2CBusScheduler::Transfer transfer{};
+		uint8_t reg{0};
+		uint8_t data[6] {};
+		int callbacks{0};
+	};
+
+	void prepare(Read &read, int device, uint64_t due_us)
+	{
+		read.transfer.device = device;
+		read.transfer.send = &read.reg;
+		read.transfer.send_len = 1;
+		read.transfer.recv = read.data;
+		read.transfer.recv_len = sizeof(read.data);
+		read.transfer.due_us = due_us;
+		read.transfer.context = &read;
+		read.transfer.callback = [](I2CBusScheduler::Transfer &, void *context) {
+			static_cast<Read *>(context)->callbacks++;
+		};
+	}
+
+	FakeAdapter _adapter;
+	I2CBusScheduler _scheduler{_adapter};
+};
+
+TEST_F(I2CBusSchedulerTest, synchronousTransfer)
+{
+	const int baro = _scheduler.registerDevice(BARO);
+	ASSERT_GE(baro, 0);
+
+	uint8_t reg = 0xAA;
+	uint8_t data[3] {};
+	EXPECT_EQ(_scheduler.transfer(baro, &reg, 1, data, sizeof(data)), 0);
+
+	// THEN: one transaction with a write and a read message
+	ASSERT_EQ(_adapter.transactions.size(), 1u);
+	ASSERT_EQ(_adapter.transactions[0].size(), 2u);
+	EXPECT_EQ(_adapter.transactions[0][0].address, BARO);
+	EXPECT_EQ(_adapter.transactions[0][0].flags, 0);
+	EXPECT_EQ(_adapter.transactions[0][1].flags, (uint16_t)I2CBusScheduler::Message::FLAG_READ);
+	EXPECT_EQ(data[2], BARO + 2);
+
+	// AND: invalid transfers are rejected without bus access
+	EXPECT_EQ(_scheduler.transfer(baro, nullptr, 0, nullptr, 0), -EINVAL);
+	EXPECT_EQ(_scheduler.transfer(baro + 1, &reg, 1, nullptr, 0), -EINVAL);
+	EXPECT_EQ(_adapter.transactions.size(), 1u);
+}
+
+TEST_F(I2CBusSchedulerTest, dueTransfersShareOneIoctl)
+{
+	// GIVEN: a barometer, a magnetometer and a power monitor reading at the same time
+	Read baro, mag, power;
+	prepare(baro, _scheduler.registerDevice(BARO), 10000);
+	prepare(mag, _scheduler.registerDevice(MAG), 10000);
+	prepare(power, _scheduler.registerDevice(POWER), 10000);
+
+	EXPECT_EQ(_scheduler.submit(baro.transfer), 0);
+	EXPECT_EQ(_scheduler.submit(mag.transfer), 0);
+	EXPECT_EQ(_scheduler.submit(power.transfer), 0);
+	EXPECT_EQ(baro.transfer.result, -EINPROGRESS);
+	EXPECT_EQ(_scheduler.nextDue(), 10000u);
+
+	// WHEN: the bus is flushed before they are due
+	EXPECT_EQ(_scheduler.flush(9999), 0u);
+
+	// THEN: nothing happens
+	EXPECT_TRUE(_adapter.transactions.empty());
+	EXPECT_EQ(baro.callbacks, 0);
+
+	// WHEN: they are due
+	EXPECT_EQ(_scheduler.flush(10000), 3u);
+
+	// THEN: a single transaction reads all of them in submission order
+	ASSERT_EQ(_adapter.transactions.size(), 1u);
+	ASSERT_EQ(_adapter.transactions[0].size(), 6u);
+	EXPECT_EQ(_adapter.transactions[0][0].address, BARO);
+	EXPECT_EQ(_adapter.transactions[0][2].address, MAG);
+	EXPECT_EQ(_adapter.transactions[0][4].address, POWER);
+
+	EXPECT_EQ(baro.transfer.result, 0);
+	EXPECT_EQ(mag.transfer.result, 0);
+	EXPECT_EQ(power.transfer.result, 0);
+	EXPECT_EQ(baro.callbacks, 1);
+	EXPECT_EQ(mag.callbacks, 1);
+	EXPECT_EQ(power.callbacks, 1);
+	EXPECT_EQ(mag.data[0], MAG);
+
+	EXPECT_EQ(_scheduler.getTransactionCount(), 1u);
+	EXPECT_EQ(_scheduler.getBatchedTransferCount(), 3u);
+	EXPECT_EQ(_scheduler.nextDue(), UINT64_MAX);
+
+	// AND: the statistics are per device: 2 messages of (address + 1 byte) and (address + 6 bytes) at 400kHz
+	const I2CBusScheduler::DeviceStats stats = _scheduler.getDeviceStats(mag.transfer.device);
+	EXPECT_EQ(stats.address, MAG);
+	EXPECT_EQ(stats.transfers, 1u);
+	EXPECT_EQ(stats.errors, 0u);
+	EXPECT_EQ(stats.bytes, 7u);
+	EXPECT_EQ(stats.bus_time_us, (uint64_t)((1 + 9 * 2) + (1 + 9 * 7)) * 1000000 / 400000);
+}
+
+TEST_F(I2CBusSchedulerTest, orderingByDueTime)
+{
+	Read late, early, middle, middle_second;
+	const int baro = _scheduler.registerDevice(BARO);
+	const int mag = _scheduler.registerDevice(MAG);
+	const int power = _scheduler.registerDevice(POWER);
+	prepare(late, baro, 3000);
+	prepare(early, mag, 1000);
+	prepare(middle, power, 2000);
+	prepare(middle_second, baro, 2000);
+
+	_scheduler.submit(late.transfer);
+	_scheduler.submit(early.transfer);
+	_scheduler.submit(middle.transfer);
+	_scheduler.submit(middle_second.transfer);
+
+	// WHEN: a synchronous transfer happens at 2500
+	uint8_t reg = 0;
+	EXPECT_EQ(_scheduler.transfer(mag, &reg, 1, nullptr, 0), 0);
+
+	// THEN: it is executed on its own
+	ASSERT_EQ(_adapter.transactions.size(), 1u);
+	ASSERT_EQ(_adapter.transactions[0].size(), 1u);
+	EXPECT_EQ(_adapter.transactions[0][0].address, MAG);
+	EXPECT_EQ(early.transfer.result, -EINPROGRESS);
+	EXPECT_EQ(early.callbacks, 0);
+
+	// WHEN: the bus is flushed at 2500
+	EXPECT_EQ(_scheduler.flush(2500), 3u);
+
+	// THEN: the due transfers are executed in one transaction, sorted by due time
+	ASSERT_EQ(_adapter.transactions.size(), 2u);
+	const std::vector<I2CBusScheduler::Message> &messages = _adapter.transactions[1];
+	ASSERT_EQ(messages.size(), 6u);
+	EXPECT_EQ(messages[0].address, MAG); // early
+	EXPECT_EQ(messages[2].address, POWER); // middle
+	EXPECT_EQ(messages[4].address, BARO); // middle_second
+
+	// AND: the late transfer is still pending
+	EXPECT_EQ(late.transfer.result, -EINPROGRESS);
+	EXPECT_EQ(_scheduler.nextDue(), 3000u);
+	EXPECT_EQ(_scheduler.flush(3000), 1u);
+	EXPECT_EQ(_adapter.transactions.size(), 3u);
+	EXPECT_EQ(late.callbacks, 1);
+}
+
+TEST_F(I2CBusSchedulerTest, failedTransactionIsNotRepeated)
+{
+	// GIVEN: a magnetometer that does not acknowledge
+	_adapter.nak_address = MAG;
+
+	Read baro, mag, power;
+	prepare(baro, _scheduler.registerDevice(BARO), 1000);
+	prepare(mag, _scheduler.registerDevice(MAG), 1000);
+	prepare(power, _scheduler.registerDevice(POWER), 1000);
+	_scheduler.submit(baro.transfer);
+	_scheduler.submit(mag.transfer);
+	_scheduler.submit(power.transfer);
+
+	// WHEN: the combined transaction fails
+	EXPECT_EQ(_scheduler.flush(1000), 3u);
+
+	// THEN: it is not repeated, since the failing message is unknown
+	EXPECT_EQ(_adapter.transactions.size(), 1u);
+
+	// AND: all its transfers report the error
+	EXPECT_EQ(baro.transfer.result, -EIO);
+	EXPECT_EQ(mag.transfer.result, -EIO);
+	EXPECT_EQ(power.transfer.result, -EIO);
+	EXPECT_EQ(baro.callbacks, 1);
+	EXPECT_EQ(mag.callbacks, 1);
+	EXPECT_EQ(power.callbacks, 1);
+
+	EXPECT_EQ(_scheduler.getDeviceStats(mag.transfer.device).errors, 1u);
+	EXPECT_EQ(_scheduler.getDeviceStats(baro.transfer.device).errors, 1u);
+	EXPECT_EQ(_scheduler.getBatchedTransferCount(), 0u);
+}
+
+TEST_F(I2CBusSchedulerTest, transactionSizeIsLimited)
+{
+	// GIVEN: more due transfers than fit into one I2C_RDWR
+	const int baro = _scheduler.registerDevice(BARO);
+	Read reads[30];
+
+	for (Read &read : reads) {
+		prepare(read, baro, 1000);
+		EXPECT_EQ(_scheduler.submit(read.transfer), 0);
+	}
+
+	EXPECT_EQ(_scheduler.flush(1000), 30u);
+
+	// THEN: they are split into as few transactions as possible
+	ASSERT_EQ(_adapter.transactions.size(), 2u);
+	EXPECT_EQ(_adapter.transactions[0].size(), (size_t)I2CBusScheduler::MAX_MESSAGES);
+	EXPECT_EQ(_adapter.transactions[1].size(), (size_t)(60 - I2CBusScheduler::MAX_MESSAGES));
+
+	// AND: the queue size is bounded
+	Read more[I2CBusScheduler::MAX_PENDING + 1];
+
+	for (unsigned i = 0; i < I2CBusScheduler::MAX_PENDING; i++) {
+		prepare(more[i], baro, 2000);
+		EXPECT_EQ(_scheduler.submit(more[i].transfer), 0);
+	}
+
+	prepare(more[I2CBusScheduler::MAX_PENDING], baro, 2000);
+	EXPECT_EQ(_scheduler.submit(more[I2CBusScheduler::MAX_PENDING].transfer), -EBUSY);
+}
+
+TEST_F(I2CBusSchedulerTest, periodicResubmitAndUnregister)
+{
+	// GIVEN: a transfer that is resubmitted from its callback every 1000us
+	struct Periodic {
+		I2CBusScheduler *scheduler;
+		I2CBusScheduler::Transfer transfer;
+		uint8_t data[2];
+		int count;
+	} periodic{};
+
+	periodic.scheduler = &_scheduler;
+	periodic.transfer.device = _scheduler.registerDevice(POWER);
+	periodic.transfer.recv = periodic.data;
+	periodic.transfer.recv_len = sizeof(periodic.data);
+	periodic.transfer.due_us = 1000;
+	periodic.transfer.context = &periodic;
+	periodic.transfer.callback = [](I2CBusScheduler::Transfer & transfer, void *context) {
+		Periodic *p = static_cast<Periodic *>(context);
+		p->count++;
+		transfer.due_us += 1000;
+		p->scheduler->submit(transfer);
+	};
+
+	_scheduler.submit(periodic.transfer);
+
+	for (uint64_t now = 0; now <= 5500; now += 500) {
+		_scheduler.flush(now);
+	}
+
+	EXPECT_EQ(periodic.count, 5);
+	EXPECT_EQ(_scheduler.nextDue(), 6000u);
+
+	// WHEN: the device is unregistered
+	_scheduler.unregisterDevice(periodic.transfer.device);
+
+	// THEN: its pending transfer is dropped
+	EXPECT_EQ(_scheduler.nextDue(), UINT64_MAX);
+	EXPECT_EQ(periodic.transfer.result, -ENODEV);
+	EXPECT_EQ(_scheduler.flush(10000), 0u);
+	EXPECT_EQ(periodic.count, 5);
+}
+
+TEST_F(I2CBusSchedulerTest, flushOfOneDevice)
+{
+	// GIVEN: due transfers of two devices
+	Read baro_first, mag, baro_second;
+	const int baro = _scheduler.registerDevice(BARO);
+	prepare(baro_first, baro, 1000);
+	prepare(mag, _scheduler.registerDevice(MAG), 1000);
+	prepare(baro_second, baro, 1000);
+
+	_scheduler.submit(baro_first.transfer);
+	_scheduler.submit(mag.transfer);
+	_scheduler.submit(baro_second.transfer);
+
+	// WHEN: the barometer flushes its own transfers
+	EXPECT_EQ(_scheduler.flush(1000, baro), 2u);
+
+	// THEN: they share one transaction, the magnetometer transfer stays pending
+	ASSERT_EQ(_adapter.transactions.size(), 1u);
+	ASSERT_EQ(_adapter.transactions[0].size(), 4u);
+	EXPECT_EQ(_adapter.transactions[0][2].address, BARO);
+	EXPECT_EQ(baro_first.callbacks, 1);
+	EXPECT_EQ(baro_second.callbacks, 1);
+	EXPECT_EQ(mag.callbacks, 0);
+	EXPECT_EQ(mag.transfer.result, -EINPROGRESS);
+	EXPECT_EQ(_scheduler.nextDue(), 1000u);
+
+	// WHEN: the bus is flushed
+	EXPECT_EQ(_scheduler.flush(1000), 1u);
+
+	// THEN: the magnetometer is read
+	EXPECT_EQ(mag.callbacks, 1);
+	EXPECT_EQ(_scheduler.nextDue(), UINT64_MAX);
+}
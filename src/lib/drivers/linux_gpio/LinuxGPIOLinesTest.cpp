@@ -0,0 +1,319 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the Linux GPIO character device interface
+ * Run this test only using make tests TESTFILTER=LinuxGPIOLines
+ *
+ * The tests on lines need a simulated GPIO chip with at least 4 lines, e.g.
+ *   sudo modprobe gpio-mockup gpio_mockup_ranges=-1,8
+ * (with debugfs mounted) or a gpio-sim chip, and are skipped without one.
+ */
+
+#include <gtest/gtest.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/gpio.h>
+
+#include "linux_gpio_lines.h"
+
+static constexpr unsigned NUM_TEST_LINES = 4;
+
+static uint64_t monotonic_ns()
+{
+	struct timespec ts {};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static bool exists(const char *path)
+{
+	struct stat statbuf;
+	return stat(path, &statbuf) == 0;
+}
+
+class LinuxGPIOLinesTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		for (unsigned i = 0; i < 32 && _chip[0] == '\0'; i++) {
+			char name[16];
+			snprintf(name, sizeof(name), "gpiochip%u", i);
+
+			char path[128];
+			snprintf(path, sizeof(path), "/sys/kernel/debug/gpio-mockup/%s", name);
+			const bool mockup = exists(path);
+
+			snprintf(path, sizeof(path), "/sys/bus/gpio/devices/%s/sim_gpio0", name);
+			const bool sim = exists(path);
+
+			if ((mockup || sim) && numLines(name) >= NUM_TEST_LINES) {
+				snprintf(_chip, sizeof(_chip), "%s", name);
+				_mockup = mockup;
+			}
+		}
+
+		if (_chip[0] == '\0') {
+			printf("no gpio-mockup or gpio-sim chip, line tests skipped\n");
+		}
+	}
+
+	/**
+	 * Drives a simulated input line.
+	 */
+	bool pull(unsigned offset, bool high)
+	{
+		char path[128];
+
+		if (_mockup) {
+			snprintf(path, sizeof(path), "/sys/kernel/debug/gpio-mockup/%s/%u", _chip, offset);
+
+		} else {
+			snprintf(path, sizeof(path), "/sys/bus/gpio/devices/%s/sim_gpio%u/pull", _chip, offset);
+		}
+
+		FILE *file = fopen(path, "w");
+
+		if (file == nullptr) {
+			return false;
+		}
+
+		if (_mockup) {
+			fprintf(file, "%d", high ? 1 : 0);
+
+		} else {
+			fprintf(file, "%s", high ? "pull-up" : "pull-down");
+		}
+
+		return fclose(file) == 0;
+	}
+
+	bool waitForEvents(LinuxGPIOLines &lines, int timeout_ms = 100)
+	{
+		struct pollfd fds {};
+		fds.fd = lines.getFd();
+		fds.events = POLLIN;
+		return ::poll(&fds, 1, timeout_ms) > 0;
+	}
+
+	char _chip[16] {};
+	bool _mockup{false};
+
+private:
+	static unsigned numLines(const char *name)
+	{
+		char path[32];
+		snprintf(path, sizeof(path), "/dev/%s", name);
+		const int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+		if (fd == -1) {
+			return 0;
+		}
+
+		struct gpiochip_info info {};
+		const int ret = ioctl(fd, GPIO_GET_CHIPINFO_IOCTL, &info);
+		close(fd);
+		return ret == 0 ? info.lines : 0;
+	}
+};
+
+TEST(LinuxGPIOLinesParseTest, ValidLine)
+{
+	char chip[32];
+	unsigned offset = 0;
+
+	EXPECT_TRUE(LinuxGPIOLines::parseLine("gpiochip0:23", chip, sizeof(chip), offset));
+	EXPECT_STREQ(chip, "gpiochip0");
+	EXPECT_EQ(offset, 23u);
+
+	EXPECT_TRUE(LinuxGPIOLines::parseLine("/dev/gpiochip12:0", chip, sizeof(chip), offset));
+	EXPECT_STREQ(chip, "/dev/gpiochip12");
+	EXPECT_EQ(offset, 0u);
+}
+
+TEST(LinuxGPIOLinesParseTest, InvalidLine)
+{
+	char chip[8];
+	unsigned offset = 0;
+
+	EXPECT_FALSE(LinuxGPIOLines::parseLine("gpiochip0", chip, sizeof(chip), offset));
+	EXPECT_FALSE(LinuxGPIOLines::parseLine(":5", chip, sizeof(chip), offset));
+	EXPECT_FALSE(LinuxGPIOLines::parseLine("gpiochip0:", chip, sizeof(chip), offset));
+	EXPECT_FALSE(LinuxGPIOLines::parseLine("gpiochip0:5a", chip, sizeof(chip), offset));
+	EXPECT_FALSE(LinuxGPIOLines::parseLine("gpiochip0:-1", chip, sizeof(chip), offset));
+	// does not fit
+	EXPECT_FALSE(LinuxGPIOLines::parseLine("gpiochip1234:5", chip, sizeof(chip), offset));
+}
+
+TEST(LinuxGPIOLinesParseTest, MissingChip)
+{
+	const unsigned offset = 0;
+	LinuxGPIOLines lines("gpiochip_missing", &offset, 1);
+
+	EXPECT_EQ(lines.request(LinuxGPIOLines::Direction::IN), -ENOENT);
+	EXPECT_EQ(lines.getFd(), -1);
+}
+
+TEST_F(LinuxGPIOLinesTest, BulkOutput)
+{
+	if (_chip[0] == '\0') {
+		return;
+	}
+
+	const unsigned offsets[NUM_TEST_LINES] = {0, 1, 2, 3};
+	LinuxGPIOLines lines(_chip, offsets, NUM_TEST_LINES);
+
+	ASSERT_EQ(lines.request(LinuxGPIOLines::Direction::OUT, LinuxGPIOLines::Edge::NONE, 0b0101), 0);
+
+	uint64_t values = 0;
+	ASSERT_EQ(lines.getValues(values), 0);
+	EXPECT_EQ(values, 0b0101u);
+
+	// all lines in one operation
+	ASSERT_EQ(lines.setValues(0b1010, 0b1111), 0);
+	ASSERT_EQ(lines.getValues(values), 0);
+	EXPECT_EQ(values, 0b1010u);
+
+	// only the lines in the mask change
+	ASSERT_EQ(lines.setValues(0b0001, 0b0011), 0);
+	ASSERT_EQ(lines.getValues(values), 0);
+	EXPECT_EQ(values, 0b1001u);
+
+	// a line can only be requested once
+	LinuxGPIOLines other(_chip, offsets, 1);
+	EXPECT_EQ(other.request(LinuxGPIOLines::Direction::IN), -EBUSY);
+}
+
+TEST_F(LinuxGPIOLinesTest, BulkInput)
+{
+	if (_chip[0] == '\0') {
+		return;
+	}
+
+	const unsigned offsets[NUM_TEST_LINES] = {0, 1, 2, 3};
+	LinuxGPIOLines lines(_chip, offsets, NUM_TEST_LINES);
+
+	ASSERT_EQ(lines.request(LinuxGPIOLines::Direction::IN), 0);
+
+	for (unsigned i = 0; i < NUM_TEST_LINES; i++) {
+		ASSERT_TRUE(pull(offsets[i], i == 1 || i == 2));
+	}
+
+	uint64_t values = 0;
+	ASSERT_EQ(lines.getValues(values), 0);
+	EXPECT_EQ(values, 0b0110u);
+}
+
+TEST_F(LinuxGPIOLinesTest, RisingEdgeTimestamp)
+{
+	if (_chip[0] == '\0') {
+		return;
+	}
+
+	// the lines are listed in a different order than on the chip
+	const unsigned offsets[2] = {3, 2};
+	ASSERT_TRUE(pull(2, false));
+	ASSERT_TRUE(pull(3, false));
+
+	LinuxGPIOLines lines(_chip, offsets, 2);
+	ASSERT_EQ(lines.request(LinuxGPIOLines::Direction::IN, LinuxGPIOLines::Edge::RISING), 0);
+
+	LinuxGPIOLines::Event events[8];
+	EXPECT_EQ(lines.readEvents(events, 8), 0);
+
+	const uint64_t before = monotonic_ns();
+	ASSERT_TRUE(pull(2, true));
+	const uint64_t after = monotonic_ns();
+
+	ASSERT_TRUE(waitForEvents(lines));
+	ASSERT_EQ(lines.readEvents(events, 8), 1);
+	EXPECT_EQ(events[0].index, 1u);
+	EXPECT_TRUE(events[0].rising);
+	// the timestamp is taken at the edge, not when the event is read
+	EXPECT_GE(events[0].timestamp_ns, before);
+	EXPECT_LE(events[0].timestamp_ns, after);
+
+	// falling edges are not reported
+	ASSERT_TRUE(pull(2, false));
+	EXPECT_FALSE(waitForEvents(lines, 20));
+	EXPECT_EQ(lines.readEvents(events, 8), 0);
+	EXPECT_EQ(lines.getMissedEvents(), 0u);
+}
+
+TEST_F(LinuxGPIOLinesTest, BothEdgesInOrder)
+{
+	if (_chip[0] == '\0') {
+		return;
+	}
+
+	const unsigned offset = 1;
+	ASSERT_TRUE(pull(offset, false));
+
+	LinuxGPIOLines lines(_chip, &offset, 1);
+	ASSERT_EQ(lines.request(LinuxGPIOLines::Direction::IN, LinuxGPIOLines::Edge::BOTH), 0);
+
+	static constexpr unsigned NUM_EDGES = 6;
+
+	for (unsigned i = 0; i < NUM_EDGES; i++) {
+		ASSERT_TRUE(pull(offset, i % 2 == 0));
+	}
+
+	LinuxGPIOLines::Event events[NUM_EDGES];
+	unsigned num = 0;
+
+	while (num < NUM_EDGES && waitForEvents(lines)) {
+		const int ret = lines.readEvents(events + num, NUM_EDGES - num);
+		ASSERT_GE(ret, 0);
+		num += ret;
+	}
+
+	ASSERT_EQ(num, NUM_EDGES);
+
+	for (unsigned i = 0; i < NUM_EDGES; i++) {
+		EXPECT_EQ(events[i].rising, i % 2 == 0);
+
+		if (i > 0) {
+			EXPECT_GE(events[i].timestamp_ns, events[i - 1].timestamp_ns);
+		}
+	}
+
+	EXPECT_EQ(lines.getMissedEvents(), 0u);
+}
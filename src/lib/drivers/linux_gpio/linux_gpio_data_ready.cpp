@@ -0,0 +1,203 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "linux_gpio_data_ready.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+#include <px4_log.h>
+#include <px4_posix.h>
+#include <px4_tasks.h>
+
+LinuxGPIODataReady::~LinuxGPIODataReady()
+{
+	stop();
+}
+
+int LinuxGPIODataReady::start(const char *line, LinuxGPIOLines::Edge edge, callback_t callback, void *arg,
+			      failure_callback_t failure_callback)
+{
+	stop();
+
+	char chip[32];
+	unsigned offset = 0;
+
+	if (!LinuxGPIOLines::parseLine(line, chip, sizeof(chip), offset)) {
+		PX4_ERR("data-ready %s: invalid line, expected <chip>:<offset>", line);
+		return -EINVAL;
+	}
+
+	_line = new LinuxGPIOLines(chip, &offset, 1);
+
+	if (_line == nullptr) {
+		return -ENOMEM;
+	}
+
+	int ret = _line->request(LinuxGPIOLines::Direction::IN, edge, 0, "px4 data-ready");
+
+	if (ret < 0) {
+		PX4_ERR("data-ready %s: request: %s (%d)", line, strerror(-ret), -ret);
+		delete _line;
+		_line = nullptr;
+		return ret;
+	}
+
+	_callback = callback;
+	_failure_callback = failure_callback;
+	_arg = arg;
+	_should_exit = false;
+	_edges = 0;
+	_running.store(true);
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, PX4_STACK_ADJUSTED(1024));
+
+	// the edges have interrupt priority, above the work queues
+	struct sched_param param {};
+	param.sched_priority = SCHED_PRIORITY_MAX;
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	pthread_attr_setschedparam(&attr, &param);
+
+	ret = pthread_create(&_thread, &attr, &LinuxGPIODataReady::threadEntry, this);
+
+	if (ret != 0) {
+		// without the permission for real-time priorities
+		PX4_WARN("data-ready %s: no real-time priority", line);
+		pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+		ret = pthread_create(&_thread, &attr, &LinuxGPIODataReady::threadEntry, this);
+	}
+
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		_running.store(false);
+		delete _line;
+		_line = nullptr;
+		return -ret;
+	}
+
+	_thread_started = true;
+	return 0;
+}
+
+void LinuxGPIODataReady::stop()
+{
+	if (_thread_started) {
+		_should_exit = true;
+		pthread_join(_thread, nullptr);
+		_thread_started = false;
+	}
+
+	_running.store(false);
+
+	delete _line;
+	_line = nullptr;
+}
+
+void *LinuxGPIODataReady::threadEntry(void *arg)
+{
+	px4_prctl(PR_SET_NAME, "gpio_drdy", px4_getpid());
+	static_cast<LinuxGPIODataReady *>(arg)->run();
+	return nullptr;
+}
+
+void LinuxGPIODataReady::run()
+{
+	struct pollfd fds {};
+	fds.fd = _line->getFd();
+	fds.events = POLLIN;
+
+	LinuxGPIOLines::Event events[16];
+
+	while (!_should_exit) {
+		// the timeout is for the exit request
+		if (::poll(&fds, 1, 100) <= 0) {
+			continue;
+		}
+
+		const int num = _line->readEvents(events, sizeof(events) / sizeof(events[0]));
+
+		if (num < 0) {
+			PX4_ERR("data-ready: read: %s (%d)", strerror(-num), -num);
+			_running.store(false);
+
+			if (_failure_callback) {
+				_failure_callback(_arg);
+			}
+
+			return;
+		}
+
+		// only the latest edge matters if the reader was late
+		if (num > 0) {
+			_edges += num;
+			_callback(_arg, toHrt(events[num - 1].timestamp_ns));
+		}
+	}
+}
+
+hrt_abstime LinuxGPIODataReady::toHrt(uint64_t timestamp_ns)
+{
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+	// the hrt is the simulation time
+	(void)timestamp_ns;
+	return hrt_absolute_time();
+#else
+	// the age of the edge on the kernel monotonic clock
+	struct timespec now {};
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	const hrt_abstime now_hrt = hrt_absolute_time();
+	const uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+	const hrt_abstime age = now_ns > timestamp_ns ? (now_ns - timestamp_ns) / 1000 : 0;
+
+	return now_hrt > age ? now_hrt - age : 0;
+#endif
+}
+
+void LinuxGPIODataReady::print_status() const
+{
+	if (_line == nullptr) {
+		PX4_INFO("data-ready: not running");
+		return;
+	}
+
+	PX4_INFO("data-ready: %u edges, %u missed", _edges, _line->getMissedEvents());
+}
@@ -0,0 +1,100 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file linux_gpio_data_ready.h
+ *
+ * Data-ready interrupt on a Linux GPIO line
+ *
+ * A thread waits for the edge events of the line and calls the callback with
+ * the timestamp of each edge, like the interrupt handler registered with
+ * px4_arch_gpiosetevent() on NuttX. Drivers store the timestamp as the sample
+ * time and schedule their work item from the callback. If the line cannot be
+ * read anymore, the thread ends and calls the failure callback, so that the
+ * driver can go back to its timer.
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include <drivers/drv_hrt.h>
+#include <px4_atomic.h>
+
+#include "linux_gpio_lines.h"
+
+class LinuxGPIODataReady
+{
+public:
+	typedef void (*callback_t)(void *arg, hrt_abstime timestamp);
+	typedef void (*failure_callback_t)(void *arg);
+
+	LinuxGPIODataReady() = default;
+	~LinuxGPIODataReady();
+
+	/**
+	 * @param line <chip>:<offset>, e.g. gpiochip0:23
+	 * @param failure_callback called from the thread if reading the line failed, no edges follow anymore
+	 * @return 0 on success, -errno otherwise
+	 */
+	int start(const char *line, LinuxGPIOLines::Edge edge, callback_t callback, void *arg,
+		  failure_callback_t failure_callback = nullptr);
+	void stop();
+
+	bool isRunning() const { return _running.load(); }
+
+	void print_status() const;
+
+	/**
+	 * Converts a kernel CLOCK_MONOTONIC timestamp to hrt time.
+	 */
+	static hrt_abstime toHrt(uint64_t timestamp_ns);
+
+private:
+	static void *threadEntry(void *arg);
+	void run();
+
+	LinuxGPIOLines *_line{nullptr};
+
+	callback_t _callback{nullptr};
+	failure_callback_t _failure_callback{nullptr};
+	void *_arg{nullptr};
+
+	pthread_t _thread{};
+	bool _thread_started{false};
+	px4::atomic_bool _running{false}; ///< false once the thread ended on an error
+	volatile bool _should_exit{false};
+
+	uint32_t _edges{0};
+};
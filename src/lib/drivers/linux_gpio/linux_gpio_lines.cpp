@@ -0,0 +1,248 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "linux_gpio_lines.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+LinuxGPIOLines::LinuxGPIOLines(const char *chip, const unsigned *offsets, unsigned num_lines)
+{
+	if (strncmp(chip, "/dev/", 5) == 0) {
+		snprintf(_chip, sizeof(_chip), "%s", chip);
+
+	} else {
+		snprintf(_chip, sizeof(_chip), "/dev/%s", chip);
+	}
+
+	_num_lines = num_lines < MaxLines ? num_lines : MaxLines;
+	memcpy(_offsets, offsets, _num_lines * sizeof(_offsets[0]));
+}
+
+LinuxGPIOLines::~LinuxGPIOLines()
+{
+	release();
+}
+
+#if defined(GPIO_V2_GET_LINE_IOCTL)
+
+int LinuxGPIOLines::request(Direction dir, Edge edge, uint64_t initial_values, const char *consumer)
+{
+	release();
+
+	if (_num_lines == 0) {
+		return -EINVAL;
+	}
+
+	struct gpio_v2_line_request req {};
+
+	memcpy(req.offsets, _offsets, _num_lines * sizeof(_offsets[0]));
+	snprintf(req.consumer, sizeof(req.consumer), "%s", consumer);
+	req.num_lines = _num_lines;
+	// room for a few edges per line while the reader is late
+	req.event_buffer_size = 16 * _num_lines;
+
+	if (dir == Direction::IN) {
+		req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+
+		if (edge == Edge::RISING || edge == Edge::BOTH) {
+			req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+		}
+
+		if (edge == Edge::FALLING || edge == Edge::BOTH) {
+			req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+		}
+
+	} else {
+		req.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+		req.config.num_attrs = 1;
+		req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+		req.config.attrs[0].attr.values = initial_values;
+		req.config.attrs[0].mask = _num_lines == 64 ? ~0ull : (1ull << _num_lines) - 1;
+	}
+
+	const int chip_fd = ::open(_chip, O_RDWR | O_CLOEXEC);
+
+	if (chip_fd == -1) {
+		return -errno;
+	}
+
+	int ret = ::ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req);
+	const int err = errno;
+	::close(chip_fd);
+
+	if (ret == -1) {
+		return -err;
+	}
+
+	// the events are read without blocking, poll() waits for them
+	ret = fcntl(req.fd, F_GETFL);
+
+	if (ret == -1 || fcntl(req.fd, F_SETFL, ret | O_NONBLOCK) == -1) {
+		const int fcntl_err = errno;
+		::close(req.fd);
+		return -fcntl_err;
+	}
+
+	_fd = req.fd;
+	memset(_line_seqno, 0, sizeof(_line_seqno));
+	_missed_events = 0;
+
+	return 0;
+}
+
+int LinuxGPIOLines::getValues(uint64_t &values)
+{
+	struct gpio_v2_line_values line_values {};
+	line_values.mask = _num_lines == 64 ? ~0ull : (1ull << _num_lines) - 1;
+
+	if (::ioctl(_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &line_values) == -1) {
+		return -errno;
+	}
+
+	values = line_values.bits;
+	return 0;
+}
+
+int LinuxGPIOLines::setValues(uint64_t values, uint64_t mask)
+{
+	struct gpio_v2_line_values line_values {};
+	line_values.bits = values;
+	line_values.mask = mask & (_num_lines == 64 ? ~0ull : (1ull << _num_lines) - 1);
+
+	if (::ioctl(_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &line_values) == -1) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+int LinuxGPIOLines::readEvents(Event *events, unsigned max_events)
+{
+	static constexpr unsigned BatchSize = 16;
+	struct gpio_v2_line_event buffer[BatchSize];
+
+	const unsigned num = max_events < BatchSize ? max_events : BatchSize;
+	const ssize_t ret = ::read(_fd, buffer, num * sizeof(buffer[0]));
+
+	if (ret == -1) {
+		return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -errno;
+	}
+
+	const unsigned num_read = ret / sizeof(buffer[0]);
+
+	for (unsigned i = 0; i < num_read; i++) {
+		unsigned index = 0;
+
+		while (index < _num_lines && _offsets[index] != buffer[i].offset) {
+			index++;
+		}
+
+		// line_seqno counts the edges of each line from 1, gaps are edges dropped by the kernel
+		if (index < _num_lines) {
+			if (_line_seqno[index] != 0 && buffer[i].line_seqno > _line_seqno[index] + 1) {
+				_missed_events += buffer[i].line_seqno - _line_seqno[index] - 1;
+			}
+
+			_line_seqno[index] = buffer[i].line_seqno;
+		}
+
+		events[i].timestamp_ns = buffer[i].timestamp_ns;
+		events[i].index = index;
+		events[i].rising = buffer[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+	}
+
+	return num_read;
+}
+
+#else // GPIO_V2_GET_LINE_IOCTL
+
+// kernel headers older than 5.10
+
+int LinuxGPIOLines::request(Direction dir, Edge edge, uint64_t initial_values, const char *consumer)
+{
+	return -ENOSYS;
+}
+
+int LinuxGPIOLines::getValues(uint64_t &values)
+{
+	return -ENOSYS;
+}
+
+int LinuxGPIOLines::setValues(uint64_t values, uint64_t mask)
+{
+	return -ENOSYS;
+}
+
+int LinuxGPIOLines::readEvents(Event *events, unsigned max_events)
+{
+	return -ENOSYS;
+}
+
+#endif // GPIO_V2_GET_LINE_IOCTL
+
+void LinuxGPIOLines::release()
+{
+	if (_fd != -1) {
+		::close(_fd);
+		_fd = -1;
+	}
+}
+
+bool LinuxGPIOLines::parseLine(const char *spec, char *chip, size_t chip_size, unsigned &offset)
+{
+	const char *separator = strrchr(spec, ':');
+
+	if (separator == nullptr || separator == spec || (size_t)(separator - spec) >= chip_size) {
+		return false;
+	}
+
+	char *end = nullptr;
+	const unsigned long value = strtoul(separator + 1, &end, 10);
+
+	if (end == separator + 1 || *end != '\0' || value > 0xffff) {
+		return false;
+	}
+
+	memcpy(chip, spec, separator - spec);
+	chip[separator - spec] = '\0';
+	offset = value;
+	return true;
+}
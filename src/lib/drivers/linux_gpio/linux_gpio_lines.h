@@ -0,0 +1,134 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file linux_gpio_lines.h
+ *
+ * Linux GPIO character device interface
+ *
+ * Requests a set of lines of a GPIO chip (/dev/gpiochipN) with the line
+ * request API (v2): the values of all lines are read and written in one
+ * ioctl, and edges on input lines are delivered as events with a kernel
+ * CLOCK_MONOTONIC timestamp.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class LinuxGPIOLines
+{
+public:
+	static constexpr unsigned MaxLines = 64;
+
+	enum class Direction {
+		IN = 0,
+		OUT = 1,
+	};
+
+	enum class Edge {
+		NONE = 0,
+		RISING,
+		FALLING,
+		BOTH,
+	};
+
+	struct Event {
+		uint64_t timestamp_ns;	///< CLOCK_MONOTONIC time of the edge
+		unsigned index;		///< index of the line in the request
+		bool rising;
+	};
+
+	/**
+	 * @param chip GPIO chip, e.g. gpiochip0 or /dev/gpiochip0
+	 * @param offsets line offsets on the chip
+	 */
+	LinuxGPIOLines(const char *chip, const unsigned *offsets, unsigned num_lines);
+	~LinuxGPIOLines();
+
+	/**
+	 * Requests the lines, all with the same configuration.
+	 * @param initial_values output values, bit i for line i
+	 * @return 0 on success, -errno otherwise
+	 */
+	int request(Direction dir, Edge edge = Edge::NONE, uint64_t initial_values = 0, const char *consumer = "px4");
+	void release();
+
+	/**
+	 * @param values bit i for line i
+	 * @return 0 on success, -errno otherwise
+	 */
+	int getValues(uint64_t &values);
+
+	/**
+	 * Sets the lines in mask to values in one operation.
+	 * @return 0 on success, -errno otherwise
+	 */
+	int setValues(uint64_t values, uint64_t mask);
+
+	/**
+	 * The request file descriptor, readable (POLLIN) when edge events are pending.
+	 */
+	int getFd() const { return _fd; }
+
+	/**
+	 * Reads the pending edge events without blocking.
+	 * @return number of events read, -errno otherwise
+	 */
+	int readEvents(Event *events, unsigned max_events);
+
+	/**
+	 * Edges lost since the request because the kernel event buffer was full.
+	 */
+	uint32_t getMissedEvents() const { return _missed_events; }
+
+	unsigned getNumLines() const { return _num_lines; }
+
+	/**
+	 * Parses a line specification <chip>:<offset>, e.g. gpiochip0:23.
+	 * @return false if invalid
+	 */
+	static bool parseLine(const char *spec, char *chip, size_t chip_size, unsigned &offset);
+
+private:
+	char _chip[64] {};
+	unsigned _offsets[MaxLines] {};
+	unsigned _num_lines{0};
+
+	int _fd{-1};
+
+	uint32_t _line_seqno[MaxLines] {};
+	uint32_t _missed_events{0};
+};
@@ -56,28 +56,96 @@ SMBus::~SMBus()
 
 int SMBus::read_word(const uint8_t cmd_code, uint16_t &data)
 {
-	uint8_t buf[6];
+	uint8_t rx[3];
 	// 2 data bytes + pec byte
-	int result = transfer(&cmd_code, 1, buf + 3, 3);
+	int result = transfer(&cmd_code, 1, rx, sizeof(rx));
 
 	if (result == PX4_OK) {
-		data = buf[3] | ((uint16_t)buf[4] << 8);
-		// Check PEC.
-		uint8_t addr = get_device_address() << 1;
-		buf[0] = addr | 0x00;
-		buf[1] = cmd_code;
-		buf[2] = addr | 0x01;
+		result = parse_word(cmd_code, rx, data);
+	}
 
-		uint8_t pec = get_pec(buf, sizeof(buf) - 1);
+	return result;
+}
 
-		if (pec != buf[sizeof(buf) - 1]) {
-			result = -EINVAL;
+int SMBus::read_words(const uint8_t cmd_codes[], uint16_t data[], const unsigned count)
+{
+	if (count > MAX_READ_WORDS) {
+		return -EINVAL;
+	}
+
+#if defined(__PX4_POSIX)
+	// Queue the reads and execute them in one combined transaction on the bus
+	device::I2CBusScheduler::Transfer transfers[MAX_READ_WORDS] {};
+	uint8_t rx[MAX_READ_WORDS][3];
+	unsigned queued = 0;
+
+	while (queued < count) {
+		transfers[queued].send = &cmd_codes[queued];
+		transfers[queued].send_len = 1;
+		transfers[queued].recv = rx[queued];
+		transfers[queued].recv_len = sizeof(rx[queued]);
+
+		if (submit_transfer(transfers[queued]) != PX4_OK) {
+			break;
+		}
+
+		queued++;
+	}
+
+	// the queued descriptors live on this stack, execute them in any case
+	flush_bus();
+
+	int result = (queued == count) ? PX4_OK : -EBUSY;
+
+	for (unsigned i = 0; i < queued && result == PX4_OK; i++) {
+		result = transfers[i].result;
+
+		if (result == PX4_OK) {
+			result = parse_word(cmd_codes[i], rx[i], data[i]);
 		}
 	}
 
+	if (result == PX4_OK) {
+		return PX4_OK;
+	}
+
+	// A failed transaction is not attributed to a single read, the word reads have no
+	// side effects and are repeated one by one with the retries of transfer().
+	result = PX4_OK;
+#else
+	int result = PX4_OK;
+#endif
+
+	for (unsigned i = 0; i < count; i++) {
+		result |= read_word(cmd_codes[i], data[i]);
+	}
+
 	return result;
 }
 
+int SMBus::parse_word(const uint8_t cmd_code, const uint8_t *rx, uint16_t &data)
+{
+	data = rx[0] | ((uint16_t)rx[1] << 8);
+
+	// Check PEC.
+	uint8_t buf[6];
+	uint8_t addr = get_device_address() << 1;
+	buf[0] = addr | 0x00;
+	buf[1] = cmd_code;
+	buf[2] = addr | 0x01;
+	buf[3] = rx[0];
+	buf[4] = rx[1];
+	buf[5] = rx[2];
+
+	uint8_t pec = get_pec(buf, sizeof(buf) - 1);
+
+	if (pec != buf[sizeof(buf) - 1]) {
+		return -EINVAL;
+	}
+
+	return PX4_OK;
+}
+
 int SMBus::write_word(const uint8_t cmd_code, uint16_t data)
 {
 	// 2 data bytes + pec byte
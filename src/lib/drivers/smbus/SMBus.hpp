@@ -76,6 +76,15 @@ public:
 	 */
 	int read_word(const uint8_t cmd_code, uint16_t &data);
 
+	/**
+	 * @brief Sends several read word commands, in a single bus transaction where supported.
+	 * @param cmd_codes The command codes.
+	 * @param data The 2 bytes of returned data per command code.
+	 * @param count The number of command codes, at most MAX_READ_WORDS.
+	 * @return Returns PX4_OK on success, -errno on failure.
+	 */
+	int read_words(const uint8_t cmd_codes[], uint16_t data[], const unsigned count);
+
 	/**
 	 * @brief Sends a write word command.
 	 * @param cmd_code The command code.
@@ -92,4 +101,16 @@ public:
 	 */
 	uint8_t get_pec(uint8_t *buffer, uint8_t length);
 
+	static constexpr unsigned MAX_READ_WORDS = 16;
+
+private:
+	/**
+	 * @brief Checks the PEC of a read word response and extracts the data.
+	 * @param cmd_code The command code.
+	 * @param rx The 2 data bytes and the PEC byte.
+	 * @param data The returned data.
+	 * @return Returns PX4_OK on success, -EINVAL if the PEC does not match.
+	 */
+	int parse_word(const uint8_t cmd_code, const uint8_t *rx, uint16_t &data);
+
 };
@@ -1649,6 +1649,7 @@ Commander::run()
 
 		estimator_check(&status_changed);
 		airspeed_use_check();
+		mag_calibration_refinement_update();
 
 		/* Update land detector */
 		if (land_detector_sub.updated()) {
@@ -2212,6 +2213,14 @@ Commander::run()
 				status.failure_detector_status = failure_status;
 				status_changed = true;
 			}
+
+			const MotorFailureDetector::Detection &motor_failure = _failure_detector.getMotorFailure();
+
+			if (motor_failure.detected && !_motor_failure_reported) {
+				mavlink_log_critical(&mavlink_log_pub, "Motor %d failure detected", motor_failure.motor + 1);
+			}
+
+			_motor_failure_reported = motor_failure.detected;
 		}
 
 		if (armed.armed &&
@@ -4437,3 +4446,59 @@ void Commander::esc_status_check(const esc_status_s &esc_status)
 		status_flags.condition_escs_error = true;
 	}
 }
+
+void Commander::mag_calibration_refinement_update()
+{
+	if (!_param_cal_mag_refine.get() || status_flags.condition_calibration_enabled) {
+		return;
+	}
+
+	// Keep roughly the last few hundred samples (spread over the orientations)
+	static constexpr float forgetting_factor = 0.998f;
+
+	for (int i = 0; i < MAG_REFINEMENT_MAX_MAGS; i++) {
+		sensor_mag_s mag;
+
+		if (_sensor_mag_sub[i].update(&mag)) {
+			if (mag.device_id != _mag_refinement_device_id[i]) {
+				_mag_refinement[i].reset();
+				_mag_refinement[i].setForgettingFactor(forgetting_factor);
+				_mag_refinement_device_id[i] = mag.device_id;
+			}
+
+			_mag_refinement[i].update(matrix::Vector3f(mag.x, mag.y, mag.z));
+		}
+	}
+
+	if (hrt_elapsed_time(&_mag_refinement_last_publish) < 1_s) {
+		return;
+	}
+
+	_mag_refinement_last_publish = hrt_absolute_time();
+
+	for (int i = 0; i < MAG_REFINEMENT_MAX_MAGS; i++) {
+		const MagCalibrationEstimator &estimator = _mag_refinement[i];
+
+		if (_mag_refinement_device_id[i] == 0 || !estimator.isValid()) {
+			continue;
+		}
+
+		mag_calibration_estimate_s estimate{};
+		estimate.device_id = _mag_refinement_device_id[i];
+
+		for (int axis = 0; axis < 3; axis++) {
+			estimate.offset[axis] = estimator.getOffset()(axis);
+			estimate.scale_diagonal[axis] = estimator.getDiagonal()(axis);
+			estimate.scale_offdiagonal[axis] = estimator.getOffDiagonal()(axis);
+		}
+
+		estimate.radius = estimator.getRadius();
+		estimate.fit_rms = estimator.getFitRms();
+		estimate.coverage = estimator.getCoverage();
+		estimate.sample_count = estimator.getSampleCount();
+		estimate.ellipsoid_fit = estimator.isEllipsoidFit();
+		estimate.converged = estimator.isConverged();
+		estimate.timestamp = hrt_absolute_time();
+		_mag_calibration_estimate_pub.publish(estimate);
+	}
+}
@@ -36,6 +36,7 @@
 
 #include "state_machine_helper.h"
 #include "failure_detector/FailureDetector.hpp"
+#include "mag_calibration_estimator/MagCalibrationEstimator.hpp"
 
 #include <lib/controllib/blocks.hpp>
 #include <lib/mathlib/mathlib.h>
@@ -48,6 +49,7 @@
 #include <uORB/PublicationQueued.hpp>
 #include <uORB/topics/actuator_armed.h>
 #include <uORB/topics/home_position.h>
+#include <uORB/topics/mag_calibration_estimate.h>
 #include <uORB/topics/vehicle_command_ack.h>
 #include <uORB/topics/vehicle_control_mode.h>
 #include <uORB/topics/vehicle_status.h>
@@ -61,6 +63,7 @@
 #include <uORB/topics/mission_result.h>
 #include <uORB/topics/offboard_control_mode.h>
 #include <uORB/topics/parameter_update.h>
+#include <uORB/topics/sensor_mag.h>
 #include <uORB/topics/telemetry_status.h>
 #include <uORB/topics/vehicle_acceleration.h>
 #include <uORB/topics/vehicle_command.h>
@@ -147,6 +150,8 @@ private:
 
 		(ParamInt<px4::params::COM_PREARM_MODE>) _param_com_prearm_mode,
 
+		(ParamBool<px4::params::CAL_MAG_REFINE>) _param_cal_mag_refine,
+
 		(ParamInt<px4::params::CBRK_SUPPLY_CHK>) _param_cbrk_supply_chk,
 		(ParamInt<px4::params::CBRK_USB_CHK>) _param_cbrk_usb_chk,
 		(ParamInt<px4::params::CBRK_AIRSPD_CHK>) _param_cbrk_airspd_chk,
@@ -201,6 +206,7 @@ private:
 
 	FailureDetector _failure_detector;
 	bool _flight_termination_triggered{false};
+	bool _motor_failure_reported{false};
 
 	bool handle_command(vehicle_status_s *status, const vehicle_command_s &cmd, actuator_armed_s *armed,
 			    uORB::PublicationQueued<vehicle_command_ack_s> &command_ack_pub, bool *changed);
@@ -240,6 +246,20 @@ private:
 
 	void esc_status_check(const esc_status_s &esc_status);
 
+	/**
+	 * Refine the magnetometer calibrations in the background and publish the proposed corrections
+	 */
+	void mag_calibration_refinement_update();
+
+	static constexpr int MAG_REFINEMENT_MAX_MAGS{4};
+	uORB::Subscription _sensor_mag_sub[MAG_REFINEMENT_MAX_MAGS] {
+		{ORB_ID(sensor_mag), 0}, {ORB_ID(sensor_mag), 1}, {ORB_ID(sensor_mag), 2}, {ORB_ID(sensor_mag), 3}
+	};
+	MagCalibrationEstimator _mag_refinement[MAG_REFINEMENT_MAX_MAGS];
+	uint32_t _mag_refinement_device_id[MAG_REFINEMENT_MAX_MAGS] {};
+	hrt_abstime _mag_refinement_last_publish{0};
+	uORB::PublicationQueued<mag_calibration_estimate_s> _mag_calibration_estimate_pub{ORB_ID(mag_calibration_estimate)};
+
 	/**
 	 * Checks the status of all available data links and handles switching between different system telemetry states.
 	 */
@@ -697,6 +697,10 @@ static bool failureDetectorCheck(orb_advert_t *mavlink_log_pub, const vehicle_st
 			if (status.failure_detector_status & vehicle_status_s::FAILURE_ALT) {
 				mavlink_log_critical(mavlink_log_pub, "Preflight Fail: Altitude failure detected");
 			}
+
+			if (status.failure_detector_status & vehicle_status_s::FAILURE_MOTOR) {
+				mavlink_log_critical(mavlink_log_pub, "Preflight Fail: Motor failure detected");
+			}
 		}
 
 		return false;
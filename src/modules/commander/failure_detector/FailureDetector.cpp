@@ -40,17 +40,45 @@
 
 #include "FailureDetector.hpp"
 
+#include <drivers/drv_hrt.h>
+#include <px4_log.h>
+#include <float.h>
+
+using namespace time_literals;
+
 FailureDetector::FailureDetector(ModuleParams *parent) :
 	ModuleParams(parent)
 {
+	updateParams();
 }
 
-bool FailureDetector::resetStatus()
+void FailureDetector::updateParams()
 {
-	bool status_changed = _status != FAILURE_NONE;
-	_status = FAILURE_NONE;
+	ModuleParams::updateParams();
+
+	// expected rate of the commander loop, the detector adapts to the measured rate
+	static constexpr float DETECTOR_RATE = 100.f;
+	static constexpr float DETECTOR_FILTER_CUTOFF = 15.f;
+
+	_motor_failure_detector.setControlEffectiveness(matrix::Vector3f(_param_fd_mot_eff_rp.get(), _param_fd_mot_eff_rp.get(),
+			_param_fd_mot_eff_y.get()));
+	_motor_failure_detector.setMotorTimeConstant(_param_fd_mot_tau.get());
+	_motor_failure_detector.setFilterCutoff(DETECTOR_RATE, DETECTOR_FILTER_CUTOFF);
+	_motor_failure_detector.setResidualThreshold(_param_fd_mot_thr.get());
+	_motor_failure_detector.setTriggerTime(_param_fd_mot_ttri.get());
+	_motor_failure_detector.setEscRpmRatioThreshold(_param_fd_mot_esc_r.get());
 
-	return status_changed;
+	if (!_motor_failure_detector.setGeometry((MotorFailureDetector::Geometry)_param_fd_mot_geom.get())) {
+		PX4_ERR("unsupported FD_MOT_GEOM %d", _param_fd_mot_geom.get());
+	}
+}
+
+bool FailureDetector::resetAttitudeStatus()
+{
+	const uint8_t previous_status = _status;
+	_status &= ~(FAILURE_ROLL | FAILURE_PITCH);
+
+	return _status != previous_status;
 }
 
 bool
@@ -62,7 +90,11 @@ FailureDetector::update(const vehicle_status_s &vehicle_status)
 		updated = updateAttitudeStatus();
 
 	} else {
-		updated = resetStatus();
+		updated = resetAttitudeStatus();
+	}
+
+	if (updateMotorStatus(vehicle_status)) {
+		updated = true;
 	}
 
 	return updated;
@@ -132,3 +164,131 @@ FailureDetector::updateAttitudeStatus()
 
 	return updated;
 }
+
+bool
+FailureDetector::updateMotorStatus(const vehicle_status_s &vehicle_status)
+{
+	const MotorFailureMode mode = (MotorFailureMode)_param_fd_mot_en.get();
+	const uint8_t previous_status = _status;
+
+	if (mode == MotorFailureMode::disabled
+	    || vehicle_status.vehicle_type != vehicle_status_s::VEHICLE_TYPE_ROTARY_WING
+	    || vehicle_status.arming_state != vehicle_status_s::ARMING_STATE_ARMED) {
+
+		bool cleared = false;
+
+		if (_motor_failure_detector_running) {
+			// failures are latched until disarm
+			cleared = _motor_failure_detector.getDetection().detected;
+			_motor_failure_detector.reset();
+			_motor_failure_detector_running = false;
+			publishMotorStatus(hrt_absolute_time());
+		}
+
+		_status &= ~FAILURE_MOTOR;
+		return cleared || _status != previous_status;
+	}
+
+	vehicle_angular_velocity_s angular_velocity;
+
+	if (!_sub_vehicle_angular_velocity.update(&angular_velocity)) {
+		return false;
+	}
+
+	const int motor_count = _motor_failure_detector.getMotorCount();
+	actuator_outputs_s actuator_outputs;
+
+	if (!_sub_actuator_outputs.copy(&actuator_outputs) || (int)actuator_outputs.noutputs < motor_count) {
+		return false;
+	}
+
+	float outputs[MotorFailureDetector::MAX_MOTORS];
+
+	for (int i = 0; i < motor_count; i++) {
+		outputs[i] = normalizeMotorOutput(actuator_outputs.output[i]);
+	}
+
+	vehicle_land_detected_s land_detected;
+
+	if (_sub_vehicle_land_detected.copy(&land_detected)) {
+		_motor_failure_detector.setGroundContact(land_detected.landed || land_detected.maybe_landed
+				|| land_detected.ground_contact);
+	}
+
+	// use the ESC telemetry if it is recent and reports all motors
+	float rpm[MotorFailureDetector::MAX_MOTORS];
+	bool rpm_valid = false;
+	esc_status_s esc_status;
+
+	if (_sub_esc_status.copy(&esc_status)
+	    && hrt_elapsed_time(&esc_status.timestamp) < 500_ms
+	    && esc_status.esc_count >= motor_count) {
+
+		rpm_valid = true;
+
+		for (int i = 0; i < motor_count; i++) {
+			rpm[i] = (esc_status.esc_online_flags & (1 << i)) ? esc_status.esc[i].esc_rpm : NAN;
+		}
+	}
+
+	_motor_failure_detector_running = true;
+	const bool detected = _motor_failure_detector.update(angular_velocity.timestamp_sample, outputs,
+			      matrix::Vector3f(angular_velocity.xyz), rpm_valid ? rpm : nullptr);
+
+	if (detected) {
+		const MotorFailureDetector::Detection &detection = _motor_failure_detector.getDetection();
+		PX4_WARN("motor %d failure detected after %.3f s", detection.motor + 1, (double)detection.latency);
+	}
+
+	publishMotorStatus(angular_velocity.timestamp);
+
+	if (mode == MotorFailureMode::failsafe && _motor_failure_detector.getDetection().detected) {
+		_status |= FAILURE_MOTOR;
+	}
+
+	return detected || _status != previous_status;
+}
+
+float
+FailureDetector::normalizeMotorOutput(float output) const
+{
+	float min = 0.f;
+	float max = 1.f;
+
+	switch ((MotorOutputType)_param_fd_mot_out.get()) {
+	case MotorOutputType::pwm:
+		min = _param_pwm_min.get();
+		max = _param_pwm_max.get();
+		break;
+
+	case MotorOutputType::uavcan_esc:
+		// raw command range of uavcan.equipment.esc.RawCommand
+		max = 8191.f;
+		break;
+
+	case MotorOutputType::normalized:
+		min = -1.f;
+		break;
+	}
+
+	return math::constrain((output - min) / math::max(max - min, FLT_EPSILON), 0.f, 1.f);
+}
+
+void
+FailureDetector::publishMotorStatus(hrt_abstime now)
+{
+	const MotorFailureDetector::Detection &detection = _motor_failure_detector.getDetection();
+
+	motor_failure_s motor_failure{};
+	motor_failure.timestamp = now;
+	motor_failure.failure_detected = detection.detected;
+	motor_failure.motor_index = detection.motor;
+	motor_failure.source = (uint8_t)detection.source;
+	motor_failure.effectiveness_loss = detection.effectiveness_loss;
+	motor_failure.confidence = detection.confidence;
+	motor_failure.detection_latency = detection.latency;
+	_motor_failure_detector.getResidual().copyTo(motor_failure.residual);
+	_motor_failure_detector.getControlEffectiveness().copyTo(motor_failure.control_effectiveness);
+
+	_motor_failure_pub.publish(motor_failure);
+}
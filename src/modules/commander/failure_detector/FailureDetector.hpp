@@ -48,17 +48,28 @@
 #include <px4_module_params.h>
 #include <hysteresis/hysteresis.h>
 
+#include "MotorFailureDetector.hpp"
+
 // subscriptions
 #include <uORB/Subscription.hpp>
+#include <uORB/topics/actuator_outputs.h>
+#include <uORB/topics/esc_status.h>
+#include <uORB/topics/vehicle_angular_velocity.h>
 #include <uORB/topics/vehicle_attitude_setpoint.h>
 #include <uORB/topics/vehicle_attitude.h>
+#include <uORB/topics/vehicle_land_detected.h>
 #include <uORB/topics/vehicle_status.h>
 
+// publications
+#include <uORB/Publication.hpp>
+#include <uORB/topics/motor_failure.h>
+
 typedef enum {
 	FAILURE_NONE = vehicle_status_s::FAILURE_NONE,
 	FAILURE_ROLL = vehicle_status_s::FAILURE_ROLL,
 	FAILURE_PITCH = vehicle_status_s::FAILURE_PITCH,
 	FAILURE_ALT = vehicle_status_s::FAILURE_ALT,
+	FAILURE_MOTOR = vehicle_status_s::FAILURE_MOTOR,
 } failure_detector_bitmak;
 
 using uORB::SubscriptionData;
@@ -73,24 +84,63 @@ public:
 	uint8_t getStatus() const { return _status; }
 	bool isFailure() const { return _status != FAILURE_NONE; }
 
+	const MotorFailureDetector::Detection &getMotorFailure() const { return _motor_failure_detector.getDetection(); }
+
+	void updateParams() override;
+
 private:
+	enum class MotorFailureMode {
+		disabled = 0,
+		report,
+		failsafe
+	};
+
+	enum class MotorOutputType {
+		pwm = 0,
+		uavcan_esc,
+		normalized
+	};
+
 
 	DEFINE_PARAMETERS(
 		(ParamInt<px4::params::FD_FAIL_P>) _param_fd_fail_p,
 		(ParamInt<px4::params::FD_FAIL_R>) _param_fd_fail_r,
 		(ParamFloat<px4::params::FD_FAIL_R_TTRI>) _param_fd_fail_r_ttri,
-		(ParamFloat<px4::params::FD_FAIL_P_TTRI>) _param_fd_fail_p_ttri
+		(ParamFloat<px4::params::FD_FAIL_P_TTRI>) _param_fd_fail_p_ttri,
+		(ParamInt<px4::params::FD_MOT_EN>) _param_fd_mot_en,
+		(ParamInt<px4::params::FD_MOT_GEOM>) _param_fd_mot_geom,
+		(ParamFloat<px4::params::FD_MOT_EFF_RP>) _param_fd_mot_eff_rp,
+		(ParamFloat<px4::params::FD_MOT_EFF_Y>) _param_fd_mot_eff_y,
+		(ParamFloat<px4::params::FD_MOT_TAU>) _param_fd_mot_tau,
+		(ParamFloat<px4::params::FD_MOT_THR>) _param_fd_mot_thr,
+		(ParamFloat<px4::params::FD_MOT_TTRI>) _param_fd_mot_ttri,
+		(ParamFloat<px4::params::FD_MOT_ESC_R>) _param_fd_mot_esc_r,
+		(ParamInt<px4::params::FD_MOT_OUT>) _param_fd_mot_out,
+		(ParamInt<px4::params::PWM_MIN>) _param_pwm_min,
+		(ParamInt<px4::params::PWM_MAX>) _param_pwm_max
 	)
 
 	// Subscriptions
 	uORB::Subscription _sub_vehicule_attitude{ORB_ID(vehicle_attitude)};
+	uORB::Subscription _sub_vehicle_angular_velocity{ORB_ID(vehicle_angular_velocity)};
+	uORB::Subscription _sub_actuator_outputs{ORB_ID(actuator_outputs)};
+	uORB::Subscription _sub_esc_status{ORB_ID(esc_status)};
+	uORB::Subscription _sub_vehicle_land_detected{ORB_ID(vehicle_land_detected)};
+
+	uORB::Publication<motor_failure_s> _motor_failure_pub{ORB_ID(motor_failure)};
 
 	uint8_t _status{FAILURE_NONE};
 
 	systemlib::Hysteresis _roll_failure_hysteresis{false};
 	systemlib::Hysteresis _pitch_failure_hysteresis{false};
 
-	bool resetStatus();
+	MotorFailureDetector _motor_failure_detector;
+	bool _motor_failure_detector_running{false};
+
+	bool resetAttitudeStatus();
 	bool isAttitudeStabilized(const vehicle_status_s &vehicle_status);
 	bool updateAttitudeStatus();
+	bool updateMotorStatus(const vehicle_status_s &vehicle_status);
+	float normalizeMotorOutput(float output) const;
+	void publishMotorStatus(hrt_abstime now);
 };
@@ -0,0 +1,439 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file MotorFailureDetector.cpp
+ */
+
+#include "MotorFailureDetector.hpp"
+
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+#include <float.h>
+
+using namespace matrix;
+
+void MotorFailureDetector::setGeometry(const Rotor *rotors, int count)
+{
+	_motor_count = math::constrain(count, 0, MAX_MOTORS);
+
+	for (int i = 0; i < _motor_count; i++) {
+		_rotors[i] = rotors[i];
+	}
+
+	reset();
+}
+
+bool MotorFailureDetector::setGeometry(Geometry geometry)
+{
+	// Rotor order, positions and directions of src/lib/mixer/geometries,
+	// roll = -y, pitch = x, yaw = 1 for counter-clockwise rotors
+	static constexpr Rotor quad_x[] = {
+		{-0.707107f, 0.707107f, 1.f},
+		{0.707107f, -0.707107f, 1.f},
+		{0.707107f, 0.707107f, -1.f},
+		{-0.707107f, -0.707107f, -1.f},
+	};
+
+	static constexpr Rotor quad_plus[] = {
+		{-1.f, 0.f, 1.f},
+		{1.f, 0.f, 1.f},
+		{0.f, 1.f, -1.f},
+		{0.f, -1.f, -1.f},
+	};
+
+	static constexpr Rotor hex_x[] = {
+		{-1.f, 0.f, -1.f},
+		{1.f, 0.f, 1.f},
+		{0.5f, 0.866025f, -1.f},
+		{-0.5f, -0.866025f, 1.f},
+		{-0.5f, 0.866025f, 1.f},
+		{0.5f, -0.866025f, -1.f},
+	};
+
+	static constexpr Rotor hex_plus[] = {
+		{0.f, 1.f, -1.f},
+		{0.f, -1.f, 1.f},
+		{0.866025f, -0.5f, -1.f},
+		{-0.866025f, 0.5f, 1.f},
+		{0.866025f, 0.5f, 1.f},
+		{-0.866025f, -0.5f, -1.f},
+	};
+
+	static constexpr Rotor octa_x[] = {
+		{-0.382683f, 0.923880f, -1.f},
+		{0.382683f, -0.923880f, -1.f},
+		{-0.923880f, 0.382683f, 1.f},
+		{-0.382683f, -0.923880f, 1.f},
+		{0.382683f, 0.923880f, 1.f},
+		{0.923880f, -0.382683f, 1.f},
+		{0.923880f, 0.382683f, -1.f},
+		{-0.923880f, -0.382683f, -1.f},
+	};
+
+	switch (geometry) {
+	case Geometry::quad_x:
+		setGeometry(quad_x, sizeof(quad_x) / sizeof(quad_x[0]));
+		return true;
+
+	case Geometry::quad_plus:
+		setGeometry(quad_plus, sizeof(quad_plus) / sizeof(quad_plus[0]));
+		return true;
+
+	case Geometry::hex_x:
+		setGeometry(hex_x, sizeof(hex_x) / sizeof(hex_x[0]));
+		return true;
+
+	case Geometry::hex_plus:
+		setGeometry(hex_plus, sizeof(hex_plus) / sizeof(hex_plus[0]));
+		return true;
+
+	case Geometry::octa_x:
+		setGeometry(octa_x, sizeof(octa_x) / sizeof(octa_x[0]));
+		return true;
+	}
+
+	_motor_count = 0;
+	return false;
+}
+
+void MotorFailureDetector::setFilterCutoff(float sample_freq, float cutoff)
+{
+	_sample_freq = sample_freq;
+	_filter_cutoff = cutoff;
+	_dt_average = 1.f / sample_freq;
+	_lp_filter_rate.set_cutoff_frequency(sample_freq, cutoff);
+	_lp_filter_model.set_cutoff_frequency(sample_freq, cutoff);
+	_time_last_us = 0;
+}
+
+void MotorFailureDetector::reset()
+{
+	_effectiveness = _effectiveness_init;
+	_offset.zero();
+
+	for (int axis = 0; axis < 3; axis++) {
+		_adaptation_cov[axis].setZero();
+		_adaptation_cov[axis](0, 0) = 0.25f * _effectiveness_init(axis) * _effectiveness_init(axis);
+		_adaptation_cov[axis](1, 1) = 10.f * MAX_OFFSET_UNCERTAINTY * MAX_OFFSET_UNCERTAINTY;
+	}
+
+	_residual.zero();
+	_time_last_us = 0;
+	_sample_count = 0;
+
+	_detection = Detection{false, -1, 0.f, 0.f, 0.f, Source::none};
+	_onset_us = 0;
+	_residual_candidate = -1;
+	_esc_candidate = -1;
+}
+
+bool MotorFailureDetector::update(uint64_t time_us, const float outputs[], const Vector3f &rate, const float rpm[])
+{
+	if (_motor_count == 0) {
+		return false;
+	}
+
+	if (_time_last_us == 0 || time_us <= _time_last_us) {
+		// (re)initialize the model on the current state
+		for (int i = 0; i < _motor_count; i++) {
+			_motor_state[i] = outputs[i];
+		}
+
+		_rate_filtered_prev = _lp_filter_rate.reset(rate);
+		_model_filtered.zero();
+		_time_last_us = time_us;
+		_sample_count = 0;
+		return false;
+	}
+
+	const float dt = math::constrain((time_us - _time_last_us) * 1e-6f, 0.0005f, 0.1f);
+	_time_last_us = time_us;
+
+	// the filters are designed for a fixed sample frequency, follow the measured update rate
+	_dt_average += 0.05f * (dt - _dt_average);
+
+	if (_filter_cutoff > 0.f && fabsf(1.f / _dt_average - _sample_freq) > SAMPLE_FREQ_TOLERANCE * _sample_freq) {
+		_sample_freq = 1.f / _dt_average;
+		_lp_filter_rate.set_cutoff_frequency(_sample_freq, _filter_cutoff);
+		_lp_filter_model.set_cutoff_frequency(_sample_freq, _filter_cutoff);
+		_rate_filtered_prev = _lp_filter_rate.reset(rate);
+		_sample_count = 0;
+	}
+
+	// Torque direction expected from the motor model
+	const float motor_alpha = dt / (_motor_time_constant + dt);
+	Vector3f model;
+
+	for (int i = 0; i < _motor_count; i++) {
+		if (PX4_ISFINITE(outputs[i])) {
+			_motor_state[i] += motor_alpha * (math::constrain(outputs[i], 0.f, 1.f) - _motor_state[i]);
+		}
+
+		model += Vector3f(_rotors[i].roll_scale, _rotors[i].pitch_scale, _rotors[i].yaw_scale) * _motor_state[i];
+	}
+
+	if (_sample_count == 0) {
+		_lp_filter_model.reset(model);
+	}
+
+	_model_filtered = _lp_filter_model.apply(model);
+
+	const Vector3f rate_filtered = _lp_filter_rate.apply(rate);
+	const Vector3f alpha_meas = (rate_filtered - _rate_filtered_prev) / dt;
+	_rate_filtered_prev = rate_filtered;
+
+	// let the filters settle before using the angular acceleration
+	static constexpr int SETTLING_SAMPLES = 10;
+
+	if (_sample_count < SETTLING_SAMPLES) {
+		_sample_count++;
+		return false;
+	}
+
+	if (_ground_contact) {
+		// the ground reaction torque is not part of the model
+		_residual.zero();
+		_onset_us = 0;
+		_residual_candidate = -1;
+		_esc_candidate = -1;
+		return false;
+	}
+
+	_residual = alpha_meas - (_effectiveness.emult(_model_filtered) + _offset);
+
+	if (_detection.detected) {
+		if (_detection.source == Source::residual) {
+			// keep refining the loss of the failed motor
+			const Rotor &rotor = _rotors[_detection.motor];
+			const Vector3f signature = -_effectiveness.emult(Vector3f(rotor.roll_scale, rotor.pitch_scale, rotor.yaw_scale));
+			const float loss = signature.dot(_residual)
+					   / (signature.norm_squared() * math::max(_motor_state[_detection.motor], MIN_OUTPUT));
+			_detection.effectiveness_loss += 0.05f * (math::constrain(loss, 0.f, 1.f) - _detection.effectiveness_loss);
+		}
+
+		return false;
+	}
+
+	bool detected = _updateResidual(time_us);
+
+	if (!detected && rpm != nullptr) {
+		detected = _updateEsc(rpm, time_us);
+	}
+
+	if (_onset_us == 0) {
+		_adaptModel(alpha_meas, dt);
+	}
+
+	return detected;
+}
+
+bool MotorFailureDetector::_updateResidual(uint64_t time_us)
+{
+	const float residual_norm = _residual.norm();
+
+	if (residual_norm < 0.5f * _residual_threshold) {
+		_onset_us = 0;
+		_residual_candidate = -1;
+		return false;
+	}
+
+	if (_onset_us == 0) {
+		_onset_us = time_us;
+	}
+
+	if (residual_norm < _residual_threshold) {
+		_residual_candidate = -1;
+		return false;
+	}
+
+	// Isolate the motor whose expected torque best explains the residual
+	int best_motor = -1;
+	float best_score = -1.f;
+	float best_loss = 0.f;
+
+	for (int i = 0; i < _motor_count; i++) {
+		const Vector3f signature = -_effectiveness.emult(Vector3f(_rotors[i].roll_scale, _rotors[i].pitch_scale,
+					   _rotors[i].yaw_scale));
+		const float signature_norm = signature.norm();
+
+		if (signature_norm < FLT_EPSILON) {
+			continue;
+		}
+
+		const float score = signature.dot(_residual) / (signature_norm * residual_norm);
+
+		if (score > best_score) {
+			best_motor = i;
+			best_score = score;
+			best_loss = signature.dot(_residual) / (signature_norm * signature_norm * math::max(_motor_state[i], MIN_OUTPUT));
+		}
+	}
+
+	if (best_score < MIN_ISOLATION_SCORE || best_loss < MIN_LOSS) {
+		best_motor = -1;
+	}
+
+	if (_trigger(best_motor, best_score, time_us, _residual_candidate, _residual_candidate_start_us, _residual_score_sum,
+		     _residual_score_count)) {
+		_detection.detected = true;
+		_detection.motor = best_motor;
+		_detection.effectiveness_loss = math::constrain(best_loss, 0.f, 1.f);
+		_detection.confidence = _residual_score_sum / _residual_score_count;
+		_detection.latency = (time_us - _onset_us) * 1e-6f;
+		_detection.source = Source::residual;
+		return true;
+	}
+
+	return false;
+}
+
+bool MotorFailureDetector::_updateEsc(const float rpm[], uint64_t time_us)
+{
+	// Speed per output of each motor, only meaningful if all motors are commanded to spin
+	float rpm_per_output[MAX_MOTORS] {};
+	float sorted[MAX_MOTORS] {};
+
+	for (int i = 0; i < _motor_count; i++) {
+		if (!PX4_ISFINITE(rpm[i]) || _motor_state[i] < 2.f * MIN_OUTPUT) {
+			_esc_candidate = -1;
+			return false;
+		}
+
+		rpm_per_output[i] = fabsf(rpm[i]) / _motor_state[i];
+
+		// insertion sort, there are only a few motors
+		int j = i;
+
+		while (j > 0 && sorted[j - 1] > rpm_per_output[i]) {
+			sorted[j] = sorted[j - 1];
+			j--;
+		}
+
+		sorted[j] = rpm_per_output[i];
+	}
+
+	const float median = sorted[_motor_count / 2];
+
+	if (median < FLT_EPSILON) {
+		_esc_candidate = -1;
+		return false;
+	}
+
+	int slowest = 0;
+
+	for (int i = 1; i < _motor_count; i++) {
+		if (rpm_per_output[i] < rpm_per_output[slowest]) {
+			slowest = i;
+		}
+	}
+
+	const float ratio = rpm_per_output[slowest] / median;
+	const int candidate = ratio < _esc_rpm_ratio_threshold ? slowest : -1;
+
+	if (_trigger(candidate, 1.f - ratio, time_us, _esc_candidate, _esc_candidate_start_us, _esc_score_sum,
+		     _esc_score_count)) {
+		_detection.detected = true;
+		_detection.motor = candidate;
+		_detection.effectiveness_loss = 1.f - ratio;
+		_detection.confidence = math::constrain(_esc_score_sum / _esc_score_count, 0.f, 1.f);
+		_detection.latency = (time_us - _esc_candidate_start_us) * 1e-6f;
+		_detection.source = Source::esc;
+		return true;
+	}
+
+	return false;
+}
+
+bool MotorFailureDetector::_trigger(int motor, float score, uint64_t time_us, int &candidate,
+				    uint64_t &candidate_start_us, float &score_sum, int &score_count)
+{
+	if (motor < 0) {
+		candidate = -1;
+		return false;
+	}
+
+	if (motor != candidate) {
+		candidate = motor;
+		candidate_start_us = time_us;
+		score_sum = 0.f;
+		score_count = 0;
+	}
+
+	score_sum += score;
+	score_count++;
+
+	return time_us - candidate_start_us >= _trigger_time_us;
+}
+
+void MotorFailureDetector::_adaptModel(const Vector3f &alpha_meas, float dt)
+{
+	// Kalman filter on effectiveness and offset of each axis, the measurement noise is a rough
+	// value for the angular acceleration obtained from a filtered gyro in turbulent air
+	static constexpr float MEASUREMENT_VARIANCE = 100.f;
+	const float forgetting = 1.f - dt / ADAPTATION_TIME_CONSTANT;
+
+	for (int axis = 0; axis < 3; axis++) {
+		SquareMatrix<float, 2> &P = _adaptation_cov[axis];
+
+		// forget old samples, but do not let the uncertainty grow beyond a bound when there is no excitation
+		const float max_variance[2] = {MAX_EFFECTIVENESS_UNCERTAINTY * MAX_EFFECTIVENESS_UNCERTAINTY * _effectiveness_init(axis) * _effectiveness_init(axis),
+					       MAX_OFFSET_UNCERTAINTY * MAX_OFFSET_UNCERTAINTY
+					      };
+
+		for (int i = 0; i < 2; i++) {
+			const float variance = math::max(P(i, i), max_variance[i]);
+			const float scale = sqrtf(math::min(P(i, i) / forgetting, variance) / P(i, i));
+			P(i, 0) *= scale;
+			P(i, 1) *= scale;
+			P(0, i) *= scale;
+			P(1, i) *= scale;
+		}
+
+		const Vector2f phi(_model_filtered(axis), 1.f);
+		const Vector2f P_phi = P * phi;
+		const float innovation_variance = phi.dot(P_phi) + MEASUREMENT_VARIANCE;
+		const Vector2f gain = P_phi / innovation_variance;
+		const float innovation = alpha_meas(axis) - (_effectiveness(axis) * phi(0) + _offset(axis));
+
+		_effectiveness(axis) = math::constrain(_effectiveness(axis) + gain(0) * innovation,
+						       0.5f * _effectiveness_init(axis), 2.f * _effectiveness_init(axis));
+		_offset(axis) += gain(1) * innovation;
+
+		for (int i = 0; i < 2; i++) {
+			for (int j = 0; j < 2; j++) {
+				P(i, j) -= gain(i) * P_phi(j);
+			}
+		}
+	}
+}
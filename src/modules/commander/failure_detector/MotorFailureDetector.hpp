@@ -0,0 +1,233 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file MotorFailureDetector.hpp
+ *
+ * Motor failure detection and isolation for multicopters.
+ *
+ * The angular acceleration predicted from the motor outputs is compared to the one
+ * measured by differentiating the angular rate. Both signals go through the same low-pass
+ * filter, and the motor outputs additionally through a first order motor model, such that
+ * they are synchronized. The remaining residual is caused by disturbances and model errors,
+ * except when a motor loses thrust: the residual then points in the direction of the
+ * torque that motor was expected to produce, which isolates the failed motor.
+ *
+ * The per-axis effectiveness and offset of the model are adapted during nominal flight,
+ * such that only a rough initial effectiveness is required.
+ *
+ * If ESC telemetry is available, a motor which turns significantly slower than the others
+ * for the same output is detected as well.
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+#include <mathlib/math/filter/LowPassFilter2pVector3f.hpp>
+#include <stdint.h>
+
+class MotorFailureDetector
+{
+public:
+	static constexpr int MAX_MOTORS = 8;
+
+	/** Contribution of a rotor to the body torques, as in the multirotor mixer geometries */
+	struct Rotor {
+		float roll_scale;
+		float pitch_scale;
+		float yaw_scale;
+	};
+
+	/** Geometries of the multirotor mixer, values match the FD_MOT_GEOM parameter */
+	enum class Geometry {
+		quad_x = 0,
+		quad_plus,
+		hex_x,
+		hex_plus,
+		octa_x
+	};
+
+	enum class Source {
+		none = 0,
+		residual,
+		esc
+	};
+
+	struct Detection {
+		bool detected;
+		int motor; ///< index of the failed motor, -1 if none
+		float effectiveness_loss; ///< estimated fraction of the thrust lost (0-1)
+		float confidence; ///< (0-1)
+		float latency; ///< time from the onset of the residual to the detection [s]
+		Source source;
+	};
+
+	MotorFailureDetector() { reset(); }
+	~MotorFailureDetector() = default;
+
+	/**
+	 * Set the motor geometry
+	 * @param rotors rotor table in the order of the motor outputs
+	 * @param count number of rotors, at most MAX_MOTORS
+	 */
+	void setGeometry(const Rotor *rotors, int count);
+
+	/**
+	 * Set one of the standard motor geometries
+	 * @return false if the geometry is unknown
+	 */
+	bool setGeometry(Geometry geometry);
+
+	int getMotorCount() const { return _motor_count; }
+	const Rotor &getRotor(int index) const { return _rotors[index]; }
+
+	/**
+	 * @param G initial angular acceleration produced by a unit motor output in the direction of the rotor scale,
+	 * for body x,y,z axis [rad/s^2]
+	 */
+	void setControlEffectiveness(const matrix::Vector3f &G) { _effectiveness_init = G; }
+
+	/**
+	 * @param time_constant of the first order motor model [s]
+	 */
+	void setMotorTimeConstant(float time_constant) { _motor_time_constant = time_constant; }
+
+	/**
+	 * Set update frequency and low-pass filter cutoff applied to the angular acceleration and the motor model
+	 * @param sample_freq [Hz] expected rate with which update function is called, the filters are
+	 * redesigned if the measured rate differs
+	 * @param cutoff [Hz] cutoff frequency of the low-pass filters
+	 */
+	void setFilterCutoff(float sample_freq, float cutoff);
+
+	/**
+	 * @param ground_contact true while the vehicle is landed or touches the ground, the residual is then
+	 * dominated by the ground reaction and neither used for the detection nor for the model adaptation
+	 */
+	void setGroundContact(bool ground_contact) { _ground_contact = ground_contact; }
+
+	/**
+	 * @param threshold norm of the angular acceleration residual above which a failure is suspected [rad/s^2]
+	 */
+	void setResidualThreshold(float threshold) { _residual_threshold = threshold; }
+
+	/**
+	 * @param trigger_time time the same motor needs to be isolated before it is detected as failed [s]
+	 */
+	void setTriggerTime(float trigger_time) { _trigger_time_us = (uint64_t)(trigger_time * 1e6f); }
+
+	/**
+	 * @param ratio a motor is considered failed if its rpm per output is below this fraction of the median
+	 */
+	void setEscRpmRatioThreshold(float ratio) { _esc_rpm_ratio_threshold = ratio; }
+
+	/**
+	 * Reset the detection and the adapted model, e.g. on disarm
+	 */
+	void reset();
+
+	/**
+	 * Run one detection cycle
+	 * @param time_us timestamp of the measurement [us]
+	 * @param outputs normalized motor outputs (0-1), one per rotor of the geometry
+	 * @param rate measured angular rate [rad/s]
+	 * @param rpm ESC telemetry per rotor [rpm], nullptr if not available
+	 * @return true if a new failure was detected
+	 */
+	bool update(uint64_t time_us, const float outputs[], const matrix::Vector3f &rate, const float rpm[] = nullptr);
+
+	const Detection &getDetection() const { return _detection; }
+
+	/**
+	 * @return difference between measured and predicted angular acceleration [rad/s^2]
+	 */
+	const matrix::Vector3f &getResidual() const { return _residual; }
+
+	/**
+	 * @return adapted angular acceleration per unit motor output for body x,y,z axis [rad/s^2]
+	 */
+	const matrix::Vector3f &getControlEffectiveness() const { return _effectiveness; }
+
+private:
+	bool _updateResidual(uint64_t time_us);
+	bool _updateEsc(const float rpm[], uint64_t time_us);
+	void _adaptModel(const matrix::Vector3f &alpha_meas, float dt);
+	bool _trigger(int motor, float score, uint64_t time_us, int &candidate, uint64_t &candidate_start_us,
+		      float &score_sum, int &score_count);
+
+	static constexpr float MIN_ISOLATION_SCORE = 0.9f; ///< minimum cosine between residual and motor signature
+	static constexpr float MIN_LOSS = 0.25f; ///< minimum estimated thrust loss for a detection
+	static constexpr float MIN_OUTPUT = 0.05f; ///< outputs used to normalize the loss are at least this value
+	static constexpr float ADAPTATION_TIME_CONSTANT = 5.f; ///< [s]
+	static constexpr float MAX_EFFECTIVENESS_UNCERTAINTY = 0.1f; ///< relative to the initial effectiveness
+	static constexpr float MAX_OFFSET_UNCERTAINTY = 1.f; ///< [rad/s^2]
+	static constexpr float SAMPLE_FREQ_TOLERANCE = 0.1f; ///< relative rate change after which the filters are redesigned
+
+	// Parameters
+	Rotor _rotors[MAX_MOTORS] {};
+	int _motor_count{0};
+	matrix::Vector3f _effectiveness_init{60.f, 60.f, 8.f};
+	float _motor_time_constant{0.03f};
+	float _residual_threshold{30.f};
+	uint64_t _trigger_time_us{20000};
+	float _esc_rpm_ratio_threshold{0.5f};
+	float _filter_cutoff{0.f};
+	bool _ground_contact{false};
+
+	// Model
+	math::LowPassFilter2pVector3f _lp_filter_rate{0.f, 0.f};
+	math::LowPassFilter2pVector3f _lp_filter_model{0.f, 0.f};
+	float _motor_state[MAX_MOTORS] {};
+	matrix::Vector3f _rate_filtered_prev;
+	matrix::Vector3f _model_filtered;
+	matrix::Vector3f _effectiveness;
+	matrix::Vector3f _offset;
+	matrix::SquareMatrix<float, 2> _adaptation_cov[3]; ///< covariance of effectiveness and offset for each axis
+	matrix::Vector3f _residual;
+	uint64_t _time_last_us{0};
+	int _sample_count{0};
+	float _sample_freq{0.f}; ///< sample frequency the filters are designed for [Hz]
+	float _dt_average{0.f}; ///< measured update interval [s]
+
+	// Detection
+	Detection _detection{};
+	uint64_t _onset_us{0}; ///< first time of the current residual excursion, 0 if none
+	int _residual_candidate{-1};
+	uint64_t _residual_candidate_start_us{0};
+	float _residual_score_sum{0.f};
+	int _residual_score_count{0};
+	int _esc_candidate{-1};
+	uint64_t _esc_candidate_start_us{0};
+	float _esc_score_sum{0.f};
+	int _esc_score_count{0};
+};
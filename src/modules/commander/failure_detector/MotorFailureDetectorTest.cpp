@@ -0,0 +1,370 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the Motor Failure Detector
+ * Run this test only using make tests TESTFILTER=MotorFailureDetector
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/matrix/math.hpp>
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+#include "MotorFailureDetector.hpp"
+
+using namespace matrix;
+
+/**
+ * Rotational dynamics of a multicopter with a rate controller running at 500Hz,
+ * replayed to the detector at 100Hz like the commander does.
+ */
+class MulticopterSimulation
+{
+public:
+	MulticopterSimulation(MotorFailureDetector::Geometry geometry, uint32_t seed = 1) :
+		_seed(seed),
+		_phase(0.3f * seed)
+	{
+		_geometry.setGeometry(geometry);
+		_motor_count = _geometry.getMotorCount();
+
+		_detector.setGeometry(geometry);
+		_detector.setControlEffectiveness(Vector3f(50.f, 50.f, 4.f)); // rough initial guess
+		_detector.setMotorTimeConstant(0.03f);
+		_detector.setFilterCutoff(1.f / DETECTOR_DT, 15.f);
+		_detector.setResidualThreshold(15.f);
+		_detector.setTriggerTime(0.02f);
+		_detector.reset();
+
+		for (int i = 0; i < MotorFailureDetector::MAX_MOTORS; i++) {
+			_thrust[i] = HOVER;
+			_efficiency[i] = 1.f;
+			_rpm_factor[i] = 1.f;
+		}
+	}
+
+	/** Fail a motor at the given time */
+	void injectFailure(int motor, float effectiveness_loss, float time, bool esc_failure = false)
+	{
+		_failed_motor = motor;
+		_failure_loss = effectiveness_loss;
+		_failure_time = time;
+		_esc_failure = esc_failure;
+	}
+
+	/**
+	 * Fly aggressive rate setpoints for the given duration
+	 * @return time of the first detection [s] or -1 if none
+	 */
+	float run(float duration, bool with_rpm = false)
+	{
+		const int steps = (int)(duration / CONTROL_DT);
+		float detection_time = -1.f;
+
+		for (int step = 0; step < steps; step++) {
+			if (_failed_motor >= 0 && _time >= _failure_time) {
+				if (_esc_failure) {
+					_rpm_factor[_failed_motor] = 1.f - _failure_loss;
+				}
+
+				_efficiency[_failed_motor] = 1.f - _failure_loss;
+			}
+
+			_control(_rateSetpoint(_time));
+			_propagate(CONTROL_DT);
+			_time += CONTROL_DT;
+
+			if (step % DETECTOR_INTERVAL == 0) {
+
+				// filtered gyro noise and vibrations
+				_gyro_noise += (Vector3f(_noise(), _noise(), _noise()) * GYRO_NOISE - _gyro_noise) * 0.5f;
+				const Vector3f gyro = _rate + _gyro_noise;
+				float rpm[MotorFailureDetector::MAX_MOTORS];
+
+				for (int i = 0; i < _motor_count; i++) {
+					// ESC telemetry roughly proportional to the output
+					rpm[i] = 20000.f * _thrust[i] * _rpm_factor[i] * (1.f + 0.02f * _noise());
+				}
+
+				const bool detected = _detector.update((uint64_t)(_time * 1e6f) + 1, _outputs, gyro, with_rpm ? rpm : nullptr);
+
+				if (detected && detection_time < 0.f) {
+					detection_time = _time;
+				}
+			}
+		}
+
+		return detection_time;
+	}
+
+	MotorFailureDetector _detector;
+	float _time{0.f};
+
+private:
+	static constexpr float CONTROL_DT = 0.002f;
+	static constexpr int DETECTOR_INTERVAL = 5;
+	static constexpr float DETECTOR_DT = CONTROL_DT * DETECTOR_INTERVAL;
+	static constexpr float HOVER = 0.5f;
+	static constexpr float GYRO_NOISE = 0.05f; ///< [rad/s]
+	static constexpr float TURBULENCE = 0.5f; ///< [Nm] before filtering
+	static constexpr float MOTOR_TIME_CONSTANT = 0.035f;
+
+	/** Standard normal pseudo random number */
+	float _noise()
+	{
+		float sum = 0.f;
+
+		for (int i = 0; i < 12; i++) {
+			_seed = 1103515245u * _seed + 12345u;
+			sum += (float)((_seed >> 8) & 0xFFFF) / 65536.f;
+		}
+
+		return sum - 6.f;
+	}
+
+	Vector3f _rateSetpoint(float t) const
+	{
+		// sweeps in all axes, with a different phase in each run
+		return Vector3f(2.5f * sinf(2.f * M_PI_F * 0.7f * t + _phase),
+				2.f * sinf(2.f * M_PI_F * 1.1f * t + 2.f * _phase),
+				1.5f * sinf(2.f * M_PI_F * 0.3f * t));
+	}
+
+	void _control(const Vector3f &rate_sp)
+	{
+		const Vector3f rate_error = rate_sp - _rate;
+		_integral += rate_error.emult(Vector3f(0.2f, 0.2f, 0.1f)) * CONTROL_DT;
+		const Vector3f torque = rate_error.emult(Vector3f(0.15f, 0.15f, 0.3f)) + _integral;
+
+		for (int i = 0; i < _motor_count; i++) {
+			const MotorFailureDetector::Rotor &rotor = _geometry.getRotor(i);
+			_outputs[i] = math::constrain(HOVER + rotor.roll_scale * torque(0) + rotor.pitch_scale * torque(1)
+						      + rotor.yaw_scale * torque(2), 0.f, 1.f);
+		}
+	}
+
+	void _propagate(float dt)
+	{
+		Vector3f torque;
+
+		for (int i = 0; i < _motor_count; i++) {
+			const MotorFailureDetector::Rotor &rotor = _geometry.getRotor(i);
+			_thrust[i] += dt / (MOTOR_TIME_CONSTANT + dt) * (_outputs[i] - _thrust[i]);
+			const float thrust = _thrust[i] * _efficiency[i] * MAX_THRUST;
+			torque += Vector3f(rotor.roll_scale * ARM, rotor.pitch_scale * ARM, rotor.yaw_scale * MOMENT_COEFF) * thrust;
+		}
+
+		// turbulence, center of gravity offset and aerodynamic damping
+		_turbulence += (Vector3f(_noise(), _noise(), 0.2f * _noise()) * TURBULENCE - _turbulence) * (dt / 0.3f);
+		torque += _turbulence + Vector3f(0.05f, -0.03f, 0.f) - _rate * 0.005f;
+
+		const Vector3f inertia(0.03f, 0.03f, 0.05f);
+		const Vector3f net_torque = torque - _rate.cross(_rate.emult(inertia));
+
+		for (int axis = 0; axis < 3; axis++) {
+			_rate(axis) += net_torque(axis) / inertia(axis) * dt;
+		}
+	}
+
+	static constexpr float MAX_THRUST = 8.f; ///< [N]
+	static constexpr float ARM = 0.25f; ///< [m]
+	static constexpr float MOMENT_COEFF = 0.016f; ///< [m]
+
+	MotorFailureDetector _geometry; ///< only used for its rotor table
+	int _motor_count{0};
+	uint32_t _seed;
+	const float _phase;
+
+	Vector3f _rate;
+	Vector3f _integral;
+	Vector3f _turbulence;
+	Vector3f _gyro_noise;
+	float _outputs[MotorFailureDetector::MAX_MOTORS] {};
+	float _thrust[MotorFailureDetector::MAX_MOTORS] {};
+	float _efficiency[MotorFailureDetector::MAX_MOTORS] {};
+	float _rpm_factor[MotorFailureDetector::MAX_MOTORS] {};
+
+	int _failed_motor{-1};
+	float _failure_loss{0.f};
+	float _failure_time{0.f};
+	bool _esc_failure{false};
+};
+
+TEST(MotorFailureDetectorTest, NoGeometry)
+{
+	MotorFailureDetector detector;
+	const float outputs[4] {};
+	EXPECT_FALSE(detector.update(1000, outputs, Vector3f()));
+	EXPECT_FALSE(detector.getDetection().detected);
+	EXPECT_EQ(detector.getDetection().motor, -1);
+}
+
+TEST(MotorFailureDetectorTest, quadMotorOutIsolated)
+{
+	for (int motor = 0; motor < 4; motor++) {
+		// GIVEN: a quadrotor flying aggressive maneuvers
+		MulticopterSimulation sim(MotorFailureDetector::Geometry::quad_x, motor + 1);
+
+		// WHEN: one motor stops
+		const float failure_time = 5.f;
+		sim.injectFailure(motor, 1.f, failure_time);
+		const float detection_time = sim.run(6.f);
+
+		// THEN: it is isolated within a few cycles of the detector
+		const MotorFailureDetector::Detection &detection = sim._detector.getDetection();
+		EXPECT_TRUE(detection.detected);
+		EXPECT_EQ(detection.motor, motor);
+		EXPECT_EQ(detection.source, MotorFailureDetector::Source::residual);
+		EXPECT_GT(detection_time, failure_time);
+		EXPECT_LT(detection_time - failure_time, 0.1f);
+		EXPECT_LE(detection.latency, detection_time - failure_time);
+		EXPECT_GT(detection.confidence, 0.9f);
+		EXPECT_GT(detection.effectiveness_loss, 0.5f);
+		printf("quad motor %d: detected after %.0f ms, confidence %.2f, loss %.2f\n", motor,
+		       (double)((detection_time - failure_time) * 1e3f), (double)detection.confidence,
+		       (double)detection.effectiveness_loss);
+	}
+}
+
+TEST(MotorFailureDetectorTest, hexPartialFailureIsolated)
+{
+	for (int motor = 0; motor < 6; motor++) {
+		// GIVEN: a hexacopter flying aggressive maneuvers
+		MulticopterSimulation sim(MotorFailureDetector::Geometry::hex_x, motor + 11);
+
+		// WHEN: one motor loses 60% of its thrust (e.g. broken propeller)
+		const float failure_time = 5.f;
+		sim.injectFailure(motor, 0.6f, failure_time);
+		const float detection_time = sim.run(7.f);
+
+		// THEN: the degraded motor is isolated
+		const MotorFailureDetector::Detection &detection = sim._detector.getDetection();
+		EXPECT_TRUE(detection.detected);
+		EXPECT_EQ(detection.motor, motor);
+		EXPECT_GT(detection_time, failure_time);
+		EXPECT_LT(detection_time - failure_time, 0.2f);
+		printf("hex motor %d: detected after %.0f ms, loss %.2f\n", motor,
+		       (double)((detection_time - failure_time) * 1e3f), (double)detection.effectiveness_loss);
+	}
+}
+
+TEST(MotorFailureDetectorTest, noFalsePositives)
+{
+	// GIVEN: aggressive flights without failure, with a wrong initial effectiveness,
+	// a center of gravity offset, motor lag mismatch and gyro noise
+	int false_positives = 0;
+	float flight_time = 0.f;
+
+	for (uint32_t seed = 100; seed < 120; seed++) {
+		MulticopterSimulation sim(seed % 2 ? MotorFailureDetector::Geometry::quad_x : MotorFailureDetector::Geometry::hex_x,
+					  seed);
+
+		// WHEN: they fly for a minute each
+		if (sim.run(60.f) >= 0.f) {
+			false_positives++;
+		}
+
+		flight_time += sim._time;
+	}
+
+	// THEN: no failure is detected
+	EXPECT_EQ(false_positives, 0);
+	printf("%d false positives in %.0f min of flight\n", false_positives, (double)(flight_time / 60.f));
+}
+
+TEST(MotorFailureDetectorTest, escTelemetry)
+{
+	// GIVEN: a quadrotor reporting ESC telemetry, with a residual threshold too high to detect a failure
+	MulticopterSimulation sim(MotorFailureDetector::Geometry::quad_x, 7);
+	sim._detector.setResidualThreshold(15.f);
+
+	// WHEN: a motor slows down because of a desync of its ESC
+	const float failure_time = 3.f;
+	sim.injectFailure(2, 0.7f, failure_time, true);
+	const float detection_time = sim.run(4.f, true);
+
+	// THEN: the telemetry isolates it
+	const MotorFailureDetector::Detection &detection = sim._detector.getDetection();
+	EXPECT_TRUE(detection.detected);
+	EXPECT_EQ(detection.motor, 2);
+	EXPECT_EQ(detection.source, MotorFailureDetector::Source::esc);
+	EXPECT_LT(detection_time - failure_time, 0.1f);
+	EXPECT_NEAR(detection.effectiveness_loss, 0.7f, 0.1f);
+}
+
+TEST(MotorFailureDetectorTest, resetClearsDetection)
+{
+	MulticopterSimulation sim(MotorFailureDetector::Geometry::quad_x);
+	sim.injectFailure(0, 1.f, 2.f);
+	sim.run(3.f);
+	EXPECT_TRUE(sim._detector.getDetection().detected);
+
+	sim._detector.reset();
+	EXPECT_FALSE(sim._detector.getDetection().detected);
+	EXPECT_EQ(sim._detector.getDetection().motor, -1);
+}
+
+TEST(MotorFailureDetectorTest, groundContactIgnored)
+{
+	// GIVEN: a quadrotor touching the ground
+	MulticopterSimulation sim(MotorFailureDetector::Geometry::quad_x, 3);
+	sim._detector.setGroundContact(true);
+
+	// WHEN: the ground reaction looks like a motor failure
+	sim.injectFailure(1, 1.f, 2.f);
+	const float detection_time = sim.run(3.f);
+
+	// THEN: it is not detected
+	EXPECT_LT(detection_time, 0.f);
+	EXPECT_FALSE(sim._detector.getDetection().detected);
+}
+
+TEST(MotorFailureDetectorTest, measuredUpdateRate)
+{
+	// GIVEN: a detector configured for a higher rate than it is actually called with
+	MulticopterSimulation sim(MotorFailureDetector::Geometry::quad_x, 5);
+	sim._detector.setFilterCutoff(250.f, 15.f);
+
+	// WHEN: a motor stops
+	const float failure_time = 3.f;
+	sim.injectFailure(3, 1.f, failure_time);
+	const float detection_time = sim.run(4.f);
+
+	// THEN: it is still isolated, without a false detection before
+	const MotorFailureDetector::Detection &detection = sim._detector.getDetection();
+	EXPECT_TRUE(detection.detected);
+	EXPECT_EQ(detection.motor, 3);
+	EXPECT_GE(detection_time, failure_time);
+}
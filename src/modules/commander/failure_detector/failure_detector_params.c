@@ -103,3 +103,135 @@ PARAM_DEFINE_FLOAT(FD_FAIL_R_TTRI, 0.3);
  * @group Failure Detector
  */
 PARAM_DEFINE_FLOAT(FD_FAIL_P_TTRI, 0.3);
+
+/**
+ * Motor failure detection
+ *
+ * Compares the angular acceleration predicted from the motor outputs with the
+ * measured one (and the ESC telemetry if available) to isolate a failed motor
+ * on multicopters. The detection is published in the motor_failure topic.
+ *
+ * If set to failsafe, a detected motor failure sets the motor failure flag which
+ * terminates the flight if flight termination is enabled (@CBRK_FLIGHTTERM set to 0).
+ *
+ * @value 0 Disabled
+ * @value 1 Report only
+ * @value 2 Report and failsafe
+ *
+ * @group Failure Detector
+ */
+PARAM_DEFINE_INT32(FD_MOT_EN, 0);
+
+/**
+ * Motor geometry for the motor failure detection
+ *
+ * Needs to match the mixer of the vehicle, check it before enabling @FD_MOT_EN.
+ *
+ * @value 0 Quadrotor x
+ * @value 1 Quadrotor +
+ * @value 2 Hexarotor x
+ * @value 3 Hexarotor +
+ * @value 4 Octorotor x
+ *
+ * @group Failure Detector
+ */
+PARAM_DEFINE_INT32(FD_MOT_GEOM, 0);
+
+/**
+ * Initial roll and pitch effectiveness for the motor failure detection
+ *
+ * Angular acceleration produced by a full motor output on a rotor at unit
+ * distance of the axis. This is only an initial value, it is adapted in flight.
+ *
+ * @unit rad/s^2
+ * @min 5
+ * @max 500
+ * @decimal 0
+ * @increment 5
+ * @group Failure Detector
+ */
+PARAM_DEFINE_FLOAT(FD_MOT_EFF_RP, 60.f);
+
+/**
+ * Initial yaw effectiveness for the motor failure detection
+ *
+ * Yaw angular acceleration produced by a full motor output.
+ * This is only an initial value, it is adapted in flight.
+ *
+ * @unit rad/s^2
+ * @min 0.5
+ * @max 50
+ * @decimal 1
+ * @increment 0.5
+ * @group Failure Detector
+ */
+PARAM_DEFINE_FLOAT(FD_MOT_EFF_Y, 4.f);
+
+/**
+ * Motor time constant for the motor failure detection
+ *
+ * @unit s
+ * @min 0.0
+ * @max 0.2
+ * @decimal 3
+ * @increment 0.005
+ * @group Failure Detector
+ */
+PARAM_DEFINE_FLOAT(FD_MOT_TAU, 0.03f);
+
+/**
+ * Motor failure angular acceleration threshold
+ *
+ * Norm of the difference between the measured and the predicted angular acceleration
+ * above which a motor failure is suspected. Increase it if failures are detected in
+ * turbulent air, decrease it to detect partial failures faster.
+ *
+ * @unit rad/s^2
+ * @min 5
+ * @max 200
+ * @decimal 0
+ * @increment 1
+ * @group Failure Detector
+ */
+PARAM_DEFINE_FLOAT(FD_MOT_THR, 15.f);
+
+/**
+ * Motor failure trigger time
+ *
+ * Time the same motor needs to be isolated before it is considered as failed.
+ *
+ * @unit s
+ * @min 0.0
+ * @max 1
+ * @decimal 2
+ * @increment 0.01
+ * @group Failure Detector
+ */
+PARAM_DEFINE_FLOAT(FD_MOT_TTRI, 0.02f);
+
+/**
+ * Motor failure ESC rpm ratio
+ *
+ * A motor is considered as failed if its ESC reports an rpm per output below
+ * this fraction of the median of all motors. Only used with ESC telemetry.
+ *
+ * @min 0.1
+ * @max 0.9
+ * @decimal 2
+ * @increment 0.05
+ * @group Failure Detector
+ */
+PARAM_DEFINE_FLOAT(FD_MOT_ESC_R, 0.5f);
+
+/**
+ * Motor output type for the motor failure detection
+ *
+ * Range of the actuator outputs of the motors, used to normalize them.
+ *
+ * @value 0 PWM (PWM_MIN to PWM_MAX)
+ * @value 1 UAVCAN ESC raw command (0 to 8191)
+ * @value 2 Normalized (-1 to 1)
+ *
+ * @group Failure Detector
+ */
+PARAM_DEFINE_INT32(FD_MOT_OUT, 0);
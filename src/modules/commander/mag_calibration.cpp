@@ -41,6 +41,7 @@
 #include "commander_helper.h"
 #include "calibration_routines.h"
 #include "calibration_messages.h"
+#include "mag_calibration_estimator/MagCalibrationEstimator.hpp"
 
 #include <px4_defines.h>
 #include <px4_posix.h>
@@ -57,6 +58,7 @@
 #include <drivers/drv_gyro.h>
 #include <drivers/drv_mag.h>
 #include <drivers/drv_tone_alarm.h>
+#include <mathlib/mathlib.h>
 #include <systemlib/mavlink_log.h>
 #include <parameters/param.h>
 #include <systemlib/err.h>
@@ -93,6 +95,7 @@ typedef struct  {
 	float		*x[max_mags];
 	float		*y[max_mags];
 	float		*z[max_mags];
+	MagCalibrationEstimator	*estimator[max_mags];	///< Calibration updated with every accepted sample
 } mag_worker_data_t;
 
 
@@ -291,6 +294,23 @@ static unsigned progress_percentage(mag_worker_data_t *worker_data)
 	return 100 * ((float)worker_data->done_count) / calibration_sides;
 }
 
+/// Returns true if the streaming calibration of all mags covers enough orientations with a good fit
+static bool coverage_complete(mag_worker_data_t *worker_data, float *min_coverage)
+{
+	bool complete = true;
+	*min_coverage = 1.f;
+
+	for (size_t cur_mag = 0; cur_mag < max_mags; cur_mag++) {
+		if (device_ids[cur_mag] != 0 && worker_data->estimator[cur_mag] != nullptr) {
+			const MagCalibrationEstimator &estimator = *worker_data->estimator[cur_mag];
+			*min_coverage = math::min(*min_coverage, estimator.getCoverage());
+			complete = complete && estimator.isConverged();
+		}
+	}
+
+	return complete;
+}
+
 // Returns calibrate_return_error if any parameter is not finite
 // Logs if parameters are out of range
 static calibrate_return check_calibration_result(float offset_x, float offset_y, float offset_z,
@@ -428,9 +448,10 @@ static calibrate_return mag_calibration_worker(detect_orientation_return orienta
 	unsigned poll_errcount = 0;
 
 	calibration_counter_side = 0;
+	bool complete = false;
 
 	while (hrt_absolute_time() < calibration_deadline &&
-	       calibration_counter_side < worker_data->calibration_points_perside) {
+	       calibration_counter_side < worker_data->calibration_points_perside && !complete) {
 
 		if (calibrate_cancel_check(worker_data->mavlink_log_pub, cancel_sub)) {
 			result = calibrate_return_cancelled;
@@ -488,11 +509,28 @@ static calibrate_return mag_calibration_worker(detect_orientation_return orienta
 			} else {
 				calibration_counter_side++;
 
+				// Update the streaming calibration with the new sample
+				for (size_t cur_mag = 0; cur_mag < max_mags; cur_mag++) {
+					if (worker_data->estimator[cur_mag] != nullptr && worker_data->calibration_counter_total[cur_mag] > 0) {
+						const unsigned last = worker_data->calibration_counter_total[cur_mag] - 1;
+						worker_data->estimator[cur_mag]->update(matrix::Vector3f(worker_data->x[cur_mag][last],
+											worker_data->y[cur_mag][last],
+											worker_data->z[cur_mag][last]));
+					}
+				}
+
+				float min_coverage = 0.f;
+				complete = coverage_complete(worker_data, &min_coverage);
+
 				unsigned new_progress = progress_percentage(worker_data) +
 							(unsigned)((100 / calibration_sides) * ((float)calibration_counter_side / (float)
 									worker_data->calibration_points_perside));
 
-				if (new_progress - _last_mag_progress > 3) {
+				// The orientation coverage can be ahead of the sides
+				new_progress = math::max(new_progress, (unsigned)(100.f * min_coverage / MagCalibrationEstimator::CONVERGED_COVERAGE));
+				new_progress = math::min(new_progress, 99u);
+
+				if ((int)new_progress - (int)_last_mag_progress > 3) {
 					// Progress indicator for side
 					calibration_log_info(worker_data->mavlink_log_pub,
 							     "[cal] %s side calibration: progress <%u>",
@@ -514,7 +552,21 @@ static calibrate_return mag_calibration_worker(detect_orientation_return orienta
 		}
 	}
 
-	if (result == calibrate_return_ok) {
+	if (result == calibrate_return_ok && complete) {
+		// Enough orientations are covered, skip the remaining sides
+		calibration_log_info(worker_data->mavlink_log_pub, "[cal] orientation coverage complete");
+
+		for (unsigned i = 0; i < detect_orientation_side_count; i++) {
+			if (!worker_data->side_data_collected[i]) {
+				worker_data->side_data_collected[i] = true;
+				worker_data->done_count++;
+			}
+		}
+
+		px4_usleep(20000);
+		calibration_log_info(worker_data->mavlink_log_pub, CAL_QGC_PROGRESS_MSG, progress_percentage(worker_data));
+
+	} else if (result == calibrate_return_ok) {
 		calibration_log_info(worker_data->mavlink_log_pub, "[cal] %s side done, rotate to a different side",
 				     detect_orientation_str(orientation));
 
@@ -571,6 +623,7 @@ calibrate_return mag_calibrate_all(orb_advert_t *mavlink_log_pub)
 		worker_data.x[cur_mag] = nullptr;
 		worker_data.y[cur_mag] = nullptr;
 		worker_data.z[cur_mag] = nullptr;
+		worker_data.estimator[cur_mag] = nullptr;
 		worker_data.calibration_counter_total[cur_mag] = 0;
 	}
 
@@ -590,8 +643,15 @@ calibrate_return mag_calibrate_all(orb_advert_t *mavlink_log_pub)
 		worker_data.x[cur_mag] = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_points_maxcount));
 		worker_data.y[cur_mag] = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_points_maxcount));
 		worker_data.z[cur_mag] = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_points_maxcount));
+		worker_data.estimator[cur_mag] = new MagCalibrationEstimator();
+
+		if (worker_data.estimator[cur_mag] != nullptr) {
+			// samples are already spread by reject_sample()
+			worker_data.estimator[cur_mag]->setMinSampleDistance(0.f);
+		}
 
-		if (worker_data.x[cur_mag] == nullptr || worker_data.y[cur_mag] == nullptr || worker_data.z[cur_mag] == nullptr) {
+		if (worker_data.x[cur_mag] == nullptr || worker_data.y[cur_mag] == nullptr || worker_data.z[cur_mag] == nullptr
+		    || worker_data.estimator[cur_mag] == nullptr) {
 			calibration_log_critical(mavlink_log_pub, "ERROR: out of memory");
 			result = calibrate_return_error;
 		}
@@ -797,6 +857,7 @@ calibrate_return mag_calibrate_all(orb_advert_t *mavlink_log_pub)
 		free(worker_data.x[cur_mag]);
 		free(worker_data.y[cur_mag]);
 		free(worker_data.z[cur_mag]);
+		delete worker_data.estimator[cur_mag];
 	}
 
 	if (result == calibrate_return_ok) {
@@ -0,0 +1,402 @@
+
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file MagCalibrationEstimator.cpp
+ */
+
+#include "MagCalibrationEstimator.hpp"
+
+#include <float.h>
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+using namespace matrix;
+
+void MagCalibrationEstimator::reset()
+{
+	_sphere_ata.setZero();
+	_sphere_atb.setZero();
+	_ellipsoid_ata.setZero();
+	_ellipsoid_atb.setZero();
+
+	for (int i = 0; i < COVERAGE_BINS; i++) {
+		_coverage_weight[i] = 0.f;
+	}
+
+	_last_sample.setZero();
+	_offset.setZero();
+	_soft_iron.setIdentity();
+	_radius = 0.f;
+	_fit_error_squared = 0.f;
+	_sample_count = 0;
+	_valid = false;
+	_ellipsoid_fit = false;
+}
+
+bool MagCalibrationEstimator::update(const Vector3f &mag)
+{
+	if (!PX4_ISFINITE(mag(0)) || !PX4_ISFINITE(mag(1)) || !PX4_ISFINITE(mag(2))) {
+		return false;
+	}
+
+	// Samples too close to each other (e.g. vehicle not rotating) would give too much weight to one direction
+	if (_sample_count > 0 && (mag - _last_sample).norm() < _min_sample_distance) {
+		return false;
+	}
+
+	// Fit quality, evaluated with the calibration the sample did not contribute to yet
+	if (_valid) {
+		const float error = correct(mag).norm() / _radius - 1.f;
+		const float gain = math::max(1.f / (_sample_count + 1), math::max(1.f - _lambda, 0.02f));
+		_fit_error_squared = (1.f - gain) * _fit_error_squared + gain * error * error;
+	}
+
+	// Forget the old samples
+	if (_lambda < 1.f) {
+		_sphere_ata *= _lambda;
+		_sphere_atb *= _lambda;
+		_ellipsoid_ata *= _lambda;
+		_ellipsoid_atb *= _lambda;
+
+		for (int i = 0; i < COVERAGE_BINS; i++) {
+			_coverage_weight[i] *= _lambda;
+		}
+	}
+
+	const float x = mag(0);
+	const float y = mag(1);
+	const float z = mag(2);
+
+	const float sphere_row[4] = {2.f * x, 2.f * y, 2.f * z, 1.f};
+	const float sphere_target = mag.dot(mag);
+
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			_sphere_ata(i, j) += sphere_row[i] * sphere_row[j];
+		}
+
+		_sphere_atb(i) += sphere_row[i] * sphere_target;
+	}
+
+	const float ellipsoid_row[9] = {x * x, y * y, z * z, 2.f * x * y, 2.f * x * z, 2.f * y * z, 2.f * x, 2.f * y, 2.f * z};
+
+	for (int i = 0; i < 9; i++) {
+		for (int j = 0; j < 9; j++) {
+			_ellipsoid_ata(i, j) += ellipsoid_row[i] * ellipsoid_row[j];
+		}
+
+		_ellipsoid_atb(i) += ellipsoid_row[i];
+	}
+
+	const int bin = _coverageBin(mag - _offset);
+
+	if (bin >= 0) {
+		_coverage_weight[bin] += 1.f;
+	}
+
+	_last_sample = mag;
+	_sample_count++;
+
+	// The full ellipsoid is only observable if enough orientations have been covered
+	_ellipsoid_fit = (getCoverage() >= _ellipsoid_min_coverage) && _solveEllipsoid();
+
+	if (!_ellipsoid_fit) {
+		_valid = _solveSphere();
+
+	} else {
+		_valid = true;
+	}
+
+	return true;
+}
+
+float MagCalibrationEstimator::getCoverage() const
+{
+	int covered = 0;
+
+	for (int i = 0; i < COVERAGE_BINS; i++) {
+		if (_coverage_weight[i] > 0.5f) {
+			covered++;
+		}
+	}
+
+	return (float)covered / COVERAGE_BINS;
+}
+
+bool MagCalibrationEstimator::isConverged(float min_coverage, float max_fit_rms, int min_samples) const
+{
+	return _valid
+	       && _sample_count >= min_samples
+	       && getCoverage() >= min_coverage
+	       && getFitRms() <= max_fit_rms;
+}
+
+bool MagCalibrationEstimator::_solveSphere()
+{
+	if (_sample_count < 4) {
+		return false;
+	}
+
+	Vector<float, 4> solution;
+
+	if (!_solveCholesky<4>(_sphere_ata, _sphere_atb, solution)) {
+		return false;
+	}
+
+	const Vector3f offset(solution(0), solution(1), solution(2));
+	const float radius_squared = solution(3) + offset.dot(offset);
+
+	if (!PX4_ISFINITE(radius_squared) || radius_squared < FLT_EPSILON) {
+		return false;
+	}
+
+	_offset = offset;
+	_soft_iron.setIdentity();
+	_radius = sqrtf(radius_squared);
+	return true;
+}
+
+bool MagCalibrationEstimator::_solveEllipsoid()
+{
+	if (_sample_count < 9) {
+		return false;
+	}
+
+	Vector<float, 9> p;
+
+	if (!_solveCholesky<9>(_ellipsoid_ata, _ellipsoid_atb, p)) {
+		return false;
+	}
+
+	SquareMatrix<float, 3> M;
+	M(0, 0) = p(0);
+	M(1, 1) = p(1);
+	M(2, 2) = p(2);
+	M(0, 1) = M(1, 0) = p(3);
+	M(0, 2) = M(2, 0) = p(4);
+	M(1, 2) = M(2, 1) = p(5);
+	Vector<float, 3> minus_v;
+	minus_v(0) = -p(6);
+	minus_v(1) = -p(7);
+	minus_v(2) = -p(8);
+
+	// Center: (m - o)' M (m - o) = 1 + o' M o with o = -M^-1 v
+	Vector<float, 3> center;
+
+	if (!_solveCholesky<3>(M, minus_v, center)) {
+		return false;
+	}
+
+	const float k = 1.f + center.dot(M * center);
+
+	if (!PX4_ISFINITE(k) || k < FLT_EPSILON) {
+		return false;
+	}
+
+	const Matrix3f shape = M / k;
+	Matrix3f sqrt_shape;
+
+	if (!_sqrtSymmetric(shape, sqrt_shape)) {
+		return false;
+	}
+
+	// Normalize the soft iron matrix such that it doesn't change the volume
+	const float det = shape(0, 0) * (shape(1, 1) * shape(2, 2) - shape(1, 2) * shape(2, 1))
+			  - shape(0, 1) * (shape(1, 0) * shape(2, 2) - shape(1, 2) * shape(2, 0))
+			  + shape(0, 2) * (shape(1, 0) * shape(2, 1) - shape(1, 1) * shape(2, 0));
+
+	if (!PX4_ISFINITE(det) || det < FLT_EPSILON) {
+		return false;
+	}
+
+	const float radius = powf(det, -1.f / 6.f);
+
+	_offset = Vector3f(center);
+	_soft_iron = (sqrt_shape + sqrt_shape.transpose()) * (0.5f * radius);
+	_radius = radius;
+	return true;
+}
+
+int MagCalibrationEstimator::_coverageBin(const Vector3f &direction) const
+{
+	int axis = 0;
+
+	for (int i = 1; i < 3; i++) {
+		if (fabsf(direction(i)) > fabsf(direction(axis))) {
+			axis = i;
+		}
+	}
+
+	if (fabsf(direction(axis)) < FLT_EPSILON) {
+		return -1;
+	}
+
+	const int face = 2 * axis + (direction(axis) < 0.f ? 1 : 0);
+	const int quadrant = (direction((axis + 1) % 3) < 0.f ? 1 : 0) + (direction((axis + 2) % 3) < 0.f ? 2 : 0);
+
+	return 4 * face + quadrant;
+}
+
+template<size_t N>
+bool MagCalibrationEstimator::_solveCholesky(const SquareMatrix<float, N> &A, const Vector<float, N> &b,
+		Vector<float, N> &x)
+{
+	// Small regularization relative to the magnitude of the matrix
+	float trace = 0.f;
+
+	for (size_t i = 0; i < N; i++) {
+		trace += A(i, i);
+	}
+
+	const float regularization = 1e-7f * trace / N;
+
+	// A = L * L'
+	SquareMatrix<float, N> L;
+	L.setZero();
+
+	for (size_t j = 0; j < N; j++) {
+		float diagonal = A(j, j) + regularization;
+
+		for (size_t k = 0; k < j; k++) {
+			diagonal -= L(j, k) * L(j, k);
+		}
+
+		if (!PX4_ISFINITE(diagonal) || diagonal <= FLT_EPSILON * regularization) {
+			return false;
+		}
+
+		L(j, j) = sqrtf(diagonal);
+
+		for (size_t i = j + 1; i < N; i++) {
+			float sum = A(i, j);
+
+			for (size_t k = 0; k < j; k++) {
+				sum -= L(i, k) * L(j, k);
+			}
+
+			L(i, j) = sum / L(j, j);
+		}
+	}
+
+	// Forward substitution L * y = b
+	Vector<float, N> y;
+
+	for (size_t i = 0; i < N; i++) {
+		float sum = b(i);
+
+		for (size_t k = 0; k < i; k++) {
+			sum -= L(i, k) * y(k);
+		}
+
+		y(i) = sum / L(i, i);
+	}
+
+	// Backward substitution L' * x = y
+	for (size_t i = N; i-- > 0;) {
+		float sum = y(i);
+
+		for (size_t k = i + 1; k < N; k++) {
+			sum -= L(k, i) * x(k);
+		}
+
+		x(i) = sum / L(i, i);
+	}
+
+	return true;
+}
+
+bool MagCalibrationEstimator::_sqrtSymmetric(const Matrix3f &A, Matrix3f &sqrt_A)
+{
+	Matrix3f D = A;
+	Matrix3f V;
+	V.setIdentity();
+
+	for (int sweep = 0; sweep < 10; sweep++) {
+		const float off_diagonal = fabsf(D(0, 1)) + fabsf(D(0, 2)) + fabsf(D(1, 2));
+
+		if (off_diagonal < 1e-9f * (fabsf(D(0, 0)) + fabsf(D(1, 1)) + fabsf(D(2, 2)))) {
+			break;
+		}
+
+		for (int p = 0; p < 2; p++) {
+			for (int q = p + 1; q < 3; q++) {
+				if (fabsf(D(p, q)) < FLT_MIN) {
+					continue;
+				}
+
+				// Rotation zeroing D(p, q)
+				const float theta = (D(q, q) - D(p, p)) / (2.f * D(p, q));
+				const float t = (theta >= 0.f ? 1.f : -1.f) / (fabsf(theta) + sqrtf(theta * theta + 1.f));
+				const float c = 1.f / sqrtf(t * t + 1.f);
+				const float s = t * c;
+
+				for (int k = 0; k < 3; k++) {
+					const float d_kp = D(k, p);
+					const float d_kq = D(k, q);
+					D(k, p) = c * d_kp - s * d_kq;
+					D(k, q) = s * d_kp + c * d_kq;
+				}
+
+				for (int k = 0; k < 3; k++) {
+					const float d_pk = D(p, k);
+					const float d_qk = D(q, k);
+					D(p, k) = c * d_pk - s * d_qk;
+					D(q, k) = s * d_pk + c * d_qk;
+				}
+
+				for (int k = 0; k < 3; k++) {
+					const float v_kp = V(k, p);
+					const float v_kq = V(k, q);
+					V(k, p) = c * v_kp - s * v_kq;
+					V(k, q) = s * v_kp + c * v_kq;
+				}
+			}
+		}
+	}
+
+	Matrix3f sqrt_eigenvalues;
+	sqrt_eigenvalues.setZero();
+
+	for (int i = 0; i < 3; i++) {
+		if (!PX4_ISFINITE(D(i, i)) || D(i, i) <= 0.f) {
+			return false;
+		}
+
+		sqrt_eigenvalues(i, i) = sqrtf(D(i, i));
+	}
+
+	sqrt_A = V * sqrt_eigenvalues * V.transpose();
+	return true;
+}
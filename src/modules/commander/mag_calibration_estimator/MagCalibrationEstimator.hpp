@@ -0,0 +1,159 @@
+
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file MagCalibrationEstimator.hpp
+ *
+ * Incremental magnetometer calibration.
+ *
+ * The sufficient statistics of the linear least-squares sphere and ellipsoid fits are
+ * accumulated with every accepted sample, such that the hard iron offset and the soft iron
+ * matrix can be updated on the fly without storing the samples. An optional forgetting factor
+ * allows to track slow changes of the magnetic environment (e.g. in flight after a payload change).
+ *
+ * The corrected field is W * (mag - offset), where W is symmetric with det(W) = 1 and the
+ * corrected field has the norm getRadius().
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+
+class MagCalibrationEstimator
+{
+public:
+	static constexpr int COVERAGE_BINS = 24; ///< 6 axis directions with 4 quadrants each
+
+	static constexpr float CONVERGED_COVERAGE = 0.75f; ///< default orientation coverage of a converged calibration
+	static constexpr float CONVERGED_FIT_RMS = 0.02f; ///< default maximum normalized fit error of a converged calibration
+	static constexpr int CONVERGED_MIN_SAMPLES = 100; ///< default minimum number of samples of a converged calibration
+
+	MagCalibrationEstimator() { reset(); }
+	~MagCalibrationEstimator() = default;
+
+	void reset();
+
+	/**
+	 * Add a sample and update the calibration.
+	 * @param mag magnetic field [Gauss]
+	 * @return true if the sample was used, false if it was too close to the previous one
+	 */
+	bool update(const matrix::Vector3f &mag);
+
+	/**
+	 * @param lambda weight of the previous samples for each new sample, 1 to never forget
+	 */
+	void setForgettingFactor(float lambda) { _lambda = lambda; }
+
+	/**
+	 * @param distance minimum distance to the previous sample for a new sample to be used [Gauss]
+	 */
+	void setMinSampleDistance(float distance) { _min_sample_distance = distance; }
+
+	/**
+	 * @param min_coverage orientation coverage required to fit the full ellipsoid (0-1)
+	 */
+	void setEllipsoidMinCoverage(float min_coverage) { _ellipsoid_min_coverage = min_coverage; }
+
+	const matrix::Vector3f &getOffset() const { return _offset; }
+	const matrix::Matrix3f &getSoftIron() const { return _soft_iron; }
+	matrix::Vector3f getDiagonal() const { return matrix::Vector3f(_soft_iron(0, 0), _soft_iron(1, 1), _soft_iron(2, 2)); }
+	matrix::Vector3f getOffDiagonal() const { return matrix::Vector3f(_soft_iron(0, 1), _soft_iron(0, 2), _soft_iron(1, 2)); }
+	float getRadius() const { return _radius; }
+
+	matrix::Vector3f correct(const matrix::Vector3f &mag) const { return _soft_iron * (mag - _offset); }
+
+	/**
+	 * @return normalized RMS of the corrected field norm, evaluated on each sample before it is used
+	 */
+	float getFitRms() const { return sqrtf(_fit_error_squared); }
+
+	/**
+	 * @return fraction of the orientation bins in which samples have been collected (0-1)
+	 */
+	float getCoverage() const;
+
+	int getSampleCount() const { return _sample_count; }
+	bool isValid() const { return _valid; }
+	bool isEllipsoidFit() const { return _ellipsoid_fit; }
+
+	/**
+	 * @return true if the calibration is valid, covers enough orientations and fits the samples well
+	 */
+	bool isConverged(float min_coverage = CONVERGED_COVERAGE, float max_fit_rms = CONVERGED_FIT_RMS,
+			 int min_samples = CONVERGED_MIN_SAMPLES) const;
+
+private:
+	bool _solveSphere();
+	bool _solveEllipsoid();
+	int _coverageBin(const matrix::Vector3f &direction) const;
+
+	/**
+	 * Solve A * x = b for a symmetric positive definite A using the Cholesky decomposition
+	 * @return false if A is not positive definite
+	 */
+	template<size_t N>
+	static bool _solveCholesky(const matrix::SquareMatrix<float, N> &A, const matrix::Vector<float, N> &b,
+				   matrix::Vector<float, N> &x);
+
+	/**
+	 * Square root of a symmetric positive definite 3x3 matrix using Jacobi eigenvalue iterations
+	 * @return false if the matrix is not positive definite
+	 */
+	static bool _sqrtSymmetric(const matrix::Matrix3f &A, matrix::Matrix3f &sqrt_A);
+
+	// Sphere: |m|^2 = 2 * m.o + c, rows [2x 2y 2z 1]
+	matrix::SquareMatrix<float, 4> _sphere_ata;
+	matrix::Vector<float, 4> _sphere_atb;
+
+	// Ellipsoid: m' M m + 2 v' m = 1, rows [x^2 y^2 z^2 2xy 2xz 2yz 2x 2y 2z]
+	matrix::SquareMatrix<float, 9> _ellipsoid_ata;
+	matrix::Vector<float, 9> _ellipsoid_atb;
+
+	float _coverage_weight[COVERAGE_BINS];
+
+	matrix::Vector3f _last_sample;
+	matrix::Vector3f _offset;
+	matrix::Matrix3f _soft_iron;
+	float _radius{0.f};
+	float _fit_error_squared{0.f};
+
+	int _sample_count{0};
+	bool _valid{false};
+	bool _ellipsoid_fit{false};
+
+	float _lambda{1.f};
+	float _min_sample_distance{0.02f};
+	float _ellipsoid_min_coverage{0.6f};
+};
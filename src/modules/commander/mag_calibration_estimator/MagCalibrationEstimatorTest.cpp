@@ -0,0 +1,283 @@
+
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Test code for the incremental magnetometer calibration
+ * Run this test only using make tests TESTFILTER=MagCalibrationEstimator
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/matrix/math.hpp>
+#include <mathlib/mathlib.h>
+
+#include "MagCalibrationEstimator.hpp"
+
+using namespace matrix;
+
+class MagCalibrationEstimatorTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		// Soft iron distortion: the sensor measures distortion * field + offset
+		_distortion(0, 0) = 1.1f;
+		_distortion(1, 1) = 0.9f;
+		_distortion(2, 2) = 1.05f;
+		_distortion(0, 1) = _distortion(1, 0) = 0.05f;
+		_distortion(0, 2) = _distortion(2, 0) = -0.03f;
+		_distortion(1, 2) = _distortion(2, 1) = 0.02f;
+		_offset = Vector3f(0.2f, -0.1f, 0.3f);
+	}
+
+	/** Deterministic pseudo random number in [-1, 1) */
+	float random()
+	{
+		_seed = 1103515245u * _seed + 12345u;
+		return (float)((_seed >> 8) & 0xFFFF) / 32768.f - 1.f;
+	}
+
+	/** Field measured by the distorted sensor for a given direction of the earth field in body frame */
+	Vector3f measure(const Vector3f &direction)
+	{
+		const Vector3f noise(random(), random(), random());
+		return _distortion * (direction.normalized() * _field_strength) + _offset + noise * _noise;
+	}
+
+	/** Direction spread over the whole sphere */
+	Vector3f randomDirection()
+	{
+		Vector3f direction;
+
+		do {
+			direction = Vector3f(random(), random(), random());
+		} while (direction.norm() > 1.f || direction.norm() < 0.1f);
+
+		return direction;
+	}
+
+	/** Relative spread of the norm of the corrected samples */
+	float correctedSpread(int n)
+	{
+		float min_norm = INFINITY;
+		float max_norm = 0.f;
+
+		for (int i = 0; i < n; i++) {
+			const float norm = _estimator.correct(measure(randomDirection())).norm();
+			min_norm = fminf(min_norm, norm);
+			max_norm = fmaxf(max_norm, norm);
+		}
+
+		return (max_norm - min_norm) / _estimator.getRadius();
+	}
+
+	MagCalibrationEstimator _estimator;
+	Matrix3f _distortion{};
+	Vector3f _offset;
+	float _field_strength{0.5f};
+	float _noise{0.002f};
+	uint32_t _seed{1};
+};
+
+TEST_F(MagCalibrationEstimatorTest, hardIronOnly)
+{
+	// GIVEN: a sensor with offsets only
+	_distortion.setIdentity();
+
+	// WHEN: the vehicle is rotated in all directions
+	for (int i = 0; i < 300; i++) {
+		_estimator.update(measure(randomDirection()));
+	}
+
+	// THEN: the offsets and the field strength are found
+	EXPECT_TRUE(_estimator.isValid());
+	EXPECT_TRUE(_estimator.isEllipsoidFit());
+	EXPECT_LT((_estimator.getOffset() - _offset).norm(), 0.005f);
+	EXPECT_NEAR(_estimator.getRadius(), _field_strength, 0.005f);
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			EXPECT_NEAR(_estimator.getSoftIron()(i, j), (i == j) ? 1.f : 0.f, 0.01f);
+		}
+	}
+
+	EXPECT_LT(_estimator.getFitRms(), 0.01f);
+	EXPECT_FLOAT_EQ(_estimator.getCoverage(), 1.f);
+}
+
+TEST_F(MagCalibrationEstimatorTest, softIron)
+{
+	// WHEN: the vehicle is rotated in all directions
+	for (int i = 0; i < 300; i++) {
+		_estimator.update(measure(randomDirection()));
+	}
+
+	// THEN: the distorted sphere is corrected
+	EXPECT_TRUE(_estimator.isEllipsoidFit());
+	EXPECT_LT((_estimator.getOffset() - _offset).norm(), 0.005f);
+	EXPECT_LT(correctedSpread(100), 0.03f);
+	EXPECT_TRUE(_estimator.isConverged(0.9f, 0.01f, 100));
+
+	// AND: the soft iron matrix inverts the distortion up to its scale
+	const Matrix3f product = _estimator.getSoftIron() * _distortion;
+	const float scale = product(0, 0);
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			EXPECT_NEAR(product(i, j) / scale, (i == j) ? 1.f : 0.f, 0.02f);
+		}
+	}
+
+	// AND: the soft iron matrix is symmetric
+	EXPECT_FLOAT_EQ(_estimator.getOffDiagonal()(0), _estimator.getSoftIron()(1, 0));
+	EXPECT_FLOAT_EQ(_estimator.getOffDiagonal()(2), _estimator.getSoftIron()(2, 1));
+}
+
+TEST_F(MagCalibrationEstimatorTest, improvesWithEverySample)
+{
+	float previous_spread = INFINITY;
+
+	// WHEN: samples are added progressively
+	for (int i = 1; i <= 200; i++) {
+		_estimator.update(measure(randomDirection()));
+
+		// THEN: the calibration is available at any time and gets better
+		if (i % 50 == 0) {
+			ASSERT_TRUE(_estimator.isValid());
+			const float spread = correctedSpread(50);
+			EXPECT_LT(spread, previous_spread + 0.005f);
+			previous_spread = spread;
+		}
+	}
+
+	EXPECT_LT(previous_spread, 0.03f);
+}
+
+TEST_F(MagCalibrationEstimatorTest, partialCoverage)
+{
+	// WHEN: only a part of the orientations is covered
+	for (int i = 0; i < 200; i++) {
+		Vector3f direction = randomDirection();
+		direction(0) = fabsf(direction(0)) + 0.5f;
+		_estimator.update(measure(direction));
+	}
+
+	// THEN: only the sphere is fitted since the ellipsoid is not observable
+	EXPECT_LE(_estimator.getCoverage(), 0.5f);
+	EXPECT_TRUE(_estimator.isValid());
+	EXPECT_FALSE(_estimator.isEllipsoidFit());
+	EXPECT_FALSE(_estimator.isConverged(0.75f, 0.05f, 50));
+}
+
+TEST_F(MagCalibrationEstimatorTest, calibrationDance)
+{
+	// GIVEN: an earth field with 60 degrees inclination in earth frame
+	const Vector3f field_earth(cosf(math::radians(60.f)), 0.f, sinf(math::radians(60.f)));
+
+	// AND: the vehicle is rotated around the vertical with different sides down
+	// (rightside up, upside down, nose down, tail down, left, right)
+	const Vector3f down_axis[6] = {
+		Vector3f(0.f, 0.f, 1.f), Vector3f(0.f, 0.f, -1.f), Vector3f(1.f, 0.f, 0.f),
+		Vector3f(-1.f, 0.f, 0.f), Vector3f(0.f, -1.f, 0.f), Vector3f(0.f, 1.f, 0.f)
+	};
+
+	int sides_needed = 0;
+
+	for (int side = 0; side < 6 && sides_needed == 0; side++) {
+		// body frame basis where the down axis points down
+		const Vector3f down = down_axis[side];
+		const Vector3f forward = (fabsf(down(0)) < 0.5f) ? Vector3f(1.f, 0.f, 0.f) : Vector3f(0.f, 0.f, 1.f);
+		const Vector3f right = down.cross(forward);
+
+		for (int i = 0; i < 72; i++) {
+			// rotate around the vertical
+			const float heading = math::radians(5.f * i);
+			const float north = cosf(heading) * field_earth(0);
+			const float east = -sinf(heading) * field_earth(0);
+			const Vector3f field_body = forward * north + right * east + down * field_earth(2);
+			_estimator.update(measure(field_body));
+		}
+
+		if (_estimator.isConverged()) {
+			sides_needed = side + 1;
+		}
+	}
+
+	// THEN: the calibration converges before all the sides are done
+	EXPECT_GT(sides_needed, 0);
+	EXPECT_LT(sides_needed, 6);
+	EXPECT_LT((_estimator.getOffset() - _offset).norm(), 0.01f);
+}
+
+TEST_F(MagCalibrationEstimatorTest, forgettingTracksChanges)
+{
+	// GIVEN: a calibration tracking slow changes
+	_estimator.setForgettingFactor(0.98f);
+
+	for (int i = 0; i < 500; i++) {
+		_estimator.update(measure(randomDirection()));
+	}
+
+	EXPECT_LT((_estimator.getOffset() - _offset).norm(), 0.005f);
+
+	// WHEN: the magnetic environment changes (e.g. payload swap)
+	_offset = Vector3f(-0.1f, 0.15f, 0.25f);
+
+	for (int i = 0; i < 500; i++) {
+		_estimator.update(measure(randomDirection()));
+	}
+
+	// THEN: the new offsets are found
+	EXPECT_LT((_estimator.getOffset() - _offset).norm(), 0.01f);
+	EXPECT_LT(_estimator.getFitRms(), 0.02f);
+}
+
+TEST_F(MagCalibrationEstimatorTest, rejectCloseSamples)
+{
+	// WHEN: the vehicle is not moving
+	const Vector3f direction(1.f, 0.f, 0.f);
+	_noise = 0.f;
+
+	EXPECT_TRUE(_estimator.update(measure(direction)));
+
+	for (int i = 0; i < 10; i++) {
+		EXPECT_FALSE(_estimator.update(measure(direction)));
+	}
+
+	// THEN: the samples are not used
+	EXPECT_EQ(_estimator.getSampleCount(), 1);
+	EXPECT_FALSE(_estimator.isValid());
+
+	_estimator.reset();
+	EXPECT_EQ(_estimator.getSampleCount(), 0);
+}
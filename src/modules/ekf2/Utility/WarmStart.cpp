@@ -0,0 +1,138 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file WarmStart.cpp
+ */
+
+#include "WarmStart.hpp"
+
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+WarmStart::Result WarmStart::check(const Snapshot &saved, const uint32_t device_id, const float temperature,
+				   const float max_temp_diff, const float bias_limit)
+{
+	if (saved.device_id == 0) {
+		return Result::NoSnapshot;
+	}
+
+	if (saved.device_id != device_id) {
+		return Result::SensorChanged;
+	}
+
+	if (max_temp_diff > 0.f) {
+		if (!PX4_ISFINITE(saved.temperature) || !PX4_ISFINITE(temperature)) {
+			return Result::TemperatureUnknown;
+		}
+
+		if (fabsf(temperature - saved.temperature) > max_temp_diff) {
+			return Result::TemperatureChanged;
+		}
+	}
+
+	if (!PX4_ISFINITE(saved.bias_std) || (saved.bias_std <= 0.f)) {
+		return Result::Implausible;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		if (!PX4_ISFINITE(saved.bias(i)) || (fabsf(saved.bias(i)) > bias_limit)) {
+			return Result::Implausible;
+		}
+	}
+
+	return Result::Accepted;
+}
+
+const char *WarmStart::resultString(const Result result)
+{
+	switch (result) {
+	case Result::Accepted: return "accepted";
+
+	case Result::NoSnapshot: return "no snapshot";
+
+	case Result::SensorChanged: return "sensor changed";
+
+	case Result::TemperatureUnknown: return "temperature unknown";
+
+	case Result::TemperatureChanged: return "temperature changed";
+
+	case Result::Implausible: return "implausible";
+	}
+
+	return "unknown";
+}
+
+float WarmStart::restoredStd(const Snapshot &saved, const float temperature, const float max_temp_diff,
+			     const float switch_on_std)
+{
+	float bias_std = saved.bias_std;
+
+	if ((max_temp_diff > 0.f) && PX4_ISFINITE(temperature) && PX4_ISFINITE(saved.temperature)) {
+		const float ratio = math::constrain(fabsf(temperature - saved.temperature) / max_temp_diff, 0.f, 1.f);
+		bias_std += ratio * (switch_on_std - bias_std);
+	}
+
+	// never more confident than when the snapshot was saved, never less than without it
+	return math::constrain(bias_std, saved.bias_std, math::max(switch_on_std, saved.bias_std));
+}
+
+float WarmStart::biasStd(const Vector3f &variance, const Vector3f &initial_variance, const float initial_std)
+{
+	float max_ratio = 0.f;
+
+	for (int i = 0; i < 3; i++) {
+		if (initial_variance(i) <= 0.f) {
+			return NAN;
+		}
+
+		max_ratio = math::max(max_ratio, variance(i) / initial_variance(i));
+	}
+
+	return initial_std * sqrtf(max_ratio);
+}
+
+void WarmStart::apply(const Snapshot *snapshot, const float init_std)
+{
+	if (snapshot != nullptr) {
+		_bias = snapshot->bias;
+		_init_std = init_std;
+		_active = true;
+
+	} else {
+		_bias.zero();
+		_init_std = 0.f;
+		_active = false;
+	}
+}
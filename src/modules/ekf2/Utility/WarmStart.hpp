@@ -0,0 +1,126 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file WarmStart.hpp
+ * Checks and bookkeeping for the EKF2 warm start, the persisted IMU bias
+ * estimates of the previous power cycle
+ *
+ * A snapshot is kept per sensor (gyro or accelerometer) and is only used
+ * if it was learned by the same sensor at a similar temperature.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <matrix/matrix/math.hpp>
+
+using matrix::Vector3f;
+
+class WarmStart
+{
+public:
+	/*
+	 * Persisted bias estimate of one sensor
+	 */
+	struct Snapshot {
+		Vector3f bias{};		///< total bias (rad/s or m/s**2)
+		float bias_std{0.f};		///< 1-sigma uncertainty of the bias (rad/s or m/s**2)
+		uint32_t device_id{0};		///< sensor the bias was learned for
+		float temperature{NAN};		///< sensor temperature when the bias was saved (degC)
+	};
+
+	enum class Result : uint8_t {
+		Accepted = 0,
+		NoSnapshot,			///< nothing saved yet
+		SensorChanged,			///< saved for a different sensor
+		TemperatureUnknown,		///< the saved or current temperature is not available
+		TemperatureChanged,		///< temperature difference exceeds the limit
+		Implausible			///< saved bias or uncertainty out of range
+	};
+
+	/*
+	 * Check if a snapshot can be used for the current sensor
+	 * @param saved the persisted snapshot
+	 * @param device_id the ID of the currently selected sensor
+	 * @param temperature the current sensor temperature (degC), NAN if unknown
+	 * @param max_temp_diff maximum temperature difference (degC), <= 0 disables the temperature check
+	 * @param bias_limit maximum accepted absolute bias per axis
+	 */
+	static Result check(const Snapshot &saved, uint32_t device_id, float temperature, float max_temp_diff,
+			    float bias_limit);
+
+	static const char *resultString(Result result);
+
+	/*
+	 * Bias uncertainty to initialise the filter with. It grows linearly from the saved
+	 * uncertainty to the switch-on uncertainty with the temperature difference.
+	 * @param switch_on_std the uncertainty used without warm start
+	 */
+	static float restoredStd(const Snapshot &saved, float temperature, float max_temp_diff, float switch_on_std);
+
+	/*
+	 * Current bias uncertainty from the filter covariance. Uses the ratio to the covariance at filter
+	 * initialisation so that it does not depend on the filter update period.
+	 * @param variance the bias state variances
+	 * @param initial_variance the bias state variances at initialisation
+	 * @param initial_std the bias uncertainty the filter was initialised with
+	 * @return the largest uncertainty of the 3 axes
+	 */
+	static float biasStd(const Vector3f &variance, const Vector3f &initial_variance, float initial_std);
+
+	/*
+	 * A bias estimate is worth saving once its uncertainty is well below the switch-on uncertainty
+	 */
+	static bool isConverged(float bias_std, float switch_on_std) { return bias_std <= _converged_ratio * switch_on_std; }
+
+	/*
+	 * Apply a snapshot (or clear it with nullptr). The applied bias is removed from the IMU data
+	 * before it is passed to the filter and added back to the published bias estimates.
+	 * @param init_std the bias uncertainty to initialise the filter with, see restoredStd()
+	 */
+	void apply(const Snapshot *snapshot, float init_std = 0.f);
+
+	bool isActive() const { return _active; }
+	const Vector3f &bias() const { return _bias; }
+	float initStd() const { return _init_std; }
+
+private:
+	static constexpr float _converged_ratio = 0.5f;
+
+	Vector3f _bias{};
+	float _init_std{0.f};
+	bool _active{false};
+};
@@ -0,0 +1,186 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Replays an IMU sequence through the EKF with and without warm start
+ * and compares how fast the IMU bias estimates converge.
+ * Run this test only using make tests TESTFILTER=WarmStartReplay
+ *
+ * Disabled until it has been run against the ecl EKF, the tolerances are
+ * not validated yet. Run it with --gtest_also_run_disabled_tests.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+
+#include <lib/ecl/EKF/ekf.h>
+
+#include "WarmStart.hpp"
+
+class WarmStartReplayTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		// snapshot of the previous power cycle, learned by the same sensor at a similar temperature
+		_saved_gyro.bias = _gyro_bias + Vector3f(0.0005f, -0.0005f, 0.0003f);
+		_saved_gyro.bias_std = 0.001f;
+		_saved_gyro.device_id = _device_id;
+		_saved_gyro.temperature = 40.f;
+
+		_saved_accel.bias = _accel_bias + Vector3f(0.f, 0.f, 0.01f);
+		_saved_accel.bias_std = 0.01f;
+		_saved_accel.device_id = _device_id;
+		_saved_accel.temperature = 40.f;
+	}
+
+	/** Deterministic pseudo random number with zero mean in [-1, 1) */
+	float noise()
+	{
+		_seed = 1103515245u * _seed + 12345u;
+		return (float)((_seed >> 8) & 0xFFFF) / 32768.f - 1.f;
+	}
+
+	Vector3f noise3(float amplitude) { return Vector3f(noise(), noise(), noise()) * amplitude; }
+
+	/**
+	 * Replay a vehicle resting level on the ground: IMU at 250Hz, mag and baro at 50Hz.
+	 * The warm start biases are removed from the IMU data before the filter as done by ekf2.
+	 * @return time after which the gyro and vertical accel bias estimates stay within the tolerance [s],
+	 *         INFINITY if they did not converge
+	 */
+	float replay(const WarmStart &warm_gyro, const WarmStart &warm_accel)
+	{
+		Ekf ekf;
+		parameters *params = ekf.getParamHandle();
+		params->switch_on_gyro_bias = warm_gyro.isActive() ? warm_gyro.initStd() : _switch_on_gyro_bias;
+		params->switch_on_accel_bias = warm_accel.isActive() ? warm_accel.initStd() : _switch_on_accel_bias;
+
+		const uint64_t start_us = 1000000;
+		ekf.init(start_us);
+
+		const float dt = 0.004f;
+		float converged_time = 0.f;
+		bool converged = false;
+
+		for (uint64_t time_us = start_us; time_us < start_us + DURATION_US; time_us += 4000) {
+			const Vector3f gyro = _gyro_bias + noise3(0.002f);
+			const Vector3f accel = Vector3f(0.f, 0.f, -CONSTANTS_ONE_G) + _accel_bias + noise3(0.05f);
+
+			imuSample imu_sample{};
+			imu_sample.time_us = time_us;
+			imu_sample.delta_ang_dt = dt;
+			imu_sample.delta_ang = (gyro - warm_gyro.bias()) * dt;
+			imu_sample.delta_vel_dt = dt;
+			imu_sample.delta_vel = (accel - warm_accel.bias()) * dt;
+			ekf.setIMUData(imu_sample);
+
+			if ((time_us - start_us) % 20000 == 0) {
+				const Vector3f mag_field = _mag_field + noise3(0.005f);
+				float mag[3] = {mag_field(0), mag_field(1), mag_field(2)};
+				ekf.setMagData(time_us, mag);
+				ekf.setBaroData(time_us, 0.05f * noise());
+			}
+
+			if (!ekf.update()) {
+				continue;
+			}
+
+			float gyro_bias[3];
+			float accel_bias[3];
+			ekf.get_gyro_bias(gyro_bias);
+			ekf.get_accel_bias(accel_bias);
+
+			// total bias estimate, including the one removed before the filter
+			const Vector3f gyro_error = Vector3f(gyro_bias) + warm_gyro.bias() - _gyro_bias;
+			const float accel_error = accel_bias[2] + warm_accel.bias()(2) - _accel_bias(2);
+
+			const bool within_tolerance = ekf.attitude_valid()
+						      && fabsf(gyro_error(0)) < _gyro_tolerance
+						      && fabsf(gyro_error(1)) < _gyro_tolerance
+						      && fabsf(gyro_error(2)) < _gyro_tolerance
+						      && fabsf(accel_error) < _accel_tolerance;
+
+			if (within_tolerance && !converged) {
+				converged_time = (time_us - start_us) * 1e-6f;
+			}
+
+			converged = within_tolerance;
+		}
+
+		return converged ? converged_time : INFINITY;
+	}
+
+	static constexpr uint64_t DURATION_US = 60000000;
+
+	const uint32_t _device_id{0x120042};
+	const Vector3f _gyro_bias{0.01f, -0.015f, 0.008f};	///< [rad/s]
+	const Vector3f _accel_bias{0.f, 0.f, 0.15f};		///< [m/s^2]
+	const Vector3f _mag_field{0.2f, 0.f, 0.4f};		///< [Gauss] NED, no declination
+
+	const float _switch_on_gyro_bias{0.1f};			///< EKF2_GBIAS_INIT default
+	const float _switch_on_accel_bias{0.2f};		///< EKF2_ABIAS_INIT default
+	const float _gyro_tolerance{0.002f};			///< same as Tools/ecl_ekf/compare_warm_start.py
+	const float _accel_tolerance{0.05f};
+
+	WarmStart::Snapshot _saved_gyro{};
+	WarmStart::Snapshot _saved_accel{};
+	uint32_t _seed{12345};
+};
+
+TEST_F(WarmStartReplayTest, DISABLED_warmStartConvergesFaster)
+{
+	// GIVEN: the snapshot is accepted for the current sensor and temperature
+	const float temperature = 42.f;
+	const float max_temp_diff = 10.f;
+	ASSERT_EQ(WarmStart::check(_saved_gyro, _device_id, temperature, max_temp_diff, 0.2f), WarmStart::Result::Accepted);
+	ASSERT_EQ(WarmStart::check(_saved_accel, _device_id, temperature, max_temp_diff, 1.f), WarmStart::Result::Accepted);
+
+	WarmStart warm_gyro;
+	WarmStart warm_accel;
+	warm_gyro.apply(&_saved_gyro, WarmStart::restoredStd(_saved_gyro, temperature, max_temp_diff, _switch_on_gyro_bias));
+	warm_accel.apply(&_saved_accel, WarmStart::restoredStd(_saved_accel, temperature, max_temp_diff,
+			 _switch_on_accel_bias));
+
+	// WHEN: the same IMU sequence is replayed with a cold and a warm start
+	const float cold_time = replay(WarmStart(), WarmStart());
+	_seed = 12345;
+	const float warm_time = replay(warm_gyro, warm_accel);
+
+	// THEN: the warm start converges within a few seconds, as soon as the attitude is aligned
+	EXPECT_LT(warm_time, 5.f);
+
+	// AND: faster than the cold start
+	EXPECT_LT(warm_time, cold_time);
+}
@@ -0,0 +1,155 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for WarmStart class
+ * Run this test only using make tests TESTFILTER=WarmStart
+ */
+
+#include <gtest/gtest.h>
+
+#include "WarmStart.hpp"
+
+class WarmStartTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		_saved.bias = Vector3f(0.01f, -0.02f, 0.005f);
+		_saved.bias_std = 0.005f;
+		_saved.device_id = 0x120042;
+		_saved.temperature = 40.f;
+	}
+
+	WarmStart::Snapshot _saved{};
+
+	static constexpr float _max_temp_diff = 10.f;
+	static constexpr float _bias_limit = 0.2f;
+	static constexpr float _switch_on_std = 0.1f;
+};
+
+TEST_F(WarmStartTest, acceptsMatchingSnapshot)
+{
+	EXPECT_EQ(WarmStart::check(_saved, 0x120042, 43.f, _max_temp_diff, _bias_limit), WarmStart::Result::Accepted);
+}
+
+TEST_F(WarmStartTest, rejectsSensorChange)
+{
+	EXPECT_EQ(WarmStart::check(WarmStart::Snapshot{}, 0x120042, 40.f, _max_temp_diff, _bias_limit),
+		  WarmStart::Result::NoSnapshot);
+	EXPECT_EQ(WarmStart::check(_saved, 0x120043, 40.f, _max_temp_diff, _bias_limit), WarmStart::Result::SensorChanged);
+	EXPECT_EQ(WarmStart::check(_saved, 0, 40.f, _max_temp_diff, _bias_limit), WarmStart::Result::SensorChanged);
+}
+
+TEST_F(WarmStartTest, rejectsTemperatureChange)
+{
+	EXPECT_EQ(WarmStart::check(_saved, 0x120042, 51.f, _max_temp_diff, _bias_limit),
+		  WarmStart::Result::TemperatureChanged);
+	EXPECT_EQ(WarmStart::check(_saved, 0x120042, 29.f, _max_temp_diff, _bias_limit),
+		  WarmStart::Result::TemperatureChanged);
+	EXPECT_EQ(WarmStart::check(_saved, 0x120042, NAN, _max_temp_diff, _bias_limit),
+		  WarmStart::Result::TemperatureUnknown);
+
+	// temperature check disabled
+	EXPECT_EQ(WarmStart::check(_saved, 0x120042, NAN, 0.f, _bias_limit), WarmStart::Result::Accepted);
+	EXPECT_EQ(WarmStart::check(_saved, 0x120042, 80.f, 0.f, _bias_limit), WarmStart::Result::Accepted);
+}
+
+TEST_F(WarmStartTest, rejectsImplausibleSnapshot)
+{
+	WarmStart::Snapshot saved = _saved;
+	saved.bias(1) = 0.3f;
+	EXPECT_EQ(WarmStart::check(saved, 0x120042, 40.f, _max_temp_diff, _bias_limit), WarmStart::Result::Implausible);
+
+	saved = _saved;
+	saved.bias(2) = NAN;
+	EXPECT_EQ(WarmStart::check(saved, 0x120042, 40.f, _max_temp_diff, _bias_limit), WarmStart::Result::Implausible);
+
+	saved = _saved;
+	saved.bias_std = 0.f;
+	EXPECT_EQ(WarmStart::check(saved, 0x120042, 40.f, _max_temp_diff, _bias_limit), WarmStart::Result::Implausible);
+}
+
+TEST_F(WarmStartTest, restoredStdGrowsWithTemperatureDifference)
+{
+	// same temperature: saved uncertainty
+	EXPECT_FLOAT_EQ(WarmStart::restoredStd(_saved, 40.f, _max_temp_diff, _switch_on_std), 0.005f);
+
+	// half the allowed difference: half way to the switch-on uncertainty
+	EXPECT_FLOAT_EQ(WarmStart::restoredStd(_saved, 35.f, _max_temp_diff, _switch_on_std), 0.0525f);
+
+	// at or beyond the limit: switch-on uncertainty
+	EXPECT_FLOAT_EQ(WarmStart::restoredStd(_saved, 50.f, _max_temp_diff, _switch_on_std), _switch_on_std);
+	EXPECT_FLOAT_EQ(WarmStart::restoredStd(_saved, 60.f, _max_temp_diff, _switch_on_std), _switch_on_std);
+
+	// temperature check disabled or unknown
+	EXPECT_FLOAT_EQ(WarmStart::restoredStd(_saved, 60.f, 0.f, _switch_on_std), 0.005f);
+	EXPECT_FLOAT_EQ(WarmStart::restoredStd(_saved, NAN, _max_temp_diff, _switch_on_std), 0.005f);
+}
+
+TEST_F(WarmStartTest, biasStdFromCovariance)
+{
+	// covariance in delta angle units, independent of the filter update period
+	const float dt = 0.008f;
+	const Vector3f initial_variance = Vector3f(1.f, 1.f, 1.f) * (_switch_on_std * dt) * (_switch_on_std * dt);
+
+	EXPECT_FLOAT_EQ(WarmStart::biasStd(initial_variance, initial_variance, _switch_on_std), _switch_on_std);
+
+	// worst axis is reported
+	const Vector3f variance(initial_variance(0) / 100.f, initial_variance(1) / 4.f, initial_variance(2) / 400.f);
+	const float bias_std = WarmStart::biasStd(variance, initial_variance, _switch_on_std);
+	EXPECT_FLOAT_EQ(bias_std, _switch_on_std / 2.f);
+	EXPECT_TRUE(WarmStart::isConverged(bias_std, _switch_on_std));
+	EXPECT_FALSE(WarmStart::isConverged(bias_std * 1.1f, _switch_on_std));
+
+	// no initial covariance captured yet
+	EXPECT_FALSE(std::isfinite(WarmStart::biasStd(variance, Vector3f(), _switch_on_std)));
+}
+
+TEST_F(WarmStartTest, applyAndClear)
+{
+	WarmStart warm_start;
+	EXPECT_FALSE(warm_start.isActive());
+	EXPECT_EQ(warm_start.bias(), Vector3f());
+
+	warm_start.apply(&_saved, 0.01f);
+	EXPECT_TRUE(warm_start.isActive());
+	EXPECT_EQ(warm_start.bias(), _saved.bias);
+	EXPECT_FLOAT_EQ(warm_start.initStd(), 0.01f);
+
+	warm_start.apply(nullptr);
+	EXPECT_FALSE(warm_start.isActive());
+	EXPECT_EQ(warm_start.bias(), Vector3f());
+	EXPECT_FLOAT_EQ(warm_start.initStd(), 0.f);
+}
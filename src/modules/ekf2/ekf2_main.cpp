@@ -64,8 +64,10 @@
 #include <uORB/topics/landing_target_pose.h>
 #include <uORB/topics/optical_flow.h>
 #include <uORB/topics/parameter_update.h>
+#include <uORB/topics/sensor_accel.h>
 #include <uORB/topics/sensor_bias.h>
 #include <uORB/topics/sensor_combined.h>
+#include <uORB/topics/sensor_gyro.h>
 #include <uORB/topics/sensor_selection.h>
 #include <uORB/topics/vehicle_air_data.h>
 #include <uORB/topics/vehicle_attitude.h>
@@ -79,6 +81,7 @@
 #include <uORB/topics/wind_estimate.h>
 
 #include "Utility/PreFlightChecker.hpp"
+#include "Utility/WarmStart.hpp"
 
 // defines used to specify the mask position for use of different accuracy metrics in the GPS blending algorithm
 #define BLEND_MASK_USE_SPD_ACC      1
@@ -115,6 +118,9 @@ public:
 
 	int print_status() override;
 
+	/** @see ModuleParams */
+	void updateParams() override;
+
 private:
 	int getRangeSubIndex(); ///< get subscription index of first downward-facing range sensor
 
@@ -130,6 +136,25 @@ private:
 	template<typename Param>
 	bool update_mag_decl(Param &mag_decl_param);
 
+	/*
+	 * Restore the IMU bias estimates of the previous power cycle if they were learned
+	 * by the currently selected sensors at a similar temperature
+	 */
+	void warm_start_restore();
+
+	/*
+	 * Save the converged IMU bias estimates for the next power cycle
+	 */
+	void warm_start_save();
+
+	/*
+	 * Drop the warm start of a sensor, e.g. after the sensor selection changed
+	 */
+	void warm_start_reset(WarmStart &warm_start);
+
+	template<typename T>
+	float sensor_temperature(uORB::Subscription(&subs)[ORB_MULTI_MAX_INSTANCES], uint32_t device_id);
+
 	bool publish_attitude(const sensor_combined_s &sensors, const hrt_abstime &now);
 	bool publish_wind_estimate(const hrt_abstime &timestamp);
 
@@ -208,6 +233,18 @@ private:
 	// Used to control saving of mag declination to be used on next startup
 	bool _mag_decl_saved = false;	///< true when the magnetic declination has been saved
 
+	// Used to restore and save the IMU bias estimates across power cycles
+	WarmStart _warm_start_gyro;		///< gyro bias removed from the IMU data before the EKF (rad/sec)
+	WarmStart _warm_start_accel;		///< accelerometer bias removed from the IMU data before the EKF (m/sec**2)
+	bool _warm_start_checked{false};	///< true once the saved biases have been checked at startup
+	bool _warm_start_save_request{false};	///< true to save the bias estimates at the next EKF update
+	bool _was_armed{false};
+	hrt_abstime _bias_var_init_time{0};	///< time the initial bias state variances were captured, 0 if not captured (uSec)
+	Vector3f _gyro_bias_var_init{};		///< gyro bias state variances at filter initialisation
+	Vector3f _accel_bias_var_init{};	///< accelerometer bias state variances at filter initialisation
+	float _gyro_bias_init_std{0.f};		///< gyro bias uncertainty the filter was initialised with (rad/sec)
+	float _accel_bias_init_std{0.f};	///< accelerometer bias uncertainty the filter was initialised with (m/sec**2)
+
 	// set pose/velocity as invalid if standard deviation is bigger than max_std_dev
 	// TODO: the user should be allowed to set these values by a parameter
 	static constexpr float ep_max_std_dev = 100.0f;	///< Maximum permissible standard deviation for estimated position
@@ -261,6 +298,10 @@ private:
 	uORB::Subscription _range_finder_subs[ORB_MULTI_MAX_INSTANCES] {{ORB_ID(distance_sensor), 0}, {ORB_ID(distance_sensor), 1}, {ORB_ID(distance_sensor), 2}, {ORB_ID(distance_sensor), 3}};
 	int _range_finder_sub_index = -1; // index for downward-facing range finder subscription
 
+	// sensor temperatures for the warm start
+	uORB::Subscription _sensor_accel_subs[ORB_MULTI_MAX_INSTANCES] {{ORB_ID(sensor_accel), 0}, {ORB_ID(sensor_accel), 1}, {ORB_ID(sensor_accel), 2}, {ORB_ID(sensor_accel), 3}};
+	uORB::Subscription _sensor_gyro_subs[ORB_MULTI_MAX_INSTANCES] {{ORB_ID(sensor_gyro), 0}, {ORB_ID(sensor_gyro), 1}, {ORB_ID(sensor_gyro), 2}, {ORB_ID(sensor_gyro), 3}};
+
 	// because we can have multiple GPS instances
 	uORB::Subscription _gps_subs[GPS_MAX_RECEIVERS] {{ORB_ID(vehicle_gps_position), 0}, {ORB_ID(vehicle_gps_position), 1}};
 
@@ -465,10 +506,10 @@ private:
 		(ParamExtFloat<px4::params::EKF2_TAU_POS>)
 		_param_ekf2_tau_pos,		///< time constant used by the output position complementary filter (sec)
 
-		// IMU switch on bias parameters
-		(ParamExtFloat<px4::params::EKF2_GBIAS_INIT>)
+		// IMU switch on bias parameters (applied in updateParams(), a warm start reduces them)
+		(ParamFloat<px4::params::EKF2_GBIAS_INIT>)
 		_param_ekf2_gbias_init,	///< 1-sigma gyro bias uncertainty at switch on (rad/sec)
-		(ParamExtFloat<px4::params::EKF2_ABIAS_INIT>)
+		(ParamFloat<px4::params::EKF2_ABIAS_INIT>)
 		_param_ekf2_abias_init,	///< 1-sigma accelerometer bias uncertainty at switch on (m/sec**2)
 		(ParamExtFloat<px4::params::EKF2_ANGERR_INIT>)
 		_param_ekf2_angerr_init,	///< 1-sigma tilt error after initial alignment using gravity vector (rad)
@@ -484,6 +525,25 @@ private:
 		(ParamFloat<px4::params::EKF2_MAGB_K>)
 		_param_ekf2_magb_k,	///< maximum fraction of the learned magnetometer bias that is saved at each disarm
 
+		// EKF saved IMU bias values (warm start)
+		(ParamInt<px4::params::EKF2_WS_EN>) _param_ekf2_ws_en,		///< enables the warm start
+		(ParamFloat<px4::params::EKF2_WS_TDIFF>)
+		_param_ekf2_ws_tdiff,	///< maximum sensor temperature difference to the saved biases (degC)
+		(ParamFloat<px4::params::EKF2_WS_GB_X>) _param_ekf2_ws_gb_x,	///< X gyro bias (rad/sec)
+		(ParamFloat<px4::params::EKF2_WS_GB_Y>) _param_ekf2_ws_gb_y,	///< Y gyro bias (rad/sec)
+		(ParamFloat<px4::params::EKF2_WS_GB_Z>) _param_ekf2_ws_gb_z,	///< Z gyro bias (rad/sec)
+		(ParamFloat<px4::params::EKF2_WS_GB_STD>) _param_ekf2_ws_gb_std,	///< 1-sigma uncertainty of the gyro bias (rad/sec)
+		(ParamInt<px4::params::EKF2_WS_GB_ID>) _param_ekf2_ws_gb_id,	///< ID of the gyro the bias was learned for
+		(ParamFloat<px4::params::EKF2_WS_GB_T>) _param_ekf2_ws_gb_t,	///< gyro temperature when the bias was saved (degC)
+		(ParamFloat<px4::params::EKF2_WS_AB_X>) _param_ekf2_ws_ab_x,	///< X accelerometer bias (m/sec**2)
+		(ParamFloat<px4::params::EKF2_WS_AB_Y>) _param_ekf2_ws_ab_y,	///< Y accelerometer bias (m/sec**2)
+		(ParamFloat<px4::params::EKF2_WS_AB_Z>) _param_ekf2_ws_ab_z,	///< Z accelerometer bias (m/sec**2)
+		(ParamFloat<px4::params::EKF2_WS_AB_STD>)
+		_param_ekf2_ws_ab_std,	///< 1-sigma uncertainty of the accelerometer bias (m/sec**2)
+		(ParamInt<px4::params::EKF2_WS_AB_ID>) _param_ekf2_ws_ab_id,	///< ID of the accelerometer the bias was learned for
+		(ParamFloat<px4::params::EKF2_WS_AB_T>)
+		_param_ekf2_ws_ab_t,	///< accelerometer temperature when the bias was saved (degC)
+
 		// EKF accel bias learning control
 		(ParamExtFloat<px4::params::EKF2_ABL_LIM>) _param_ekf2_abl_lim,	///< Accelerometer bias learning limit (m/s**2)
 		(ParamExtFloat<px4::params::EKF2_ABL_ACCLIM>)
@@ -619,8 +679,6 @@ Ekf2::Ekf2(bool replay_mode):
 	_param_ekf2_ev_pos_z(_params->ev_pos_body(2)),
 	_param_ekf2_tau_vel(_params->vel_Tau),
 	_param_ekf2_tau_pos(_params->pos_Tau),
-	_param_ekf2_gbias_init(_params->switch_on_gyro_bias),
-	_param_ekf2_abias_init(_params->switch_on_accel_bias),
 	_param_ekf2_angerr_init(_params->initial_tilt_err),
 	_param_ekf2_abl_lim(_params->acc_bias_lim),
 	_param_ekf2_abl_acclim(_params->acc_bias_learn_acc_lim),
@@ -660,11 +718,179 @@ int Ekf2::print_status()
 
 	PX4_INFO("time slip: %" PRId64 " us", _last_time_slip_us);
 
+	PX4_INFO("warm start gyro: %s, accel: %s", _warm_start_gyro.isActive() ? "yes" : "no",
+		 _warm_start_accel.isActive() ? "yes" : "no");
+
 	perf_print_counter(_ekf_update_perf);
 
 	return 0;
 }
 
+void Ekf2::updateParams()
+{
+	ModuleParams::updateParams();
+
+	// switch-on bias uncertainty, reduced if the bias of the previous power cycle is used
+	_params->switch_on_gyro_bias = _warm_start_gyro.isActive() ? _warm_start_gyro.initStd() : _param_ekf2_gbias_init.get();
+	_params->switch_on_accel_bias = _warm_start_accel.isActive() ? _warm_start_accel.initStd() :
+					_param_ekf2_abias_init.get();
+}
+
+template<typename T>
+float Ekf2::sensor_temperature(uORB::Subscription(&subs)[ORB_MULTI_MAX_INSTANCES], uint32_t device_id)
+{
+	for (uORB::Subscription &sub : subs) {
+		T report;
+
+		if (sub.copy(&report) && (report.device_id == device_id)) {
+			return report.temperature;
+		}
+	}
+
+	return NAN;
+}
+
+void Ekf2::warm_start_restore()
+{
+	if (_param_ekf2_ws_en.get() == 0) {
+		return;
+	}
+
+	if (_ekf.attitude_valid()) {
+		// too late, changing the IMU data now would appear as a bias step to the filter
+		PX4_WARN("warm start: selected sensors unknown at filter initialisation");
+		return;
+	}
+
+	// the sensor temperatures are not replayed
+	const float max_temp_diff = _replay_mode ? 0.f : _param_ekf2_ws_tdiff.get();
+
+	WarmStart::Snapshot gyro;
+	gyro.bias = Vector3f{_param_ekf2_ws_gb_x.get(), _param_ekf2_ws_gb_y.get(), _param_ekf2_ws_gb_z.get()};
+	gyro.bias_std = _param_ekf2_ws_gb_std.get();
+	gyro.device_id = (uint32_t)_param_ekf2_ws_gb_id.get();
+	gyro.temperature = _param_ekf2_ws_gb_t.get();
+
+	const float gyro_temperature = sensor_temperature<sensor_gyro_s>(_sensor_gyro_subs, _sensor_selection.gyro_device_id);
+
+	// a saved bias beyond 3 sigma of the switch-on uncertainty is not trusted
+	const WarmStart::Result gyro_result = WarmStart::check(gyro, _sensor_selection.gyro_device_id, gyro_temperature,
+					      max_temp_diff, 3.f * _param_ekf2_gbias_init.get());
+
+	if (gyro_result == WarmStart::Result::Accepted) {
+		_warm_start_gyro.apply(&gyro, WarmStart::restoredStd(gyro, gyro_temperature, max_temp_diff,
+				       _param_ekf2_gbias_init.get()));
+	}
+
+	WarmStart::Snapshot accel;
+	accel.bias = Vector3f{_param_ekf2_ws_ab_x.get(), _param_ekf2_ws_ab_y.get(), _param_ekf2_ws_ab_z.get()};
+	accel.bias_std = _param_ekf2_ws_ab_std.get();
+	accel.device_id = (uint32_t)_param_ekf2_ws_ab_id.get();
+	accel.temperature = _param_ekf2_ws_ab_t.get();
+
+	const float accel_temperature = sensor_temperature<sensor_accel_s>(_sensor_accel_subs, _sensor_selection.accel_device_id);
+
+	// the EKF does not learn accelerometer biases beyond EKF2_ABL_LIM
+	const WarmStart::Result accel_result = WarmStart::check(accel, _sensor_selection.accel_device_id, accel_temperature,
+					       max_temp_diff, _param_ekf2_abl_lim.get());
+
+	if (accel_result == WarmStart::Result::Accepted) {
+		_warm_start_accel.apply(&accel, WarmStart::restoredStd(accel, accel_temperature, max_temp_diff,
+					_param_ekf2_abias_init.get()));
+	}
+
+	PX4_INFO("warm start gyro bias: %s, accel bias: %s", WarmStart::resultString(gyro_result),
+		 WarmStart::resultString(accel_result));
+
+	updateParams();
+}
+
+void Ekf2::warm_start_reset(WarmStart &warm_start)
+{
+	if (warm_start.isActive()) {
+		warm_start.apply(nullptr);
+		updateParams();
+	}
+}
+
+void Ekf2::warm_start_save()
+{
+	// never save while armed: the parameter storage can cause time slips
+	if ((_param_ekf2_ws_en.get() == 0) || _replay_mode
+	    || (_vehicle_status.arming_state == vehicle_status_s::ARMING_STATE_ARMED)) {
+		return;
+	}
+
+	// give the biases time to converge
+	if ((_bias_var_init_time == 0) || (hrt_elapsed_time(&_bias_var_init_time) < 30_s)) {
+		return;
+	}
+
+	uint16_t filter_fault_flags = 0;
+	_ekf.get_filter_fault_status(&filter_fault_flags);
+
+	if (filter_fault_flags != 0) {
+		return;
+	}
+
+	const matrix::Vector<float, 24> covariances = _ekf.covariances_diagonal();
+	const bool check_temperature = _param_ekf2_ws_tdiff.get() > 0.f;
+
+	float gyro_bias[3];
+	_ekf.get_gyro_bias(gyro_bias);
+
+	const float gyro_bias_std = WarmStart::biasStd(Vector3f{covariances(10), covariances(11), covariances(12)},
+				    _gyro_bias_var_init, _gyro_bias_init_std);
+	const float gyro_temperature = sensor_temperature<sensor_gyro_s>(_sensor_gyro_subs, _sensor_selection.gyro_device_id);
+
+	if (WarmStart::isConverged(gyro_bias_std, _param_ekf2_gbias_init.get())
+	    && (_sensor_selection.gyro_device_id != 0) && (PX4_ISFINITE(gyro_temperature) || !check_temperature)) {
+
+		// total bias, including the part removed before the EKF
+		const Vector3f bias = Vector3f{gyro_bias} + _warm_start_gyro.bias();
+
+		_param_ekf2_ws_gb_x.set(bias(0));
+		_param_ekf2_ws_gb_x.commit_no_notification();
+		_param_ekf2_ws_gb_y.set(bias(1));
+		_param_ekf2_ws_gb_y.commit_no_notification();
+		_param_ekf2_ws_gb_z.set(bias(2));
+		_param_ekf2_ws_gb_z.commit_no_notification();
+		_param_ekf2_ws_gb_std.set(gyro_bias_std);
+		_param_ekf2_ws_gb_std.commit_no_notification();
+		_param_ekf2_ws_gb_t.set(PX4_ISFINITE(gyro_temperature) ? gyro_temperature : 0.f);
+		_param_ekf2_ws_gb_t.commit_no_notification();
+		_param_ekf2_ws_gb_id.set((int32_t)_sensor_selection.gyro_device_id);
+		_param_ekf2_ws_gb_id.commit_no_notification();
+	}
+
+	float accel_bias[3];
+	_ekf.get_accel_bias(accel_bias);
+
+	const float accel_bias_std = WarmStart::biasStd(Vector3f{covariances(13), covariances(14), covariances(15)},
+				     _accel_bias_var_init, _accel_bias_init_std);
+	const float accel_temperature = sensor_temperature<sensor_accel_s>(_sensor_accel_subs, _sensor_selection.accel_device_id);
+
+	// the horizontal accelerometer biases are usually only observable in flight
+	if (WarmStart::isConverged(accel_bias_std, _param_ekf2_abias_init.get())
+	    && (_sensor_selection.accel_device_id != 0) && (PX4_ISFINITE(accel_temperature) || !check_temperature)) {
+
+		const Vector3f bias = Vector3f{accel_bias} + _warm_start_accel.bias();
+
+		_param_ekf2_ws_ab_x.set(bias(0));
+		_param_ekf2_ws_ab_x.commit_no_notification();
+		_param_ekf2_ws_ab_y.set(bias(1));
+		_param_ekf2_ws_ab_y.commit_no_notification();
+		_param_ekf2_ws_ab_z.set(bias(2));
+		_param_ekf2_ws_ab_z.commit_no_notification();
+		_param_ekf2_ws_ab_std.set(accel_bias_std);
+		_param_ekf2_ws_ab_std.commit_no_notification();
+		_param_ekf2_ws_ab_t.set(PX4_ISFINITE(accel_temperature) ? accel_temperature : 0.f);
+		_param_ekf2_ws_ab_t.commit_no_notification();
+		_param_ekf2_ws_ab_id.set((int32_t)_sensor_selection.accel_device_id);
+		_param_ekf2_ws_ab_id.commit_no_notification();
+	}
+}
+
 template<typename Param>
 void Ekf2::update_mag_bias(Param &mag_bias_param, int axis_index)
 {
@@ -703,6 +929,7 @@ void Ekf2::Run()
 {
 	if (should_exit()) {
 		_sensors_sub.unregisterCallback();
+		warm_start_save();
 		exit_and_cleanup();
 		return;
 	}
@@ -743,6 +970,15 @@ void Ekf2::Run()
 
 			// let the EKF know if the vehicle motion is that of a fixed wing (forward flight only relative to wind)
 			_ekf.set_is_fixed_wing(is_fixed_wing);
+
+			// save the IMU bias estimates on disarm
+			const bool armed = (_vehicle_status.arming_state == vehicle_status_s::ARMING_STATE_ARMED);
+
+			if (_was_armed && !armed) {
+				_warm_start_save_request = true;
+			}
+
+			_was_armed = armed;
 		}
 
 		// Always update sensor selction first time through if time stamp is non zero
@@ -753,11 +989,13 @@ void Ekf2::Run()
 				if ((sensor_selection_prev.timestamp > 0) && (_sensor_selection.timestamp > sensor_selection_prev.timestamp)) {
 					if (_sensor_selection.accel_device_id != sensor_selection_prev.accel_device_id) {
 						PX4_WARN("accel id changed, resetting IMU bias");
+						warm_start_reset(_warm_start_accel);
 						_imu_bias_reset_request = true;
 					}
 
 					if (_sensor_selection.gyro_device_id != sensor_selection_prev.gyro_device_id) {
 						PX4_WARN("gyro id changed, resetting IMU bias");
+						warm_start_reset(_warm_start_gyro);
 						_imu_bias_reset_request = true;
 					}
 				}
@@ -767,17 +1005,29 @@ void Ekf2::Run()
 		// attempt reset until successful
 		if (_imu_bias_reset_request) {
 			_imu_bias_reset_request = !_ekf.reset_imu_bias();
+
+			if (!_imu_bias_reset_request) {
+				// capture the re-initialised bias variances again
+				_bias_var_init_time = 0;
+			}
+		}
+
+		// check the saved IMU biases once the selected sensors are known
+		if (!_warm_start_checked && ((_sensor_selection.timestamp != 0) || _ekf.attitude_valid())) {
+			warm_start_restore();
+			_warm_start_checked = true;
 		}
 
 		const hrt_abstime now = sensors.timestamp;
 
-		// push imu data into estimator
+		// push imu data into estimator, corrected for the biases restored by the warm start
 		imuSample imu_sample_new;
 		imu_sample_new.time_us = now;
 		imu_sample_new.delta_ang_dt = sensors.gyro_integral_dt * 1.e-6f;
-		imu_sample_new.delta_ang = Vector3f{sensors.gyro_rad} * imu_sample_new.delta_ang_dt;
+		imu_sample_new.delta_ang = (Vector3f{sensors.gyro_rad} - _warm_start_gyro.bias()) * imu_sample_new.delta_ang_dt;
 		imu_sample_new.delta_vel_dt = sensors.accelerometer_integral_dt * 1.e-6f;
-		imu_sample_new.delta_vel = Vector3f{sensors.accelerometer_m_s2} * imu_sample_new.delta_vel_dt;
+		imu_sample_new.delta_vel = (Vector3f{sensors.accelerometer_m_s2} - _warm_start_accel.bias()) *
+					   imu_sample_new.delta_vel_dt;
 
 		_ekf.setIMUData(imu_sample_new);
 
@@ -1321,9 +1571,9 @@ void Ekf2::Run()
 				// Vehicle odometry angular rates
 				float gyro_bias[3];
 				_ekf.get_gyro_bias(gyro_bias);
-				odom.rollspeed = sensors.gyro_rad[0] - gyro_bias[0];
-				odom.pitchspeed = sensors.gyro_rad[1] - gyro_bias[1];
-				odom.yawspeed = sensors.gyro_rad[2] - gyro_bias[2];
+				odom.rollspeed = sensors.gyro_rad[0] - gyro_bias[0] - _warm_start_gyro.bias()(0);
+				odom.pitchspeed = sensors.gyro_rad[1] - gyro_bias[1] - _warm_start_gyro.bias()(1);
+				odom.yawspeed = sensors.gyro_rad[2] - gyro_bias[2] - _warm_start_gyro.bias()(2);
 
 				lpos.dist_bottom_valid = _ekf.get_terrain_valid();
 
@@ -1504,10 +1754,15 @@ void Ekf2::Run()
 
 				bias.timestamp = now;
 
-				// In-run bias estimates
+				// In-run bias estimates, including the biases restored by the warm start
 				_ekf.get_gyro_bias(bias.gyro_bias);
 				_ekf.get_accel_bias(bias.accel_bias);
 
+				for (int i = 0; i < 3; i++) {
+					bias.gyro_bias[i] += _warm_start_gyro.bias()(i);
+					bias.accel_bias[i] += _warm_start_accel.bias()(i);
+				}
+
 				bias.mag_bias[0] = _last_valid_mag_cal[0];
 				bias.mag_bias[1] = _last_valid_mag_cal[1];
 				bias.mag_bias[2] = _last_valid_mag_cal[2];
@@ -1546,6 +1801,20 @@ void Ekf2::Run()
 
 			_estimator_status_pub.publish(status);
 
+			// capture the bias state variances the filter was (re-)initialised with
+			if (_bias_var_init_time == 0) {
+				_gyro_bias_var_init = Vector3f{status.covariances[10], status.covariances[11], status.covariances[12]};
+				_accel_bias_var_init = Vector3f{status.covariances[13], status.covariances[14], status.covariances[15]};
+				_gyro_bias_init_std = _params->switch_on_gyro_bias;
+				_accel_bias_init_std = _params->switch_on_accel_bias;
+				_bias_var_init_time = hrt_absolute_time();
+			}
+
+			if (_warm_start_save_request) {
+				warm_start_save();
+				_warm_start_save_request = false;
+			}
+
 			// publish GPS drift data only when updated to minimise overhead
 			float gps_drift[3];
 			bool blocked;
@@ -1110,6 +1110,185 @@ PARAM_DEFINE_FLOAT(EKF2_MAGB_VREF, 2.5E-7f);
  */
 PARAM_DEFINE_FLOAT(EKF2_MAGB_K, 0.2f);
 
+/**
+ * Warm start from the saved IMU biases.
+ *
+ * If enabled, the gyro and accelerometer bias estimates are saved on disarm and on shutdown once they have
+ * converged, and used to initialise the EKF at the next startup. This shortens the time until the biases are
+ * learned after a power cycle. The saved biases of a sensor are only used if they were learned by the same
+ * sensor (EKF2_WS_GB_ID, EKF2_WS_AB_ID) at a similar temperature (EKF2_WS_TDIFF).
+ *
+ * @group EKF2
+ * @boolean
+ * @reboot_required true
+ */
+PARAM_DEFINE_INT32(EKF2_WS_EN, 0);
+
+/**
+ * Maximum temperature difference for the warm start.
+ *
+ * The saved IMU biases are rejected if the sensor temperature differs by more than this from the temperature
+ * they were saved at. Their uncertainty is increased towards EKF2_GBIAS_INIT and EKF2_ABIAS_INIT with the
+ * temperature difference. Set to 0 to disable the temperature check.
+ *
+ * @group EKF2
+ * @min 0.0
+ * @max 50.0
+ * @unit deg C
+ * @decimal 1
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_TDIFF, 10.0f);
+
+/**
+ * Saved gyro X axis bias.
+ * Total gyro bias estimated by the EKF and saved on the last disarm or shutdown (see EKF2_WS_EN).
+ *
+ * @group EKF2
+ * @min -0.6
+ * @max 0.6
+ * @unit rad/s
+ * @decimal 4
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_GB_X, 0.0f);
+
+/**
+ * Saved gyro Y axis bias.
+ * Total gyro bias estimated by the EKF and saved on the last disarm or shutdown (see EKF2_WS_EN).
+ *
+ * @group EKF2
+ * @min -0.6
+ * @max 0.6
+ * @unit rad/s
+ * @decimal 4
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_GB_Y, 0.0f);
+
+/**
+ * Saved gyro Z axis bias.
+ * Total gyro bias estimated by the EKF and saved on the last disarm or shutdown (see EKF2_WS_EN).
+ *
+ * @group EKF2
+ * @min -0.6
+ * @max 0.6
+ * @unit rad/s
+ * @decimal 4
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_GB_Z, 0.0f);
+
+/**
+ * 1-sigma uncertainty of the saved gyro bias.
+ *
+ * @group EKF2
+ * @min 0.0
+ * @max 0.2
+ * @unit rad/s
+ * @decimal 4
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_GB_STD, 0.0f);
+
+/**
+ * ID of the gyro the saved bias is for.
+ *
+ * @group EKF2
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_INT32(EKF2_WS_GB_ID, 0);
+
+/**
+ * Gyro temperature when the bias was saved.
+ *
+ * @group EKF2
+ * @unit deg C
+ * @decimal 1
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_GB_T, 0.0f);
+
+/**
+ * Saved accelerometer X axis bias.
+ * Total accelerometer bias estimated by the EKF and saved on the last disarm or shutdown (see EKF2_WS_EN).
+ *
+ * @group EKF2
+ * @min -0.5
+ * @max 0.5
+ * @unit m/s/s
+ * @decimal 4
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_AB_X, 0.0f);
+
+/**
+ * Saved accelerometer Y axis bias.
+ * Total accelerometer bias estimated by the EKF and saved on the last disarm or shutdown (see EKF2_WS_EN).
+ *
+ * @group EKF2
+ * @min -0.5
+ * @max 0.5
+ * @unit m/s/s
+ * @decimal 4
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_AB_Y, 0.0f);
+
+/**
+ * Saved accelerometer Z axis bias.
+ * Total accelerometer bias estimated by the EKF and saved on the last disarm or shutdown (see EKF2_WS_EN).
+ *
+ * @group EKF2
+ * @min -0.5
+ * @max 0.5
+ * @unit m/s/s
+ * @decimal 4
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_AB_Z, 0.0f);
+
+/**
+ * 1-sigma uncertainty of the saved accelerometer bias.
+ *
+ * @group EKF2
+ * @min 0.0
+ * @max 0.5
+ * @unit m/s/s
+ * @decimal 4
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_AB_STD, 0.0f);
+
+/**
+ * ID of the accelerometer the saved bias is for.
+ *
+ * @group EKF2
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_INT32(EKF2_WS_AB_ID, 0);
+
+/**
+ * Accelerometer temperature when the bias was saved.
+ *
+ * @group EKF2
+ * @unit deg C
+ * @decimal 1
+ * @volatile
+ * @category system
+ */
+PARAM_DEFINE_FLOAT(EKF2_WS_AB_T, 0.0f);
+
 /**
  * Range sensor aid.
  *
@@ -79,6 +79,7 @@ void LandDetector::Run()
 	const bool landDetected = _landed_hysteresis.get_state();
 	const float alt_max = _get_max_altitude() > 0.0f ? _get_max_altitude() : INFINITY;
 	const bool in_ground_effect = _ground_effect_hysteresis.get_state();
+	const float touchdown_confidence = _get_touchdown_confidence();
 
 	const hrt_abstime now = hrt_absolute_time();
 
@@ -89,6 +90,7 @@ void LandDetector::Run()
 	    (_land_detected.maybe_landed != maybe_landedDetected) ||
 	    (_land_detected.ground_contact != ground_contactDetected) ||
 	    (_land_detected.in_ground_effect != in_ground_effect) ||
+	    (fabsf(_land_detected.touchdown_confidence - touchdown_confidence) > 0.1f) ||
 	    (fabsf(_land_detected.alt_max - alt_max) > FLT_EPSILON)) {
 
 		if (!landDetected && _land_detected.landed && _takeoff_time == 0) { /* only set take off time once, until disarming */
@@ -103,6 +105,7 @@ void LandDetector::Run()
 		_land_detected.ground_contact = ground_contactDetected;
 		_land_detected.alt_max = alt_max;
 		_land_detected.in_ground_effect = in_ground_effect;
+		_land_detected.touchdown_confidence = touchdown_confidence;
 
 		_vehicle_land_detected_pub.publish(_land_detected);
 	}
@@ -143,6 +146,16 @@ void LandDetector::_update_params()
 	_update_total_flight_time();
 }
 
+void LandDetector::_run_at_estimator_rate(bool enable)
+{
+	if (enable) {
+		_vehicle_local_position_sub.registerCallback();
+
+	} else {
+		_vehicle_local_position_sub.unregisterCallback();
+	}
+}
+
 void LandDetector::_update_state()
 {
 	/* when we are landed we also have ground contact for sure but only one output state can be true at a particular time
@@ -56,6 +56,11 @@
  *If the land-detector does not detect ground_contact, then the vehicle is either flying or falling, where free fall detection heavily relies
  *on the acceleration. TODO: verify that free fall is reliable
  *
+ *Touchdown detection (LNDMC_TD_EN):
+ *The land detector additionally runs on every estimator update and feeds the TouchdownDetector with the accelerometer, the thrust and the
+ *vertical velocity. An impact during the descent gives ground_contact without waiting for low thrust, and once the ground carries the vehicle
+ *the confidence replaces the minimal thrust criterion of maybe_landed. While the confidence holds, all three states use TOUCHDOWN_TRIGGER_TIME_US.
+ *
  * @author Johan Jansen <jnsn.johan@gmail.com>
  * @author Morten Lysgaard <morten@lysgaard.no>
  * @author Julian Oes <julian@oes.ch>
@@ -93,6 +98,10 @@ void MulticopterLandDetector::_update_topics()
 	_vehicle_angular_velocity_sub.update(&_vehicle_angular_velocity);
 	_vehicle_control_mode_sub.update(&_vehicle_control_mode);
 	_vehicle_local_position_setpoint_sub.update(&_vehicle_local_position_setpoint);
+
+	if (_param_lndmc_td_en.get()) {
+		_update_touchdown();
+	}
 }
 
 void MulticopterLandDetector::_update_params()
@@ -105,6 +114,78 @@ void MulticopterLandDetector::_update_params()
 	param_get(_paramHandle.hoverThrottle, &_params.hoverThrottle);
 	param_get(_paramHandle.minManThrottle, &_params.minManThrottle);
 	param_get(_paramHandle.landSpeed, &_params.landSpeed);
+
+	_touchdown_detector.setHoverThrust(_params.hoverThrottle);
+	_touchdown_detector.setImpactThreshold(_param_lndmc_td_acc.get());
+	_touchdown_detector.setSupportThreshold(_param_lndmc_td_sup.get());
+	_touchdown_detector.setMaxVerticalSpeed(_param_lndmc_z_vel_max.get());
+
+	_run_at_estimator_rate(_param_lndmc_td_en.get());
+
+	if (!_param_lndmc_td_en.get()) {
+		_touchdown_detector.reset();
+		_touchdown_sample_last = 0;
+
+		_ground_contact_hysteresis.set_hysteresis_time_from(false, GROUND_CONTACT_TRIGGER_TIME_US);
+		_landed_hysteresis.set_hysteresis_time_from(false, LAND_DETECTOR_TRIGGER_TIME_US);
+		_maybe_landed_hysteresis.set_hysteresis_time_from(false, MAYBE_LAND_DETECTOR_TRIGGER_TIME_US);
+	}
+}
+
+void MulticopterLandDetector::_update_touchdown()
+{
+	hover_thrust_estimate_s hover_thrust_estimate;
+
+	if (_hover_thrust_estimate_sub.update(&hover_thrust_estimate)) {
+		_touchdown_detector.setHoverThrust(hover_thrust_estimate.valid ? hover_thrust_estimate.hover_thrust :
+						   _params.hoverThrottle);
+	}
+
+	if (!_actuator_armed.armed) {
+		_touchdown_detector.reset();
+		_touchdown_sample_last = 0;
+
+	} else if (_vehicle_local_position.timestamp != _touchdown_sample_last) {
+		// one update per estimator sample, the first one only sets the time base
+		const float dt = (_touchdown_sample_last != 0) ? (_vehicle_local_position.timestamp - _touchdown_sample_last) * 1e-6f : 0.f;
+		const float vz = _has_altitude_lock() ? _vehicle_local_position.vz : NAN;
+
+		_touchdown_detector.update(dt, _vehicle_acceleration.xyz[2],
+					   _actuator_controls.control[actuator_controls_s::INDEX_THROTTLE], vz);
+		_touchdown_sample_last = _vehicle_local_position.timestamp;
+	}
+
+	const bool contact = _has_touchdown_contact();
+	const bool landed = _get_touchdown_confidence() >= TOUCHDOWN_LANDED_CONFIDENCE;
+
+	_ground_contact_hysteresis.set_hysteresis_time_from(false, contact ? TOUCHDOWN_TRIGGER_TIME_US :
+			GROUND_CONTACT_TRIGGER_TIME_US);
+	_maybe_landed_hysteresis.set_hysteresis_time_from(false, landed ? TOUCHDOWN_TRIGGER_TIME_US :
+			MAYBE_LAND_DETECTOR_TRIGGER_TIME_US);
+	_landed_hysteresis.set_hysteresis_time_from(false, landed ? TOUCHDOWN_TRIGGER_TIME_US : LAND_DETECTOR_TRIGGER_TIME_US);
+}
+
+float MulticopterLandDetector::_get_touchdown_confidence()
+{
+	return _param_lndmc_td_en.get() ? _touchdown_detector.getConfidence() : NAN;
+}
+
+bool MulticopterLandDetector::_has_touchdown_contact()
+{
+	const float confidence = _get_touchdown_confidence();
+
+	// An impact alone is only trusted while a descent is commanded, a bump in any other
+	// phase of the flight must not cut the thrust. The ground carrying the vehicle always counts.
+	return (confidence >= TOUCHDOWN_LANDED_CONFIDENCE)
+	       || (confidence >= TOUCHDOWN_CONTACT_CONFIDENCE && _is_descent_commanded());
+}
+
+bool MulticopterLandDetector::_is_descent_commanded()
+{
+	// land speed threshold
+	const float land_speed_threshold = 0.9f * math::max(_params.landSpeed, 0.1f);
+
+	return _is_climb_rate_enabled() && (_vehicle_local_position_setpoint.vz >= land_speed_threshold);
 }
 
 bool MulticopterLandDetector::_get_freefall_state()
@@ -160,12 +241,14 @@ bool MulticopterLandDetector::_get_ground_contact_state()
 
 	// if we have a valid velocity setpoint and the vehicle is demanded to go down but no vertical movement present,
 	// we then can assume that the vehicle hit ground
-	_in_descend = _is_climb_rate_enabled()
-		      && (_vehicle_local_position_setpoint.vz >= land_speed_threshold);
+	_in_descend = _is_descent_commanded();
 	bool hit_ground = _in_descend && !vertical_movement;
 
+	// an impact during the descent or the ground carrying the vehicle is seen before the thrust is reduced
+	const bool touchdown = _has_touchdown_contact();
+
 	// TODO: we need an accelerometer based check for vertical movement for flying without GPS
-	if ((_has_low_thrust() || hit_ground) && (!_horizontal_movement || !_has_position_lock())
+	if ((_has_low_thrust() || hit_ground || touchdown) && (!_horizontal_movement || !_has_position_lock())
 	    && (!vertical_movement || !_has_altitude_lock())) {
 		return true;
 	}
@@ -220,6 +303,11 @@ bool MulticopterLandDetector::_get_maybe_landed_state()
 		return true;
 	}
 
+	if (_ground_contact_hysteresis.get_state() && (_get_touchdown_confidence() >= TOUCHDOWN_LANDED_CONFIDENCE) && !rotating) {
+		// Ground contact, the ground carries the vehicle and no movement -> landed
+		return true;
+	}
+
 	return false;
 }
 
@@ -44,12 +44,14 @@
 
 #include <uORB/topics/actuator_controls.h>
 #include <uORB/topics/battery_status.h>
+#include <uORB/topics/hover_thrust_estimate.h>
 #include <uORB/topics/vehicle_angular_velocity.h>
 #include <uORB/topics/vehicle_attitude.h>
 #include <uORB/topics/vehicle_control_mode.h>
 #include <uORB/topics/vehicle_local_position_setpoint.h>
 
 #include "LandDetector.h"
+#include "TouchdownDetector/TouchdownDetector.hpp"
 
 using namespace time_literals;
 
@@ -72,6 +74,7 @@ protected:
 	bool _get_ground_effect_state() override;
 
 	float _get_max_altitude() override;
+	float _get_touchdown_confidence() override;
 private:
 
 	/** Get control mode dependent pilot throttle threshold with which we should quit landed state and take off. */
@@ -83,6 +86,15 @@ private:
 	bool _has_position_lock();
 	bool _is_climb_rate_enabled();
 
+	/** Feed the touchdown detector with new estimator samples and shorten the trigger times on touchdown. */
+	void _update_touchdown();
+
+	/** @return true if the touchdown detector sees an impact during a commanded descent or the ground carrying the vehicle */
+	bool _has_touchdown_contact();
+
+	/** @return true if the velocity setpoint demands a descent at landing speed */
+	bool _is_descent_commanded();
+
 	/** Time in us that landing conditions have to hold before triggering a land. */
 	static constexpr hrt_abstime LAND_DETECTOR_TRIGGER_TIME_US = 300_ms;
 
@@ -92,6 +104,15 @@ private:
 	/** Time in us that ground contact condition have to hold before triggering contact ground */
 	static constexpr hrt_abstime GROUND_CONTACT_TRIGGER_TIME_US = 350_ms;
 
+	/** Time in us that each of the conditions has to hold on a detected touchdown. */
+	static constexpr hrt_abstime TOUCHDOWN_TRIGGER_TIME_US = 100_ms;
+
+	/** Touchdown confidence for ground contact, reached by an impact alone. */
+	static constexpr float TOUCHDOWN_CONTACT_CONFIDENCE = 0.5f;
+
+	/** Touchdown confidence for maybe landed and landed, requires the ground to carry the vehicle. */
+	static constexpr float TOUCHDOWN_LANDED_CONFIDENCE = 0.9f;
+
 	/** Time interval in us in which wider acceptance thresholds are used after landed. */
 	static constexpr hrt_abstime LAND_DETECTOR_LAND_PHASE_TIME_US = 2_s;
 
@@ -112,6 +133,7 @@ private:
 
 	uORB::Subscription _actuator_controls_sub{ORB_ID(actuator_controls_0)};
 	uORB::Subscription _battery_sub{ORB_ID(battery_status)};
+	uORB::Subscription _hover_thrust_estimate_sub{ORB_ID(hover_thrust_estimate)};
 	uORB::Subscription _vehicle_acceleration_sub{ORB_ID(vehicle_acceleration)};
 	uORB::Subscription _vehicle_angular_velocity_sub{ORB_ID(vehicle_angular_velocity)};
 	uORB::Subscription _vehicle_control_mode_sub{ORB_ID(vehicle_control_mode)};
@@ -127,6 +149,9 @@ private:
 	hrt_abstime _min_trust_start{0};	///< timestamp when minimum trust was applied first
 	hrt_abstime _landed_time{0};
 
+	TouchdownDetector _touchdown_detector;
+	hrt_abstime _touchdown_sample_last{0};	///< timestamp of the last estimator sample fed to the touchdown detector
+
 	bool _in_descend{false};		///< vehicle is desending
 	bool _horizontal_movement{false};	///< vehicle is moving horizontally
 
@@ -137,6 +162,9 @@ private:
 		(ParamFloat<px4::params::LNDMC_FFALL_TTRI>) _param_lndmc_ffall_ttri,
 		(ParamFloat<px4::params::LNDMC_LOW_T_THR>)  _param_lndmc_low_t_thr,
 		(ParamFloat<px4::params::LNDMC_ROT_MAX>)    _param_lndmc_rot_max,
+		(ParamFloat<px4::params::LNDMC_TD_ACC>)     _param_lndmc_td_acc,
+		(ParamBool<px4::params::LNDMC_TD_EN>)       _param_lndmc_td_en,
+		(ParamFloat<px4::params::LNDMC_TD_SUP>)     _param_lndmc_td_sup,
 		(ParamFloat<px4::params::LNDMC_XY_VEL_MAX>) _param_lndmc_xy_vel_max,
 		(ParamFloat<px4::params::LNDMC_Z_VEL_MAX>)  _param_lndmc_z_vel_max
 	);
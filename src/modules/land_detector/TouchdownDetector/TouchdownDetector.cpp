@@ -0,0 +1,122 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file TouchdownDetector.cpp
+ */
+
+#include "TouchdownDetector.hpp"
+
+#include <lib/ecl/geo/geo.h>
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+void TouchdownDetector::reset()
+{
+	_initialized = false;
+	_thrust_accel = 0.f;
+	_impact_residual = 0.f;
+	_residual = 0.f;
+	_specific_force = 0.f;
+	_support = 0.f;
+	_descent_speed = 0.f;
+	_impact = false;
+	_time_since_impact = 0.f;
+	_confidence = 0.f;
+}
+
+void TouchdownDetector::setHoverThrust(float hover_thrust)
+{
+	if (PX4_ISFINITE(hover_thrust) && hover_thrust > 0.f) {
+		_hover_thrust = hover_thrust;
+	}
+}
+
+void TouchdownDetector::update(float dt, float accel_z, float thrust, float vz)
+{
+	if (!(dt > 0.f) || !PX4_ISFINITE(accel_z) || !PX4_ISFINITE(thrust)) {
+		return;
+	}
+
+	dt = math::min(dt, 0.1f);
+
+	// specific force the thrust should produce, delayed by the motor response
+	const float thrust_accel = CONSTANTS_ONE_G * math::max(thrust, 0.f) / _hover_thrust;
+
+	if (!_initialized) {
+		_thrust_accel = thrust_accel;
+		_specific_force = -accel_z;
+		_descent_speed = PX4_ISFINITE(vz) ? vz : 0.f;
+		_initialized = true;
+	}
+
+	_thrust_accel += (thrust_accel - _thrust_accel) * dt / (dt + _motor_time_constant);
+
+	// specific force (up) not produced by the thrust, an impact lasts for several samples while vibrations do not
+	const float residual = -accel_z - _thrust_accel;
+	_impact_residual += (residual - _impact_residual) * dt / (dt + IMPACT_TIME_CONSTANT);
+	_residual += (residual - _residual) * dt / (dt + SUPPORT_TIME_CONSTANT);
+	_specific_force += (-accel_z - _specific_force) * dt / (dt + SUPPORT_TIME_CONSTANT);
+
+	// relative to the measured specific force a hover thrust error gives the same offset at any thrust
+	_support = _residual / math::max(_specific_force, CONSTANTS_ONE_G);
+
+	if (!PX4_ISFINITE(vz)) {
+		// without vertical velocity a support can not be told apart from a thrust model error
+		_impact = false;
+		_confidence = 0.f;
+		return;
+	}
+
+	// an impact stops the descent: check the velocity from before the impact
+	if (_impact_residual > _impact_threshold && _descent_speed > IMPACT_MIN_DESCENT_SPEED) {
+		_impact = true;
+		_time_since_impact = 0.f;
+
+	} else if (_impact) {
+		_time_since_impact += dt;
+
+		// expired or bounced off
+		if (_time_since_impact > IMPACT_WINDOW || vz < -_max_vertical_speed) {
+			_impact = false;
+		}
+	}
+
+	_descent_speed += (vz - _descent_speed) * dt / (dt + DESCENT_TIME_CONSTANT);
+
+	// full below half the maximum vertical speed, zero above it
+	const float stopped = math::constrain(2.f * (1.f - fabsf(vz) / _max_vertical_speed), 0.f, 1.f);
+	const float support = math::constrain(_support / _support_threshold, 0.f, 1.f);
+	_confidence = stopped * math::max(support, _impact ? IMPACT_CONFIDENCE : 0.f);
+}
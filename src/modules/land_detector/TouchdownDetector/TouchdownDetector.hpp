@@ -0,0 +1,138 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file TouchdownDetector.hpp
+ *
+ * Multicopter touchdown detection from the accelerometer, the thrust model and the vertical velocity.
+ *
+ * In flight, the specific force along the body z axis is produced by the thrust alone and follows
+ * g * thrust / hover_thrust. On the ground, the ground reaction carries the part of the weight that
+ * the thrust does not, which shows up as a residual between the measured and the modelled specific
+ * force: a short spike on impact and a steady offset once the vehicle rests on the ground.
+ *
+ * The confidence combines the two with the vertical velocity:
+ * confidence = stopped * max(support, IMPACT_CONFIDENCE if an impact was detected recently),
+ * such that an impact alone can not exceed IMPACT_CONFIDENCE and a full confidence requires the
+ * ground to carry at least the support threshold of the weight.
+ */
+
+#pragma once
+
+class TouchdownDetector
+{
+public:
+	/** Confidence of an impact while stopped without ground support */
+	static constexpr float IMPACT_CONFIDENCE = 0.75f;
+
+	TouchdownDetector() = default;
+	~TouchdownDetector() = default;
+
+	void reset();
+
+	/**
+	 * Update with a new estimator sample
+	 * @param dt time since the previous update [s]
+	 * @param accel_z specific force along the body z axis (down) [m/s^2], about -g in hover
+	 * @param thrust normalized collective thrust (0-1)
+	 * @param vz vertical velocity (NED) [m/s], NAN if not available
+	 */
+	void update(float dt, float accel_z, float thrust, float vz);
+
+	/**
+	 * @param hover_thrust normalized thrust required to hover (0-1)
+	 */
+	void setHoverThrust(float hover_thrust);
+
+	/**
+	 * @param threshold specific force residual above which a touchdown during descent is detected as impact [m/s^2]
+	 */
+	void setImpactThreshold(float threshold) { _impact_threshold = threshold; }
+
+	/**
+	 * @param fraction fraction of the weight carried by the ground for a full confidence (0-1)
+	 */
+	void setSupportThreshold(float fraction) { _support_threshold = fraction; }
+
+	/**
+	 * @param speed vertical speed above which the vehicle is not considered stopped [m/s]
+	 */
+	void setMaxVerticalSpeed(float speed) { _max_vertical_speed = speed; }
+
+	/**
+	 * @param time_constant time constant of the thrust response to a thrust command change [s]
+	 */
+	void setMotorTimeConstant(float time_constant) { _motor_time_constant = time_constant; }
+
+	/**
+	 * @return touchdown confidence (0-1)
+	 */
+	float getConfidence() const { return _confidence; }
+
+	/**
+	 * @return fraction of the measured specific force not produced by the thrust, the weight carried by the ground at rest
+	 */
+	float getSupport() const { return _support; }
+
+	/**
+	 * @return true if an impact was detected within the last IMPACT_WINDOW
+	 */
+	bool isImpactDetected() const { return _impact; }
+
+private:
+	static constexpr float IMPACT_TIME_CONSTANT = 0.02f; ///< [s]
+	static constexpr float SUPPORT_TIME_CONSTANT = 0.1f; ///< [s]
+	static constexpr float DESCENT_TIME_CONSTANT = 0.3f; ///< [s]
+	static constexpr float IMPACT_MIN_DESCENT_SPEED = 0.2f; ///< descent speed before an impact [m/s]
+	static constexpr float IMPACT_WINDOW = 1.f; ///< [s]
+
+	float _hover_thrust{0.5f};
+	float _impact_threshold{5.f};
+	float _support_threshold{0.4f};
+	float _max_vertical_speed{0.5f};
+	float _motor_time_constant{0.05f};
+
+	bool _initialized{false};
+	float _thrust_accel{0.f}; ///< specific force produced by the thrust [m/s^2]
+	float _impact_residual{0.f}; ///< [m/s^2]
+	float _residual{0.f}; ///< filtered specific force not produced by the thrust [m/s^2]
+	float _specific_force{0.f}; ///< filtered specific force (up) [m/s^2]
+	float _support{0.f};
+	float _descent_speed{0.f}; ///< filtered vertical velocity [m/s]
+
+	bool _impact{false};
+	float _time_since_impact{0.f}; ///< [s]
+
+	float _confidence{0.f};
+};
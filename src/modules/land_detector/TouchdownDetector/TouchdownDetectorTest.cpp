@@ -0,0 +1,309 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the multicopter touchdown detector
+ * Run this test only using make tests TESTFILTER=TouchdownDetector
+ */
+
+#include <gtest/gtest.h>
+#include <lib/ecl/geo/geo.h>
+#include <math.h>
+
+#include "TouchdownDetector.hpp"
+
+// confidence thresholds of the multicopter land detector
+static constexpr float CONTACT_CONFIDENCE = 0.5f;
+static constexpr float LANDED_CONFIDENCE = 0.9f;
+
+static constexpr float MIN_THRUST = 0.12f;
+
+/**
+ * Vertical multicopter dynamics with a velocity controller, motor lag and a spring-damper ground
+ */
+class TouchdownDetectorTest : public ::testing::Test
+{
+public:
+	struct Scenario {
+		float descent_speed{0.7f};		///< velocity setpoint down [m/s]
+		float height{2.f};			///< initial height above ground [m]
+		float true_hover_thrust{0.5f};
+		float model_hover_thrust{0.5f};		///< hover thrust known to the detector
+		float ground_stiffness{400.f};		///< per unit mass [1/s^2]
+		float ground_damping{25.f};		///< per unit mass [1/s]
+		float noise{1.f};			///< accelerometer vibration [m/s^2]
+		float duration{6.f};			///< [s]
+	};
+
+	struct Result {
+		float touchdown_time{NAN};		///< first ground contact [s]
+		float contact_latency{NAN};		///< touchdown to confidence >= CONTACT_CONFIDENCE [s]
+		float landed_latency{NAN};		///< touchdown to confidence >= LANDED_CONFIDENCE [s]
+		int false_positives{0};			///< samples in the air above CONTACT_CONFIDENCE
+		int samples_in_air{0};
+		float final_confidence{0.f};
+	};
+
+	TouchdownDetectorTest()
+	{
+		_detector.setImpactThreshold(5.f);
+		_detector.setSupportThreshold(0.4f);
+		_detector.setMaxVerticalSpeed(0.5f);
+	}
+
+	/** Deterministic pseudo random number with zero mean and unit variance */
+	float randomNormal()
+	{
+		// sum of 12 uniform samples
+		float sum = 0.f;
+
+		for (int i = 0; i < 12; i++) {
+			_seed = 1103515245u * _seed + 12345u;
+			sum += (float)((_seed >> 8) & 0xFFFF) / 65536.f;
+		}
+
+		return sum - 6.f;
+	}
+
+	/**
+	 * Run a scenario, the velocity setpoint (down) is given by a function of time
+	 */
+	template<typename Setpoint>
+	Result run(const Scenario &scenario, Setpoint velocity_setpoint)
+	{
+		Result result;
+		_detector.reset();
+		_detector.setHoverThrust(scenario.model_hover_thrust);
+
+		float z = -scenario.height; // ground at 0, down positive
+		float vz = 0.f;
+		float vz_estimate = 0.f;
+		float thrust = scenario.true_hover_thrust;
+		float thrust_actual = thrust;
+		float integral = 0.f;
+
+		for (float t = 0.f; t < scenario.duration; t += _dt) {
+			// controller: thrust up from the velocity error, integral winds down on the ground
+			const float velocity_error = velocity_setpoint(t) - vz_estimate;
+			integral += 0.4f * velocity_error * _dt;
+			thrust = scenario.true_hover_thrust * (1.f - (2.f * velocity_error + integral) / CONSTANTS_ONE_G);
+			thrust = fminf(fmaxf(thrust, MIN_THRUST), 1.f);
+
+			if (_detector.getConfidence() >= CONTACT_CONFIDENCE) {
+				// the position controller sets the thrust to zero on ground contact
+				thrust = MIN_THRUST;
+				integral = 0.f;
+			}
+
+			thrust_actual += (thrust - thrust_actual) * _dt / (_dt + 0.04f);
+
+			const float thrust_accel = CONSTANTS_ONE_G * thrust_actual / scenario.true_hover_thrust;
+			const float ground_accel = (z > 0.f) ? fmaxf(scenario.ground_stiffness * z + scenario.ground_damping * vz, 0.f) : 0.f;
+
+			vz += (CONSTANTS_ONE_G - thrust_accel - ground_accel) * _dt;
+			z += vz * _dt;
+
+			if (z > 0.f && !isfinite(result.touchdown_time)) {
+				result.touchdown_time = t;
+			}
+
+			// the estimate lags and is noisy
+			vz_estimate += (vz - vz_estimate) * _dt / (_dt + 0.05f);
+
+			const float accel_z = -(thrust_accel + ground_accel) + scenario.noise * randomNormal();
+			_detector.update(_dt, accel_z, thrust, vz_estimate + 0.03f * randomNormal());
+
+			const float confidence = _detector.getConfidence();
+
+			if (isfinite(result.touchdown_time)) {
+				const float since_touchdown = t - result.touchdown_time;
+
+				if (confidence >= CONTACT_CONFIDENCE && !isfinite(result.contact_latency)) {
+					result.contact_latency = since_touchdown;
+				}
+
+				if (confidence >= LANDED_CONFIDENCE && !isfinite(result.landed_latency)) {
+					result.landed_latency = since_touchdown;
+				}
+
+			} else {
+				result.samples_in_air++;
+
+				if (confidence >= CONTACT_CONFIDENCE) {
+					result.false_positives++;
+				}
+			}
+		}
+
+		result.final_confidence = _detector.getConfidence();
+		return result;
+	}
+
+	Result runLanding(const Scenario &scenario)
+	{
+		return run(scenario, [&scenario](float) { return scenario.descent_speed; });
+	}
+
+	TouchdownDetector _detector;
+	const float _dt{0.004f}; // 250 Hz estimator rate
+	uint32_t _seed{1};
+};
+
+TEST_F(TouchdownDetectorTest, softLanding)
+{
+	// GIVEN: a landing at the default land speed
+	Scenario scenario;
+
+	// WHEN: the vehicle descends onto the ground
+	const Result result = runLanding(scenario);
+
+	// THEN: the touchdown is detected within a fraction of the hysteresis chain of the land detector
+	printf("soft landing: contact %.3f s, landed %.3f s\n", (double)result.contact_latency,
+	       (double)result.landed_latency);
+	EXPECT_TRUE(isfinite(result.touchdown_time));
+	EXPECT_LT(result.contact_latency, 0.3f);
+	EXPECT_LT(result.landed_latency, 1.f);
+	EXPECT_GE(result.final_confidence, LANDED_CONFIDENCE);
+	EXPECT_EQ(result.false_positives, 0);
+}
+
+TEST_F(TouchdownDetectorTest, hardLanding)
+{
+	// GIVEN: a fast descent onto stiff ground
+	Scenario scenario;
+	scenario.descent_speed = 1.5f;
+	scenario.ground_stiffness = 2000.f;
+
+	const Result result = runLanding(scenario);
+
+	// THEN: the impact is detected right away
+	printf("hard landing: contact %.3f s, landed %.3f s\n", (double)result.contact_latency,
+	       (double)result.landed_latency);
+	EXPECT_LT(result.contact_latency, 0.2f);
+	EXPECT_LT(result.landed_latency, 1.f);
+	EXPECT_EQ(result.false_positives, 0);
+}
+
+TEST_F(TouchdownDetectorTest, bounce)
+{
+	// GIVEN: a fast descent onto a bouncy surface
+	Scenario scenario;
+	scenario.descent_speed = 1.5f;
+	scenario.ground_stiffness = 1000.f;
+	scenario.ground_damping = 2.f;
+
+	const Result result = runLanding(scenario);
+
+	// THEN: the vehicle is still detected once it settles
+	printf("bounce: contact %.3f s, landed %.3f s\n", (double)result.contact_latency,
+	       (double)result.landed_latency);
+	EXPECT_LT(result.landed_latency, 1.5f);
+	EXPECT_GE(result.final_confidence, LANDED_CONFIDENCE);
+	EXPECT_EQ(result.false_positives, 0);
+}
+
+TEST_F(TouchdownDetectorTest, hoverThrustModelError)
+{
+	// GIVEN: a hover thrust known to the detector 20% off in both directions
+	for (float model_error : {0.8f, 1.2f}) {
+		Scenario scenario;
+		scenario.model_hover_thrust = scenario.true_hover_thrust * model_error;
+
+		const Result result = runLanding(scenario);
+
+		// THEN: the landing is detected without false positives during the descent
+		printf("model error %.1f: contact %.3f s, landed %.3f s\n", (double)model_error,
+		       (double)result.contact_latency, (double)result.landed_latency);
+		EXPECT_LT(result.contact_latency, 0.5f);
+		EXPECT_LT(result.landed_latency, 1.5f);
+		EXPECT_GE(result.final_confidence, LANDED_CONFIDENCE);
+		EXPECT_EQ(result.false_positives, 0);
+	}
+}
+
+TEST_F(TouchdownDetectorTest, falsePositiveRate)
+{
+	// GIVEN: flights that never touch the ground: hover, descents stopped in the air and vertical maneuvers
+	Scenario scenario;
+	scenario.height = 100.f;
+	scenario.duration = 20.f;
+	scenario.noise = 2.f;
+
+	int false_positives = 0;
+	int samples = 0;
+
+	for (float model_error : {0.9f, 1.f, 1.1f}) {
+		scenario.model_hover_thrust = scenario.true_hover_thrust * model_error;
+
+		// hover
+		Result result = run(scenario, [](float) { return 0.f; });
+		false_positives += result.false_positives;
+		samples += result.samples_in_air;
+
+		// descents at increasing speed braked to hover
+		result = run(scenario, [](float t) { return (fmodf(t, 4.f) < 2.f) ? 0.5f * (1.f + floorf(t / 4.f)) : 0.f; });
+		false_positives += result.false_positives;
+		samples += result.samples_in_air;
+
+		// vertical oscillation
+		result = run(scenario, [](float t) { return 2.f * sinf(3.f * t); });
+		false_positives += result.false_positives;
+		samples += result.samples_in_air;
+	}
+
+	// THEN: the confidence stays below the contact threshold in the air
+	printf("false positives: %d of %d samples\n", false_positives, samples);
+	EXPECT_GT(samples, 0);
+	EXPECT_EQ(false_positives, 0);
+}
+
+TEST_F(TouchdownDetectorTest, noVelocity)
+{
+	// GIVEN: a vehicle resting on the ground without vertical velocity estimate
+	for (int i = 0; i < 250; i++) {
+		_detector.update(_dt, -CONSTANTS_ONE_G, 0.1f, NAN);
+	}
+
+	// THEN: the ground support is seen, but not trusted
+	EXPECT_GT(_detector.getSupport(), 0.5f);
+	EXPECT_FLOAT_EQ(_detector.getConfidence(), 0.f);
+
+	// WHEN: the velocity becomes available
+	for (int i = 0; i < 10; i++) {
+		_detector.update(_dt, -CONSTANTS_ONE_G, 0.1f, 0.f);
+	}
+
+	// THEN: the confidence is full
+	EXPECT_FLOAT_EQ(_detector.getConfidence(), 1.f);
+}
@@ -131,3 +131,50 @@ PARAM_DEFINE_FLOAT(LNDMC_ALT_MAX, -1.0f);
  *
  */
 PARAM_DEFINE_FLOAT(LNDMC_LOW_T_THR, 0.3);
+
+/**
+ * Multicopter touchdown detection
+ *
+ * Runs the land detector on every estimator update and detects the touchdown from the
+ * accelerometer impact, the thrust compared to the hover thrust and the vertical velocity.
+ * A detected touchdown shortens the time the land detector states have to hold
+ * and completes the landing without waiting for the thrust to be reduced.
+ *
+ * @boolean
+ * @reboot_required false
+ *
+ * @group Land Detector
+ */
+PARAM_DEFINE_INT32(LNDMC_TD_EN, 0);
+
+/**
+ * Multicopter touchdown impact threshold
+ *
+ * Upwards specific force not explained by the thrust above which a
+ * touchdown during the descent is detected as impact.
+ * Increase this value if vibrations or gusts are detected as impact.
+ *
+ * @unit m/s^2
+ * @min 1
+ * @max 30
+ * @decimal 1
+ *
+ * @group Land Detector
+ */
+PARAM_DEFINE_FLOAT(LNDMC_TD_ACC, 5.0f);
+
+/**
+ * Multicopter touchdown ground support threshold
+ *
+ * Fraction of the vehicle weight which has to be carried by the ground
+ * (the specific force not explained by the thrust) for a full touchdown confidence.
+ * Has to be larger than the error of the hover thrust (MPC_THR_HOVER or its estimate).
+ *
+ * @unit norm
+ * @min 0.1
+ * @max 1
+ * @decimal 2
+ *
+ * @group Land Detector
+ */
+PARAM_DEFINE_FLOAT(LNDMC_TD_SUP, 0.4f);
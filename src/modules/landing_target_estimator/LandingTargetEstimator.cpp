@@ -31,6 +31,7 @@
  *
  ****************************************************************************/
 
+
 /*
  * @file LandingTargetEstimator.cpp
  *
@@ -45,220 +46,254 @@
 
 #include "LandingTargetEstimator.h"
 
-#define SEC2USEC 1000000.0f
-
+using namespace matrix;
 
 namespace landing_target_estimator
 {
 
-LandingTargetEstimator::LandingTargetEstimator()
+LandingTargetEstimator::LandingTargetEstimator() :
+	ModuleParams(nullptr),
+	WorkItem(MODULE_NAME, px4::wq_configurations::lp_default)
 {
-	_paramHandle.acc_unc = param_find("LTEST_ACC_UNC");
-	_paramHandle.meas_unc = param_find("LTEST_MEAS_UNC");
-	_paramHandle.pos_unc_init = param_find("LTEST_POS_UNC_IN");
-	_paramHandle.vel_unc_init = param_find("LTEST_VEL_UNC_IN");
-	_paramHandle.mode = param_find("LTEST_MODE");
-	_paramHandle.scale_x = param_find("LTEST_SCALE_X");
-	_paramHandle.scale_y = param_find("LTEST_SCALE_Y");
-
-	_check_params(true);
+	_update_params();
 }
 
-void LandingTargetEstimator::update()
+LandingTargetEstimator::~LandingTargetEstimator()
 {
-	_check_params(false);
+	perf_free(_cycle_perf);
+	perf_free(_rejected_perf);
+}
 
-	_update_topics();
+bool LandingTargetEstimator::init()
+{
+	if (!_vehicleLocalPositionSub.registerCallback()) {
+		PX4_ERR("vehicle_local_position callback registration failed!");
+		return false;
+	}
 
-	/* predict */
-	if (_estimator_initialized) {
-		if (hrt_absolute_time() - _last_update > landing_target_estimator_TIMEOUT_US) {
-			PX4_WARN("Timeout");
-			_estimator_initialized = false;
+	// measurements are processed without waiting for the next local position
+	_irlockReportSub.registerCallback();
+	_targetMeasurementSub.registerCallback();
 
-		} else {
-			float dt = (hrt_absolute_time() - _last_predict) / SEC2USEC;
+	return true;
+}
 
-			// predict target position with the help of accel data
-			matrix::Vector3f a{_vehicle_acceleration.xyz};
+void LandingTargetEstimator::Run()
+{
+	if (should_exit()) {
+		_vehicleLocalPositionSub.unregisterCallback();
+		_irlockReportSub.unregisterCallback();
+		_targetMeasurementSub.unregisterCallback();
+		exit_and_cleanup();
+		return;
+	}
 
-			if (_vehicleAttitude_valid && _vehicle_acceleration_valid) {
-				matrix::Quaternion<float> q_att(&_vehicleAttitude.q[0]);
-				_R_att = matrix::Dcm<float>(q_att);
-				a = _R_att * a;
+	perf_begin(_cycle_perf);
 
-			} else {
-				a.zero();
-			}
+	if (_parameterSub.updated()) {
+		parameter_update_s paramUpdate;
+		_parameterSub.copy(&paramUpdate);
+		updateParams();
+		_update_params();
+	}
 
-			_kalman_filter_x.predict(dt, -a(0), _params.acc_unc);
-			_kalman_filter_y.predict(dt, -a(1), _params.acc_unc);
+	_update_history();
 
-			_last_predict = hrt_absolute_time();
-		}
-	}
+	_tracker.predict(hrt_absolute_time());
 
-	if (!_new_irlockReport) {
-		// nothing to do
-		return;
+	irlock_report_s irlockReport;
+
+	if (_irlockReportSub.update(&irlockReport)
+	    && PX4_ISFINITE(irlockReport.pos_x) && PX4_ISFINITE(irlockReport.pos_y)) {
+
+		// TODO account for sensor orientation as set by parameter
+		// default orientation has camera x pointing in body y, camera y in body -x
+		TargetTracker::Measurement measurement{};
+		measurement.type = TargetTracker::Measurement::Type::bearing;
+		measurement.target_id = irlockReport.signature;
+		measurement.value(0) = -irlockReport.pos_y * _param_ltest_scale_y.get(); // forward
+		measurement.value(1) = irlockReport.pos_x * _param_ltest_scale_x.get(); // right
+		measurement.value(2) = NAN; // use the distance to ground
+		measurement.variance = _param_ltest_meas_unc.get();
+
+		// the report is published after the image was processed
+		const hrt_abstime delay = static_cast<hrt_abstime>(_param_ltest_irl_delay.get() * 1000.f);
+		measurement.time_us = irlockReport.timestamp > delay ? irlockReport.timestamp - delay : 0;
+
+		_fuse(measurement);
 	}
 
-	// mark this sensor measurement as consumed
-	_new_irlockReport = false;
+	landing_target_measurement_s targetMeasurement;
 
-	if (!_vehicleAttitude_valid || !_vehicleLocalPosition_valid || !_vehicleLocalPosition.dist_bottom_valid) {
-		// don't have the data needed for an update
-		return;
+	while (_targetMeasurementSub.update(&targetMeasurement)) {
+		TargetTracker::Measurement measurement{};
+		measurement.time_us = targetMeasurement.timestamp_sample;
+		measurement.type = (targetMeasurement.type == landing_target_measurement_s::TYPE_POSITION) ?
+				   TargetTracker::Measurement::Type::position : TargetTracker::Measurement::Type::bearing;
+		measurement.target_id = targetMeasurement.target_id;
+		measurement.value = Vector3f(targetMeasurement.value);
+		measurement.variance = targetMeasurement.variance;
+
+		if (!PX4_ISFINITE(measurement.variance) || measurement.variance <= 0.f) {
+			// unknown, use the angular uncertainty of the IR-LOCK sensor
+			measurement.variance = _param_ltest_meas_unc.get();
+
+			if (measurement.type == TargetTracker::Measurement::Type::position) {
+				measurement.variance *= measurement.value(2) * measurement.value(2);
+			}
+		}
+
+		_fuse(measurement);
 	}
 
-	if (!PX4_ISFINITE(_irlockReport.pos_y) || !PX4_ISFINITE(_irlockReport.pos_x)) {
+	perf_end(_cycle_perf);
+}
+
+void LandingTargetEstimator::_update_history()
+{
+	if (!_vehicleLocalPositionSub.update(&_vehicleLocalPosition)) {
 		return;
 	}
 
-	// TODO account for sensor orientation as set by parameter
-	// default orientation has camera x pointing in body y, camera y in body -x
+	vehicle_attitude_s attitude;
 
-	matrix::Vector<float, 3> sensor_ray; // ray pointing towards target in body frame
-	sensor_ray(0) = -_irlockReport.pos_y * _params.scale_y; // forward
-	sensor_ray(1) = _irlockReport.pos_x * _params.scale_x; // right
-	sensor_ray(2) = 1.0f;
+	if (!_attitudeSub.copy(&attitude) || attitude.timestamp == 0) {
+		return;
+	}
 
-	// rotate the unit ray into the navigation frame, assume sensor frame = body frame
-	matrix::Quaternion<float> q_att(&_vehicleAttitude.q[0]);
-	_R_att = matrix::Dcm<float>(q_att);
-	sensor_ray = _R_att * sensor_ray;
+	VehicleState state{};
+	state.time_us = _vehicleLocalPosition.timestamp;
+	state.q = Quatf(attitude.q);
+	state.position = Vector3f(_vehicleLocalPosition.x, _vehicleLocalPosition.y, _vehicleLocalPosition.z);
 
-	if (fabsf(sensor_ray(2)) < 1e-6f) {
-		// z component of measurement unsafe, don't use this measurement
-		return;
+	if (_vehicleLocalPosition.v_xy_valid) {
+		state.velocity = Vector3f(_vehicleLocalPosition.vx, _vehicleLocalPosition.vy, _vehicleLocalPosition.vz);
 	}
 
-	float dist = _vehicleLocalPosition.dist_bottom;
+	state.dist_bottom = _vehicleLocalPosition.dist_bottom_valid ? _vehicleLocalPosition.dist_bottom : NAN;
 
-	// scale the ray s.t. the z component has length of dist
-	_rel_pos(0) = sensor_ray(0) / sensor_ray(2) * dist;
-	_rel_pos(1) = sensor_ray(1) / sensor_ray(2) * dist;
+	_history.push(state);
+}
 
-	if (!_estimator_initialized) {
-		PX4_INFO("Init");
-		float vx_init = _vehicleLocalPosition.v_xy_valid ? -_vehicleLocalPosition.vx : 0.f;
-		float vy_init = _vehicleLocalPosition.v_xy_valid ? -_vehicleLocalPosition.vy : 0.f;
-		_kalman_filter_x.init(_rel_pos(0), vx_init, _params.pos_unc_init, _params.vel_unc_init);
-		_kalman_filter_y.init(_rel_pos(1), vy_init, _params.pos_unc_init, _params.vel_unc_init);
+void LandingTargetEstimator::_fuse(const TargetTracker::Measurement &measurement)
+{
+	const int index = _tracker.fuse(measurement, _history);
 
-		_estimator_initialized = true;
-		_last_update = hrt_absolute_time();
-		_last_predict = _last_update;
+	if (index < 0) {
+		// measurement too old or missing vehicle state at the time it was taken
+		perf_count(_rejected_perf);
+		return;
+	}
 
-	} else {
-		// update
-		bool update_x = _kalman_filter_x.update(_rel_pos(0), _params.meas_unc * dist * dist);
-		bool update_y = _kalman_filter_y.update(_rel_pos(1), _params.meas_unc * dist * dist);
-
-		if (!update_x || !update_y) {
-			if (!_faulty) {
-				_faulty = true;
-				PX4_WARN("Landing target measurement rejected:%s%s", update_x ? "" : " x", update_y ? "" : " y");
-			}
+	if (index != _tracker.select(_param_ltest_target_id.get())) {
+		return;
+	}
 
-		} else {
-			_faulty = false;
-		}
+	const TargetTracker::Target &target = _tracker.getTarget(index);
 
+	if (target.faulty) {
 		if (!_faulty) {
-			// only publish if both measurements were good
+			_faulty = true;
+			PX4_WARN("Landing target measurement rejected");
+		}
 
-			_target_pose.timestamp = _irlockReport.timestamp;
+	} else {
+		_faulty = false;
 
-			float x, xvel, y, yvel, covx, covx_v, covy, covy_v;
-			_kalman_filter_x.getState(x, xvel);
-			_kalman_filter_x.getCovariance(covx, covx_v);
+		// only publish if the measurement was good
+		_publish_target(index);
+	}
 
-			_kalman_filter_y.getState(y, yvel);
-			_kalman_filter_y.getCovariance(covy, covy_v);
+	landing_target_innovations_s innovations{};
+	innovations.timestamp = hrt_absolute_time();
+	innovations.innov_x = target.innov[0];
+	innovations.innov_cov_x = target.innov_var[0];
+	innovations.innov_y = target.innov[1];
+	innovations.innov_cov_y = target.innov_var[1];
+	_targetInnovationsPub.publish(innovations);
+}
 
-			_target_pose.is_static = (_params.mode == TargetMode::Stationary);
+void LandingTargetEstimator::_publish_target(int index)
+{
+	// vehicle state at the time the target estimate is valid for
+	VehicleState vehicle;
 
-			_target_pose.rel_pos_valid = true;
-			_target_pose.rel_vel_valid = true;
-			_target_pose.x_rel = x;
-			_target_pose.y_rel = y;
-			_target_pose.z_rel = dist;
-			_target_pose.vx_rel = xvel;
-			_target_pose.vy_rel = yvel;
+	if (!_history.interpolate(_tracker.getTime(), vehicle)) {
+		return;
+	}
 
-			_target_pose.cov_x_rel = covx;
-			_target_pose.cov_y_rel = covy;
+	const TargetTracker::Target &target = _tracker.getTarget(index);
 
-			_target_pose.cov_vx_rel = covx_v;
-			_target_pose.cov_vy_rel = covy_v;
+	Vector3f position;
+	Vector2f velocity;
+	_tracker.getState(index, position, velocity);
 
-			if (_vehicleLocalPosition_valid && _vehicleLocalPosition.xy_valid) {
-				_target_pose.x_abs = x + _vehicleLocalPosition.x;
-				_target_pose.y_abs = y + _vehicleLocalPosition.y;
-				_target_pose.z_abs = dist + _vehicleLocalPosition.z;
-				_target_pose.abs_pos_valid = true;
+	float cov_x, cov_vx, cov_y, cov_vy;
+	target.filter_x.getCovariance(cov_x, cov_vx);
+	target.filter_y.getCovariance(cov_y, cov_vy);
 
-			} else {
-				_target_pose.abs_pos_valid = false;
-			}
+	landing_target_pose_s targetPose{};
+	targetPose.timestamp = _tracker.getTime();
+	targetPose.is_static = (static_cast<TargetMode>(_param_ltest_mode.get()) == TargetMode::Stationary);
 
-			_targetPosePub.publish(_target_pose);
+	targetPose.rel_pos_valid = _tracker.isPositionValid(index);
+	targetPose.rel_vel_valid = targetPose.rel_pos_valid && _vehicleLocalPosition.v_xy_valid;
+	targetPose.x_rel = position(0) - vehicle.position(0);
+	targetPose.y_rel = position(1) - vehicle.position(1);
+	targetPose.z_rel = position(2) - vehicle.position(2);
+	targetPose.vx_rel = velocity(0) - vehicle.velocity(0);
+	targetPose.vy_rel = velocity(1) - vehicle.velocity(1);
 
-			_last_update = hrt_absolute_time();
-			_last_predict = _last_update;
-		}
+	targetPose.cov_x_rel = cov_x;
+	targetPose.cov_y_rel = cov_y;
 
-		float innov_x, innov_cov_x, innov_y, innov_cov_y;
-		_kalman_filter_x.getInnovations(innov_x, innov_cov_x);
-		_kalman_filter_y.getInnovations(innov_y, innov_cov_y);
+	targetPose.cov_vx_rel = cov_vx;
+	targetPose.cov_vy_rel = cov_vy;
 
-		_target_innovations.timestamp = _irlockReport.timestamp;
-		_target_innovations.innov_x = innov_x;
-		_target_innovations.innov_cov_x = innov_cov_x;
-		_target_innovations.innov_y = innov_y;
-		_target_innovations.innov_cov_y = innov_cov_y;
+	if (_vehicleLocalPosition.xy_valid) {
+		targetPose.x_abs = position(0);
+		targetPose.y_abs = position(1);
+		targetPose.z_abs = position(2);
+		targetPose.abs_pos_valid = true;
 
-		_targetInnovationsPub.publish(_target_innovations);
+	} else {
+		targetPose.abs_pos_valid = false;
 	}
+
+	_targetPosePub.publish(targetPose);
 }
 
-void LandingTargetEstimator::_check_params(const bool force)
+void LandingTargetEstimator::_update_params()
 {
-	bool updated = _parameterSub.updated();
-
-	if (updated) {
-		parameter_update_s paramUpdate;
-		_parameterSub.copy(&paramUpdate);
-	}
-
-	if (updated || force) {
-		_update_params();
-	}
+	TargetTracker::Parameters params{};
+	params.acc_unc = _param_ltest_acc_unc.get();
+	params.pos_unc_init = _param_ltest_pos_unc_in.get();
+	params.vel_unc_init = _param_ltest_vel_unc_in.get();
+	params.stationary = (static_cast<TargetMode>(_param_ltest_mode.get()) == TargetMode::Stationary);
+	params.preferred_id = _param_ltest_target_id.get();
+	_tracker.setParameters(params);
 }
 
-void LandingTargetEstimator::_update_topics()
+int LandingTargetEstimator::print_status()
 {
-	_vehicleLocalPosition_valid = _vehicleLocalPositionSub.update(&_vehicleLocalPosition);
-	_vehicleAttitude_valid = _attitudeSub.update(&_vehicleAttitude);
-	_vehicle_acceleration_valid = _vehicle_acceleration_sub.update(&_vehicle_acceleration);
+	PX4_INFO("Running");
 
-	_new_irlockReport = _irlockReportSub.update(&_irlockReport);
-}
+	for (int i = 0; i < TargetTracker::MAX_TARGETS; i++) {
+		const TargetTracker::Target &target = _tracker.getTarget(i);
 
-void LandingTargetEstimator::_update_params()
-{
-	param_get(_paramHandle.acc_unc, &_params.acc_unc);
-	param_get(_paramHandle.meas_unc, &_params.meas_unc);
-	param_get(_paramHandle.pos_unc_init, &_params.pos_unc_init);
-	param_get(_paramHandle.vel_unc_init, &_params.vel_unc_init);
+		if (target.valid) {
+			Vector3f position;
+			Vector2f velocity;
+			_tracker.getState(i, position, velocity);
+			PX4_INFO("target %d: [%.2f, %.2f, %.2f] m, last seen %.1f s ago", target.id, (double)position(0),
+				 (double)position(1), (double)position(2), (double)(hrt_elapsed_time(&target.last_update_us) * 1e-6f));
+		}
+	}
 
-	int32_t mode = 0;
-	param_get(_paramHandle.mode, &mode);
-	_params.mode = (TargetMode)mode;
+	perf_print_counter(_cycle_perf);
+	perf_print_counter(_rejected_perf);
 
-	param_get(_paramHandle.scale_x, &_params.scale_x);
-	param_get(_paramHandle.scale_y, &_params.scale_y);
+	return 0;
 }
 
 
@@ -31,10 +31,14 @@
  *
  ****************************************************************************/
 
+
 /*
  * @file LandingTargetEstimator.h
  * Landing target position estimator. Filter and publish the position of a landing target on the ground as observed by an onboard sensor.
  *
+ * Runs on a work queue whenever a new vehicle local position or target measurement is published.
+ * The measurements are fused at the time they were taken, using a short history of the vehicle state.
+ *
  * @author Nicolas de Palezieux (Sunflower Labs) <ndepal@gmail.com>
  * @author Mohammed Kabir <kabir@uasys.io>
  *
@@ -42,121 +46,109 @@
 
 #pragma once
 
-#include <px4_workqueue.h>
+#include <px4_module.h>
+#include <px4_module_params.h>
 #include <drivers/drv_hrt.h>
-#include <parameters/param.h>
+#include <perf/perf_counter.h>
+#include <px4_platform_common/px4_work_queue/WorkItem.hpp>
 #include <uORB/Publication.hpp>
 #include <uORB/Subscription.hpp>
-#include <uORB/topics/vehicle_acceleration.h>
+#include <uORB/SubscriptionCallback.hpp>
 #include <uORB/topics/vehicle_attitude.h>
 #include <uORB/topics/vehicle_local_position.h>
 #include <uORB/topics/irlock_report.h>
+#include <uORB/topics/landing_target_measurement.h>
 #include <uORB/topics/landing_target_pose.h>
 #include <uORB/topics/landing_target_innovations.h>
 #include <uORB/topics/parameter_update.h>
 #include <matrix/math.hpp>
-#include <mathlib/mathlib.h>
-#include <matrix/Matrix.hpp>
-#include "KalmanFilter.h"
+
+#include "TargetTracker.hpp"
+#include "VehicleStateHistory.hpp"
 
 
 namespace landing_target_estimator
 {
 
-class LandingTargetEstimator
+class LandingTargetEstimator : public ModuleBase<LandingTargetEstimator>, public ModuleParams, public px4::WorkItem
 {
 public:
 
 	LandingTargetEstimator();
-	virtual ~LandingTargetEstimator() = default;
+	~LandingTargetEstimator() override;
 
-	/*
-	 * Get new measurements and update the state estimate
-	 */
-	void update();
+	/** @see ModuleBase */
+	static int task_spawn(int argc, char *argv[]);
 
-protected:
+	/** @see ModuleBase */
+	static int custom_command(int argc, char *argv[]);
 
-	/*
-	 * Update uORB topics.
-	 */
-	void _update_topics();
+	/** @see ModuleBase */
+	static int print_usage(const char *reason = nullptr);
+
+	/** @see ModuleBase::print_status() */
+	int print_status() override;
+
+	bool init();
+
+private:
+
+	void Run() override;
 
 	/*
 	 * Update parameters.
 	 */
 	void _update_params();
 
-	/* timeout after which filter is reset if target not seen */
-	static constexpr uint32_t landing_target_estimator_TIMEOUT_US = 2000000;
-
-	uORB::Publication<landing_target_pose_s> _targetPosePub{ORB_ID(landing_target_pose)};
-	landing_target_pose_s _target_pose{};
-
-	uORB::Publication<landing_target_innovations_s> _targetInnovationsPub{ORB_ID(landing_target_innovations)};
-	landing_target_innovations_s _target_innovations{};
+	/*
+	 * Add the latest vehicle state to the history.
+	 */
+	void _update_history();
 
-	uORB::Subscription _parameterSub{ORB_ID(parameter_update)};
+	/*
+	 * Fuse a measurement and publish the result if it belongs to the selected target.
+	 */
+	void _fuse(const TargetTracker::Measurement &measurement);
 
-private:
+	void _publish_target(int index);
 
 	enum class TargetMode {
 		Moving = 0,
 		Stationary
 	};
 
-	/**
-	* Handles for parameters
-	**/
-	struct {
-		param_t acc_unc;
-		param_t meas_unc;
-		param_t pos_unc_init;
-		param_t vel_unc_init;
-		param_t mode;
-		param_t scale_x;
-		param_t scale_y;
-	} _paramHandle;
-
-	struct {
-		float acc_unc;
-		float meas_unc;
-		float pos_unc_init;
-		float vel_unc_init;
-		TargetMode mode;
-		float scale_x;
-		float scale_y;
-	} _params;
-
-	uORB::Subscription _vehicleLocalPositionSub{ORB_ID(vehicle_local_position)};
+	uORB::Publication<landing_target_pose_s> _targetPosePub{ORB_ID(landing_target_pose)};
+	uORB::Publication<landing_target_innovations_s> _targetInnovationsPub{ORB_ID(landing_target_innovations)};
+
+	uORB::SubscriptionCallbackWorkItem _vehicleLocalPositionSub{this, ORB_ID(vehicle_local_position)};
+	uORB::SubscriptionCallbackWorkItem _irlockReportSub{this, ORB_ID(irlock_report)};
+	uORB::SubscriptionCallbackWorkItem _targetMeasurementSub{this, ORB_ID(landing_target_measurement)};
+
 	uORB::Subscription _attitudeSub{ORB_ID(vehicle_attitude)};
-	uORB::Subscription _vehicle_acceleration_sub{ORB_ID(vehicle_acceleration)};
-	uORB::Subscription _irlockReportSub{ORB_ID(irlock_report)};
-
-	vehicle_local_position_s	_vehicleLocalPosition{};
-	vehicle_attitude_s		_vehicleAttitude{};
-	vehicle_acceleration_s		_vehicle_acceleration{};
-	irlock_report_s			_irlockReport{};
-
-	// keep track of which topics we have received
-	bool _vehicleLocalPosition_valid{false};
-	bool _vehicleAttitude_valid{false};
-	bool _vehicle_acceleration_valid{false};
-	bool _new_irlockReport{false};
-	bool _estimator_initialized{false};
-	// keep track of whether last measurement was rejected
-	bool _faulty{false};
+	uORB::Subscription _parameterSub{ORB_ID(parameter_update)};
+
+	vehicle_local_position_s _vehicleLocalPosition{};
 
-	matrix::Dcmf _R_att;
-	matrix::Vector2f _rel_pos;
-	KalmanFilter _kalman_filter_x;
-	KalmanFilter _kalman_filter_y;
-	hrt_abstime _last_predict{0}; // timestamp of last filter prediction
-	hrt_abstime _last_update{0}; // timestamp of last filter update (used to check timeout)
+	VehicleStateHistory _history;
+	TargetTracker _tracker;
 
-	void _check_params(const bool force);
+	// keep track of whether last measurement was rejected
+	bool _faulty{false};
 
-	void _update_state();
+	perf_counter_t _cycle_perf{perf_alloc(PC_ELAPSED, "landing_target_estimator: cycle")};
+	perf_counter_t _rejected_perf{perf_alloc(PC_COUNT, "landing_target_estimator: unused measurement")};
+
+	DEFINE_PARAMETERS(
+		(ParamInt<px4::params::LTEST_MODE>) _param_ltest_mode,
+		(ParamFloat<px4::params::LTEST_ACC_UNC>) _param_ltest_acc_unc,
+		(ParamFloat<px4::params::LTEST_MEAS_UNC>) _param_ltest_meas_unc,
+		(ParamFloat<px4::params::LTEST_POS_UNC_IN>) _param_ltest_pos_unc_in,
+		(ParamFloat<px4::params::LTEST_VEL_UNC_IN>) _param_ltest_vel_unc_in,
+		(ParamFloat<px4::params::LTEST_SCALE_X>) _param_ltest_scale_x,
+		(ParamFloat<px4::params::LTEST_SCALE_Y>) _param_ltest_scale_y,
+		(ParamFloat<px4::params::LTEST_IRL_DELAY>) _param_ltest_irl_delay,
+		(ParamInt<px4::params::LTEST_TARGET_ID>) _param_ltest_target_id
+	)
 };
 
 
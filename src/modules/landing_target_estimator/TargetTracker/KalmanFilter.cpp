@@ -86,13 +86,20 @@ void KalmanFilter::predict(float dt, float acc, float acc_unc)
 }
 
 bool KalmanFilter::update(float meas, float measUnc)
+{
+	return update(meas, measUnc, 0.f);
+}
+
+bool KalmanFilter::update(float meas, float measUnc, float delay)
 {
 
-	// H = [1, 0]
-	_residual = meas - _x(0);
+	// H = [1, -delay]
+	_residual = meas - (_x(0) - delay * _x(1));
 
-	// H * P * H^T simply selects P(0,0)
-	_innovCov = _covariance(0, 0) + measUnc;
+	// H * P * H^T
+	const float PHt0 = _covariance(0, 0) - delay * _covariance(0, 1);
+	const float PHt1 = _covariance(1, 0) - delay * _covariance(1, 1);
+	_innovCov = PHt0 - delay * PHt1 + measUnc;
 
 	// outlier rejection
 	float beta = _residual / _innovCov * _residual;
@@ -103,8 +110,8 @@ bool KalmanFilter::update(float meas, float measUnc)
 	}
 
 	matrix::Vector<float, 2> kalmanGain;
-	kalmanGain(0) = _covariance(0, 0);
-	kalmanGain(1) = _covariance(1, 0);
+	kalmanGain(0) = PHt0;
+	kalmanGain(1) = PHt1;
 	kalmanGain /= _innovCov;
 
 	_x += kalmanGain * _residual;
@@ -115,6 +122,8 @@ bool KalmanFilter::update(float meas, float measUnc)
 	matrix::Matrix<float, 2, 2> KH; // kalmanGain * H
 	KH(0, 0) = kalmanGain(0);
 	KH(1, 0) = kalmanGain(1);
+	KH(0, 1) = -kalmanGain(0) * delay;
+	KH(1, 1) = -kalmanGain(1) * delay;
 
 	_covariance = (identity - KH) * _covariance;
 
@@ -122,29 +131,29 @@ bool KalmanFilter::update(float meas, float measUnc)
 
 }
 
-void KalmanFilter::getState(matrix::Vector<float, 2> &state)
+void KalmanFilter::getState(matrix::Vector<float, 2> &state) const
 {
 	state = _x;
 }
 
-void KalmanFilter::getState(float &state0, float &state1)
+void KalmanFilter::getState(float &state0, float &state1) const
 {
 	state0 = _x(0);
 	state1 = _x(1);
 }
 
-void KalmanFilter::getCovariance(matrix::Matrix<float, 2, 2> &covariance)
+void KalmanFilter::getCovariance(matrix::Matrix<float, 2, 2> &covariance) const
 {
 	covariance = _covariance;
 }
 
-void KalmanFilter::getCovariance(float &cov00, float &cov11)
+void KalmanFilter::getCovariance(float &cov00, float &cov11) const
 {
 	cov00 = _covariance(0, 0);
 	cov11 = _covariance(1, 1);
 }
 
-void KalmanFilter::getInnovations(float &innov, float &innovCov)
+void KalmanFilter::getInnovations(float &innov, float &innovCov) const
 {
 	innov = _residual;
 	innovCov = _innovCov;
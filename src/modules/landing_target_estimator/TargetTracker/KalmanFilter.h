@@ -41,6 +41,8 @@
  *
  * Update with a direct measurement of the first state:
  * H = [1 0]
+ * or with a measurement of the first state taken a short delay before the current state:
+ * H = [1 -delay]
  *
  * @author Nicolas de Palezieux (Sunflower Labs) <ndepal@gmail.com>
  *
@@ -105,38 +107,48 @@ public:
 	 */
 	bool update(float meas, float measUnc);
 
+	/**
+	 * Update the state estimate with a delayed measurement
+	 * The process noise in between the measurement and the current state is neglected.
+	 * @param meas    measurement of the first state at the time current - delay
+	 * @param measUnc measurement uncertainty
+	 * @param delay   Time delta in seconds between the measurement and the current state
+	 * @return update success (measurement not rejected)
+	 */
+	bool update(float meas, float measUnc, float delay);
+
 	/**
 	 * Get the current filter state
 	 * @param x1 State
 	 */
-	void getState(matrix::Vector<float, 2> &state);
+	void getState(matrix::Vector<float, 2> &state) const;
 
 	/**
 	 * Get the current filter state
 	 * @param state0 First state
 	 * @param state1 Second state
 	 */
-	void getState(float &state0, float &state1);
+	void getState(float &state0, float &state1) const;
 
 	/**
 	 * Get state covariance
 	 * @param covariance Covariance of the state
 	 */
-	void getCovariance(matrix::Matrix<float, 2, 2> &covariance);
+	void getCovariance(matrix::Matrix<float, 2, 2> &covariance) const;
 
 	/**
 	 * Get state variances (diagonal elements)
 	 * @param cov00 Variance of first state
 	 * @param cov11 Variance of second state
 	 */
-	void getCovariance(float &cov00, float &cov11);
+	void getCovariance(float &cov00, float &cov11) const;
 
 	/**
 	 * Get measurement innovation and covariance of last update call
 	 * @param innov Measurement innovation
 	 * @param innovCov Measurement innovation covariance
 	 */
-	void getInnovations(float &innov, float &innovCov);
+	void getInnovations(float &innov, float &innovCov) const;
 
 private:
 	matrix::Vector<float, 2> _x; // state
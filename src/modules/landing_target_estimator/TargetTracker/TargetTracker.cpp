@@ -0,0 +1,248 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file TargetTracker.cpp
+ */
+
+#include "TargetTracker.hpp"
+
+#include <px4_defines.h>
+
+using namespace matrix;
+
+namespace landing_target_estimator
+{
+
+void TargetTracker::reset()
+{
+	for (Target &target : _targets) {
+		target.valid = false;
+	}
+
+	_time_us = 0;
+}
+
+void TargetTracker::predict(uint64_t now)
+{
+	if (now <= _time_us) {
+		return;
+	}
+
+	const float dt = (_time_us == 0) ? 0.f : (now - _time_us) * 1e-6f;
+	const float acc_unc = _params.stationary ? STATIONARY_ACC_UNC : _params.acc_unc;
+
+	for (Target &target : _targets) {
+		if (!target.valid) {
+			continue;
+		}
+
+		if (now > target.last_update_us + TIMEOUT_US) {
+			target.valid = false;
+			continue;
+		}
+
+		target.filter_x.predict(dt, 0.f, acc_unc);
+		target.filter_y.predict(dt, 0.f, acc_unc);
+	}
+
+	_time_us = now;
+}
+
+int TargetTracker::fuse(const Measurement &measurement, const VehicleStateHistory &history)
+{
+	if (measurement.time_us + MAX_DELAY_US < _time_us) {
+		return -1;
+	}
+
+	predict(measurement.time_us);
+
+	// vehicle state at the time the measurement was taken
+	VehicleState state;
+
+	if (!history.interpolate(measurement.time_us, state)) {
+		return -1;
+	}
+
+	const Dcmf R(state.q);
+	Vector3f relative_position;
+	float variance = measurement.variance;
+
+	if (measurement.type == Measurement::Type::bearing) {
+		const Vector3f ray = R * Vector3f(measurement.value(0), measurement.value(1), 1.f);
+		const float range = measurement.value(2);
+
+		if (PX4_ISFINITE(range) && range > 0.f) {
+			relative_position = ray.normalized() * range;
+
+		} else if (PX4_ISFINITE(state.dist_bottom) && ray(2) > 1e-6f) {
+			// scale the ray s.t. the z component has length of dist_bottom
+			relative_position = ray * (state.dist_bottom / ray(2));
+
+		} else {
+			return -1;
+		}
+
+		// angular uncertainty to position uncertainty
+		variance *= relative_position(2) * relative_position(2);
+
+	} else {
+		relative_position = R * measurement.value;
+	}
+
+	if (!PX4_ISFINITE(relative_position(0)) || !PX4_ISFINITE(relative_position(1)) || !PX4_ISFINITE(variance)) {
+		return -1;
+	}
+
+	const Vector3f target_position = state.position + relative_position;
+
+	const int index = _findOrAllocate(measurement.target_id);
+	Target &target = _targets[index];
+
+	if (!target.valid) {
+		target.filter_x.init(target_position(0), 0.f, _params.pos_unc_init, _params.vel_unc_init);
+		target.filter_y.init(target_position(1), 0.f, _params.pos_unc_init, _params.vel_unc_init);
+		target.z = target_position(2);
+		target.id = measurement.target_id;
+		target.last_update_us = measurement.time_us;
+		target.valid = true;
+		target.faulty = false;
+		target.innov[0] = target.innov[1] = 0.f;
+		target.innov_var[0] = target.innov_var[1] = 0.f;
+		return index;
+	}
+
+	// the filters are at _time_us, the measurement is delayed relative to it
+	const float delay = (_time_us - measurement.time_us) * 1e-6f;
+
+	const bool update_x = target.filter_x.update(target_position(0), variance, delay);
+	const bool update_y = target.filter_y.update(target_position(1), variance, delay);
+
+	target.filter_x.getInnovations(target.innov[0], target.innov_var[0]);
+	target.filter_y.getInnovations(target.innov[1], target.innov_var[1]);
+
+	target.faulty = !update_x || !update_y;
+
+	if (!target.faulty) {
+		target.z = target_position(2);
+
+		if (measurement.time_us > target.last_update_us) {
+			target.last_update_us = measurement.time_us;
+		}
+	}
+
+	return index;
+}
+
+int TargetTracker::select(int preferred_id) const
+{
+	int selected = -1;
+
+	for (int i = 0; i < MAX_TARGETS; i++) {
+		if (!_targets[i].valid) {
+			continue;
+		}
+
+		if (_targets[i].id == preferred_id) {
+			return i;
+		}
+
+		// otherwise prefer the lowest id such that the selection is stable
+		if (selected < 0 || _targets[i].id < _targets[selected].id) {
+			selected = i;
+		}
+	}
+
+	return selected;
+}
+
+bool TargetTracker::isPositionValid(int index) const
+{
+	const Target &target = _targets[index];
+
+	if (!target.valid || target.faulty) {
+		return false;
+	}
+
+	Vector3f position;
+	Vector2f velocity;
+	getState(index, position, velocity);
+
+	float var_x, var_vx, var_y, var_vy;
+	target.filter_x.getCovariance(var_x, var_vx);
+	target.filter_y.getCovariance(var_y, var_vy);
+
+	return PX4_ISFINITE(position(0)) && PX4_ISFINITE(position(1))
+	       && PX4_ISFINITE(var_x) && PX4_ISFINITE(var_y)
+	       && var_x < MAX_POS_VARIANCE && var_y < MAX_POS_VARIANCE;
+}
+
+void TargetTracker::getState(int index, Vector3f &position, Vector2f &velocity) const
+{
+	const Target &target = _targets[index];
+	target.filter_x.getState(position(0), velocity(0));
+	target.filter_y.getState(position(1), velocity(1));
+	position(2) = target.z;
+}
+
+int TargetTracker::_findOrAllocate(uint16_t id)
+{
+	const int selected = select(_params.preferred_id);
+	int free = -1;
+	int oldest = -1;
+
+	for (int i = 0; i < MAX_TARGETS; i++) {
+		if (_targets[i].valid) {
+			if (_targets[i].id == id) {
+				return i;
+			}
+
+			// the target we are landing on is never replaced
+			if (i != selected && (oldest < 0 || _targets[i].last_update_us < _targets[oldest].last_update_us)) {
+				oldest = i;
+			}
+
+		} else if (free < 0) {
+			free = i;
+		}
+	}
+
+	if (free >= 0) {
+		return free;
+	}
+
+	// all slots in use: replace the target that was not seen for the longest time
+	_targets[oldest].valid = false;
+	return oldest;
+}
+
+} // namespace landing_target_estimator
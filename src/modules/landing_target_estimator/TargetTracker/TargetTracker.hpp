@@ -0,0 +1,145 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file TargetTracker.hpp
+ *
+ * Tracks the position of one or more landing targets in the navigation frame (NED).
+ *
+ * Each measurement is related to the vehicle state at the time it was taken (from the
+ * VehicleStateHistory), such that sensor latency does not turn into a position error
+ * when the vehicle moves or tilts. The target position is then fused as a delayed
+ * measurement into a constant velocity Kalman filter per horizontal axis, which is
+ * propagated to the current time.
+ *
+ * Targets are identified by the id reported by the sensor (e.g. the IR beacon signature).
+ */
+
+#pragma once
+
+#include "KalmanFilter.h"
+#include "VehicleStateHistory.hpp"
+
+namespace landing_target_estimator
+{
+
+class TargetTracker
+{
+public:
+	static constexpr int MAX_TARGETS = 4;
+	static constexpr uint64_t TIMEOUT_US = 2000000; ///< a target is dropped if not seen for this long
+	static constexpr uint64_t MAX_DELAY_US = 500000; ///< older measurements are rejected
+
+	struct Measurement {
+		enum class Type {
+			bearing, ///< value = [x/z, y/z, range] of the ray to the target in body frame, NAN range to use the distance to ground
+			position ///< value = position of the target relative to the vehicle in body frame [m]
+		};
+
+		uint64_t time_us; ///< time at which the measurement was taken
+		Type type;
+		uint16_t target_id;
+		matrix::Vector3f value;
+		float variance; ///< bearing: [tan(rad)^2], position: [m^2]
+	};
+
+	struct Target {
+		KalmanFilter filter_x;
+		KalmanFilter filter_y;
+		float z; ///< NED [m]
+		uint64_t last_update_us; ///< time of the last accepted measurement
+		uint16_t id;
+		bool valid;
+		bool faulty; ///< last measurement rejected by the outlier check
+		float innov[2];
+		float innov_var[2];
+	};
+
+	struct Parameters {
+		float acc_unc{10.f}; ///< target acceleration variance, only used for moving targets [(m/s^2)^2]
+		float pos_unc_init{0.1f};
+		float vel_unc_init{0.1f};
+		bool stationary{false};
+		int preferred_id{-1}; ///< target to land on if tracked, see select()
+	};
+
+	TargetTracker() = default;
+	~TargetTracker() = default;
+
+	void setParameters(const Parameters &params) { _params = params; }
+
+	void reset();
+
+	/**
+	 * Propagate all targets to the current time and drop the ones not seen for too long
+	 */
+	void predict(uint64_t now);
+
+	/**
+	 * Fuse a measurement, the targets are propagated to the measurement time if it is newer than the last predict() call
+	 * @return index of the target the measurement belongs to, -1 if the measurement could not be used
+	 */
+	int fuse(const Measurement &measurement, const VehicleStateHistory &history);
+
+	/**
+	 * Select the target to land on
+	 * @param preferred_id id of the preferred target, used if it is tracked
+	 * @return index of the selected target, -1 if no target is tracked
+	 */
+	int select(int preferred_id) const;
+
+	const Target &getTarget(int index) const { return _targets[index]; }
+
+	/**
+	 * @return true if the target is tracked and its position estimate is finite with a bounded variance
+	 */
+	bool isPositionValid(int index) const;
+
+	/**
+	 * Get the position and velocity of a target in the navigation frame at the time of the last predict() call
+	 */
+	void getState(int index, matrix::Vector3f &position, matrix::Vector2f &velocity) const;
+
+	uint64_t getTime() const { return _time_us; }
+
+private:
+	int _findOrAllocate(uint16_t id);
+
+	Target _targets[MAX_TARGETS] {};
+	Parameters _params{};
+	uint64_t _time_us{0};
+
+	static constexpr float STATIONARY_ACC_UNC = 0.01f; ///< only accounts for the drift of the local position [(m/s^2)^2]
+	static constexpr float MAX_POS_VARIANCE = 4.f; ///< larger position variances are not usable for landing [m^2]
+};
+
+} // namespace landing_target_estimator
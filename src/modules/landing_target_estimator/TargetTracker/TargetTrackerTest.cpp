@@ -0,0 +1,314 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * Test code for the landing target tracker
+ * Run this test only using make tests TESTFILTER=TargetTracker
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/matrix/math.hpp>
+
+#include <vector>
+
+#include "TargetTracker.hpp"
+
+using namespace matrix;
+using namespace landing_target_estimator;
+
+class TargetTrackerTest : public ::testing::Test
+{
+public:
+	static constexpr uint64_t DESCENT_US = 20000000;
+
+	/** Vehicle spiraling down onto the target while rotating and tilting */
+	static VehicleState vehicle(uint64_t time_us)
+	{
+		const float t = time_us * 1e-6f;
+		const float T = DESCENT_US * 1e-6f;
+		const float radius = 4.f * (1.f - t / T);
+
+		VehicleState state{};
+		state.time_us = time_us;
+		state.position = Vector3f(3.f + radius * cosf(0.8f * t), -2.f + radius * sinf(0.8f * t), -10.f + 9.5f * t / T);
+		state.velocity = Vector3f(-4.f / T * cosf(0.8f * t) - 0.8f * radius * sinf(0.8f * t),
+					  -4.f / T * sinf(0.8f * t) + 0.8f * radius * cosf(0.8f * t), 9.5f / T);
+		state.q = Quatf(Eulerf(0.15f * sinf(2.f * t), 0.15f * cosf(1.7f * t), 0.3f * t));
+		state.dist_bottom = -state.position(2);
+		return state;
+	}
+
+	/** Bearing to a target on the ground as seen from the vehicle body frame */
+	TargetTracker::Measurement bearing(const Vector3f &target, uint64_t time_us, uint16_t id)
+	{
+		const VehicleState state = vehicle(time_us);
+		const Vector3f relative_body = Dcmf(state.q).transpose() * (target - state.position);
+
+		TargetTracker::Measurement measurement{};
+		measurement.time_us = time_us;
+		measurement.type = TargetTracker::Measurement::Type::bearing;
+		measurement.target_id = id;
+		measurement.value = Vector3f(relative_body(0) / relative_body(2) + 0.01f * noise(),
+					     relative_body(1) / relative_body(2) + 0.01f * noise(), NAN);
+		measurement.variance = 0.005f;
+		return measurement;
+	}
+
+	/** Position of a target relative to the vehicle in body frame */
+	TargetTracker::Measurement position(const Vector3f &target, uint64_t time_us, uint16_t id)
+	{
+		const VehicleState state = vehicle(time_us);
+
+		TargetTracker::Measurement measurement{};
+		measurement.time_us = time_us;
+		measurement.type = TargetTracker::Measurement::Type::position;
+		measurement.target_id = id;
+		measurement.value = Dcmf(state.q).transpose() * (target - state.position);
+		measurement.value(0) += 0.05f * noise();
+		measurement.value(1) += 0.05f * noise();
+		measurement.variance = 0.01f;
+		return measurement;
+	}
+
+	/** Deterministic pseudo random number in [-1, 1) */
+	float noise()
+	{
+		_seed = 1103515245u * _seed + 12345u;
+		return (float)((_seed >> 8) & 0xFFFF) / 32768.f - 1.f;
+	}
+
+	struct Message {
+		uint64_t arrival_us;
+		TargetTracker::Measurement measurement;
+	};
+
+	/**
+	 * Replay a descent with a target measurement every 20ms arriving after the given delay.
+	 * @param compensated if false, the measurements are time stamped at arrival like a polling estimator would
+	 * @return RMS of the horizontal landing target position error during the descent [m]
+	 */
+	float replayDescent(uint64_t delay_us, bool compensated)
+	{
+		const Vector3f target(3.f, -2.f, 0.f);
+		std::vector<Message> messages;
+
+		for (uint64_t time_us = 20000; time_us < DESCENT_US; time_us += 20000) {
+			Message message{time_us + delay_us, bearing(target, time_us, 1)};
+
+			if (!compensated) {
+				message.measurement.time_us = message.arrival_us;
+			}
+
+			messages.push_back(message);
+		}
+
+		VehicleStateHistory history;
+		TargetTracker tracker;
+		TargetTracker::Parameters params{};
+		params.stationary = true;
+		tracker.setParameters(params);
+
+		size_t index = 0;
+		float error_squared = 0.f;
+		int n = 0;
+
+		// estimator runs with the local position at 100Hz
+		for (uint64_t now = 10000; now < DESCENT_US; now += 10000) {
+			history.push(vehicle(now));
+			tracker.predict(now);
+
+			while (index < messages.size() && messages[index].arrival_us <= now) {
+				tracker.fuse(messages[index++].measurement, history);
+			}
+
+			const int selected = tracker.select(1);
+
+			if (now < 2000000) {
+				// initial convergence
+				continue;
+			}
+
+			EXPECT_GE(selected, 0);
+
+			if (selected >= 0) {
+				Vector3f estimate;
+				Vector2f velocity;
+				tracker.getState(selected, estimate, velocity);
+				const Vector2f error(estimate(0) - target(0), estimate(1) - target(1));
+				error_squared += error * error;
+				n++;
+			}
+		}
+
+		return sqrtf(error_squared / n);
+	}
+
+	uint32_t _seed{12345};
+};
+
+TEST_F(TargetTrackerTest, historyInterpolation)
+{
+	VehicleStateHistory history;
+
+	for (uint64_t time_us = 1000000; time_us <= 1500000; time_us += 10000) {
+		history.push(vehicle(time_us));
+	}
+
+	VehicleState state;
+	EXPECT_FALSE(history.interpolate(900000, state));
+	EXPECT_FALSE(history.interpolate(1600000, state));
+
+	ASSERT_TRUE(history.interpolate(1234500, state));
+	const VehicleState truth = vehicle(1234500);
+	EXPECT_LT((state.position - truth.position).norm(), 1e-3f);
+	EXPECT_LT((Dcmf(state.q) * Vector3f(0.f, 0.f, 1.f) - Dcmf(truth.q) * Vector3f(0.f, 0.f, 1.f)).norm(), 1e-3f);
+	EXPECT_NEAR(state.dist_bottom, truth.dist_bottom, 1e-3f);
+}
+
+TEST_F(TargetTrackerTest, delayCompensatedLanding)
+{
+	for (uint64_t delay_us : {0, 50000, 100000, 200000}) {
+		// WHEN: the measurements are fused at the time they were taken
+		const float error_compensated = replayDescent(delay_us, true);
+
+		// AND: for comparison at the time they arrived
+		const float error_uncompensated = replayDescent(delay_us, false);
+
+		// THEN: the landing target error does not depend on the sensor delay
+		EXPECT_LT(error_compensated, 0.05f) << "delay " << delay_us;
+
+		if (delay_us >= 50000) {
+			EXPECT_LT(error_compensated * 2.f, error_uncompensated) << "delay " << delay_us;
+		}
+	}
+}
+
+TEST_F(TargetTrackerTest, multipleTargetsAndSensors)
+{
+	// GIVEN: two targets, one seen by a bearing sensor with 20ms delay,
+	// the other one by a position sensor with 150ms delay, arriving interleaved
+	const Vector3f target_a(3.f, -2.f, 0.f);
+	const Vector3f target_b(-1.f, 4.f, 0.f);
+
+	VehicleStateHistory history;
+	TargetTracker tracker;
+	TargetTracker::Parameters params{};
+	params.stationary = true;
+	tracker.setParameters(params);
+
+	for (uint64_t now = 10000; now < 5000000; now += 10000) {
+		history.push(vehicle(now));
+		tracker.predict(now);
+
+		if (now % 20000 == 0 && now > 20000) {
+			EXPECT_GE(tracker.fuse(bearing(target_a, now - 20000, 7), history), 0);
+		}
+
+		if (now % 50000 == 0 && now > 150000) {
+			EXPECT_GE(tracker.fuse(position(target_b, now - 150000, 3), history), 0);
+		}
+	}
+
+	// THEN: both targets are tracked independently
+	const int index_a = tracker.select(7);
+	const int index_b = tracker.select(3);
+	ASSERT_GE(index_a, 0);
+	ASSERT_GE(index_b, 0);
+	EXPECT_NE(index_a, index_b);
+
+	Vector3f position_a, position_b;
+	Vector2f velocity;
+	tracker.getState(index_a, position_a, velocity);
+	tracker.getState(index_b, position_b, velocity);
+	EXPECT_LT((position_a - target_a).norm(), 0.1f);
+	EXPECT_LT((position_b - target_b).norm(), 0.1f);
+
+	// AND: without preference, the selection is stable
+	EXPECT_EQ(tracker.select(-1), index_b);
+
+	// AND: the targets time out when not seen anymore
+	tracker.predict(5000000 + TargetTracker::TIMEOUT_US);
+	EXPECT_EQ(tracker.select(-1), -1);
+}
+
+TEST_F(TargetTrackerTest, selectedTargetIsNeverReplaced)
+{
+	// GIVEN: the preferred target, seen first, and then as many other targets as there are slots
+	VehicleStateHistory history;
+	TargetTracker tracker;
+	TargetTracker::Parameters params{};
+	params.stationary = true;
+	params.preferred_id = 1;
+	tracker.setParameters(params);
+
+	for (uint64_t now = 10000; now <= 1000000; now += 10000) {
+		history.push(vehicle(now));
+	}
+
+	tracker.predict(500000);
+	const int selected = tracker.fuse(position(Vector3f(3.f, -2.f, 0.f), 500000, 1), history);
+	ASSERT_GE(selected, 0);
+	EXPECT_TRUE(tracker.isPositionValid(selected));
+
+	for (uint16_t id = 2; id < 2 + TargetTracker::MAX_TARGETS; id++) {
+		EXPECT_GE(tracker.fuse(position(Vector3f(id, 0.f, 0.f), 500000 + id * 10000, id), history), 0);
+	}
+
+	// THEN: the oldest other target was replaced, not the one we land on
+	EXPECT_EQ(tracker.select(params.preferred_id), selected);
+	EXPECT_EQ(tracker.getTarget(selected).id, 1);
+
+	// AND: the estimate becomes invalid once the target times out
+	tracker.predict(500000 + TargetTracker::TIMEOUT_US + 1);
+	EXPECT_FALSE(tracker.isPositionValid(selected));
+}
+
+TEST_F(TargetTrackerTest, rejectTooOldMeasurements)
+{
+	VehicleStateHistory history;
+	TargetTracker tracker;
+
+	for (uint64_t now = 10000; now < 2000000; now += 10000) {
+		history.push(vehicle(now));
+	}
+
+	tracker.predict(2000000);
+
+	// older than the allowed delay
+	EXPECT_EQ(tracker.fuse(bearing(Vector3f(), 2000000 - TargetTracker::MAX_DELAY_US - 10000, 1), history), -1);
+
+	// older than the history
+	history.reset();
+	history.push(vehicle(1900000));
+	EXPECT_EQ(tracker.fuse(bearing(Vector3f(), 1800000, 1), history), -1);
+	EXPECT_EQ(tracker.fuse(bearing(Vector3f(), 1950000, 1), history), 0);
+}
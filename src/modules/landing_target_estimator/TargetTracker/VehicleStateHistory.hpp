@@ -0,0 +1,172 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file VehicleStateHistory.hpp
+ *
+ * Short history of the vehicle state, such that sensor measurements can be related
+ * to the attitude and position of the vehicle at the time they were taken.
+ */
+
+#pragma once
+
+#include <matrix/math.hpp>
+#include <px4_defines.h>
+#include <stdint.h>
+
+namespace landing_target_estimator
+{
+
+struct VehicleState {
+	uint64_t time_us;
+	matrix::Quatf q; ///< attitude, rotation from body (FRD) to navigation frame (NED)
+	matrix::Vector3f position; ///< NED [m]
+	matrix::Vector3f velocity; ///< NED [m/s]
+	float dist_bottom; ///< distance to the ground [m], NAN if not valid
+};
+
+class VehicleStateHistory
+{
+public:
+	static constexpr int CAPACITY = 64;
+	static constexpr uint64_t MIN_INTERVAL_US = 10000; ///< states closer in time are decimated
+	static constexpr uint64_t MAX_EXTRAPOLATION_US = 50000; ///< newest state may be extrapolated by this
+
+	VehicleStateHistory() = default;
+	~VehicleStateHistory() = default;
+
+	void reset() { _count = 0; }
+
+	/**
+	 * Add a state, states must be pushed in chronological order
+	 */
+	void push(const VehicleState &state)
+	{
+		if (_count > 0) {
+			const VehicleState &newest = get(_count - 1);
+
+			if (state.time_us < newest.time_us) {
+				return;
+			}
+
+			if (_count > 1 && state.time_us - get(_count - 2).time_us < MIN_INTERVAL_US) {
+				// keep the history dense in time: replace the newest state
+				_states[(_head + _count - 1) % CAPACITY] = state;
+				return;
+			}
+		}
+
+		if (_count < CAPACITY) {
+			_count++;
+
+		} else {
+			_head = (_head + 1) % CAPACITY;
+		}
+
+		_states[(_head + _count - 1) % CAPACITY] = state;
+	}
+
+	/**
+	 * Get the state at a given time, interpolated between the buffered states
+	 * @return false if the time is not covered by the history
+	 */
+	bool interpolate(uint64_t time_us, VehicleState &out) const
+	{
+		if (_count == 0 || time_us < get(0).time_us) {
+			return false;
+		}
+
+		const VehicleState &newest = get(_count - 1);
+
+		if (time_us >= newest.time_us) {
+			if (time_us - newest.time_us > MAX_EXTRAPOLATION_US) {
+				return false;
+			}
+
+			out = newest;
+			out.position += newest.velocity * ((time_us - newest.time_us) * 1e-6f);
+			out.time_us = time_us;
+			return true;
+		}
+
+		// binary search for the last state before time_us
+		int low = 0;
+		int high = _count - 1;
+
+		while (high - low > 1) {
+			const int mid = (low + high) / 2;
+
+			if (get(mid).time_us <= time_us) {
+				low = mid;
+
+			} else {
+				high = mid;
+			}
+		}
+
+		const VehicleState &a = get(low);
+		const VehicleState &b = get(high);
+		const float s = (float)(time_us - a.time_us) / (float)(b.time_us - a.time_us);
+
+		out.time_us = time_us;
+		out.position = a.position * (1.f - s) + b.position * s;
+		out.velocity = a.velocity * (1.f - s) + b.velocity * s;
+
+		// normalized linear quaternion interpolation, accurate for the small rotations in between states
+		const float sign = (a.q.dot(b.q) < 0.f) ? -1.f : 1.f;
+		for (int i = 0; i < 4; i++) {
+			out.q(i) = a.q(i) * (1.f - s) + b.q(i) * (sign * s);
+		}
+
+		out.q.normalize();
+
+		if (PX4_ISFINITE(a.dist_bottom) && PX4_ISFINITE(b.dist_bottom)) {
+			out.dist_bottom = a.dist_bottom * (1.f - s) + b.dist_bottom * s;
+
+		} else {
+			out.dist_bottom = (s < 0.5f) ? a.dist_bottom : b.dist_bottom;
+		}
+
+		return true;
+	}
+
+	int size() const { return _count; }
+
+	const VehicleState &get(int index) const { return _states[(_head + index) % CAPACITY]; }
+
+private:
+	VehicleState _states[CAPACITY] {};
+	int _head{0};
+	int _count{0};
+};
+
+} // namespace landing_target_estimator
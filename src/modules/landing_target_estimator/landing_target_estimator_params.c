@@ -59,7 +59,7 @@ PARAM_DEFINE_INT32(LTEST_MODE, 0);
 /**
  * Acceleration uncertainty
  *
- * Variance of acceleration measurement used for landing target position prediction.
+ * Variance of the acceleration of the landing target used for landing target position prediction in mode Moving.
  * Higher values results in tighter following of the measurements and more lenient outlier rejection
  *
  * @unit (m/s^2)^2
@@ -132,3 +132,31 @@ PARAM_DEFINE_FLOAT(LTEST_SCALE_X, 1.0f);
  * @group Landing target Estimator
  */
 PARAM_DEFINE_FLOAT(LTEST_SCALE_Y, 1.0f);
+
+/**
+ * IR-LOCK sensor latency
+ *
+ * Time between the image capture and the publication of the IR-LOCK report.
+ * The report is fused with the vehicle attitude and position at the time of the image capture.
+ *
+ * @unit ms
+ * @min 0
+ * @max 300
+ * @decimal 0
+ *
+ * @group Landing target Estimator
+ */
+PARAM_DEFINE_FLOAT(LTEST_IRL_DELAY, 0.0f);
+
+/**
+ * Landing target id
+ *
+ * Id of the landing target to land on (e.g. the IR beacon signature) if more than one target is seen.
+ * If the target is not tracked, or the id is set to -1, the tracked target with the lowest id is used.
+ *
+ * @min -1
+ * @max 65535
+ *
+ * @group Landing target Estimator
+ */
+PARAM_DEFINE_INT32(LTEST_TARGET_ID, -1);
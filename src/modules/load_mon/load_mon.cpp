@@ -51,6 +51,7 @@
 #include <uORB/PublicationQueued.hpp>
 #include <uORB/topics/cpuload.h>
 #include <uORB/topics/task_stack_info.h>
+#include <uORB/topics/work_item_status.h>
 
 #if defined(__PX4_NUTTX) && !defined(CONFIG_SCHED_INSTRUMENTATION)
 #  error load_mon support requires CONFIG_SCHED_INSTRUMENTATION
@@ -101,6 +102,18 @@ private:
 	/** Calculate the memory usage */
 	float _ram_used();
 
+	/** Publish the runtime and budget status of the next few work items. */
+	void _work_item_status();
+
+	static void _publish_work_item_status(const char *wq_name, const px4::WorkItem &item, void *arg);
+
+	static constexpr int WORK_ITEMS_PER_CYCLE = 4;	///< less than the work_item_status queue length
+
+	int _work_item_index{0};	///< first work item published in this cycle
+	int _work_item_count{0};	///< work items visited in this cycle
+
+	uORB::PublicationQueued<work_item_status_s> _work_item_status_pub{ORB_ID(work_item_status)};
+
 #ifdef __PX4_NUTTX
 	/* Calculate stack usage */
 	void _stack_usage();
@@ -162,6 +175,7 @@ LoadMon::start()
 void LoadMon::Run()
 {
 	_cpuload();
+	_work_item_status();
 
 #ifdef __PX4_NUTTX
 
@@ -224,6 +238,51 @@ float LoadMon::_ram_used()
 #endif
 }
 
+void LoadMon::_work_item_status()
+{
+	// all work items round robin, a few per cycle
+	_work_item_count = 0;
+	px4::WorkQueueManagerForEachItem(&LoadMon::_publish_work_item_status, this);
+
+	_work_item_index += WORK_ITEMS_PER_CYCLE;
+
+	if (_work_item_index >= _work_item_count) {
+		_work_item_index = 0;
+	}
+}
+
+void LoadMon::_publish_work_item_status(const char *wq_name, const px4::WorkItem &item, void *arg)
+{
+	LoadMon *obj = static_cast<LoadMon *>(arg);
+	const int index = obj->_work_item_count++;
+
+	if (index < obj->_work_item_index || index >= obj->_work_item_index + WORK_ITEMS_PER_CYCLE) {
+		return;
+	}
+
+	const px4::WorkItemBudget &budget = item.budget();
+
+	work_item_status_s status{};
+	strncpy((char *)status.item_name, item.ItemName(), sizeof(status.item_name) - 1);
+	strncpy((char *)status.work_queue, wq_name, sizeof(status.work_queue) - 1);
+
+	status.budget = budget.budget();
+	status.period = budget.period();
+	status.run_count = budget.run_count();
+	status.overrun_count = budget.overrun_count();
+	status.late_count = budget.late_count();
+	status.skip_count = budget.skip_count();
+	status.runtime_avg = budget.runtime_avg();
+	status.runtime_max = budget.runtime_max();
+	status.lateness_avg = budget.lateness_avg();
+	status.lateness_max = budget.lateness_max();
+	status.policy = (uint8_t)budget.policy();
+	status.chronic = budget.chronic();
+	status.timestamp = hrt_absolute_time();
+
+	obj->_work_item_status_pub.publish(status);
+}
+
 #ifdef __PX4_NUTTX
 void LoadMon::_stack_usage()
 {
@@ -326,7 +385,8 @@ int LoadMon::print_usage(const char *reason)
 		R"DESCR_STR(
 ### Description
 Background process running periodically with 1 Hz on the LP work queue to calculate the CPU load and RAM
-usage and publish the `cpuload` topic.
+usage and publish the `cpuload` topic. For each work item with an execution budget it publishes
+`work_item_status` with its runtime, start lateness and overruns.
 
 On NuttX it also checks the stack usage of each process and if it falls below 300 bytes, a warning is output,
 which will also appear in the log file.
@@ -515,16 +515,21 @@ void Logger::add_default_topics()
 	add_topic("camera_capture");
 	add_topic("camera_trigger");
 	add_topic("camera_trigger_secondary");
+	add_topic("camera_trigger_distance");
 	add_topic("cpuload");
 	add_topic("ekf2_innovations", 200);
 	add_topic("ekf_gps_drift");
 	add_topic("esc_status", 250);
 	add_topic("estimator_status", 200);
 	add_topic("home_position");
+	add_topic("hover_thrust_estimate", 100);
 	add_topic("input_rc", 200);
 	add_topic("manual_control_setpoint", 200);
+	add_topic("mag_calibration_estimate", 1000);
 	add_topic("mission");
+	add_topic("mission_lookahead");
 	add_topic("mission_result");
+	add_topic("motor_failure", 100);
 	add_topic("optical_flow", 50);
 	add_topic("position_controller_status", 500);
 	add_topic("position_setpoint_triplet", 200);
@@ -550,6 +555,7 @@ void Logger::add_default_topics()
 	add_topic("vehicle_status", 200);
 	add_topic("vehicle_status_flags");
 	add_topic("vtol_vehicle_status", 200);
+	add_topic("work_item_status");
 
 	add_topic_multi("actuator_outputs", 100);
 	add_topic_multi("battery_status", 500);
@@ -565,6 +571,7 @@ void Logger::add_default_topics()
 	add_topic("fw_virtual_attitude_setpoint");
 	add_topic("mc_virtual_attitude_setpoint");
 	add_topic("offboard_control_mode");
+	add_topic("offboard_trajectory_sample");
 	add_topic("position_controller_status");
 	add_topic("time_offset");
 	add_topic("vehicle_angular_velocity", 10);
@@ -1039,10 +1046,10 @@ void Logger::run()
 				++sub_idx;
 			}
 
-			// check for new logging message(s)
+			// check for new logging message(s), they are queued
 			log_message_s log_message;
 
-			if (_log_message_sub.update(&log_message)) {
+			while (_log_message_sub.update(&log_message)) {
 				const char *message = (const char *)log_message.text;
 				int message_len = strlen(message);
 
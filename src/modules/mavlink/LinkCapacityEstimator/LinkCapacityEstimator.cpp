@@ -0,0 +1,326 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file LinkCapacityEstimator.cpp
+ */
+
+#include "LinkCapacityEstimator.hpp"
+
+#include <mathlib/mathlib.h>
+
+void LinkCapacityEstimator::reset()
+{
+	_budget = math::max(STARTUP_RATIO * _max_rate, _min_rate);
+	_capacity = 0.f;
+	_startup = true;
+	_state = State::Normal;
+	_hold_until = 0;
+	_last_decrease = 0;
+
+	_bytes_tx = 0;
+	_bytes_txerr = 0;
+	_last_update = 0;
+	_sent_rate = 0.f;
+	_total_bytes = 0;
+	_history_index = 0;
+	_history_count = 0;
+
+	_rtt_valid = false;
+	_last_rtt_sample = 0;
+	_srtt = 0.f;
+	_min_rtt = 0.f;
+	_min_rtt_window = 0.f;
+	_min_rtt_previous = 0.f;
+	_min_rtt_window_start = 0;
+	_queue_delay = 0.f;
+	_last_queue_delay = 0.f;
+
+	_anchor_valid = false;
+	_delay_trend = 0.f;
+	_delay_trend_start = 0;
+	_capacity_sample = 0.f;
+	_capacity_sample_time = 0;
+
+	_last_radio_status = 0;
+	_radio_txbuf = 100;
+}
+
+void LinkCapacityEstimator::setMaxRate(float rate)
+{
+	_max_rate = rate;
+
+	if (_last_update == 0) {
+		// not started yet
+		_budget = math::max(STARTUP_RATIO * rate, _min_rate);
+
+	} else {
+		_budget = math::min(_budget, rate);
+	}
+}
+
+void LinkCapacityEstimator::rttSample(uint64_t now, float rtt)
+{
+	const uint64_t rtt_us = (uint64_t)(rtt * 1e6f);
+
+	if (!(rtt > 0.f) || rtt_us > now) {
+		return;
+	}
+
+	if (!_rtt_valid || (now > _last_rtt_sample + rttTimeout())) {
+		_srtt = rtt;
+		_min_rtt_window = rtt;
+		_min_rtt_previous = rtt;
+		_min_rtt_window_start = now;
+		_anchor_valid = false;
+
+	} else {
+		_srtt += SRTT_GAIN * (rtt - _srtt);
+
+		if (now > _min_rtt_window_start + MIN_RTT_WINDOW) {
+			_min_rtt_previous = _min_rtt_window;
+			_min_rtt_window = rtt;
+			_min_rtt_window_start = now;
+
+		} else {
+			_min_rtt_window = math::min(_min_rtt_window, rtt);
+		}
+	}
+
+	// the minimum over one to two windows
+	_min_rtt = math::min(_min_rtt_window, _min_rtt_previous);
+	_queue_delay = math::max(_srtt - _min_rtt, 0.f);
+	_last_queue_delay = rtt - _min_rtt;
+
+	_rtt_valid = true;
+	_last_rtt_sample = now;
+
+	updateCapacitySample(now, now - rtt_us, _last_queue_delay);
+}
+
+void LinkCapacityEstimator::updateCapacitySample(uint64_t now, uint64_t request, float queue_delay)
+{
+	uint64_t bytes = 0;
+
+	if (!bytesSentAt(request, bytes)) {
+		_anchor_valid = false;
+		return;
+	}
+
+	if (_anchor_valid && request < _anchor_request + CAPACITY_SAMPLE_INTERVAL) {
+		return;
+	}
+
+	if (_anchor_valid && request > _anchor_request) {
+		const float interval = (request - _anchor_request) * 1e-6f;
+		const float delay_growth = queue_delay - _anchor_delay;
+
+		_delay_trend = delay_growth / interval;
+		_delay_trend_start = _anchor_request;
+
+		// the link was busy if both requests waited in a queue
+		const float busy_delay = 0.25f * _target_delay;
+
+		if (_anchor_delay > busy_delay && queue_delay > busy_delay && interval + delay_growth > 0.f) {
+			_capacity_sample = (bytes - _anchor_bytes) / (interval + delay_growth);
+			_capacity_sample_time = now;
+			_capacity = _capacity_sample;
+		}
+	}
+
+	_anchor_valid = true;
+	_anchor_request = request;
+	_anchor_bytes = bytes;
+	_anchor_delay = queue_delay;
+}
+
+bool LinkCapacityEstimator::bytesSentAt(uint64_t time, uint64_t &bytes) const
+{
+	if (_history_count == 0) {
+		return false;
+	}
+
+	const int newest = (_history_index + HISTORY_SIZE - 1) % HISTORY_SIZE;
+
+	if (time >= _history[newest].time) {
+		bytes = _history[newest].total_bytes;
+		return true;
+	}
+
+	for (int i = 1; i < _history_count; i++) {
+		const HistoryEntry &after = _history[(newest - i + 1 + HISTORY_SIZE) % HISTORY_SIZE];
+		const HistoryEntry &before = _history[(newest - i + HISTORY_SIZE) % HISTORY_SIZE];
+
+		if (time >= before.time) {
+			const float ratio = (float)(time - before.time) / (after.time - before.time);
+			bytes = before.total_bytes + (uint64_t)(ratio * (after.total_bytes - before.total_bytes));
+			return true;
+		}
+	}
+
+	// older than the history
+	return false;
+}
+
+void LinkCapacityEstimator::radioStatus(uint64_t now, unsigned txbuf)
+{
+	_last_radio_status = now;
+	_radio_txbuf = txbuf;
+}
+
+void LinkCapacityEstimator::update(uint64_t now)
+{
+	if (_last_update == 0) {
+		_last_update = now;
+		_history[0] = HistoryEntry{now, 0};
+		_history_index = 1;
+		_history_count = 1;
+		return;
+	}
+
+	if (now < _last_update + UPDATE_INTERVAL) {
+		return;
+	}
+
+	const float dt = (now - _last_update) * 1e-6f;
+	_last_update = now;
+
+	bool response_timeout = false;
+
+	if (_rtt_valid && (now > _last_rtt_sample + rttTimeout())) {
+		// responses stuck behind a long queue or lost on a congested link
+		response_timeout = _last_queue_delay > _target_delay;
+
+		_rtt_valid = false;
+		_anchor_valid = false;
+		_delay_trend = 0.f;
+	}
+
+	const unsigned bytes_tx = _bytes_tx;
+	const unsigned bytes_txerr = _bytes_txerr;
+	_bytes_tx = 0;
+	_bytes_txerr = 0;
+
+	const float alpha = dt / (RATE_TIME_CONSTANT + dt);
+	_sent_rate += alpha * (bytes_tx / dt - _sent_rate);
+
+	_total_bytes += bytes_tx;
+	_history[_history_index] = HistoryEntry{now, _total_bytes};
+	_history_index = (_history_index + 1) % HISTORY_SIZE;
+	_history_count = math::min(_history_count + 1, HISTORY_SIZE);
+
+	const float error_ratio = (bytes_txerr > 0) ? (float)bytes_txerr / (bytes_tx + bytes_txerr) : 0.f;
+
+	const State usage = detectUsage(now, error_ratio, response_timeout);
+
+	if (usage == State::Overuse) {
+		if (now >= _hold_until) {
+			// what the link delivered while congested
+			float delivered = math::min(_budget, _sent_rate);
+			_capacity = delivered;
+
+			if (_capacity_sample > 0.f && (now < _capacity_sample_time + CAPACITY_SAMPLE_TIMEOUT)) {
+				delivered = math::min(delivered, _capacity_sample);
+				_capacity = _capacity_sample;
+			}
+
+			// decrease more with a long queue, so that it drains within a few round trips
+			float decrease = DECREASE_FACTOR;
+
+			if (_rtt_valid && _queue_delay > 2.f * _target_delay) {
+				decrease = math::max(MIN_DECREASE_FACTOR, DECREASE_FACTOR * 2.f * _target_delay / _queue_delay);
+			}
+
+			_budget = math::max(decrease * delivered, _min_rate);
+			_startup = false;
+			_last_decrease = now;
+			_hold_until = now + MIN_HOLD_TIME;
+		}
+
+	} else if (usage == State::Normal && now >= _hold_until) {
+		// do not probe beyond what is used
+		if (_sent_rate >= APP_LIMITED_RATIO * _budget) {
+			if (_capacity > 0.f && _budget > 1.5f * _capacity) {
+				// the link improved, the old estimate does not limit the increase anymore
+				_capacity = 0.f;
+			}
+
+			if (_startup) {
+				_budget *= 1.f + STARTUP_INCREASE * dt;
+
+			} else if (_capacity > 0.f && _budget > 0.9f * _capacity) {
+				_budget += NEAR_INCREASE * _capacity * dt;
+
+			} else {
+				_budget *= 1.f + FAR_INCREASE * dt;
+			}
+		}
+	}
+
+	_budget = math::constrain(_budget, _min_rate, math::max(_max_rate, _min_rate));
+	_state = usage;
+}
+
+LinkCapacityEstimator::State LinkCapacityEstimator::detectUsage(uint64_t now, float error_ratio,
+		bool response_timeout) const
+{
+	const bool radio_valid = (_last_radio_status != 0) && (now < _last_radio_status + RADIO_STATUS_TIMEOUT);
+
+	// a decrease shows in the next RADIO_STATUS at the earliest
+	const bool radio_overuse = radio_valid && (_radio_txbuf < RADIO_BUFFER_LOW_PERCENTAGE)
+				   && (_last_radio_status > _last_decrease);
+
+	// the delay growth has to be measured with requests sent after the last decrease,
+	// and a queue that is already draining does not need another decrease
+	const bool delay_overuse = _rtt_valid && (_queue_delay > _target_delay) && (_last_queue_delay > _target_delay)
+				   && (_delay_trend_start >= _last_decrease) && (_delay_trend > -MIN_DRAIN_RATE);
+
+	if (radio_overuse || delay_overuse || response_timeout || (error_ratio > TX_ERROR_RATIO)) {
+		return State::Overuse;
+	}
+
+	const bool radio_underuse = !radio_valid || (_radio_txbuf > RADIO_BUFFER_HALF_PERCENTAGE);
+	const bool delay_underuse = !_rtt_valid || (_queue_delay < 0.5f * _target_delay);
+
+	if (radio_underuse && delay_underuse && (error_ratio <= 0.f)) {
+		return State::Normal;
+	}
+
+	return State::Hold;
+}
+
+uint64_t LinkCapacityEstimator::rttTimeout() const
+{
+	return math::max(RTT_TIMEOUT, (uint64_t)(2.f * _srtt * 1e6f));
+}
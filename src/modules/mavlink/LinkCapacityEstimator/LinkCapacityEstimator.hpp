@@ -0,0 +1,239 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file LinkCapacityEstimator.hpp
+ *
+ * Congestion control of the MAVLink transmit rate.
+ *
+ * The send budget follows what the link delivers instead of a configured data rate. Congestion
+ * is detected from the queueing delay, the radio buffer level (RADIO_STATUS) and transmit errors.
+ * The queueing delay is the smoothed round trip time of request/response pairs (TIMESYNC) above
+ * the minimum round trip time of the last MIN_RTT_WINDOW.
+ *
+ * Each response also tells when its request was sent. Between two requests sent while the queue
+ * at the bottleneck was not empty, the link delivered the bytes sent in between minus the growth
+ * of the queue, which gives a capacity sample bytes / (time + delay growth).
+ *
+ * The budget starts at STARTUP_RATIO of the maximum rate and grows exponentially until the link
+ * is congested for the first time, such that the minimum round trip time is measured with an
+ * empty queue. On congestion the budget is reduced to DECREASE_FACTOR times the capacity sample (or the sent
+ * rate), down to MIN_DECREASE_FACTOR with a long queue, and held until feedback about the new
+ * budget arrived. Without congestion it increases, quickly while far below the last capacity
+ * estimate and slowly close to it, but only while the budget is used.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+class LinkCapacityEstimator
+{
+public:
+	/** Percentage of the radio buffer that is free below which the link is congested */
+	static constexpr unsigned RADIO_BUFFER_LOW_PERCENTAGE = 35;
+	/** Percentage of the radio buffer that is free above which the link has spare capacity */
+	static constexpr unsigned RADIO_BUFFER_HALF_PERCENTAGE = 50;
+
+	LinkCapacityEstimator() = default;
+	~LinkCapacityEstimator() = default;
+
+	/**
+	 * Restart from a fraction of the maximum rate and forget all feedback
+	 */
+	void reset();
+
+	/**
+	 * @param rate maximum send budget, the configured data rate [B/s]
+	 */
+	void setMaxRate(float rate);
+
+	/**
+	 * @param rate minimum send budget [B/s]
+	 */
+	void setMinRate(float rate) { _min_rate = rate; }
+
+	/**
+	 * @param delay queueing delay above which the link is considered congested [s]
+	 */
+	void setTargetDelay(float delay) { _target_delay = delay; }
+
+	/**
+	 * Count transmitted bytes
+	 */
+	void txBytes(unsigned bytes) { _bytes_tx += bytes; }
+
+	/**
+	 * Count bytes that could not be transmitted (e.g. full UART buffer)
+	 */
+	void txErrorBytes(unsigned bytes) { _bytes_txerr += bytes; }
+
+	/**
+	 * @param now time of the response [us]
+	 * @param rtt round trip time of a request/response pair [s]
+	 */
+	void rttSample(uint64_t now, float rtt);
+
+	/**
+	 * @param now time of the RADIO_STATUS message [us]
+	 * @param txbuf remaining free transmit buffer space of the radio [%]
+	 */
+	void radioStatus(uint64_t now, unsigned txbuf);
+
+	/**
+	 * Run the controller, can be called at any rate
+	 * @param now [us]
+	 */
+	void update(uint64_t now);
+
+	/**
+	 * @return current send budget [B/s]
+	 */
+	float getBudget() const { return _budget; }
+
+	/**
+	 * @return estimated link capacity [B/s], 0 if the link was not congested yet
+	 */
+	float getCapacity() const { return _capacity; }
+
+	/**
+	 * @return estimated queueing delay [s], 0 without round trip time samples
+	 */
+	float getQueueDelay() const { return _rtt_valid ? _queue_delay : 0.f; }
+
+	/**
+	 * @return smoothed round trip time [s], 0 without round trip time samples
+	 */
+	float getRtt() const { return _rtt_valid ? _srtt : 0.f; }
+
+	/**
+	 * @return transmitted data rate, low pass filtered [B/s]
+	 */
+	float getSentRate() const { return _sent_rate; }
+
+	/**
+	 * @return true if the link was congested at the last update
+	 */
+	bool isCongested() const { return _state == State::Overuse; }
+
+private:
+	enum class State {
+		Normal,
+		Hold,
+		Overuse
+	};
+
+	static constexpr uint64_t UPDATE_INTERVAL = 100000; ///< [us]
+	static constexpr uint64_t CAPACITY_SAMPLE_INTERVAL = 500000; ///< minimum time between the requests of a sample [us]
+	static constexpr uint64_t CAPACITY_SAMPLE_TIMEOUT = 2000000; ///< [us]
+	static constexpr uint64_t MIN_RTT_WINDOW = 10000000; ///< [us]
+	static constexpr uint64_t RTT_TIMEOUT = 3000000; ///< minimum, at least twice the round trip time [us]
+	static constexpr uint64_t RADIO_STATUS_TIMEOUT = 5000000; ///< [us]
+	static constexpr uint64_t MIN_HOLD_TIME = 300000; ///< [us]
+
+	static constexpr float RATE_TIME_CONSTANT = 1.f; ///< sent rate filter [s]
+	static constexpr float SRTT_GAIN = 0.25f;
+	static constexpr float DECREASE_FACTOR = 0.85f;
+	static constexpr float MIN_DECREASE_FACTOR = 0.5f; ///< decrease with a queueing delay far above the target
+	static constexpr float STARTUP_RATIO = 0.1f; ///< initial budget relative to the maximum rate
+	static constexpr float STARTUP_INCREASE = 1.f; ///< relative increase until the first congestion [1/s]
+	static constexpr float FAR_INCREASE = 0.15f; ///< relative increase far below the capacity estimate [1/s]
+	static constexpr float NEAR_INCREASE = 0.03f; ///< increase close to the capacity estimate, relative to it [1/s]
+	static constexpr float APP_LIMITED_RATIO = 0.7f; ///< used fraction of the budget below which it is not increased
+	static constexpr float TX_ERROR_RATIO = 0.01f; ///< fraction of bytes with transmit errors that is congestion
+	static constexpr float MIN_DRAIN_RATE = 0.05f; ///< queueing delay decrease of a draining queue [s/s]
+
+	static constexpr int HISTORY_SIZE = 64; ///< sent bytes history, UPDATE_INTERVAL apart, longer than RTT_TIMEOUT
+
+	State detectUsage(uint64_t now, float error_ratio, bool response_timeout) const;
+	uint64_t rttTimeout() const;
+	void updateCapacitySample(uint64_t now, uint64_t request, float queue_delay);
+
+	/**
+	 * @return total bytes sent until the given time, interpolated from the history
+	 */
+	bool bytesSentAt(uint64_t time, uint64_t &bytes) const;
+
+	float _max_rate{1000.f};
+	float _min_rate{50.f};
+	float _target_delay{0.1f};
+
+	float _budget{1000.f};
+	float _capacity{0.f};
+	bool _startup{true};
+	State _state{State::Normal};
+	uint64_t _hold_until{0};
+	uint64_t _last_decrease{0};
+
+	// sent data
+	unsigned _bytes_tx{0};
+	unsigned _bytes_txerr{0};
+	uint64_t _last_update{0};
+	float _sent_rate{0.f};
+	uint64_t _total_bytes{0};
+
+	struct HistoryEntry {
+		uint64_t time;
+		uint64_t total_bytes;
+	};
+
+	HistoryEntry _history[HISTORY_SIZE] {};
+	int _history_index{0};
+	int _history_count{0};
+
+	// round trip time
+	bool _rtt_valid{false};
+	uint64_t _last_rtt_sample{0};
+	float _srtt{0.f};
+	float _min_rtt{0.f};
+	float _min_rtt_window{0.f}; ///< minimum in the current window
+	float _min_rtt_previous{0.f}; ///< minimum of the previous window
+	uint64_t _min_rtt_window_start{0};
+	float _queue_delay{0.f}; ///< smoothed
+	float _last_queue_delay{0.f}; ///< of the latest sample
+
+	// capacity sample between the request of the anchor and a later one
+	bool _anchor_valid{false};
+	uint64_t _anchor_request{0};
+	uint64_t _anchor_bytes{0};
+	float _anchor_delay{0.f};
+	float _delay_trend{0.f}; ///< queueing delay growth [s/s]
+	uint64_t _delay_trend_start{0}; ///< request time from which the trend was measured
+	float _capacity_sample{0.f};
+	uint64_t _capacity_sample_time{0};
+
+	// radio
+	uint64_t _last_radio_status{0};
+	unsigned _radio_txbuf{100};
+};
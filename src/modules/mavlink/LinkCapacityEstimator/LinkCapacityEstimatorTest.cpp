@@ -0,0 +1,325 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the MAVLink link capacity estimator
+ * Run this test only using make tests TESTFILTER=LinkCapacityEstimator
+ */
+
+#include <gtest/gtest.h>
+#include <deque>
+#include <math.h>
+#include <random>
+
+#include "LinkCapacityEstimator.hpp"
+
+static constexpr float MAX_RATE = 10000.f; // [B/s]
+static constexpr float TARGET_DELAY = 0.1f; // [s]
+
+/**
+ * Rate limited, lossy link with a transmit buffer at the bottleneck (e.g. a telemetry radio)
+ */
+class LinkCapacityEstimatorTest : public ::testing::Test
+{
+public:
+	struct Link {
+		float capacity{2000.f};			///< [B/s]
+		float buffer{1000.f};			///< transmit buffer [B]
+		float base_rtt{0.05f};			///< round trip time with an empty buffer [s]
+		float loss{0.f};			///< probability to lose a response or a RADIO_STATUS
+		bool rtt{true};				///< request/response round trip times (TIMESYNC)
+		bool radio_status{false};		///< RADIO_STATUS with the buffer level at 1 Hz
+		bool tx_errors{false};			///< a full buffer rejects writes (UART) instead of dropping silently
+	};
+
+	struct Stats {
+		float throughput{0.f};			///< delivered over the link [B/s]
+		float queue_delay{0.f};			///< mean time in the buffer [s]
+		float budget{0.f};			///< mean budget [B/s]
+		float drop_ratio{0.f};			///< dropped or rejected fraction of the data
+	};
+
+	void SetUp() override
+	{
+		_estimator.setMaxRate(MAX_RATE);
+		_estimator.setMinRate(0.05f * MAX_RATE);
+		_estimator.setTargetDelay(TARGET_DELAY);
+	}
+
+	/**
+	 * Runs the link with the sender writing up to the budget
+	 * @param duration [s]
+	 * @param demand data the sender has available [B/s]
+	 * @param record accumulate the statistics
+	 */
+	Stats run(float duration, float demand = 1e6f, bool record = true)
+	{
+		static constexpr uint64_t DT = 10000;
+		Stats stats{};
+		const uint64_t end = _now + (uint64_t)(duration * 1e6f);
+		uint64_t steps = 0;
+		float sent = 0.f;
+		float dropped = 0.f;
+
+		while (_now < end) {
+			_now += DT;
+			const float dt = DT * 1e-6f;
+
+			// sender
+			_pending_bytes += fminf(demand, _estimator.getBudget()) * dt;
+			const unsigned bytes = (unsigned)_pending_bytes;
+			_pending_bytes -= bytes;
+
+			const float accepted = fminf(bytes, _link.buffer - _queue);
+
+			if (_link.tx_errors) {
+				_estimator.txBytes((unsigned)accepted);
+				_estimator.txErrorBytes(bytes - (unsigned)accepted);
+
+			} else {
+				_estimator.txBytes(bytes);
+			}
+
+			sent += bytes;
+			dropped += bytes - accepted;
+			_queue += accepted;
+
+			// requests queue behind the data
+			if (_link.rtt && _now % 100000 == 0 && !lost()) {
+				_responses.push_back(Response{_now + (uint64_t)((_link.base_rtt + _queue / _link.capacity) * 1e6f), _now});
+			}
+
+			const float delivered = fminf(_queue, _link.capacity * dt);
+			_queue -= delivered;
+
+			while (!_responses.empty() && _responses.front().time <= _now) {
+				_estimator.rttSample(_now, (_now - _responses.front().request) * 1e-6f);
+				_responses.pop_front();
+			}
+
+			if (_link.radio_status && _now % 1000000 == 0 && !lost()) {
+				_estimator.radioStatus(_now, (unsigned)(100.f * (1.f - _queue / _link.buffer)));
+			}
+
+			_estimator.update(_now);
+
+			if (record) {
+				stats.throughput += delivered;
+				stats.queue_delay += _queue / _link.capacity;
+				stats.budget += _estimator.getBudget();
+				steps++;
+			}
+		}
+
+		if (steps > 0) {
+			stats.throughput /= duration;
+			stats.queue_delay /= steps;
+			stats.budget /= steps;
+			stats.drop_ratio = sent > 0.f ? dropped / sent : 0.f;
+		}
+
+		return stats;
+	}
+
+	/**
+	 * @return time until the budget is below the given rate [s], NAN if not within the duration
+	 */
+	float timeToReach(float rate, float duration)
+	{
+		const uint64_t start = _now;
+
+		while (_now < start + (uint64_t)(duration * 1e6f)) {
+			run(0.1f);
+
+			if (_estimator.getBudget() <= rate) {
+				return (_now - start) * 1e-6f;
+			}
+		}
+
+		return NAN;
+	}
+
+	LinkCapacityEstimator _estimator;
+	Link _link;
+
+private:
+	struct Response {
+		uint64_t time;
+		uint64_t request;
+	};
+
+	bool lost() { return _distribution(_random) < _link.loss; }
+
+	uint64_t _now{0};
+	float _queue{0.f};
+	float _pending_bytes{0.f};
+	std::deque<Response> _responses;
+	std::mt19937 _random{42};
+	std::uniform_real_distribution<float> _distribution{0.f, 1.f};
+};
+
+TEST_F(LinkCapacityEstimatorTest, Startup)
+{
+	// the link has a fifth of the configured rate
+	const Stats startup = run(10.f);
+
+	EXPECT_LT(startup.drop_ratio, 0.02f);
+	EXPECT_GT(_estimator.getBudget(), 0.7f * _link.capacity);
+	EXPECT_LT(_estimator.getBudget(), 1.2f * _link.capacity);
+}
+
+TEST_F(LinkCapacityEstimatorTest, DelayFeedback)
+{
+	run(20.f, 1e6f, false);
+	const Stats stats = run(60.f);
+
+	EXPECT_GT(stats.throughput, 0.9f * _link.capacity);
+	EXPECT_LT(stats.queue_delay, TARGET_DELAY);
+	EXPECT_LT(stats.budget, 1.1f * _link.capacity);
+	EXPECT_FLOAT_EQ(stats.drop_ratio, 0.f);
+	EXPECT_NEAR(_estimator.getCapacity(), _link.capacity, 0.1f * _link.capacity);
+	EXPECT_NEAR(_estimator.getRtt(), _link.base_rtt + stats.queue_delay, 0.1f);
+}
+
+TEST_F(LinkCapacityEstimatorTest, CapacityDrop)
+{
+	// a buffer of 2 seconds, which drops data once full
+	_link.buffer = 2.f * _link.capacity;
+	run(20.f, 1e6f, false);
+
+	// above the minimum budget, such that the queue can drain
+	_link.capacity = 800.f;
+	EXPECT_LT(timeToReach(1.2f * _link.capacity, 30.f), 10.f);
+
+	run(20.f, 1e6f, false);
+	const Stats stats = run(60.f);
+
+	EXPECT_GT(stats.throughput, 0.9f * _link.capacity);
+	EXPECT_LT(stats.queue_delay, 2.f * TARGET_DELAY);
+}
+
+TEST_F(LinkCapacityEstimatorTest, RadioStatusOnly)
+{
+	_link.rtt = false;
+	_link.radio_status = true;
+	_link.buffer = 2000.f;
+
+	run(30.f, 1e6f, false);
+	const Stats stats = run(60.f);
+
+	EXPECT_GT(stats.throughput, 0.7f * _link.capacity);
+	EXPECT_LT(stats.drop_ratio, 0.02f);
+	EXPECT_FLOAT_EQ(_estimator.getQueueDelay(), 0.f);
+}
+
+TEST_F(LinkCapacityEstimatorTest, TransmitErrors)
+{
+	// UART without flow control and without feedback from the other end
+	_link.rtt = false;
+	_link.tx_errors = true;
+	_link.buffer = 300.f;
+
+	run(30.f, 1e6f, false);
+	const Stats stats = run(60.f);
+
+	EXPECT_GT(stats.throughput, 0.7f * _link.capacity);
+	EXPECT_LT(stats.drop_ratio, 0.1f);
+}
+
+TEST_F(LinkCapacityEstimatorTest, LossyLink)
+{
+	// lost responses do not indicate congestion
+	_link.loss = 0.2f;
+	_link.radio_status = true;
+
+	run(30.f, 1e6f, false);
+	const Stats stats = run(60.f);
+
+	EXPECT_GT(stats.throughput, 0.75f * _link.capacity);
+	EXPECT_LT(stats.queue_delay, 3.f * TARGET_DELAY);
+}
+
+TEST_F(LinkCapacityEstimatorTest, CapacityIncrease)
+{
+	run(40.f, 1e6f, false);
+	EXPECT_LT(_estimator.getBudget(), 1.2f * _link.capacity);
+
+	_link.capacity = 6000.f;
+	run(30.f, 1e6f, false);
+	const Stats stats = run(20.f);
+
+	EXPECT_GT(stats.throughput, 0.75f * _link.capacity);
+	EXPECT_LT(stats.queue_delay, 2.f * TARGET_DELAY);
+}
+
+TEST_F(LinkCapacityEstimatorTest, NoCongestion)
+{
+	_link.capacity = 2.f * MAX_RATE;
+	_link.radio_status = true;
+
+	const Stats stats = run(30.f);
+
+	EXPECT_FLOAT_EQ(_estimator.getBudget(), MAX_RATE);
+	EXPECT_FLOAT_EQ(stats.drop_ratio, 0.f);
+	EXPECT_FALSE(_estimator.isCongested());
+}
+
+TEST_F(LinkCapacityEstimatorTest, ApplicationLimited)
+{
+	run(30.f, 1e6f, false);
+	const float budget = _estimator.getBudget();
+	EXPECT_LT(budget, 1.2f * _link.capacity);
+
+	// no feedback about the capacity while the budget is not used
+	_link.capacity = MAX_RATE;
+	run(30.f, 0.3f * budget, false);
+	EXPECT_LT(_estimator.getBudget(), 1.1f * budget);
+
+	run(30.f, 1e6f, false);
+	EXPECT_GT(_estimator.getBudget(), 0.8f * MAX_RATE);
+}
+
+TEST_F(LinkCapacityEstimatorTest, Reset)
+{
+	const float initial_budget = _estimator.getBudget();
+	EXPECT_LT(initial_budget, MAX_RATE);
+
+	run(30.f, 1e6f, false);
+	EXPECT_GT(_estimator.getCapacity(), 0.f);
+
+	_estimator.reset();
+	EXPECT_FLOAT_EQ(_estimator.getBudget(), initial_budget);
+	EXPECT_FLOAT_EQ(_estimator.getCapacity(), 0.f);
+	EXPECT_FLOAT_EQ(_estimator.getRtt(), 0.f);
+}
@@ -1519,6 +1519,56 @@ Mavlink::update_rate_mult()
 		mavlink_ulog_streaming_rate_inv = 1.0f - _mavlink_ulog->current_data_rate();
 	}
 
+	// check for RADIO_STATUS timeout and reset
+	if (_radio_status_available && hrt_elapsed_time(&_rstatus.timestamp) > 5_s) {
+		PX4_ERR("instance %d: RADIO_STATUS timeout", _instance_id);
+		set_telemetry_status_type(telemetry_status_s::LINK_TYPE_GENERIC);
+
+		_radio_status_available = false;
+		_radio_status_critical = false;
+		_radio_status_mult = 1.0f;
+	}
+
+	const bool link_capacity_was_active = _link_capacity_active;
+	_link_capacity_active = link_capacity_adaptation();
+
+	if (_link_capacity_active != link_capacity_was_active) {
+		update_link_capacity_timesync();
+	}
+
+	if (_link_capacity_active) {
+		/* send as much as the link delivers without building up a queue */
+		const hrt_abstime now = hrt_absolute_time();
+
+		_link_capacity.setMaxRate(_datarate);
+		_link_capacity.setMinRate(0.05f * _datarate);
+		_link_capacity.setTargetDelay(_param_mav_tx_delay.get());
+
+		if (!link_capacity_was_active) {
+			/* start again from the startup budget, e.g. when a radio appears */
+			_link_capacity.reset();
+		}
+
+		const uint32_t rtt_us = _round_trip_time_us.fetch_and(0);
+
+		if (rtt_us > 0) {
+			_link_capacity.rttSample(now, rtt_us * 1e-6f);
+		}
+
+		if (_radio_status_available && _rstatus.timestamp != _link_capacity_radio_status) {
+			_link_capacity.radioStatus(_rstatus.timestamp, _rstatus.txbuf);
+			_link_capacity_radio_status = _rstatus.timestamp;
+		}
+
+		_link_capacity.update(now);
+
+		_rate_mult = (_link_capacity.getBudget() * mavlink_ulog_streaming_rate_inv - const_rate) / rate;
+
+		/* ensure the rate multiplier never drops below 5% so that something is always sent */
+		_rate_mult = math::constrain(_rate_mult, 0.05f, 1.0f);
+		return;
+	}
+
 	/* scale up and down as the link permits */
 	float bandwidth_mult = (float)(_datarate * mavlink_ulog_streaming_rate_inv - const_rate) / rate;
 
@@ -1534,17 +1584,6 @@ Mavlink::update_rate_mult()
 		hardware_mult = (_tstatus.rate_tx) / (_tstatus.rate_tx + _tstatus.rate_txerr);
 
 	} else if (_radio_status_available) {
-
-		// check for RADIO_STATUS timeout and reset
-		if (hrt_elapsed_time(&_rstatus.timestamp) > 5_s) {
-			PX4_ERR("instance %d: RADIO_STATUS timeout", _instance_id);
-			set_telemetry_status_type(telemetry_status_s::LINK_TYPE_GENERIC);
-
-			_radio_status_available = false;
-			_radio_status_critical = false;
-			_radio_status_mult = 1.0f;
-		}
-
 		hardware_mult *= _radio_status_mult;
 	}
 
@@ -1555,6 +1594,40 @@ Mavlink::update_rate_mult()
 	_rate_mult = math::constrain(_rate_mult, 0.05f, 1.0f);
 }
 
+bool
+Mavlink::link_capacity_adaptation() const
+{
+	switch (_param_mav_tx_adapt.get()) {
+	case 1:
+		return _radio_status_available;
+
+	case 2:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+void
+Mavlink::update_link_capacity_timesync()
+{
+	if (_link_capacity_active) {
+		for (const auto &stream : _streams) {
+			if (strcmp(stream->get_name(), "TIMESYNC") == 0) {
+				return;
+			}
+		}
+
+		/* a low rate is enough, each reply is one RTT sample */
+		_link_capacity_timesync = (configure_stream("TIMESYNC", 1.0f) == OK);
+
+	} else if (_link_capacity_timesync) {
+		configure_stream("TIMESYNC", 0.0f);
+		_link_capacity_timesync = false;
+	}
+}
+
 void
 Mavlink::update_radio_status(const radio_status_s &radio_status)
 {
@@ -2604,6 +2677,10 @@ void Mavlink::publish_telemetry_status()
 	_tstatus.mode = _mode;
 	_tstatus.data_rate = _datarate;
 	_tstatus.rate_multiplier = _rate_mult;
+	_tstatus.tx_budget = _link_capacity_active ? _link_capacity.getBudget() : 0.f;
+	_tstatus.link_capacity = _link_capacity.getCapacity();
+	_tstatus.queue_delay = _link_capacity.getQueueDelay();
+	_tstatus.round_trip_time = _link_capacity.getRtt();
 	_tstatus.flow_control = get_flow_control_enabled();
 	_tstatus.ftp = ftp_enabled();
 	_tstatus.forwarding = get_forwarding_on();
@@ -2794,6 +2871,15 @@ Mavlink::display_status()
 	printf("\t  txerr: %.3f kB/s\n", (double)_tstatus.rate_txerr);
 	printf("\t  tx rate mult: %.3f\n", (double)_rate_mult);
 	printf("\t  tx rate max: %i B/s\n", _datarate);
+
+	if (_link_capacity_active) {
+		printf("\t  tx budget: %.0f B/s%s\n", (double)_link_capacity.getBudget(),
+		       _link_capacity.isCongested() ? " (congested)" : "");
+		printf("\t  link capacity: %.0f B/s, queueing delay: %.0f ms, RTT: %.0f ms\n",
+		       (double)_link_capacity.getCapacity(), (double)_link_capacity.getQueueDelay() * 1e3,
+		       (double)_link_capacity.getRtt() * 1e3);
+	}
+
 	printf("\t  rx: %.3f kB/s\n", (double)_tstatus.rate_rx);
 
 	if (_mavlink_ulog) {
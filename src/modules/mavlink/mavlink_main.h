@@ -69,6 +69,7 @@
 #include <px4_module.h>
 #include <px4_module_params.h>
 #include <px4_posix.h>
+#include <px4_atomic.h>
 #include <systemlib/mavlink_log.h>
 #include <systemlib/uthash/utlist.h>
 #include <uORB/PublicationQueued.hpp>
@@ -77,6 +78,7 @@
 #include <uORB/topics/radio_status.h>
 #include <uORB/topics/telemetry_status.h>
 
+#include "LinkCapacityEstimator/LinkCapacityEstimator.hpp"
 #include "mavlink_command_sender.h"
 #include "mavlink_messages.h"
 #include "mavlink_orb_subscription.h"
@@ -429,12 +431,12 @@ public:
 	/**
 	 * Count transmitted bytes
 	 */
-	void			count_txbytes(unsigned n) { _bytes_tx += n; };
+	void			count_txbytes(unsigned n) { _bytes_tx += n; _link_capacity.txBytes(n); };
 
 	/**
 	 * Count bytes not transmitted because of errors
 	 */
-	void			count_txerrbytes(unsigned n) { _bytes_txerr += n; };
+	void			count_txerrbytes(unsigned n) { _bytes_txerr += n; _link_capacity.txErrorBytes(n); };
 
 	/**
 	 * Count received bytes
@@ -450,6 +452,12 @@ public:
 
 	void			update_radio_status(const radio_status_s &radio_status);
 
+	/**
+	 * Round trip time of a request/response pair (TIMESYNC), used for the link capacity estimation
+	 * @param rtt_us round trip time [us]
+	 */
+	void			update_round_trip_time(uint64_t rtt_us) { _round_trip_time_us.store(rtt_us < UINT32_MAX ? rtt_us : UINT32_MAX); }
+
 	ringbuffer::RingBuffer	*get_logbuffer() { return &_logbuffer; }
 
 	unsigned		get_system_type() { return _param_mav_type.get(); }
@@ -594,6 +602,12 @@ private:
 	bool			_radio_status_critical{false};
 	float			_radio_status_mult{1.0f};
 
+	LinkCapacityEstimator	_link_capacity;
+	px4::atomic<uint32_t>	_round_trip_time_us{0};	///< latest round trip time sample from the receive thread, 0 if consumed
+	hrt_abstime		_link_capacity_radio_status{0};	///< timestamp of the last RADIO_STATUS passed to _link_capacity
+	bool			_link_capacity_active{false};	///< the send budget of _link_capacity limits the rate
+	bool			_link_capacity_timesync{false};	///< the TIMESYNC stream was added for the RTT samples of _link_capacity
+
 	/**
 	 * If the queue index is not at 0, the queue sending
 	 * logic will send parameters from the current index
@@ -672,6 +686,8 @@ private:
 		(ParamBool<px4::params::MAV_HASH_CHK_EN>) _param_mav_hash_chk_en,
 		(ParamBool<px4::params::MAV_HB_FORW_EN>) _param_mav_hb_forw_en,
 		(ParamBool<px4::params::MAV_ODOM_LP>) _param_mav_odom_lp,
+		(ParamInt<px4::params::MAV_TX_ADAPT>) _param_mav_tx_adapt,
+		(ParamFloat<px4::params::MAV_TX_DELAY>) _param_mav_tx_delay,
 		(ParamInt<px4::params::SYS_HITL>) _param_sys_hitl
 	)
 
@@ -733,10 +749,22 @@ private:
 	void check_radio_config();
 
 	/**
-	 * Update rate mult so total bitrate will be equal to _datarate.
+	 * Update rate mult so total bitrate will be equal to _datarate,
+	 * or to the send budget of the link capacity estimation (MAV_TX_ADAPT).
 	 */
 	void update_rate_mult();
 
+	/**
+	 * @return true if the rate follows the link capacity estimation on this link (MAV_TX_ADAPT)
+	 */
+	bool link_capacity_adaptation() const;
+
+	/**
+	 * Make sure that TIMESYNC is streamed while the link capacity is estimated, its replies are the RTT samples.
+	 * An already configured TIMESYNC stream is kept, the added one is removed again once the adaptation stops.
+	 */
+	void update_link_capacity_timesync();
+
 #if defined(MAVLINK_UDP)
 	void find_broadcast_address();
 
@@ -130,6 +130,20 @@ PARAM_DEFINE_INT32(MAV_USEHILGPS, 0);
  */
 PARAM_DEFINE_INT32(MAV_FWDEXTSP, 1);
 
+/**
+ * Timestamped offboard trajectory
+ *
+ * If set to 1 the time_boot_ms field of incoming SET_POSITION_TARGET_LOCAL_NED messages
+ * is interpreted as the time (in the sender's time base) at which the setpoint has to be reached.
+ * The setpoints are buffered and interpolated onboard, which allows streaming a horizon
+ * of future setpoints that is tolerant to link latency and message loss.
+ * Requires time synchronization with the sender (TIMESYNC).
+ *
+ * @boolean
+ * @group MAVLink
+ */
+PARAM_DEFINE_INT32(MAV_OFFB_HRZN, 0);
+
 /**
  * Broadcast heartbeats on local network
  *
@@ -175,3 +189,36 @@ PARAM_DEFINE_INT32(MAV_HB_FORW_EN, 1);
  * @group MAVLink
  */
 PARAM_DEFINE_INT32(MAV_ODOM_LP, 0);
+
+/**
+ * Adapt the transmit rate to the link capacity.
+ *
+ * If enabled, the stream rates are scaled to a send budget that follows the estimated
+ * capacity of the link instead of the configured data rate. The estimation uses the
+ * round trip time of TIMESYNC, RADIO_STATUS and transmit errors. TIMESYNC is streamed
+ * at 1 Hz on the adapted links that do not stream it already. The configured data
+ * rate is the maximum. The budget starts low and grows while the link delivers.
+ *
+ * Radio links are the links on which a radio reports RADIO_STATUS.
+ *
+ * @value 0 Disabled
+ * @value 1 Radio links
+ * @value 2 All links
+ * @group MAVLink
+ */
+PARAM_DEFINE_INT32(MAV_TX_ADAPT, 0);
+
+/**
+ * Target queueing delay of the transmit rate adaptation.
+ *
+ * The link is considered congested if the round trip time exceeds its minimum
+ * by more than this.
+ *
+ * @unit s
+ * @min 0.02
+ * @max 2.0
+ * @decimal 2
+ * @increment 0.01
+ * @group MAVLink
+ */
+PARAM_DEFINE_FLOAT(MAV_TX_DELAY, 0.1f);
@@ -888,6 +888,34 @@ MavlinkReceiver::handle_message_set_position_target_local_ned(mavlink_message_t
 
 					//XXX handle global pos setpoints (different MAV frames)
 					_pos_sp_triplet_pub.publish(pos_sp_triplet);
+
+					/* timestamped setpoints are additionally buffered by the offboard flight task */
+					if (_param_mav_offb_hrzn.get() && _mavlink_timesync.sync_converged()
+					    && pos_sp_triplet.current.type == position_setpoint_s::SETPOINT_TYPE_POSITION
+					    && pos_sp_triplet.current.position_valid && pos_sp_triplet.current.alt_valid
+					    && pos_sp_triplet.current.velocity_valid
+					    && set_position_target_local_ned.coordinate_frame == MAV_FRAME_LOCAL_NED) {
+
+						offboard_trajectory_sample_s sample{};
+
+						sample.sample_time = _mavlink_timesync.sync_stamp((uint64_t)set_position_target_local_ned.time_boot_ms * 1000);
+						sample.position[0] = set_position_target_local_ned.x;
+						sample.position[1] = set_position_target_local_ned.y;
+						sample.position[2] = set_position_target_local_ned.z;
+						sample.velocity[0] = set_position_target_local_ned.vx;
+						sample.velocity[1] = set_position_target_local_ned.vy;
+						sample.velocity[2] = set_position_target_local_ned.vz;
+
+						const bool acceleration_valid = pos_sp_triplet.current.acceleration_valid && !is_force_sp;
+						sample.acceleration[0] = acceleration_valid ? set_position_target_local_ned.afx : NAN;
+						sample.acceleration[1] = acceleration_valid ? set_position_target_local_ned.afy : NAN;
+						sample.acceleration[2] = acceleration_valid ? set_position_target_local_ned.afz : NAN;
+
+						sample.yaw = pos_sp_triplet.current.yaw_valid ? set_position_target_local_ned.yaw : NAN;
+
+						sample.timestamp = hrt_absolute_time();
+						_offboard_trajectory_sample_pub.publish(sample);
+					}
 				}
 			}
 		}
@@ -1585,6 +1613,11 @@ MavlinkReceiver::handle_message_battery_status(mavlink_message_t *msg)
 	battery_status.current_a = battery_status.current_filtered_a = (float)(battery_mavlink.current_battery) / 100.0f;
 	battery_status.current_filtered_a = battery_status.current_a;
 	battery_status.remaining = (float)battery_mavlink.battery_remaining / 100.0f;
+	battery_status.remaining_std = NAN;
+	battery_status.internal_resistance = NAN;
+	battery_status.time_remaining_s = NAN;
+	battery_status.time_remaining_std_s = NAN;
+	battery_status.energy_remaining_wh = NAN;
 	battery_status.discharged_mah = (float)battery_mavlink.current_consumed;
 	battery_status.cell_count = cell_count;
 	battery_status.connected = true;
@@ -2083,6 +2116,11 @@ MavlinkReceiver::handle_message_hil_sensor(mavlink_message_t *msg)
 		hil_battery_status.voltage_filtered_v = 11.5f;
 		hil_battery_status.current_a = 10.0f;
 		hil_battery_status.discharged_mah = -1.0f;
+		hil_battery_status.remaining_std = NAN;
+		hil_battery_status.internal_resistance = NAN;
+		hil_battery_status.time_remaining_s = NAN;
+		hil_battery_status.time_remaining_std_s = NAN;
+		hil_battery_status.energy_remaining_wh = NAN;
 
 		_battery_pub.publish(hil_battery_status);
 	}
@@ -2138,6 +2176,10 @@ MavlinkReceiver::handle_message_follow_target(mavlink_message_t *msg)
 	follow_target_topic.lat = follow_target_msg.lat * 1e-7;
 	follow_target_topic.lon = follow_target_msg.lon * 1e-7;
 	follow_target_topic.alt = follow_target_msg.alt;
+	follow_target_topic.vx = follow_target_msg.vel[0];
+	follow_target_topic.vy = follow_target_msg.vel[1];
+	follow_target_topic.vz = follow_target_msg.vel[2];
+	follow_target_topic.est_cap = follow_target_msg.est_capabilities;
 
 	_follow_target_pub.publish(follow_target_topic);
 }
@@ -2158,6 +2200,21 @@ MavlinkReceiver::handle_message_landing_target(mavlink_message_t *msg)
 		landing_target_pose.z_abs = landing_target.z;
 
 		_landing_target_pose_pub.publish(landing_target_pose);
+
+	} else if (landing_target.position_valid && landing_target.frame == MAV_FRAME_BODY_FRD) {
+		// relative measurement, fused by the landing target estimator
+		landing_target_measurement_s landing_target_measurement{};
+
+		landing_target_measurement.timestamp_sample = _mavlink_timesync.sync_stamp(landing_target.time_usec);
+		landing_target_measurement.type = landing_target_measurement_s::TYPE_POSITION;
+		landing_target_measurement.target_id = landing_target.target_num;
+		landing_target_measurement.value[0] = landing_target.x;
+		landing_target_measurement.value[1] = landing_target.y;
+		landing_target_measurement.value[2] = landing_target.z;
+		landing_target_measurement.variance = NAN;
+		landing_target_measurement.timestamp = hrt_absolute_time();
+
+		_landing_target_measurement_pub.publish(landing_target_measurement);
 	}
 }
 
@@ -2440,6 +2497,11 @@ MavlinkReceiver::handle_message_hil_state_quaternion(mavlink_message_t *msg)
 		hil_battery_status.voltage_filtered_v = 11.1f;
 		hil_battery_status.current_a = 10.0f;
 		hil_battery_status.discharged_mah = -1.0f;
+		hil_battery_status.remaining_std = NAN;
+		hil_battery_status.internal_resistance = NAN;
+		hil_battery_status.time_remaining_s = NAN;
+		hil_battery_status.time_remaining_std_s = NAN;
+		hil_battery_status.energy_remaining_wh = NAN;
 
 		_battery_pub.publish(hil_battery_status);
 	}
@@ -79,6 +79,8 @@ MavlinkTimesync::handle_message(const mavlink_message_t *msg)
 				// Calculate the round trip time (RTT) it took the timesync packet to bounce back to us from remote system
 				uint64_t rtt_us = now - (tsync.ts1 / 1000ULL);
 
+				_mavlink->update_round_trip_time(rtt_us);
+
 				// Calculate the difference of this sample from the current estimate
 				uint64_t deviation = llabs((int64_t)_time_offset - offset_us);
 
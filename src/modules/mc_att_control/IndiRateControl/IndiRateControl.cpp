@@ -0,0 +1,145 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file IndiRateControl.cpp
+ */
+
+#include <IndiRateControl.hpp>
+#include <px4_defines.h>
+
+using namespace matrix;
+
+void IndiRateControl::setFilterCutoff(const float loop_rate, const float cutoff, const bool force)
+{
+	// only do expensive filter update if the cutoff changed
+	if (force || fabsf(_lp_filter_rate.get_cutoff_freq() - cutoff) > 0.01f) {
+		_lp_filter_rate.set_cutoff_frequency(loop_rate, cutoff);
+		_lp_filter_torque.set_cutoff_frequency(loop_rate, cutoff);
+		_lp_filter_rate.reset(_rate_filtered_prev);
+		_torque_actuator_filtered_prev = _lp_filter_torque.reset(_torque_actuator);
+	}
+}
+
+void IndiRateControl::setSaturationStatus(const MultirotorMixer::saturation_status &status)
+{
+	_mixer_saturation_positive[0] = status.flags.roll_pos;
+	_mixer_saturation_positive[1] = status.flags.pitch_pos;
+	_mixer_saturation_positive[2] = status.flags.yaw_pos;
+	_mixer_saturation_negative[0] = status.flags.roll_neg;
+	_mixer_saturation_negative[1] = status.flags.pitch_neg;
+	_mixer_saturation_negative[2] = status.flags.yaw_neg;
+}
+
+void IndiRateControl::reset(const Vector3f &torque)
+{
+	_torque_sp = torque;
+	_torque_actuator = torque;
+	_torque_actuator_filtered_prev = _lp_filter_torque.reset(torque);
+	_disturbance_torque.zero();
+	_initialized = false;
+}
+
+Vector3f IndiRateControl::update(const Vector3f &rate, const Vector3f &rate_sp, const float dt, const bool landed)
+{
+	if (!_initialized) {
+		_rate_filtered_prev = _lp_filter_rate.reset(rate);
+		_initialized = true;
+	}
+
+	// first order model of the actuator response to the previous command
+	if (_actuator_time_constant > FLT_EPSILON && dt > FLT_EPSILON) {
+		_torque_actuator += (_torque_sp - _torque_actuator) * (dt / (_actuator_time_constant + dt));
+
+	} else {
+		_torque_actuator = _torque_sp;
+	}
+
+	// filter angular rate and actuator torque identically to keep them synchronized
+	const Vector3f rate_filtered(_lp_filter_rate.apply(rate));
+	const Vector3f torque_actuator_filtered(_lp_filter_torque.apply(_torque_actuator));
+
+	Vector3f rate_dot;
+
+	if (dt > FLT_EPSILON) {
+		rate_dot = (rate_filtered - _rate_filtered_prev) / dt;
+	}
+
+	// the finite difference is centered between the two samples, so is the actuator torque
+	const Vector3f torque_actuator_sync = (torque_actuator_filtered + _torque_actuator_filtered_prev) * 0.5f;
+
+	_rate_filtered_prev = rate_filtered;
+	_torque_actuator_filtered_prev = torque_actuator_filtered;
+
+	// desired angular acceleration
+	const Vector3f rate_dot_sp = _gain_k.emult(rate_sp - rate);
+
+	Vector3f torque;
+
+	for (int i = 0; i < 3; i++) {
+		const float effectiveness = math::max(_effectiveness(i), FLT_EPSILON);
+
+		if (landed) {
+			// the ground produces the moments, there is nothing to compensate
+			_disturbance_torque(i) = 0.f;
+
+		} else {
+			_disturbance_torque(i) = torque_actuator_sync(i) - rate_dot(i) / effectiveness;
+		}
+
+		torque(i) = rate_dot_sp(i) / effectiveness + _disturbance_torque(i);
+
+		// the increment cannot be produced in the saturated direction
+		if (_mixer_saturation_positive[i]) {
+			torque(i) = math::min(torque(i), _torque_sp(i));
+		}
+
+		if (_mixer_saturation_negative[i]) {
+			torque(i) = math::max(torque(i), _torque_sp(i));
+		}
+
+		// do not propagate the result if invalid
+		if (PX4_ISFINITE(torque(i))) {
+			_torque_sp(i) = math::constrain(torque(i), -1.f, 1.f);
+		}
+	}
+
+	return _torque_sp;
+}
+
+void IndiRateControl::getRateControlStatus(rate_ctrl_status_s &rate_ctrl_status)
+{
+	rate_ctrl_status.rollspeed_integ = _disturbance_torque(0);
+	rate_ctrl_status.pitchspeed_integ = _disturbance_torque(1);
+	rate_ctrl_status.yawspeed_integ = _disturbance_torque(2);
+}
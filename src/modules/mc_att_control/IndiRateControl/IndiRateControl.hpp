@@ -0,0 +1,140 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file IndiRateControl.hpp
+ *
+ * Incremental nonlinear dynamic inversion (INDI) 3 axis angular rate control.
+ *
+ * Instead of a model of all the moments acting on the vehicle, INDI uses the measured
+ * angular acceleration together with the actuator state that produced it:
+ *
+ * torque = torque_act + G^-1 * (K * (rate_sp - rate) - rate_dot)
+ *
+ * where G is the control effectiveness (angular acceleration per unit of normalized torque)
+ * and torque_act the torque command delayed by the actuator dynamics. Both the angular
+ * acceleration and the actuator torque are low-pass filtered with the same filter such that
+ * they are synchronized. Unmodelled moments (gusts, payload swing, center of gravity offset)
+ * are rejected at the bandwidth of that filter instead of through a slow integrator.
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+#include <mathlib/math/filter/LowPassFilter2pVector3f.hpp>
+
+#include <lib/mixer/mixer.h>
+#include <uORB/topics/rate_ctrl_status.h>
+
+class IndiRateControl
+{
+public:
+	IndiRateControl() = default;
+	~IndiRateControl() = default;
+
+	/**
+	 * Set the rate error gains
+	 * @param K 3D vector of gains from rate error to desired angular acceleration for body x,y,z axis [1/s]
+	 */
+	void setGains(const matrix::Vector3f &K) { _gain_k = K; }
+
+	/**
+	 * Set the control effectiveness
+	 * @param G 3D vector of angular accelerations produced by a unit normalized torque for body x,y,z axis [rad/s^2]
+	 */
+	void setControlEffectiveness(const matrix::Vector3f &G) { _effectiveness = G; }
+
+	/**
+	 * Set the time constant of the first order actuator model
+	 * @param time_constant [s] 0 if the actuators are assumed to react instantly
+	 */
+	void setActuatorTimeConstant(const float time_constant) { _actuator_time_constant = time_constant; }
+
+	/**
+	 * Set update frequency and low-pass filter cutoff that is applied to the angular acceleration and actuator state
+	 * @param loop_rate [Hz] rate with which update function is called
+	 * @param cutoff [Hz] cutoff frequency of the low-pass filters
+	 * @param force flag to force an expensive update even if the cutoff didn't change
+	 */
+	void setFilterCutoff(const float loop_rate, const float cutoff, const bool force);
+
+	/**
+	 * Set saturation status
+	 * @param status message from mixer reporting about saturation
+	 */
+	void setSaturationStatus(const MultirotorMixer::saturation_status &status);
+
+	/**
+	 * Run one control loop cycle calculation
+	 * @param rate estimation of the current vehicle angular rate
+	 * @param rate_sp desired vehicle angular rate setpoint
+	 * @param dt time since the last update
+	 * @param landed if true, no increments are accumulated since the ground reacts to any torque
+	 * @return [-1,1] normalized torque vector to apply to the vehicle
+	 */
+	matrix::Vector3f update(const matrix::Vector3f &rate, const matrix::Vector3f &rate_sp, const float dt,
+				const bool landed);
+
+	/**
+	 * Reset the actuator state, e.g. when switching from another controller
+	 * @param torque normalized torque that is currently applied
+	 */
+	void reset(const matrix::Vector3f &torque = matrix::Vector3f());
+
+	/**
+	 * Get status message of controller for logging/debugging
+	 * The torque used to compensate for unmodelled moments is reported in place of the integrator.
+	 * @param rate_ctrl_status status message to fill with internal states
+	 */
+	void getRateControlStatus(rate_ctrl_status_s &rate_ctrl_status);
+
+private:
+	// Parameters
+	matrix::Vector3f _gain_k; ///< rate error to desired angular acceleration gain [1/s]
+	matrix::Vector3f _effectiveness; ///< angular acceleration per normalized torque [rad/s^2]
+	float _actuator_time_constant{0.f}; ///< [s]
+
+	// States
+	matrix::Vector3f _torque_sp; ///< last commanded normalized torque
+	matrix::Vector3f _torque_actuator; ///< modelled torque produced by the actuators
+	matrix::Vector3f _torque_actuator_filtered_prev; ///< filtered actuator torque of previous update
+	matrix::Vector3f _rate_filtered_prev; ///< filtered angular rate of previous update
+	matrix::Vector3f _disturbance_torque; ///< torque compensating the unmodelled moments
+	bool _initialized{false};
+
+	math::LowPassFilter2pVector3f _lp_filter_rate{0.f, 0.f}; ///< low-pass filter for the angular rate
+	math::LowPassFilter2pVector3f _lp_filter_torque{0.f, 0.f}; ///< same filter on the actuator torque
+
+	bool _mixer_saturation_positive[3] {};
+	bool _mixer_saturation_negative[3] {};
+};
@@ -0,0 +1,268 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Test code for the INDI rate control library
+ * Run this test only using make tests TESTFILTER=IndiRateControl
+ */
+
+#include <gtest/gtest.h>
+#include <IndiRateControl.hpp>
+#include <RateControl.hpp>
+#include <px4_defines.h>
+
+#include <chrono>
+
+using namespace matrix;
+
+/**
+ * Rigid body with first order actuator dynamics, driven by normalized torque
+ */
+class RigidBodyPlant
+{
+public:
+	/**
+	 * Propagate the plant
+	 * @param torque_sp normalized torque command
+	 * @param disturbance external moment [Nm]
+	 * @param dt [s]
+	 */
+	void step(const Vector3f &torque_sp, const Vector3f &disturbance, float dt)
+	{
+		const int substeps = 4;
+		const float h = dt / substeps;
+
+		for (int i = 0; i < substeps; i++) {
+			for (int j = 0; j < 3; j++) {
+				torque_actuator(j) += (math::constrain(torque_sp(j), -1.f, 1.f) - torque_actuator(j)) * h / actuator_time_constant;
+			}
+
+			const Vector3f moment = torque_actuator.emult(torque_max) + disturbance;
+			const Vector3f J_rate = inertia.emult(rate);
+			rate_dot = (moment - rate.cross(J_rate)).edivide(inertia);
+			rate += rate_dot * h;
+		}
+	}
+
+	/** angular acceleration per normalized torque [rad/s^2] */
+	Vector3f effectiveness() const { return torque_max.edivide(inertia); }
+
+	Vector3f inertia{0.03f, 0.03f, 0.05f}; ///< [kg m^2]
+	Vector3f torque_max{1.8f, 1.8f, 0.4f}; ///< [Nm]
+	float actuator_time_constant{0.03f}; ///< [s]
+
+	Vector3f rate;
+	Vector3f rate_dot;
+	Vector3f torque_actuator;
+};
+
+class IndiRateControlTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		_indi.setGains(Vector3f(20.f, 20.f, 8.f));
+		_indi.setControlEffectiveness(_plant.effectiveness());
+		_indi.setActuatorTimeConstant(_plant.actuator_time_constant);
+		_indi.setFilterCutoff(1.f / _dt, 30.f, true);
+
+		// default PX4 rate gains
+		_pid.setGains(Vector3f(0.15f, 0.15f, 0.2f), Vector3f(0.2f, 0.2f, 0.1f), Vector3f(0.003f, 0.003f, 0.f));
+		_pid.setIntegratorLimit(Vector3f(0.3f, 0.3f, 0.3f));
+		_pid.setDTermCutoff(1.f / _dt, 30.f, true);
+		_pid.setFeedForwardGain(Vector3f());
+	}
+
+	/** Deterministic pseudo random number with zero mean in [-1, 1) */
+	float random()
+	{
+		_seed = 1103515245u * _seed + 12345u;
+		return (float)((_seed >> 8) & 0xFFFF) / 32768.f - 1.f;
+	}
+
+	/** Moments from a gust (step) and a swinging payload (sinusoid) */
+	static Vector3f disturbance(float t)
+	{
+		Vector3f moment;
+
+		if (t > 1.f) {
+			moment += Vector3f(0.3f, -0.2f, 0.05f);
+		}
+
+		if (t > 3.f) {
+			moment += Vector3f(0.25f * sinf(2.f * M_PI_F * 1.5f * t), 0.25f * cosf(2.f * M_PI_F * 1.5f * t), 0.f);
+		}
+
+		return moment;
+	}
+
+	/**
+	 * Hold zero rate against the disturbances
+	 * @return RMS roll and pitch rate error [rad/s]
+	 */
+	template<typename Controller>
+	float holdAgainstDisturbances(Controller &controller, RigidBodyPlant &plant)
+	{
+		float error_squared = 0.f;
+		int n = 0;
+
+		for (float t = 0.f; t < 6.f; t += _dt) {
+			const Vector3f gyro = plant.rate + Vector3f(random(), random(), random()) * 0.01f;
+			const Vector3f torque = controller.update(gyro, Vector3f(), _dt, false);
+			plant.step(torque, disturbance(t), _dt);
+
+			if (t > 1.f) {
+				error_squared += plant.rate(0) * plant.rate(0) + plant.rate(1) * plant.rate(1);
+				n++;
+			}
+		}
+
+		return sqrtf(error_squared / n);
+	}
+
+	/** @return average execution time of one update [us], for information only */
+	template<typename Controller>
+	float measureUpdateTime(Controller &controller)
+	{
+		const int n = 20000;
+		Vector3f sum;
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < n; i++) {
+			const Vector3f rate(0.01f * (i % 7), -0.02f * (i % 5), 0.005f * (i % 3));
+			sum += controller.update(rate, Vector3f(0.1f, 0.f, 0.f), _dt, false);
+		}
+
+		const auto end = std::chrono::steady_clock::now();
+		EXPECT_TRUE(PX4_ISFINITE(sum(0)));
+		return std::chrono::duration<float, std::micro>(end - start).count() / n;
+	}
+
+	IndiRateControl _indi;
+	RateControl _pid;
+	RigidBodyPlant _plant;
+	const float _dt{0.002f}; // 500Hz
+	uint32_t _seed{12345};
+};
+
+TEST_F(IndiRateControlTest, AllZeroCase)
+{
+	Vector3f torque = _indi.update(Vector3f(), Vector3f(), 0.f, false);
+	EXPECT_EQ(torque, Vector3f());
+}
+
+TEST_F(IndiRateControlTest, noIncrementsWhenLanded)
+{
+	// GIVEN: a vehicle on the ground with a rate setpoint it cannot follow
+	Vector3f torque;
+
+	for (int i = 0; i < 1000; i++) {
+		torque = _indi.update(Vector3f(), Vector3f(0.5f, 0.f, 0.f), _dt, true);
+	}
+
+	// THEN: the output is the proportional part only, nothing accumulates
+	EXPECT_NEAR(torque(0), 20.f * 0.5f / _plant.effectiveness()(0), 1e-4f);
+	EXPECT_FLOAT_EQ(torque(1), 0.f);
+}
+
+TEST_F(IndiRateControlTest, tracksRateStep)
+{
+	// WHEN: a roll rate step is commanded
+	for (float t = 0.f; t < 0.5f; t += _dt) {
+		const Vector3f torque = _indi.update(_plant.rate, Vector3f(2.f, 0.f, 0.f), _dt, false);
+		_plant.step(torque, Vector3f(), _dt);
+	}
+
+	// THEN: it is reached without coupling into the other axes
+	EXPECT_NEAR(_plant.rate(0), 2.f, 0.02f);
+	EXPECT_NEAR(_plant.rate(1), 0.f, 0.01f);
+	EXPECT_NEAR(_plant.rate(2), 0.f, 0.01f);
+}
+
+TEST_F(IndiRateControlTest, robustToEffectivenessError)
+{
+	// GIVEN: a control effectiveness off by -40% and +50%
+	for (float scale : {0.6f, 1.5f}) {
+		IndiRateControl indi;
+		indi.setGains(Vector3f(20.f, 20.f, 8.f));
+		indi.setControlEffectiveness(_plant.effectiveness() * scale);
+		indi.setActuatorTimeConstant(_plant.actuator_time_constant);
+		indi.setFilterCutoff(1.f / _dt, 30.f, true);
+		RigidBodyPlant plant;
+
+		// WHEN: holding zero rate against the disturbances
+		const float rms = holdAgainstDisturbances(indi, plant);
+
+		// THEN: the loop stays stable and the moments are still rejected, if slower
+		EXPECT_LT(rms, 0.3f) << "effectiveness scale " << scale;
+		EXPECT_LT(plant.rate.norm(), 0.5f) << "effectiveness scale " << scale;
+	}
+}
+
+TEST_F(IndiRateControlTest, disturbanceRejectionBenchmark)
+{
+	// WHEN: both controllers hold zero rate against a gust and a swinging payload
+	RigidBodyPlant plant_pid;
+	const float rms_pid = holdAgainstDisturbances(_pid, plant_pid);
+	const float rms_indi = holdAgainstDisturbances(_indi, _plant);
+
+	// AND: we measure the execution time of one update, not asserted as it depends on the host
+	const float time_pid = measureUpdateTime(_pid);
+	const float time_indi = measureUpdateTime(_indi);
+
+	printf("RMS rate error: PID %.4f rad/s, INDI %.4f rad/s\n", (double)rms_pid, (double)rms_indi);
+	printf("update time: PID %.3f us, INDI %.3f us\n", (double)time_pid, (double)time_indi);
+
+	// THEN: INDI rejects the disturbances much better
+	EXPECT_LT(rms_indi * 3.f, rms_pid);
+}
+
+TEST_F(IndiRateControlTest, switchToPidIsBumpless)
+{
+	// GIVEN: INDI holding zero rate against the constant gust
+	Vector3f torque;
+	Vector3f gyro;
+
+	for (float t = 0.f; t < 3.f; t += _dt) {
+		gyro = _plant.rate;
+		torque = _indi.update(gyro, Vector3f(), _dt, false);
+		_plant.step(torque, disturbance(t), _dt);
+	}
+
+	// WHEN: the PID controller takes over from the last output
+	_pid.resetIntegral(torque, gyro, Vector3f());
+	const Vector3f torque_pid = _pid.update(_plant.rate, Vector3f(), _dt, false);
+
+	// THEN: its output continues without a jump
+	EXPECT_LT((torque_pid - torque).norm(), 0.02f);
+}
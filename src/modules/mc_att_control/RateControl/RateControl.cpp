@@ -93,6 +93,16 @@ Vector3f RateControl::update(const Vector3f rate, const Vector3f rate_sp, const
 	return torque;
 }
 
+void RateControl::resetIntegral(const Vector3f &torque, const Vector3f &rate, const Vector3f &rate_sp)
+{
+	const Vector3f rate_error = rate_sp - rate;
+	const Vector3f rate_int = torque - _gain_p.emult(rate_error) - _gain_ff.emult(rate_sp);
+
+	for (int i = 0; i < 3; i++) {
+		_rate_int(i) = math::constrain(rate_int(i), -_lim_int(i), _lim_int(i));
+	}
+}
+
 void RateControl::updateIntegral(Vector3f &rate_error, const float dt)
 {
 	for (int i = 0; i < 3; i++) {
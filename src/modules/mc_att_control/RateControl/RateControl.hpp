@@ -101,6 +101,15 @@ public:
 	 */
 	void resetIntegral() { _rate_int.zero(); }
 
+	/**
+	 * Set the integral term such that the output continues from a given torque, e.g. of another controller
+	 * @see _rate_int
+	 * @param torque [-1,1] normalized torque to continue from
+	 * @param rate estimation of the current vehicle angular rate
+	 * @param rate_sp desired vehicle angular rate setpoint
+	 */
+	void resetIntegral(const matrix::Vector3f &torque, const matrix::Vector3f &rate, const matrix::Vector3f &rate_sp);
+
 	/**
 	 * Get status message of controller for logging/debugging
 	 * @param rate_ctrl_status status message to fill with internal states
@@ -64,6 +64,7 @@
 
 #include <AttitudeControl.hpp>
 #include <RateControl.hpp>
+#include <IndiRateControl.hpp>
 
 /**
  * Multicopter attitude control app start / stop handling function
@@ -139,6 +140,8 @@ private:
 
 	AttitudeControl _attitude_control; ///< class for attitude control calculations
 	RateControl _rate_control; ///< class for rate control calculations
+	IndiRateControl _indi_rate_control; ///< class for incremental nonlinear dynamic inversion rate control
+	bool _indi_active{false}; ///< true if the INDI rate controller generates the torque
 
 	uORB::Subscription _v_att_sub{ORB_ID(vehicle_attitude)};			/**< vehicle attitude subscription */
 	uORB::Subscription _v_att_sp_sub{ORB_ID(vehicle_attitude_setpoint)};		/**< vehicle attitude setpoint subscription */
@@ -184,6 +187,8 @@ private:
 	MultirotorMixer::saturation_status _saturation_status{};
 
 	perf_counter_t	_loop_perf;			/**< loop performance counter */
+	perf_counter_t	_rate_control_perf;		/**< PID rate controller update */
+	perf_counter_t	_indi_rate_control_perf;	/**< INDI rate controller update */
 
 	static constexpr const float initial_update_rate_hz = 250.f; /**< loop update rate used for initialization */
 	float _loop_update_rate_hz{initial_update_rate_hz};          /**< current rate-controller loop update rate in [Hz] */
@@ -231,6 +236,16 @@ private:
 
 		(ParamFloat<px4::params::MC_DTERM_CUTOFF>) _param_mc_dterm_cutoff,			/**< Cutoff frequency for the D-term filter */
 
+		(ParamBool<px4::params::MC_INDI_EN>) _param_mc_indi_en,
+		(ParamFloat<px4::params::MC_INDI_R_K>) _param_mc_indi_r_k,
+		(ParamFloat<px4::params::MC_INDI_P_K>) _param_mc_indi_p_k,
+		(ParamFloat<px4::params::MC_INDI_Y_K>) _param_mc_indi_y_k,
+		(ParamFloat<px4::params::MC_INDI_R_EFF>) _param_mc_indi_r_eff,
+		(ParamFloat<px4::params::MC_INDI_P_EFF>) _param_mc_indi_p_eff,
+		(ParamFloat<px4::params::MC_INDI_Y_EFF>) _param_mc_indi_y_eff,
+		(ParamFloat<px4::params::MC_INDI_ACT_TC>) _param_mc_indi_act_tc,		/**< actuator time constant */
+		(ParamFloat<px4::params::MC_INDI_CUTOFF>) _param_mc_indi_cutoff,		/**< Cutoff frequency for the angular acceleration filter */
+
 		(ParamFloat<px4::params::MC_ROLLRATE_MAX>) _param_mc_rollrate_max,
 		(ParamFloat<px4::params::MC_PITCHRATE_MAX>) _param_mc_pitchrate_max,
 		(ParamFloat<px4::params::MC_YAWRATE_MAX>) _param_mc_yawrate_max,
@@ -57,7 +57,9 @@ using namespace matrix;
 MulticopterAttitudeControl::MulticopterAttitudeControl() :
 	ModuleParams(nullptr),
 	WorkItem(MODULE_NAME, px4::wq_configurations::rate_ctrl),
-	_loop_perf(perf_alloc(PC_ELAPSED, "mc_att_control"))
+	_loop_perf(perf_alloc(PC_ELAPSED, "mc_att_control")),
+	_rate_control_perf(perf_alloc(PC_ELAPSED, "mc_att_control: pid")),
+	_indi_rate_control_perf(perf_alloc(PC_ELAPSED, "mc_att_control: indi"))
 {
 	_vehicle_status.vehicle_type = vehicle_status_s::VEHICLE_TYPE_ROTARY_WING;
 
@@ -75,6 +77,8 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 MulticopterAttitudeControl::~MulticopterAttitudeControl()
 {
 	perf_free(_loop_perf);
+	perf_free(_rate_control_perf);
+	perf_free(_indi_rate_control_perf);
 }
 
 bool
@@ -108,6 +112,13 @@ MulticopterAttitudeControl::parameters_updated()
 	_rate_control.setFeedForwardGain(
 		Vector3f(_param_mc_rollrate_ff.get(), _param_mc_pitchrate_ff.get(), _param_mc_yawrate_ff.get()));
 
+	// INDI rate control parameters
+	_indi_rate_control.setGains(Vector3f(_param_mc_indi_r_k.get(), _param_mc_indi_p_k.get(), _param_mc_indi_y_k.get()));
+	_indi_rate_control.setControlEffectiveness(
+		Vector3f(_param_mc_indi_r_eff.get(), _param_mc_indi_p_eff.get(), _param_mc_indi_y_eff.get()));
+	_indi_rate_control.setActuatorTimeConstant(_param_mc_indi_act_tc.get());
+	_indi_rate_control.setFilterCutoff(_loop_update_rate_hz, _param_mc_indi_cutoff.get(), false);
+
 	// angular rate limits
 	using math::radians;
 	_attitude_control.setRateLimit(Vector3f(radians(_param_mc_rollrate_max.get()), radians(_param_mc_pitchrate_max.get()),
@@ -373,11 +384,35 @@ MulticopterAttitudeControl::control_attitude_rates(float dt, const Vector3f &rat
 	// reset integral if disarmed
 	if (!_v_control_mode.flag_armed || _vehicle_status.vehicle_type != vehicle_status_s::VEHICLE_TYPE_ROTARY_WING) {
 		_rate_control.resetIntegral();
+		_indi_rate_control.reset();
+	}
+
+	// switch the rate controller, starting from the current output to avoid a jump
+	if (_param_mc_indi_en.get() != _indi_active) {
+		_indi_active = _param_mc_indi_en.get();
+
+		if (_indi_active) {
+			_indi_rate_control.reset(_att_control);
+
+		} else {
+			_rate_control.resetIntegral(_att_control, rates, _rates_sp);
+		}
 	}
 
 	const bool landed = _vehicle_land_detected.maybe_landed || _vehicle_land_detected.landed;
-	_rate_control.setSaturationStatus(_saturation_status);
-	_att_control = _rate_control.update(rates, _rates_sp, dt, landed);
+
+	if (_indi_active) {
+		perf_begin(_indi_rate_control_perf);
+		_indi_rate_control.setSaturationStatus(_saturation_status);
+		_att_control = _indi_rate_control.update(rates, _rates_sp, dt, landed);
+		perf_end(_indi_rate_control_perf);
+
+	} else {
+		perf_begin(_rate_control_perf);
+		_rate_control.setSaturationStatus(_saturation_status);
+		_att_control = _rate_control.update(rates, _rates_sp, dt, landed);
+		perf_end(_rate_control_perf);
+	}
 }
 
 void
@@ -399,7 +434,12 @@ MulticopterAttitudeControl::publish_rate_controller_status()
 {
 	rate_ctrl_status_s rate_ctrl_status = {};
 	rate_ctrl_status.timestamp = hrt_absolute_time();
-	_rate_control.getRateControlStatus(rate_ctrl_status);
+	if (_indi_active) {
+		_indi_rate_control.getRateControlStatus(rate_ctrl_status);
+
+	} else {
+		_rate_control.getRateControlStatus(rate_ctrl_status);
+	}
 	_controller_status_pub.publish(rate_ctrl_status);
 }
 
@@ -582,6 +622,7 @@ MulticopterAttitudeControl::Run()
 			if (!_vehicle_status.is_vtol) {
 				_rates_sp.zero();
 				_rate_control.resetIntegral();
+				_indi_rate_control.reset();
 				_thrust_sp = 0.0f;
 				_att_control.zero();
 				publish_actuator_controls();
@@ -609,6 +650,7 @@ MulticopterAttitudeControl::Run()
 				_dt_accumulator = 0;
 				_loop_counter = 0;
 				_rate_control.setDTermCutoff(_loop_update_rate_hz, _param_mc_dterm_cutoff.get(), true);
+				_indi_rate_control.setFilterCutoff(_loop_update_rate_hz, _param_mc_indi_cutoff.get(), true);
 			}
 		}
 
@@ -646,6 +688,8 @@ int MulticopterAttitudeControl::print_status()
 	PX4_INFO("Running");
 
 	perf_print_counter(_loop_perf);
+	perf_print_counter(_rate_control_perf);
+	perf_print_counter(_indi_rate_control_perf);
 
 	print_message(_actuators);
 
@@ -519,3 +519,132 @@ PARAM_DEFINE_INT32(MC_BAT_SCALE_EN, 0);
  */
 PARAM_DEFINE_FLOAT(MC_DTERM_CUTOFF, 0.f);
 
+/**
+ * Enable the INDI rate controller
+ *
+ * Replaces the PID rate controller by incremental nonlinear dynamic inversion,
+ * which uses the measured angular acceleration to reject unmodelled moments
+ * (gusts, swinging payloads) without relying on the integrator.
+ * MC_INDI_R_EFF, MC_INDI_P_EFF and MC_INDI_Y_EFF need to be identified for the vehicle.
+ * Can be changed in flight, the switch starts from the current output.
+ *
+ * @boolean
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_INT32(MC_INDI_EN, 0);
+
+/**
+ * INDI roll rate gain
+ *
+ * Desired angular acceleration per unit of roll rate error.
+ *
+ * @unit 1/s
+ * @min 1.0
+ * @max 100.0
+ * @decimal 1
+ * @increment 0.5
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_INDI_R_K, 20.f);
+
+/**
+ * INDI pitch rate gain
+ *
+ * Desired angular acceleration per unit of pitch rate error.
+ *
+ * @unit 1/s
+ * @min 1.0
+ * @max 100.0
+ * @decimal 1
+ * @increment 0.5
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_INDI_P_K, 20.f);
+
+/**
+ * INDI yaw rate gain
+ *
+ * Desired angular acceleration per unit of yaw rate error.
+ *
+ * @unit 1/s
+ * @min 1.0
+ * @max 100.0
+ * @decimal 1
+ * @increment 0.5
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_INDI_Y_K, 8.f);
+
+/**
+ * INDI roll control effectiveness
+ *
+ * Roll angular acceleration produced by a full normalized roll torque command.
+ * Overestimating it makes the disturbance rejection slower, underestimating it
+ * leads to oscillations.
+ *
+ * @unit rad/s^2
+ * @min 1.0
+ * @max 1000.0
+ * @decimal 1
+ * @increment 1
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_INDI_R_EFF, 60.f);
+
+/**
+ * INDI pitch control effectiveness
+ *
+ * Pitch angular acceleration produced by a full normalized pitch torque command.
+ *
+ * @unit rad/s^2
+ * @min 1.0
+ * @max 1000.0
+ * @decimal 1
+ * @increment 1
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_INDI_P_EFF, 60.f);
+
+/**
+ * INDI yaw control effectiveness
+ *
+ * Yaw angular acceleration produced by a full normalized yaw torque command.
+ *
+ * @unit rad/s^2
+ * @min 0.5
+ * @max 500.0
+ * @decimal 1
+ * @increment 0.5
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_INDI_Y_EFF, 8.f);
+
+/**
+ * INDI actuator time constant
+ *
+ * Time constant of the first order model of the motor response,
+ * used to synchronize the commanded torque with the measured angular acceleration.
+ *
+ * @unit s
+ * @min 0.0
+ * @max 0.2
+ * @decimal 3
+ * @increment 0.005
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_INDI_ACT_TC, 0.03f);
+
+/**
+ * Cutoff frequency for the angular acceleration filter of the INDI rate controller
+ *
+ * The same filter is applied to the actuator model. Lower values reduce the noise
+ * on the output but slow down the disturbance rejection.
+ *
+ * @unit Hz
+ * @min 5
+ * @max 200
+ * @decimal 0
+ * @increment 5
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_INDI_CUTOFF, 30.f);
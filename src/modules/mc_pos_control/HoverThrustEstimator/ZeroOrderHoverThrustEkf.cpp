@@ -0,0 +1,123 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ZeroOrderHoverThrustEkf.cpp
+ */
+
+#include "ZeroOrderHoverThrustEkf.hpp"
+
+#include <mathlib/mathlib.h>
+#include <lib/ecl/geo/geo.h>
+
+void ZeroOrderHoverThrustEkf::resetHoverThrust(float hover_thrust)
+{
+	_hover_thrust = math::constrain(hover_thrust, HOVER_THRUST_MIN, HOVER_THRUST_MAX);
+	_state_var = _hover_thrust_std_dev_init * _hover_thrust_std_dev_init;
+	_rejection_time = 0.f;
+}
+
+void ZeroOrderHoverThrustEkf::predict(float dt)
+{
+	// State is constant, only the uncertainty grows
+	_state_var += _process_var * dt * dt;
+	_dt = dt;
+}
+
+bool ZeroOrderHoverThrustEkf::fuseAccZ(float acc_z, float thrust_z, status &status_return)
+{
+	const float H = computeH(thrust_z);
+	const float innov_var = computeInnovVar(H);
+	const float innov = acc_z - computePredictedAccZ(thrust_z);
+	const float innov_test_ratio = computeInnovTestRatio(innov, innov_var);
+
+	const bool fused = innov_test_ratio < 1.f;
+
+	if (fused) {
+		const float K = _state_var * H / innov_var;
+		_hover_thrust = math::constrain(_hover_thrust + K * innov, HOVER_THRUST_MIN, HOVER_THRUST_MAX);
+		_state_var = math::max((1.f - K * H) * _state_var, 1e-10f);
+
+		// Learn the measurement noise from the post-fit residual
+		const float residual = acc_z - computePredictedAccZ(thrust_z);
+		const float alpha = math::constrain(_dt / (NOISE_LEARNING_TIME_CONSTANT + _dt), 0.f, 1.f);
+		_acc_var = (1.f - alpha) * _acc_var + alpha * (residual * residual + H * H * _state_var);
+		_acc_var = math::constrain(_acc_var, ACC_VAR_MIN, ACC_VAR_MAX);
+
+		_rejection_time = 0.f;
+
+	} else {
+		_rejection_time += _dt;
+
+		if (_rejection_time > REJECTION_RESET_TIME) {
+			// The model does not fit anymore (e.g. the mass changed), allow a fast convergence
+			_state_var = math::max(_state_var, _hover_thrust_std_dev_init * _hover_thrust_std_dev_init);
+			_acc_var = math::max(_acc_var, _acc_var_init);
+			_rejection_time = 0.f;
+		}
+	}
+
+	status_return.hover_thrust = _hover_thrust;
+	status_return.hover_thrust_var = _state_var;
+	status_return.innov = innov;
+	status_return.innov_var = innov_var;
+	status_return.innov_test_ratio = innov_test_ratio;
+	status_return.accel_noise_var = _acc_var;
+
+	return fused;
+}
+
+bool ZeroOrderHoverThrustEkf::isValid() const
+{
+	return _state_var < VALID_STD_DEV_MAX * VALID_STD_DEV_MAX && _rejection_time < REJECTION_RESET_TIME * 0.5f;
+}
+
+float ZeroOrderHoverThrustEkf::computeH(float thrust_z) const
+{
+	return -CONSTANTS_ONE_G * thrust_z / (_hover_thrust * _hover_thrust);
+}
+
+float ZeroOrderHoverThrustEkf::computeInnovVar(float H) const
+{
+	return math::max(H * _state_var * H + _acc_var, ACC_VAR_MIN);
+}
+
+float ZeroOrderHoverThrustEkf::computePredictedAccZ(float thrust_z) const
+{
+	return CONSTANTS_ONE_G * (1.f + thrust_z / _hover_thrust);
+}
+
+float ZeroOrderHoverThrustEkf::computeInnovTestRatio(float innov, float innov_var) const
+{
+	return innov * innov / (_gate_size * _gate_size * innov_var);
+}
@@ -0,0 +1,142 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ZeroOrderHoverThrustEkf.hpp
+ *
+ * Single state EKF estimating the normalized thrust required to hover.
+ *
+ * The hover thrust is modelled as a random walk (zero order). The measurement
+ * is the vertical acceleration (NED) produced by the vertical component of the
+ * thrust setpoint, assuming the thrust scales linearly with the setpoint:
+ *
+ * acc_z = g * (1 + thrust_z / hover_thrust), with thrust_z < 0 upwards.
+ *
+ * The accelerometer noise variance is learned online from the post-fit residuals
+ * and the measurements are gated with the innovation test ratio. If the
+ * measurements are rejected during a longer time (e.g.: after a change of
+ * payload), the state and noise variances are reset such that the filter
+ * converges again.
+ */
+
+#pragma once
+
+class ZeroOrderHoverThrustEkf
+{
+public:
+	struct status {
+		float hover_thrust;
+		float hover_thrust_var;
+		float innov;
+		float innov_var;
+		float innov_test_ratio;
+		float accel_noise_var;
+	};
+
+	ZeroOrderHoverThrustEkf() = default;
+	~ZeroOrderHoverThrustEkf() = default;
+
+	/**
+	 * Reset the estimate and its variance
+	 * @param hover_thrust initial hover thrust (0-1)
+	 */
+	void resetHoverThrust(float hover_thrust);
+
+	/**
+	 * Propagate the state variance
+	 * @param dt time since the last prediction [s]
+	 */
+	void predict(float dt);
+
+	/**
+	 * Fuse a vertical acceleration measurement
+	 * @param acc_z vertical acceleration, positive down [m/s^2]
+	 * @param thrust_z vertical component of the normalized thrust setpoint that produced it, negative up
+	 * @param status_return filled with the state and the innovation of the fusion
+	 * @return true if the measurement passed the innovation gate and was fused
+	 */
+	bool fuseAccZ(float acc_z, float thrust_z, status &status_return);
+
+	/**
+	 * @param std_dev standard deviation of the initial hover thrust error, also used on resets
+	 */
+	void setHoverThrustStdDev(float std_dev) { _hover_thrust_std_dev_init = std_dev; }
+
+	/**
+	 * @param std_dev standard deviation of the hover thrust random walk [1/s]
+	 */
+	void setProcessNoiseStdDev(float std_dev) { _process_var = std_dev * std_dev; }
+
+	/**
+	 * @param std_dev initial standard deviation of the acceleration measurement [m/s^2]
+	 */
+	void setMeasurementNoiseStdDev(float std_dev) { _acc_var = _acc_var_init = std_dev * std_dev; }
+
+	/**
+	 * @param gate_size innovation consistency gate size [SD]
+	 */
+	void setInnovGateSize(float gate_size) { _gate_size = gate_size; }
+
+	float getHoverThrustEstimate() const { return _hover_thrust; }
+	float getHoverThrustEstimateVar() const { return _state_var; }
+
+	/**
+	 * @return true if the estimate converged and the measurements are consistent with it
+	 */
+	bool isValid() const;
+
+private:
+	float computeH(float thrust_z) const;
+	float computeInnovVar(float H) const;
+	float computePredictedAccZ(float thrust_z) const;
+	float computeInnovTestRatio(float innov, float innov_var) const;
+
+	static constexpr float HOVER_THRUST_MIN = 0.1f;
+	static constexpr float HOVER_THRUST_MAX = 0.9f;
+	static constexpr float ACC_VAR_MIN = 0.01f; ///< [(m/s^2)^2]
+	static constexpr float ACC_VAR_MAX = 400.f; ///< [(m/s^2)^2]
+	static constexpr float NOISE_LEARNING_TIME_CONSTANT = 2.f; ///< [s]
+	static constexpr float REJECTION_RESET_TIME = 1.f; ///< [s]
+	static constexpr float VALID_STD_DEV_MAX = 0.03f;
+
+	float _hover_thrust{0.5f};
+	float _state_var{0.01f};
+	float _process_var{12.5e-6f}; ///< [1/s^2]
+	float _acc_var{5.f}; ///< [(m/s^2)^2]
+	float _acc_var_init{5.f}; ///< [(m/s^2)^2]
+	float _gate_size{3.f};
+	float _hover_thrust_std_dev_init{0.1f};
+
+	float _dt{0.02f}; ///< time since the last fusion [s]
+	float _rejection_time{0.f}; ///< time during which the measurements have been rejected [s]
+};
@@ -0,0 +1,137 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Test code for the zero order hover thrust EKF
+ * Run this test only using make tests TESTFILTER=ZeroOrderHoverThrustEkf
+ */
+
+#include <gtest/gtest.h>
+#include <lib/ecl/geo/geo.h>
+#include <math.h>
+
+#include "ZeroOrderHoverThrustEkf.hpp"
+
+class ZeroOrderHoverThrustEkfTest : public ::testing::Test
+{
+public:
+	ZeroOrderHoverThrustEkfTest()
+	{
+		_ekf.setHoverThrustStdDev(0.1f);
+		_ekf.setProcessNoiseStdDev(0.0036f);
+		_ekf.setMeasurementNoiseStdDev(2.f);
+		_ekf.resetHoverThrust(0.5f);
+	}
+
+	/** Deterministic pseudo random number with zero mean and unit variance */
+	float randomNormal()
+	{
+		// sum of 12 uniform samples
+		float sum = 0.f;
+
+		for (int i = 0; i < 12; i++) {
+			_seed = 1103515245u * _seed + 12345u;
+			sum += (float)((_seed >> 8) & 0xFFFF) / 65536.f;
+		}
+
+		return sum - 6.f;
+	}
+
+	/**
+	 * Run the filter on a vehicle oscillating vertically around hover
+	 * @return number of fused measurements
+	 */
+	int run(float true_hover_thrust, float duration, float noise_std_dev)
+	{
+		int fused = 0;
+
+		for (float t = 0.f; t < duration; t += _dt) {
+			const float thrust_z = -true_hover_thrust * (1.f + 0.2f * sinf(2.f * t));
+			const float acc_z = CONSTANTS_ONE_G * (1.f + thrust_z / true_hover_thrust) + noise_std_dev * randomNormal();
+			_ekf.predict(_dt);
+			fused += _ekf.fuseAccZ(acc_z, thrust_z, _status) ? 1 : 0;
+		}
+
+		return fused;
+	}
+
+	ZeroOrderHoverThrustEkf _ekf;
+	ZeroOrderHoverThrustEkf::status _status{};
+	const float _dt{0.02f};
+	uint32_t _seed{12345};
+};
+
+TEST_F(ZeroOrderHoverThrustEkfTest, convergesWithoutNoise)
+{
+	// GIVEN: a vehicle hovering at 60% thrust and a wrong initial guess
+	// WHEN: the filter runs for a few seconds
+	run(0.6f, 5.f, 0.f);
+
+	// THEN: it converges to the true hover thrust
+	EXPECT_NEAR(_ekf.getHoverThrustEstimate(), 0.6f, 0.01f);
+	EXPECT_TRUE(_ekf.isValid());
+	EXPECT_LT(fabsf(_status.innov), 0.1f);
+}
+
+TEST_F(ZeroOrderHoverThrustEkfTest, learnsMeasurementNoise)
+{
+	// GIVEN: noisy accelerometer data
+	const float noise_std_dev = 1.5f;
+	const int fused = run(0.4f, 30.f, noise_std_dev);
+
+	// THEN: the estimate is close, the noise level is learned and most of the measurements are fused
+	EXPECT_NEAR(_ekf.getHoverThrustEstimate(), 0.4f, 0.02f);
+	EXPECT_NEAR(sqrtf(_status.accel_noise_var), noise_std_dev, 0.5f);
+	EXPECT_GT(fused, (int)(0.95f * 30.f / _dt));
+	EXPECT_TRUE(_ekf.isValid());
+}
+
+TEST_F(ZeroOrderHoverThrustEkfTest, recoversFromPayloadChange)
+{
+	// GIVEN: a converged filter
+	run(0.45f, 10.f, 0.5f);
+	EXPECT_NEAR(_ekf.getHoverThrustEstimate(), 0.45f, 0.01f);
+
+	// WHEN: the mass suddenly increases by 30%
+	const float hover_thrust_heavy = 0.45f * 1.3f;
+	run(hover_thrust_heavy, 0.6f, 0.5f);
+
+	// THEN: the new measurements are not consistent with the estimate
+	EXPECT_GT(_status.innov_test_ratio, 1.f);
+	EXPECT_FALSE(_ekf.isValid());
+
+	// AND: the filter converges again
+	run(hover_thrust_heavy, 10.f, 0.5f);
+	EXPECT_NEAR(_ekf.getHoverThrustEstimate(), hover_thrust_heavy, 0.015f);
+	EXPECT_TRUE(_ekf.isValid());
+}
@@ -42,7 +42,6 @@
 #include <uORB/topics/vehicle_local_position.h>
 #include <uORB/topics/vehicle_local_position_setpoint.h>
 #include <uORB/topics/vehicle_constraints.h>
-#include <px4_module_params.h>
 #pragma once
 
 struct PositionControlStates {
@@ -71,21 +70,76 @@ struct PositionControlStates {
  * 	A setpoint that is NAN is considered as not set.
  * 	If there is a position/velocity- and thrust-setpoint present, then
  *  the thrust-setpoint is ommitted and recomputed from position-velocity-PID-loop.
+ *
+ * 	If enabled, a finite acceleration set-point is mapped to a thrust feed-forward
+ * 	scaled by the hover thrust, such that the velocity integrator only has
+ * 	to compensate for the residual model error.
  */
-class PositionControl : public ModuleParams
+class PositionControl
 {
 public:
 
-	PositionControl(ModuleParams *parent);
+	PositionControl() = default;
 	~PositionControl() = default;
 
 	/**
-	 *	Overwrites certain parameters.
-	 *	Overwrites are required for unit-conversion.
-	 *	This method should only be called if parameters
-	 *	have been updated.
+	 * Set the position control gains
+	 * @param P 3D vector of proportional gains for x,y,z axis
+	 */
+	void setPositionGains(const matrix::Vector3f &P) { _gain_pos_p = P; }
+
+	/**
+	 * Set the velocity control gains
+	 * @param P 3D vector of proportional gains for x,y,z axis
+	 * @param I 3D vector of integral gains
+	 * @param D 3D vector of derivative gains
+	 */
+	void setVelocityGains(const matrix::Vector3f &P, const matrix::Vector3f &I, const matrix::Vector3f &D);
+
+	/**
+	 * Set the global velocity limits, constraints can only be stricter
+	 * @param vel_horizontal horizontal velocity limit [m/s]
+	 * @param vel_up upwards velocity limit [m/s]
+	 * @param vel_down downwards velocity limit [m/s]
+	 */
+	void setVelocityLimits(const float vel_horizontal, const float vel_up, const float vel_down);
+
+	/**
+	 * Set the collective thrust limits
+	 * @param min minimum thrust in velocity control (0-1)
+	 * @param max maximum thrust (0-1)
+	 * @param manual_min minimum thrust for a thrust set-point from the sticks (0-1)
+	 */
+	void setThrustLimits(const float min, const float max, const float manual_min);
+
+	/**
+	 * Set the global tilt limit, constraints can only be stricter
+	 * @param tilt maximum tilt angle [rad]
+	 */
+	void setTiltLimit(const float tilt) { _lim_tilt = tilt; }
+
+	/**
+	 * Enable the acceleration set-point as thrust feed-forward. The D-term then acts on the
+	 * derivative of the velocity error instead of the vehicle acceleration.
+	 * @param enabled if false, acceleration set-points are ignored
+	 */
+	void setAccelerationFeedForward(const bool enabled) { _acc_ff_enabled = enabled; }
+
+	/**
+	 * Update the hover thrust, the equilibrium of the vertical velocity controller, e.g. from an estimator.
+	 * The part of the change that the integrator already compensates is moved out of it,
+	 * such that the integrator only keeps the residual to the new hover thrust.
+	 * @param hover_thrust normalized thrust required to hover (0-1)
 	 */
-	void overwriteParams();
+	void updateHoverThrust(const float hover_thrust);
+
+	/**
+	 * Set the hover thrust without touching the integrator, e.g. when landed or after a parameter change
+	 * @param hover_thrust normalized thrust required to hover (0-1)
+	 */
+	void setHoverThrust(const float hover_thrust) { _hover_thrust = hover_thrust; }
+
+	float getHoverThrust() const { return _hover_thrust; }
 
 	/**
 	 * Update the current vehicle state.
@@ -135,6 +189,13 @@ public:
 	 */
 	const matrix::Vector3f &getThrustSetpoint() { return _thr_sp; }
 
+	/**
+	 * 	Get the
+	 * 	@see _thr_int
+	 * 	@return The thrust integral term, in D-direction relative to the hover thrust.
+	 */
+	const matrix::Vector3f &getThrustIntegral() const { return _thr_int; }
+
 	/**
 	 * 	Get the
 	 * 	@see _yaw_sp
@@ -191,10 +252,6 @@ public:
 		return pos_sp;
 	}
 
-protected:
-
-	void updateParams() override;
-
 private:
 	/**
 	 * Maps setpoints to internal-setpoints.
@@ -206,6 +263,24 @@ private:
 	void _velocityController(const float &dt); /** applies the PID-velocity-controller */
 	void _setCtrlFlag(bool value); /**< set control-loop flags (only required for logging) */
 
+	// Gains
+	matrix::Vector3f _gain_pos_p{0.95f, 0.95f, 1.f}; /**< position control proportional gain */
+	matrix::Vector3f _gain_vel_p{0.09f, 0.09f, 0.2f}; /**< velocity control proportional gain */
+	matrix::Vector3f _gain_vel_i{0.02f, 0.02f, 0.02f}; /**< velocity control integral gain */
+	matrix::Vector3f _gain_vel_d{0.01f, 0.01f, 0.f}; /**< velocity control derivative gain */
+
+	// Limits
+	float _lim_vel_horizontal{12.f}; /**< horizontal velocity limit [m/s] */
+	float _lim_vel_up{3.f}; /**< upwards velocity limit [m/s] */
+	float _lim_vel_down{1.f}; /**< downwards velocity limit [m/s] */
+	float _lim_thr_min{0.12f}; /**< minimum collective thrust in velocity control */
+	float _lim_thr_max{1.f}; /**< maximum collective thrust */
+	float _lim_thr_manual_min{0.08f}; /**< minimum collective thrust from the sticks */
+	float _lim_tilt{0.785398f}; /**< maximum tilt [rad] */
+
+	float _hover_thrust{0.5f}; /**< thrust required to hover */
+	bool _acc_ff_enabled{false}; /**< acceleration set-point used as thrust feed-forward */
+
 	matrix::Vector3f _pos{}; /**< MC position */
 	matrix::Vector3f _vel{}; /**< MC velocity */
 	matrix::Vector3f _vel_dot{}; /**< MC velocity derivative */
@@ -213,7 +288,7 @@ private:
 	float _yaw{0.0f}; /**< MC yaw */
 	matrix::Vector3f _pos_sp{}; /**< desired position */
 	matrix::Vector3f _vel_sp{}; /**< desired velocity */
-	matrix::Vector3f _acc_sp{}; /**< desired acceleration: not supported yet */
+	matrix::Vector3f _acc_sp{}; /**< desired acceleration, used as thrust feed-forward */
 	matrix::Vector3f _thr_sp{}; /**< desired thrust */
 	float _yaw_sp{}; /**< desired yaw */
 	float _yawspeed_sp{}; /** desired yaw-speed */
@@ -222,26 +297,4 @@ private:
 	bool _skip_controller{false}; /**< skips position/velocity controller. true for stabilized mode */
 	bool _ctrl_pos[3] = {true, true, true}; /**< True if the control-loop for position was used */
 	bool _ctrl_vel[3] = {true, true, true}; /**< True if the control-loop for velocity was used */
-
-	DEFINE_PARAMETERS(
-		(ParamFloat<px4::params::MPC_THR_MAX>) _param_mpc_thr_max,
-		(ParamFloat<px4::params::MPC_THR_HOVER>) _param_mpc_thr_hover,
-		(ParamFloat<px4::params::MPC_THR_MIN>) _param_mpc_thr_min,
-		(ParamFloat<px4::params::MPC_MANTHR_MIN>) _param_mpc_manthr_min,
-		(ParamFloat<px4::params::MPC_XY_VEL_MAX>) _param_mpc_xy_vel_max,
-		(ParamFloat<px4::params::MPC_Z_VEL_MAX_DN>) _param_mpc_z_vel_max_dn,
-		(ParamFloat<px4::params::MPC_Z_VEL_MAX_UP>) _param_mpc_z_vel_max_up,
-		(ParamFloat<px4::params::MPC_TILTMAX_AIR>)
-		_param_mpc_tiltmax_air, // maximum tilt for any position controlled mode in degrees
-		(ParamFloat<px4::params::MPC_MAN_TILT_MAX>)
-		_param_mpc_man_tilt_max, // maximum til for stabilized/altitude mode in degrees
-		(ParamFloat<px4::params::MPC_Z_P>) _param_mpc_z_p,
-		(ParamFloat<px4::params::MPC_Z_VEL_P>) _param_mpc_z_vel_p,
-		(ParamFloat<px4::params::MPC_Z_VEL_I>) _param_mpc_z_vel_i,
-		(ParamFloat<px4::params::MPC_Z_VEL_D>) _param_mpc_z_vel_d,
-		(ParamFloat<px4::params::MPC_XY_P>) _param_mpc_xy_p,
-		(ParamFloat<px4::params::MPC_XY_VEL_P>) _param_mpc_xy_vel_p,
-		(ParamFloat<px4::params::MPC_XY_VEL_I>) _param_mpc_xy_vel_i,
-		(ParamFloat<px4::params::MPC_XY_VEL_D>) _param_mpc_xy_vel_d
-	)
 };
@@ -0,0 +1,339 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Test code for the Position Control library
+ * Run this test only using make tests TESTFILTER=PositionControl
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/matrix/math.hpp>
+#include <mathlib/mathlib.h>
+#include <lib/ecl/geo/geo.h>
+
+#include "PositionControl.hpp"
+#include <ZeroOrderHoverThrustEkf.hpp>
+
+using namespace matrix;
+
+/**
+ * Closed loop simulation of a point mass with ideal attitude tracking.
+ * The thrust setpoint of a control cycle is applied during the next cycle.
+ */
+class PointMassSimulation
+{
+public:
+	PointMassSimulation()
+	{
+		control.setPositionGains(Vector3f(0.95f, 0.95f, 1.f));
+		control.setVelocityGains(Vector3f(0.09f, 0.09f, 0.2f), Vector3f(0.02f, 0.02f, 0.02f), Vector3f(0.01f, 0.01f, 0.f));
+		control.setVelocityLimits(12.f, 3.f, 1.f);
+		control.setThrustLimits(0.12f, 1.f, 0.08f);
+		control.setTiltLimit(math::radians(45.f));
+		control.setHoverThrust(0.5f);
+
+		hover_thrust_ekf.setHoverThrustStdDev(0.1f);
+		hover_thrust_ekf.setProcessNoiseStdDev(0.0036f);
+		hover_thrust_ekf.setMeasurementNoiseStdDev(1.f);
+		hover_thrust_ekf.resetHoverThrust(0.5f);
+
+		constraints.tilt = NAN;
+		constraints.speed_xy = NAN;
+		constraints.speed_up = NAN;
+		constraints.speed_down = NAN;
+	}
+
+	/** Circle of 5m radius flown at 5m/s with a vertical oscillation */
+	static vehicle_local_position_setpoint_s reference(float t, bool acceleration_feed_forward)
+	{
+		const float radius = 5.f;
+		const float omega = 1.f;
+		const float amplitude = 0.5f;
+
+		vehicle_local_position_setpoint_s setpoint{};
+		setpoint.x = radius * cosf(omega * t);
+		setpoint.y = radius * sinf(omega * t);
+		setpoint.z = -10.f + amplitude * sinf(omega * t);
+		setpoint.vx = -radius * omega * sinf(omega * t);
+		setpoint.vy = radius * omega * cosf(omega * t);
+		setpoint.vz = amplitude * omega * cosf(omega * t);
+
+		if (acceleration_feed_forward) {
+			setpoint.acc_x = -radius * omega * omega * cosf(omega * t);
+			setpoint.acc_y = -radius * omega * omega * sinf(omega * t);
+			setpoint.acc_z = -amplitude * omega * omega * sinf(omega * t);
+
+		} else {
+			setpoint.acc_x = setpoint.acc_y = setpoint.acc_z = NAN;
+		}
+
+		setpoint.yaw = 0.f;
+		setpoint.yawspeed = NAN;
+		setpoint.thrust[0] = setpoint.thrust[1] = setpoint.thrust[2] = NAN;
+		return setpoint;
+	}
+
+	static vehicle_local_position_setpoint_s hover(const Vector3f &position)
+	{
+		vehicle_local_position_setpoint_s setpoint{};
+		setpoint.x = position(0);
+		setpoint.y = position(1);
+		setpoint.z = position(2);
+		setpoint.vx = setpoint.vy = setpoint.vz = NAN;
+		setpoint.acc_x = setpoint.acc_y = setpoint.acc_z = NAN;
+		setpoint.yaw = 0.f;
+		setpoint.yawspeed = NAN;
+		setpoint.thrust[0] = setpoint.thrust[1] = setpoint.thrust[2] = NAN;
+		return setpoint;
+	}
+
+	/**
+	 * Run one control cycle and propagate the vehicle
+	 * @param true_hover_thrust thrust at which the simulated vehicle hovers, depends on its mass
+	 * @param use_hover_thrust_estimate feed the hover thrust estimator output to the controller
+	 */
+	void step(const vehicle_local_position_setpoint_s &setpoint, float true_hover_thrust, bool use_hover_thrust_estimate)
+	{
+		const Vector3f acceleration = Vector3f(0.f, 0.f, CONSTANTS_ONE_G) + thrust * (CONSTANTS_ONE_G / true_hover_thrust);
+
+		if (use_hover_thrust_estimate) {
+			ZeroOrderHoverThrustEkf::status status{};
+			hover_thrust_ekf.predict(dt);
+			hover_thrust_ekf.fuseAccZ(acceleration(2), thrust(2), status);
+
+			if (hover_thrust_ekf.isValid()) {
+				control.updateHoverThrust(hover_thrust_ekf.getHoverThrustEstimate());
+			}
+		}
+
+		PositionControlStates states{};
+		states.position = position;
+		states.velocity = velocity;
+		// the controller expects the derivative of the negative velocity
+		states.acceleration = -acceleration;
+		states.yaw = 0.f;
+
+		control.updateConstraints(constraints);
+		control.updateState(states);
+		EXPECT_TRUE(control.updateSetpoint(setpoint));
+		control.generateThrustYawSetpoint(dt);
+
+		// propagate with the thrust of the previous cycle
+		velocity += acceleration * dt;
+		position += velocity * dt;
+		thrust = control.getThrustSetpoint();
+	}
+
+	/** @return RMS position tracking error of a circle flown after a convergence time */
+	float trackCircle(bool acceleration_feed_forward)
+	{
+		position = Vector3f(reference(0.f, true).x, reference(0.f, true).y, reference(0.f, true).z);
+		float error_squared = 0.f;
+		int n = 0;
+
+		control.setAccelerationFeedForward(acceleration_feed_forward);
+
+		for (float t = 0.f; t < 20.f; t += dt) {
+			const vehicle_local_position_setpoint_s setpoint = reference(t, acceleration_feed_forward);
+			step(setpoint, 0.5f, false);
+
+			if (t > 5.f) {
+				const vehicle_local_position_setpoint_s next = reference(t + dt, acceleration_feed_forward);
+				error_squared += (position - Vector3f(next.x, next.y, next.z)).norm_squared();
+				n++;
+			}
+		}
+
+		return sqrtf(error_squared / n);
+	}
+
+	/**
+	 * Hover, then increase the mass by 30%
+	 * @return integral of the absolute altitude error after the mass change [m s]
+	 */
+	float payloadStep(bool use_hover_thrust_estimate)
+	{
+		const Vector3f hover_position(0.f, 0.f, -10.f);
+		position = hover_position;
+		thrust = Vector3f(0.f, 0.f, -0.5f);
+		float integrated_error = 0.f;
+
+		for (float t = 0.f; t < 30.f; t += dt) {
+			const float true_hover_thrust = t < 10.f ? 0.5f : 0.65f;
+			step(hover(hover_position), true_hover_thrust, use_hover_thrust_estimate);
+
+			if (t > 10.f) {
+				integrated_error += fabsf(position(2) - hover_position(2)) * dt;
+			}
+		}
+
+		return integrated_error;
+	}
+
+	PositionControl control;
+	ZeroOrderHoverThrustEkf hover_thrust_ekf;
+	vehicle_constraints_s constraints{};
+	const float dt{0.02f};
+
+	Vector3f position;
+	Vector3f velocity;
+	Vector3f thrust{0.f, 0.f, -0.5f};
+};
+
+TEST(PositionControlTest, hoverEquilibrium)
+{
+	PointMassSimulation sim;
+
+	// GIVEN: a vehicle at the position setpoint with the correct hover thrust
+	sim.position = Vector3f(1.f, 2.f, -5.f);
+
+	// WHEN: it hovers
+	for (int i = 0; i < 100; i++) {
+		sim.step(PointMassSimulation::hover(sim.position), 0.5f, false);
+	}
+
+	// THEN: the thrust is the hover thrust and the integrator is not needed
+	EXPECT_NEAR(sim.control.getThrustSetpoint()(2), -0.5f, 1e-4f);
+	EXPECT_LT(sim.control.getThrustIntegral().norm(), 1e-4f);
+	EXPECT_LT((sim.position - Vector3f(1.f, 2.f, -5.f)).norm(), 1e-3f);
+}
+
+TEST(PositionControlTest, hoverThrustUpdateTransfersIntegral)
+{
+	// GIVEN: a vehicle that is heavier than the configured hover thrust, compensated by the integrator
+	PointMassSimulation sim;
+	sim.position = Vector3f(0.f, 0.f, -5.f);
+
+	for (int i = 0; i < 3000; i++) {
+		sim.step(PointMassSimulation::hover(Vector3f(0.f, 0.f, -5.f)), 0.6f, false);
+	}
+
+	EXPECT_NEAR(sim.control.getThrustSetpoint()(2), -0.6f, 1e-3f);
+	EXPECT_NEAR(sim.control.getThrustIntegral()(2), -0.1f, 1e-3f);
+
+	// WHEN: the correct hover thrust is set
+	sim.control.updateHoverThrust(0.6f);
+	sim.step(PointMassSimulation::hover(Vector3f(0.f, 0.f, -5.f)), 0.6f, false);
+
+	// THEN: the thrust output does not jump and the integrator is emptied
+	EXPECT_NEAR(sim.control.getThrustSetpoint()(2), -0.6f, 1e-3f);
+	EXPECT_NEAR(sim.control.getThrustIntegral()(2), 0.f, 1e-3f);
+	EXPECT_FLOAT_EQ(sim.control.getHoverThrust(), 0.6f);
+
+	// WHEN: the hover thrust increases further
+	sim.control.updateHoverThrust(0.7f);
+	sim.step(PointMassSimulation::hover(Vector3f(0.f, 0.f, -5.f)), 0.6f, false);
+
+	// THEN: the change is applied directly
+	EXPECT_NEAR(sim.control.getThrustSetpoint()(2), -0.7f, 1e-2f);
+	EXPECT_NEAR(sim.control.getThrustIntegral()(2), 0.f, 1e-3f);
+}
+
+TEST(PositionControlTest, accelerationFeedForwardTrackingBenchmark)
+{
+	// WHEN: we fly an aggressive circle with and without acceleration feed-forward
+	PointMassSimulation velocity_only;
+	const float rms_velocity_only = velocity_only.trackCircle(false);
+
+	PointMassSimulation feed_forward;
+	const float rms_feed_forward = feed_forward.trackCircle(true);
+
+	// THEN: the feed-forward reduces the tracking error significantly
+	printf("circle tracking RMS error: %.3fm without, %.3fm with acceleration feed-forward\n",
+	       (double)rms_velocity_only, (double)rms_feed_forward);
+	EXPECT_LT(rms_feed_forward, 0.2f);
+	EXPECT_LT(rms_feed_forward * 3.f, rms_velocity_only);
+}
+
+TEST(PositionControlTest, accelerationFeedForwardDisabledByDefault)
+{
+	// GIVEN: two controllers in the same state, one with an acceleration setpoint
+	PositionControl with_acceleration;
+	PositionControl without_acceleration;
+
+	PositionControlStates states{};
+	states.position = Vector3f(0.f, 0.f, -5.f);
+	states.velocity = Vector3f(1.f, 0.f, 0.f);
+	states.acceleration = Vector3f(0.2f, 0.f, 0.f);
+	states.yaw = 0.f;
+
+	vehicle_constraints_s constraints{};
+	constraints.tilt = constraints.speed_xy = constraints.speed_up = constraints.speed_down = NAN;
+	with_acceleration.updateConstraints(constraints);
+	without_acceleration.updateConstraints(constraints);
+
+	vehicle_local_position_setpoint_s setpoint = PointMassSimulation::hover(Vector3f(1.f, 0.f, -5.f));
+	without_acceleration.updateState(states);
+	without_acceleration.updateSetpoint(setpoint);
+	without_acceleration.generateThrustYawSetpoint(0.02f);
+
+	setpoint.acc_x = 3.f;
+	setpoint.acc_z = -2.f;
+	with_acceleration.updateState(states);
+	with_acceleration.updateSetpoint(setpoint);
+	with_acceleration.generateThrustYawSetpoint(0.02f);
+
+	// THEN: without enabling the feed-forward the acceleration setpoint is ignored
+	EXPECT_LT((with_acceleration.getThrustSetpoint() - without_acceleration.getThrustSetpoint()).norm(), 1e-6f);
+
+	// WHEN: the feed-forward is enabled
+	with_acceleration.setAccelerationFeedForward(true);
+	with_acceleration.updateSetpoint(setpoint);
+	with_acceleration.generateThrustYawSetpoint(0.02f);
+
+	// THEN: it tilts and climbs
+	EXPECT_GT(with_acceleration.getThrustSetpoint()(0), without_acceleration.getThrustSetpoint()(0));
+	EXPECT_LT(with_acceleration.getThrustSetpoint()(2), without_acceleration.getThrustSetpoint()(2));
+}
+
+TEST(PositionControlTest, payloadChangeWithHoverThrustEstimator)
+{
+	// WHEN: the mass increases by 30% while hovering, only the integrator compensates
+	PointMassSimulation integrator;
+	const float error_integrator = integrator.payloadStep(false);
+
+	// AND: the same with the hover thrust estimator
+	PointMassSimulation estimator;
+	const float error_estimator = estimator.payloadStep(true);
+
+	printf("payload step integrated altitude error: %.3fms integrator only, %.3fms with estimator\n",
+	       (double)error_integrator, (double)error_estimator);
+
+	// THEN: the estimator recovers the altitude faster
+	EXPECT_LT(error_estimator * 2.f, error_integrator);
+
+	// AND: finds the new hover thrust, the integrator only holds the residual
+	EXPECT_NEAR(estimator.control.getHoverThrust(), 0.65f, 0.01f);
+	EXPECT_LT(fabsf(estimator.control.getThrustIntegral()(2)), 0.01f);
+	EXPECT_GT(fabsf(integrator.control.getThrustIntegral()(2)), 0.1f);
+}
@@ -57,6 +57,7 @@
 #include <uORB/Subscription.hpp>
 #include <uORB/SubscriptionCallback.hpp>
 #include <uORB/topics/home_position.h>
+#include <uORB/topics/hover_thrust_estimate.h>
 #include <uORB/topics/landing_gear.h>
 #include <uORB/topics/parameter_update.h>
 #include <uORB/topics/vehicle_attitude_setpoint.h>
@@ -67,9 +68,10 @@
 #include <uORB/topics/vehicle_status.h>
 #include <uORB/topics/vehicle_trajectory_waypoint.h>
 
-#include "PositionControl.hpp"
+#include "PositionControl/PositionControl.hpp"
 #include "Utility/ControlMath.hpp"
 #include "Takeoff.hpp"
+#include "ZeroOrderHoverThrustEkf.hpp"
 
 #include <float.h>
 
@@ -116,6 +118,7 @@ private:
 	uORB::Publication<landing_gear_s>			_landing_gear_pub{ORB_ID(landing_gear)};
 	uORB::Publication<vehicle_local_position_setpoint_s>	_local_pos_sp_pub{ORB_ID(vehicle_local_position_setpoint)};	/**< vehicle local position setpoint publication */
 	uORB::Publication<vehicle_local_position_setpoint_s>	_traj_sp_pub{ORB_ID(trajectory_setpoint)};			/**< trajectory setpoints publication */
+	uORB::Publication<hover_thrust_estimate_s>		_hover_thrust_estimate_pub{ORB_ID(hover_thrust_estimate)};	/**< hover thrust estimate publication */
 
 	uORB::SubscriptionCallbackWorkItem _local_pos_sub{this, ORB_ID(vehicle_local_position)};	/**< vehicle local position */
 
@@ -166,7 +169,22 @@ private:
 		(ParamFloat<px4::params::MPC_THR_MIN>)_param_mpc_thr_min,
 		(ParamFloat<px4::params::MPC_THR_HOVER>)_param_mpc_thr_hover,
 		(ParamFloat<px4::params::MPC_THR_MAX>)_param_mpc_thr_max,
-		(ParamFloat<px4::params::MPC_Z_VEL_P>)_param_mpc_z_vel_p
+		(ParamFloat<px4::params::MPC_MANTHR_MIN>) _param_mpc_manthr_min,
+		(ParamFloat<px4::params::MPC_TILTMAX_AIR>) _param_mpc_tiltmax_air, /**< maximum tilt for any position controlled mode */
+		(ParamFloat<px4::params::MPC_MAN_TILT_MAX>) _param_mpc_man_tilt_max, /**< maximum tilt for stabilized/altitude mode */
+		(ParamFloat<px4::params::MPC_Z_P>) _param_mpc_z_p,
+		(ParamFloat<px4::params::MPC_Z_VEL_P>)_param_mpc_z_vel_p,
+		(ParamFloat<px4::params::MPC_Z_VEL_I>) _param_mpc_z_vel_i,
+		(ParamFloat<px4::params::MPC_Z_VEL_D>) _param_mpc_z_vel_d,
+		(ParamFloat<px4::params::MPC_XY_P>) _param_mpc_xy_p,
+		(ParamFloat<px4::params::MPC_XY_VEL_P>) _param_mpc_xy_vel_p,
+		(ParamFloat<px4::params::MPC_XY_VEL_I>) _param_mpc_xy_vel_i,
+		(ParamFloat<px4::params::MPC_XY_VEL_D>) _param_mpc_xy_vel_d,
+		(ParamInt<px4::params::MPC_USE_HTE>) _param_mpc_use_hte,
+		(ParamBool<px4::params::MPC_ACC_FF>) _param_mpc_acc_ff,
+		(ParamFloat<px4::params::HTE_HT_NOISE>) _param_hte_ht_noise,
+		(ParamFloat<px4::params::HTE_ACC_GATE>) _param_hte_acc_gate,
+		(ParamFloat<px4::params::HTE_HT_ERR_INIT>) _param_hte_ht_err_init
 	);
 
 	control::BlockDerivative _vel_x_deriv; /**< velocity derivative in x */
@@ -177,6 +195,10 @@ private:
 	PositionControl _control; /**< class for core PID position control */
 	PositionControlStates _states{}; /**< structure containing vehicle state information for position control */
 
+	ZeroOrderHoverThrustEkf _hover_thrust_ekf; /**< online estimate of the hover thrust */
+	bool _hover_thrust_estimate_in_use{false}; /**< true if the controller uses the estimate instead of MPC_THR_HOVER */
+	float _thrust_sp_z_prev{NAN}; /**< vertical thrust setpoint of the previous cycle, produced the current acceleration */
+
 	hrt_abstime _last_warn = 0; /**< timer when the last warn message was sent out */
 
 	bool _in_failsafe = false; /**< true if failsafe was entered within current cycle */
@@ -214,6 +236,11 @@ private:
 	 */
 	void set_vehicle_states(const float &vel_sp_z);
 
+	/**
+	 * Run the hover thrust estimator on the vertical acceleration and feed it to the controller.
+	 */
+	void update_hover_thrust_estimator();
+
 	/**
 	 * Limit altitude based on land-detector.
 	 * @param setpoint needed to detect vehicle intention.
@@ -287,7 +314,6 @@ MulticopterPositionControl::MulticopterPositionControl() :
 	_vel_x_deriv(this, "VELD"),
 	_vel_y_deriv(this, "VELD"),
 	_vel_z_deriv(this, "VELD"),
-	_control(this),
 	_cycle_perf(perf_alloc_once(PC_ELAPSED, MODULE_NAME": cycle time"))
 {
 	// fetch initial parameter values
@@ -336,7 +362,7 @@ int
 MulticopterPositionControl::parameters_update(bool force)
 {
 	// check for parameter updates
-	if (_parameter_update_sub.updated()) {
+	if (_parameter_update_sub.updated() || force) {
 		// clear update
 		parameter_update_s pupdate;
 		_parameter_update_sub.copy(&pupdate);
@@ -372,6 +398,25 @@ MulticopterPositionControl::parameters_update(bool force)
 		_param_mpc_tko_speed.set(math::min(_param_mpc_tko_speed.get(), _param_mpc_z_vel_max_up.get()));
 		_param_mpc_land_speed.set(math::min(_param_mpc_land_speed.get(), _param_mpc_z_vel_max_dn.get()));
 
+		// set the position controller gains and limits
+		_control.setPositionGains(Vector3f(_param_mpc_xy_p.get(), _param_mpc_xy_p.get(), _param_mpc_z_p.get()));
+		_control.setVelocityGains(
+			Vector3f(_param_mpc_xy_vel_p.get(), _param_mpc_xy_vel_p.get(), _param_mpc_z_vel_p.get()),
+			Vector3f(_param_mpc_xy_vel_i.get(), _param_mpc_xy_vel_i.get(), _param_mpc_z_vel_i.get()),
+			Vector3f(_param_mpc_xy_vel_d.get(), _param_mpc_xy_vel_d.get(), _param_mpc_z_vel_d.get()));
+		_control.setVelocityLimits(_param_mpc_xy_vel_max.get(), _param_mpc_z_vel_max_up.get(), _param_mpc_z_vel_max_dn.get());
+		_control.setThrustLimits(_param_mpc_thr_min.get(), _param_mpc_thr_max.get(), _param_mpc_manthr_min.get());
+		_control.setTiltLimit(math::radians(math::max(_param_mpc_tiltmax_air.get(), _param_mpc_man_tilt_max.get())));
+		_control.setAccelerationFeedForward(_param_mpc_acc_ff.get());
+
+		if (!_hover_thrust_estimate_in_use) {
+			_control.setHoverThrust(_param_mpc_thr_hover.get());
+		}
+
+		_hover_thrust_ekf.setProcessNoiseStdDev(_param_hte_ht_noise.get());
+		_hover_thrust_ekf.setInnovGateSize(_param_hte_acc_gate.get());
+		_hover_thrust_ekf.setHoverThrustStdDev(_param_hte_ht_err_init.get());
+
 		// set trigger time for takeoff delay
 		_takeoff.setSpoolupTime(_param_mpc_spoolup_time.get());
 		_takeoff.setTakeoffRampTime(_param_mpc_tko_ramp_t.get());
@@ -419,6 +464,53 @@ MulticopterPositionControl::poll_subscriptions()
 	}
 }
 
+void
+MulticopterPositionControl::update_hover_thrust_estimator()
+{
+	const bool in_flight = _control_mode.flag_armed && !_vehicle_land_detected.landed
+			       && _takeoff.getTakeoffState() == TakeoffState::flight;
+
+	if (!in_flight) {
+		// start from the parameter for the next flight
+		_hover_thrust_ekf.resetHoverThrust(_param_mpc_thr_hover.get());
+
+		if (_hover_thrust_estimate_in_use) {
+			_control.setHoverThrust(_param_mpc_thr_hover.get());
+			_hover_thrust_estimate_in_use = false;
+		}
+
+		return;
+	}
+
+	_hover_thrust_ekf.predict(_dt);
+
+	// the acceleration is the response to the thrust setpoint of the previous cycle
+	if (!_local_pos.v_z_valid || !PX4_ISFINITE(_local_pos.az) || !PX4_ISFINITE(_thrust_sp_z_prev)) {
+		return;
+	}
+
+	ZeroOrderHoverThrustEkf::status status{};
+	_hover_thrust_ekf.fuseAccZ(_local_pos.az, _thrust_sp_z_prev, status);
+
+	const bool valid = _hover_thrust_ekf.isValid();
+
+	if (_param_mpc_use_hte.get() && valid) {
+		_control.updateHoverThrust(status.hover_thrust);
+		_hover_thrust_estimate_in_use = true;
+	}
+
+	hover_thrust_estimate_s hover_thrust_estimate{};
+	hover_thrust_estimate.timestamp = hrt_absolute_time();
+	hover_thrust_estimate.hover_thrust = status.hover_thrust;
+	hover_thrust_estimate.hover_thrust_var = status.hover_thrust_var;
+	hover_thrust_estimate.accel_innov = status.innov;
+	hover_thrust_estimate.accel_innov_var = status.innov_var;
+	hover_thrust_estimate.accel_innov_test_ratio = status.innov_test_ratio;
+	hover_thrust_estimate.accel_noise_var = status.accel_noise_var;
+	hover_thrust_estimate.valid = valid;
+	_hover_thrust_estimate_pub.publish(hover_thrust_estimate);
+}
+
 void
 MulticopterPositionControl::limit_altitude(vehicle_local_position_setpoint_s &setpoint)
 {
@@ -540,6 +632,8 @@ MulticopterPositionControl::Run()
 		const bool was_in_failsafe = _in_failsafe;
 		_in_failsafe = false;
 
+		update_hover_thrust_estimator();
+
 		// activate the weathervane controller if required. If activated a flighttask can use it to implement a yaw-rate control strategy
 		// that turns the nose of the vehicle into the wind
 		if (_wv_controller != nullptr) {
@@ -695,6 +789,8 @@ MulticopterPositionControl::Run()
 				limit_thrust_during_landing(local_pos_sp);
 			}
 
+			_thrust_sp_z_prev = local_pos_sp.thrust[2];
+
 			// Fill attitude setpoint. Attitude is computed from yaw and thrust setpoint.
 			_att_sp = ControlMath::thrustToAttitude(matrix::Vector3f(local_pos_sp.thrust), local_pos_sp.yaw);
 			_att_sp.yaw_sp_move_rate = _control.getYawspeedSetpoint();
@@ -731,6 +827,7 @@ MulticopterPositionControl::Run()
 			q_sp.copyTo(_att_sp.q_d);
 			_att_sp.q_d_valid = true;
 			_att_sp.thrust_body[2] = 0.0f;
+			_thrust_sp_z_prev = NAN;
 
 			// reset the numerical derivatives to not generate d term spikes when coming from non-position controlled operation
 			_vel_x_deriv.reset();
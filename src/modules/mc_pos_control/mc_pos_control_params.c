@@ -73,6 +73,33 @@ PARAM_DEFINE_FLOAT(MPC_THR_MIN, 0.12f);
  */
 PARAM_DEFINE_FLOAT(MPC_THR_HOVER, 0.5f);
 
+/**
+ * Use the hover thrust estimate
+ *
+ * If enabled, the hover thrust estimated in flight replaces MPC_THR_HOVER
+ * as equilibrium of the vertical velocity controller once it converged.
+ * The estimate is published and logged in any case, such that it can be
+ * compared against MPC_THR_HOVER before enabling this.
+ *
+ * @boolean
+ * @group Multicopter Position Control
+ */
+PARAM_DEFINE_INT32(MPC_USE_HTE, 0);
+
+/**
+ * Acceleration feed-forward
+ *
+ * If enabled, the acceleration setpoint of the flight task is added to the
+ * velocity controller output as thrust feed-forward, scaled by the hover thrust,
+ * and the derivative term acts on the velocity error instead of the acceleration.
+ * Only enable it if the hover thrust is accurate (see MPC_THR_HOVER and MPC_USE_HTE).
+ * If disabled, the velocity controller behaves as without feed-forward.
+ *
+ * @boolean
+ * @group Multicopter Position Control
+ */
+PARAM_DEFINE_INT32(MPC_ACC_FF, 0);
+
 /**
  * Thrust curve in Manual Mode
  *
@@ -771,3 +798,48 @@ PARAM_DEFINE_FLOAT(MPC_SPOOLUP_TIME, 1.0f);
  * @group Mission
  */
 PARAM_DEFINE_INT32(MPC_YAW_MODE, 0);
+
+/**
+ * Hover thrust process noise
+ *
+ * Reduce to make the hover thrust estimate more stable,
+ * increase if the real hover thrust is expected to change quickly over time.
+ *
+ * @min 0.0001
+ * @max 1.0
+ * @decimal 4
+ * @increment 0.0001
+ * @unit norm/s
+ * @group Hover Thrust Estimator
+ */
+PARAM_DEFINE_FLOAT(HTE_HT_NOISE, 0.0036f);
+
+/**
+ * Gate size for acceleration fusion
+ *
+ * Sets the number of standard deviations used
+ * by the innovation consistency test.
+ *
+ * @min 1.0
+ * @max 10.0
+ * @decimal 1
+ * @unit SD
+ * @group Hover Thrust Estimator
+ */
+PARAM_DEFINE_FLOAT(HTE_ACC_GATE, 3.0f);
+
+/**
+ * 1-sigma initial hover thrust uncertainty
+ *
+ * Sets the initial uncertainty of the hover thrust around MPC_THR_HOVER.
+ * It is also used to reset the uncertainty when the measurements are
+ * persistently inconsistent with the estimate, e.g. after a payload change.
+ *
+ * @min 0.0
+ * @max 1.0
+ * @decimal 3
+ * @increment 0.01
+ * @unit norm
+ * @group Hover Thrust Estimator
+ */
+PARAM_DEFINE_FLOAT(HTE_HT_ERR_INIT, 0.1f);
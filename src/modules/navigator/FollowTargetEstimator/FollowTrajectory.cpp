@@ -0,0 +1,89 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file FollowTrajectory.cpp
+ */
+
+#include "FollowTrajectory.hpp"
+
+#include <float.h>
+#include <mathlib/mathlib.h>
+
+using namespace matrix;
+
+void FollowTrajectory::reset(const Vector2f &position, const Vector2f &velocity)
+{
+	_position = position;
+	_velocity = velocity;
+	_acceleration.zero();
+}
+
+void FollowTrajectory::update(float dt, const Vector2f &position, const Vector2f &velocity)
+{
+	if (dt <= 0.f) {
+		return;
+	}
+
+	// Cascaded position and velocity loops, critically damped when not saturated. The position
+	// correction is limited such that the vehicle can still brake before reaching the reference.
+	const Vector2f position_error = position - _position;
+	const float position_error_norm = position_error.norm();
+	Vector2f velocity_setpoint = velocity;
+
+	if (position_error_norm > FLT_EPSILON) {
+		const float correction = math::min(0.5f * _bandwidth * position_error_norm,
+						   sqrtf(2.f * _max_acceleration * position_error_norm));
+		velocity_setpoint += position_error * (correction / position_error_norm);
+	}
+
+	if (velocity_setpoint.norm() > _max_velocity) {
+		velocity_setpoint = velocity_setpoint.normalized() * _max_velocity;
+	}
+
+	_acceleration = (velocity_setpoint - _velocity) * (2.f * _bandwidth);
+
+	if (_acceleration.norm() > _max_acceleration) {
+		_acceleration = _acceleration.normalized() * _max_acceleration;
+	}
+
+	const Vector2f velocity_prev = _velocity;
+	_velocity += _acceleration * dt;
+
+	if (_velocity.norm() > _max_velocity) {
+		_velocity = _velocity.normalized() * _max_velocity;
+		_acceleration = (_velocity - velocity_prev) / dt;
+	}
+
+	_position += (velocity_prev + _velocity) * (0.5f * dt);
+}
@@ -0,0 +1,95 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file FollowTrajectory.hpp
+ *
+ * Smooth and feasible horizontal setpoints following a moving reference.
+ *
+ * The setpoint is a double integrator tracking the reference position and velocity with a
+ * critically damped second order response, with the acceleration and velocity limited to what
+ * the vehicle can fly. Jumps of the reference (e.g. a new fix after a dropout) result in a
+ * smooth transition instead of a step.
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+
+class FollowTrajectory
+{
+public:
+	FollowTrajectory() = default;
+	~FollowTrajectory() = default;
+
+	/**
+	 * @param max_velocity [m/s]
+	 * @param max_acceleration [m/s^2]
+	 */
+	void setLimits(float max_velocity, float max_acceleration)
+	{
+		_max_velocity = max_velocity;
+		_max_acceleration = max_acceleration;
+	}
+
+	/**
+	 * @param bandwidth natural frequency of the tracking [rad/s]
+	 */
+	void setBandwidth(float bandwidth) { _bandwidth = bandwidth; }
+
+	/**
+	 * Start from the current state of the vehicle
+	 */
+	void reset(const matrix::Vector2f &position, const matrix::Vector2f &velocity);
+
+	/**
+	 * Advance the setpoint
+	 * @param dt [s]
+	 * @param position reference position [m]
+	 * @param velocity reference velocity [m/s]
+	 */
+	void update(float dt, const matrix::Vector2f &position, const matrix::Vector2f &velocity);
+
+	const matrix::Vector2f &getPosition() const { return _position; }
+	const matrix::Vector2f &getVelocity() const { return _velocity; }
+	const matrix::Vector2f &getAcceleration() const { return _acceleration; }
+
+private:
+	float _max_velocity{10.f};
+	float _max_acceleration{3.f};
+	float _bandwidth{1.f};
+
+	matrix::Vector2f _position;
+	matrix::Vector2f _velocity;
+	matrix::Vector2f _acceleration;
+};
@@ -0,0 +1,212 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file TargetEstimator.cpp
+ */
+
+#include "TargetEstimator.hpp"
+
+#include <mathlib/mathlib.h>
+
+using namespace matrix;
+
+void TargetEstimator::reset()
+{
+	for (int axis = 0; axis < 2; axis++) {
+		_state[axis].zero();
+		_covariance[axis].setZero();
+	}
+
+	_time_us = 0;
+	_last_fix_us = 0;
+	_initialized = false;
+	_rejections = 0;
+}
+
+void TargetEstimator::setNoise(float position_std, float velocity_std, float acceleration_std)
+{
+	_position_variance = position_std * position_std;
+	_velocity_variance = velocity_std * velocity_std;
+	_acceleration_variance = acceleration_std * acceleration_std;
+}
+
+bool TargetEstimator::fusePosition(uint64_t time_us, const Vector2f &position)
+{
+	if (!_initialized || _rejections >= MAX_REJECTIONS || !isValid(time_us)) {
+		// start at the fix with an unknown velocity
+		for (int axis = 0; axis < 2; axis++) {
+			_state[axis] = Vector2f(position(axis), 0.f);
+			_covariance[axis].setZero();
+			_covariance[axis](0, 0) = _position_variance;
+			_covariance[axis](1, 1) = INITIAL_VELOCITY_STD * INITIAL_VELOCITY_STD;
+		}
+
+		_time_us = time_us;
+		_last_fix_us = time_us;
+		_initialized = true;
+		_rejections = 0;
+		return true;
+	}
+
+	if (time_us < _time_us) {
+		return false;
+	}
+
+	_predictState(time_us);
+
+	if (!_fuse(0, position, _position_variance)) {
+		_rejections++;
+		return false;
+	}
+
+	_rejections = 0;
+	_last_fix_us = time_us;
+	return true;
+}
+
+bool TargetEstimator::fuseVelocity(uint64_t time_us, const Vector2f &velocity)
+{
+	if (!_initialized || time_us < _time_us) {
+		return false;
+	}
+
+	_predictState(time_us);
+	return _fuse(1, velocity, _velocity_variance);
+}
+
+bool TargetEstimator::predict(uint64_t time_us, Vector2f &position, Vector2f &velocity) const
+{
+	if (!isValid(time_us)) {
+		return false;
+	}
+
+	const float dt = time_us > _time_us ? (time_us - _time_us) * 1e-6f : 0.f;
+	const float age = time_us > _last_fix_us ? (time_us - _last_fix_us) * 1e-6f : 0.f;
+
+	// constant velocity extrapolation, decaying once the fixes stop
+	float extrapolation = dt;
+	float velocity_scale = 1.f;
+
+	if (age > DAMPING_DELAY) {
+		const float damped = age - DAMPING_DELAY;
+		velocity_scale = expf(-damped / DAMPING_TIME_CONSTANT);
+		extrapolation = math::max(dt - damped, 0.f) + DAMPING_TIME_CONSTANT * (1.f - velocity_scale);
+	}
+
+	for (int axis = 0; axis < 2; axis++) {
+		position(axis) = _state[axis](0) + _state[axis](1) * extrapolation;
+		velocity(axis) = _state[axis](1) * velocity_scale;
+	}
+
+	return true;
+}
+
+bool TargetEstimator::isValid(uint64_t time_us) const
+{
+	return _initialized && (time_us < _last_fix_us || time_us - _last_fix_us < _timeout_us);
+}
+
+float TargetEstimator::getPositionStd() const
+{
+	return sqrtf(math::max(_covariance[0](0, 0), _covariance[1](0, 0)));
+}
+
+float TargetEstimator::getVelocityStd() const
+{
+	return sqrtf(math::max(_covariance[0](1, 1), _covariance[1](1, 1)));
+}
+
+void TargetEstimator::_predictState(uint64_t time_us)
+{
+	const float dt = (time_us - _time_us) * 1e-6f;
+	_time_us = time_us;
+
+	if (dt <= 0.f) {
+		return;
+	}
+
+	SquareMatrix<float, 2> F;
+	F.setIdentity();
+	F(0, 1) = dt;
+
+	// white noise acceleration
+	SquareMatrix<float, 2> Q;
+	Q(0, 0) = dt * dt * dt / 3.f;
+	Q(0, 1) = Q(1, 0) = dt * dt / 2.f;
+	Q(1, 1) = dt;
+	Q *= _acceleration_variance;
+
+	for (int axis = 0; axis < 2; axis++) {
+		_state[axis] = F * _state[axis];
+		_covariance[axis] = F * _covariance[axis] * F.transpose() + Q;
+	}
+}
+
+bool TargetEstimator::_fuse(int index, const Vector2f &measurement, float variance)
+{
+	float innovation[2];
+	float innovation_variance[2];
+
+	// both axes need to pass the gate, the fix is wrong as a whole
+	for (int axis = 0; axis < 2; axis++) {
+		innovation[axis] = measurement(axis) - _state[axis](index);
+		innovation_variance[axis] = _covariance[axis](index, index) + variance;
+
+		if (innovation[axis] * innovation[axis] > INNOVATION_GATE * INNOVATION_GATE * innovation_variance[axis]) {
+			return false;
+		}
+	}
+
+	for (int axis = 0; axis < 2; axis++) {
+		Vector2f gain;
+		gain(0) = _covariance[axis](0, index) / innovation_variance[axis];
+		gain(1) = _covariance[axis](1, index) / innovation_variance[axis];
+
+		_state[axis] += gain * innovation[axis];
+
+		SquareMatrix<float, 2> P = _covariance[axis];
+
+		for (int i = 0; i < 2; i++) {
+			for (int j = 0; j < 2; j++) {
+				P(i, j) -= gain(i) * _covariance[axis](index, j);
+			}
+		}
+
+		// keep it symmetric
+		P(0, 1) = P(1, 0) = 0.5f * (P(0, 1) + P(1, 0));
+		_covariance[axis] = P;
+	}
+
+	return true;
+}
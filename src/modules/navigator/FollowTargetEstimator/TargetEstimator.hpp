@@ -0,0 +1,126 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file TargetEstimator.hpp
+ *
+ * Horizontal position and velocity estimation of a follow target from timestamped fixes.
+ *
+ * Each axis is a constant velocity Kalman filter driven by white acceleration noise. Fixes are
+ * fused at the time they were taken, which compensates a known link delay, and the state is
+ * predicted forward to the time it is needed. If the fixes stop, the predicted velocity decays
+ * such that the target is not extrapolated indefinitely. Positions are in a local north east
+ * frame [m].
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+#include <stdint.h>
+
+class TargetEstimator
+{
+public:
+	TargetEstimator() { reset(); }
+	~TargetEstimator() = default;
+
+	void reset();
+
+	/**
+	 * @param position_std standard deviation of the position fixes [m]
+	 * @param velocity_std standard deviation of the velocity reported by the target [m/s]
+	 * @param acceleration_std standard deviation of the target acceleration [m/s^2], higher is more responsive
+	 */
+	void setNoise(float position_std, float velocity_std, float acceleration_std);
+
+	/**
+	 * @param timeout time without fixes after which the estimate is not valid anymore [s]
+	 */
+	void setTimeout(float timeout) { _timeout_us = (uint64_t)(timeout * 1e6f); }
+
+	/**
+	 * Fuse a position fix
+	 * @param time_us time at which the fix was taken [us]
+	 * @param position [m]
+	 * @return false if the fix is older than the last one or rejected as an outlier
+	 */
+	bool fusePosition(uint64_t time_us, const matrix::Vector2f &position);
+
+	/**
+	 * Fuse a velocity reported by the target, after the position of the same fix
+	 * @param time_us time at which the velocity was measured [us]
+	 * @param velocity [m/s]
+	 * @return false if the measurement is older than the last one or rejected as an outlier
+	 */
+	bool fuseVelocity(uint64_t time_us, const matrix::Vector2f &velocity);
+
+	/**
+	 * Predict the target state
+	 * @param time_us [us]
+	 * @param position [m]
+	 * @param velocity [m/s]
+	 * @return false if the estimate is not valid
+	 */
+	bool predict(uint64_t time_us, matrix::Vector2f &position, matrix::Vector2f &velocity) const;
+
+	/**
+	 * @return true if the target was seen within the timeout
+	 */
+	bool isValid(uint64_t time_us) const;
+
+	float getPositionStd() const;
+	float getVelocityStd() const;
+
+private:
+	void _predictState(uint64_t time_us);
+	bool _fuse(int index, const matrix::Vector2f &measurement, float variance);
+
+	static constexpr float INITIAL_VELOCITY_STD = 5.f; ///< [m/s]
+	static constexpr float INNOVATION_GATE = 5.f; ///< [std]
+	static constexpr int MAX_REJECTIONS = 3; ///< consecutive rejected fixes after which the filter restarts
+	static constexpr float DAMPING_DELAY = 2.f; ///< age of the last fix after which the velocity decays [s]
+	static constexpr float DAMPING_TIME_CONSTANT = 2.f; ///< [s]
+
+	float _position_variance{4.f};
+	float _velocity_variance{1.f};
+	float _acceleration_variance{1.f};
+	uint64_t _timeout_us{2500000};
+
+	// per axis: [position, velocity]
+	matrix::Vector2f _state[2];
+	matrix::SquareMatrix<float, 2> _covariance[2];
+	uint64_t _time_us{0};
+	uint64_t _last_fix_us{0};
+	bool _initialized{false};
+	int _rejections{0};
+};
@@ -0,0 +1,338 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Test code for the follow target estimator
+ * Run this test only using make tests TESTFILTER=TargetEstimator
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/matrix/math.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "FollowTrajectory.hpp"
+#include "TargetEstimator.hpp"
+
+using namespace matrix;
+
+class TargetEstimatorTest : public ::testing::Test
+{
+public:
+	struct Fix {
+		uint64_t arrival_us;
+		uint64_t time_us; ///< time at which the fix was taken
+		Vector2f position;
+	};
+
+	/** Target riding along a circle of 60m radius with a varying speed of 3 to 7 m/s */
+	static void target(float t, Vector2f &position, Vector2f &velocity)
+	{
+		const float radius = 60.f;
+		const float angle = (5.f * t + 10.f * (1.f - cosf(0.2f * t))) / radius;
+		const float angle_rate = (5.f + 2.f * sinf(0.2f * t)) / radius;
+		position = Vector2f(radius * sinf(angle), radius * (1.f - cosf(angle)));
+		velocity = Vector2f(cosf(angle), sinf(angle)) * (radius * angle_rate);
+	}
+
+	/** Deterministic pseudo random number in [0, 1) */
+	float random()
+	{
+		_seed = 1103515245u * _seed + 12345u;
+		return (float)((_seed >> 8) & 0xFFFF) / 65536.f;
+	}
+
+	/** Deterministic pseudo random normal distribution */
+	float gaussian()
+	{
+		const float u1 = fmaxf(random(), 1e-6f);
+		const float u2 = random();
+		return sqrtf(-2.f * logf(u1)) * cosf(2.f * (float)M_PI * u2);
+	}
+
+	/**
+	 * Phone GPS fixes at 5Hz with 2.5m noise, delayed by 0.3s +- 0.05s, with 20% loss and a
+	 * dropout of 4s
+	 */
+	std::vector<Fix> generateFixes(float duration)
+	{
+		std::vector<Fix> fixes;
+
+		for (uint64_t time_us = 1000000; time_us < (uint64_t)(duration * 1e6f); time_us += 200000) {
+			const float t = time_us * 1e-6f;
+			const float delay = 0.25f + 0.1f * random();
+
+			if (random() < 0.2f || (t > 30.f && t < 34.f)) {
+				continue;
+			}
+
+			Vector2f position;
+			Vector2f velocity;
+			target(t, position, velocity);
+			position += Vector2f(gaussian(), gaussian()) * POSITION_NOISE;
+			fixes.push_back({time_us + (uint64_t)(delay * 1e6f), time_us, position});
+		}
+
+		std::sort(fixes.begin(), fixes.end(), [](const Fix & a, const Fix & b) { return a.arrival_us < b.arrival_us; });
+		return fixes;
+	}
+
+	static constexpr float POSITION_NOISE = 2.5f;
+	static constexpr float DELAY = 0.3f;
+	static constexpr float MAX_VELOCITY = 12.f;
+	static constexpr float MAX_ACCELERATION = 3.f;
+	static constexpr float BANDWIDTH = 1.2f;
+
+	TargetEstimator _estimator;
+	uint32_t _seed{12345};
+};
+
+constexpr float TargetEstimatorTest::POSITION_NOISE;
+
+TEST_F(TargetEstimatorTest, straightLine)
+{
+	// GIVEN: exact fixes of a target moving on a straight line, received with a known delay
+	_estimator.setNoise(0.5f, 0.5f, 0.5f);
+	const Vector2f velocity_truth(3.f, -1.f);
+
+	for (uint64_t time_us = 0; time_us <= 10000000; time_us += 200000) {
+		EXPECT_TRUE(_estimator.fusePosition(time_us, velocity_truth * (time_us * 1e-6f)));
+	}
+
+	// WHEN: we predict to the time the last fix is received
+	const uint64_t now = 10000000 + (uint64_t)(DELAY * 1e6f);
+	Vector2f position;
+	Vector2f velocity;
+	EXPECT_TRUE(_estimator.predict(now, position, velocity));
+
+	// THEN: the delay is compensated
+	EXPECT_LT((position - velocity_truth * (now * 1e-6f)).norm(), 0.01f);
+	EXPECT_LT((velocity - velocity_truth).norm(), 0.01f);
+}
+
+TEST_F(TargetEstimatorTest, outOfOrderAndOutliers)
+{
+	// GIVEN: a standing target
+	_estimator.setNoise(1.f, 0.5f, 0.5f);
+
+	for (uint64_t time_us = 0; time_us <= 5000000; time_us += 200000) {
+		_estimator.fusePosition(time_us, Vector2f(10.f, 20.f));
+	}
+
+	// THEN: older fixes are rejected
+	EXPECT_FALSE(_estimator.fusePosition(4000000, Vector2f(10.f, 20.f)));
+
+	// AND: a single jump is rejected
+	EXPECT_FALSE(_estimator.fusePosition(5200000, Vector2f(110.f, 20.f)));
+
+	Vector2f position;
+	Vector2f velocity;
+	EXPECT_TRUE(_estimator.predict(5200000, position, velocity));
+	EXPECT_LT((position - Vector2f(10.f, 20.f)).norm(), 0.1f);
+
+	// AND: the filter restarts at the new position if the jump is confirmed
+	EXPECT_FALSE(_estimator.fusePosition(5400000, Vector2f(110.f, 20.f)));
+	EXPECT_FALSE(_estimator.fusePosition(5600000, Vector2f(110.f, 20.f)));
+	EXPECT_TRUE(_estimator.fusePosition(5800000, Vector2f(110.f, 20.f)));
+	EXPECT_TRUE(_estimator.predict(5800000, position, velocity));
+	EXPECT_LT((position - Vector2f(110.f, 20.f)).norm(), 0.1f);
+	EXPECT_LT(velocity.norm(), 0.1f);
+}
+
+TEST_F(TargetEstimatorTest, dropout)
+{
+	// GIVEN: a target moving at 5m/s
+	_estimator.setNoise(0.5f, 0.5f, 0.5f);
+	_estimator.setTimeout(5.f);
+
+	for (uint64_t time_us = 0; time_us <= 5000000; time_us += 200000) {
+		_estimator.fusePosition(time_us, Vector2f(5.f * time_us * 1e-6f, 0.f));
+	}
+
+	// WHEN: the fixes stop
+	Vector2f position;
+	Vector2f velocity;
+
+	// THEN: the target is extrapolated at full speed for a short time
+	EXPECT_TRUE(_estimator.predict(5500000, position, velocity));
+	EXPECT_NEAR(position(0), 27.5f, 0.05f);
+	EXPECT_NEAR(velocity(0), 5.f, 0.05f);
+
+	// AND: the velocity decays afterwards, such that the position converges
+	EXPECT_TRUE(_estimator.predict(9000000, position, velocity));
+	EXPECT_LT(velocity(0), 5.f * expf(-0.9f));
+	EXPECT_LT(position(0), 25.f + 5.f * 4.f);
+
+	// AND: the estimate is invalid after the timeout
+	EXPECT_FALSE(_estimator.predict(10100000, position, velocity));
+	EXPECT_FALSE(_estimator.isValid(10100000));
+
+	// AND: the filter restarts at the next fix
+	EXPECT_TRUE(_estimator.fusePosition(11000000, Vector2f(100.f, 0.f)));
+	EXPECT_TRUE(_estimator.predict(11000000, position, velocity));
+	EXPECT_LT((position - Vector2f(100.f, 0.f)).norm(), 0.01f);
+}
+
+TEST_F(TargetEstimatorTest, trajectoryLimits)
+{
+	// GIVEN: a vehicle in hover and a reference 100m away
+	FollowTrajectory trajectory;
+	trajectory.setLimits(MAX_VELOCITY, MAX_ACCELERATION);
+	trajectory.setBandwidth(0.8f);
+	trajectory.reset(Vector2f(), Vector2f());
+
+	float max_error = 0.f;
+
+	// WHEN: we fly to it
+	for (int i = 0; i < 1000; i++) {
+		trajectory.update(0.02f, Vector2f(100.f, 0.f), Vector2f());
+
+		// THEN: the velocity and acceleration limits are respected
+		EXPECT_LE(trajectory.getVelocity().norm(), MAX_VELOCITY + 1e-4f);
+		EXPECT_LE(trajectory.getAcceleration().norm(), MAX_ACCELERATION + 1e-4f);
+		max_error = fmaxf(max_error, trajectory.getPosition()(0) - 100.f);
+	}
+
+	// AND: it arrives with little overshoot
+	EXPECT_LT((trajectory.getPosition() - Vector2f(100.f, 0.f)).norm(), 0.1f);
+	EXPECT_LT(max_error, 2.f);
+}
+
+TEST_F(TargetEstimatorTest, noisyDelayedLossyTrack)
+{
+	// GIVEN: a noisy, delayed and lossy target track
+	const float duration = 60.f;
+	const std::vector<Fix> fixes = generateFixes(duration);
+
+	_estimator.setNoise(POSITION_NOISE, 1.f, 1.f);
+	_estimator.setTimeout(5.f);
+
+	FollowTrajectory trajectory;
+	trajectory.setLimits(MAX_VELOCITY, MAX_ACCELERATION);
+	trajectory.setBandwidth(BANDWIDTH);
+
+	FollowTrajectory baseline;
+	baseline.setLimits(MAX_VELOCITY, MAX_ACCELERATION);
+	baseline.setBandwidth(BANDWIDTH);
+
+	Vector2f start_position;
+	Vector2f start_velocity;
+	target(0.f, start_position, start_velocity);
+	trajectory.reset(start_position, Vector2f());
+	baseline.reset(start_position, Vector2f());
+
+	// AND: for comparison, the previous implementation: a low pass filter on the fixes with a
+	// responsiveness of 0.5 and a finite difference of the filtered fixes for the velocity
+	Vector2f baseline_position = start_position;
+	Vector2f baseline_velocity;
+	uint64_t baseline_time_us = 0;
+
+	// WHEN: the navigator runs at 20Hz and the vehicle tracks the setpoints
+	size_t fix_index = 0;
+	float error_squared = 0.f;
+	float baseline_error_squared = 0.f;
+	float error_max = 0.f;
+	float dropout_error_max = 0.f;
+	float baseline_dropout_error_max = 0.f;
+	int n = 0;
+
+	for (uint64_t now = 0; now < (uint64_t)(duration * 1e6f); now += 50000) {
+		while (fix_index < fixes.size() && fixes[fix_index].arrival_us <= now) {
+			const Fix &fix = fixes[fix_index++];
+
+			// the fix time is the arrival time with the configured delay
+			_estimator.fusePosition(fix.arrival_us - (uint64_t)(DELAY * 1e6f), fix.position);
+
+			const Vector2f filtered = baseline_position * 0.5f + fix.position * 0.5f;
+
+			if (baseline_time_us > 0) {
+				baseline_velocity = (filtered - baseline_position) / ((fix.arrival_us - baseline_time_us) * 1e-6f);
+			}
+
+			baseline_position = filtered;
+			baseline_time_us = fix.arrival_us;
+		}
+
+		Vector2f position;
+		Vector2f velocity;
+
+		if (_estimator.predict(now, position, velocity)) {
+			trajectory.update(0.05f, position, velocity);
+		}
+
+		baseline.update(0.05f, baseline_position, baseline_velocity);
+
+		EXPECT_LE(trajectory.getVelocity().norm(), MAX_VELOCITY + 1e-4f);
+		EXPECT_LE(trajectory.getAcceleration().norm(), MAX_ACCELERATION + 1e-4f);
+
+		const float t = now * 1e-6f;
+
+		if (t < 10.f) {
+			// startup
+			continue;
+		}
+
+		Vector2f truth;
+		Vector2f truth_velocity;
+		target(t, truth, truth_velocity);
+		const float error = (trajectory.getPosition() - truth).norm();
+		const float baseline_error = (baseline.getPosition() - truth).norm();
+
+		if (t > 30.f && t < 40.f) {
+			// dropout and recovery
+			dropout_error_max = fmaxf(dropout_error_max, error);
+			baseline_dropout_error_max = fmaxf(baseline_dropout_error_max, baseline_error);
+			continue;
+		}
+
+		error_squared += error * error;
+		baseline_error_squared += baseline_error * baseline_error;
+		error_max = fmaxf(error_max, error);
+		n++;
+	}
+
+	const float rms = sqrtf(error_squared / n);
+	const float baseline_rms = sqrtf(baseline_error_squared / n);
+
+	// THEN: the vehicle follows the target within the accuracy of the fixes
+	EXPECT_LT(rms, 2.f * POSITION_NOISE);
+	EXPECT_LT(error_max, 10.f);
+
+	// AND: it keeps moving with the target during the dropout
+	EXPECT_LT(dropout_error_max, 15.f);
+
+	// AND: it follows much closer than the previous implementation
+	EXPECT_LT(rms * 1.5f, baseline_rms);
+	EXPECT_LT(dropout_error_max * 1.5f, baseline_dropout_error_max);
+}
@@ -0,0 +1,265 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file RtlDestination.cpp
+ */
+
+#include "RtlDestination.hpp"
+
+#include <float.h>
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+using namespace matrix;
+
+void RtlDestination::setVehicleLimits(float cruise_speed, float climb_rate, float descent_rate)
+{
+	_cruise_speed = math::max(cruise_speed, 0.1f);
+	_climb_rate = math::max(climb_rate, 0.1f);
+	_descent_rate = math::max(descent_rate, 0.1f);
+}
+
+bool RtlDestination::setDestinations(const Destination *destinations, int count)
+{
+	_count = math::min(count, MAX_DESTINATIONS);
+
+	for (int i = 0; i < _count; i++) {
+		_destinations[i] = destinations[i];
+	}
+
+	_next = 0;
+	_evaluated = 0;
+	_best = -1;
+
+	return count <= MAX_DESTINATIONS;
+}
+
+bool RtlDestination::setDestination(const Destination &destination)
+{
+	int i = _find(destination.type, destination.index);
+
+	if (i < 0) {
+		if (_count == MAX_DESTINATIONS) {
+			return false;
+		}
+
+		i = _count++;
+	}
+
+	_destinations[i] = destination;
+	_evaluated &= ~(1u << i);
+
+	if (_best == i) {
+		_selectBest();
+	}
+
+	return true;
+}
+
+void RtlDestination::removeDestination(Type type, int index)
+{
+	const int i = _find(type, index);
+
+	if (i < 0) {
+		return;
+	}
+
+	// move the last destination into the gap
+	const int last = _count - 1;
+	_destinations[i] = _destinations[last];
+	_costs[i] = _costs[last];
+	_evaluated = (_evaluated & ~(1u << i)) | (((_evaluated >> last) & 1u) << i);
+	_evaluated &= ~(1u << last);
+	_count--;
+
+	if (_next >= _count) {
+		_next = 0;
+	}
+
+	_selectBest();
+}
+
+void RtlDestination::update(const Vector2f &position, float altitude, const Vector2f &wind, float power,
+			    float energy_available)
+{
+	_position = position;
+	_altitude = altitude;
+	_wind = PX4_ISFINITE(wind(0)) && PX4_ISFINITE(wind(1)) ? wind : Vector2f();
+	_power = power;
+	_energy_available = energy_available;
+
+	if (_count == 0) {
+		return;
+	}
+
+	// destinations that changed first, then round robin
+	int i = _next;
+
+	for (int j = 0; j < _count; j++) {
+		if (!(_evaluated & (1u << j))) {
+			i = j;
+			break;
+		}
+	}
+
+	_refresh(i);
+
+	if (i == _next) {
+		_next = (_next + 1) % _count;
+	}
+}
+
+void RtlDestination::updateAll()
+{
+	for (int i = 0; i < _count; i++) {
+		_refresh(i);
+	}
+}
+
+RtlDestination::Cost RtlDestination::evaluate(const Destination &destination) const
+{
+	Cost cost{};
+
+	const Vector2f delta = destination.position - _position;
+	const float distance = delta.norm();
+
+	// climb to the return altitude unless the destination is right below
+	float cruise_altitude = _altitude;
+
+	if (distance > _min_distance) {
+		cruise_altitude = math::max(_altitude, destination.altitude + _return_altitude);
+	}
+
+	const float climb_time = (cruise_altitude - _altitude) / _climb_rate;
+	const float descent_time = math::max(cruise_altitude - destination.altitude, 0.f) / _descent_rate;
+
+	// ground speed along the track: the air speed vector compensates the cross wind
+	float cruise_time = 0.f;
+	cost.reachable = true;
+
+	if (distance > FLT_EPSILON) {
+		const Vector2f direction = delta / distance;
+		const float wind_along = _wind.dot(direction);
+		const float wind_cross = (_wind - direction * wind_along).norm();
+
+		if (wind_cross < _cruise_speed) {
+			const float ground_speed = wind_along + sqrtf(_cruise_speed * _cruise_speed - wind_cross * wind_cross);
+
+			if (ground_speed > 0.1f) {
+				cruise_time = distance / ground_speed;
+
+			} else {
+				cost.reachable = false;
+			}
+
+		} else {
+			cost.reachable = false;
+		}
+	}
+
+	if (cost.reachable) {
+		cost.time = climb_time + cruise_time + descent_time;
+
+	} else {
+		cost.time = INFINITY;
+	}
+
+	if (PX4_ISFINITE(_power) && _power > 0.f && cost.reachable) {
+		cost.energy = _power * (cruise_time + CLIMB_POWER_RATIO * climb_time + DESCENT_POWER_RATIO * descent_time) / 3600.f;
+
+	} else {
+		cost.energy = NAN;
+	}
+
+	cost.path_allowed = (_path_checker == nullptr)
+			    || _path_checker->isPathAllowed(_position, destination.position, cruise_altitude);
+
+	const bool energy_known = PX4_ISFINITE(cost.energy) && PX4_ISFINITE(_energy_available);
+	const bool enough_energy = !energy_known || cost.energy <= (1.f - _energy_reserve) * _energy_available;
+
+	cost.safe = cost.reachable && cost.path_allowed && enough_energy;
+
+	return cost;
+}
+
+int RtlDestination::_find(Type type, int index) const
+{
+	for (int i = 0; i < _count; i++) {
+		if (_destinations[i].type == type && _destinations[i].index == index) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void RtlDestination::_refresh(int i)
+{
+	_costs[i] = evaluate(_destinations[i]);
+	_evaluated |= 1u << i;
+	_selectBest();
+}
+
+void RtlDestination::_selectBest()
+{
+	int best_safe = -1;
+	int best_allowed = -1;
+
+	for (int i = 0; i < _count; i++) {
+		if (!(_evaluated & (1u << i))) {
+			continue;
+		}
+
+		const Cost &cost = _costs[i];
+
+		if (cost.safe && (best_safe < 0 || _isCheaper(cost, _costs[best_safe]))) {
+			best_safe = i;
+		}
+
+		if (cost.reachable && cost.path_allowed && (best_allowed < 0 || _isCheaper(cost, _costs[best_allowed]))) {
+			best_allowed = i;
+		}
+	}
+
+	_best = best_safe >= 0 ? best_safe : best_allowed;
+}
+
+bool RtlDestination::_isCheaper(const Cost &a, const Cost &b) const
+{
+	if (PX4_ISFINITE(a.energy) && PX4_ISFINITE(b.energy)) {
+		return a.energy < b.energy;
+	}
+
+	return a.time < b.time;
+}
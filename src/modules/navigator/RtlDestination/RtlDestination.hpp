@@ -0,0 +1,203 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file RtlDestination.hpp
+ *
+ * Ranking of the possible return destinations (home, rally points, mission landing) by the
+ * estimated flight time and energy needed to reach and land at them.
+ *
+ * The return path to each destination is a climb to the return altitude above the destination,
+ * a straight cruise leg and a descent. The ground speed of the cruise leg is computed from the
+ * air speed and the current wind, and the energy from the present power draw. A destination is
+ * safe if the cruise leg can be flown against the wind, it does not cross the geofence and the
+ * energy needed leaves the reserve in the battery.
+ *
+ * The costs are refreshed incrementally, one destination per update, such that the best
+ * destination is always available without any computation when the return is triggered.
+ * Positions are in a local north east frame [m], altitudes AMSL [m].
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+#include <stdint.h>
+
+class RtlDestination
+{
+public:
+	static constexpr int MAX_DESTINATIONS = 18; ///< home, mission landing and up to 16 rally points
+
+	enum class Type : uint8_t {
+		home = 0,
+		safe_point,
+		mission_landing
+	};
+
+	struct Destination {
+		Type type;
+		int index; ///< rally point index, 0 for the others
+		matrix::Vector2f position; ///< [m]
+		float altitude; ///< ground altitude AMSL [m]
+	};
+
+	struct Cost {
+		float time; ///< [s], INFINITY if not reachable
+		float energy; ///< [Wh], NAN if the power is not known
+		bool reachable; ///< the cruise leg can be flown against the wind
+		bool path_allowed; ///< the path and the destination are inside the geofence
+		bool safe; ///< reachable, allowed and leaves the energy reserve
+	};
+
+	/**
+	 * Geofence test of a straight cruise leg at constant altitude
+	 */
+	class PathChecker
+	{
+	public:
+		virtual ~PathChecker() = default;
+		virtual bool isPathAllowed(const matrix::Vector2f &from, const matrix::Vector2f &to, float altitude) = 0;
+	};
+
+	RtlDestination() = default;
+	~RtlDestination() = default;
+
+	/**
+	 * @param cruise_speed horizontal air speed on the return leg [m/s]
+	 * @param climb_rate [m/s]
+	 * @param descent_rate [m/s]
+	 */
+	void setVehicleLimits(float cruise_speed, float climb_rate, float descent_rate);
+
+	/**
+	 * @param return_altitude altitude above the destination to cruise at [m]
+	 * @param min_distance below this horizontal distance the vehicle does not climb [m]
+	 */
+	void setReturnAltitude(float return_altitude, float min_distance)
+	{
+		_return_altitude = return_altitude;
+		_min_distance = min_distance;
+	}
+
+	/**
+	 * @param reserve fraction of the available energy that must be left at the destination
+	 */
+	void setEnergyReserve(float reserve) { _energy_reserve = reserve; }
+
+	void setPathChecker(PathChecker *checker) { _path_checker = checker; }
+
+	/**
+	 * Replace all destinations, the costs are evaluated again from scratch
+	 * @return false if there are too many destinations, the remaining ones are ignored
+	 */
+	bool setDestinations(const Destination *destinations, int count);
+
+	/**
+	 * Add or replace the destination of the given type and index
+	 * @return false if there is no space left
+	 */
+	bool setDestination(const Destination &destination);
+
+	/**
+	 * Remove the destination of the given type and index
+	 */
+	void removeDestination(Type type, int index);
+
+	/**
+	 * Update the vehicle state and refresh the cost of one destination
+	 * @param position [m]
+	 * @param altitude AMSL [m]
+	 * @param wind wind velocity north east [m/s]
+	 * @param power present power draw [W], NAN if unknown
+	 * @param energy_available energy left in the battery [Wh], NAN if unknown
+	 */
+	void update(const matrix::Vector2f &position, float altitude, const matrix::Vector2f &wind, float power,
+		    float energy_available);
+
+	/**
+	 * Refresh the costs of all destinations with the last vehicle state
+	 */
+	void updateAll();
+
+	/**
+	 * Estimate the cost of a return to a destination from the last vehicle state
+	 */
+	Cost evaluate(const Destination &destination) const;
+
+	/**
+	 * @return the index of the cheapest safe destination, or of the cheapest allowed one if none is safe,
+	 * -1 if there are no destinations or none is reachable
+	 */
+	int getBestIndex() const { return _best; }
+
+	int getDestinationCount() const { return _count; }
+	const Destination &getDestination(int i) const { return _destinations[i]; }
+	const Cost &getCost(int i) const { return _costs[i]; }
+
+	/**
+	 * @return true if all destinations have been evaluated since they were last changed
+	 */
+	bool isComplete() const { return _evaluated == (1u << _count) - 1u; }
+
+private:
+	int _find(Type type, int index) const;
+	void _refresh(int i);
+	void _selectBest();
+	bool _isCheaper(const Cost &a, const Cost &b) const;
+
+	static constexpr float CLIMB_POWER_RATIO = 1.5f; ///< power while climbing relative to the cruise power
+	static constexpr float DESCENT_POWER_RATIO = 0.8f; ///< power while descending relative to the cruise power
+
+	// Parameters
+	float _cruise_speed{5.f};
+	float _climb_rate{3.f};
+	float _descent_rate{1.f};
+	float _return_altitude{60.f};
+	float _min_distance{5.f};
+	float _energy_reserve{0.2f};
+	PathChecker *_path_checker{nullptr};
+
+	// Vehicle state
+	matrix::Vector2f _position;
+	float _altitude{0.f};
+	matrix::Vector2f _wind;
+	float _power{NAN};
+	float _energy_available{NAN};
+
+	Destination _destinations[MAX_DESTINATIONS] {};
+	Cost _costs[MAX_DESTINATIONS] {};
+	int _count{0};
+	int _next{0}; ///< destination to refresh with the next update
+	uint32_t _evaluated{0}; ///< bit mask of the destinations evaluated since they were changed
+	int _best{-1};
+};
@@ -0,0 +1,309 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Test code for the RTL destination ranking
+ * Run this test only using make tests TESTFILTER=RtlDestination
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/matrix/math.hpp>
+#include <px4_defines.h>
+
+#include "RtlDestination.hpp"
+
+using namespace matrix;
+
+/** Rectangular no fly zone up to a given altitude */
+class NoFlyZone : public RtlDestination::PathChecker
+{
+public:
+	NoFlyZone(const Vector2f &min, const Vector2f &max, float top = INFINITY) : _min(min), _max(max), _top(top) {}
+
+	bool isPathAllowed(const Vector2f &from, const Vector2f &to, float altitude) override
+	{
+		if (altitude > _top) {
+			checks++;
+			return true;
+		}
+
+		// sample the leg every meter
+		const int steps = (int)(to - from).norm() + 1;
+
+		for (int i = 0; i <= steps; i++) {
+			const Vector2f p = from + (to - from) * ((float)i / steps);
+
+			if (p(0) > _min(0) && p(0) < _max(0) && p(1) > _min(1) && p(1) < _max(1)) {
+				return false;
+			}
+		}
+
+		checks++;
+		return true;
+	}
+
+	int checks{0};
+
+private:
+	Vector2f _min;
+	Vector2f _max;
+	float _top;
+};
+
+class RtlDestinationTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		_planner.setVehicleLimits(12.f, 3.f, 1.5f);
+		_planner.setReturnAltitude(60.f, 5.f);
+		_planner.setEnergyReserve(0.2f);
+	}
+
+	static RtlDestination::Destination home(float north, float east, float altitude = 0.f)
+	{
+		return {RtlDestination::Type::home, 0, Vector2f(north, east), altitude};
+	}
+
+	static RtlDestination::Destination rally(int index, float north, float east, float altitude = 0.f)
+	{
+		return {RtlDestination::Type::safe_point, index, Vector2f(north, east), altitude};
+	}
+
+	/** Update until all destinations are evaluated */
+	void fly(const Vector2f &position, float altitude, const Vector2f &wind = Vector2f(), float power = 400.f,
+		 float energy = 50.f)
+	{
+		for (int i = 0; i < _planner.getDestinationCount(); i++) {
+			_planner.update(position, altitude, wind, power, energy);
+		}
+	}
+
+	RtlDestination _planner;
+};
+
+TEST_F(RtlDestinationTest, noDestinations)
+{
+	fly(Vector2f(100.f, 0.f), 50.f);
+	EXPECT_EQ(_planner.getBestIndex(), -1);
+}
+
+TEST_F(RtlDestinationTest, homeOnly)
+{
+	// GIVEN: only a home position 1km away
+	_planner.setDestination(home(0.f, 0.f));
+
+	// WHEN: we fly at the return altitude
+	fly(Vector2f(1000.f, 0.f), 60.f);
+
+	// THEN: we return home and the cost covers the cruise and the descent
+	ASSERT_EQ(_planner.getBestIndex(), 0);
+	const RtlDestination::Cost &cost = _planner.getCost(0);
+	EXPECT_TRUE(cost.safe);
+	EXPECT_NEAR(cost.time, 1000.f / 12.f + 60.f / 1.5f, 0.1f);
+	EXPECT_NEAR(cost.energy, 400.f * (1000.f / 12.f + 0.8f * 60.f / 1.5f) / 3600.f, 0.01f);
+}
+
+TEST_F(RtlDestinationTest, closerRallyPointOnTheWay)
+{
+	// GIVEN: a long range mission with rally points along the route
+	const RtlDestination::Destination destinations[] = {home(0.f, 0.f), rally(0, 2000.f, 100.f), rally(1, 4000.f, -100.f), rally(2, 6000.f, 0.f)};
+	_planner.setDestinations(destinations, 4);
+
+	// WHEN: we are past the second rally point
+	fly(Vector2f(4500.f, 0.f), 80.f);
+
+	// THEN: the closest one is chosen, not home
+	ASSERT_GE(_planner.getBestIndex(), 0);
+	const RtlDestination::Destination &best = _planner.getDestination(_planner.getBestIndex());
+	EXPECT_EQ(best.type, RtlDestination::Type::safe_point);
+	EXPECT_EQ(best.index, 1);
+}
+
+TEST_F(RtlDestinationTest, windChangesTheRanking)
+{
+	// GIVEN: home 1km north and a rally point 1.3km south
+	_planner.setDestination(home(1000.f, 0.f));
+	_planner.setDestination(rally(0, -1300.f, 0.f));
+
+	// WHEN: there is no wind
+	fly(Vector2f(), 60.f);
+
+	// THEN: home is closer
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).type, RtlDestination::Type::home);
+
+	// WHEN: a strong wind blows towards the south
+	fly(Vector2f(), 60.f, Vector2f(-9.f, 0.f));
+
+	// THEN: the rally point downwind is cheaper
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).type, RtlDestination::Type::safe_point);
+	EXPECT_NEAR(_planner.getCost(0).time, 1000.f / 3.f + 40.f, 0.5f);
+
+	// WHEN: the cross wind is faster than the vehicle
+	_planner.setDestinations(nullptr, 0);
+	_planner.setDestination(home(0.f, 1000.f));
+	fly(Vector2f(), 60.f, Vector2f(-13.f, 0.f));
+
+	// THEN: home is not reachable
+	EXPECT_FALSE(_planner.getCost(0).reachable);
+	EXPECT_EQ(_planner.getBestIndex(), -1);
+}
+
+TEST_F(RtlDestinationTest, altitudeChanges)
+{
+	// GIVEN: two rally points at the same distance, one on a hill
+	_planner.setDestination(rally(0, 500.f, 0.f, 300.f));
+	_planner.setDestination(rally(1, -500.f, 0.f, 0.f));
+
+	// WHEN: we fly low
+	fly(Vector2f(), 50.f);
+
+	// THEN: the one in the valley is cheaper since we do not need to climb
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).index, 1);
+	EXPECT_GT(_planner.getCost(0).time, _planner.getCost(1).time + 300.f / 3.f - 1.f);
+}
+
+TEST_F(RtlDestinationTest, geofence)
+{
+	// GIVEN: a rally point behind a no fly zone and home further away
+	NoFlyZone zone(Vector2f(200.f, -100.f), Vector2f(300.f, 100.f));
+	_planner.setPathChecker(&zone);
+	_planner.setDestination(home(-1000.f, 0.f));
+	_planner.setDestination(rally(0, 500.f, 0.f));
+	_planner.setDestination(rally(1, 500.f, 400.f));
+
+	// WHEN: we fly
+	fly(Vector2f(), 60.f);
+
+	// THEN: the path through the zone is not allowed, the rally point next to it is used
+	EXPECT_FALSE(_planner.getCost(1).path_allowed);
+	EXPECT_FALSE(_planner.getCost(1).safe);
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).index, 1);
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).type, RtlDestination::Type::safe_point);
+
+	// WHEN: the zone only extends to 50m and the destination is evaluated at the return altitude
+	NoFlyZone low_zone(Vector2f(200.f, -100.f), Vector2f(300.f, 100.f), 50.f);
+	_planner.setPathChecker(&low_zone);
+	fly(Vector2f(), 60.f);
+
+	// THEN: we fly over it
+	EXPECT_TRUE(_planner.getCost(1).path_allowed);
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).index, 0);
+}
+
+TEST_F(RtlDestinationTest, energyReserve)
+{
+	// GIVEN: home 3km away and a rally point 2.5km away
+	_planner.setDestination(home(0.f, 0.f));
+	_planner.setDestination(rally(0, 3000.f, 2500.f));
+
+	// WHEN: there is enough energy
+	fly(Vector2f(3000.f, 0.f), 60.f, Vector2f(), 400.f, 50.f);
+
+	// THEN: both are safe and the rally point is cheaper
+	EXPECT_TRUE(_planner.getCost(0).safe);
+	EXPECT_TRUE(_planner.getCost(1).safe);
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).type, RtlDestination::Type::safe_point);
+
+	// WHEN: home would eat into the reserve
+	const float energy_home = _planner.getCost(0).energy;
+	const float energy_rally = _planner.getCost(1).energy;
+	fly(Vector2f(3000.f, 0.f), 60.f, Vector2f(), 400.f, (energy_home + energy_rally) / 2.f / 0.8f);
+
+	// THEN: only the rally point is safe
+	EXPECT_FALSE(_planner.getCost(0).safe);
+	EXPECT_TRUE(_planner.getCost(1).safe);
+
+	// WHEN: nothing is safe anymore
+	fly(Vector2f(3000.f, 0.f), 60.f, Vector2f(), 400.f, 0.5f * energy_rally);
+
+	// THEN: the cheapest destination is still returned and reported as not safe
+	EXPECT_FALSE(_planner.getCost(_planner.getBestIndex()).safe);
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).type, RtlDestination::Type::safe_point);
+
+	// WHEN: the power is not known
+	fly(Vector2f(3000.f, 0.f), 60.f, Vector2f(), NAN, NAN);
+
+	// THEN: the destinations are ranked by time
+	EXPECT_FALSE(PX4_ISFINITE(_planner.getCost(0).energy));
+	EXPECT_TRUE(_planner.getCost(0).safe);
+	EXPECT_LT(_planner.getCost(1).time, _planner.getCost(0).time);
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).type, RtlDestination::Type::safe_point);
+}
+
+TEST_F(RtlDestinationTest, incrementalRefresh)
+{
+	// GIVEN: a layout of 16 rally points on a grid and home
+	NoFlyZone zone(Vector2f(1e5f, 1e5f), Vector2f(1e5f + 1.f, 1e5f + 1.f));
+	_planner.setPathChecker(&zone);
+	_planner.setDestination(home(0.f, 0.f));
+
+	for (int i = 0; i < 16; i++) {
+		_planner.setDestination(rally(i, 1000.f * (i / 4), 1000.f * (i % 4)));
+	}
+
+	EXPECT_EQ(_planner.getDestinationCount(), 17);
+	EXPECT_FALSE(_planner.setDestination(rally(16, 0.f, 0.f)) && _planner.setDestination(rally(17, 0.f, 0.f)));
+
+	// WHEN: we update once
+	_planner.removeDestination(RtlDestination::Type::safe_point, 16);
+	_planner.update(Vector2f(2900.f, 2900.f), 60.f, Vector2f(), 400.f, 50.f);
+
+	// THEN: only one destination is evaluated
+	EXPECT_EQ(zone.checks, 1);
+	EXPECT_FALSE(_planner.isComplete());
+
+	// WHEN: we keep updating
+	for (int i = 1; i < 17; i++) {
+		_planner.update(Vector2f(2900.f, 2900.f), 60.f, Vector2f(), 400.f, 50.f);
+	}
+
+	// THEN: each destination is evaluated once and the closest rally point is selected
+	EXPECT_EQ(zone.checks, 17);
+	EXPECT_TRUE(_planner.isComplete());
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).index, 15);
+
+	// WHEN: we fly somewhere else
+	for (int i = 0; i < 17; i++) {
+		_planner.update(Vector2f(100.f, 1100.f), 60.f, Vector2f(), 400.f, 50.f);
+	}
+
+	// THEN: the ranking follows within one round
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).index, 1);
+
+	// AND: removing the best destination selects the next best
+	_planner.removeDestination(RtlDestination::Type::safe_point, 1);
+	EXPECT_EQ(_planner.getDestinationCount(), 16);
+	EXPECT_EQ(_planner.getDestination(_planner.getBestIndex()).type, RtlDestination::Type::safe_point);
+	EXPECT_NE(_planner.getDestination(_planner.getBestIndex()).index, 1);
+}
@@ -65,11 +65,25 @@ FollowTarget::FollowTarget(Navigator *navigator) :
 	ModuleParams(navigator)
 {
 	_current_vel.zero();
-	_step_vel.zero();
-	_est_target_vel.zero();
-	_target_distance.zero();
 	_target_position_offset.zero();
-	_target_position_delta.zero();
+
+	_handle_mc_max_velocity = param_find("MPC_XY_VEL_MAX");
+	_handle_mc_max_acceleration = param_find("MPC_ACC_HOR");
+
+	updateParams();
+}
+
+void FollowTarget::updateParams()
+{
+	ModuleParams::updateParams();
+
+	if (_handle_mc_max_velocity != PARAM_INVALID) {
+		param_get(_handle_mc_max_velocity, &_mc_max_velocity);
+	}
+
+	if (_handle_mc_max_acceleration != PARAM_INVALID) {
+		param_get(_handle_mc_max_acceleration, &_mc_max_acceleration);
+	}
 }
 
 void FollowTarget::on_inactive()
@@ -90,192 +104,74 @@ void FollowTarget::on_activation()
 	}
 
 	_rot_matrix = Dcmf(_follow_position_matricies[_follow_target_position]);
+
+	// a lower responsiveness setting allows the target to change its velocity faster
+	_target_estimator.setNoise(TARGET_POSITION_STD, TARGET_VELOCITY_STD, math::max(2.0F * (1.0F - _responsiveness), 0.2F));
+	_target_estimator.setTimeout(TARGET_TIMEOUT_MS / 1000.0F);
+
+	_trajectory.setBandwidth(TRAJECTORY_BANDWIDTH);
 }
 
 void FollowTarget::on_active()
 {
-	struct map_projection_reference_s target_ref;
-	follow_target_s target_motion_with_offset = {};
-	uint64_t current_time = hrt_absolute_time();
-	bool _radius_entered = false;
-	bool _radius_exited = false;
-	bool updated = false;
-	float dt_ms = 0;
+	const hrt_abstime current_time = hrt_absolute_time();
 
-	if (_follow_target_sub.updated()) {
-		follow_target_s target_motion;
+	update_target_estimate();
 
-		_target_updates++;
-
-		// save last known motion topic
-
-		_previous_target_motion = _current_target_motion;
-
-		_follow_target_sub.copy(&target_motion);
-
-		if (_current_target_motion.timestamp == 0) {
-			_current_target_motion = target_motion;
-		}
+	// predict the target to now, which compensates the link delay and bridges short dropouts
 
-		_current_target_motion.timestamp = target_motion.timestamp;
-		_current_target_motion.lat = (_current_target_motion.lat * (double)_responsiveness) + target_motion.lat * (double)(
-						     1 - _responsiveness);
-		_current_target_motion.lon = (_current_target_motion.lon * (double)_responsiveness) + target_motion.lon * (double)(
-						     1 - _responsiveness);
+	Vector2f target_position;
+	Vector2f target_velocity;
+	const bool target_valid = _target_estimator.predict(current_time, target_position, target_velocity);
 
-	} else if (((current_time - _current_target_motion.timestamp) / 1000) > TARGET_TIMEOUT_MS && target_velocity_valid()) {
+	if (!target_valid && target_position_valid()) {
 		reset_target_validity();
 	}
 
-	// update distance to target
-
-	if (target_position_valid()) {
-
-		// get distance to target
-
-		map_projection_init(&target_ref, _navigator->get_global_position()->lat, _navigator->get_global_position()->lon);
-		map_projection_project(&target_ref, _current_target_motion.lat, _current_target_motion.lon, &_target_distance(0),
-				       &_target_distance(1));
-
-	}
-
-	// update target velocity
-
-	if (target_velocity_valid() && updated) {
-
-		dt_ms = ((_current_target_motion.timestamp - _previous_target_motion.timestamp) / 1000);
-
-		// ignore a small dt
-		if (dt_ms > 10.0F) {
-			// get last gps known reference for target
-			map_projection_init(&target_ref, _previous_target_motion.lat, _previous_target_motion.lon);
+	// update state machine
 
-			// calculate distance the target has moved
-			map_projection_project(&target_ref, _current_target_motion.lat, _current_target_motion.lon,
-					       &(_target_position_delta(0)), &(_target_position_delta(1)));
+	switch (_follow_target_state) {
 
-			// update the average velocity of the target based on the position
-			_est_target_vel = _target_position_delta / (dt_ms / 1000.0f);
+	case TRACK_TARGET: {
 
 			// if the target is moving add an offset and rotation
-			if (_est_target_vel.length() > .5F) {
-				_target_position_offset = _rot_matrix * _est_target_vel.normalized() * _follow_offset;
+
+			if (target_velocity.length() > .5F) {
+				const Vector3f direction(target_velocity(0), target_velocity(1), 0.0F);
+				_target_position_offset = _rot_matrix * direction.normalized() * _follow_offset;
 			}
 
-			// are we within the target acceptance radius?
-			// give a buffer to exit/enter the radius to give the velocity controller
-			// a chance to catch up
+			// smooth and feasible setpoints towards the predicted target with offset
 
-			_radius_exited = ((_target_position_offset + _target_distance).length() > (float) TARGET_ACCEPTANCE_RADIUS_M * 1.5f);
-			_radius_entered = ((_target_position_offset + _target_distance).length() < (float) TARGET_ACCEPTANCE_RADIUS_M);
+			const float dt = math::constrain((current_time - _last_update_time) * 1e-6f, 0.0F, 0.1F);
+			_last_update_time = current_time;
 
-			// to keep the velocity increase/decrease smooth
-			// calculate how many velocity increments/decrements
-			// it will take to reach the targets velocity
-			// with the given amount of steps also add a feed forward input that adjusts the
-			// velocity as the position gap increases since
-			// just traveling at the exact velocity of the target will not
-			// get any closer or farther from the target
+			const Vector2f offset(_target_position_offset(0), _target_position_offset(1));
+			_trajectory.update(dt, target_position + offset, target_velocity);
 
-			_step_vel = (_est_target_vel - _current_vel) + (_target_position_offset + _target_distance) * FF_K;
-			_step_vel /= (dt_ms / 1000.0F * (float) INTERPOLATION_PNTS);
-			_step_time_in_ms = (dt_ms / (float) INTERPOLATION_PNTS);
+			const Vector2f &setpoint = _trajectory.getPosition();
+			const Vector2f to_target = target_position - setpoint;
 
 			// if we are less than 1 meter from the target don't worry about trying to yaw
 			// lock the yaw until we are at a distance that makes sense
 
-			if ((_target_distance).length() > 1.0F) {
-
-				// yaw rate smoothing
-
-				// this really needs to control the yaw rate directly in the attitude pid controller
-				// but seems to work ok for now since the yaw rate cannot be controlled directly in auto mode
-
-				_yaw_angle = get_bearing_to_next_waypoint(_navigator->get_global_position()->lat,
-						_navigator->get_global_position()->lon,
-						_current_target_motion.lat,
-						_current_target_motion.lon);
-
-				_yaw_rate = wrap_pi((_yaw_angle - _navigator->get_global_position()->yaw) / (dt_ms / 1000.0f));
-
-			} else {
-				_yaw_angle = _yaw_rate = NAN;
-			}
-		}
-
-//		warnx(" _step_vel x %3.6f y %3.6f cur vel %3.6f %3.6f tar vel %3.6f %3.6f dist = %3.6f (%3.6f) mode = %d yaw rate = %3.6f",
-//				(double) _step_vel(0),
-//				(double) _step_vel(1),
-//				(double) _current_vel(0),
-//				(double) _current_vel(1),
-//				(double) _est_target_vel(0),
-//				(double) _est_target_vel(1),
-//				(double) (_target_distance).length(),
-//				(double) (_target_position_offset + _target_distance).length(),
-//				_follow_target_state,
-//				(double) _yaw_rate);
-	}
-
-	if (target_position_valid()) {
-
-		// get the target position using the calculated offset
-
-		map_projection_init(&target_ref,  _current_target_motion.lat, _current_target_motion.lon);
-		map_projection_reproject(&target_ref, _target_position_offset(0), _target_position_offset(1),
-					 &target_motion_with_offset.lat, &target_motion_with_offset.lon);
-	}
-
-	// clamp yaw rate smoothing if we are with in
-	// 3 degrees of facing target
-
-	if (PX4_ISFINITE(_yaw_rate)) {
-		if (fabsf(fabsf(_yaw_angle) - fabsf(_navigator->get_global_position()->yaw)) < math::radians(3.0F)) {
-			_yaw_rate = NAN;
-		}
-	}
-
-	// update state machine
-
-	switch (_follow_target_state) {
-
-	case TRACK_POSITION: {
-
-			if (_radius_entered == true) {
-				_follow_target_state = TRACK_VELOCITY;
-
-			} else if (target_velocity_valid()) {
-				set_follow_target_item(&_mission_item, _param_nav_min_ft_ht.get(), target_motion_with_offset, _yaw_angle);
-				// keep the current velocity updated with the target velocity for when it's needed
-				_current_vel = _est_target_vel;
-
-				update_position_sp(true, true, _yaw_rate);
+			if (to_target.length() > 1.0F) {
+				_yaw_angle = atan2f(to_target(1), to_target(0));
 
 			} else {
-				_follow_target_state = SET_WAIT_FOR_TARGET_POSITION;
+				_yaw_angle = NAN;
 			}
 
-			break;
-		}
-
-	case TRACK_VELOCITY: {
-
-			if (_radius_exited == true) {
-				_follow_target_state = TRACK_POSITION;
-
-			} else if (target_velocity_valid()) {
+			follow_target_s target_motion_with_offset{};
+			map_projection_reproject(&_target_ref, setpoint(0), setpoint(1),
+						 &target_motion_with_offset.lat, &target_motion_with_offset.lon);
 
-				if ((float)(current_time - _last_update_time) / 1000.0f >= _step_time_in_ms) {
-					_current_vel += _step_vel;
-					_last_update_time = current_time;
-				}
+			_current_vel(0) = _trajectory.getVelocity()(0);
+			_current_vel(1) = _trajectory.getVelocity()(1);
 
-				set_follow_target_item(&_mission_item, _param_nav_min_ft_ht.get(), target_motion_with_offset, _yaw_angle);
+			set_follow_target_item(&_mission_item, _param_nav_min_ft_ht.get(), target_motion_with_offset, _yaw_angle);
 
-				update_position_sp(true, false, _yaw_rate);
-
-			} else {
-				_follow_target_state = SET_WAIT_FOR_TARGET_POSITION;
-			}
+			update_position_sp(true, true, _yaw_rate);
 
 			break;
 		}
@@ -306,7 +202,9 @@ void FollowTarget::on_active()
 
 			if (is_mission_item_reached() && target_velocity_valid()) {
 				_target_position_offset(0) = _follow_offset;
-				_follow_target_state = TRACK_POSITION;
+				reset_trajectory();
+				_last_update_time = current_time;
+				_follow_target_state = TRACK_TARGET;
 			}
 
 			break;
@@ -314,6 +212,48 @@ void FollowTarget::on_active()
 	}
 }
 
+void FollowTarget::update_target_estimate()
+{
+	if (!_follow_target_sub.updated()) {
+		return;
+	}
+
+	follow_target_s target_motion;
+	_follow_target_sub.copy(&target_motion);
+
+	if (!_target_ref_valid) {
+		map_projection_init(&_target_ref, target_motion.lat, target_motion.lon);
+		_target_ref_valid = true;
+	}
+
+	Vector2f position;
+	map_projection_project(&_target_ref, target_motion.lat, target_motion.lon, &position(0), &position(1));
+
+	// the fix was taken before it was received
+	const uint64_t delay = (uint64_t)(math::max(_param_nav_ft_delay.get(), 0.0F) * 1e6f);
+	const uint64_t fix_time = target_motion.timestamp > delay ? target_motion.timestamp - delay : 0;
+
+	if (_target_estimator.fusePosition(fix_time, position)) {
+		_target_updates++;
+
+		if ((target_motion.est_cap & (1 << VEL)) && PX4_ISFINITE(target_motion.vx) && PX4_ISFINITE(target_motion.vy)) {
+			_target_estimator.fuseVelocity(fix_time, Vector2f(target_motion.vx, target_motion.vy));
+		}
+	}
+}
+
+void FollowTarget::reset_trajectory()
+{
+	Vector2f position;
+	map_projection_project(&_target_ref, _navigator->get_global_position()->lat, _navigator->get_global_position()->lon,
+			       &position(0), &position(1));
+
+	const Vector2f velocity(_navigator->get_global_position()->vel_n, _navigator->get_global_position()->vel_e);
+
+	_trajectory.setLimits(_mc_max_velocity, _mc_max_acceleration);
+	_trajectory.reset(position, velocity);
+}
+
 void FollowTarget::update_position_sp(bool use_velocity, bool use_position, float yaw_rate)
 {
 	// convert mission item to current setpoint
@@ -340,13 +280,10 @@ void FollowTarget::update_position_sp(bool use_velocity, bool use_position, floa
 void FollowTarget::reset_target_validity()
 {
 	_yaw_rate = NAN;
-	_previous_target_motion = {};
-	_current_target_motion = {};
 	_target_updates = 0;
+	_target_estimator.reset();
+	_target_ref_valid = false;
 	_current_vel.zero();
-	_step_vel.zero();
-	_est_target_vel.zero();
-	_target_distance.zero();
 	_target_position_offset.zero();
 	reset_mission_item_reached();
 	_follow_target_state = SET_WAIT_FOR_TARGET_POSITION;
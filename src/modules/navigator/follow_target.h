@@ -46,6 +46,9 @@
 #include <mathlib/mathlib.h>
 #include <matrix/math.hpp>
 
+#include <FollowTrajectory.hpp>
+#include <TargetEstimator.hpp>
+#include <lib/ecl/geo/geo.h>
 #include <px4_module_params.h>
 #include <uORB/Subscription.hpp>
 #include <uORB/topics/follow_target.h>
@@ -61,17 +64,19 @@ public:
 	void on_activation() override;
 	void on_active() override;
 
+protected:
+	void updateParams() override;
+
 private:
 
 	static constexpr int TARGET_TIMEOUT_MS = 2500;
-	static constexpr int TARGET_ACCEPTANCE_RADIUS_M = 5;
-	static constexpr int INTERPOLATION_PNTS = 20;
-	static constexpr float FF_K = .25F;
 	static constexpr float OFFSET_M = 8;
+	static constexpr float TARGET_POSITION_STD = 2.5f; ///< typical accuracy of a phone GPS [m]
+	static constexpr float TARGET_VELOCITY_STD = 1.f; ///< [m/s]
+	static constexpr float TRAJECTORY_BANDWIDTH = 1.2f; ///< [rad/s]
 
 	enum FollowTargetState {
-		TRACK_POSITION,
-		TRACK_VELOCITY,
+		TRACK_TARGET,
 		SET_WAIT_FOR_TARGET_POSITION,
 		WAIT_FOR_TARGET_POSITION
 	};
@@ -94,34 +99,39 @@ private:
 		(ParamFloat<px4::params::NAV_MIN_FT_HT>) _param_nav_min_ft_ht,
 		(ParamFloat<px4::params::NAV_FT_DST>) _param_nav_ft_dst,
 		(ParamInt<px4::params::NAV_FT_FS>) _param_nav_ft_fs,
-		(ParamFloat<px4::params::NAV_FT_RS>) _param_nav_ft_rs
+		(ParamFloat<px4::params::NAV_FT_RS>) _param_nav_ft_rs,
+		(ParamFloat<px4::params::NAV_FT_DELAY>) _param_nav_ft_delay
 	)
 
 	FollowTargetState _follow_target_state{SET_WAIT_FOR_TARGET_POSITION};
 	int _follow_target_position{FOLLOW_FROM_BEHIND};
 
 	uORB::Subscription _follow_target_sub{ORB_ID(follow_target)};
-	float _step_time_in_ms{0.0f};
 	float _follow_offset{OFFSET_M};
 
 	uint64_t _target_updates{0};
 	uint64_t _last_update_time{0};
 
+	TargetEstimator _target_estimator;
+	FollowTrajectory _trajectory;
+
+	// local frame of the target estimate, centered at the first fix
+	map_projection_reference_s _target_ref{};
+	bool _target_ref_valid{false};
+
 	matrix::Vector3f _current_vel;
-	matrix::Vector3f _step_vel;
-	matrix::Vector3f _est_target_vel;
-	matrix::Vector3f _target_distance;
 	matrix::Vector3f _target_position_offset;
-	matrix::Vector3f _target_position_delta;
-	matrix::Vector3f _filtered_target_position_delta;
-
-	follow_target_s _current_target_motion{};
-	follow_target_s _previous_target_motion{};
 
 	float _yaw_rate{0.0f};
 	float _responsiveness{0.0f};
 	float _yaw_angle{0.0f};
 
+	// MC limits, not available on all vehicle types
+	param_t _handle_mc_max_velocity{PARAM_INVALID};
+	param_t _handle_mc_max_acceleration{PARAM_INVALID};
+	float _mc_max_velocity{12.f};
+	float _mc_max_acceleration{3.f};
+
 	// Mavlink defined motion reporting capabilities
 	enum {
 		POS = 0,
@@ -132,14 +142,20 @@ private:
 
 	matrix::Dcmf _rot_matrix;
 
-	void track_target_position();
-	void track_target_velocity();
 	bool target_velocity_valid();
 	bool target_position_valid();
 	void reset_target_validity();
 	void update_position_sp(bool velocity_valid, bool position_valid, float yaw_rate);
-	void update_target_motion();
-	void update_target_velocity();
+
+	/**
+	 * Fuse new target fixes into the target estimate
+	 */
+	void update_target_estimate();
+
+	/**
+	 * Start the follow trajectory from the current vehicle state
+	 */
+	void reset_trajectory();
 
 	/**
 	 * Set follow_target item
@@ -82,6 +82,8 @@ PARAM_DEFINE_INT32(NAV_FT_FS, 1);
  * lower numbers increase the responsiveness to changing long lat
  * but also ignore less noise
  *
+ * Sets the acceleration the target estimate allows for, from 0.2 m/s^2 (1.0) to 1.8 m/s^2 (0.1).
+ *
  * @unit n/a
  * @min 0.0
  * @max 1.0
@@ -90,3 +92,19 @@ PARAM_DEFINE_INT32(NAV_FT_FS, 1);
  */
 PARAM_DEFINE_FLOAT(NAV_FT_RS, 0.5f);
 
+
+/**
+ * Follow target position delay
+ *
+ * Time between the target taking a position fix and it being received, such as the
+ * GPS latency of the phone and the telemetry link delay. The target is predicted forward by
+ * this time.
+ *
+ * @unit s
+ * @min 0.0
+ * @max 2.0
+ * @decimal 2
+ * @increment 0.05
+ * @group Follow target
+ */
+PARAM_DEFINE_FLOAT(NAV_FT_DELAY, 0.3f);
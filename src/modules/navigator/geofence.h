@@ -97,6 +97,14 @@ public:
 	 */
 	bool check(const struct mission_item_s &mission_item);
 
+	/**
+	 * Return whether a point is inside the polygons and altitude limits, without reporting violations.
+	 * Used to plan paths ahead of time.
+	 *
+	 * @return false if the point would violate the fence
+	 */
+	bool checkPoint(double lat, double lon, float altitude) { return checkPolygons(lat, lon, altitude); }
+
 	int clearDm();
 
 	bool valid();
@@ -401,14 +401,56 @@ Mission::find_mission_land_start()
 		    (missionitem.nav_cmd == NAV_CMD_LAND)) {
 			_land_start_available = true;
 			_land_start_index = i;
+			find_mission_land_position();
 			return true;
 		}
 	}
 
 	_land_start_available = false;
+	_land_position_available = false;
 	return false;
 }
 
+void
+Mission::find_mission_land_position()
+{
+	// the touchdown point is the first landing item of the landing sequence
+	const dm_item_t dm_current = (dm_item_t)_mission.dataman_id;
+	_land_position_available = false;
+
+	for (size_t i = _land_start_index; i < _mission.count; i++) {
+		struct mission_item_s missionitem = {};
+		const ssize_t len = sizeof(missionitem);
+
+		if (dm_read(dm_current, i, &missionitem, len) != len) {
+			PX4_ERR("dataman read failure");
+			break;
+		}
+
+		if ((missionitem.nav_cmd == NAV_CMD_VTOL_LAND) || (missionitem.nav_cmd == NAV_CMD_LAND)) {
+			_land_lat = missionitem.lat;
+			_land_lon = missionitem.lon;
+			_land_alt = missionitem.altitude;
+			_land_alt_is_relative = missionitem.altitude_is_relative;
+			_land_position_available = true;
+			break;
+		}
+	}
+}
+
+bool
+Mission::get_land_position(double &lat, double &lon, float &alt) const
+{
+	if (!_land_start_available || !_land_position_available) {
+		return false;
+	}
+
+	lat = _land_lat;
+	lon = _land_lon;
+	alt = _land_alt_is_relative ? _land_alt + _navigator->get_home_position()->alt : _land_alt;
+	return true;
+}
+
 bool
 Mission::land_start()
 {
@@ -651,6 +693,7 @@ Mission::set_mission_items()
 			user_feedback_done = true;
 		}
 
+		publish_mission_lookahead();
 		_navigator->set_position_setpoint_triplet_updated();
 		return;
 	}
@@ -1084,6 +1127,7 @@ Mission::set_mission_items()
 						     pos_sp_triplet->previous.lat, pos_sp_triplet->previous.lon);
 	}
 
+	publish_mission_lookahead();
 	_navigator->set_position_setpoint_triplet_updated();
 }
 
@@ -1546,6 +1590,135 @@ Mission::read_mission_item(int offset, struct mission_item_s *mission_item)
 	return false;
 }
 
+bool
+Mission::read_lookahead_item(int *index, lookahead_jumps_s *jumps, struct mission_item_s *mission_item)
+{
+	const dm_item_t dm_item = (dm_item_t)_mission.dataman_id;
+	const bool execute_jumps = _mission_execution_mode == mission_result_s::MISSION_EXECUTION_MODE_NORMAL;
+
+	/* follow the DO_JUMPs like read_mission_item(), give up after 10 of them */
+	for (int i = 0; i < 10; i++) {
+		if (*index < 0 || *index >= (int)_mission.count) {
+			return false;
+		}
+
+		if (dm_read(dm_item, *index, mission_item, sizeof(struct mission_item_s)) != sizeof(struct mission_item_s)) {
+			return false;
+		}
+
+		if (mission_item->nav_cmd != NAV_CMD_DO_JUMP) {
+			(*index)++;
+			return true;
+		}
+
+		/* the repetitions taken while reading ahead are only counted locally, not written to dataman */
+		int jump = 0;
+
+		while (jump < jumps->count && jumps->index[jump] != *index) {
+			jump++;
+		}
+
+		if (jump == jumps->count) {
+			if (jumps->count >= lookahead_jumps_s::MAX_JUMPS) {
+				return false;
+			}
+
+			jumps->index[jump] = *index;
+			jumps->taken[jump] = 0;
+			jumps->count++;
+		}
+
+		if (execute_jumps
+		    && mission_item->do_jump_current_count + jumps->taken[jump] < mission_item->do_jump_repeat_count) {
+			jumps->taken[jump]++;
+			*index = mission_item->do_jump_mission_index;
+
+		} else {
+			(*index)++;
+		}
+	}
+
+	return false;
+}
+
+void
+Mission::publish_mission_lookahead()
+{
+	mission_lookahead_s lookahead{};
+
+	const position_setpoint_s &next_sp = _navigator->get_position_setpoint_triplet()->next;
+
+	/* only forward missions are planned ahead, reverse missions stop at every waypoint anyway */
+	if (next_sp.valid && _mission_type == MISSION_TYPE_MISSION
+	    && _mission_execution_mode != mission_result_s::MISSION_EXECUTION_MODE_REVERSE) {
+
+		lookahead.anchor_lat = next_sp.lat;
+		lookahead.anchor_lon = next_sp.lon;
+
+		/* walk the mission in execution order, starting after the current item */
+		int index = _current_mission_index + 1;
+		lookahead_jumps_s jumps{};
+		bool next_found = false;
+		mission_item_s mission_item;
+
+		while (lookahead.count < mission_lookahead_s::MAX_ITEMS
+		       && read_lookahead_item(&index, &jumps, &mission_item)) {
+
+			if (!item_contains_position(mission_item)) {
+				continue;
+			}
+
+			if (!next_found) {
+				/* the first position item is already published as triplet next,
+				 * nothing follows it if it is not (e.g. during takeoff) */
+				next_found = true;
+
+				if (item_requires_stop(mission_item)
+				    || fabs(mission_item.lat - next_sp.lat) > 1e-7
+				    || fabs(mission_item.lon - next_sp.lon) > 1e-7) {
+					break;
+				}
+
+				continue;
+			}
+
+			mission_apply_limitation(mission_item);
+
+			position_setpoint_s sp{};
+
+			if (!mission_item_to_position_setpoint(mission_item, &sp)) {
+				break;
+			}
+
+			const uint8_t i = lookahead.count++;
+			lookahead.lat[i] = sp.lat;
+			lookahead.lon[i] = sp.lon;
+			lookahead.alt[i] = sp.alt;
+			lookahead.acceptance_radius[i] = sp.acceptance_radius;
+			lookahead.stop[i] = item_requires_stop(mission_item);
+
+			if (lookahead.stop[i]) {
+				break;
+			}
+		}
+	}
+
+	lookahead.timestamp = hrt_absolute_time();
+	_mission_lookahead_pub.publish(lookahead);
+}
+
+bool
+Mission::item_requires_stop(const mission_item_s &item) const
+{
+	return !item.autocontinue
+	       || get_time_inside(item) > FLT_EPSILON
+	       || item.nav_cmd == NAV_CMD_LAND
+	       || item.nav_cmd == NAV_CMD_VTOL_LAND
+	       || item.nav_cmd == NAV_CMD_TAKEOFF
+	       || item.nav_cmd == NAV_CMD_VTOL_TAKEOFF
+	       || item.nav_cmd == NAV_CMD_LOITER_UNLIMITED;
+}
+
 void
 Mission::save_mission_state()
 {
@@ -53,9 +53,11 @@
 #include <dataman/dataman.h>
 #include <drivers/drv_hrt.h>
 #include <px4_module_params.h>
+#include <uORB/Publication.hpp>
 #include <uORB/Subscription.hpp>
 #include <uORB/topics/home_position.h>
 #include <uORB/topics/mission.h>
+#include <uORB/topics/mission_lookahead.h>
 #include <uORB/topics/mission_result.h>
 #include <uORB/topics/position_setpoint_triplet.h>
 #include <uORB/topics/vehicle_global_position.h>
@@ -88,6 +90,12 @@ public:
 
 	uint16_t get_land_start_index() const { return _land_start_index; }
 	bool get_land_start_available() const { return _land_start_available; }
+
+	/**
+	 * Get the touchdown position of the planned mission landing
+	 * @return false if the mission has no landing
+	 */
+	bool get_land_position(double &lat, double &lon, float &alt) const;
 	bool get_mission_finished() const { return _mission_type == MISSION_TYPE_NONE; }
 	bool get_mission_changed() const { return _mission_changed ; }
 	bool get_mission_waypoints_changed() const { return _mission_waypoints_changed ; }
@@ -184,6 +192,33 @@ private:
 	 */
 	bool read_mission_item(int offset, struct mission_item_s *mission_item);
 
+	/**
+	 * DO_JUMP repetitions taken while reading ahead of the current mission item
+	 */
+	struct lookahead_jumps_s {
+		static constexpr int MAX_JUMPS = 4;
+		int index[MAX_JUMPS];
+		uint16_t taken[MAX_JUMPS];
+		int count;
+	};
+
+	/**
+	 * Read the mission item at index in execution order, following DO_JUMPs that still have repetitions left.
+	 * The index is advanced to the item that is executed next.
+	 */
+	bool read_lookahead_item(int *index, lookahead_jumps_s *jumps, struct mission_item_s *mission_item);
+
+	/**
+	 * Publish the position mission items following the triplet next setpoint,
+	 * up to the first item the vehicle has to stop at.
+	 */
+	void publish_mission_lookahead();
+
+	/**
+	 * Returns true if the vehicle has to come to a halt at the given mission item
+	 */
+	bool item_requires_stop(const mission_item_s &item) const;
+
 	/**
 	 * Save current mission state to dataman
 	 */
@@ -229,6 +264,11 @@ private:
 	 */
 	bool find_mission_land_start();
 
+	/**
+	 * Find and store the touchdown position of the landing sequence
+	 */
+	void find_mission_land_position();
+
 	/**
 	 * Return the index of the closest mission item to the current global position.
 	 */
@@ -244,6 +284,7 @@ private:
 	)
 
 	uORB::Subscription	_mission_sub{ORB_ID(mission)};		/**< mission subscription */
+	uORB::Publication<mission_lookahead_s>	_mission_lookahead_pub{ORB_ID(mission_lookahead)};
 	mission_s		_mission {};
 
 	int32_t _current_mission_index{-1};
@@ -251,6 +292,11 @@ private:
 	// track location of planned mission landing
 	bool	_land_start_available{false};
 	uint16_t _land_start_index{UINT16_MAX};		/**< index of DO_LAND_START, INVALID_DO_LAND_START if no planned landing */
+	bool	_land_position_available{false};
+	double	_land_lat{0.0};
+	double	_land_lon{0.0};
+	float	_land_alt{0.0f};			/**< AMSL, or relative to home if _land_alt_is_relative */
+	bool	_land_alt_is_relative{false};
 
 	bool _need_takeoff{true};					/**< if true, then takeoff must be performed before going to the first waypoint (if needed) */
 
@@ -268,6 +268,7 @@ public:
 	bool		is_planned_mission() const { return _navigation_mode == &_mission; }
 	bool		on_mission_landing() { return _mission.landing(); }
 	bool		start_mission_landing() { return _mission.land_start(); }
+	bool		get_mission_landing_position(double &lat, double &lon, float &alt) { return _mission.get_land_position(lat, lon, alt); }
 	bool		mission_start_land_available() { return _mission.get_land_start_available(); }
 
 	// RTL
@@ -370,6 +371,7 @@ private:
 	Land		_land;			/**< class for handling land commands */
 	PrecLand	_precland;			/**< class for handling precision land commands */
 	RTL 		_rtl;				/**< class that handles RTL */
+	bool		_rtl_to_mission_landing{false};	/**< RTL_CLOSEST selected the mission landing */
 	RCLoss 		_rcLoss;				/**< class that handles RTL according to OBC rules (rc loss mode) */
 	DataLinkLoss	_dataLinkLoss;			/**< class that handles the OBC datalink loss mode */
 	EngineFailure	_engineFailure;			/**< class that handles the engine failure mode (FW only!) */
@@ -563,6 +563,27 @@ Navigator::run()
 
 					break;
 
+				case RTL::RTL_CLOSEST: {
+						// the destination is selected once on activation from the ranking kept up to date by RTL
+						if (rtl_activated) {
+							_rtl_to_mission_landing = _rtl.find_rtl_destination();
+						}
+
+						if (_rtl_to_mission_landing && _mission.get_land_start_available() && !get_land_detected()->landed) {
+							if (!on_mission_landing()) {
+								start_mission_landing();
+							}
+
+							_mission.set_execution_mode(mission_result_s::MISSION_EXECUTION_MODE_FAST_FORWARD);
+							navigation_mode_new = &_mission;
+
+						} else {
+							navigation_mode_new = &_rtl;
+						}
+
+						break;
+					}
+
 				default:
 					if (rtl_activated) {
 						mavlink_and_console_log_info(get_mavlink_log_pub(), "RTL HOME activated");
@@ -42,13 +42,58 @@
 #include "rtl.h"
 #include "navigator.h"
 
+#include <dataman/dataman.h>
+
+using matrix::Vector2f;
 
 static constexpr float DELAY_SIGMA = 0.01f;
+static constexpr int MAX_SAFE_POINTS = RtlDestination::MAX_DESTINATIONS - 2;
+static constexpr hrt_abstime DESTINATIONS_CHECK_INTERVAL = 1000000;
+static constexpr hrt_abstime DESTINATION_REFRESH_INTERVAL = 1000000; ///< every destination is refreshed once per interval
+static constexpr hrt_abstime WIND_TIMEOUT = 5000000;
 
 RTL::RTL(Navigator *navigator) :
 	MissionBlock(navigator),
 	ModuleParams(navigator)
 {
+	_handle_mc_cruise_speed = param_find("MPC_XY_CRUISE");
+	_handle_mc_climb_rate = param_find("MPC_Z_VEL_MAX_UP");
+	_handle_mc_descent_rate = param_find("MPC_Z_VEL_MAX_DN");
+	_handle_fw_cruise_speed = param_find("FW_AIRSPD_TRIM");
+	_handle_fw_climb_rate = param_find("FW_T_CLMB_MAX");
+	_handle_fw_descent_rate = param_find("FW_T_SINK_MIN");
+
+	updateParams();
+}
+
+void
+RTL::updateParams()
+{
+	ModuleParams::updateParams();
+
+	if (_handle_mc_cruise_speed != PARAM_INVALID) {
+		param_get(_handle_mc_cruise_speed, &_mc_cruise_speed);
+	}
+
+	if (_handle_mc_climb_rate != PARAM_INVALID) {
+		param_get(_handle_mc_climb_rate, &_mc_climb_rate);
+	}
+
+	if (_handle_mc_descent_rate != PARAM_INVALID) {
+		param_get(_handle_mc_descent_rate, &_mc_descent_rate);
+	}
+
+	if (_handle_fw_cruise_speed != PARAM_INVALID) {
+		param_get(_handle_fw_cruise_speed, &_fw_cruise_speed);
+	}
+
+	if (_handle_fw_climb_rate != PARAM_INVALID) {
+		param_get(_handle_fw_climb_rate, &_fw_climb_rate);
+	}
+
+	if (_handle_fw_descent_rate != PARAM_INVALID) {
+		param_get(_handle_fw_descent_rate, &_fw_descent_rate);
+	}
 }
 
 void
@@ -56,6 +101,227 @@ RTL::on_inactive()
 {
 	// Reset RTL state.
 	_rtl_state = RTL_STATE_NONE;
+
+	// Keep the destination ranking up to date such that triggering RTL does not cost anything.
+	update_destinations();
+}
+
+bool
+RTL::find_rtl_destination()
+{
+	set_destination_home();
+
+	if (rtl_type() != RTL_CLOSEST) {
+		return false;
+	}
+
+	if (!_destination_planner.isComplete()) {
+		_destination_planner.updateAll();
+	}
+
+	const int best = _destination_planner.getBestIndex();
+
+	if (best < 0) {
+		mavlink_log_critical(_navigator->get_mavlink_log_pub(), "RTL: no reachable destination, return home");
+		return false;
+	}
+
+	const RtlDestination::Destination &destination = _destination_planner.getDestination(best);
+	const RtlDestination::Cost &cost = _destination_planner.getCost(best);
+
+	if (!cost.safe) {
+		mavlink_log_critical(_navigator->get_mavlink_log_pub(), "RTL: energy reserve not sufficient");
+	}
+
+	switch (destination.type) {
+	case RtlDestination::Type::safe_point:
+		map_projection_reproject(&_destination_reference, destination.position(0), destination.position(1),
+					 &_destination.lat, &_destination.lon);
+		_destination.alt = destination.altitude;
+		_destination.yaw = _navigator->get_local_position()->yaw;
+		_destination.type = destination.type;
+		_destination.index = destination.index;
+		mavlink_and_console_log_info(_navigator->get_mavlink_log_pub(), "RTL: return to rally point %d, %d s",
+					     destination.index + 1, (int)cost.time);
+		return false;
+
+	case RtlDestination::Type::mission_landing:
+		_destination.type = destination.type;
+		mavlink_and_console_log_info(_navigator->get_mavlink_log_pub(), "RTL: use mission landing, %d s", (int)cost.time);
+		return true;
+
+	default:
+		mavlink_and_console_log_info(_navigator->get_mavlink_log_pub(), "RTL: return home, %d s", (int)cost.time);
+		return false;
+	}
+}
+
+void
+RTL::set_destination_home()
+{
+	const home_position_s &home = *_navigator->get_home_position();
+
+	_destination.lat = home.lat;
+	_destination.lon = home.lon;
+	_destination.alt = home.alt;
+	_destination.yaw = home.yaw;
+	_destination.type = RtlDestination::Type::home;
+	_destination.index = 0;
+}
+
+void
+RTL::update_destinations()
+{
+	if (rtl_type() != RTL_CLOSEST || !_navigator->home_position_valid()) {
+		return;
+	}
+
+	const home_position_s &home = *_navigator->get_home_position();
+
+	// the planner works in a local frame at home, start over when home changes
+	if (home.timestamp != _destination_home_timestamp) {
+		_destination_home_timestamp = home.timestamp;
+		map_projection_init(&_destination_reference, home.lat, home.lon);
+
+		const RtlDestination::Destination destination{RtlDestination::Type::home, 0, Vector2f(), home.alt};
+		_destination_planner.setDestinations(&destination, 1);
+		_safe_points_update_counter = -1;
+		_safe_points_check_time = 0;
+		_destination_refresh_time = 0;
+	}
+
+	// rally points and the mission landing rarely change
+	if (hrt_elapsed_time(&_safe_points_check_time) > DESTINATIONS_CHECK_INTERVAL) {
+		_safe_points_check_time = hrt_absolute_time();
+		update_safe_points();
+
+		double lat;
+		double lon;
+		float alt;
+
+		if (_navigator->get_mission_landing_position(lat, lon, alt)) {
+			RtlDestination::Destination destination{RtlDestination::Type::mission_landing, 0, Vector2f(), alt};
+			map_projection_project(&_destination_reference, lat, lon, &destination.position(0), &destination.position(1));
+			_destination_planner.setDestination(destination);
+
+		} else {
+			_destination_planner.removeDestination(RtlDestination::Type::mission_landing, 0);
+		}
+	}
+
+	const vehicle_global_position_s &gpos = *_navigator->get_global_position();
+
+	// One destination is refreshed per call, including the geofence check of its path. Spread the
+	// refreshes over the interval instead of running them on every navigator cycle.
+	const hrt_abstime refresh_interval = DESTINATION_REFRESH_INTERVAL
+					     / math::max(_destination_planner.getDestinationCount(), 1);
+
+	if (gpos.timestamp == 0 || hrt_elapsed_time(&_destination_refresh_time) < refresh_interval) {
+		return;
+	}
+
+	_destination_refresh_time = hrt_absolute_time();
+
+	_battery_sub.update(&_battery_status);
+	_wind_sub.update(&_wind_estimate);
+
+	Vector2f position;
+	map_projection_project(&_destination_reference, gpos.lat, gpos.lon, &position(0), &position(1));
+
+	Vector2f wind;
+
+	if (_wind_estimate.timestamp != 0 && hrt_elapsed_time(&_wind_estimate.timestamp) < WIND_TIMEOUT) {
+		wind = Vector2f(_wind_estimate.windspeed_north, _wind_estimate.windspeed_east);
+	}
+
+	float power = NAN;
+	float energy = NAN;
+
+	if (_battery_status.connected && _battery_status.current_filtered_a > 0.f) {
+		power = _battery_status.voltage_filtered_v * _battery_status.current_filtered_a;
+
+		if (PX4_ISFINITE(_battery_status.energy_remaining_wh) && _battery_status.energy_remaining_wh > 0.f) {
+			energy = _battery_status.energy_remaining_wh;
+		}
+	}
+
+	if (_navigator->get_vstatus()->vehicle_type == vehicle_status_s::VEHICLE_TYPE_ROTARY_WING) {
+		_destination_planner.setVehicleLimits(_mc_cruise_speed, _mc_climb_rate, _mc_descent_rate);
+
+	} else {
+		_destination_planner.setVehicleLimits(_fw_cruise_speed, _fw_climb_rate, _fw_descent_rate);
+	}
+
+	_destination_planner.setReturnAltitude(_param_rtl_return_alt.get(), _param_rtl_min_dist.get());
+	_destination_planner.setEnergyReserve(_param_rtl_en_reserve.get());
+	_destination_planner.setPathChecker(_navigator->get_geofence().isEmpty() ? nullptr : &_path_checker);
+	_destination_planner.update(position, gpos.alt, wind, power, energy);
+}
+
+void
+RTL::update_safe_points()
+{
+	mission_stats_entry_s stats{};
+
+	if (dm_read(DM_KEY_SAFE_POINTS, 0, &stats, sizeof(mission_stats_entry_s)) != sizeof(mission_stats_entry_s)) {
+		stats.num_items = 0;
+	}
+
+	if ((int32_t)stats.update_counter == _safe_points_update_counter && stats.num_items > 0) {
+		return;
+	}
+
+	_safe_points_update_counter = stats.update_counter;
+
+	for (int i = 0; i < MAX_SAFE_POINTS; i++) {
+		_destination_planner.removeDestination(RtlDestination::Type::safe_point, i);
+	}
+
+	const int count = math::min((int)stats.num_items, MAX_SAFE_POINTS);
+
+	if (stats.num_items > MAX_SAFE_POINTS) {
+		PX4_WARN("RTL: only the first %d rally points are used", MAX_SAFE_POINTS);
+	}
+
+	for (int i = 0; i < count; i++) {
+		mission_save_point_s point{};
+
+		if (dm_read(DM_KEY_SAFE_POINTS, i + 1, &point, sizeof(mission_save_point_s)) != sizeof(mission_save_point_s)) {
+			PX4_ERR("dataman read failure");
+			break;
+		}
+
+		// the altitude of a rally point is the ground altitude of the landing spot
+		float alt = point.alt;
+
+		if (point.frame == NAV_FRAME_GLOBAL_RELATIVE_ALT || point.frame == NAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
+			alt += _navigator->get_home_position()->alt;
+		}
+
+		RtlDestination::Destination destination{RtlDestination::Type::safe_point, i, Vector2f(), alt};
+		map_projection_project(&_destination_reference, point.lat, point.lon, &destination.position(0),
+				       &destination.position(1));
+		_destination_planner.setDestination(destination);
+	}
+}
+
+bool
+RTL::GeofencePathChecker::isPathAllowed(const Vector2f &from, const Vector2f &to, float altitude)
+{
+	const int samples = math::constrain((int)((to - from).norm() / SAMPLE_DISTANCE) + 1, 1, MAX_SAMPLES);
+
+	for (int i = 1; i <= samples; i++) {
+		const Vector2f point = from + (to - from) * ((float)i / samples);
+		double lat;
+		double lon;
+		map_projection_reproject(&_reference, point(0), point(1), &lat, &lon);
+
+		if (!_navigator->get_geofence().checkPoint(lat, lon, altitude)) {
+			return false;
+		}
+	}
+
+	return true;
 }
 
 int
@@ -67,6 +333,10 @@ RTL::rtl_type() const
 void
 RTL::on_activation()
 {
+	// With RTL_CLOSEST the navigator selects the destination, the mission takes over for a mission landing.
+	if (rtl_type() != RTL_CLOSEST || _destination.type == RtlDestination::Type::mission_landing) {
+		set_destination_home();
+	}
 
 	_rtl_alt = calculate_return_alt_from_cone_half_angle((float)_param_rtl_cone_half_angle_deg.get());
 
@@ -77,7 +347,7 @@ RTL::on_activation()
 	} else if ((rtl_type() == RTL_LAND) && _navigator->on_mission_landing()) {
 		// RTL straight to RETURN state, but mission will takeover for landing.
 
-	} else if ((_navigator->get_global_position()->alt < _navigator->get_home_position()->alt + _param_rtl_return_alt.get())
+	} else if ((_navigator->get_global_position()->alt < _destination.alt + _param_rtl_return_alt.get())
 		   || _rtl_alt_min) {
 
 		// If lower than return altitude, climb up first.
@@ -133,11 +403,11 @@ RTL::set_rtl_item()
 
 	position_setpoint_triplet_s *pos_sp_triplet = _navigator->get_position_setpoint_triplet();
 
-	// Check if we are pretty close to home already.
-	const float home_dist = get_distance_to_next_waypoint(home.lat, home.lon, gpos.lat, gpos.lon);
+	// Check if we are pretty close to the destination already.
+	const float destination_dist = get_distance_to_next_waypoint(_destination.lat, _destination.lon, gpos.lat, gpos.lon);
 
 	// Compute the loiter altitude.
-	const float loiter_altitude = math::min(home.alt + _param_rtl_descend_alt.get(), gpos.alt);
+	const float loiter_altitude = math::min(_destination.alt + _param_rtl_descend_alt.get(), gpos.alt);
 
 	switch (_rtl_state) {
 	case RTL_STATE_CLIMB: {
@@ -162,19 +432,19 @@ RTL::set_rtl_item()
 
 			// Don't change altitude.
 			_mission_item.nav_cmd = NAV_CMD_WAYPOINT;
-			_mission_item.lat = home.lat;
-			_mission_item.lon = home.lon;
+			_mission_item.lat = _destination.lat;
+			_mission_item.lon = _destination.lon;
 			_mission_item.altitude = _rtl_alt;
 			_mission_item.altitude_is_relative = false;
 
-			// Use home yaw if close to home.
-			// Check if we are pretty close to home already.
-			if (home_dist < _param_rtl_min_dist.get()) {
-				_mission_item.yaw = home.yaw;
+			// Use destination yaw if close to the destination.
+			// Check if we are pretty close to the destination already.
+			if (destination_dist < _param_rtl_min_dist.get()) {
+				_mission_item.yaw = _destination.yaw;
 
 			} else {
-				// Use current heading to home.
-				_mission_item.yaw = get_bearing_to_next_waypoint(gpos.lat, gpos.lon, home.lat, home.lon);
+				// Use current heading to the destination.
+				_mission_item.yaw = get_bearing_to_next_waypoint(gpos.lat, gpos.lon, _destination.lat, _destination.lon);
 			}
 
 			_mission_item.acceptance_radius = _navigator->get_acceptance_radius();
@@ -195,8 +465,8 @@ RTL::set_rtl_item()
 
 	case RTL_STATE_DESCEND: {
 			_mission_item.nav_cmd = NAV_CMD_WAYPOINT;
-			_mission_item.lat = home.lat;
-			_mission_item.lon = home.lon;
+			_mission_item.lat = _destination.lat;
+			_mission_item.lon = _destination.lon;
 			_mission_item.altitude = loiter_altitude;
 			_mission_item.altitude_is_relative = false;
 
@@ -207,7 +477,7 @@ RTL::set_rtl_item()
 				_mission_item.yaw = get_bearing_to_next_waypoint(gpos.lat, gpos.lon, _mission_item.lat, _mission_item.lon);
 
 			} else {
-				_mission_item.yaw = home.yaw;
+				_mission_item.yaw = _destination.yaw;
 			}
 
 			_mission_item.acceptance_radius = _navigator->get_acceptance_radius();
@@ -227,11 +497,11 @@ RTL::set_rtl_item()
 			const bool autoland = (_param_rtl_land_delay.get() > FLT_EPSILON);
 
 			// Don't change altitude.
-			_mission_item.lat = home.lat;
-			_mission_item.lon = home.lon;
+			_mission_item.lat = _destination.lat;
+			_mission_item.lon = _destination.lon;
 			_mission_item.altitude = loiter_altitude;
 			_mission_item.altitude_is_relative = false;
-			_mission_item.yaw = home.yaw;
+			_mission_item.yaw = _destination.yaw;
 			_mission_item.loiter_radius = _navigator->get_loiter_radius();
 			_mission_item.acceptance_radius = _navigator->get_acceptance_radius();
 			_mission_item.time_inside = math::max(_param_rtl_land_delay.get(), 0.0f);
@@ -254,19 +524,26 @@ RTL::set_rtl_item()
 		}
 
 	case RTL_STATE_LAND: {
-			// Land at home position.
+			// Land at the destination.
 			_mission_item.nav_cmd = NAV_CMD_LAND;
-			_mission_item.lat = home.lat;
-			_mission_item.lon = home.lon;
-			_mission_item.yaw = home.yaw;
-			_mission_item.altitude = home.alt;
+			_mission_item.lat = _destination.lat;
+			_mission_item.lon = _destination.lon;
+			_mission_item.yaw = _destination.yaw;
+			_mission_item.altitude = _destination.alt;
 			_mission_item.altitude_is_relative = false;
 			_mission_item.acceptance_radius = _navigator->get_acceptance_radius();
 			_mission_item.time_inside = 0.0f;
 			_mission_item.autocontinue = true;
 			_mission_item.origin = ORIGIN_ONBOARD;
 
-			mavlink_and_console_log_info(_navigator->get_mavlink_log_pub(), "RTL: land at home");
+			if (_destination.type == RtlDestination::Type::safe_point) {
+				mavlink_and_console_log_info(_navigator->get_mavlink_log_pub(), "RTL: land at rally point %d",
+							     _destination.index + 1);
+
+			} else {
+				mavlink_and_console_log_info(_navigator->get_mavlink_log_pub(), "RTL: land at home");
+			}
+
 			break;
 		}
 
@@ -352,34 +629,33 @@ RTL::advance_rtl()
 
 float RTL::calculate_return_alt_from_cone_half_angle(float cone_half_angle_deg)
 {
-	const home_position_s &home = *_navigator->get_home_position();
 	const vehicle_global_position_s &gpos = *_navigator->get_global_position();
 
-	// horizontal distance to home position
-	const float home_dist = get_distance_to_next_waypoint(home.lat, home.lon, gpos.lat, gpos.lon);
+	// horizontal distance to the destination
+	const float destination_dist = get_distance_to_next_waypoint(_destination.lat, _destination.lon, gpos.lat, gpos.lon);
 
 	float rtl_altitude;
 
-	if (home_dist <= _param_rtl_min_dist.get()) {
-		rtl_altitude = home.alt + _param_rtl_descend_alt.get();
+	if (destination_dist <= _param_rtl_min_dist.get()) {
+		rtl_altitude = _destination.alt + _param_rtl_descend_alt.get();
 
-	} else if (gpos.alt > home.alt + _param_rtl_return_alt.get() || cone_half_angle_deg >= 90.0f) {
+	} else if (gpos.alt > _destination.alt + _param_rtl_return_alt.get() || cone_half_angle_deg >= 90.0f) {
 		rtl_altitude = gpos.alt;
 
 	} else if (cone_half_angle_deg <= 0) {
-		rtl_altitude = home.alt + _param_rtl_return_alt.get();
+		rtl_altitude = _destination.alt + _param_rtl_return_alt.get();
 
 	} else {
 
 		// constrain cone half angle to meaningful values. All other cases are already handled above.
 		const float cone_half_angle_rad = math::radians(math::constrain(cone_half_angle_deg, 1.0f, 89.0f));
 
-		// minimum height above home position required
-		float height_above_home_min = home_dist / tanf(cone_half_angle_rad);
+		// minimum height above the destination required
+		float height_above_destination_min = destination_dist / tanf(cone_half_angle_rad);
 
 		// minimum altitude we need in order to be within the user defined cone
-		const float altitude_min = math::constrain(height_above_home_min + home.alt, home.alt,
-					   home.alt + _param_rtl_return_alt.get());
+		const float altitude_min = math::constrain(height_above_destination_min + _destination.alt, _destination.alt,
+					   _destination.alt + _param_rtl_return_alt.get());
 
 		if (gpos.alt < altitude_min) {
 			rtl_altitude = altitude_min;
@@ -390,7 +666,7 @@ float RTL::calculate_return_alt_from_cone_half_angle(float cone_half_angle_deg)
 	}
 
 	// always demand altitude which is higher or equal the RTL descend altitude
-	rtl_altitude = math::max(rtl_altitude, home.alt + _param_rtl_descend_alt.get());
+	rtl_altitude = math::max(rtl_altitude, _destination.alt + _param_rtl_descend_alt.get());
 
 	return rtl_altitude;
 }
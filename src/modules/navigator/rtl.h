@@ -42,6 +42,11 @@
 #pragma once
 
 #include <px4_module_params.h>
+#include <lib/ecl/geo/geo.h>
+#include <uORB/Subscription.hpp>
+#include <uORB/topics/battery_status.h>
+#include <uORB/topics/wind_estimate.h>
+#include <RtlDestination.hpp>
 
 #include "navigator_mode.h"
 #include "mission_block.h"
@@ -55,6 +60,7 @@ public:
 		RTL_HOME = 0,
 		RTL_LAND,
 		RTL_MISSION,
+		RTL_CLOSEST,
 	};
 
 	RTL(Navigator *navigator);
@@ -69,7 +75,51 @@ public:
 
 	int rtl_type() const;
 
+	/**
+	 * Select the return destination (home, rally point or mission landing) with the lowest
+	 * estimated cost. The selection is kept until the next call.
+	 * @return true if the planned mission landing was selected
+	 */
+	bool find_rtl_destination();
+
+	void updateParams() override;
+
 private:
+	/**
+	 * Geofence test of the cruise leg, sampled along the path
+	 */
+	class GeofencePathChecker : public RtlDestination::PathChecker
+	{
+	public:
+		GeofencePathChecker(Navigator *navigator, const map_projection_reference_s &reference) :
+			_navigator(navigator), _reference(reference) {}
+
+		bool isPathAllowed(const matrix::Vector2f &from, const matrix::Vector2f &to, float altitude) override;
+
+	private:
+		static constexpr float SAMPLE_DISTANCE = 50.f; ///< [m]
+		static constexpr int MAX_SAMPLES = 40;
+
+		Navigator *_navigator;
+		const map_projection_reference_s &_reference;
+	};
+
+	/**
+	 * Refresh the destination ranking, one destination per call and at most
+	 * one refresh of each destination per second
+	 */
+	void		update_destinations();
+
+	/**
+	 * Reload the rally points from dataman if they changed
+	 */
+	void		update_safe_points();
+
+	/**
+	 * Use the home position as destination
+	 */
+	void		set_destination_home();
+
 	/**
 	 * Set the RTL item
 	 */
@@ -94,15 +144,53 @@ private:
 		RTL_STATE_LANDED,
 	} _rtl_state{RTL_STATE_NONE};
 
-	float _rtl_alt{0.0f};	// AMSL altitude at which the vehicle should return to the home position
+	float _rtl_alt{0.0f};	// AMSL altitude at which the vehicle should return to the destination
 	bool _rtl_alt_min{false};
 
+	struct {
+		double lat;
+		double lon;
+		float alt;	///< ground altitude AMSL
+		float yaw;
+		RtlDestination::Type type;
+		int index;
+	} _destination{};	///< where the vehicle returns to, latched on activation
+
+	RtlDestination _destination_planner;
+	map_projection_reference_s _destination_reference{};	///< local frame of the planner, at home
+	GeofencePathChecker _path_checker{_navigator, _destination_reference};
+	hrt_abstime _destination_home_timestamp{0};
+	hrt_abstime _safe_points_check_time{0};
+	hrt_abstime _destination_refresh_time{0};
+	int32_t _safe_points_update_counter{-1};
+	int32_t _mission_landing_update_counter{-1};
+
+	uORB::Subscription _battery_sub{ORB_ID(battery_status)};
+	uORB::Subscription _wind_sub{ORB_ID(wind_estimate)};
+	battery_status_s _battery_status{};
+	wind_estimate_s _wind_estimate{};
+
+	// flight performance, looked up since not all of them exist on every vehicle type
+	param_t _handle_mc_cruise_speed{PARAM_INVALID};
+	param_t _handle_mc_climb_rate{PARAM_INVALID};
+	param_t _handle_mc_descent_rate{PARAM_INVALID};
+	param_t _handle_fw_cruise_speed{PARAM_INVALID};
+	param_t _handle_fw_climb_rate{PARAM_INVALID};
+	param_t _handle_fw_descent_rate{PARAM_INVALID};
+	float _mc_cruise_speed{5.f};
+	float _mc_climb_rate{3.f};
+	float _mc_descent_rate{1.f};
+	float _fw_cruise_speed{15.f};
+	float _fw_climb_rate{5.f};
+	float _fw_descent_rate{2.f};
+
 	DEFINE_PARAMETERS(
 		(ParamFloat<px4::params::RTL_RETURN_ALT>) _param_rtl_return_alt,
 		(ParamFloat<px4::params::RTL_DESCEND_ALT>) _param_rtl_descend_alt,
 		(ParamFloat<px4::params::RTL_LAND_DELAY>) _param_rtl_land_delay,
 		(ParamFloat<px4::params::RTL_MIN_DIST>) _param_rtl_min_dist,
 		(ParamInt<px4::params::RTL_TYPE>) _param_rtl_type,
-		(ParamInt<px4::params::RTL_CONE_ANG>) _param_rtl_cone_half_angle_deg
+		(ParamInt<px4::params::RTL_CONE_ANG>) _param_rtl_cone_half_angle_deg,
+		(ParamFloat<px4::params::RTL_EN_RESERVE>) _param_rtl_en_reserve
 	)
 };
@@ -113,10 +113,27 @@ PARAM_DEFINE_FLOAT(RTL_MIN_DIST, 5.0f);
  * @value 0 Return home via direct path
  * @value 1 Return to a planned mission landing, if available, via direct path, else return to home via direct path
  * @value 2 Return to a planned mission landing, if available, using the mission path, else return to home via the reverse mission path
+ * @value 3 Return to the destination among home, rally points and planned mission landing with the lowest estimated energy use, via direct path
  * @group Return Mode
  */
 PARAM_DEFINE_INT32(RTL_TYPE, 0);
 
+/**
+ * Return energy reserve
+ *
+ * With RTL_TYPE 3, a destination is only considered safe if the estimated energy to
+ * reach and land at it leaves this fraction of the remaining battery energy.
+ * The estimate accounts for the wind, the climb to the return altitude and the descent.
+ * The altitude of a rally point is taken as the ground altitude of the landing spot.
+ *
+ * @min 0
+ * @max 0.9
+ * @decimal 2
+ * @increment 0.05
+ * @group Return Mode
+ */
+PARAM_DEFINE_FLOAT(RTL_EN_RESERVE, 0.2f);
+
 /**
  * Half-angle of the return mode altitude cone
  *
@@ -57,3 +57,15 @@ PARAM_DEFINE_INT32(CAL_MAG_PRIME, 0);
  * @group Sensors
  */
 PARAM_DEFINE_INT32(CAL_MAG_SIDES, 63);
+
+/**
+ * Magnetometer calibration refinement
+ *
+ * If enabled, the calibration of each magnetometer is refined in the background with
+ * every new sample and a correction on top of the current calibration is proposed
+ * on the mag_calibration_estimate topic. The correction is never applied automatically.
+ *
+ * @boolean
+ * @group Sensors
+ */
+PARAM_DEFINE_INT32(CAL_MAG_REFINE, 0);
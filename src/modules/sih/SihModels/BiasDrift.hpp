@@ -0,0 +1,77 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file BiasDrift.hpp
+ *
+ * Random walk of a simulated sensor bias, as modelled by the estimator, bounded per axis.
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+
+#include "NoiseGenerator.hpp"
+
+class BiasDrift
+{
+public:
+	BiasDrift() = default;
+	~BiasDrift() = default;
+
+	/**
+	 * @param initial bias to restart the drift from
+	 */
+	void reset(const matrix::Vector3f &initial = matrix::Vector3f()) { _bias = initial; }
+
+	/**
+	 * @param random_walk standard deviation of the bias change after one second [unit/sqrt(s)], 0 for a constant bias
+	 * @param limit largest absolute bias per axis [unit]
+	 */
+	void setRandomWalk(float random_walk, float limit) { _random_walk = random_walk; _limit = limit; }
+
+	/**
+	 * @param dt time step [s]
+	 * @param noise noise source of the random walk, only drawn from if the random walk is not 0
+	 * @return the new bias
+	 */
+	const matrix::Vector3f &update(float dt, NoiseGenerator &noise);
+
+	const matrix::Vector3f &get() const { return _bias; }
+
+private:
+	matrix::Vector3f _bias;
+	float _random_walk{0.f};
+	float _limit{0.f};
+};
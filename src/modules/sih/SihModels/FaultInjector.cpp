@@ -0,0 +1,168 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file FaultInjector.cpp
+ */
+
+#include "FaultInjector.hpp"
+
+#include <string.h>
+#include <mathlib/mathlib.h>
+
+static constexpr const char *TYPE_NAMES[] = {"motor", "gyro_bias", "accel_bias", "stuck", "off"};
+static constexpr const char *SENSOR_NAMES[] = {"gyro", "accel", "mag", "baro", "gps"};
+
+bool FaultInjector::add(const Fault &fault)
+{
+	if (_count >= MAX_FAULTS || (fault.end != 0 && fault.end <= fault.start)) {
+		return false;
+	}
+
+	switch (fault.type) {
+	case Type::Motor:
+		if (fault.index >= MAX_MOTORS || fault.value < 0.f || fault.value > 1.f) {
+			return false;
+		}
+
+		break;
+
+	case Type::GyroBias:
+	case Type::AccelBias:
+		if (fault.index >= 3) {
+			return false;
+		}
+
+		break;
+
+	case Type::Stuck:
+	case Type::Off:
+		if (fault.index >= (int)Sensor::Count) {
+			return false;
+		}
+
+		break;
+
+	default:
+		return false;
+	}
+
+	_faults[_count++] = fault;
+	return true;
+}
+
+void FaultInjector::clear()
+{
+	_count = 0;
+	update(0);
+}
+
+void FaultInjector::update(uint64_t now)
+{
+	for (int i = 0; i < MAX_MOTORS; i++) {
+		_motor_efficiency[i] = 1.f;
+	}
+
+	_gyro_bias.setZero();
+	_accel_bias.setZero();
+	_stuck = 0;
+	_off = 0;
+	_active_count = 0;
+
+	for (int i = 0; i < _count; i++) {
+		const Fault &fault = _faults[i];
+
+		if (now < fault.start || (fault.end != 0 && now >= fault.end)) {
+			continue;
+		}
+
+		_active_count++;
+
+		switch (fault.type) {
+		case Type::Motor:
+			_motor_efficiency[fault.index] = math::min(_motor_efficiency[fault.index], fault.value);
+			break;
+
+		case Type::GyroBias:
+			_gyro_bias(fault.index) += fault.value;
+			break;
+
+		case Type::AccelBias:
+			_accel_bias(fault.index) += fault.value;
+			break;
+
+		case Type::Stuck:
+			_stuck |= 1u << fault.index;
+			break;
+
+		case Type::Off:
+			_off |= 1u << fault.index;
+			break;
+		}
+	}
+}
+
+bool FaultInjector::parseType(const char *name, Type &type)
+{
+	for (unsigned i = 0; i < sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]); i++) {
+		if (strcmp(name, TYPE_NAMES[i]) == 0) {
+			type = (Type)i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FaultInjector::parseSensor(const char *name, Sensor &sensor)
+{
+	for (unsigned i = 0; i < sizeof(SENSOR_NAMES) / sizeof(SENSOR_NAMES[0]); i++) {
+		if (strcmp(name, SENSOR_NAMES[i]) == 0) {
+			sensor = (Sensor)i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const char *FaultInjector::typeName(Type type)
+{
+	return ((unsigned)type < sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0])) ? TYPE_NAMES[(unsigned)type] : "unknown";
+}
+
+const char *FaultInjector::sensorName(Sensor sensor)
+{
+	return ((unsigned)sensor < sizeof(SENSOR_NAMES) / sizeof(SENSOR_NAMES[0])) ? SENSOR_NAMES[(unsigned)sensor] : "unknown";
+}
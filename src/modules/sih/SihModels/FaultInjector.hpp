@@ -0,0 +1,132 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file FaultInjector.hpp
+ *
+ * Schedule of simulated actuator and sensor faults.
+ *
+ * Faults are added with a start and an end time in simulation time and are active in between.
+ * Overlapping faults of the same kind combine: the lowest motor efficiency, the sum of the biases.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <matrix/matrix/math.hpp>
+
+class FaultInjector
+{
+public:
+	static constexpr int MAX_FAULTS = 8;
+	static constexpr int MAX_MOTORS = 8;
+
+	enum class Type : uint8_t {
+		Motor,		///< motor index produces value times its nominal thrust (0: failed)
+		GyroBias,	///< gyro axis index is offset by value [rad/s]
+		AccelBias,	///< accelerometer axis index is offset by value [m/s^2]
+		Stuck,		///< sensor index keeps its last output
+		Off,		///< sensor index stops publishing
+	};
+
+	enum class Sensor : uint8_t {
+		Gyro,
+		Accel,
+		Mag,
+		Baro,
+		Gps,
+		Count
+	};
+
+	struct Fault {
+		Type type;
+		uint8_t index;
+		float value;
+		uint64_t start;	///< [us]
+		uint64_t end;	///< [us], 0 for a permanent fault
+	};
+
+	FaultInjector() { update(0); }
+	~FaultInjector() = default;
+
+	/**
+	 * @return false if the schedule is full or the fault is invalid
+	 */
+	bool add(const Fault &fault);
+
+	void clear();
+
+	/**
+	 * Evaluate the faults active at a time
+	 * @param now simulation time [us]
+	 */
+	void update(uint64_t now);
+
+	/**
+	 * @return efficiency of all motors (0-1), MAX_MOTORS values
+	 */
+	const float *getMotorEfficiency() const { return _motor_efficiency; }
+
+	const matrix::Vector3f &getGyroBias() const { return _gyro_bias; }
+	const matrix::Vector3f &getAccelBias() const { return _accel_bias; }
+
+	bool isStuck(Sensor sensor) const { return _stuck & (1u << (int)sensor); }
+	bool isOff(Sensor sensor) const { return _off & (1u << (int)sensor); }
+
+	int getFaultCount() const { return _count; }
+	int getActiveCount() const { return _active_count; }
+	const Fault &getFault(int index) const { return _faults[index]; }
+
+	/**
+	 * Parse the names used on the command line
+	 * @return false if unknown
+	 */
+	static bool parseType(const char *name, Type &type);
+	static bool parseSensor(const char *name, Sensor &sensor);
+
+	static const char *typeName(Type type);
+	static const char *sensorName(Sensor sensor);
+
+private:
+	Fault _faults[MAX_FAULTS] {};
+	int _count{0};
+	int _active_count{0};
+
+	float _motor_efficiency[MAX_MOTORS] {};
+	matrix::Vector3f _gyro_bias;
+	matrix::Vector3f _accel_bias;
+	uint32_t _stuck{0};	///< bitmask of Sensor
+	uint32_t _off{0};	///< bitmask of Sensor
+};
@@ -0,0 +1,143 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file MotorModel.cpp
+ */
+
+#include "MotorModel.hpp"
+
+#include <math.h>
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+using matrix::Vector3f;
+
+void MotorModel::reset()
+{
+	for (int i = 0; i < MAX_ROTORS; i++) {
+		_speed[i] = 0.f;
+		// spread the initial rotor angles (golden angle) such that the imbalances do not start in phase
+		_phase[i] = fmodf(2.39996f * i, M_TWOPI_F);
+	}
+
+	_thrust.setZero();
+	_torque.setZero();
+	_accel_vibration.setZero();
+	_gyro_vibration.setZero();
+}
+
+void MotorModel::addRotor(float x, float y, float direction)
+{
+	if (_rotor_count < MAX_ROTORS) {
+		_rotors[_rotor_count++] = Rotor{x, y, direction};
+	}
+}
+
+void MotorModel::setGeometry(Frame frame, float arm_roll, float arm_pitch)
+{
+	_rotor_count = 0;
+
+	switch (frame) {
+	case Frame::QuadPlus:
+		addRotor(0.f, arm_roll, 1.f);		// right
+		addRotor(0.f, -arm_roll, 1.f);		// left
+		addRotor(arm_pitch, 0.f, -1.f);		// front
+		addRotor(-arm_pitch, 0.f, -1.f);	// rear
+		break;
+
+	case Frame::HexX:
+		addRotor(0.f, arm_roll, -1.f);				// mid right
+		addRotor(0.f, -arm_roll, 1.f);				// mid left
+		addRotor(arm_pitch, -0.5f * arm_roll, -1.f);		// front left
+		addRotor(-arm_pitch, 0.5f * arm_roll, 1.f);		// rear right
+		addRotor(arm_pitch, 0.5f * arm_roll, 1.f);		// front right
+		addRotor(-arm_pitch, -0.5f * arm_roll, -1.f);		// rear left
+		break;
+
+	case Frame::QuadX:
+	default:
+		addRotor(arm_pitch, arm_roll, 1.f);	// front right
+		addRotor(-arm_pitch, -arm_roll, 1.f);	// rear left
+		addRotor(arm_pitch, -arm_roll, -1.f);	// front left
+		addRotor(-arm_pitch, arm_roll, -1.f);	// rear right
+		break;
+	}
+
+	reset();
+}
+
+void MotorModel::update(float dt, const float command[], const float efficiency[])
+{
+	_thrust.setZero();
+	_torque.setZero();
+	_accel_vibration.setZero();
+	_gyro_vibration.setZero();
+
+	for (int i = 0; i < _rotor_count; i++) {
+		const float rotor_efficiency = (efficiency != nullptr) ? math::constrain(efficiency[i], 0.f, 1.f) : 1.f;
+
+		// a failed motor does not spin, a damaged rotor spins but produces less thrust
+		const float speed_setpoint = (rotor_efficiency > 0.f) ? sqrtf(math::constrain(command[i], 0.f, 1.f)) : 0.f;
+		const float tau = (speed_setpoint > _speed[i]) ? _tau_up : _tau_down;
+
+		if (tau > 0.f && dt > 0.f) {
+			// exact discretization of the first order lag
+			_speed[i] += (speed_setpoint - _speed[i]) * (1.f - expf(-dt / tau));
+
+		} else {
+			_speed[i] = speed_setpoint;
+		}
+
+		const Rotor &rotor = _rotors[i];
+		const float speed_sq = _speed[i] * _speed[i];
+		const float thrust = rotor_efficiency * _thrust_max * speed_sq;
+
+		// thrust along -z at (x, y, 0): torque = r x F
+		_thrust(2) -= thrust;
+		_torque(0) -= rotor.y * thrust;
+		_torque(1) += rotor.x * thrust;
+		_torque(2) += rotor.direction * rotor_efficiency * _torque_max * speed_sq;
+
+		// rotor angle, CCW seen from above is negative about the body z axis (down)
+		_phase[i] = fmodf(_phase[i] + M_TWOPI_F * _max_rotor_frequency * _speed[i] * dt, M_TWOPI_F);
+
+		const float cos_phase = cosf(_phase[i]);
+		const float sin_phase = -rotor.direction * sinf(_phase[i]);
+		const float blade_pass = BLADE_PASS_RATIO * sinf(2.f * _phase[i]);
+
+		_accel_vibration += Vector3f(cos_phase, sin_phase, blade_pass) * (_vibration_accel * speed_sq);
+		_gyro_vibration += Vector3f(sin_phase, cos_phase, blade_pass) * (_vibration_gyro * speed_sq);
+	}
+}
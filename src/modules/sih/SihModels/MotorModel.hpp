@@ -0,0 +1,169 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file MotorModel.hpp
+ *
+ * Rotor model of the simulator: geometry, motor/ESC dynamics and vibration.
+ *
+ * Each rotor speed follows its command with a first order lag, a shorter time constant
+ * when spinning up than when spinning down (no active braking). The normalized rotor speed
+ * settles at sqrt(command), such that the thrust T_MAX * speed^2 is linear in the command
+ * in steady state, as the mixer assumes.
+ *
+ * The vibration is the sum of a once per revolution imbalance, rotating in the rotor plane,
+ * and a blade pass component along the rotor axis, both proportional to the squared rotor speed.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <matrix/matrix/math.hpp>
+
+class MotorModel
+{
+public:
+	static constexpr int MAX_ROTORS = 6;
+
+	/** Frames, the rotor order is the one of the corresponding mixer geometry */
+	enum class Frame : int32_t {
+		QuadX = 0,
+		QuadPlus = 1,
+		HexX = 2,
+	};
+
+	MotorModel() { setGeometry(Frame::QuadX, 0.2f, 0.2f); }
+	~MotorModel() = default;
+
+	/**
+	 * Stop all rotors
+	 */
+	void reset();
+
+	/**
+	 * @param frame rotor layout
+	 * @param arm_roll lateral distance of the outermost rotors to the center of mass [m]
+	 * @param arm_pitch longitudinal distance of the outermost rotors to the center of mass [m]
+	 */
+	void setGeometry(Frame frame, float arm_roll, float arm_pitch);
+
+	/**
+	 * @param thrust_max thrust of one rotor at full speed [N]
+	 * @param torque_max drag torque of one rotor at full speed [Nm]
+	 */
+	void setRotorLimits(float thrust_max, float torque_max) { _thrust_max = thrust_max; _torque_max = torque_max; }
+
+	/**
+	 * @param spin_up time constant of the rotor speed when accelerating [s], 0 for no lag
+	 * @param spin_down time constant of the rotor speed when decelerating [s], 0 for no lag
+	 */
+	void setTimeConstants(float spin_up, float spin_down) { _tau_up = spin_up; _tau_down = spin_down; }
+
+	/**
+	 * @param rpm rotor speed at full command [rpm]
+	 */
+	void setMaxRotorSpeed(float rpm) { _max_rotor_frequency = rpm / 60.f; }
+
+	/**
+	 * @param accel acceleration amplitude of one rotor at full speed [m/s^2]
+	 * @param gyro angular rate amplitude of one rotor at full speed [rad/s]
+	 */
+	void setVibration(float accel, float gyro) { _vibration_accel = accel; _vibration_gyro = gyro; }
+
+	/**
+	 * Integrate the rotor speeds and update the forces, torques and vibration
+	 * @param dt time step [s]
+	 * @param command motor commands (0-1), getRotorCount() values
+	 * @param efficiency thrust of each rotor relative to a healthy one (0-1), nullptr if all healthy
+	 */
+	void update(float dt, const float command[], const float efficiency[] = nullptr);
+
+	int getRotorCount() const { return _rotor_count; }
+
+	/**
+	 * @return normalized rotor speed (0-1)
+	 */
+	float getRotorSpeed(int rotor) const { return _speed[rotor]; }
+
+	/**
+	 * @return total thrust in body frame [N]
+	 */
+	const matrix::Vector3f &getThrust() const { return _thrust; }
+
+	/**
+	 * @return total torque of the rotors in body frame [Nm]
+	 */
+	const matrix::Vector3f &getTorque() const { return _torque; }
+
+	/**
+	 * @return vibration acceleration at the IMU in body frame [m/s^2]
+	 */
+	const matrix::Vector3f &getAccelVibration() const { return _accel_vibration; }
+
+	/**
+	 * @return vibration angular rate at the IMU in body frame [rad/s]
+	 */
+	const matrix::Vector3f &getGyroVibration() const { return _gyro_vibration; }
+
+private:
+	struct Rotor {
+		float x;		///< position forward [m]
+		float y;		///< position right [m]
+		float direction;	///< 1: CCW, -1: CW seen from above
+	};
+
+	static constexpr float BLADE_PASS_RATIO = 0.5f;	///< blade pass vibration relative to the imbalance
+
+	void addRotor(float x, float y, float direction);
+
+	Rotor _rotors[MAX_ROTORS] {};
+	int _rotor_count{0};
+
+	float _thrust_max{5.f};
+	float _torque_max{0.1f};
+	float _tau_up{0.f};
+	float _tau_down{0.f};
+	float _max_rotor_frequency{150.f};	///< [Hz]
+	float _vibration_accel{0.f};
+	float _vibration_gyro{0.f};
+
+	float _speed[MAX_ROTORS] {};		///< normalized rotor speed
+	float _phase[MAX_ROTORS] {};		///< rotor angle [rad]
+
+	matrix::Vector3f _thrust;
+	matrix::Vector3f _torque;
+	matrix::Vector3f _accel_vibration;
+	matrix::Vector3f _gyro_vibration;
+};
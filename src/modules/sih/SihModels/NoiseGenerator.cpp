@@ -0,0 +1,96 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file NoiseGenerator.cpp
+ */
+
+#include "NoiseGenerator.hpp"
+
+#include <math.h>
+
+void NoiseGenerator::setSeed(uint32_t seed)
+{
+	// mix the seed (splitmix32) such that close seeds give unrelated sequences and the state is never 0
+	uint32_t z = seed + 0x9E3779B9u;
+	z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+	z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+	z ^= z >> 16;
+
+	_state = (z != 0) ? z : 1;
+	_spare = 0.f;
+	_has_spare = false;
+}
+
+uint32_t NoiseGenerator::next()
+{
+	// xorshift32
+	uint32_t x = _state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	_state = x;
+	return x;
+}
+
+float NoiseGenerator::uniform()
+{
+	// upper 24 bits, exactly representable as float
+	return (next() >> 8) * (1.f / 16777216.f);
+}
+
+float NoiseGenerator::gaussian()
+{
+	// Marsaglia polar method, as the former Sih::generate_wgn() (from BlockRandGauss.hpp)
+	if (_has_spare) {
+		_has_spare = false;
+		return _spare;
+	}
+
+	float v1;
+	float v2;
+	float s;
+
+	do {
+		v1 = 2.f * uniform() - 1.f;
+		v2 = 2.f * uniform() - 1.f;
+		s = v1 * v1 + v2 * v2;
+	} while (s >= 1.f || s < 1e-8f);
+
+	const float scale = sqrtf(-2.f * logf(s) / s);
+
+	_spare = v2 * scale;
+	_has_spare = true;
+	return v1 * scale;
+}
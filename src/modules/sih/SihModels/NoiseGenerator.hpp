@@ -0,0 +1,86 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file NoiseGenerator.hpp
+ *
+ * Seeded pseudo random number generator for the simulated sensor noise.
+ *
+ * Unlike rand(), the sequence only depends on the seed and on the number of samples drawn,
+ * such that a simulation with the same seed and the same inputs is reproducible.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <matrix/matrix/math.hpp>
+
+class NoiseGenerator
+{
+public:
+	explicit NoiseGenerator(uint32_t seed = 1) { setSeed(seed); }
+	~NoiseGenerator() = default;
+
+	/**
+	 * Restart the sequence
+	 * @param seed any value, 0 included
+	 */
+	void setSeed(uint32_t seed);
+
+	/**
+	 * @return uniformly distributed sample in [0, 1)
+	 */
+	float uniform();
+
+	/**
+	 * @return normally distributed sample with zero mean and unit standard deviation
+	 */
+	float gaussian();
+
+	/**
+	 * @return normally distributed vector with zero mean and the given standard deviation per axis
+	 */
+	matrix::Vector3f gaussian3f(float stdx, float stdy, float stdz)
+	{
+		return matrix::Vector3f(gaussian() * stdx, gaussian() * stdy, gaussian() * stdz);
+	}
+
+private:
+	uint32_t next();
+
+	uint32_t _state{1};
+	float _spare{0.f};	///< second sample of the polar method
+	bool _has_spare{false};
+};
@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file SensorDelay.hpp
+ *
+ * Fixed size history of a simulated sensor signal to output it with a latency.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+template<typename T, int N>
+class SensorDelay
+{
+public:
+	SensorDelay() = default;
+	~SensorDelay() = default;
+
+	void reset() { _count = 0; _head = 0; }
+
+	/**
+	 * Add a sample, the oldest is dropped if full
+	 * @param time sample time [us], not decreasing
+	 */
+	void push(uint64_t time, const T &sample)
+	{
+		_head = (_head + 1) % N;
+		_time[_head] = time;
+		_samples[_head] = sample;
+
+		if (_count < N) {
+			_count++;
+		}
+	}
+
+	/**
+	 * Get the newest sample at least delay old, or the oldest one if the history is too short
+	 * @param time current time [us]
+	 * @param delay latency [us]
+	 * @param sample set to the delayed sample
+	 * @return false if empty
+	 */
+	bool get(uint64_t time, uint64_t delay, T &sample) const
+	{
+		if (_count == 0) {
+			return false;
+		}
+
+		int index = _head;
+
+		for (int i = 0; i < _count; i++) {
+			index = (_head - i + N) % N;
+
+			if (_time[index] + delay <= time) {
+				break;
+			}
+		}
+
+		sample = _samples[index];
+		return true;
+	}
+
+	/**
+	 * @return the longest delay that can be applied at a sample interval
+	 */
+	static constexpr uint64_t maxDelay(uint64_t interval) { return (N - 1) * interval; }
+
+private:
+	T _samples[N] {};
+	uint64_t _time[N] {};
+	int _head{0};
+	int _count{0};
+};
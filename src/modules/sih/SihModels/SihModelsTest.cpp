@@ -0,0 +1,562 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the simulator in hardware models
+ * Run this test only using make tests TESTFILTER=SihModels
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+
+#include "BiasDrift.hpp"
+#include "FaultInjector.hpp"
+#include "MotorModel.hpp"
+#include "NoiseGenerator.hpp"
+#include "SensorDelay.hpp"
+
+using matrix::Vector3f;
+
+static constexpr float T_MAX = 5.f;
+static constexpr float Q_MAX = 0.1f;
+static constexpr float L_ROLL = 0.2f;
+static constexpr float L_PITCH = 0.15f;
+
+TEST(SihModelsTest, NoiseIsSeeded)
+{
+	NoiseGenerator a(42);
+	NoiseGenerator b(42);
+	NoiseGenerator c(43);
+
+	int differences = 0;
+
+	for (int i = 0; i < 1000; i++) {
+		const float sample = a.gaussian();
+		EXPECT_EQ(sample, b.gaussian());
+		differences += (sample != c.gaussian());
+	}
+
+	EXPECT_GT(differences, 990);
+
+	// restarting gives the same sequence again
+	a.setSeed(42);
+	b.setSeed(42);
+
+	for (int i = 0; i < 10; i++) {
+		EXPECT_EQ(a.uniform(), b.uniform());
+	}
+}
+
+TEST(SihModelsTest, NoiseStatistics)
+{
+	NoiseGenerator noise(1);
+	static constexpr int N = 100000;
+	double sum = 0.;
+	double sum_sq = 0.;
+
+	for (int i = 0; i < N; i++) {
+		const float sample = noise.gaussian();
+		sum += sample;
+		sum_sq += sample * sample;
+	}
+
+	EXPECT_NEAR(sum / N, 0., 0.02);
+	EXPECT_NEAR(sqrt(sum_sq / N), 1., 0.02);
+
+	float min = 1.f;
+	float max = 0.f;
+
+	for (int i = 0; i < N; i++) {
+		const float sample = noise.uniform();
+		min = fminf(min, sample);
+		max = fmaxf(max, sample);
+	}
+
+	EXPECT_GE(min, 0.f);
+	EXPECT_LT(max, 1.f);
+	EXPECT_LT(min, 0.001f);
+	EXPECT_GT(max, 0.999f);
+}
+
+TEST(SihModelsTest, QuadXMatchesInstantaneousModel)
+{
+	// without lag, the quad X geometry gives the former hard-coded mapping
+	MotorModel motors;
+	motors.setGeometry(MotorModel::Frame::QuadX, L_ROLL, L_PITCH);
+	motors.setRotorLimits(T_MAX, Q_MAX);
+	motors.setTimeConstants(0.f, 0.f);
+
+	NoiseGenerator noise(7);
+
+	for (int n = 0; n < 100; n++) {
+		const float u[4] = {noise.uniform(), noise.uniform(), noise.uniform(), noise.uniform()};
+		motors.update(0.004f, u);
+
+		const Vector3f thrust(0.f, 0.f, -T_MAX * (+u[0] + u[1] + u[2] + u[3]));
+		const Vector3f torque(L_ROLL * T_MAX * (-u[0] + u[1] + u[2] - u[3]),
+				      L_PITCH * T_MAX * (+u[0] - u[1] + u[2] - u[3]),
+				      Q_MAX * (+u[0] + u[1] - u[2] - u[3]));
+
+		for (int i = 0; i < 3; i++) {
+			EXPECT_NEAR(motors.getThrust()(i), thrust(i), 1e-4f);
+			EXPECT_NEAR(motors.getTorque()(i), torque(i), 1e-5f);
+		}
+	}
+}
+
+TEST(SihModelsTest, GeometryIsBalanced)
+{
+	const MotorModel::Frame frames[] = {MotorModel::Frame::QuadX, MotorModel::Frame::QuadPlus, MotorModel::Frame::HexX};
+	const int rotor_counts[] = {4, 4, 6};
+
+	for (int f = 0; f < 3; f++) {
+		MotorModel motors;
+		motors.setGeometry(frames[f], L_ROLL, L_PITCH);
+		motors.setRotorLimits(T_MAX, Q_MAX);
+		EXPECT_EQ(motors.getRotorCount(), rotor_counts[f]);
+
+		const float hover[MotorModel::MAX_ROTORS] = {0.4f, 0.4f, 0.4f, 0.4f, 0.4f, 0.4f};
+		motors.update(0.004f, hover);
+
+		EXPECT_NEAR(motors.getThrust()(2), -0.4f * T_MAX * rotor_counts[f], 1e-4f);
+		EXPECT_NEAR(motors.getTorque().norm(), 0.f, 1e-5f);
+
+		// more thrust on the right rotors rolls left (negative), on the front rotors pitches up (positive)
+		MotorModel::Frame frame = frames[f];
+		float roll_command[MotorModel::MAX_ROTORS];
+		float pitch_command[MotorModel::MAX_ROTORS];
+
+		MotorModel reference;
+		reference.setGeometry(frame, 1.f, 1.f);
+
+		// rotor positions are recovered from the torque of a single rotor
+		for (int i = 0; i < rotor_counts[f]; i++) {
+			float single[MotorModel::MAX_ROTORS] = {};
+			single[i] = 1.f;
+			reference.setRotorLimits(1.f, 0.f);
+			reference.update(0.004f, single);
+			const float y = -reference.getTorque()(0);
+			const float x = reference.getTorque()(1);
+			roll_command[i] = 0.4f + 0.1f * (y > 0.01f ? 1.f : (y < -0.01f ? -1.f : 0.f));
+			pitch_command[i] = 0.4f + 0.1f * (x > 0.01f ? 1.f : (x < -0.01f ? -1.f : 0.f));
+		}
+
+		motors.update(0.004f, roll_command);
+		EXPECT_LT(motors.getTorque()(0), 0.f);
+		EXPECT_NEAR(motors.getTorque()(1), 0.f, 1e-5f);
+
+		motors.update(0.004f, pitch_command);
+		EXPECT_GT(motors.getTorque()(1), 0.f);
+		EXPECT_NEAR(motors.getTorque()(0), 0.f, 1e-5f);
+	}
+}
+
+TEST(SihModelsTest, MotorDynamics)
+{
+	static constexpr float TAU_UP = 0.05f;
+	static constexpr float TAU_DOWN = 0.1f;
+	static constexpr float DT = 0.001f;
+
+	MotorModel motors;
+	motors.setGeometry(MotorModel::Frame::QuadX, L_ROLL, L_ROLL);
+	motors.setRotorLimits(T_MAX, Q_MAX);
+	motors.setTimeConstants(TAU_UP, TAU_DOWN);
+
+	const float full[4] = {1.f, 1.f, 1.f, 1.f};
+	const float half[4] = {0.5f, 0.5f, 0.5f, 0.5f};
+	const float off[4] = {};
+
+	// the rotor speed reaches 63% of the step after one time constant
+	for (int i = 0; i < (int)(TAU_UP / DT + 0.5f); i++) {
+		motors.update(DT, full);
+	}
+
+	EXPECT_NEAR(motors.getRotorSpeed(0), 1.f - expf(-1.f), 0.01f);
+
+	// the steady state thrust is linear in the command
+	for (int i = 0; i < 2000; i++) {
+		motors.update(DT, half);
+	}
+
+	EXPECT_NEAR(motors.getThrust()(2), -4.f * 0.5f * T_MAX, 1e-3f);
+	EXPECT_NEAR(motors.getRotorSpeed(0), sqrtf(0.5f), 1e-4f);
+
+	// spinning down is slower
+	const float start_speed = motors.getRotorSpeed(0);
+
+	for (int i = 0; i < (int)(TAU_DOWN / DT + 0.5f); i++) {
+		motors.update(DT, off);
+	}
+
+	EXPECT_NEAR(motors.getRotorSpeed(0), start_speed * expf(-1.f), 0.01f);
+
+	// the response does not depend on the time step
+	MotorModel coarse;
+	coarse.setRotorLimits(T_MAX, Q_MAX);
+	coarse.setTimeConstants(TAU_UP, TAU_DOWN);
+	MotorModel fine;
+	fine.setRotorLimits(T_MAX, Q_MAX);
+	fine.setTimeConstants(TAU_UP, TAU_DOWN);
+
+	for (int i = 0; i < 10; i++) {
+		coarse.update(0.004f, full);
+
+		for (int j = 0; j < 4; j++) {
+			fine.update(0.001f, full);
+		}
+	}
+
+	EXPECT_NEAR(coarse.getRotorSpeed(0), fine.getRotorSpeed(0), 1e-4f);
+}
+
+TEST(SihModelsTest, MotorFailure)
+{
+	MotorModel motors;
+	motors.setGeometry(MotorModel::Frame::QuadX, L_ROLL, L_ROLL);
+	motors.setRotorLimits(T_MAX, Q_MAX);
+	motors.setTimeConstants(0.02f, 0.05f);
+
+	const float hover[4] = {0.5f, 0.5f, 0.5f, 0.5f};
+	const float failed[4] = {1.f, 0.f, 1.f, 1.f};
+	const float damaged[4] = {1.f, 0.5f, 1.f, 1.f};
+
+	for (int i = 0; i < 500; i++) {
+		motors.update(0.002f, hover, damaged);
+	}
+
+	// rotor 1 (rear left) spins at the commanded speed with half the thrust
+	EXPECT_NEAR(motors.getRotorSpeed(1), motors.getRotorSpeed(0), 1e-5f);
+	EXPECT_NEAR(motors.getThrust()(2), -3.5f * 0.5f * T_MAX, 1e-3f);
+
+	// missing thrust at the rear left rolls left and pitches up
+	EXPECT_LT(motors.getTorque()(0), 0.f);
+	EXPECT_GT(motors.getTorque()(1), 0.f);
+
+	for (int i = 0; i < 500; i++) {
+		motors.update(0.002f, hover, failed);
+	}
+
+	EXPECT_LT(motors.getRotorSpeed(1), 0.01f);
+	EXPECT_NEAR(motors.getThrust()(2), -3.f * 0.5f * T_MAX, 1e-2f);
+}
+
+TEST(SihModelsTest, Vibration)
+{
+	static constexpr float RPM = 6000.f;	// 100 Hz
+	static constexpr float ACCEL = 2.f;
+	static constexpr float GYRO = 0.1f;
+	static constexpr float DT = 0.0001f;
+
+	MotorModel motors;
+	motors.setGeometry(MotorModel::Frame::QuadX, L_ROLL, L_ROLL);
+	motors.setRotorLimits(T_MAX, Q_MAX);
+	motors.setMaxRotorSpeed(RPM);
+	motors.setVibration(ACCEL, GYRO);
+
+	const float off[4] = {};
+	motors.update(DT, off);
+	EXPECT_EQ(motors.getAccelVibration().norm(), 0.f);
+	EXPECT_EQ(motors.getGyroVibration().norm(), 0.f);
+
+	// a single rotor at full speed vibrates at the rotor frequency with the configured amplitude
+	const float single[4] = {1.f, 0.f, 0.f, 0.f};
+	int zero_crossings = 0;
+	float previous = 0.f;
+	float max_accel = 0.f;
+	float max_gyro = 0.f;
+
+	for (int i = 0; i < 10000; i++) {
+		motors.update(DT, single);
+		const float x = motors.getAccelVibration()(0);
+
+		if (i > 0 && (x > 0.f) != (previous > 0.f)) {
+			zero_crossings++;
+		}
+
+		previous = x;
+		max_accel = fmaxf(max_accel, fabsf(x));
+		max_gyro = fmaxf(max_gyro, fabsf(motors.getGyroVibration()(1)));
+	}
+
+	EXPECT_NEAR(zero_crossings, 2 * RPM / 60.f, 2);
+	EXPECT_NEAR(max_accel, ACCEL, 0.01f);
+	EXPECT_NEAR(max_gyro, GYRO, 0.001f);
+
+	// the amplitude grows with the squared rotor speed
+	const float quarter[4] = {0.25f, 0.f, 0.f, 0.f};
+	max_accel = 0.f;
+
+	for (int i = 0; i < 10000; i++) {
+		motors.update(DT, quarter);
+		max_accel = fmaxf(max_accel, fabsf(motors.getAccelVibration()(0)));
+	}
+
+	EXPECT_NEAR(max_accel, 0.25f * ACCEL, 0.01f);
+}
+
+TEST(SihModelsTest, SensorDelay)
+{
+	static constexpr uint64_t INTERVAL = 4000;
+	SensorDelay<float, 16> delay;
+	float sample = -1.f;
+
+	EXPECT_FALSE(delay.get(0, 0, sample));
+
+	delay.push(INTERVAL, 1.f);
+
+	// too short history: the oldest sample
+	EXPECT_TRUE(delay.get(INTERVAL, 20000, sample));
+	EXPECT_EQ(sample, 1.f);
+
+	for (int i = 2; i <= 40; i++) {
+		delay.push(i * INTERVAL, (float)i);
+	}
+
+	const uint64_t now = 40 * INTERVAL;
+
+	EXPECT_TRUE(delay.get(now, 0, sample));
+	EXPECT_EQ(sample, 40.f);
+
+	EXPECT_TRUE(delay.get(now, 20000, sample));
+	EXPECT_EQ(sample, 35.f);
+
+	// between two samples: the older one
+	EXPECT_TRUE(delay.get(now, 21000, sample));
+	EXPECT_EQ(sample, 34.f);
+
+	EXPECT_TRUE(delay.get(now, SensorDelay<float, 16>::maxDelay(INTERVAL), sample));
+	EXPECT_EQ(sample, 25.f);
+
+	// beyond the history: the oldest
+	EXPECT_TRUE(delay.get(now, 1000000, sample));
+	EXPECT_EQ(sample, 25.f);
+
+	delay.reset();
+	EXPECT_FALSE(delay.get(now, 0, sample));
+}
+
+TEST(SihModelsTest, BiasDrift)
+{
+	static constexpr float RANDOM_WALK = 0.01f;
+	static constexpr float DURATION = 4.f;
+	static constexpr float DT = 0.004f;
+	static constexpr int RUNS = 500;
+
+	NoiseGenerator noise(3);
+	double sum_sq = 0.;
+
+	for (int run = 0; run < RUNS; run++) {
+		BiasDrift drift;
+		drift.setRandomWalk(RANDOM_WALK, 1.f);
+
+		for (int i = 0; i < (int)(DURATION / DT); i++) {
+			drift.update(DT, noise);
+		}
+
+		sum_sq += drift.get().norm_squared();
+	}
+
+	// the standard deviation grows with the square root of the time
+	EXPECT_NEAR(sqrt(sum_sq / (3 * RUNS)), RANDOM_WALK * sqrtf(DURATION), 0.1f * RANDOM_WALK * sqrtf(DURATION));
+
+	// bounded
+	BiasDrift bounded;
+	bounded.setRandomWalk(1.f, 0.05f);
+
+	for (int i = 0; i < 1000; i++) {
+		const Vector3f &bias = bounded.update(DT, noise);
+
+		for (int axis = 0; axis < 3; axis++) {
+			EXPECT_LE(fabsf(bias(axis)), 0.05f);
+		}
+	}
+
+	// constant without random walk
+	BiasDrift constant;
+	constant.reset(Vector3f(0.1f, -0.2f, 0.3f));
+	NoiseGenerator a(5);
+	NoiseGenerator b(5);
+
+	EXPECT_EQ(constant.update(DT, a)(1), -0.2f);
+	EXPECT_EQ(a.uniform(), b.uniform());
+}
+
+TEST(SihModelsTest, FaultSchedule)
+{
+	FaultInjector faults;
+
+	EXPECT_EQ(faults.getMotorEfficiency()[0], 1.f);
+
+	EXPECT_TRUE(faults.add({FaultInjector::Type::Motor, 2, 0.f, 1000000, 0}));
+	EXPECT_TRUE(faults.add({FaultInjector::Type::Motor, 2, 0.5f, 500000, 1500000}));
+	EXPECT_TRUE(faults.add({FaultInjector::Type::GyroBias, 1, 0.1f, 0, 2000000}));
+	EXPECT_TRUE(faults.add({FaultInjector::Type::GyroBias, 1, 0.05f, 1000000, 0}));
+	EXPECT_TRUE(faults.add({FaultInjector::Type::Stuck, (uint8_t)FaultInjector::Sensor::Baro, 0.f, 3000000, 4000000}));
+	EXPECT_TRUE(faults.add({FaultInjector::Type::Off, (uint8_t)FaultInjector::Sensor::Gps, 0.f, 3000000, 0}));
+
+	// invalid
+	EXPECT_FALSE(faults.add({FaultInjector::Type::Motor, FaultInjector::MAX_MOTORS, 0.f, 0, 0}));
+	EXPECT_FALSE(faults.add({FaultInjector::Type::Motor, 0, 1.5f, 0, 0}));
+	EXPECT_FALSE(faults.add({FaultInjector::Type::AccelBias, 3, 1.f, 0, 0}));
+	EXPECT_FALSE(faults.add({FaultInjector::Type::Stuck, (uint8_t)FaultInjector::Sensor::Count, 0.f, 0, 0}));
+	EXPECT_FALSE(faults.add({FaultInjector::Type::Off, 0, 0.f, 2000000, 1000000}));
+	EXPECT_EQ(faults.getFaultCount(), 6);
+
+	faults.update(0);
+	EXPECT_EQ(faults.getActiveCount(), 1);
+	EXPECT_EQ(faults.getMotorEfficiency()[2], 1.f);
+	EXPECT_EQ(faults.getGyroBias()(1), 0.1f);
+
+	faults.update(600000);
+	EXPECT_EQ(faults.getMotorEfficiency()[2], 0.5f);
+
+	// overlapping faults: the lowest efficiency, the sum of the biases
+	faults.update(1200000);
+	EXPECT_EQ(faults.getMotorEfficiency()[2], 0.f);
+	EXPECT_EQ(faults.getMotorEfficiency()[1], 1.f);
+	EXPECT_NEAR(faults.getGyroBias()(1), 0.15f, 1e-6f);
+	EXPECT_EQ(faults.getAccelBias().norm(), 0.f);
+
+	faults.update(2500000);
+	EXPECT_EQ(faults.getMotorEfficiency()[2], 0.f);
+	EXPECT_NEAR(faults.getGyroBias()(1), 0.05f, 1e-6f);
+	EXPECT_FALSE(faults.isStuck(FaultInjector::Sensor::Baro));
+
+	faults.update(3500000);
+	EXPECT_TRUE(faults.isStuck(FaultInjector::Sensor::Baro));
+	EXPECT_FALSE(faults.isStuck(FaultInjector::Sensor::Gps));
+	EXPECT_TRUE(faults.isOff(FaultInjector::Sensor::Gps));
+	EXPECT_FALSE(faults.isOff(FaultInjector::Sensor::Baro));
+
+	faults.update(4000000);
+	EXPECT_FALSE(faults.isStuck(FaultInjector::Sensor::Baro));
+	EXPECT_TRUE(faults.isOff(FaultInjector::Sensor::Gps));
+
+	faults.clear();
+	EXPECT_EQ(faults.getFaultCount(), 0);
+	EXPECT_FALSE(faults.isOff(FaultInjector::Sensor::Gps));
+	EXPECT_EQ(faults.getMotorEfficiency()[2], 1.f);
+
+	for (int i = 0; i < FaultInjector::MAX_FAULTS; i++) {
+		EXPECT_TRUE(faults.add({FaultInjector::Type::AccelBias, 0, 0.1f, 0, 0}));
+	}
+
+	EXPECT_FALSE(faults.add({FaultInjector::Type::AccelBias, 0, 0.1f, 0, 0}));
+}
+
+TEST(SihModelsTest, FaultNames)
+{
+	FaultInjector::Type type;
+	FaultInjector::Sensor sensor;
+
+	EXPECT_TRUE(FaultInjector::parseType("motor", type));
+	EXPECT_EQ(type, FaultInjector::Type::Motor);
+	EXPECT_TRUE(FaultInjector::parseType("accel_bias", type));
+	EXPECT_EQ(type, FaultInjector::Type::AccelBias);
+	EXPECT_FALSE(FaultInjector::parseType("motors", type));
+
+	EXPECT_TRUE(FaultInjector::parseSensor("gps", sensor));
+	EXPECT_EQ(sensor, FaultInjector::Sensor::Gps);
+	EXPECT_FALSE(FaultInjector::parseSensor("airspeed", sensor));
+
+	EXPECT_STREQ(FaultInjector::typeName(FaultInjector::Type::Stuck), "stuck");
+	EXPECT_STREQ(FaultInjector::sensorName(FaultInjector::Sensor::Mag), "mag");
+}
+
+/**
+ * IMU chain of the simulator: rotors, vibration, noise, bias drift, faults and latency
+ */
+static void simulateImu(uint32_t seed, Vector3f output[], int count)
+{
+	static constexpr uint64_t INTERVAL = 4000;
+
+	NoiseGenerator noise(seed);
+	MotorModel motors;
+	motors.setGeometry(MotorModel::Frame::HexX, L_ROLL, L_PITCH);
+	motors.setRotorLimits(T_MAX, Q_MAX);
+	motors.setTimeConstants(0.03f, 0.06f);
+	motors.setMaxRotorSpeed(9000.f);
+	motors.setVibration(2.f, 0.05f);
+
+	BiasDrift drift;
+	drift.setRandomWalk(0.001f, 0.1f);
+
+	FaultInjector faults;
+	faults.add({FaultInjector::Type::Motor, 3, 0.f, 100 * INTERVAL, 0});
+	faults.add({FaultInjector::Type::GyroBias, 0, 0.02f, 150 * INTERVAL, 0});
+
+	SensorDelay<Vector3f, 8> delay;
+
+	for (int i = 0; i < count; i++) {
+		const uint64_t now = (i + 1) * INTERVAL;
+		faults.update(now);
+
+		float command[MotorModel::MAX_ROTORS];
+
+		for (int r = 0; r < MotorModel::MAX_ROTORS; r++) {
+			command[r] = 0.5f + 0.2f * sinf(0.01f * i + r);
+		}
+
+		motors.update(INTERVAL * 1e-6f, command, faults.getMotorEfficiency());
+
+		const Vector3f gyro = motors.getTorque() + motors.getGyroVibration() + noise.gaussian3f(0.01f, 0.01f, 0.01f)
+				      + drift.update(INTERVAL * 1e-6f, noise) + faults.getGyroBias();
+		delay.push(now, gyro);
+		delay.get(now, 3 * INTERVAL, output[i]);
+	}
+}
+
+TEST(SihModelsTest, Determinism)
+{
+	static constexpr int N = 500;
+	Vector3f first[N];
+	Vector3f second[N];
+	Vector3f other_seed[N];
+
+	simulateImu(1234, first, N);
+	simulateImu(1234, second, N);
+	simulateImu(1235, other_seed, N);
+
+	int differences = 0;
+
+	for (int i = 0; i < N; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			// bit identical
+			EXPECT_EQ(first[i](axis), second[i](axis));
+			differences += (first[i](axis) != other_seed[i](axis));
+		}
+	}
+
+	EXPECT_GT(differences, 3 * N * 9 / 10);
+}
@@ -49,6 +49,7 @@
 #include <uORB/topics/actuator_outputs.h>
 #include <uORB/topics/vehicle_status.h>     // to get the HIL status
 
+#include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <fcntl.h>
@@ -60,14 +61,158 @@ using namespace matrix;
 int Sih::print_status()
 {
 	PX4_INFO("Running");
+	PX4_INFO("frame: %d, %d rotors", (int)_FRAME, _motors.getRotorCount());
+
+	for (int i = 0; i < _motors.getRotorCount(); i++) {
+		PX4_INFO("rotor %d: command %.3f, speed %.0f rpm", i + 1, (double)_u[i],
+			 (double)(_motors.getRotorSpeed(i) * _sih_mot_rpm.get()));
+	}
+
+	PX4_INFO("gyro bias: %.4f %.4f %.4f rad/s", (double)_gyro_drift.get()(0), (double)_gyro_drift.get()(1),
+		 (double)_gyro_drift.get()(2));
+	PX4_INFO("accel bias: %.3f %.3f %.3f m/s^2", (double)_accel_drift.get()(0), (double)_accel_drift.get()(1),
+		 (double)_accel_drift.get()(2));
+	PX4_INFO("latency: IMU %.1f ms, GPS %.1f ms", (double)(_IMU_DELAY * 1e-3f), (double)(_GPS_DELAY * 1e-3f));
+
+	pthread_mutex_lock(&_faults_mutex);
+
+	const hrt_abstime now = hrt_absolute_time();
+	PX4_INFO("faults: %d scheduled, %d active", _faults.getFaultCount(), _active_faults.getActiveCount());
+
+	for (int i = 0; i < _faults.getFaultCount(); i++) {
+		const FaultInjector::Fault &fault = _faults.getFault(i);
+		const bool sensor = (fault.type == FaultInjector::Type::Stuck || fault.type == FaultInjector::Type::Off);
+
+		PX4_INFO("  %s %d (%s) %.3f, start %.1f s, end %.1f s", FaultInjector::typeName(fault.type), fault.index,
+			 sensor ? FaultInjector::sensorName((FaultInjector::Sensor)fault.index) : "-", (double)fault.value,
+			 (double)(((int64_t)fault.start - (int64_t)now) * 1e-6),
+			 fault.end != 0 ? (double)(((int64_t)fault.end - (int64_t)now) * 1e-6) : (double)INFINITY);
+	}
+
+	pthread_mutex_unlock(&_faults_mutex);
+
+	perf_print_counter(_loop_perf);
+	perf_print_counter(_sampling_perf);
 	return 0;
 }
 
 int Sih::custom_command(int argc, char *argv[])
 {
+	if (argc > 0 && strcmp(argv[0], "fault") == 0) {
+		if (!is_running()) {
+			PX4_ERR("not running");
+			return 1;
+		}
+
+		return get_instance()->fault_command(argc - 1, argv + 1);
+	}
+
 	return print_usage("unknown command");
 }
 
+int Sih::fault_command(int argc, char *argv[])
+{
+	if (argc == 1 && strcmp(argv[0], "clear") == 0) {
+		clear_faults();
+		return 0;
+	}
+
+	const char *args[3] {};
+	int arg_count = 0;
+	float delay = 0.0f;
+	float duration = 0.0f;
+
+	for (int i = 0; i < argc; i++) {
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			delay = strtof(argv[++i], nullptr);
+
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			duration = strtof(argv[++i], nullptr);
+
+		} else if (arg_count < 3) {
+			args[arg_count++] = argv[i];
+
+		} else {
+			return print_usage("too many arguments");
+		}
+	}
+
+	FaultInjector::Fault fault{};
+
+	if (arg_count < 2 || !FaultInjector::parseType(args[0], fault.type)) {
+		return print_usage("unknown fault");
+	}
+
+	switch (fault.type) {
+	case FaultInjector::Type::Motor: {
+			// motors are numbered from 1 as in motor_test
+			const long motor = strtol(args[1], nullptr, 10);
+
+			if (motor < 1 || motor > _motors.getRotorCount()) {
+				return print_usage("invalid motor");
+			}
+
+			fault.index = motor - 1;
+		}
+		break;
+
+	case FaultInjector::Type::GyroBias:
+	case FaultInjector::Type::AccelBias:
+		if (strlen(args[1]) != 1 || args[1][0] < 'x' || args[1][0] > 'z') {
+			return print_usage("invalid axis");
+		}
+
+		fault.index = args[1][0] - 'x';
+		break;
+
+	case FaultInjector::Type::Stuck:
+	case FaultInjector::Type::Off: {
+			FaultInjector::Sensor sensor;
+
+			if (!FaultInjector::parseSensor(args[1], sensor)) {
+				return print_usage("unknown sensor");
+			}
+
+			fault.index = (uint8_t)sensor;
+		}
+		break;
+	}
+
+	if (fault.type == FaultInjector::Type::Motor || fault.type == FaultInjector::Type::GyroBias
+	    || fault.type == FaultInjector::Type::AccelBias) {
+		if (arg_count < 3) {
+			return print_usage("missing value");
+		}
+
+		fault.value = strtof(args[2], nullptr);
+	}
+
+	fault.start = hrt_absolute_time() + (hrt_abstime)(math::max(delay, 0.0f) * 1e6f);
+	fault.end = (duration > 0.0f) ? fault.start + (hrt_abstime)(duration * 1e6f) : 0;
+
+	if (!add_fault(fault)) {
+		PX4_ERR("invalid fault or schedule full");
+		return 1;
+	}
+
+	return 0;
+}
+
+bool Sih::add_fault(const FaultInjector::Fault &fault)
+{
+	pthread_mutex_lock(&_faults_mutex);
+	const bool added = _faults.add(fault);
+	pthread_mutex_unlock(&_faults_mutex);
+	return added;
+}
+
+void Sih::clear_faults()
+{
+	pthread_mutex_lock(&_faults_mutex);
+	_faults.clear();
+	pthread_mutex_unlock(&_faults_mutex);
+}
+
 
 int Sih::task_spawn(int argc, char *argv[])
 {
@@ -102,6 +247,14 @@ Sih::Sih() :
 	_loop_perf(perf_alloc(PC_ELAPSED, "sih_execution")),
 	_sampling_perf(perf_alloc(PC_ELAPSED, "sih_sampling"))
 {
+	pthread_mutex_init(&_faults_mutex, nullptr);
+}
+
+Sih::~Sih()
+{
+	pthread_mutex_destroy(&_faults_mutex);
+	perf_free(_loop_perf);
+	perf_free(_sampling_perf);
 }
 
 void Sih::run()
@@ -153,9 +306,29 @@ void Sih::timer_callback(void *sem)
 // this is the main execution waken up periodically by the semaphore
 void Sih::inner_loop()
 {
-	_now = hrt_absolute_time();
-	_dt = (_now - _last_run) * 1e-6f;
-	_last_run = _now;
+	const hrt_abstime now = hrt_absolute_time();
+
+	// advance the simulation in fixed steps, such that it does not depend on the wakeup jitter
+	for (int i = 0; i < MAX_CATCH_UP_STEPS && _last_run + LOOP_INTERVAL <= now; i++) {
+		_last_run += LOOP_INTERVAL;
+		_now = _last_run;
+		simulation_step();
+	}
+
+	if (_last_run + LOOP_INTERVAL <= now) {
+		// too late to catch up, drop the missed steps
+		_last_run = now;
+	}
+}
+
+void Sih::simulation_step()
+{
+	_dt = LOOP_INTERVAL * 1e-6f;
+
+	pthread_mutex_lock(&_faults_mutex);
+	_faults.update(_now);
+	_active_faults = _faults;
+	pthread_mutex_unlock(&_faults_mutex);
 
 	read_motors();
 
@@ -199,6 +372,12 @@ void Sih::parameters_update_poll()
 // store the parameters in a more convenient form
 void Sih::parameters_updated()
 {
+	// a new geometry restarts the rotors, only set it on a change
+	if (_sih_frame.get() != _FRAME || _sih_l_roll.get() != _L_ROLL || _sih_l_pitch.get() != _L_PITCH) {
+		_FRAME = _sih_frame.get();
+		_motors.setGeometry((MotorModel::Frame)_FRAME, _sih_l_roll.get(), _sih_l_pitch.get());
+	}
+
 	_T_MAX = _sih_t_max.get();
 	_Q_MAX = _sih_q_max.get();
 	_L_ROLL = _sih_l_roll.get();
@@ -223,19 +402,40 @@ void Sih::parameters_updated()
 	_Im1 = inv(_I);
 
 	_mu_I = Vector3f(_sih_mu_x.get(), _sih_mu_y.get(), _sih_mu_z.get());
+
+	_motors.setRotorLimits(_T_MAX, _Q_MAX);
+	_motors.setTimeConstants(_sih_mot_tau_up.get(), _sih_mot_tau_dn.get());
+	_motors.setMaxRotorSpeed(_sih_mot_rpm.get());
+	_motors.setVibration(_sih_vib_acc.get(), _sih_vib_gyr.get());
+
+	_gyro_drift.setRandomWalk(_sih_gyr_brw.get(), GYRO_BIAS_LIMIT);
+	_accel_drift.setRandomWalk(_sih_acc_brw.get(), ACCEL_BIAS_LIMIT);
+
+	_IMU_DELAY = min((hrt_abstime)(max(_sih_imu_delay.get(), 0.0f) * 1e6f),
+			 SensorDelay<ImuSample, IMU_DELAY_SAMPLES>::maxDelay(LOOP_INTERVAL));
+	_GPS_DELAY = min((hrt_abstime)(max(_sih_gps_delay.get(), 0.0f) * 1e6f),
+			 SensorDelay<GpsSample, GPS_DELAY_SAMPLES>::maxDelay(LOOP_INTERVAL));
 }
 
 // initialization of the variables for the simulator
 void Sih::init_variables()
 {
-	srand(1234);    // initialize the random seed once before calling generate_wgn()
+	_noise.setSeed(_sih_seed.get());    // the same noise sequence at every start
 
 	_p_I = Vector3f(0.0f, 0.0f, 0.0f);
 	_v_I = Vector3f(0.0f, 0.0f, 0.0f);
 	_q = Quatf(1.0f, 0.0f, 0.0f, 0.0f);
 	_w_B = Vector3f(0.0f, 0.0f, 0.0f);
 
-	_u[0] = _u[1] = _u[2] = _u[3] = 0.0f;
+	for (int i = 0; i < MotorModel::MAX_ROTORS; i++) {
+		_u[i] = 0.0f;
+	}
+
+	_motors.reset();
+	_gyro_drift.reset();
+	_accel_drift.reset();
+	_imu_delay.reset();
+	_gps_delay.reset();
 }
 
 void Sih::init_sensors()
@@ -264,7 +464,7 @@ void Sih::read_motors()
 	if (updated) {
 		orb_copy(ORB_ID(actuator_outputs), _actuator_out_sub, &actuators_out);
 
-		for (int i = 0; i < NB_MOTORS; i++) { // saturate the motor signals
+		for (int i = 0; i < _motors.getRotorCount(); i++) { // saturate the motor signals
 			_u[i] = constrain((actuators_out.output[i] - PWM_DEFAULT_MIN) / (PWM_DEFAULT_MAX - PWM_DEFAULT_MIN), 0.0f, 1.0f);
 		}
 	}
@@ -273,10 +473,10 @@ void Sih::read_motors()
 // generate the motors thrust and torque in the body frame
 void Sih::generate_force_and_torques()
 {
-	_T_B = Vector3f(0.0f, 0.0f, -_T_MAX * (+_u[0] + _u[1] + _u[2] + _u[3]));
-	_Mt_B = Vector3f(_L_ROLL * _T_MAX * (-_u[0] + _u[1] + _u[2] - _u[3]),
-			 _L_PITCH * _T_MAX * (+_u[0] - _u[1] + _u[2] - _u[3]),
-			 _Q_MAX * (+_u[0] + _u[1] - _u[2] - _u[3]));
+	_motors.update(_dt, _u, _active_faults.getMotorEfficiency());
+
+	_T_B = _motors.getThrust();
+	_Mt_B = _motors.getTorque();
 
 	_Fa_I = -_KDV * _v_I;   // first order drag to slow down the aircraft
 	_Ma_B = -_KDW * _w_B;   // first order angular damper
@@ -288,9 +488,7 @@ void Sih::equations_of_motion()
 	_C_IB = _q.to_dcm(); // body to inertial transformation
 
 	// Equations of motion of a rigid body
-	_p_I_dot = _v_I;                        // position differential
 	_v_I_dot = (_W_I + _Fa_I + _C_IB * _T_B) / _MASS;   // conservation of linear momentum
-	_q_dot = _q.derivative1(_w_B);              // attitude differential
 	_w_B_dot = _Im1 * (_Mt_B + _Ma_B - _w_B.cross(_I * _w_B)); // conservation of angular momentum
 
 	// fake ground, avoid free fall
@@ -308,12 +506,13 @@ void Sih::equations_of_motion()
 		_grounded = true;
 
 	} else {
-		// integration: Euler forward
-		_p_I = _p_I + _p_I_dot * _dt;
+		// integration: semi-implicit Euler, the position and the attitude are propagated
+		// with the new velocity and body rate, the attitude exactly for a constant rate
 		_v_I = _v_I + _v_I_dot * _dt;
-		_q = _q + _q_dot * _dt; // as given in attitude_estimator_q_main.cpp
-		_q.normalize();
+		_p_I = _p_I + _v_I * _dt;
 		_w_B = _w_B + _w_B_dot * _dt;
+		_q = _q * Quatf(AxisAnglef(_w_B * _dt));
+		_q.normalize();
 		_grounded = false;
 	}
 }
@@ -325,13 +524,20 @@ void Sih::reconstruct_sensors_signals()
 	// Bulka, Eitan, and Meyer Nahon. "Autonomous fixed-wing aerobatics: from theory to flight."
 	// In 2018 IEEE International Conference on Robotics and Automation (ICRA), pp. 6573-6580. IEEE, 2018.
 
-	// IMU
-	_acc = _C_IB.transpose() * (_v_I_dot - Vector3f(0.0f, 0.0f, CONSTANTS_ONE_G)) + noiseGauss3f(0.5f, 1.7f, 1.4f);
-	_gyro = _w_B + noiseGauss3f(0.14f, 0.07f, 0.03f);
-	_mag = _C_IB.transpose() * _mu_I + noiseGauss3f(0.02f, 0.02f, 0.03f);
+	// IMU, with the rotor vibration, the drifting biases and the injected bias faults
+	_acc = _C_IB.transpose() * (_v_I_dot - Vector3f(0.0f, 0.0f, CONSTANTS_ONE_G)) + _motors.getAccelVibration()
+	       + _noise.gaussian3f(0.5f, 1.7f, 1.4f);
+	_acc += _accel_drift.update(_dt, _noise) + _active_faults.getAccelBias();
+
+	_gyro = _w_B + _motors.getGyroVibration() + _noise.gaussian3f(0.14f, 0.07f, 0.03f);
+	_gyro += _gyro_drift.update(_dt, _noise) + _active_faults.getGyroBias();
+
+	_mag = _C_IB.transpose() * _mu_I + _noise.gaussian3f(0.02f, 0.02f, 0.03f);
+
+	_imu_delay.push(_now, ImuSample{_acc, _gyro});
 
 	// barometer
-	float altitude = (_H0 - _p_I(2)) + generate_wgn() * 0.14f; // altitude with noise
+	float altitude = (_H0 - _p_I(2)) + _noise.gaussian() * 0.14f; // altitude with noise
 	_baro_p_mBar = CONSTANTS_STD_PRESSURE_MBAR *        // reconstructed pressure in mBar
 		       powf((1.0f + altitude * TEMP_GRADIENT / T1_K), -CONSTANTS_ONE_G / (TEMP_GRADIENT * CONSTANTS_AIR_GAS_CONST));
 	_baro_temp_c = T1_K + CONSTANTS_ABSOLUTE_NULL_CELSIUS + TEMP_GRADIENT * altitude; // reconstructed temperture in celcius
@@ -341,60 +547,91 @@ void Sih::reconstruct_sensors_signals()
 	_gps_lon_noiseless = _LON0 + degrees((double)_p_I(1) / CONSTANTS_RADIUS_OF_EARTH) / _COS_LAT0;
 	_gps_alt_noiseless = _H0 - _p_I(2);
 
-	_gps_lat = _gps_lat_noiseless + (double)(generate_wgn() * 7.2e-6f); // latitude in degrees
-	_gps_lon = _gps_lon_noiseless + (double)(generate_wgn() * 1.75e-5f); // longitude in degrees
-	_gps_alt = _gps_alt_noiseless + generate_wgn() * 1.78f;
-	_gps_vel = _v_I + noiseGauss3f(0.06f, 0.077f, 0.158f);
+	_gps_lat = _gps_lat_noiseless + (double)(_noise.gaussian() * 7.2e-6f); // latitude in degrees
+	_gps_lon = _gps_lon_noiseless + (double)(_noise.gaussian() * 1.75e-5f); // longitude in degrees
+	_gps_alt = _gps_alt_noiseless + _noise.gaussian() * 1.78f;
+	_gps_vel = _v_I + _noise.gaussian3f(0.06f, 0.077f, 0.158f);
+
+	_gps_delay.push(_now, GpsSample{_gps_lat, _gps_lon, _gps_alt, _gps_vel});
 }
 
 void Sih::send_IMU()
 {
+	// the IMU outputs a delayed sample, stamped with the current time like a sensor with latency
+	ImuSample imu{};
+	_imu_delay.get(_now, _IMU_DELAY, imu);
+
 	// gyro
-	{
+	if (!_active_faults.isOff(FaultInjector::Sensor::Gyro)) {
+		if (!_active_faults.isStuck(FaultInjector::Sensor::Gyro)) {
+			_gyro_out = imu.gyro;
+		}
+
 		static constexpr float scaling = 1000.0f;
 		_px4_gyro.set_scale(1 / scaling);
 		_px4_gyro.set_temperature(T1_C);
-		_px4_gyro.update(_now, _gyro(0) * scaling, _gyro(1) * scaling, _gyro(2) * scaling);
+		_px4_gyro.update(_now, _gyro_out(0) * scaling, _gyro_out(1) * scaling, _gyro_out(2) * scaling);
 	}
 
 	// accel
-	{
+	if (!_active_faults.isOff(FaultInjector::Sensor::Accel)) {
+		if (!_active_faults.isStuck(FaultInjector::Sensor::Accel)) {
+			_acc_out = imu.acc;
+		}
+
 		static constexpr float scaling = 1000.0f;
 		_px4_accel.set_scale(1 / scaling);
 		_px4_accel.set_temperature(T1_C);
-		_px4_accel.update(_now, _acc(0) * scaling, _acc(1) * scaling, _acc(2) * scaling);
+		_px4_accel.update(_now, _acc_out(0) * scaling, _acc_out(1) * scaling, _acc_out(2) * scaling);
 	}
 
 	// magnetometer
-	{
+	if (!_active_faults.isOff(FaultInjector::Sensor::Mag)) {
+		if (!_active_faults.isStuck(FaultInjector::Sensor::Mag)) {
+			_mag_out = _mag;
+		}
+
 		static constexpr float scaling = 1000.0f;
 		_px4_mag.set_scale(1 / scaling);
 		_px4_mag.set_temperature(T1_C);
-		_px4_mag.update(_now, _mag(0) * scaling, _mag(1) * scaling, _mag(2) * scaling);
+		_px4_mag.update(_now, _mag_out(0) * scaling, _mag_out(1) * scaling, _mag_out(2) * scaling);
 	}
 
 	// baro
-	{
-		_px4_baro.set_temperature(_baro_temp_c);
-		_px4_baro.update(_now, _baro_p_mBar);
+	if (!_active_faults.isOff(FaultInjector::Sensor::Baro)) {
+		if (!_active_faults.isStuck(FaultInjector::Sensor::Baro)) {
+			_baro_p_mBar_out = _baro_p_mBar;
+			_baro_temp_c_out = _baro_temp_c;
+		}
+
+		_px4_baro.set_temperature(_baro_temp_c_out);
+		_px4_baro.update(_now, _baro_p_mBar_out);
 	}
 }
 
 void Sih::send_gps()
 {
+	if (_active_faults.isOff(FaultInjector::Sensor::Gps)) {
+		return;
+	}
+
+	if (!_active_faults.isStuck(FaultInjector::Sensor::Gps)) {
+		_gps_delay.get(_now, _GPS_DELAY, _gps_out);
+	}
+
 	_vehicle_gps_pos.timestamp = _now;
-	_vehicle_gps_pos.lat = (int32_t)(_gps_lat * 1e7);       // Latitude in 1E-7 degrees
-	_vehicle_gps_pos.lon = (int32_t)(_gps_lon * 1e7); // Longitude in 1E-7 degrees
-	_vehicle_gps_pos.alt = (int32_t)(_gps_alt * 1000.0f); // Altitude in 1E-3 meters above MSL, (millimetres)
-	_vehicle_gps_pos.alt_ellipsoid = (int32_t)(_gps_alt * 1000); // Altitude in 1E-3 meters bove Ellipsoid, (millimetres)
+	_vehicle_gps_pos.lat = (int32_t)(_gps_out.lat * 1e7);       // Latitude in 1E-7 degrees
+	_vehicle_gps_pos.lon = (int32_t)(_gps_out.lon * 1e7); // Longitude in 1E-7 degrees
+	_vehicle_gps_pos.alt = (int32_t)(_gps_out.alt * 1000.0f); // Altitude in 1E-3 meters above MSL, (millimetres)
+	_vehicle_gps_pos.alt_ellipsoid = (int32_t)(_gps_out.alt * 1000); // Altitude in 1E-3 meters bove Ellipsoid, (millimetres)
 	_vehicle_gps_pos.vel_ned_valid = true;              // True if NED velocity is valid
-	_vehicle_gps_pos.vel_m_s = sqrtf(_gps_vel(0) * _gps_vel(0) + _gps_vel(1) * _gps_vel(
+	_vehicle_gps_pos.vel_m_s = sqrtf(_gps_out.vel(0) * _gps_out.vel(0) + _gps_out.vel(1) * _gps_out.vel(
 			1)); // GPS ground speed, (metres/sec)
-	_vehicle_gps_pos.vel_n_m_s = _gps_vel(0);           // GPS North velocity, (metres/sec)
-	_vehicle_gps_pos.vel_e_m_s = _gps_vel(1);           // GPS East velocity, (metres/sec)
-	_vehicle_gps_pos.vel_d_m_s = _gps_vel(2);           // GPS Down velocity, (metres/sec)
-	_vehicle_gps_pos.cog_rad = atan2(_gps_vel(1),
-					 _gps_vel(0)); // Course over ground (NOT heading, but direction of movement), -PI..PI, (radians)
+	_vehicle_gps_pos.vel_n_m_s = _gps_out.vel(0);           // GPS North velocity, (metres/sec)
+	_vehicle_gps_pos.vel_e_m_s = _gps_out.vel(1);           // GPS East velocity, (metres/sec)
+	_vehicle_gps_pos.vel_d_m_s = _gps_out.vel(2);           // GPS Down velocity, (metres/sec)
+	_vehicle_gps_pos.cog_rad = atan2(_gps_out.vel(1),
+					 _gps_out.vel(0)); // Course over ground (NOT heading, but direction of movement), -PI..PI, (radians)
 
 	if (_vehicle_gps_pos_pub != nullptr) {
 		orb_publish(ORB_ID(vehicle_gps_position), _vehicle_gps_pos_pub, &_vehicle_gps_pos);
@@ -451,41 +688,6 @@ void Sih::publish_sih()
 	}
 }
 
-float Sih::generate_wgn()   // generate white Gaussian noise sample with std=1
-{
-	// algorithm 1:
-	// float temp=((float)(rand()+1))/(((float)RAND_MAX+1.0f));
-	// return sqrtf(-2.0f*logf(temp))*cosf(2.0f*M_PI_F*rand()/RAND_MAX);
-	// algorithm 2: from BlockRandGauss.hpp
-	static float V1, V2, S;
-	static bool phase = true;
-	float X;
-
-	if (phase) {
-		do {
-			float U1 = (float)rand() / RAND_MAX;
-			float U2 = (float)rand() / RAND_MAX;
-			V1 = 2.0f * U1 - 1.0f;
-			V2 = 2.0f * U2 - 1.0f;
-			S = V1 * V1 + V2 * V2;
-		} while (S >= 1.0f || fabsf(S) < 1e-8f);
-
-		X = V1 * float(sqrtf(-2.0f * float(logf(S)) / S));
-
-	} else {
-		X = V2 * float(sqrtf(-2.0f * float(logf(S)) / S));
-	}
-
-	phase = !phase;
-	return X;
-}
-
-// generate white Gaussian noise sample vector with specified std
-Vector3f Sih::noiseGauss3f(float stdx, float stdy, float stdz)
-{
-	return Vector3f(generate_wgn() * stdx, generate_wgn() * stdy, generate_wgn() * stdz);
-}
-
 int sih_main(int argc, char *argv[])
 {
 	return Sih::main(argc, argv);
@@ -509,17 +711,39 @@ signals given by the mixer.
 This simulator publishes the sensors signals corrupted with realistic noise
 in order to incorporate the state estimator in the loop.
 
+The rotors follow their commands with first order motor dynamics (SIH_MOT_TAU_UP, SIH_MOT_TAU_DN)
+in the geometry of SIH_FRAME. Their vibration is injected into the IMU (SIH_VIB_ACC, SIH_VIB_GYR),
+the IMU and GPS are delayed (SIH_IMU_DELAY, SIH_GPS_DELAY) and the IMU biases drift
+(SIH_GYR_BRW, SIH_ACC_BRW). The noise is seeded with SIH_SEED.
+
+Motor and sensor faults can be scheduled with the fault command.
+
 ### Implementation
 The simulator implements the equations of motion using matrix algebra.
 Quaternion representation is used for the attitude.
-Forward Euler is used for integration.
+Semi-implicit Euler is used for integration, with a fixed time step.
 Most of the variables are declared global in the .hpp file to avoid stack overflow.
 
+### Examples
+Fail motor 2 in 10 seconds:
+$ sih fault motor 2 0 -t 10
+
+Freeze the barometer for 5 seconds, add a gyro bias of 0.05 rad/s about x:
+$ sih fault stuck baro -d 5
+$ sih fault gyro_bias x 0.05
+
 
 )DESCR_STR");
 
     PRINT_MODULE_USAGE_NAME("sih", "simulation");
     PRINT_MODULE_USAGE_COMMAND("start");
+    PRINT_MODULE_USAGE_COMMAND_DESCR("fault", "Schedule a fault");
+    PRINT_MODULE_USAGE_ARG("motor|gyro_bias|accel_bias|stuck|off", "Fault type", false);
+    PRINT_MODULE_USAGE_ARG("<motor>|x|y|z|gyro|accel|mag|baro|gps", "Motor (1-N), axis or sensor", false);
+    PRINT_MODULE_USAGE_ARG("<value>", "Motor efficiency (0-1, 0: failed) or bias [rad/s, m/s^2]", true);
+    PRINT_MODULE_USAGE_PARAM_FLOAT('t', 0.0f, 0.0f, 3600.0f, "Start in [s]", true);
+    PRINT_MODULE_USAGE_PARAM_FLOAT('d', 0.0f, 0.0f, 3600.0f, "Duration [s], 0 for permanent", true);
+    PRINT_MODULE_USAGE_COMMAND_DESCR("fault clear", "Remove all faults");
     PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 
     return 0;
@@ -53,6 +53,14 @@
 #include <uORB/topics/vehicle_global_position.h>    // to publish groundtruth
 #include <uORB/topics/vehicle_gps_position.h>
 
+#include "SihModels/BiasDrift.hpp"
+#include "SihModels/FaultInjector.hpp"
+#include "SihModels/MotorModel.hpp"
+#include "SihModels/NoiseGenerator.hpp"
+#include "SihModels/SensorDelay.hpp"
+
+#include <pthread.h>
+
 extern "C" __EXPORT int sih_main(int argc, char *argv[]);
 
 class Sih : public ModuleBase<Sih>, public ModuleParams
@@ -60,7 +68,7 @@ class Sih : public ModuleBase<Sih>, public ModuleParams
 public:
 	Sih();
 
-	virtual ~Sih() = default;
+	virtual ~Sih();
 
 	/** @see ModuleBase */
 	static int task_spawn(int argc, char *argv[]);
@@ -80,10 +88,13 @@ public:
 	/** @see ModuleBase::print_status() */
 	int print_status() override;
 
-	static float generate_wgn();    // generate white Gaussian noise sample
+	/**
+	 * Schedule a fault, thread safe
+	 * @return false if the schedule is full or the fault is invalid
+	 */
+	bool add_fault(const FaultInjector::Fault &fault);
 
-	// generate white Gaussian noise sample as a 3D vector with specified std
-	static matrix::Vector3f noiseGauss3f(float stdx, float stdy, float stdz);
+	void clear_faults();
 
 	// timer called periodically to post the semaphore
 	static void timer_callback(void *sem);
@@ -124,11 +135,15 @@ private:
 	int _actuator_out_sub {-1};
 
 	// hard constants
-	static constexpr uint16_t NB_MOTORS = 4;
 	static constexpr float T1_C = 15.0f;                        // ground temperature in celcius
 	static constexpr float T1_K = T1_C - CONSTANTS_ABSOLUTE_NULL_CELSIUS;   // ground temperature in Kelvin
 	static constexpr float TEMP_GRADIENT  = -6.5f / 1000.0f;    // temperature gradient in degrees per metre
 	static constexpr hrt_abstime LOOP_INTERVAL = 4000;      // 4ms => 250 Hz real-time
+	static constexpr int MAX_CATCH_UP_STEPS = 5;            // steps simulated at once after a late wakeup
+	static constexpr float GYRO_BIAS_LIMIT = 0.1f;          // largest drifting gyro bias [rad/s]
+	static constexpr float ACCEL_BIAS_LIMIT = 0.4f;         // largest drifting accelerometer bias [m/s^2]
+	static constexpr int IMU_DELAY_SAMPLES = 32;            // IMU history, 124 ms at LOOP_INTERVAL
+	static constexpr int GPS_DELAY_SAMPLES = 128;           // GPS history, 508 ms at LOOP_INTERVAL
 
 	void init_variables();
 	void init_sensors();
@@ -140,6 +155,8 @@ private:
 	void send_gps();
 	void publish_sih();
 	void inner_loop();
+	void simulation_step();
+	int fault_command(int argc, char *argv[]);
 
 	perf_counter_t  _loop_perf;
 	perf_counter_t  _sampling_perf;
@@ -161,14 +178,36 @@ private:
 	matrix::Vector3f    _p_I;           // inertial position [m]
 	matrix::Vector3f    _v_I;           // inertial velocity [m/s]
 	matrix::Vector3f    _v_B;           // body frame velocity [m/s]
-	matrix::Vector3f    _p_I_dot;       // inertial position differential
 	matrix::Vector3f    _v_I_dot;       // inertial velocity differential
 	matrix::Quatf       _q;             // quaternion attitude
 	matrix::Dcmf        _C_IB;          // body to inertial transformation
 	matrix::Vector3f    _w_B;           // body rates in body frame [rad/s]
-	matrix::Quatf       _q_dot;         // quaternion differential
 	matrix::Vector3f    _w_B_dot;       // body rates differential
-	float       _u[NB_MOTORS];  // thruster signals
+	float       _u[MotorModel::MAX_ROTORS];  // thruster signals
+
+	// models
+	MotorModel      _motors;        // rotor geometry, motor dynamics and vibration
+	NoiseGenerator  _noise;         // seeded sensor noise (SIH_SEED)
+	BiasDrift       _gyro_drift;
+	BiasDrift       _accel_drift;
+	FaultInjector   _faults;            // fault schedule, also accessed from the shell ('sih fault')
+	FaultInjector   _active_faults;     // copy of _faults evaluated at the current step
+	pthread_mutex_t _faults_mutex{};    // protects _faults
+
+	struct ImuSample {
+		matrix::Vector3f acc;
+		matrix::Vector3f gyro;
+	};
+
+	struct GpsSample {
+		double lat;
+		double lon;
+		float alt;
+		matrix::Vector3f vel;
+	};
+
+	SensorDelay<ImuSample, IMU_DELAY_SAMPLES> _imu_delay;
+	SensorDelay<GpsSample, GPS_DELAY_SAMPLES> _gps_delay;
 
 
 	// sensors reconstruction
@@ -182,8 +221,18 @@ private:
 	float       _baro_p_mBar;   // reconstructed (simulated) pressure in mBar
 	float       _baro_temp_c;   // reconstructed (simulated) barometer temperature in celcius
 
+	// sensor outputs after latency and faults, kept while a sensor is stuck
+	matrix::Vector3f    _acc_out;
+	matrix::Vector3f    _gyro_out;
+	matrix::Vector3f    _mag_out;
+	float       _baro_p_mBar_out{0.0f};
+	float       _baro_temp_c_out{0.0f};
+	GpsSample   _gps_out{};
+
 	// parameters
 	float _MASS, _T_MAX, _Q_MAX, _L_ROLL, _L_PITCH, _KDV, _KDW, _H0;
+	int32_t _FRAME{-1};
+	hrt_abstime _IMU_DELAY, _GPS_DELAY;
 	double _LAT0, _LON0, _COS_LAT0;
 	matrix::Vector3f _W_I;  // weight of the vehicle in inertial frame [N]
 	matrix::Matrix3f _I;    // vehicle inertia matrix
@@ -205,6 +254,17 @@ private:
 		(ParamFloat<px4::params::SIH_L_PITCH>) _sih_l_pitch,
 		(ParamFloat<px4::params::SIH_KDV>) _sih_kdv,
 		(ParamFloat<px4::params::SIH_KDW>) _sih_kdw,
+		(ParamInt<px4::params::SIH_FRAME>) _sih_frame,
+		(ParamFloat<px4::params::SIH_MOT_TAU_UP>) _sih_mot_tau_up,
+		(ParamFloat<px4::params::SIH_MOT_TAU_DN>) _sih_mot_tau_dn,
+		(ParamFloat<px4::params::SIH_MOT_RPM>) _sih_mot_rpm,
+		(ParamFloat<px4::params::SIH_VIB_ACC>) _sih_vib_acc,
+		(ParamFloat<px4::params::SIH_VIB_GYR>) _sih_vib_gyr,
+		(ParamFloat<px4::params::SIH_IMU_DELAY>) _sih_imu_delay,
+		(ParamFloat<px4::params::SIH_GPS_DELAY>) _sih_gps_delay,
+		(ParamFloat<px4::params::SIH_GYR_BRW>) _sih_gyr_brw,
+		(ParamFloat<px4::params::SIH_ACC_BRW>) _sih_acc_brw,
+		(ParamInt<px4::params::SIH_SEED>) _sih_seed,
 		(ParamInt<px4::params::SIH_LOC_LAT0>) _sih_lat0,
 		(ParamInt<px4::params::SIH_LOC_LON0>) _sih_lon0,
 		(ParamFloat<px4::params::SIH_LOC_H0>) _sih_h0,
@@ -343,3 +343,169 @@ PARAM_DEFINE_FLOAT(SIH_LOC_MU_Y, -0.045f);
  * @group Simulation In Hardware
  */
 PARAM_DEFINE_FLOAT(SIH_LOC_MU_Z,  0.504f);
+
+/**
+ * Vehicle frame
+ *
+ * Rotor layout and order, the same as the mixer of the airframe.
+ * For the hexacopter, the middle rotors are at SIH_L_ROLL to the side,
+ * the front and rear rotors at SIH_L_PITCH to the front and back and at
+ * half SIH_L_ROLL to the side.
+ *
+ * @value 0 Quadcopter X
+ * @value 1 Quadcopter +
+ * @value 2 Hexacopter X
+ * @reboot_required true
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_INT32(SIH_FRAME, 0);
+
+/**
+ * Motor spin up time constant
+ *
+ * Time constant of the first order response of the rotor speed
+ * to an increasing motor command, including the ESC.
+ * Set to 0 for an instantaneous response.
+ *
+ * @unit s
+ * @min 0.0
+ * @max 0.5
+ * @decimal 3
+ * @increment 0.005
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_FLOAT(SIH_MOT_TAU_UP, 0.025f);
+
+/**
+ * Motor spin down time constant
+ *
+ * Time constant of the first order response of the rotor speed
+ * to a decreasing motor command. It is usually longer than the spin up
+ * time constant, unless the ESC brakes actively.
+ * Set to 0 for an instantaneous response.
+ *
+ * @unit s
+ * @min 0.0
+ * @max 0.5
+ * @decimal 3
+ * @increment 0.005
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_FLOAT(SIH_MOT_TAU_DN, 0.05f);
+
+/**
+ * Max rotor speed
+ *
+ * Rotor speed at full motor command. It sets the frequency of the vibration.
+ *
+ * @unit rpm
+ * @min 1000.0
+ * @max 50000.0
+ * @decimal 0
+ * @increment 100
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_FLOAT(SIH_MOT_RPM, 9000.0f);
+
+/**
+ * Accelerometer vibration
+ *
+ * Vibration amplitude at the accelerometer caused by one rotor at full speed.
+ * It scales with the squared rotor speed, at the rotor frequency in the rotor plane
+ * and at the blade pass frequency along the rotor axis.
+ *
+ * @unit m/s^2
+ * @min 0.0
+ * @max 50.0
+ * @decimal 2
+ * @increment 0.1
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_FLOAT(SIH_VIB_ACC, 0.0f);
+
+/**
+ * Gyroscope vibration
+ *
+ * Vibration amplitude at the gyroscope caused by one rotor at full speed.
+ * It scales with the squared rotor speed.
+ *
+ * @unit rad/s
+ * @min 0.0
+ * @max 2.0
+ * @decimal 3
+ * @increment 0.005
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_FLOAT(SIH_VIB_GYR, 0.0f);
+
+/**
+ * IMU latency
+ *
+ * Delay of the accelerometer and gyroscope signals.
+ * The samples are published with the current time.
+ *
+ * @unit s
+ * @min 0.0
+ * @max 0.12
+ * @decimal 3
+ * @increment 0.004
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_FLOAT(SIH_IMU_DELAY, 0.0f);
+
+/**
+ * GPS latency
+ *
+ * Delay of the GPS position and velocity.
+ * The samples are published with the current time.
+ *
+ * @unit s
+ * @min 0.0
+ * @max 0.5
+ * @decimal 2
+ * @increment 0.01
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_FLOAT(SIH_GPS_DELAY, 0.0f);
+
+/**
+ * Gyroscope bias random walk
+ *
+ * Standard deviation of the gyroscope bias change after one second.
+ * The bias starts at 0 and is limited to 0.1 rad/s.
+ *
+ * @unit rad/s/sqrt(s)
+ * @min 0.0
+ * @max 0.01
+ * @decimal 5
+ * @increment 0.0001
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_FLOAT(SIH_GYR_BRW, 0.0f);
+
+/**
+ * Accelerometer bias random walk
+ *
+ * Standard deviation of the accelerometer bias change after one second.
+ * The bias starts at 0 and is limited to 0.4 m/s^2.
+ *
+ * @unit m/s^2/sqrt(s)
+ * @min 0.0
+ * @max 0.1
+ * @decimal 4
+ * @increment 0.001
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_FLOAT(SIH_ACC_BRW, 0.0f);
+
+/**
+ * Noise seed
+ *
+ * Seed of the sensor noise and bias drift. A simulation with the same seed
+ * and the same inputs gives the same sensor signals.
+ *
+ * @min 0
+ * @reboot_required true
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_INT32(SIH_SEED, 1234);
@@ -0,0 +1,127 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file GimbalStabilizer.cpp
+ */
+
+#include "GimbalStabilizer.hpp"
+
+#include <mathlib/mathlib.h>
+#include <px4_defines.h>
+
+using namespace matrix;
+
+void GimbalStabilizer::setpointUpdated(uint64_t timestamp)
+{
+	_setpoint_timestamp = timestamp;
+	_setpoint_pending = true;
+}
+
+void GimbalStabilizer::setAttitude(const Quatf &q, const Vector3f &angular_velocity, uint64_t timestamp)
+{
+	_attitude = q;
+	_angular_velocity = angular_velocity;
+	_attitude_timestamp = timestamp;
+}
+
+Quatf GimbalStabilizer::predictAttitude(uint64_t time) const
+{
+	if (time <= _attitude_timestamp) {
+		return _attitude;
+	}
+
+	const float dt = math::min((time - _attitude_timestamp) * 1e-6f, MAX_PREDICTION_TIME);
+	const Vector3f rotation = _angular_velocity * dt;
+	const float angle = rotation.norm();
+
+	if (angle < 1e-6f) {
+		return _attitude;
+	}
+
+	// body rates: the increment is applied in the body frame
+	const Vector3f axis = rotation / angle;
+	const float s = sinf(angle / 2.f);
+	const Quatf delta(cosf(angle / 2.f), axis(0) * s, axis(1) * s, axis(2) * s);
+
+	Quatf q = _attitude * delta;
+	q.normalize();
+	return q;
+}
+
+const float *GimbalStabilizer::update(uint64_t now)
+{
+	// take speed into account
+	const float dt = (_last_update > 0 && now > _last_update) ? (now - _last_update) * 1e-6f : 0.f;
+	_last_update = now;
+
+	for (int i = 0; i < 3; ++i) {
+		_angle_setpoints[i] += dt * _angle_speeds[i];
+	}
+
+	Eulerf euler(0.f, 0.f, 0.f);
+
+	if (isStabilizing() && _attitude_timestamp > 0) {
+		euler = Eulerf(predictAttitude(now + (uint64_t)(_feed_forward_time * 1e6f)));
+	}
+
+	for (int i = 0; i < 3; ++i) {
+		if (_stabilize[i]) {
+			_angle_outputs[i] = _angle_setpoints[i] - euler(i);
+
+		} else {
+			_angle_outputs[i] = _angle_setpoints[i];
+		}
+
+		// bring angles into proper range [-pi, pi]
+		_angle_outputs[i] = wrap_pi(_angle_outputs[i]);
+	}
+
+	_setpoint_output = _setpoint_pending;
+
+	if (_setpoint_pending) {
+		_setpoint_latency = now > _setpoint_timestamp ? now - _setpoint_timestamp : 0;
+		_setpoint_pending = false;
+	}
+
+	return _angle_outputs;
+}
+
+bool GimbalStabilizer::getSetpointLatency(uint64_t &latency_us) const
+{
+	if (_setpoint_output) {
+		latency_us = _setpoint_latency;
+	}
+
+	return _setpoint_output;
+}
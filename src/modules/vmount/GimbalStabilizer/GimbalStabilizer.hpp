@@ -0,0 +1,123 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file GimbalStabilizer.hpp
+ *
+ * Computes the gimbal output angles from the angle setpoints and the vehicle attitude.
+ *
+ * Angle setpoints of stabilized axes are relative to the horizon (roll, pitch) or north (yaw),
+ * the vehicle attitude is subtracted to get the output angles. The attitude is extrapolated with
+ * the angular velocity from the time it was estimated to the time the output takes effect
+ * (attitude feed-forward), such that the estimator and actuator delays do not result in a
+ * stabilization error when the vehicle rotates.
+ */
+
+#pragma once
+
+#include <matrix/math.hpp>
+#include <stdint.h>
+
+class GimbalStabilizer
+{
+public:
+	static constexpr float MAX_PREDICTION_TIME = 0.1f; ///< [s]
+
+	GimbalStabilizer() = default;
+	~GimbalStabilizer() = default;
+
+	void setAngleSetpoint(int axis, float angle) { _angle_setpoints[axis] = angle; }
+	void setAngularSpeed(int axis, float speed) { _angle_speeds[axis] = speed; }
+	void setStabilize(int axis, bool stabilize) { _stabilize[axis] = stabilize; }
+
+	float getAngleSetpoint(int axis) const { return _angle_setpoints[axis]; }
+	bool isStabilizing() const { return _stabilize[0] || _stabilize[1] || _stabilize[2]; }
+
+	/**
+	 * Mark the setpoints as changed by a new command
+	 * @param timestamp time the command was published [us], used to measure the setpoint to output latency
+	 */
+	void setpointUpdated(uint64_t timestamp);
+
+	/**
+	 * @param q vehicle attitude, rotation from body to NED frame
+	 * @param angular_velocity vehicle body rates [rad/s]
+	 * @param timestamp time of the attitude estimate [us]
+	 */
+	void setAttitude(const matrix::Quatf &q, const matrix::Vector3f &angular_velocity, uint64_t timestamp);
+
+	/**
+	 * @param time_s delay from the output update until it takes effect at the gimbal [s]
+	 */
+	void setFeedForwardTime(float time_s) { _feed_forward_time = time_s; }
+
+	/**
+	 * Integrate the angular speeds and compute the output angles.
+	 * @param now current time [us]
+	 * @return output angles (roll, pitch, yaw) in [-pi, pi] [rad]
+	 */
+	const float *update(uint64_t now);
+
+	const float *getOutputs() const { return _angle_outputs; }
+
+	/**
+	 * Latency from the last command to the first output including it
+	 * @param latency_us set to the latency [us] if a new command was output with the last update
+	 * @return true if a new command was output with the last update
+	 */
+	bool getSetpointLatency(uint64_t &latency_us) const;
+
+	/**
+	 * @return vehicle attitude extrapolated to the given time
+	 */
+	matrix::Quatf predictAttitude(uint64_t time) const;
+
+private:
+	float _angle_setpoints[3] {}; ///< [rad]
+	float _angle_speeds[3] {}; ///< [rad/s]
+	bool _stabilize[3] {};
+
+	float _angle_outputs[3] {}; ///< [rad]
+
+	matrix::Quatf _attitude{1.f, 0.f, 0.f, 0.f};
+	matrix::Vector3f _angular_velocity{0.f, 0.f, 0.f};
+	uint64_t _attitude_timestamp{0};
+
+	float _feed_forward_time{0.f};
+
+	uint64_t _last_update{0};
+	uint64_t _setpoint_timestamp{0};
+	uint64_t _setpoint_latency{0};
+	bool _setpoint_pending{false};
+	bool _setpoint_output{false};
+};
@@ -0,0 +1,273 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the gimbal stabilizer of vmount
+ * Run this test only using make tests TESTFILTER=GimbalStabilizer
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/matrix/math.hpp>
+#include <px4_defines.h>
+
+#include "GimbalStabilizer.hpp"
+
+using namespace matrix;
+
+class GimbalStabilizerTest : public ::testing::Test
+{
+public:
+	/** Vehicle oscillating around all axes */
+	static Eulerf vehicleEuler(uint64_t time_us)
+	{
+		const float t = time_us * 1e-6f;
+		return Eulerf(0.3f * sinf(2.f * M_PI_F * 1.f * t),
+			      0.2f * sinf(2.f * M_PI_F * 0.7f * t + 1.f),
+			      0.5f * sinf(2.f * M_PI_F * 0.3f * t));
+	}
+
+	static Quatf vehicleAttitude(uint64_t time_us) { return Quatf(vehicleEuler(time_us)); }
+
+	/** Body rates from the derivative of the attitude */
+	static Vector3f vehicleAngularVelocity(uint64_t time_us)
+	{
+		const uint64_t dt_us = 100;
+		const Quatf dq = vehicleAttitude(time_us).inversed() * vehicleAttitude(time_us + dt_us);
+		return Vector3f(dq(1), dq(2), dq(3)) * (2.f / (dt_us * 1e-6f));
+	}
+
+	/** Deterministic pseudo random number in [0, 1) */
+	float random()
+	{
+		_seed = 1103515245u * _seed + 12345u;
+		return (float)((_seed >> 8) & 0xFFFF) / 65536.f;
+	}
+
+	struct Result {
+		float rms_error; ///< stabilization error of the gimbal [rad]
+		uint64_t max_latency; ///< setpoint to output latency [us]
+	};
+
+	/**
+	 * Replay an attitude stream at 250Hz and a command stream at ~10Hz.
+	 * @param event_driven run on every attitude and command publication, otherwise poll every 50ms
+	 * @param feed_forward_time attitude feed-forward time [s]
+	 * @param actuator_delay time it takes for the output to take effect at the gimbal [us]
+	 */
+	Result replay(bool event_driven, float feed_forward_time, uint64_t actuator_delay)
+	{
+		static constexpr uint64_t duration = 20000000;
+		static constexpr uint64_t attitude_interval = 4000;
+		static constexpr uint64_t poll_interval = 50000;
+		static constexpr uint64_t run_delay = 200; // work queue scheduling
+
+		GimbalStabilizer stabilizer;
+		stabilizer.setFeedForwardTime(feed_forward_time);
+
+		for (int i = 0; i < 3; ++i) {
+			stabilizer.setStabilize(i, true);
+		}
+
+		// outputs in order of computation, the gimbal applies them after the actuator delay
+		static constexpr int max_outputs = 8192;
+		static uint64_t output_time[max_outputs];
+		static float output_angles[max_outputs][3];
+		static float output_setpoints[max_outputs][3];
+		int outputs = 0;
+		int applied = -1;
+
+		Result result{};
+		float error_squared = 0.f;
+		int n = 0;
+
+		uint64_t next_attitude = 0;
+		uint64_t next_command = 100000;
+		uint64_t next_poll = 0;
+		bool command_pending = false;
+		float command_angles[3] {};
+		uint64_t command_timestamp = 0;
+
+		for (uint64_t now = 0; now < duration; now += 100) {
+			bool run = false;
+
+			// a new attitude is published, the work item runs after the scheduling delay
+			if (now == next_attitude + run_delay) {
+				const uint64_t t = next_attitude;
+				stabilizer.setAttitude(vehicleAttitude(t), vehicleAngularVelocity(t), t);
+				next_attitude += attitude_interval;
+				run = event_driven;
+			}
+
+			if (now == next_command) {
+				command_pending = true;
+				command_timestamp = now;
+				command_angles[0] = 0.2f * (random() - 0.5f);
+				command_angles[1] = -0.5f * random();
+				command_angles[2] = 0.5f * (random() - 0.5f);
+				next_command += 80000 + (uint64_t)(40000.f * random()) / 100 * 100;
+			}
+
+			if (command_pending && (event_driven ? now == command_timestamp + run_delay : now == next_poll)) {
+				for (int i = 0; i < 3; ++i) {
+					stabilizer.setAngleSetpoint(i, command_angles[i]);
+				}
+
+				stabilizer.setpointUpdated(command_timestamp);
+				command_pending = false;
+				run = true;
+			}
+
+			if (!event_driven && now == next_poll) {
+				next_poll += poll_interval;
+				run = true;
+			}
+
+			if (run && outputs < max_outputs) {
+				const float *out = stabilizer.update(now);
+				output_time[outputs] = now;
+
+				for (int i = 0; i < 3; ++i) {
+					output_angles[outputs][i] = out[i];
+					output_setpoints[outputs][i] = stabilizer.getAngleSetpoint(i);
+				}
+
+				outputs++;
+
+				uint64_t latency = 0;
+
+				if (stabilizer.getSetpointLatency(latency)) {
+					result.max_latency = latency > result.max_latency ? latency : result.max_latency;
+				}
+			}
+
+			while (applied + 1 < outputs && output_time[applied + 1] + actuator_delay <= now) {
+				applied++;
+			}
+
+			if (applied < 0 || now < 1000000 || now % 1000 != 0) {
+				continue;
+			}
+
+			// THEN: the gimbal points to the setpoint of the applied output
+			const Eulerf vehicle = vehicleEuler(now);
+
+			for (int i = 0; i < 3; ++i) {
+				const float error = wrap_pi(output_angles[applied][i] + vehicle(i) - output_setpoints[applied][i]);
+				error_squared += error * error;
+				n++;
+			}
+		}
+
+		result.rms_error = sqrtf(error_squared / n);
+		return result;
+	}
+
+	uint32_t _seed{12345};
+};
+
+TEST_F(GimbalStabilizerTest, notStabilized)
+{
+	GimbalStabilizer stabilizer;
+	stabilizer.setAttitude(vehicleAttitude(250000), vehicleAngularVelocity(250000), 250000);
+	stabilizer.setAngleSetpoint(0, 0.1f);
+	stabilizer.setAngleSetpoint(1, -0.4f);
+	stabilizer.setAngleSetpoint(2, 3.f);
+	stabilizer.setAngularSpeed(2, 0.5f);
+
+	// WHEN: no axis is stabilized
+	stabilizer.update(1000000);
+	const float *out = stabilizer.update(1500000);
+
+	// THEN: the setpoints are output, yaw integrates the speed and wraps
+	EXPECT_FLOAT_EQ(out[0], 0.1f);
+	EXPECT_FLOAT_EQ(out[1], -0.4f);
+	EXPECT_NEAR(out[2], 3.25f - 2.f * M_PI_F, 1e-5f);
+}
+
+TEST_F(GimbalStabilizerTest, attitudeFeedForward)
+{
+	GimbalStabilizer stabilizer;
+	stabilizer.setStabilize(0, true);
+	stabilizer.setStabilize(1, true);
+	stabilizer.setStabilize(2, true);
+
+	// GIVEN: an attitude estimated at 1s
+	const uint64_t t = 1000000;
+	stabilizer.setAttitude(vehicleAttitude(t), vehicleAngularVelocity(t), t);
+
+	// WHEN: the output is computed 10ms later to take effect 20ms later
+	stabilizer.setFeedForwardTime(0.02f);
+	const float *out = stabilizer.update(t + 10000);
+
+	// THEN: the output compensates the attitude 30ms after the estimate
+	const Eulerf expected = vehicleEuler(t + 30000);
+
+	for (int i = 0; i < 3; ++i) {
+		EXPECT_NEAR(out[i], -expected(i), 2e-3f);
+	}
+
+	// AND: the prediction is limited
+	const Quatf q_limited = stabilizer.predictAttitude(t + 1000000);
+	const Quatf q_max = stabilizer.predictAttitude(t + (uint64_t)(GimbalStabilizer::MAX_PREDICTION_TIME * 1e6f));
+
+	for (int i = 0; i < 4; ++i) {
+		EXPECT_FLOAT_EQ(q_limited(i), q_max(i));
+	}
+}
+
+TEST_F(GimbalStabilizerTest, eventDrivenLatencyAndStabilization)
+{
+	const uint64_t actuator_delay = 20000;
+
+	// WHEN: the output is updated every 50ms as the polling loop did
+	const Result polling = replay(false, 0.f, actuator_delay);
+
+	// AND: on every attitude and command publication
+	const Result event_driven = replay(true, 0.f, actuator_delay);
+
+	// AND: with the attitude feed-forward compensating the actuator delay
+	const Result feed_forward = replay(true, actuator_delay * 1e-6f, actuator_delay);
+
+	// THEN: commands are output as soon as the work item runs
+	EXPECT_GT(polling.max_latency, 40000u);
+	EXPECT_LE(event_driven.max_latency, 200u);
+	EXPECT_LE(feed_forward.max_latency, 200u);
+
+	// AND: the gimbal stabilization error is reduced
+	EXPECT_GT(polling.rms_error, 0.03f);
+	EXPECT_LT(event_driven.rms_error, polling.rms_error * 0.6f);
+	EXPECT_LT(feed_forward.rms_error, 0.005f);
+	EXPECT_LT(feed_forward.rms_error, event_driven.rms_error * 0.25f);
+
+}
@@ -87,6 +87,8 @@ struct ControlData {
 
 	bool gimbal_shutter_retract = false; /**< whether to lock the gimbal (only in RC output mode) */
 
+	uint64_t timestamp = 0; /**< time the command was published [us], to measure the latency until it is output */
+
 };
 
 
@@ -39,6 +39,8 @@
 
 #include "input.h"
 
+#include <drivers/drv_hrt.h>
+
 
 namespace vmount
 {
@@ -55,6 +57,7 @@ int InputBase::update(unsigned int timeout_ms, ControlData **control_data, bool
 		//on startup, set the mount to a neutral position
 		_control_data.type = ControlData::Type::Neutral;
 		_control_data.gimbal_shutter_retract = true;
+		_control_data.timestamp = hrt_absolute_time();
 		*control_data = &_control_data;
 		_initialized = true;
 		return 0;
@@ -110,6 +110,7 @@ int InputMavlinkROI::update_impl(unsigned int timeout_ms, ControlData **control_
 			orb_copy(ORB_ID(vehicle_roi), _vehicle_roi_sub, &vehicle_roi);
 
 			_control_data.gimbal_shutter_retract = false;
+			_control_data.timestamp = vehicle_roi.timestamp;
 
 			if (vehicle_roi.mode == vehicle_roi_s::ROI_NONE) {
 
@@ -167,6 +168,7 @@ void InputMavlinkROI::_read_control_data_from_position_setpoint_sub()
 	_control_data.type_data.lonlat.lon = position_setpoint_triplet.current.lon;
 	_control_data.type_data.lonlat.lat = position_setpoint_triplet.current.lat;
 	_control_data.type_data.lonlat.altitude = position_setpoint_triplet.current.alt;
+	_control_data.timestamp = position_setpoint_triplet.timestamp;
 }
 
 void InputMavlinkROI::print_status()
@@ -205,8 +207,8 @@ int InputMavlinkCmdMount::initialize()
 	}
 
 	// rate-limit inputs to 100Hz. If we don't do this and the output is configured to mavlink mode,
-	// it will publish vehicle_command's as well, causing the input poll() in here to return
-	// immediately, which in turn will cause an output update and thus a busy loop.
+	// it will publish vehicle_command's as well, each of them scheduling the vmount work item
+	// and returning new data in here, which in turn will cause an output update and thus a busy loop.
 	orb_set_interval(_vehicle_command_sub, 10);
 
 	return 0;
@@ -264,6 +266,7 @@ int InputMavlinkCmdMount::update_impl(unsigned int timeout_ms, ControlData **con
 				}
 
 				_control_data.gimbal_shutter_retract = false;
+				_control_data.timestamp = vehicle_command.timestamp;
 
 				if (vehicle_command.command == vehicle_command_s::VEHICLE_CMD_DO_MOUNT_CONTROL) {
 
@@ -140,6 +140,7 @@ bool InputRC::_read_control_data_from_subscription(ControlData &control_data, bo
 		}
 
 		control_data.gimbal_shutter_retract = false;
+		control_data.timestamp = manual_control_setpoint.timestamp;
 		return true;
 
 	} else {
@@ -41,6 +41,7 @@
 
 #include <math.h>
 
+#include <drivers/drv_hrt.h>
 #include <px4_posix.h>
 
 
@@ -73,6 +74,7 @@ int InputTest::update(unsigned int timeout_ms, ControlData **control_data, bool
 	}
 
 	_control_data.gimbal_shutter_retract = false;
+	_control_data.timestamp = hrt_absolute_time();
 	*control_data = &_control_data;
 	return 0;
 }
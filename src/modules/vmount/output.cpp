@@ -41,8 +41,6 @@
 #include "output.h"
 #include <errno.h>
 
-#include <uORB/topics/vehicle_attitude.h>
-#include <uORB/topics/vehicle_attitude.h>
 #include <uORB/topics/vehicle_global_position.h>
 #include <uORB/topics/mount_orientation.h>
 #include <px4_defines.h>
@@ -59,15 +57,11 @@ namespace vmount
 OutputBase::OutputBase(const OutputConfig &output_config)
 	: _config(output_config)
 {
-	_last_update = hrt_absolute_time();
+	_stabilizer.setFeedForwardTime(_config.feed_forward_time);
 }
 
 OutputBase::~OutputBase()
 {
-	if (_vehicle_attitude_sub >= 0) {
-		orb_unsubscribe(_vehicle_attitude_sub);
-	}
-
 	if (_vehicle_global_position_sub >= 0) {
 		orb_unsubscribe(_vehicle_global_position_sub);
 	}
@@ -79,10 +73,6 @@ OutputBase::~OutputBase()
 
 int OutputBase::initialize()
 {
-	if ((_vehicle_attitude_sub = orb_subscribe(ORB_ID(vehicle_attitude))) < 0) {
-		return -errno;
-	}
-
 	if ((_vehicle_global_position_sub = orb_subscribe(ORB_ID(vehicle_global_position))) < 0) {
 		return -errno;
 	}
@@ -119,23 +109,29 @@ float OutputBase::_calculate_pitch(double lon, double lat, float altitude,
 	return atan2f(z, target_distance);
 }
 
+void OutputBase::set_vehicle_attitude(const matrix::Quatf &q, const matrix::Vector3f &angular_velocity,
+				      hrt_abstime timestamp)
+{
+	_stabilizer.setAttitude(q, angular_velocity, timestamp);
+}
+
 void OutputBase::_set_angle_setpoints(const ControlData *control_data)
 {
 	_cur_control_data = control_data;
 
 	for (int i = 0; i < 3; ++i) {
-		_stabilize[i] = control_data->stabilize_axis[i];
-		_angle_speeds[i] = 0.f;
+		_stabilizer.setStabilize(i, control_data->stabilize_axis[i]);
+		_stabilizer.setAngularSpeed(i, 0.f);
 	}
 
 	switch (control_data->type) {
 	case ControlData::Type::Angle:
 		for (int i = 0; i < 3; ++i) {
 			if (control_data->type_data.angle.is_speed[i]) {
-				_angle_speeds[i] = control_data->type_data.angle.angles[i];
+				_stabilizer.setAngularSpeed(i, control_data->type_data.angle.angles[i]);
 
 			} else {
-				_angle_setpoints[i] = control_data->type_data.angle.angles[i];
+				_stabilizer.setAngleSetpoint(i, control_data->type_data.angle.angles[i]);
 			}
 		}
 
@@ -146,11 +142,13 @@ void OutputBase::_set_angle_setpoints(const ControlData *control_data)
 		break;
 
 	case ControlData::Type::Neutral:
-		_angle_setpoints[0] = 0.f;
-		_angle_setpoints[1] = 0.f;
-		_angle_setpoints[2] = 0.f;
+		_stabilizer.setAngleSetpoint(0, 0.f);
+		_stabilizer.setAngleSetpoint(1, 0.f);
+		_stabilizer.setAngleSetpoint(2, 0.f);
 		break;
 	}
+
+	_stabilizer.setpointUpdated(control_data->timestamp);
 }
 
 void OutputBase::_handle_position_update(bool force_update)
@@ -178,56 +176,35 @@ void OutputBase::_handle_position_update(bool force_update)
 	const double &lon = _cur_control_data->type_data.lonlat.lon;
 	const float &alt = _cur_control_data->type_data.lonlat.altitude;
 
-	_angle_setpoints[0] = _cur_control_data->type_data.lonlat.roll_angle;
+	float pitch;
 
 	// interface: use fixed pitch value > -pi otherwise consider ROI altitude
 	if (_cur_control_data->type_data.lonlat.pitch_fixed_angle >= -M_PI_F) {
-		_angle_setpoints[1] = _cur_control_data->type_data.lonlat.pitch_fixed_angle;
+		pitch = _cur_control_data->type_data.lonlat.pitch_fixed_angle;
 
 	} else {
-		_angle_setpoints[1] = _calculate_pitch(lon, lat, alt, vehicle_global_position);
+		pitch = _calculate_pitch(lon, lat, alt, vehicle_global_position);
 	}
 
-	_angle_setpoints[2] = get_bearing_to_next_waypoint(vlat, vlon, lat, lon) - vehicle_global_position.yaw;
+	float yaw = get_bearing_to_next_waypoint(vlat, vlon, lat, lon) - vehicle_global_position.yaw;
 
 	// add offsets from VEHICLE_CMD_DO_SET_ROI_WPNEXT_OFFSET
-	_angle_setpoints[1] += _cur_control_data->type_data.lonlat.pitch_angle_offset;
-	_angle_setpoints[2] += _cur_control_data->type_data.lonlat.yaw_angle_offset;
+	pitch += _cur_control_data->type_data.lonlat.pitch_angle_offset;
+	yaw += _cur_control_data->type_data.lonlat.yaw_angle_offset;
+
+	_stabilizer.setAngleSetpoint(0, _cur_control_data->type_data.lonlat.roll_angle);
+	_stabilizer.setAngleSetpoint(1, pitch);
 
 	// make sure yaw is wrapped correctly for the output
-	_angle_setpoints[2] = wrap_pi(_angle_setpoints[2]);
+	_stabilizer.setAngleSetpoint(2, wrap_pi(yaw));
 }
 
 void OutputBase::_calculate_output_angles(const hrt_abstime &t)
 {
-	//take speed into account
-	float dt = (t - _last_update) / 1.e6f;
+	const float *angle_outputs = _stabilizer.update(t);
 
 	for (int i = 0; i < 3; ++i) {
-		_angle_setpoints[i] += dt * _angle_speeds[i];
-	}
-
-	//get the output angles and stabilize if necessary
-	vehicle_attitude_s vehicle_attitude;
-	matrix::Eulerf euler;
-
-	if (_stabilize[0] || _stabilize[1] || _stabilize[2]) {
-		orb_copy(ORB_ID(vehicle_attitude), _vehicle_attitude_sub, &vehicle_attitude);
-		euler = matrix::Quatf(vehicle_attitude.q);
-	}
-
-	for (int i = 0; i < 3; ++i) {
-		if (_stabilize[i]) {
-			_angle_outputs[i] = _angle_setpoints[i] - euler(i);
-
-		} else {
-			_angle_outputs[i] = _angle_setpoints[i];
-		}
-
-		//bring angles into proper range [-pi, pi]
-		while (_angle_outputs[i] > M_PI_F) { _angle_outputs[i] -= 2.f * M_PI_F; }
-
-		while (_angle_outputs[i] < -M_PI_F) { _angle_outputs[i] += 2.f * M_PI_F; }
+		_angle_outputs[i] = angle_outputs[i];
 	}
 }
 
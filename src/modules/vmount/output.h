@@ -40,6 +40,7 @@
 #pragma once
 
 #include "common.h"
+#include "GimbalStabilizer.hpp"
 #include <drivers/drv_hrt.h>
 #include <lib/ecl/geo/geo.h>
 #include <uORB/uORB.h>
@@ -64,6 +65,8 @@ struct OutputConfig {
 	float roll_offset;	/**< Offset for roll channel in radians */
 	float yaw_offset;	/**< Offset for yaw channel in radians */
 
+	float feed_forward_time;	/**< Time the vehicle attitude is extrapolated ahead when stabilizing [s] */
+
 	uint32_t mavlink_sys_id;	/**< Mavlink target system id for mavlink output */
 	uint32_t mavlink_comp_id;
 };
@@ -94,6 +97,23 @@ public:
 	/** Publish _angle_outputs as a mount_orientation message. */
 	void publish();
 
+	/**
+	 * Set the vehicle attitude used for stabilization.
+	 * @param q rotation from body to NED frame
+	 * @param angular_velocity body rates [rad/s]
+	 * @param timestamp time of the attitude estimate
+	 */
+	void set_vehicle_attitude(const matrix::Quatf &q, const matrix::Vector3f &angular_velocity, hrt_abstime timestamp);
+
+	/** @return true if any axis is stabilized */
+	bool stabilizing() const { return _stabilizer.isStabilizing(); }
+
+	/**
+	 * @param latency_us set to the latency from the command to the output [us]
+	 * @return true if the last update output a new command
+	 */
+	bool get_setpoint_latency(uint64_t &latency_us) const { return _stabilizer.getSetpointLatency(latency_us); }
+
 protected:
 	float _calculate_pitch(double lon, double lat, float altitude,
 			       const vehicle_global_position_s &global_position);
@@ -109,20 +129,16 @@ protected:
 	void _handle_position_update(bool force_update = false);
 
 	const ControlData *_cur_control_data = nullptr;
-	float _angle_setpoints[3] = { 0.f, 0.f, 0.f }; ///< [rad]
-	float _angle_speeds[3] = { 0.f, 0.f, 0.f };
-	bool _stabilize[3] = { false, false, false };
+
+	/** angle setpoints, speeds & stabilize flags, computes the output angles */
+	GimbalStabilizer _stabilizer;
 
 	/** calculate the _angle_outputs (with speed) and stabilize if needed */
 	void _calculate_output_angles(const hrt_abstime &t);
 
 	float _angle_outputs[3] = { 0.f, 0.f, 0.f }; ///< calculated output angles (roll, pitch, yaw) [rad]
-	hrt_abstime _last_update;
-
-	int _get_vehicle_attitude_sub() const { return _vehicle_attitude_sub; }
 
 private:
-	int _vehicle_attitude_sub = -1;
 	int _vehicle_global_position_sub = -1;
 
 	orb_advert_t _mount_orientation_pub = nullptr;
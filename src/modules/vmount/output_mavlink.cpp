@@ -95,8 +95,6 @@ int OutputMavlink::update(const ControlData *control_data)
 
 	_vehicle_command_pub.publish(vehicle_command);
 
-	_last_update = t;
-
 	return 0;
 }
 
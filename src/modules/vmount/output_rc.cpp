@@ -83,8 +83,6 @@ int OutputRC::update(const ControlData *control_data)
 	orb_publish_auto(ORB_ID(actuator_controls_2), &_actuator_controls_pub, &actuator_controls,
 			 &instance, ORB_PRIO_DEFAULT);
 
-	_last_update = t;
-
 	return 0;
 }
 
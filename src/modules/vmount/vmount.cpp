@@ -41,19 +41,19 @@
  * Driver for to control mounts such as gimbals or servos.
  * Inputs for the mounts can RC and/or mavlink commands.
  * Outputs to the mounts can be RC (PWM) output or mavlink.
+ *
+ * Runs on a work queue whenever an input command or the vehicle attitude is published.
  */
 
 #include <math.h>
 #include <stdlib.h>
-#include <stdio.h>
-#include <stdbool.h>
 #include <string.h>
-#include <sys/types.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <systemlib/err.h>
+#include <px4_config.h>
 #include <px4_defines.h>
-#include <px4_tasks.h>
+#include <px4_module.h>
+#include <px4_platform_common/px4_work_queue/WorkItem.hpp>
+#include <drivers/drv_hrt.h>
+#include <perf/perf_counter.h>
 
 #include "input_mavlink.h"
 #include "input_rc.h"
@@ -62,25 +62,24 @@
 #include "output_mavlink.h"
 
 #include <uORB/Subscription.hpp>
+#include <uORB/SubscriptionCallback.hpp>
+#include <uORB/topics/manual_control_setpoint.h>
 #include <uORB/topics/parameter_update.h>
-
-#include <px4_config.h>
-#include <px4_module.h>
+#include <uORB/topics/position_setpoint_triplet.h>
+#include <uORB/topics/vehicle_angular_velocity.h>
+#include <uORB/topics/vehicle_attitude.h>
+#include <uORB/topics/vehicle_command.h>
+#include <uORB/topics/vehicle_roi.h>
 
 using namespace vmount;
 
-/* thread state */
-static volatile bool thread_should_exit = false;
-static volatile bool thread_running = false;
-
 static constexpr int input_objs_len_max = 3;
 
-struct ThreadData {
-	InputBase *input_objs[input_objs_len_max] = {nullptr, nullptr, nullptr};
-	int input_objs_len = 0;
-	OutputBase *output_obj = nullptr;
-};
-static volatile ThreadData *g_thread_data = nullptr;
+/** minimum interval of the attitude updates of the mavlink output, to limit the vehicle_command rate */
+static constexpr uint32_t mavlink_output_interval_us = 20000;
+
+/** minimum interval of the attitude updates of the AUX output, gimbal servos do not follow faster updates */
+static constexpr uint32_t aux_output_interval_us = 10000;
 
 struct Parameters {
 	int32_t mnt_mode_in;
@@ -99,6 +98,7 @@ struct Parameters {
 	float mnt_off_pitch;
 	float mnt_off_roll;
 	float mnt_off_yaw;
+	float mnt_ff_time;
 
 	bool operator!=(const Parameters &p)
 	{
@@ -119,7 +119,8 @@ struct Parameters {
 		       mnt_range_yaw != p.mnt_range_yaw ||
 		       mnt_off_pitch != p.mnt_off_pitch ||
 		       mnt_off_roll != p.mnt_off_roll ||
-		       mnt_off_yaw != p.mnt_off_yaw;
+		       mnt_off_yaw != p.mnt_off_yaw ||
+		       mnt_ff_time != p.mnt_ff_time;
 #pragma GCC diagnostic pop
 
 	}
@@ -142,383 +143,446 @@ struct ParameterHandles {
 	param_t mnt_off_pitch;
 	param_t mnt_off_roll;
 	param_t mnt_off_yaw;
+	param_t mnt_ff_time;
 };
 
 
-/* functions */
-static void usage();
-static void update_params(ParameterHandles &param_handles, Parameters &params, bool &got_changes);
+
 static bool get_params(ParameterHandles &param_handles, Parameters &params);
+static void update_params(ParameterHandles &param_handles, Parameters &params, bool &got_changes);
 
-static int vmount_thread_main(int argc, char *argv[]);
-extern "C" __EXPORT int vmount_main(int argc, char *argv[]);
 
-static int vmount_thread_main(int argc, char *argv[])
+class Vmount : public ModuleBase<Vmount>, public px4::WorkItem
 {
-	ParameterHandles param_handles;
-	Parameters params {};
-	OutputConfig output_config;
-	ThreadData thread_data;
+public:
+	/**
+	 * @param test_input fixed test input, the mount is controlled by the inputs from MNT_MODE_IN if nullptr
+	 */
+	Vmount(InputTest *test_input);
+	~Vmount() override;
 
-	InputTest *test_input = nullptr;
+	/** @see ModuleBase */
+	static int task_spawn(int argc, char *argv[]);
 
-#ifdef __PX4_NUTTX
-	/* the NuttX optarg handler does not
-	 * ignore argv[0] like the POSIX handler
-	 * does, nor does it deal with non-flag
-	 * verbs well. So we Remove the application
-	 * name and the verb.
-	 */
-	argc -= 1;
-	argv += 1;
-#endif
+	/** @see ModuleBase */
+	static int custom_command(int argc, char *argv[]);
 
-	if (argc > 0 && !strcmp(argv[0], "test")) {
-		PX4_INFO("Starting in test mode");
+	/** @see ModuleBase */
+	static int print_usage(const char *reason = nullptr);
 
-		const char *axis_names[3] = {"roll", "pitch", "yaw"};
-		float angles[3] = { 0.f, 0.f, 0.f };
+	/** @see ModuleBase::print_status() */
+	int print_status() override;
 
-		if (argc == 3) {
-			bool found_axis = false;
+	bool init();
 
-			for (int i = 0 ; i < 3; ++i) {
-				if (!strcmp(argv[1], axis_names[i])) {
-					long angle_deg = strtol(argv[2], nullptr, 0);
-					angles[i] = (float)angle_deg;
-					found_axis = true;
-				}
-			}
+private:
+	void Run() override;
 
-			if (!found_axis) {
-				usage();
-				return -1;
-			}
+	/**
+	 * Create the input and output objects from the parameters.
+	 * @return false on failure
+	 */
+	bool _create_objects();
+	void _delete_objects();
 
-			test_input = new InputTest(angles[0], angles[1], angles[2]);
+	/** (un)register the callbacks of the topics that trigger an update */
+	void _register_callbacks();
+	void _unregister_callbacks();
 
-			if (!test_input) {
-				PX4_ERR("memory allocation failed");
-				return -1;
-			}
+	InputBase *_input_objs[input_objs_len_max] {};
+	int _input_objs_len{0};
+	int _last_active{0};
+	OutputBase *_output_obj{nullptr};
+	OutputConfig _output_config{};
 
-		} else {
-			usage();
-			return -1;
-		}
-	}
+	InputTest *_test_input{nullptr};
 
-	if (!get_params(param_handles, params)) {
-		PX4_ERR("could not get mount parameters!");
-		delete test_input;
-		return -1;
-	}
+	ParameterHandles _param_handles{};
+	Parameters _params{};
+
+	// the inputs read the commands themselves, these only schedule the work item
+	uORB::SubscriptionCallbackWorkItem _vehicle_command_sub{this, ORB_ID(vehicle_command)};
+	uORB::SubscriptionCallbackWorkItem _vehicle_roi_sub{this, ORB_ID(vehicle_roi)};
+	uORB::SubscriptionCallbackWorkItem _position_setpoint_triplet_sub{this, ORB_ID(position_setpoint_triplet)};
+	uORB::SubscriptionCallbackWorkItem _manual_control_setpoint_sub{this, ORB_ID(manual_control_setpoint)};
 
-	uORB::Subscription parameter_update_sub{ORB_ID(parameter_update)};
-	thread_running = true;
-	ControlData *control_data = nullptr;
-	g_thread_data = &thread_data;
+	uORB::SubscriptionCallbackWorkItem _vehicle_attitude_sub{this, ORB_ID(vehicle_attitude)};
+	uORB::SubscriptionCallbackWorkItem _parameter_update_sub{this, ORB_ID(parameter_update)};
 
-	int last_active = 0;
+	uORB::Subscription _vehicle_angular_velocity_sub{ORB_ID(vehicle_angular_velocity)};
 
-	while (!thread_should_exit) {
+	perf_counter_t _cycle_perf{perf_alloc(PC_ELAPSED, "vmount: cycle")};
+	perf_counter_t _latency_perf{perf_alloc(PC_ELAPSED, "vmount: setpoint latency")};
+};
 
-		if (!thread_data.input_objs[0] && (params.mnt_mode_in >= 0 || test_input)) { //need to initialize
 
-			output_config.gimbal_normal_mode_value = params.mnt_ob_norm_mode;
-			output_config.gimbal_retracted_mode_value = params.mnt_ob_lock_mode;
-			output_config.pitch_scale = 1.0f / ((params.mnt_range_pitch / 2.0f) * M_DEG_TO_RAD_F);
-			output_config.roll_scale = 1.0f / ((params.mnt_range_roll / 2.0f) * M_DEG_TO_RAD_F);
-			output_config.yaw_scale = 1.0f / ((params.mnt_range_yaw / 2.0f) * M_DEG_TO_RAD_F);
-			output_config.pitch_offset = params.mnt_off_pitch * M_DEG_TO_RAD_F;
-			output_config.roll_offset = params.mnt_off_roll * M_DEG_TO_RAD_F;
-			output_config.yaw_offset = params.mnt_off_yaw * M_DEG_TO_RAD_F;
-			output_config.mavlink_sys_id = params.mnt_mav_sysid;
-			output_config.mavlink_comp_id = params.mnt_mav_compid;
+Vmount::Vmount(InputTest *test_input) :
+	WorkItem(MODULE_NAME, px4::wq_configurations::att_pos_ctrl),
+	_test_input(test_input)
+{
+}
 
-			bool alloc_failed = false;
-			thread_data.input_objs_len = 1;
+Vmount::~Vmount()
+{
+	_delete_objects();
+	delete _test_input;
 
-			if (test_input) {
-				thread_data.input_objs[0] = test_input;
+	perf_free(_cycle_perf);
+	perf_free(_latency_perf);
+}
 
-			} else {
-				switch (params.mnt_mode_in) {
-				case 0:
+bool Vmount::init()
+{
+	if (!get_params(_param_handles, _params)) {
+		PX4_ERR("could not get mount parameters!");
+		return false;
+	}
 
-					// Automatic
-					thread_data.input_objs[0] = new InputMavlinkCmdMount(params.mnt_do_stab);
-					thread_data.input_objs[1] = new InputMavlinkROI();
+	if (!_parameter_update_sub.registerCallback()) {
+		PX4_ERR("parameter_update callback registration failed!");
+		return false;
+	}
 
-					// RC is on purpose last here so that if there are any mavlink
-					// messages, they will take precedence over RC.
-					// This logic is done further below while update() is called.
-					thread_data.input_objs[2] = new InputRC(params.mnt_do_stab, params.mnt_man_roll, params.mnt_man_pitch,
-										params.mnt_man_yaw);
-					thread_data.input_objs_len = 3;
+	ScheduleNow();
 
-					break;
+	return true;
+}
 
-				case 1: //RC
-					thread_data.input_objs[0] = new InputRC(params.mnt_do_stab, params.mnt_man_roll, params.mnt_man_pitch,
-										params.mnt_man_yaw);
-					break;
+bool Vmount::_create_objects()
+{
+	_output_config.gimbal_normal_mode_value = _params.mnt_ob_norm_mode;
+	_output_config.gimbal_retracted_mode_value = _params.mnt_ob_lock_mode;
+	_output_config.pitch_scale = 1.0f / ((_params.mnt_range_pitch / 2.0f) * M_DEG_TO_RAD_F);
+	_output_config.roll_scale = 1.0f / ((_params.mnt_range_roll / 2.0f) * M_DEG_TO_RAD_F);
+	_output_config.yaw_scale = 1.0f / ((_params.mnt_range_yaw / 2.0f) * M_DEG_TO_RAD_F);
+	_output_config.pitch_offset = _params.mnt_off_pitch * M_DEG_TO_RAD_F;
+	_output_config.roll_offset = _params.mnt_off_roll * M_DEG_TO_RAD_F;
+	_output_config.yaw_offset = _params.mnt_off_yaw * M_DEG_TO_RAD_F;
+	_output_config.mavlink_sys_id = _params.mnt_mav_sysid;
+	_output_config.mavlink_comp_id = _params.mnt_mav_compid;
+	_output_config.feed_forward_time = _params.mnt_ff_time;
+
+	bool alloc_failed = false;
+	_input_objs_len = 1;
+
+	if (_test_input) {
+		_input_objs[0] = _test_input;
+
+	} else {
+		switch (_params.mnt_mode_in) {
+		case 0:
+
+			// Automatic
+			_input_objs[0] = new InputMavlinkCmdMount(_params.mnt_do_stab);
+			_input_objs[1] = new InputMavlinkROI();
+
+			// RC is on purpose last here so that if there are any mavlink
+			// messages, they will take precedence over RC.
+			// This logic is done further below while update() is called.
+			_input_objs[2] = new InputRC(_params.mnt_do_stab, _params.mnt_man_roll, _params.mnt_man_pitch,
+						     _params.mnt_man_yaw);
+			_input_objs_len = 3;
 
-				case 2: //MAVLINK_ROI
-					thread_data.input_objs[0] = new InputMavlinkROI();
-					break;
+			break;
 
-				case 3: //MAVLINK_DO_MOUNT
-					thread_data.input_objs[0] = new InputMavlinkCmdMount(params.mnt_do_stab);
-					break;
+		case 1: //RC
+			_input_objs[0] = new InputRC(_params.mnt_do_stab, _params.mnt_man_roll, _params.mnt_man_pitch,
+						     _params.mnt_man_yaw);
+			break;
 
-				default:
-					PX4_ERR("invalid input mode %i", params.mnt_mode_in);
-					break;
-				}
-			}
+		case 2: //MAVLINK_ROI
+			_input_objs[0] = new InputMavlinkROI();
+			break;
 
-			for (int i = 0; i < thread_data.input_objs_len; ++i) {
-				if (!thread_data.input_objs[i]) {
-					alloc_failed = true;
-				}
-			}
+		case 3: //MAVLINK_DO_MOUNT
+			_input_objs[0] = new InputMavlinkCmdMount(_params.mnt_do_stab);
+			break;
 
-			switch (params.mnt_mode_out) {
-			case 0: //AUX
-				thread_data.output_obj = new OutputRC(output_config);
+		default:
+			PX4_ERR("invalid input mode %i", _params.mnt_mode_in);
+			break;
+		}
+	}
 
-				if (!thread_data.output_obj) { alloc_failed = true; }
+	for (int i = 0; i < _input_objs_len; ++i) {
+		if (!_input_objs[i]) {
+			alloc_failed = true;
+		}
+	}
 
-				break;
+	switch (_params.mnt_mode_out) {
+	case 0: //AUX
+		_output_obj = new OutputRC(_output_config);
+		break;
 
-			case 1: //MAVLINK
-				thread_data.output_obj = new OutputMavlink(output_config);
+	case 1: //MAVLINK
+		_output_obj = new OutputMavlink(_output_config);
+		break;
 
-				if (!thread_data.output_obj) { alloc_failed = true; }
+	default:
+		PX4_ERR("invalid output mode %i", _params.mnt_mode_out);
+		return false;
+	}
 
-				break;
+	if (!_output_obj) { alloc_failed = true; }
 
-			default:
-				PX4_ERR("invalid output mode %i", params.mnt_mode_out);
-				thread_should_exit = true;
-				break;
-			}
+	if (alloc_failed) {
+		PX4_ERR("memory allocation failed");
+		return false;
+	}
 
-			if (alloc_failed) {
-				thread_data.input_objs_len = 0;
-				PX4_ERR("memory allocation failed");
-				thread_should_exit = true;
-			}
+	int ret = _output_obj->initialize();
 
-			if (thread_should_exit) {
-				break;
-			}
+	if (ret) {
+		PX4_ERR("failed to initialize output mode (%i)", ret);
+		return false;
+	}
 
-			int ret = thread_data.output_obj->initialize();
+	return true;
+}
 
-			if (ret) {
-				PX4_ERR("failed to initialize output mode (%i)", ret);
-				thread_should_exit = true;
-				break;
-			}
+void Vmount::_delete_objects()
+{
+	for (int i = 0; i < input_objs_len_max; ++i) {
+		// the test input is kept if the objects are re-created
+		if (_input_objs[i] && _input_objs[i] != _test_input) {
+			delete (_input_objs[i]);
 		}
 
-		if (thread_data.input_objs_len > 0) {
+		_input_objs[i] = nullptr;
+	}
 
-			//get input: we cannot make the timeout too large, because the output needs to update
-			//periodically for stabilization and angle updates.
+	_input_objs_len = 0;
+	_last_active = 0;
 
-			for (int i = 0; i < thread_data.input_objs_len; ++i) {
+	if (_output_obj) {
+		delete (_output_obj);
+		_output_obj = nullptr;
+	}
+}
 
-				bool already_active = (last_active == i);
+void Vmount::_register_callbacks()
+{
+	if (!_test_input) {
+		_vehicle_command_sub.registerCallback();
+		_vehicle_roi_sub.registerCallback();
+		_position_setpoint_triplet_sub.registerCallback();
+		_manual_control_setpoint_sub.registerCallback();
+	}
 
-				ControlData *control_data_to_check = nullptr;
-				unsigned int poll_timeout = already_active ? 50 : 0; // poll only on active input to reduce latency
-				int ret = thread_data.input_objs[i]->update(poll_timeout, &control_data_to_check, already_active);
+	// the output is updated with the attitude, limited such that the work item does not run at the full
+	// attitude rate on the controller work queue, and further for the mavlink output to not flood the link
+	_vehicle_attitude_sub.set_interval_us(_params.mnt_mode_out == 1 ? mavlink_output_interval_us : aux_output_interval_us);
+	_vehicle_attitude_sub.registerCallback();
+}
 
-				if (ret) {
-					PX4_ERR("failed to read input %i (ret: %i)", i, ret);
-					continue;
-				}
+void Vmount::_unregister_callbacks()
+{
+	_vehicle_command_sub.unregisterCallback();
+	_vehicle_roi_sub.unregisterCallback();
+	_position_setpoint_triplet_sub.unregisterCallback();
+	_manual_control_setpoint_sub.unregisterCallback();
+	_vehicle_attitude_sub.unregisterCallback();
+}
 
-				if (control_data_to_check != nullptr || already_active) {
-					control_data = control_data_to_check;
-					last_active = i;
-				}
-			}
+void Vmount::Run()
+{
+	if (should_exit()) {
+		_unregister_callbacks();
+		_parameter_update_sub.unregisterCallback();
+		exit_and_cleanup();
+		return;
+	}
 
-			//update output
-			int ret = thread_data.output_obj->update(control_data);
+	perf_begin(_cycle_perf);
 
-			if (ret) {
-				PX4_ERR("failed to write output (%i)", ret);
-				break;
-			}
+	// check for parameter updates
+	parameter_update_s pupdate;
 
-			thread_data.output_obj->publish();
+	if (_parameter_update_sub.update(&pupdate)) {
+		// update parameters from storage
+		bool updated = false;
+		update_params(_param_handles, _params, updated);
 
-		} else {
-			//wait for parameter changes. We still need to wake up regularily to check for thread exit requests
-			px4_usleep(1e6);
+		if (updated) {
+			//re-init objects
+			_unregister_callbacks();
+			_delete_objects();
 		}
+	}
 
-		if (test_input && test_input->finished()) {
-			thread_should_exit = true;
-			break;
+	if (!_output_obj && (_params.mnt_mode_in >= 0 || _test_input)) { //need to initialize
+		if (!_create_objects()) {
+			_delete_objects();
+			perf_end(_cycle_perf);
+			request_stop();
+			ScheduleNow();
+			return;
 		}
 
-		// check for parameter updates
-		if (parameter_update_sub.updated()) {
-			// clear update
-			parameter_update_s pupdate;
-			parameter_update_sub.copy(&pupdate);
-
-			// update parameters from storage
-			bool updated = false;
-			update_params(param_handles, params, updated);
-
-			if (updated) {
-				//re-init objects
-				for (int i = 0; i < input_objs_len_max; ++i) {
-					if (thread_data.input_objs[i]) {
-						delete (thread_data.input_objs[i]);
-						thread_data.input_objs[i] = nullptr;
-					}
-				}
+		_register_callbacks();
+	}
 
-				thread_data.input_objs_len = 0;
+	if (_input_objs_len > 0) {
 
-				last_active = 0;
+		vehicle_attitude_s vehicle_attitude;
+		const bool attitude_updated = _vehicle_attitude_sub.update(&vehicle_attitude);
 
-				if (thread_data.output_obj) {
-					delete (thread_data.output_obj);
-					thread_data.output_obj = nullptr;
-				}
+		if (attitude_updated) {
+			vehicle_angular_velocity_s vehicle_angular_velocity{};
+			_vehicle_angular_velocity_sub.copy(&vehicle_angular_velocity);
+
+			_output_obj->set_vehicle_attitude(matrix::Quatf(vehicle_attitude.q),
+							  matrix::Vector3f(vehicle_angular_velocity.xyz), vehicle_attitude.timestamp);
+		}
+
+		// get input: the inputs are checked without waiting, any of them schedules the work item
+		ControlData *control_data = nullptr;
+
+		for (int i = 0; i < _input_objs_len; ++i) {
+
+			bool already_active = (_last_active == i);
+
+			ControlData *control_data_to_check = nullptr;
+			int ret = _input_objs[i]->update(0, &control_data_to_check, already_active);
+
+			if (ret) {
+				PX4_ERR("failed to read input %i (ret: %i)", i, ret);
+				continue;
+			}
+
+			if (control_data_to_check != nullptr || already_active) {
+				control_data = control_data_to_check;
+				_last_active = i;
 			}
 		}
-	}
 
-	g_thread_data = nullptr;
+		// update the output on new commands, and at the attitude rate for stabilization and angle updates
+		if (control_data || attitude_updated || _test_input) {
+			int ret = _output_obj->update(control_data);
 
-	for (int i = 0; i < input_objs_len_max; ++i) {
-		if (thread_data.input_objs[i]) {
-			delete (thread_data.input_objs[i]);
-			thread_data.input_objs[i] = nullptr;
+			if (ret) {
+				PX4_ERR("failed to write output (%i)", ret);
+				perf_end(_cycle_perf);
+				request_stop();
+				ScheduleNow();
+				return;
+			}
+
+			_output_obj->publish();
+
+			uint64_t latency_us = 0;
+
+			if (_output_obj->get_setpoint_latency(latency_us)) {
+				perf_set_elapsed(_latency_perf, latency_us);
+			}
 		}
 	}
 
-	thread_data.input_objs_len = 0;
+	perf_end(_cycle_perf);
 
-	if (thread_data.output_obj) {
-		delete (thread_data.output_obj);
-		thread_data.output_obj = nullptr;
+	if (_test_input && _test_input->finished()) {
+		request_stop();
+		ScheduleNow();
 	}
-
-	thread_running = false;
-	return 0;
 }
 
-/**
- * The main command function.
- * Processes command line arguments and starts the daemon.
- */
-int vmount_main(int argc, char *argv[])
+int Vmount::task_spawn(int argc, char *argv[])
 {
-	if (argc < 2) {
-		PX4_ERR("missing command");
-		usage();
-		return -1;
-	}
+	InputTest *test_input = nullptr;
 
-	const bool found_start = !strcmp(argv[1], "start");
-	const bool found_test = !strcmp(argv[1], "test");
+	if (argc > 0 && !strcmp(argv[0], "test")) {
+		PX4_INFO("Starting in test mode");
 
-	if (found_start || found_test) {
+		const char *axis_names[3] = {"roll", "pitch", "yaw"};
+		float angles[3] = { 0.f, 0.f, 0.f };
 
-		/* this is not an error */
-		if (thread_running) {
-			if (found_start) {
-				PX4_WARN("mount driver already running");
-				return 0;
+		if (argc == 3) {
+			bool found_axis = false;
 
-			} else {
-				PX4_WARN("mount driver already running, run vmount stop before 'vmount test'");
-				return 1;
+			for (int i = 0 ; i < 3; ++i) {
+				if (!strcmp(argv[1], axis_names[i])) {
+					long angle_deg = strtol(argv[2], nullptr, 0);
+					angles[i] = (float)angle_deg;
+					found_axis = true;
+				}
 			}
-		}
 
-		thread_should_exit = false;
-		int vmount_task = px4_task_spawn_cmd("vmount",
-						     SCHED_DEFAULT,
-						     SCHED_PRIORITY_DEFAULT,
-						     1900,
-						     vmount_thread_main,
-						     (char *const *)argv + 1);
-
-		int counter = 0;
+			if (!found_axis) {
+				print_usage();
+				return -1;
+			}
 
-		while (!thread_running && vmount_task >= 0) {
-			px4_usleep(5000);
+			test_input = new InputTest(angles[0], angles[1], angles[2]);
 
-			if (++counter >= 100) {
-				break;
+			if (!test_input) {
+				PX4_ERR("memory allocation failed");
+				return -1;
 			}
-		}
 
-		if (vmount_task < 0) {
-			PX4_ERR("failed to start");
+		} else {
+			print_usage();
 			return -1;
 		}
-
-		return counter < 100 || thread_should_exit ? 0 : -1;
 	}
 
-	if (!strcmp(argv[1], "stop")) {
-
-		/* this is not an error */
-		if (!thread_running) {
-			PX4_WARN("mount driver not running");
-			return 0;
-		}
+	Vmount *instance = new Vmount(test_input);
 
-		thread_should_exit = true;
+	if (instance) {
+		_object.store(instance);
+		_task_id = task_id_is_work_queue;
 
-		while (thread_running) {
-			px4_usleep(100000);
+		if (instance->init()) {
+			return PX4_OK;
 		}
 
-		return 0;
+	} else {
+		PX4_ERR("alloc failed");
+		delete test_input;
 	}
 
-	if (!strcmp(argv[1], "status")) {
-		if (thread_running && g_thread_data) {
+	delete instance;
+	_object.store(nullptr);
+	_task_id = -1;
 
-			for (int i = 0; i < g_thread_data->input_objs_len; ++i) {
-				g_thread_data->input_objs[i]->print_status();
-			}
+	return PX4_ERROR;
+}
 
-			if (g_thread_data->input_objs_len == 0) {
-				PX4_INFO("Input: None");
-			}
+int Vmount::custom_command(int argc, char *argv[])
+{
+	if (!strcmp(argv[0], "test")) {
+		if (is_running()) {
+			PX4_WARN("mount driver already running, run vmount stop before 'vmount test'");
+			return 1;
+		}
 
-			if (g_thread_data->output_obj) {
-				g_thread_data->output_obj->print_status();
+		return task_spawn(argc, argv);
+	}
 
-			} else {
-				PX4_INFO("Output: None");
-			}
+	return print_usage("unknown command");
+}
 
-		} else {
-			PX4_INFO("not running");
-		}
+int Vmount::print_status()
+{
+	for (int i = 0; i < _input_objs_len; ++i) {
+		_input_objs[i]->print_status();
+	}
+
+	if (_input_objs_len == 0) {
+		PX4_INFO("Input: None");
+	}
+
+	if (_output_obj) {
+		_output_obj->print_status();
 
-		return 0;
+	} else {
+		PX4_INFO("Output: None");
 	}
 
-	PX4_ERR("unrecognized command");
-	usage();
-	return -1;
+	perf_print_counter(_cycle_perf);
+	perf_print_counter(_latency_perf);
+
+	return 0;
 }
 
 void update_params(ParameterHandles &param_handles, Parameters &params, bool &got_changes)
@@ -540,6 +604,7 @@ void update_params(ParameterHandles &param_handles, Parameters &params, bool &go
 	param_get(param_handles.mnt_off_pitch, &params.mnt_off_pitch);
 	param_get(param_handles.mnt_off_roll, &params.mnt_off_roll);
 	param_get(param_handles.mnt_off_yaw, &params.mnt_off_yaw);
+	param_get(param_handles.mnt_ff_time, &params.mnt_ff_time);
 
 	got_changes = prev_params != params;
 }
@@ -562,6 +627,7 @@ bool get_params(ParameterHandles &param_handles, Parameters &params)
 	param_handles.mnt_off_pitch = param_find("MNT_OFF_PITCH");
 	param_handles.mnt_off_roll = param_find("MNT_OFF_ROLL");
 	param_handles.mnt_off_yaw = param_find("MNT_OFF_YAW");
+	param_handles.mnt_ff_time = param_find("MNT_FF_TIME");
 
 	if (param_handles.mnt_mode_in == PARAM_INVALID ||
 	    param_handles.mnt_mode_out == PARAM_INVALID ||
@@ -578,7 +644,8 @@ bool get_params(ParameterHandles &param_handles, Parameters &params)
 	    param_handles.mnt_range_yaw == PARAM_INVALID ||
 	    param_handles.mnt_off_pitch == PARAM_INVALID ||
 	    param_handles.mnt_off_roll == PARAM_INVALID ||
-	    param_handles.mnt_off_yaw == PARAM_INVALID) {
+	    param_handles.mnt_off_yaw == PARAM_INVALID ||
+	    param_handles.mnt_ff_time == PARAM_INVALID) {
 		return false;
 	}
 
@@ -587,8 +654,12 @@ bool get_params(ParameterHandles &param_handles, Parameters &params)
 	return true;
 }
 
-static void usage()
+int Vmount::print_usage(const char *reason)
 {
+	if (reason) {
+		PX4_WARN("%s\n", reason);
+	}
+
 	PRINT_MODULE_DESCRIPTION(
 		R"DESCR_STR(
 ### Description
@@ -602,6 +673,10 @@ Each method is implemented in its own class, and there is a common base class fo
 They are connected via an API, defined by the `ControlData` data structure. This makes sure that each input method
 can be used with each output method and new inputs/outputs can be added with minimal effort.
 
+The driver runs whenever an input command or the vehicle attitude is published. Stabilized axes compensate
+the vehicle attitude, extrapolated with the angular velocity by `MNT_FF_TIME`. The `status` command reports
+the latency from a command to the output.
+
 ### Examples
 Test the output by setting a fixed yaw angle (and the other axes to 0):
 $ vmount stop
@@ -613,4 +688,17 @@ $ vmount test yaw 30
 	PRINT_MODULE_USAGE_COMMAND_DESCR("test", "Test the output: set a fixed angle for one axis (vmount must not be running)");
 	PRINT_MODULE_USAGE_ARG("roll|pitch|yaw <angle>", "Specify an axis and an angle in degrees", false);
 	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
+
+	return 0;
+}
+
+/**
+ * The main command function.
+ * Processes command line arguments and starts the work item.
+ */
+extern "C" __EXPORT int vmount_main(int argc, char *argv[]);
+
+int vmount_main(int argc, char *argv[])
+{
+	return Vmount::main(argc, argv);
 }
@@ -228,3 +228,18 @@ PARAM_DEFINE_FLOAT(MNT_OFF_ROLL, 0.0f);
 * @group Mount
 */
 PARAM_DEFINE_FLOAT(MNT_OFF_YAW, 0.0f);
+
+/**
+* Attitude feed-forward time for stabilized axes.
+*
+* The vehicle attitude is extrapolated with the angular velocity by this time,
+* to compensate the delay from the output until the gimbal moves.
+*
+* @unit s
+* @min 0.0
+* @max 0.1
+* @decimal 3
+* @increment 0.005
+* @group Mount
+*/
+PARAM_DEFINE_FLOAT(MNT_FF_TIME, 0.01f);
@@ -57,6 +57,24 @@ __BEGIN_DECLS
  */
 __EXPORT extern void px4_log_initialize(void);
 
+#if defined(__PX4_POSIX)
+#include <stdbool.h>
+
+/**
+ * Select whether the messages of the calling thread are formatted and printed by the log
+ * formatter thread (the default once the orb logging is initialized) or immediately.
+ * Threads that mix log messages with direct stdout output (e.g. the interactive shell)
+ * should log immediately to keep the output in order.
+ */
+__EXPORT extern void px4_log_set_deferred(bool deferred);
+
+/**
+ * Wake up the log formatter to print and publish the pending deferred messages of the
+ * calling thread. Does not wait for the output.
+ */
+__EXPORT extern void px4_log_flush(void);
+#endif
+
 __END_DECLS
 
 /****************************************************************************
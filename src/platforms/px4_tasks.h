@@ -148,6 +148,7 @@ typedef struct {
 //      SCHED_PRIORITY_DEFAULT
 #define SCHED_PRIORITY_LOG_WRITER		(SCHED_PRIORITY_DEFAULT - 10)
 #define SCHED_PRIORITY_PARAMS			(SCHED_PRIORITY_DEFAULT - 15)
+#define SCHED_PRIORITY_LOG_FORMATTER		(SCHED_PRIORITY_DEFAULT - 20)
 //      SCHED_PRIORITY_IDLE
 
 typedef int (*px4_main_t)(int argc, char *argv[]);
@@ -35,6 +35,9 @@
  * @file sd_bench.c
  *
  * SD Card benchmarking
+ *
+ * Besides sequential writes, the storage can be profiled with the write pattern of the logger
+ * and dataman (see workload.c), either synthesized or replayed from a trace.
  */
 
 #include <stdio.h>
@@ -49,6 +52,8 @@
 
 #include <drivers/drv_hrt.h>
 
+#include "workload.h"
+
 static void	usage(void);
 
 /** sequential write speed test */
@@ -64,6 +69,7 @@ static inline unsigned int time_fsync(int fd);
 __EXPORT int	sd_bench_main(int argc, char *argv[]);
 
 static const char *BENCHMARK_FILE = PX4_STORAGEDIR"/benchmark.tmp";
+static const char *DATAMAN_SUFFIX = ".dm";
 
 static int num_runs; ///< number of runs
 static int run_duration; ///< duration of a single run [ms]
@@ -72,13 +78,26 @@ static bool synchronized; ///< call fsync after each block?
 static void
 usage()
 {
-	PRINT_MODULE_DESCRIPTION("Test the speed of an SD Card");
+	PRINT_MODULE_DESCRIPTION("Test the speed of an SD Card\n"
+				 "\n"
+				 "By default, blocks of a fixed size are written sequentially. With -l, the write pattern of the logger\n"
+				 "is emulated: data is produced in bursts into a log buffer and written in chunks with a periodic fsync,\n"
+				 "while dataman items are written concurrently. The latency percentiles, the buffer fill level and the\n"
+				 "dropouts the logger would have are reported. With -t, a recorded write trace is replayed\n"
+				 "(see workload.h for the format and Tools/sd_bench_strace2trace.py to record one on Linux).\n"
+				);
 
 	PRINT_MODULE_USAGE_NAME_SIMPLE("sd_bench", "command");
 	PRINT_MODULE_USAGE_PARAM_INT('b', 4096, 1, 1000000, "Block size for each read/write", true);
 	PRINT_MODULE_USAGE_PARAM_INT('r', 5, 1, 1000, "Number of runs", true);
-	PRINT_MODULE_USAGE_PARAM_INT('d', 2000, 1, 100000, "Duration of a run in ms", true);
+	PRINT_MODULE_USAGE_PARAM_INT('d', 2000, 1, 100000, "Duration of a run in ms (logger workload: 10000)", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('s', "Call fsync after each block (default=at end of each run)", true);
+	PRINT_MODULE_USAGE_PARAM_STRING('p', "<storage>/benchmark.tmp", "<file>", "Benchmark file", true);
+	PRINT_MODULE_USAGE_PARAM_FLAG('l', "Logger and dataman workload", true);
+	PRINT_MODULE_USAGE_PARAM_INT('R', 200, 1, 100000, "Logger workload: logging rate in KB/s", true);
+	PRINT_MODULE_USAGE_PARAM_INT('B', 12, 4, 10000, "Logger workload: log buffer size in KB", true);
+	PRINT_MODULE_USAGE_PARAM_INT('D', 10, 0, 1000, "Logger workload: dataman writes per second", true);
+	PRINT_MODULE_USAGE_PARAM_STRING('t', NULL, "<file>", "Replay a write trace", true);
 }
 
 int
@@ -88,11 +107,17 @@ sd_bench_main(int argc, char *argv[])
 	int myoptind = 1;
 	int ch;
 	const char *myoptarg = NULL;
+	const char *path = BENCHMARK_FILE;
+	const char *trace = NULL;
+	bool logger_workload = false;
+	int logger_rate = 200;
+	int logger_buffer_size = 12;
+	int dataman_rate = 10;
 	synchronized = false;
 	num_runs = 5;
-	run_duration = 2000;
+	run_duration = 0;
 
-	while ((ch = px4_getopt(argc, argv, "b:r:d:s", &myoptind, &myoptarg)) != EOF) {
+	while ((ch = px4_getopt(argc, argv, "b:r:d:sp:lR:B:D:t:", &myoptind, &myoptarg)) != EOF) {
 		switch (ch) {
 		case 'b':
 			block_size = strtol(myoptarg, NULL, 0);
@@ -110,6 +135,30 @@ sd_bench_main(int argc, char *argv[])
 			synchronized = true;
 			break;
 
+		case 'p':
+			path = myoptarg;
+			break;
+
+		case 'l':
+			logger_workload = true;
+			break;
+
+		case 'R':
+			logger_rate = strtol(myoptarg, NULL, 0);
+			break;
+
+		case 'B':
+			logger_buffer_size = strtol(myoptarg, NULL, 0);
+			break;
+
+		case 'D':
+			dataman_rate = strtol(myoptarg, NULL, 0);
+			break;
+
+		case 't':
+			trace = myoptarg;
+			break;
+
 		default:
 			usage();
 			return -1;
@@ -117,15 +166,38 @@ sd_bench_main(int argc, char *argv[])
 		}
 	}
 
-	if (block_size <= 0 || num_runs <= 0) {
+	if (block_size <= 0 || num_runs <= 0 || run_duration < 0) {
 		PX4_ERR("invalid argument");
 		return -1;
 	}
 
-	int bench_fd = open(BENCHMARK_FILE, O_CREAT | O_WRONLY | O_TRUNC, PX4_O_MODE_666);
+	if (logger_workload || trace) {
+		char dataman_path[128];
+		snprintf(dataman_path, sizeof(dataman_path), "%s%s", path, DATAMAN_SUFFIX);
+
+		if (trace) {
+			return trace_replay_run(trace, path, dataman_path);
+		}
+
+		logger_workload_t config = {};
+		config.path = path;
+		config.dataman_path = dataman_path;
+		config.duration_ms = run_duration > 0 ? run_duration : 10000;
+		config.rate = logger_rate * 1024;
+		config.buffer_size = logger_buffer_size * 1024;
+		config.dataman_rate = dataman_rate;
+		config.dataman_size = 64;
+		return logger_workload_run(&config);
+	}
+
+	if (run_duration == 0) {
+		run_duration = 2000;
+	}
+
+	int bench_fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, PX4_O_MODE_666);
 
 	if (bench_fd < 0) {
-		PX4_ERR("Can't open benchmark file %s", BENCHMARK_FILE);
+		PX4_ERR("Can't open benchmark file %s", path);
 		return -1;
 	}
 
@@ -147,7 +219,7 @@ sd_bench_main(int argc, char *argv[])
 
 	free(block);
 	close(bench_fd);
-	unlink(BENCHMARK_FILE);
+	unlink(path);
 
 	return 0;
 }
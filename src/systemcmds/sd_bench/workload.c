@@ -0,0 +1,780 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file workload.c
+ *
+ * Logger and dataman like storage workloads and trace replay
+ */
+
+#include "workload.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <px4_log.h>
+#include <px4_posix.h>
+#include <px4_tasks.h>
+#include <px4_time.h>
+
+#include <drivers/drv_hrt.h>
+
+static const int LOGGER_LOOP_INTERVAL_US = 3500; ///< default logger update interval
+static const int LOGGER_MIN_WRITE_CHUNK = 4096; ///< LogWriterFile::_min_write_chunk
+static const int LOGGER_BURST_INTERVAL = 256; ///< loop iterations between large messages (e.g. logged strings)
+static const int LOGGER_BURST_SIZE = 3000;
+static const int DATAMAN_FILE_SIZE = 64 * 1024;
+
+static void
+sleep_until(hrt_abstime time)
+{
+	const hrt_abstime now = hrt_absolute_time();
+
+	if (time > now) {
+		px4_usleep(time - now);
+	}
+}
+
+static uint32_t
+elapsed_us(hrt_abstime start)
+{
+	const hrt_abstime elapsed = hrt_elapsed_time(&start);
+	return elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+}
+
+static int
+create_thread(pthread_t *thread, void *(*entry)(void *), void *arg, int priority_offset)
+{
+	pthread_attr_t thr_attr;
+	pthread_attr_init(&thr_attr);
+
+	struct sched_param param;
+	(void)pthread_attr_getschedparam(&thr_attr, &param);
+	param.sched_priority = SCHED_PRIORITY_DEFAULT + priority_offset;
+	(void)pthread_attr_setschedparam(&thr_attr, &param);
+
+	pthread_attr_setstacksize(&thr_attr, PX4_STACK_ADJUSTED(1500));
+
+	int ret = pthread_create(thread, &thr_attr, entry, arg);
+	pthread_attr_destroy(&thr_attr);
+	return ret;
+}
+
+void
+latency_stats_reset(latency_stats_t *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+}
+
+static int
+latency_bucket(uint32_t latency_us)
+{
+	if (latency_us < 4) {
+		return latency_us;
+	}
+
+	// 4 buckets per octave: the most significant bit and the 2 following bits
+	int msb = 31 - __builtin_clz(latency_us);
+	int bucket = 4 * msb + ((latency_us >> (msb - 2)) & 3) - 4;
+	return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+static uint32_t
+latency_bucket_upper(int bucket)
+{
+	if (bucket < 4) {
+		return bucket;
+	}
+
+	const int msb = (bucket + 4) / 4;
+	const uint32_t lower = (uint32_t)(4 + (bucket % 4)) << (msb - 2);
+	return lower + (1u << (msb - 2)) - 1;
+}
+
+void
+latency_stats_add(latency_stats_t *stats, uint32_t latency_us)
+{
+	++stats->count;
+	stats->sum_us += latency_us;
+
+	if (latency_us > stats->max_us) {
+		stats->max_us = latency_us;
+	}
+
+	++stats->buckets[latency_bucket(latency_us)];
+}
+
+uint32_t
+latency_stats_percentile(const latency_stats_t *stats, float percentile)
+{
+	if (stats->count == 0) {
+		return 0;
+	}
+
+	// rank of the percentile, rounded up
+	const uint64_t rank = ((uint64_t)stats->count * (uint64_t)(percentile * 1000.f) + 99999) / 100000;
+	uint64_t count = 0;
+
+	for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+		count += stats->buckets[i];
+
+		if (count >= rank && count > 0) {
+			const uint32_t upper = latency_bucket_upper(i);
+			return upper < stats->max_us ? upper : stats->max_us;
+		}
+	}
+
+	return stats->max_us;
+}
+
+void
+latency_stats_print(const char *name, const latency_stats_t *stats)
+{
+	if (stats->count == 0) {
+		PX4_INFO("  %-8s      0 ops", name);
+		return;
+	}
+
+	PX4_INFO("  %-8s %6u ops, avg %7u us, p50 %7u, p90 %7u, p99 %7u, p99.9 %7u, max %7u us", name,
+		 (unsigned)stats->count, (unsigned)(stats->sum_us / stats->count),
+		 (unsigned)latency_stats_percentile(stats, 50.f), (unsigned)latency_stats_percentile(stats, 90.f),
+		 (unsigned)latency_stats_percentile(stats, 99.f), (unsigned)latency_stats_percentile(stats, 99.9f),
+		 (unsigned)stats->max_us);
+}
+
+/* dataman */
+
+typedef struct {
+	int fd;
+	hrt_abstime end;
+	int interval_us;
+	int size;
+	uint32_t seed;
+	latency_stats_t stats;
+	int error;
+} dataman_worker_t;
+
+static const uint8_t dataman_item[256] = {}; ///< largest dataman item written per operation
+
+/** like _file_write() of dataman: seek, write and fsync */
+static int
+dataman_write(int fd, int size, uint32_t *seed, latency_stats_t *stats)
+{
+	if (size < 1) {
+		size = 1;
+
+	} else if (size > (int)sizeof(dataman_item)) {
+		size = sizeof(dataman_item);
+	}
+
+	*seed = *seed * 1103515245u + 12345u;
+	const off_t offset = ((*seed >> 8) % (DATAMAN_FILE_SIZE / size)) * size;
+
+	const hrt_abstime start = hrt_absolute_time();
+
+	if (lseek(fd, offset, SEEK_SET) != offset || write(fd, dataman_item, size) != size) {
+		return -errno;
+	}
+
+	fsync(fd);
+	latency_stats_add(stats, elapsed_us(start));
+	return 0;
+}
+
+static void *
+dataman_run(void *arg)
+{
+	dataman_worker_t *worker = (dataman_worker_t *)arg;
+	hrt_abstime next = hrt_absolute_time();
+
+	while (next < worker->end && worker->error == 0) {
+		sleep_until(next);
+		worker->error = dataman_write(worker->fd, worker->size, &worker->seed, &worker->stats);
+		next += worker->interval_us;
+	}
+
+	return NULL;
+}
+
+/* logger */
+
+typedef struct {
+	const logger_workload_t *config;
+	int fd;
+	uint8_t *buffer;
+
+	latency_stats_t write_stats;
+	latency_stats_t fsync_stats;
+	latency_stats_t loop_stats; ///< time between writer iterations, i.e. stalls of the writer
+
+	uint64_t accepted; ///< bytes added to the buffer
+	uint64_t consumed; ///< bytes written
+	uint64_t dropped; ///< bytes that did not fit into the buffer
+	int max_fill; ///< [bytes]
+	hrt_abstime dropout_start; ///< 0 if no dropout is ongoing
+	int dropouts;
+	uint32_t max_dropout_us;
+	int error;
+} logger_worker_t;
+
+/** logging rate with bursts like logger: varying message sizes per loop and occasional large messages */
+static int
+logger_loop_size(const logger_workload_t *config, uint32_t iteration, uint32_t *seed)
+{
+	int mean = (int)((int64_t)config->rate * LOGGER_LOOP_INTERVAL_US / 1000000) - LOGGER_BURST_SIZE / LOGGER_BURST_INTERVAL;
+
+	if (mean < 1) {
+		mean = 1;
+	}
+
+	*seed = *seed * 1103515245u + 12345u;
+	int size = mean / 2 + (int)((*seed >> 8) % (uint32_t)(mean + 1));
+
+	if (iteration % LOGGER_BURST_INTERVAL == 0) {
+		size += LOGGER_BURST_SIZE;
+	}
+
+	return size;
+}
+
+/** add data produced by the logger up to now to the buffer, dropping what does not fit */
+static void
+logger_produce(logger_worker_t *worker, hrt_abstime now, hrt_abstime *next_loop, uint32_t *iteration, uint32_t *seed)
+{
+	const logger_workload_t *config = worker->config;
+
+	while (*next_loop <= now) {
+		const int size = logger_loop_size(config, (*iteration)++, seed);
+		const int fill = (int)(worker->accepted - worker->consumed);
+
+		if (fill + size > config->buffer_size) {
+			// like logger, drop what does not fit and count the time until data fits again
+			if (worker->dropout_start == 0) {
+				worker->dropout_start = *next_loop;
+				++worker->dropouts;
+			}
+
+			worker->dropped += size;
+
+		} else {
+			if (worker->dropout_start != 0) {
+				const uint32_t dropout_us = (uint32_t)(*next_loop - worker->dropout_start);
+
+				if (dropout_us > worker->max_dropout_us) {
+					worker->max_dropout_us = dropout_us;
+				}
+
+				worker->dropout_start = 0;
+			}
+
+			worker->accepted += size;
+
+			if (fill + size > worker->max_fill) {
+				worker->max_fill = fill + size;
+			}
+		}
+
+		*next_loop += LOGGER_LOOP_INTERVAL_US;
+	}
+}
+
+static void *
+logger_run(void *arg)
+{
+	logger_worker_t *worker = (logger_worker_t *)arg;
+	const logger_workload_t *config = worker->config;
+	const hrt_abstime start = hrt_absolute_time();
+	const hrt_abstime end = start + config->duration_ms * 1000ULL;
+
+	hrt_abstime next_loop = start;
+	hrt_abstime last_fsync = start;
+	hrt_abstime last_iteration = start;
+	uint32_t iteration = 0;
+	uint32_t seed = 1;
+	int poll_count = 0;
+
+	while (worker->error == 0) {
+		// the writer is notified once per logger loop
+		sleep_until(next_loop);
+
+		hrt_abstime now = hrt_absolute_time();
+		latency_stats_add(&worker->loop_stats, (uint32_t)(now - last_iteration));
+		last_iteration = now;
+
+		logger_produce(worker, now, &next_loop, &iteration, &seed);
+
+		const bool done = now >= end;
+
+		// call fsync periodically to minimize potential loss of data, as LogWriterFile
+		const bool call_fsync = ++poll_count >= 100 || now - last_fsync > 1000000 || done;
+
+		if (call_fsync) {
+			last_fsync = now;
+			poll_count = 0;
+		}
+
+		const int available = (int)(worker->accepted - worker->consumed);
+		const int read_pos = (int)(worker->consumed % config->buffer_size);
+		const bool is_part = read_pos + available > config->buffer_size;
+		const int size = is_part ? config->buffer_size - read_pos : available;
+
+		if (size >= LOGGER_MIN_WRITE_CHUNK || is_part || (done && size > 0)) {
+			hrt_abstime write_start = hrt_absolute_time();
+			ssize_t written = write(worker->fd, worker->buffer + read_pos, size);
+			latency_stats_add(&worker->write_stats, elapsed_us(write_start));
+
+			if (written != size) {
+				worker->error = written < 0 ? -errno : -EIO;
+				break;
+			}
+
+			worker->consumed += size;
+
+			if (call_fsync) {
+				hrt_abstime fsync_start = hrt_absolute_time();
+				fsync(worker->fd);
+				latency_stats_add(&worker->fsync_stats, elapsed_us(fsync_start));
+			}
+
+			// account for the data produced while writing
+			logger_produce(worker, hrt_absolute_time(), &next_loop, &iteration, &seed);
+
+			// if split into 2 parts, write the second part immediately as well
+			if (is_part) {
+				continue;
+			}
+
+		} else if (call_fsync) {
+			hrt_abstime fsync_start = hrt_absolute_time();
+			fsync(worker->fd);
+			latency_stats_add(&worker->fsync_stats, elapsed_us(fsync_start));
+		}
+
+		if (done && worker->accepted == worker->consumed) {
+			if (worker->dropout_start != 0 && now - worker->dropout_start > worker->max_dropout_us) {
+				worker->max_dropout_us = (uint32_t)(now - worker->dropout_start);
+			}
+
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+int
+logger_workload_run(const logger_workload_t *config)
+{
+	if (config->rate <= 0 || config->buffer_size < LOGGER_MIN_WRITE_CHUNK || config->dataman_size <= 0) {
+		PX4_ERR("invalid workload");
+		return -1;
+	}
+
+	// the largest data of a logger loop must fit into the buffer
+	if ((int64_t)config->rate * LOGGER_LOOP_INTERVAL_US / 1000000 * 3 / 2 + LOGGER_BURST_SIZE > config->buffer_size) {
+		PX4_ERR("log buffer too small for the rate");
+		return -1;
+	}
+
+	int ret = -1;
+	logger_worker_t *logger = (logger_worker_t *)calloc(1, sizeof(logger_worker_t));
+	dataman_worker_t *dataman = (dataman_worker_t *)calloc(1, sizeof(dataman_worker_t));
+
+	if (!logger || !dataman) {
+		PX4_ERR("alloc failed");
+		goto out;
+	}
+
+	logger->config = config;
+	logger->fd = -1;
+	dataman->fd = -1;
+	logger->buffer = (uint8_t *)malloc(config->buffer_size);
+
+	if (!logger->buffer) {
+		PX4_ERR("Failed to allocate log buffer");
+		goto out;
+	}
+
+	for (int i = 0; i < config->buffer_size; ++i) {
+		logger->buffer[i] = (uint8_t)i;
+	}
+
+	logger->fd = open(config->path, O_CREAT | O_WRONLY | O_TRUNC, PX4_O_MODE_666);
+
+	if (logger->fd < 0) {
+		PX4_ERR("Can't open benchmark file %s", config->path);
+		goto out;
+	}
+
+	if (config->dataman_rate > 0) {
+		dataman->fd = open(config->dataman_path, O_CREAT | O_RDWR, PX4_O_MODE_666);
+
+		if (dataman->fd < 0) {
+			PX4_ERR("Can't open dataman file %s", config->dataman_path);
+			goto out;
+		}
+	}
+
+	PX4_INFO("Logger workload: %i KB/s, buffer %i KB, dataman %i Hz x %i B, %i ms", config->rate / 1024,
+		 config->buffer_size / 1024, config->dataman_rate, config->dataman_size, config->duration_ms);
+
+	pthread_t logger_thread;
+	pthread_t dataman_thread;
+	bool dataman_started = false;
+
+	// same priority as the log writer
+	if (create_thread(&logger_thread, logger_run, logger, -40) != 0) {
+		PX4_ERR("thread create failed");
+		goto out;
+	}
+
+	if (dataman->fd >= 0) {
+		dataman->end = hrt_absolute_time() + config->duration_ms * 1000ULL;
+		dataman->interval_us = 1000000 / config->dataman_rate;
+		dataman->size = config->dataman_size;
+		dataman->seed = 2;
+
+		dataman_started = create_thread(&dataman_thread, dataman_run, dataman, -10) == 0;
+
+		if (!dataman_started) {
+			PX4_ERR("dataman thread create failed");
+		}
+	}
+
+	pthread_join(logger_thread, NULL);
+
+	if (dataman_started) {
+		pthread_join(dataman_thread, NULL);
+	}
+
+	if (logger->error != 0 || dataman->error != 0) {
+		PX4_ERR("Write error (%i, %i)", logger->error, dataman->error);
+	}
+
+	latency_stats_print("write", &logger->write_stats);
+	latency_stats_print("fsync", &logger->fsync_stats);
+	latency_stats_print("dataman", &dataman->stats);
+	latency_stats_print("writer", &logger->loop_stats);
+
+	const double elapsed = config->duration_ms / 1000.;
+	PX4_INFO("  written: %.2lf KB/s, max buffer fill: %i%% (%i ms of data)",
+		 (double)logger->consumed / elapsed / 1024., logger->max_fill * 100 / config->buffer_size,
+		 (int)((int64_t)logger->max_fill * 1000 / config->rate));
+	PX4_INFO("  dropouts: %i, dropped: %.1lf KB, longest dropout: %u ms", logger->dropouts,
+		 (double)logger->dropped / 1024., (unsigned)(logger->max_dropout_us / 1000));
+
+	ret = (logger->error == 0 && dataman->error == 0) ? 0 : -1;
+
+out:
+
+	if (logger) {
+		if (logger->fd >= 0) {
+			close(logger->fd);
+			unlink(config->path);
+		}
+
+		free(logger->buffer);
+		free(logger);
+	}
+
+	if (dataman) {
+		if (dataman->fd >= 0) {
+			close(dataman->fd);
+			unlink(config->dataman_path);
+		}
+
+		free(dataman);
+	}
+
+	return ret;
+}
+
+/* trace replay */
+
+typedef struct {
+	uint32_t time_us;
+	uint32_t size;
+	char op;
+} trace_op_t;
+
+typedef struct {
+	const trace_op_t *ops;
+	int num_ops;
+	bool dataman; ///< replay the dataman or the log operations
+	int fd;
+	hrt_abstime start;
+	uint8_t *buffer;
+	int buffer_size;
+
+	latency_stats_t write_stats;
+	latency_stats_t fsync_stats;
+	latency_stats_t delay_stats; ///< time an operation was issued after its recorded time
+	uint64_t written;
+	int error;
+} trace_worker_t;
+
+static void *
+trace_run(void *arg)
+{
+	trace_worker_t *worker = (trace_worker_t *)arg;
+	uint32_t seed = 3;
+
+	for (int i = 0; i < worker->num_ops && worker->error == 0; ++i) {
+		const trace_op_t *op = &worker->ops[i];
+
+		if ((op->op == 'd') != worker->dataman) {
+			continue;
+		}
+
+		const hrt_abstime time = worker->start + op->time_us;
+		sleep_until(time);
+
+		const hrt_abstime now = hrt_absolute_time();
+		latency_stats_add(&worker->delay_stats, now > time ? (uint32_t)(now - time) : 0);
+
+		if (op->op == 'd') {
+			worker->error = dataman_write(worker->fd, op->size, &seed, &worker->write_stats);
+			worker->written += op->size;
+
+		} else if (op->op == 'w') {
+			uint32_t remaining = op->size;
+			const hrt_abstime write_start = hrt_absolute_time();
+
+			while (remaining > 0) {
+				const int size = remaining > (uint32_t)worker->buffer_size ? worker->buffer_size : (int)remaining;
+
+				if (write(worker->fd, worker->buffer, size) != size) {
+					worker->error = -errno;
+					break;
+				}
+
+				remaining -= size;
+			}
+
+			latency_stats_add(&worker->write_stats, elapsed_us(write_start));
+			worker->written += op->size;
+
+		} else {
+			const hrt_abstime fsync_start = hrt_absolute_time();
+			fsync(worker->fd);
+			latency_stats_add(&worker->fsync_stats, elapsed_us(fsync_start));
+		}
+	}
+
+	return NULL;
+}
+
+/** @return number of operations, or -1 on error */
+static int
+trace_load(const char *trace_path, trace_op_t **ops)
+{
+	FILE *file = fopen(trace_path, "r");
+
+	if (!file) {
+		PX4_ERR("Can't open trace %s", trace_path);
+		return -1;
+	}
+
+	int capacity = 0;
+	int num_ops = 0;
+	*ops = NULL;
+	char line[80];
+	int line_number = 0;
+
+	while (fgets(line, sizeof(line), file)) {
+		++line_number;
+		unsigned long time_us;
+		unsigned long size;
+		char op;
+
+		line[strcspn(line, "\r\n")] = '\0';
+
+		if (line[0] == '#' || line[0] == '\0') {
+			continue;
+		}
+
+		// %lu silently accepts negative numbers, so reject them explicitly
+		const bool valid = sscanf(line, "%lu %c %lu", &time_us, &op, &size) == 3 && !strchr(line, '-')
+				   && (uint32_t)time_us == time_us && (uint32_t)size == size
+				   && (op == 'f' || (op == 'w' && size > 0)
+				       || (op == 'd' && size > 0 && size <= sizeof(dataman_item)));
+
+		if (!valid) {
+			PX4_ERR("invalid trace line %i: %s", line_number, line);
+			num_ops = -1;
+			break;
+		}
+
+		if (num_ops == capacity) {
+			capacity = capacity ? capacity * 2 : 256;
+			trace_op_t *resized = (trace_op_t *)realloc(*ops, capacity * sizeof(trace_op_t));
+
+			if (!resized) {
+				PX4_ERR("trace too large");
+				num_ops = -1;
+				break;
+			}
+
+			*ops = resized;
+		}
+
+		(*ops)[num_ops].time_us = time_us;
+		(*ops)[num_ops].size = size;
+		(*ops)[num_ops].op = op;
+		++num_ops;
+	}
+
+	fclose(file);
+
+	if (num_ops < 0) {
+		free(*ops);
+		*ops = NULL;
+	}
+
+	return num_ops;
+}
+
+int
+trace_replay_run(const char *trace_path, const char *path, const char *dataman_path)
+{
+	trace_op_t *ops = NULL;
+	const int num_ops = trace_load(trace_path, &ops);
+
+	if (num_ops <= 0) {
+		PX4_ERR("no operations in trace");
+		return -1;
+	}
+
+	trace_worker_t *workers = (trace_worker_t *)calloc(2, sizeof(trace_worker_t));
+
+	if (!workers) {
+		PX4_ERR("alloc failed");
+		free(ops);
+		return -1;
+	}
+
+	int ret = -1;
+	trace_worker_t *log = &workers[0];
+	trace_worker_t *dataman = &workers[1];
+	pthread_t threads[2];
+	int num_threads = 0;
+
+	log->fd = -1;
+	dataman->fd = -1;
+	dataman->dataman = true;
+	log->buffer_size = LOGGER_MIN_WRITE_CHUNK;
+	log->buffer = (uint8_t *)calloc(1, log->buffer_size);
+
+	bool has_dataman = false;
+
+	for (int i = 0; i < num_ops; ++i) {
+		has_dataman |= ops[i].op == 'd';
+	}
+
+	log->fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, PX4_O_MODE_666);
+
+	if (!log->buffer || log->fd < 0) {
+		PX4_ERR("Can't open benchmark file %s", path);
+		goto out;
+	}
+
+	if (has_dataman) {
+		dataman->fd = open(dataman_path, O_CREAT | O_RDWR, PX4_O_MODE_666);
+
+		if (dataman->fd < 0) {
+			PX4_ERR("Can't open dataman file %s", dataman_path);
+			goto out;
+		}
+	}
+
+	PX4_INFO("Replaying %i operations over %u ms from %s", num_ops, (unsigned)(ops[num_ops - 1].time_us / 1000),
+		 trace_path);
+
+	const hrt_abstime start = hrt_absolute_time() + 10000;
+
+	for (int i = 0; i < 2; ++i) {
+		if (workers[i].fd < 0) {
+			continue;
+		}
+
+		workers[i].ops = ops;
+		workers[i].num_ops = num_ops;
+		workers[i].start = start;
+
+		if (create_thread(&threads[num_threads], trace_run, &workers[i], i == 0 ? -40 : -10) != 0) {
+			PX4_ERR("thread create failed");
+			break;
+		}
+
+		++num_threads;
+	}
+
+	for (int i = 0; i < num_threads; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+
+	if (log->error != 0 || dataman->error != 0) {
+		PX4_ERR("Write error (%i, %i)", log->error, dataman->error);
+	}
+
+	latency_stats_print("write", &log->write_stats);
+	latency_stats_print("fsync", &log->fsync_stats);
+	latency_stats_print("dataman", &dataman->write_stats);
+	latency_stats_print("log late", &log->delay_stats);
+	latency_stats_print("dm late", &dataman->delay_stats);
+	PX4_INFO("  written: %.1lf KB log, %.1lf KB dataman", (double)log->written / 1024., (double)dataman->written / 1024.);
+
+	ret = (num_threads == 2 || (num_threads == 1 && !has_dataman)) && log->error == 0 && dataman->error == 0 ? 0 : -1;
+
+out:
+
+	if (log->fd >= 0) {
+		close(log->fd);
+		unlink(path);
+	}
+
+	if (dataman->fd >= 0) {
+		close(dataman->fd);
+		unlink(dataman_path);
+	}
+
+	free(log->buffer);
+	free(workers);
+	free(ops);
+	return ret;
+}
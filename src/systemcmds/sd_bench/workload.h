@@ -0,0 +1,100 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2019 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file workload.h
+ *
+ * Storage workloads of sd_bench that follow the write pattern of the logger and dataman
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <px4_config.h>
+
+__BEGIN_DECLS
+
+#define LATENCY_BUCKETS 128
+
+/**
+ * Latency histogram with 4 buckets per octave, i.e. a resolution of 19%
+ */
+typedef struct {
+	uint32_t count;
+	uint64_t sum_us;
+	uint32_t max_us;
+	uint32_t buckets[LATENCY_BUCKETS];
+} latency_stats_t;
+
+void latency_stats_reset(latency_stats_t *stats);
+void latency_stats_add(latency_stats_t *stats, uint32_t latency_us);
+
+/**
+ * @param percentile 0-100
+ * @return upper bound of the bucket containing the percentile [us]
+ */
+uint32_t latency_stats_percentile(const latency_stats_t *stats, float percentile);
+
+void latency_stats_print(const char *name, const latency_stats_t *stats);
+
+typedef struct {
+	const char *path; ///< log file
+	const char *dataman_path; ///< dataman file
+	int duration_ms;
+	int rate; ///< average logging rate [bytes/s]
+	int buffer_size; ///< size of the emulated log buffer [bytes]
+	int dataman_rate; ///< dataman writes per second, 0 to disable
+	int dataman_size; ///< size of a dataman write [bytes]
+} logger_workload_t;
+
+/**
+ * Emulate the logger: messages are added to a ring buffer in bursts, and the buffer is written
+ * to the log file by a writer thread in the same way as LogWriterFile, including the periodic
+ * fsync. Data that does not fit into the buffer is dropped and reported as dropout.
+ * Concurrently, dataman items are written at random offsets, each followed by fsync.
+ * @return 0 on success
+ */
+int logger_workload_run(const logger_workload_t *config);
+
+/**
+ * Replay a recorded write trace. Each line has the format '<time [us]> <op> <size [bytes]>',
+ * where op is 'w' for a log write, 'f' for a log fsync and 'd' for a dataman write followed by fsync.
+ * Lines starting with '#' are ignored. Log and dataman operations are replayed on separate threads
+ * at their recorded time, and the delay of operations that could not be issued in time is reported.
+ * @return 0 on success
+ */
+int trace_replay_run(const char *trace_path, const char *path, const char *dataman_path);
+
+__END_DECLS
@@ -51,6 +51,7 @@ public:
 	bool test_pop();
 	bool test_push_duplicate();
 	bool test_remove();
+	bool test_remove_reinsert();
 
 };
 
@@ -60,6 +61,7 @@ bool IntrusiveQueueTest::run_tests()
 	ut_run_test(test_pop);
 	ut_run_test(test_push_duplicate);
 	ut_run_test(test_remove);
+	ut_run_test(test_remove_reinsert);
 
 	return (_tests_failed == 0);
 }
@@ -273,4 +275,53 @@ bool IntrusiveQueueTest::test_remove()
 	return true;
 }
 
+bool IntrusiveQueueTest::test_remove_reinsert()
+{
+	IntrusiveQueue<testContainer *> q1;
+	IntrusiveQueue<testContainer *> q2;
+
+	testContainer t1;
+	testContainer t2;
+	testContainer t3;
+	t1.i = 1;
+	t2.i = 2;
+	t3.i = 3;
+
+	q1.push(&t1);
+	q1.push(&t2);
+	q1.push(&t3);
+
+	// remove the head while others are queued and move it to another queue
+	ut_assert_true(q1.remove(&t1));
+	q2.push(&t1);
+	ut_compare("moved to q2", q2.size(), 1);
+	ut_compare("q1 size 2", q1.size(), 2);
+
+	// remove the tail, pushing again appends it after the new tail
+	ut_assert_true(q1.remove(&t3));
+	ut_compare("q1 size 1", q1.size(), 1);
+	q1.push(&t3);
+	ut_compare("q1 size 2 again", q1.size(), 2);
+	ut_assert_true(q1.back() == &t3);
+
+	// remove the only item, the queue can be reused
+	ut_assert_true(q2.remove(&t1));
+	ut_assert_true(q2.empty());
+	ut_assert_false(q2.remove(&t1));
+	q2.push(&t1);
+	ut_assert_true(q2.front() == &t1);
+	ut_assert_true(q2.back() == &t1);
+
+	// removing an item not in the queue fails
+	ut_assert_false(q1.remove(&t1));
+
+	ut_assert_true(q1.pop() == &t2);
+	ut_assert_true(q1.pop() == &t3);
+	ut_assert_true(q1.empty());
+	ut_assert_true(q2.pop() == &t1);
+	ut_assert_true(q2.empty());
+
+	return true;
+}
+
 ut_declare_test_c(test_IntrusiveQueue, IntrusiveQueueTest)
@@ -36,6 +36,12 @@
 #include <px4_getopt.h>
 #include <px4_platform_common/px4_work_queue/WorkQueueManager.hpp>
 
+#include <stdlib.h>
+
+#if defined(__PX4_POSIX) && !defined(__PX4_QURT)
+#include <px4_rt_profile.h>
+#endif
+
 static void	usage();
 
 extern "C" {
@@ -45,7 +51,7 @@ extern "C" {
 int
 work_queue_main(int argc, char *argv[])
 {
-	if (argc != 2) {
+	if (argc < 2) {
 		usage();
 		return 1;
 	}
@@ -61,6 +67,51 @@ work_queue_main(int argc, char *argv[])
 	} else if (!strcmp(argv[1], "status")) {
 		px4::WorkQueueManagerStatus();
 		return 0;
+
+	} else if (!strcmp(argv[1], "affinity")) {
+		if (argc != 4) {
+			usage();
+			return 1;
+		}
+
+#if defined(__PX4_POSIX) && !defined(__PX4_QURT)
+		uint32_t cpus = 0;
+
+		if (strcmp(argv[3], "all") != 0 && px4_rt_parse_cpu_list(argv[3], &cpus) != 0) {
+			PX4_ERR("invalid CPU list %s", argv[3]);
+			return 1;
+		}
+
+		return (px4::WorkQueueManagerSetAffinity(argv[2], cpus) == PX4_OK) ? 0 : 1;
+#else
+		PX4_ERR("not supported");
+		return 1;
+#endif
+
+	} else if (!strcmp(argv[1], "lock")) {
+		int heap_reserve_kb = 4096;
+		int myoptind = 1;
+		int ch;
+		const char *myoptarg = nullptr;
+
+		while ((ch = px4_getopt(argc - 1, &argv[1], "r:", &myoptind, &myoptarg)) != EOF) {
+			switch (ch) {
+			case 'r':
+				heap_reserve_kb = strtol(myoptarg, nullptr, 0);
+				break;
+
+			default:
+				usage();
+				return 1;
+			}
+		}
+
+		if (heap_reserve_kb < 0) {
+			usage();
+			return 1;
+		}
+
+		return (px4::WorkQueueManagerLockMemory((size_t)heap_reserve_kb * 1024) == PX4_OK) ? 0 : 1;
 	}
 
 	usage();
@@ -78,9 +129,23 @@ usage()
 
 Command-line tool to show work queue status.
 
+On Linux the status also shows the effective scheduling policy, priority and CPU affinity of each
+work queue thread. For a real-time setup, lock the memory before starting the work queues (and
+most other modules), and pin the time critical work queues to isolated CPUs (e.g. `isolcpus=3`
+on the kernel command line).
+
+### Examples
+Lock the memory and pin the rate controller to CPU 3:
+$ work_queue lock
+$ work_queue affinity wq:rate_ctrl 3
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("work_queue", "system");
 	PRINT_MODULE_USAGE_COMMAND("start");
+	PRINT_MODULE_USAGE_COMMAND_DESCR("affinity", "Pin a work queue to a set of CPUs (Linux)");
+	PRINT_MODULE_USAGE_ARG("<wq>", "Work queue name (e.g. wq:rate_ctrl)", false);
+	PRINT_MODULE_USAGE_ARG("<cpus>", "CPU list (e.g. 2-3,5), 'all' for all CPUs", false);
+	PRINT_MODULE_USAGE_COMMAND_DESCR("lock", "Lock and pre-fault memory (POSIX)");
+	PRINT_MODULE_USAGE_PARAM_INT('r', 4096, 0, 1048576, "Heap to pre-fault [KB]", true);
 	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 }